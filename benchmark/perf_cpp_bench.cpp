@@ -0,0 +1,433 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <perfcpp/analyzer/data.h>
+#include <perfcpp/event_counter.h>
+#include <perfcpp/sampler.h>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * Benchmarks measuring the overhead and throughput of perf-cpp itself (not of the monitored code): Starting and
+ * stopping counters, reading counters, decoding and draining samples, merging samples of many CPUs, and mapping samples
+ * to data types. Every measurement is reported as one row (benchmark, configuration, parameter, value, unit) as CSV
+ * or JSON.
+ *
+ * Usage: perf-cpp-bench [--format=csv|json] [--repetitions=N] [--counters=a,b,c] [--trigger=event]
+ */
+namespace perf::bench {
+class Reporter
+{
+public:
+  explicit Reporter(const bool is_json) noexcept
+    : _is_json(is_json)
+  {
+  }
+
+  void add(std::string benchmark, std::string configuration, std::string parameter, double value, std::string unit)
+  {
+    _rows.push_back(
+      Row{ std::move(benchmark), std::move(configuration), std::move(parameter), value, std::move(unit) });
+  }
+
+  void print(std::ostream& stream) const
+  {
+    if (_is_json) {
+      stream << "[\n";
+      for (auto i = 0U; i < _rows.size(); ++i) {
+        const auto& row = _rows[i];
+        stream << "  {\"benchmark\": \"" << row.benchmark << "\", \"configuration\": \"" << row.configuration
+               << "\", \"parameter\": \"" << row.parameter << "\", \"value\": " << row.value << ", \"unit\": \""
+               << row.unit << "\"}" << (i + 1U < _rows.size() ? "," : "") << "\n";
+      }
+      stream << "]" << std::endl;
+    } else {
+      stream << "benchmark,configuration,parameter,value,unit\n";
+      for (const auto& row : _rows) {
+        stream << row.benchmark << "," << row.configuration << "," << row.parameter << "," << row.value << ","
+               << row.unit << "\n";
+      }
+      stream << std::flush;
+    }
+  }
+
+private:
+  struct Row
+  {
+    std::string benchmark;
+    std::string configuration;
+    std::string parameter;
+    double value;
+    std::string unit;
+  };
+
+  bool _is_json;
+  std::vector<Row> _rows;
+};
+
+/**
+ * Runs the callable the given number of times and returns the median duration of a single run in nanoseconds.
+ */
+template<typename F>
+[[nodiscard]] double
+median_nanoseconds(const std::uint32_t repetitions, F&& callable)
+{
+  auto durations = std::vector<double>{};
+  durations.reserve(repetitions);
+
+  for (auto repetition = 0U; repetition < repetitions; ++repetition) {
+    const auto start = std::chrono::steady_clock::now();
+    callable();
+    const auto end = std::chrono::steady_clock::now();
+    durations.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+  }
+
+  std::nth_element(durations.begin(), durations.begin() + std::int64_t(durations.size() / 2U), durations.end());
+  return durations[durations.size() / 2U];
+}
+
+/**
+ * Workload generating events (and samples) while benchmarking samplers.
+ */
+void
+run_workload(const std::chrono::milliseconds duration)
+{
+  auto data = std::vector<std::uint64_t>(1U << 20U);
+  std::iota(data.begin(), data.end(), 0U);
+
+  auto value = std::uint64_t{ 0U };
+  const auto end = std::chrono::steady_clock::now() + duration;
+  while (std::chrono::steady_clock::now() < end) {
+    for (auto index = std::size_t{ 0U }; index < data.size(); index += 8U) {
+      value += data[(index * 4099U) & (data.size() - 1U)];
+    }
+  }
+
+  asm volatile("" : "+r,m"(value) : : "memory");
+}
+
+[[nodiscard]] std::vector<std::string>
+split(const std::string& list)
+{
+  auto items = std::vector<std::string>{};
+  auto stream = std::stringstream{ list };
+  for (auto item = std::string{}; std::getline(stream, item, ',');) {
+    if (!item.empty()) {
+      items.push_back(std::move(item));
+    }
+  }
+
+  return items;
+}
+
+/**
+ * Checks if the counters can be opened (e.g., hardware counters are not available in many virtual machines).
+ */
+[[nodiscard]] bool
+is_available(const CounterDefinition& counter_definitions, const std::vector<std::string>& counters)
+{
+  try {
+    auto event_counter = EventCounter{ counter_definitions };
+    event_counter.add(counters);
+    event_counter.start();
+    event_counter.stop();
+    return true;
+  } catch (std::runtime_error&) {
+    return false;
+  }
+}
+
+void
+benchmark_start_stop(Reporter& reporter,
+                     const CounterDefinition& counter_definitions,
+                     const std::vector<std::string>& counters,
+                     const std::uint32_t repetitions)
+{
+  for (auto count_counters = std::size_t{ 1U }; count_counters <= counters.size(); count_counters *= 2U) {
+    const auto counter_names = std::vector<std::string>{ counters.begin(), counters.begin() + count_counters };
+    const auto parameter = "counters=" + std::to_string(count_counters);
+
+    for (const auto is_user_level_read : { false, true }) {
+      auto config = Config{};
+      config.user_level_read(is_user_level_read);
+      const auto configuration = std::string{ is_user_level_read ? "user-level-read" : "syscall-read" };
+
+      /// Opened once, every start/stop only enables, reads, and disables the counters.
+      auto event_counter = EventCounter{ counter_definitions, config };
+      event_counter.add(counter_names);
+      event_counter.open();
+
+      const auto start_stop = median_nanoseconds(repetitions, [&event_counter] {
+        event_counter.start();
+        event_counter.stop();
+      });
+      reporter.add("start-stop", configuration + "/opened", parameter, start_stop, "ns");
+
+      event_counter.start();
+      const auto live_result =
+        median_nanoseconds(repetitions, [&event_counter] { static_cast<void>(event_counter.live_result()); });
+      reporter.add("read", configuration + "/live-result", parameter, live_result, "ns");
+
+      auto values = std::vector<double>{};
+      const auto live_values = median_nanoseconds(
+        repetitions, [&event_counter, &values] { static_cast<void>(event_counter.live_values(values)); });
+      reporter.add("read", configuration + "/live-values", parameter, live_values, "ns");
+      event_counter.stop();
+
+      const auto result =
+        median_nanoseconds(repetitions, [&event_counter] { static_cast<void>(event_counter.result()); });
+      reporter.add("read", configuration + "/result", parameter, result, "ns");
+      event_counter.close();
+    }
+
+    /// Opening and closing the counters on every start/stop.
+    auto event_counter = EventCounter{ counter_definitions };
+    event_counter.add(counter_names);
+    const auto open_start_stop = median_nanoseconds(std::max(1U, repetitions / 10U), [&event_counter] {
+      event_counter.start();
+      event_counter.stop();
+    });
+    reporter.add("start-stop", "syscall-read/open-close", parameter, open_start_stop, "ns");
+  }
+}
+
+/**
+ * Configurations of sampled values, from cheap to expensive decoding.
+ */
+[[nodiscard]] std::vector<std::pair<std::string, std::function<void(Sampler::Values&)>>>
+value_configurations()
+{
+  return {
+    { "ip-time", [](Sampler::Values& values) { values.instruction_pointer(true).time(true); } },
+    { "ip-time-tid-cpu",
+      [](Sampler::Values& values) { values.instruction_pointer(true).time(true).thread_id(true).cpu_id(true); } },
+    { "ip-time-period-callchain",
+      [](Sampler::Values& values) { values.instruction_pointer(true).time(true).period(true).callchain(true); } },
+    { "ip-time-addr-data-src-weight",
+      [](Sampler::Values& values) {
+        values.instruction_pointer(true).time(true).logical_memory_address(true).data_src(true).weight(true);
+      } },
+  };
+}
+
+void
+benchmark_sampling(Reporter& reporter,
+                   const CounterDefinition& counter_definitions,
+                   const std::string& trigger,
+                   const std::uint64_t period,
+                   const std::uint32_t repetitions)
+{
+  for (const auto& [configuration, set_values] : value_configurations()) {
+    auto config = SampleConfig{};
+    config.period(period);
+
+    auto sampler = Sampler{ counter_definitions, config };
+    sampler.trigger(std::string{ trigger });
+    set_values(sampler.values());
+
+    try {
+      sampler.start();
+    } catch (std::runtime_error&) {
+      continue;
+    }
+    run_workload(std::chrono::milliseconds{ 200U });
+    sampler.stop();
+
+    const auto count_samples = double(sampler.result(false).size());
+    if (count_samples == 0.0) {
+      sampler.close();
+      continue;
+    }
+    reporter.add("decode", configuration, "samples", count_samples, "samples");
+
+    /// Decoding does not consume the buffer, all runs decode the same samples.
+    const auto result = median_nanoseconds(repetitions, [&sampler] { static_cast<void>(sampler.result(false)); });
+    reporter.add("decode", configuration + "/result", "throughput", count_samples / (result / 1e9), "samples/s");
+
+    auto arena = SampleArena{};
+    const auto arena_result = median_nanoseconds(repetitions, [&sampler, &arena] { sampler.result(arena, false); });
+    reporter.add("decode", configuration + "/arena", "throughput", count_samples / (arena_result / 1e9), "samples/s");
+
+    auto batch = SampleBatch{};
+    const auto batch_result = median_nanoseconds(repetitions, [&sampler, &batch] { sampler.result(batch, false); });
+    reporter.add("decode", configuration + "/batch", "throughput", count_samples / (batch_result / 1e9), "samples/s");
+
+    const auto for_each = median_nanoseconds(repetitions, [&sampler] {
+      auto count = std::uint64_t{ 0U };
+      sampler.for_each([&count](const SampleView& sample) { count += sample.time().value_or(0U) & 1U; });
+      asm volatile("" : "+r,m"(count) : : "memory");
+    });
+    reporter.add("decode", configuration + "/for-each", "throughput", count_samples / (for_each / 1e9), "samples/s");
+
+    sampler.close();
+
+    /// Drain while sampling: Every drain hands the consumed buffer back to the kernel.
+    auto draining_sampler = Sampler{ counter_definitions, config };
+    draining_sampler.trigger(std::string{ trigger });
+    set_values(draining_sampler.values());
+    draining_sampler.start();
+
+    auto count_drained = std::uint64_t{ 0U };
+    auto drain_time = 0.0;
+    for (auto round = 0U; round < 20U; ++round) {
+      run_workload(std::chrono::milliseconds{ 10U });
+      drain_time += median_nanoseconds(1U, [&draining_sampler, &count_drained] {
+        draining_sampler.drain([&count_drained](const SampleView&) { ++count_drained; });
+      });
+    }
+    draining_sampler.stop();
+    draining_sampler.close();
+
+    if (count_drained > 0U) {
+      reporter.add("drain", configuration, "throughput", double(count_drained) / (drain_time / 1e9), "samples/s");
+    }
+  }
+}
+
+/**
+ * Grants access to merging results of multiple samplers.
+ */
+class MergeBenchmark final : private MultiSamplerBase
+{
+public:
+  [[nodiscard]] static std::vector<Sample> merge(std::vector<std::vector<Sample>>&& results)
+  {
+    return MultiSamplerBase::merge(std::move(results), /* sort_by_time */ true);
+  }
+};
+
+void
+benchmark_merge(Reporter& reporter, const std::uint32_t repetitions)
+{
+  constexpr auto samples_per_cpu = std::uint64_t{ 10000U };
+
+  for (auto count_cpus = std::uint64_t{ 1U }; count_cpus <= 128U; count_cpus *= 2U) {
+    /// Every CPU's samples are sorted by time, samples of different CPUs interleave.
+    auto results = std::vector<std::vector<Sample>>(count_cpus);
+    for (auto cpu_id = 0U; cpu_id < count_cpus; ++cpu_id) {
+      results[cpu_id].reserve(samples_per_cpu);
+      for (auto sample_id = std::uint64_t{ 0U }; sample_id < samples_per_cpu; ++sample_id) {
+        auto& sample = results[cpu_id].emplace_back(Sample::Mode::User);
+        sample.timestamp(sample_id * count_cpus + cpu_id);
+        sample.cpu_id(cpu_id);
+      }
+    }
+
+    auto durations = std::vector<double>{};
+    for (auto repetition = 0U; repetition < std::max(1U, repetitions / 100U); ++repetition) {
+      auto copy = results;
+      durations.push_back(
+        median_nanoseconds(1U, [&copy] { static_cast<void>(MergeBenchmark::merge(std::move(copy))); }));
+    }
+    std::sort(durations.begin(), durations.end());
+
+    const auto count_samples = double(count_cpus * samples_per_cpu);
+    reporter.add("merge",
+                 "k-way",
+                 "cpus=" + std::to_string(count_cpus),
+                 durations[durations.size() / 2U] / count_samples,
+                 "ns/sample");
+  }
+}
+
+void
+benchmark_analyzer(Reporter& reporter, const std::uint32_t repetitions)
+{
+  constexpr auto count_instances = std::uint64_t{ 1U << 16U };
+  auto instances = std::vector<std::array<std::uint64_t, 8U>>(count_instances);
+
+  auto random = std::mt19937_64{ 42U };
+  auto distribution = std::uniform_int_distribution<std::uint64_t>{ 0U, count_instances * 64U - 1U };
+  const auto begin = std::uintptr_t(instances.data());
+
+  for (auto count_samples = std::uint64_t{ 1000U }; count_samples <= 1000000U; count_samples *= 10U) {
+    auto samples = std::vector<Sample>{};
+    samples.reserve(count_samples);
+    for (auto sample_id = std::uint64_t{ 0U }; sample_id < count_samples; ++sample_id) {
+      auto& sample = samples.emplace_back(Sample::Mode::User);
+      sample.logical_memory_address(begin + distribution(random));
+      sample.data_src(DataSource{ PERF_MEM_S(OP, LOAD) | PERF_MEM_S(LVL, HIT) | PERF_MEM_S(LVL, L1) });
+      sample.weight(Weight{ 4U });
+    }
+
+    auto data_analyzer = analyzer::DataAnalyzer{};
+    auto data_type = analyzer::DataType{ "instance", 64U };
+    for (auto member = 0U; member < 8U; ++member) {
+      data_type.add<std::uint64_t>("member[" + std::to_string(member) + "]");
+    }
+    data_analyzer.add(std::move(data_type));
+    data_analyzer.annotate("instance", instances.data(), instances.size());
+
+    const auto map = median_nanoseconds(std::max(1U, repetitions / 100U), [&data_analyzer, &samples] {
+      static_cast<void>(data_analyzer.map(samples, /* is_keep_samples */ false));
+    });
+    reporter.add("analyzer", "map", "samples=" + std::to_string(count_samples), double(count_samples) / (map / 1e9),
+                 "samples/s");
+  }
+}
+}
+
+int
+main(const int count_arguments, const char** arguments)
+{
+  auto is_json = false;
+  auto repetitions = std::uint32_t{ 1000U };
+  auto counters = std::vector<std::string>{
+    "instructions", "cycles", "branches", "branch-misses", "cache-references", "cache-misses", "L1-dcache-loads",
+    "L1-dcache-load-misses"
+  };
+  auto trigger = std::string{ "cycles" };
+
+  for (auto i = 1; i < count_arguments; ++i) {
+    const auto argument = std::string{ arguments[i] };
+    if (argument == "--format=json") {
+      is_json = true;
+    } else if (argument == "--format=csv") {
+      is_json = false;
+    } else if (argument.rfind("--repetitions=", 0U) == 0U) {
+      repetitions = std::max(1U, std::uint32_t(std::stoul(argument.substr(14U))));
+    } else if (argument.rfind("--counters=", 0U) == 0U) {
+      counters = perf::bench::split(argument.substr(11U));
+    } else if (argument.rfind("--trigger=", 0U) == 0U) {
+      trigger = argument.substr(10U);
+    } else {
+      std::cerr << "Usage: " << arguments[0]
+                << " [--format=csv|json] [--repetitions=N] [--counters=a,b,c] [--trigger=event]" << std::endl;
+      return 1;
+    }
+  }
+
+  auto counter_definitions = perf::CounterDefinition{};
+  auto reporter = perf::bench::Reporter{ is_json };
+
+  /// Fall back to software events if hardware counters are not available (e.g., in virtual machines).
+  auto period = std::uint64_t{ 100000U };
+  if (!perf::bench::is_available(counter_definitions, counters)) {
+    std::cerr << "Counters are not available, falling back to software events." << std::endl;
+    counters = { "cpu-clock", "task-clock", "page-faults", "context-switches" };
+  }
+  if (!perf::bench::is_available(counter_definitions, { trigger })) {
+    std::cerr << "Trigger '" << trigger << "' is not available, falling back to 'cpu-clock'." << std::endl;
+    trigger = "cpu-clock";
+    period = 20000U;
+  }
+
+  try {
+    perf::bench::benchmark_start_stop(reporter, counter_definitions, counters, repetitions);
+    perf::bench::benchmark_sampling(reporter, counter_definitions, trigger, period, std::max(1U, repetitions / 100U));
+    perf::bench::benchmark_merge(reporter, repetitions);
+    perf::bench::benchmark_analyzer(reporter, repetitions);
+  } catch (std::runtime_error& exception) {
+    std::cerr << exception.what() << std::endl;
+    return 1;
+  }
+
+  reporter.print(std::cout);
+
+  return 0;
+}
@@ -29,7 +29,9 @@ main()
     return 1;
   }
 
-  /// Setup which data will be included into samples (raw data, instruction, logical memory).
+  /// Setup which data will be included into samples (raw data, instruction, logical memory). Additionally, let the
+  /// sampler decode the raw IBS registers into memory addresses, latency, and data source.
+  sampler.values().raw(true).instruction_pointer(true).logical_memory_address(true).amd_ibs(true);
   sampler.values().raw(true).instruction_pointer(true).logical_memory_address(true);
 
   /// Create random access benchmark.
@@ -68,36 +70,38 @@ main()
   for (auto index = 0U; index < count_show_samples; ++index) {
     const auto& sample = samples[index];
 
-    /// See the AMD IBS manual at
-    /// https://www.amd.com/content/dam/amd/en/documents/processor-tech-docs/programmer-references/24593.pdf (from page
-    /// 428).
-
+    /// The registers are decoded by the perf::AmdIbsDecoder (see the AMD IBS manual at
+    /// https://www.amd.com/content/dam/amd/en/documents/processor-tech-docs/programmer-references/24593.pdf, from page
+    /// 428), which is also available for every perf::SampleView when iterating with sampler.for_each().
     if (sample.raw().has_value() && sample.instruction_pointer().has_value()) {
-      const auto* registers =
-        reinterpret_cast<const std::uint64_t*>(sample.raw().value().data() + /* 4 byte offset */ 4);
-
-      // const auto ibs_execution_control_reg = registers[0U]; /// IBS Execution Control Register (see page 429 in the
-      // referenced AMD manual)
-      const auto ibs_rip_reg =
-        registers[1U]; /// IBS Op Linear Address Register (see page 430 in the referenced AMD manual)
-      // const auto ibs_data1_reg = registers[2U];         /// IBS Op Data 1 Register (see page 431 in the referenced
-      // AMD manual) const auto ibs_data2_reg = registers[3U];      // IBS Op Data 2 Register (see page 432 in the
-      // referenced AMD manual)
-      const auto ibs_data3_reg = registers[4U]; // IBS Op Data 3 Register (see page 432 in the referenced AMD manual)
-      const auto ibs_linear_addr_reg =
-        registers[5]; // IBS Data Cache Linear Address Register (see page 434 in the referenced AMD manual)
-
-      std::cout << "Raw (" << sample.raw().value().size() << " bytes): IP (from raw) = 0x" << std::hex << ibs_rip_reg
-                << std::dec;
-      if ((ibs_data3_reg & 1U << 17)) { /// Check if the address is valid
-        std::cout << " ; Addr (from raw) = 0x" << std::hex << ibs_linear_addr_reg << std::dec;
+      std::cout << "Raw (" << sample.raw().value().size() << " bytes): IP = 0x" << std::hex
+                << sample.instruction_pointer().value() << std::dec;
+
+      if (sample.logical_memory_address().has_value()) {
+        std::cout << " | Addr = 0x" << std::hex << sample.logical_memory_address().value() << std::dec;
       } else {
-        std::cout << " ; Addr (from raw) not valid";
+        std::cout << " | Addr not valid";
+      }
+
+      if (sample.data_src().has_value() && !sample.data_src()->is_na()) {
+        auto data_source = "N/A";
+        if (sample.data_src()->is_mem_l1()) {
+          data_source = "L1d";
+        } else if (sample.data_src()->is_mem_l2()) {
+          data_source = "L2";
+        } else if (sample.data_src()->is_mem_l3()) {
+          data_source = "L3";
+        } else if (sample.data_src()->is_mem_ram()) {
+          data_source = "RAM";
+        }
+
+        const auto weight = sample.weight().value_or(perf::Weight{ 0U, 0U, 0U });
+        std::cout << " | Latency (cache, tag-to-retire) = " << weight.cache_latency() << ", "
+                  << weight.instruction_retirement_latency() << " | Is Load = " << sample.data_src()->is_load()
+                  << " | Data Source = " << data_source;
       }
 
-      std::cout << " | IP (from perf) = 0x" << std::hex << sample.instruction_pointer().value() << std::dec;
-      std::cout << " | Addr (from perf) = 0x" << std::hex << sample.logical_memory_address().value_or(0) << std::dec
-                << "\n";
+      std::cout << "\n";
     }
   }
   std::cout << std::flush;
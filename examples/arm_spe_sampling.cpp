@@ -0,0 +1,107 @@
+#include "access_benchmark.h"
+#include <iostream>
+#include <iterator>
+#include <perfcpp/hardware_info.h>
+#include <perfcpp/sampler.h>
+#include <tuple>
+
+int
+main()
+{
+  std::cout << "libperf-cpp example: Record Arm SPE samples including logical and physical memory address, latency, "
+               "and data source for single-threaded random access to an in-memory array, draining the AUX area while "
+               "sampling."
+            << std::endl;
+
+  /// Initialize counter definitions.
+  /// Note that the perf::CounterDefinition holds all counter names and must be
+  /// alive until the benchmark finishes.
+  auto counter_definitions = perf::CounterDefinition{};
+
+  if (!perf::HardwareInfo::arm_spe_type().has_value()) {
+    std::cout << "Error: Arm SPE is not supported on this CPU." << std::endl;
+    return 1;
+  }
+
+  /// Initialize sampler: SPE writes its records into the AUX area (4 MB), which is mapped behind the buffer.
+  auto perf_config = perf::SampleConfig{};
+  perf_config.period(4096U); /// Tag every 4,096th operation.
+  perf_config.aux_pages(1024U);
+
+  auto sampler = perf::Sampler{ counter_definitions, perf_config };
+  sampler.trigger("arm_spe_loads", perf::Precision::AllowArbitrarySkid);
+
+  /// Create random access benchmark.
+  auto benchmark = perf::example::AccessBenchmark{ /*randomize the accesses*/ true,
+                                                   /* create benchmark of 512 MB */ 512U };
+
+  /// Start sampling.
+  try {
+    sampler.start();
+  } catch (std::runtime_error& exception) {
+    std::cerr << exception.what() << std::endl;
+    return 1;
+  }
+
+  /// Execute the benchmark (accessing cache lines in a random order) and decode the AUX area every few accesses to
+  /// keep it from running full.
+  auto samples = std::vector<perf::Sample>{};
+  auto value = 0ULL;
+  for (auto index = 0U; index < benchmark.size(); ++index) {
+    value += benchmark[index].value;
+
+    if (index % (1U << 20U) == 0U) {
+      auto drained_samples = sampler.drain_arm_spe();
+      std::move(drained_samples.begin(), drained_samples.end(), std::back_inserter(samples));
+    }
+  }
+  asm volatile(""
+               : "+r,m"(value)
+               :
+               : "memory"); /// We do not want the compiler to optimize away
+                            /// this unused value.
+
+  /// Stop sampling.
+  sampler.stop();
+
+  /// Decode the remaining records and consume the PERF_RECORD_AUX records of the buffer.
+  auto drained_samples = sampler.drain_arm_spe();
+  std::move(drained_samples.begin(), drained_samples.end(), std::back_inserter(samples));
+  std::ignore = sampler.drain();
+
+  /// Print the first samples.
+  const auto count_show_samples = std::min<std::size_t>(samples.size(), 40U);
+  std::cout << "\nRecorded " << samples.size() << " samples." << std::endl;
+  std::cout << "Here are the first " << count_show_samples << " recorded samples:\n" << std::endl;
+  for (auto index = 0U; index < count_show_samples; ++index) {
+    const auto& sample = samples[index];
+
+    if (sample.logical_memory_address().has_value() && sample.data_src().has_value()) {
+      auto data_source = "N/A";
+      if (sample.data_src()->is_mem_l1()) {
+        data_source = "L1d";
+      } else if (sample.data_src()->is_mem_l2()) {
+        data_source = "L2";
+      } else if (sample.data_src()->is_mem_l3()) {
+        data_source = "L3";
+      } else if (sample.data_src()->is_mem_ram()) {
+        data_source = "RAM";
+      }
+
+      const auto weight = sample.weight().value_or(perf::Weight{ 0U, 0U, 0U });
+
+      std::cout << "Time = " << sample.time().value_or(0U) << " | Logical Mem Address = 0x" << std::hex
+                << sample.logical_memory_address().value() << " | Physical Mem Address = 0x"
+                << sample.physical_memory_address().value_or(0U) << std::dec
+                << " | Latency (total, issue, translation) = " << weight.cache_latency() << ", "
+                << weight.instruction_retirement_latency() << ", " << weight.var3()
+                << " | Is Load = " << sample.data_src()->is_load() << " | Data Source = " << data_source << "\n";
+    }
+  }
+  std::cout << std::flush;
+
+  /// Close the sampler.
+  sampler.close();
+
+  return 0;
+}
@@ -0,0 +1,92 @@
+#include "access_benchmark.h"
+#include <fstream>
+#include <iostream>
+#include <perfcpp/analyzer/branch.h>
+#include <perfcpp/sampler.h>
+#include <perfcpp/symbolizer.h>
+
+int
+main()
+{
+  std::cout << "libperf-cpp example: Record branch stacks and aggregate them into hot branches, mispredictions, and an "
+               "AutoFDO profile."
+            << std::endl;
+
+  /// Initialize counter definitions.
+  /// Note that the perf::CounterDefinition holds all counter names and must be
+  /// alive until the benchmark finishes.
+  auto counter_definitions = perf::CounterDefinition{};
+
+  auto sampler = perf::Sampler{ counter_definitions };
+
+  /// Event that generates an overflow which is samples.
+  sampler.trigger("cycles", perf::Precision::AllowArbitrarySkid, perf::Period{ 100000U });
+
+  /// Record all branches in user-mode (ranges between branches are only meaningful if no branch is filtered), including
+  /// their type.
+  sampler.values().thread_id(true).branch_stack(
+    { perf::BranchType::User, perf::BranchType::Any, perf::BranchType::SaveType });
+
+  /// Create random access benchmark.
+  auto benchmark = perf::example::AccessBenchmark{ /*randomize the accesses*/ true,
+                                                   /* create benchmark of 512 MB */ 512U };
+
+  /// Start sampling.
+  try {
+    sampler.start();
+  } catch (std::runtime_error& exception) {
+    std::cerr << exception.what() << std::endl;
+    return 1;
+  }
+
+  /// Execute the benchmark (accessing cache lines in a random order); the branch depends on the data and is hard to
+  /// predict.
+  auto value = 0ULL;
+  for (auto index = 0U; index < benchmark.size(); ++index) {
+    if (benchmark[index].value % 3U == 0U) {
+      value += benchmark[index].value;
+    } else {
+      value ^= benchmark[index].value;
+    }
+  }
+  asm volatile(""
+               : "+r,m"(value)
+               :
+               : "memory"); /// We do not want the compiler to optimize away
+                            /// this unused value.
+
+  /// Stop sampling.
+  sampler.stop();
+
+  /// Aggregate the branch stacks directly from the buffer, without copying samples.
+  auto branch_analyzer = perf::analyzer::BranchAnalyzer{};
+  sampler.drain([&branch_analyzer](const perf::SampleView& sample) { branch_analyzer.consume(sample); });
+
+  /// Print the top-10 branches, resolved to functions.
+  auto symbolizer = perf::Symbolizer{};
+  std::cout << "\nRecorded " << branch_analyzer.count_samples() << " branch stacks with "
+            << branch_analyzer.count_branches() << " branches.\n"
+            << std::endl;
+  std::cout << branch_analyzer.to_string(10U, &symbolizer) << std::endl;
+
+  /// Print the most frequently executed ranges (estimated execution counts of basic blocks).
+  std::cout << "Hot ranges:\n";
+  for (const auto& range : branch_analyzer.ranges(10U)) {
+    std::cout << "\t0x" << std::hex << range.begin() << " - 0x" << range.end() << std::dec << " | count "
+              << range.count() << " | cycles " << range.average_cycles().value_or(0.0) << "\n";
+  }
+
+  /// Write the profile of every binary (e.g., to convert it via "create_llvm_prof --profile=<file> --binary=<path>").
+  auto profile_id = 0U;
+  for (const auto& [binary, profile] : branch_analyzer.to_autofdo(symbolizer)) {
+    const auto file_name = std::string{ "branch_analyzer." }.append(std::to_string(profile_id++)).append(".afdo.txt");
+    auto profile_file = std::ofstream{ file_name };
+    profile_file << profile;
+    std::cout << "\nWrote AutoFDO profile of '" << binary << "' to '" << file_name << "'." << std::endl;
+  }
+
+  /// Close the sampler.
+  sampler.close();
+
+  return 0;
+}
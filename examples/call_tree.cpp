@@ -0,0 +1,67 @@
+#include "access_benchmark.h"
+#include <iostream>
+#include <perfcpp/analyzer/call_tree.h>
+#include <perfcpp/sampler.h>
+#include <perfcpp/symbolizer.h>
+
+int
+main()
+{
+  std::cout << "libperf-cpp example: Record call chains and aggregate them into a call tree." << std::endl;
+
+  /// Initialize counter definitions.
+  /// Note that the perf::CounterDefinition holds all counter names and must be
+  /// alive until the benchmark finishes.
+  auto counter_definitions = perf::CounterDefinition{};
+
+  auto sampler = perf::Sampler{ counter_definitions };
+
+  /// Event that generates an overflow which is samples.
+  sampler.trigger("cycles", perf::Precision::RequestZeroSkid, perf::Period{ 4000U });
+
+  /// Include the instruction pointer, the call chain, and the process id into samples.
+  sampler.values().instruction_pointer(true).callchain(true).thread_id(true);
+
+  /// Create random access benchmark.
+  auto benchmark = perf::example::AccessBenchmark{ /*randomize the accesses*/ true,
+                                                   /* create benchmark of 512 MB */ 512U };
+
+  /// Start sampling.
+  try {
+    sampler.start();
+  } catch (std::runtime_error& exception) {
+    std::cerr << exception.what() << std::endl;
+    return 1;
+  }
+
+  /// Execute the benchmark (accessing cache lines in a random order).
+  auto value = 0ULL;
+  for (auto index = 0U; index < benchmark.size(); ++index) {
+    value += benchmark[index].value;
+  }
+  asm volatile(""
+               : "+r,m"(value)
+               :
+               : "memory"); /// We do not want the compiler to optimize away
+                            /// this unused value.
+
+  /// Stop sampling.
+  sampler.stop();
+
+  /// Fold the call chains into the call tree directly from the buffer, without copying samples.
+  auto call_tree = perf::analyzer::CallTree{};
+  sampler.drain([&call_tree](const perf::SampleView& sample) { call_tree.consume(sample); });
+
+  /// Print the top-10 hotspots, resolved to functions.
+  auto symbolizer = perf::Symbolizer{};
+  std::cout << "\nRecorded " << call_tree.count_samples() << " samples.\n" << std::endl;
+  std::cout << call_tree.to_string(10U, &symbolizer) << std::endl;
+
+  /// Print the collapsed stacks (e.g., to create a flame graph via "flamegraph.pl call_tree.folded > call_tree.svg").
+  std::cout << "Collapsed stacks:\n" << call_tree.to_collapsed_stacks(symbolizer) << std::flush;
+
+  /// Close the sampler.
+  sampler.close();
+
+  return 0;
+}
@@ -1,5 +1,6 @@
 #include "access_benchmark.h"
 #include <iostream>
+#include <perfcpp/counter_delta.h>
 #include <perfcpp/sampler.h>
 
 int
@@ -52,39 +53,27 @@ main()
   /// Stop sampling.
   sampler.stop();
 
-  /// Get all the recorded samples.
-  const auto samples = sampler.result();
-
-  /// Print the first samples.
-  const auto count_show_samples = std::min<std::size_t>(samples.size(), 40U);
-  std::cout << "\nRecorded " << samples.size() << " samples." << std::endl;
-  std::cout << "Here are the first " << count_show_samples << " recorded samples:\n" << std::endl;
-
-  std::optional<perf::CounterResult> last_counter_result = std::nullopt; /// Remember the last counter result to show
-                                                                         /// only the difference.
-
-  for (auto index = 0U; index < count_show_samples; ++index) {
-    const auto& sample = samples[index];
-
-    /// Since we recorded the time, period, the instruction pointer, and the CPU
-    /// id, we can only read these values.
-    if (sample.time().has_value() && sample.counter().has_value()) {
-      if (last_counter_result.has_value()) {
-        std::cout << "Time = " << sample.time().value() << " | cycles (diff) = "
-                  << sample.counter()->get("cycles").value_or(.0) - last_counter_result->get("cycles").value_or(.0)
-                  << " | L1-dcache-loads (diff) = "
-                  << sample.counter()->get("L1-dcache-loads").value_or(.0) -
-                       last_counter_result->get("L1-dcache-loads").value_or(.0)
-                  << " | L1-dcache-load-misses (diff) = "
-                  << sample.counter()->get("L1-dcache-load-misses").value_or(.0) -
-                       last_counter_result->get("L1-dcache-load-misses").value_or(.0)
-                  << "\n";
-      }
-
-      last_counter_result = sample.counter();
+  /// Read the samples directly from the buffer and compute the counter differences between consecutive samples,
+  /// without copying samples or allocating memory per sample.
+  auto counter_delta = perf::CounterDelta{};
+  auto count_samples = 0ULL;
+  constexpr auto count_show_samples = 40ULL;
+  std::cout << "\nHere are the first " << count_show_samples << " recorded samples:\n" << std::endl;
+
+  sampler.drain([&counter_delta, &count_samples](const perf::SampleView& sample) {
+    ++count_samples;
+
+    /// The first sample has no predecessor.
+    if (counter_delta.update(sample) && count_samples <= count_show_samples && sample.time().has_value()) {
+      std::cout << "Time = " << sample.time().value()
+                << " | cycles (diff) = " << counter_delta.value("cycles").value_or(.0)
+                << " | L1-dcache-loads (diff) = " << counter_delta.value("L1-dcache-loads").value_or(.0)
+                << " | L1-dcache-load-misses (diff) = " << counter_delta.value("L1-dcache-load-misses").value_or(.0)
+                << " | miss ratio = " << counter_delta.ratio("L1-dcache-load-misses", "L1-dcache-loads").value_or(.0)
+                << "\n";
     }
-  }
-  std::cout << std::flush;
+  });
+  std::cout << "\nRecorded " << count_samples << " samples." << std::endl;
 
   /// Close the sampler.
   /// Note that the sampler can only be closed after reading the samples.
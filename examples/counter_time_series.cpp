@@ -0,0 +1,66 @@
+#include <iostream>
+#include <perfcpp/counter_time_series.h>
+
+#include "access_benchmark.h"
+
+int
+main()
+{
+  std::cout << "libperf-cpp example: Record performance counters periodically (every 10ms) for "
+               "single-threaded sequential and random access to an in-memory array."
+            << std::endl;
+
+  /// Initialize performance counters.
+  /// Note that the perf::CounterDefinition holds all counter names and must be
+  /// alive until the benchmark finishes.
+  auto counter_definitions = perf::CounterDefinition{};
+
+  /// Read the counters every 10ms and keep up to 1024 intervals.
+  auto time_series =
+    perf::CounterTimeSeries{ counter_definitions, std::chrono::milliseconds{ 10U }, /* capacity */ 1024U };
+
+  /// Add all the performance counters we want to record.
+  try {
+    time_series.add({ "instructions", "cycles", "cache-misses", "cycles-per-instruction" });
+  } catch (std::runtime_error& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  /// Create a sequential and a random access benchmark.
+  auto sequential_benchmark = perf::example::AccessBenchmark{ /*randomize the accesses*/ false,
+                                                              /* create benchmark of 512 MB */ 512U };
+  auto random_benchmark = perf::example::AccessBenchmark{ /*randomize the accesses*/ true,
+                                                          /* create benchmark of 512 MB */ 512U };
+
+  /// Start recording.
+  try {
+    time_series.start();
+  } catch (std::runtime_error& exception) {
+    std::cerr << exception.what() << std::endl;
+    return 1;
+  }
+
+  /// Execute the benchmarks (accessing cache lines sequentially first and in a random order afterward); the time series
+  /// should show the cycles per instruction increasing.
+  auto value = 0ULL;
+  for (auto index = 0U; index < sequential_benchmark.size(); ++index) {
+    value += sequential_benchmark[index].value;
+  }
+  for (auto index = 0U; index < random_benchmark.size(); ++index) {
+    value += random_benchmark[index].value;
+  }
+  asm volatile(""
+               : "+r,m"(value)
+               :
+               : "memory"); /// We do not want the compiler to optimize away
+                            /// this unused value.
+
+  /// Stop recording counters.
+  time_series.stop();
+
+  /// Print the time series as CSV.
+  std::cout << "\nRecorded " << time_series.size() << " intervals:\n" << time_series.to_csv() << std::endl;
+
+  return 0;
+}
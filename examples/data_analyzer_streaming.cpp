@@ -0,0 +1,116 @@
+#include "access_benchmark.h"
+#include <iostream>
+#include <perfcpp/analyzer/data.h>
+#include <perfcpp/hardware_info.h>
+#include <perfcpp/sample_view.h>
+#include <perfcpp/sampler.h>
+
+int
+main()
+{
+  std::cout << "libperf-cpp example: Sample memory addresses and analyze data objects while sampling." << std::endl;
+
+  /// Initialize counter definitions.
+  /// Note that the perf::CounterDefinition holds all counter names and must be
+  /// alive until the benchmark finishes.
+  auto counter_definitions = perf::CounterDefinition{};
+
+  /// Initialize sampler.
+  auto perf_config = perf::SampleConfig{};
+  perf_config.period(16000U); /// Record every 16,000th event.
+
+  auto sampler = perf::Sampler{ counter_definitions, perf_config };
+
+  /// Setup which counters trigger the writing of samples (depends on the underlying hardware substrate).
+  if (perf::HardwareInfo::is_amd_ibs_supported()) {
+    sampler.trigger("ibs_op_uops", perf::Precision::MustHaveZeroSkid);
+  } else if (perf::HardwareInfo::is_intel()) {
+    if (perf::HardwareInfo::is_intel_aux_counter_required()) {
+      /// Note: For sampling on Sapphire Rapids, we have to prepend an auxiliary counter.
+      sampler.trigger({ perf::Sampler::Trigger{ "mem-loads-aux", perf::Precision::MustHaveZeroSkid },
+                        perf::Sampler::Trigger{ "mem-loads", perf::Precision::MustHaveZeroSkid } });
+    } else {
+      sampler.trigger("mem-loads", perf::Precision::MustHaveZeroSkid);
+    }
+  } else {
+    std::cout << "Error: Memory sampling is not supported on this CPU." << std::endl;
+    return 1;
+  }
+
+  /// Setup which data will be included into samples (timestamp, virtual memory address, data source like L1d or RAM,
+  /// and latency).
+  sampler.values().logical_memory_address(true).data_src(true);
+#ifndef PERFCPP_NO_SAMPLE_WEIGHT_STRUCT
+  sampler.values().weight_struct(true);
+#else
+  sampler.values().weight(true);
+#endif
+
+  /// Create random access benchmark.
+  auto benchmark = perf::example::AccessBenchmark{ /*randomize the accesses*/ true,
+                                                   /* create benchmark of 512 MB */ 512U };
+
+  /// Create data types for analyzer.
+  auto data_analyzer = perf::analyzer::DataAnalyzer{};
+  /// 1) Cache line that dictates the pattern.
+  auto pattern_cache_line = perf::analyzer::DataType{ "pattern_cache_line", 64U };
+  for (auto i = 0U; i < 8U; ++i) {
+    auto member_name = std::string{ "index[" }.append(std::to_string(i)).append("]");
+    pattern_cache_line.add<std::uint64_t>(std::move(member_name));
+  }
+  data_analyzer.add(std::move(pattern_cache_line));
+
+  /// Register instances.
+  data_analyzer.annotate("pattern_cache_line", benchmark.indices().data(), benchmark.indices().size());
+
+  /// 2) Data that is accessed
+  auto data_cache_line = perf::analyzer::DataType{ "data_cache_line", 64U };
+  data_cache_line.add<std::uint64_t>("value");
+  data_analyzer.add(std::move(data_cache_line));
+
+  /// Register instances.
+  data_analyzer.annotate("data_cache_line", benchmark.data_to_read().data(), benchmark.data_to_read().size());
+
+  /// Start sampling.
+  try {
+    sampler.start();
+  } catch (std::runtime_error& exception) {
+    std::cerr << exception.what() << std::endl;
+    return 1;
+  }
+
+  /// Execute the benchmark (accessing cache lines in a random order) in rounds. After every round, the recorded
+  /// samples are consumed by the analyzer directly from the buffer, without keeping them in memory.
+  constexpr auto count_rounds = 8U;
+  const auto items_per_round = benchmark.size() / count_rounds;
+  auto value = 0ULL;
+  for (auto round = 0U; round < count_rounds; ++round) {
+    for (auto index = round * items_per_round; index < (round + 1U) * items_per_round; ++index) {
+      value += benchmark[index].value;
+    }
+    asm volatile(""
+                 : "+r,m"(value)
+                 :
+                 : "memory"); /// We do not want the compiler to optimize away
+                              /// this unused value.
+
+    sampler.drain([&data_analyzer](const perf::SampleView& sample) { data_analyzer.consume(sample); });
+
+    /// The current result can be read at any time.
+    const auto result = data_analyzer.result();
+    const auto& statistics = result.data_types().back().members().front().statistics();
+    std::cout << "Round " << round << ": " << statistics.count_loads() << " loads sampled on data_cache_line::value, "
+              << "p90 load latency >= " << statistics.load_latency_percentile(0.9) << " cycles" << std::endl;
+  }
+
+  /// Stop sampling and consume the remaining samples.
+  sampler.stop();
+  sampler.drain([&data_analyzer](const perf::SampleView& sample) { data_analyzer.consume(sample); });
+
+  std::cout << data_analyzer.result().to_string() << std::flush;
+
+  /// Close the sampler.
+  sampler.close();
+
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,329 @@
+#include "memory_workload.h"
+#include <algorithm>
+#include <cstring>
+#include <linux/mempolicy.h>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace perf::example;
+
+MappedMemory::MappedMemory(const std::size_t size, const std::optional<std::uint16_t> numa_node)
+  : _size(size)
+{
+  auto* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (data == MAP_FAILED) {
+    throw std::runtime_error{ "Cannot map memory for workload." };
+  }
+  this->_data = static_cast<std::byte*>(data);
+
+  /// Back the memory by base pages, such that page-strided accesses miss the TLB.
+  ::madvise(data, size, MADV_NOHUGEPAGE);
+
+  /// Bind the memory before touching it, so that all pages are allocated on the node.
+  if (numa_node.has_value()) {
+    auto node_mask = std::array<unsigned long, 16U>{};
+    constexpr auto bits_per_mask = sizeof(unsigned long) * 8U;
+    if (numa_node.value() >= node_mask.size() * bits_per_mask) {
+      ::munmap(data, size);
+      throw std::runtime_error{ "Cannot bind memory for workload: NUMA node is out of range." };
+    }
+    node_mask[numa_node.value() / bits_per_mask] = 1UL << (numa_node.value() % bits_per_mask);
+
+    const auto max_node = node_mask.size() * bits_per_mask;
+    if (::syscall(SYS_mbind, data, size, MPOL_BIND, node_mask.data(), max_node, MPOL_MF_STRICT) != 0) {
+      ::munmap(data, size);
+      throw std::runtime_error{ std::string{ "Cannot bind memory for workload to NUMA node " }
+                                  .append(std::to_string(numa_node.value()))
+                                  .append(".") };
+    }
+  }
+
+  std::memset(data, 0, size);
+}
+
+MappedMemory::~MappedMemory()
+{
+  if (this->_data != nullptr) {
+    ::munmap(this->_data, this->_size);
+  }
+}
+
+Verdict
+MemoryWorkload::check(const std::vector<Sample>& samples) const
+{
+  auto count_samples = std::uint64_t{ 0U };
+  auto count_expected_source = std::uint64_t{ 0U };
+  auto latencies = std::vector<std::uint32_t>{};
+
+  for (const auto& sample : samples) {
+    const auto address = sample.logical_memory_address().value_or(0U);
+    if (address < this->_memory_begin || address >= this->_memory_end || !sample.data_src().has_value() ||
+        sample.data_src()->is_na()) {
+      continue;
+    }
+
+    ++count_samples;
+    if (this->_expectation.is_expected_source(sample.data_src().value())) {
+      ++count_expected_source;
+    }
+
+    if (sample.weight().has_value()) {
+      latencies.push_back(sample.weight()->cache_latency());
+    }
+  }
+
+  auto median_latency = std::optional<std::uint32_t>{ std::nullopt };
+  if (!latencies.empty()) {
+    std::nth_element(latencies.begin(), latencies.begin() + std::int64_t(latencies.size() / 2U), latencies.end());
+    median_latency = latencies[latencies.size() / 2U];
+  }
+
+  const auto is_source_in_band =
+    count_samples > 0U && double(count_expected_source) >= this->_expectation.min_share() * double(count_samples);
+
+  /// Without any latency, only a band starting at zero (i.e., latency is not checked) is met.
+  const auto is_latency_in_band = median_latency.has_value()
+                                    ? median_latency.value() >= this->_expectation.min_latency() &&
+                                        median_latency.value() <= this->_expectation.max_latency()
+                                    : this->_expectation.min_latency() == 0U;
+
+  return Verdict{ count_samples, count_expected_source, median_latency, is_source_in_band, is_latency_in_band };
+}
+
+PointerChase::PointerChase(const Level level)
+  : PointerChase(PointerChase::working_set_size(level), PointerChase::default_expectation(level))
+{
+  constexpr auto names = std::array<const char*, 4U>{ "L1", "L2", "L3", "RAM" };
+  this->_name = std::string{ "pointer-chase-" }.append(names[static_cast<std::uint8_t>(level)]);
+}
+
+PointerChase::PointerChase(const std::size_t working_set_size,
+                           Expectation&& expectation,
+                           const std::optional<std::uint16_t> numa_node)
+  : MemoryWorkload(std::move(expectation))
+  , _name(std::string{ "pointer-chase-" }.append(std::to_string(working_set_size / 1024U)).append("KiB"))
+  , _memory(std::max<std::size_t>(working_set_size, 128U), numa_node)
+{
+  const auto count_lines = this->_memory.size() / 64U;
+
+  /// Sattolo's algorithm creates a single cycle through all cache lines.
+  auto order = std::vector<std::size_t>(count_lines);
+  std::iota(order.begin(), order.end(), 0U);
+  auto random = std::mt19937_64{ std::random_device{}() };
+  for (auto i = count_lines - 1U; i > 0U; --i) {
+    std::swap(order[i], order[std::uniform_int_distribution<std::size_t>{ 0U, i - 1U }(random)]);
+  }
+
+  auto* lines = this->_memory.data();
+  for (auto i = 0U; i < count_lines; ++i) {
+    const auto next = lines + order[i] * 64U;
+    std::memcpy(lines + order[(i + count_lines - 1U) % count_lines] * 64U, &next, sizeof(std::byte*));
+  }
+
+  /// Small working sets are chased multiple times per run to record enough samples.
+  this->_count_loads = std::max<std::uint64_t>(count_lines, 1U << 22U);
+
+  this->memory_range(this->_memory.data(), this->_memory.size());
+}
+
+void
+PointerChase::run()
+{
+  auto* line = this->_memory.data();
+  for (auto load = std::uint64_t{ 0U }; load < this->_count_loads; ++load) {
+    line = *reinterpret_cast<std::byte* const*>(line);
+  }
+
+  asm volatile("" : "+r,m"(line) : : "memory");
+}
+
+std::size_t
+PointerChase::working_set_size(const Level level)
+{
+  const auto cache_size = [](const int name, const std::size_t fallback) {
+    const auto size = ::sysconf(name);
+    return size > 0 ? std::size_t(size) : fallback;
+  };
+
+  switch (level) {
+    case Level::L1:
+      return cache_size(_SC_LEVEL1_DCACHE_SIZE, 32U * 1024U) / 2U;
+    case Level::L2:
+      return cache_size(_SC_LEVEL2_CACHE_SIZE, 1024U * 1024U) / 2U;
+    case Level::L3:
+      return cache_size(_SC_LEVEL3_CACHE_SIZE, 32U * 1024U * 1024U) / 2U;
+    case Level::RAM:
+      return cache_size(_SC_LEVEL3_CACHE_SIZE, 32U * 1024U * 1024U) * 8U;
+  }
+
+  return 0U;
+}
+
+Expectation
+PointerChase::default_expectation(const Level level)
+{
+  switch (level) {
+    case Level::L1:
+      return Expectation{ "L1d", [](const DataSource& data_source) { return data_source.is_mem_l1(); }, .8, 1U, 10U };
+    case Level::L2:
+      return Expectation{
+        "L2", [](const DataSource& data_source) { return data_source.is_mem_l2(); }, .6, 8U, 30U
+      };
+    case Level::L3:
+      return Expectation{
+        "L3", [](const DataSource& data_source) { return data_source.is_mem_l3(); }, .6, 25U, 120U
+      };
+    case Level::RAM:
+      break;
+  }
+
+  return Expectation{
+    "RAM",
+    [](const DataSource& data_source) { return data_source.is_mem_ram() || data_source.is_mem_local_ram(); },
+    .6,
+    100U,
+    2000U
+  };
+}
+
+RemoteNumaAccess::RemoteNumaAccess(const std::size_t working_set_size, const std::optional<std::uint16_t> numa_node)
+  : PointerChase(working_set_size,
+                 Expectation{ "remote RAM",
+                              [](const DataSource& data_source) {
+                                return data_source.is_mem_remote_ram() || data_source.is_mem_remote_cce1() ||
+                                       data_source.is_mem_remote_cce2();
+                              },
+                              .6,
+                              150U,
+                              4000U },
+                 RemoteNumaAccess::remote_numa_node(numa_node))
+{
+  this->_name = "remote-numa";
+}
+
+std::uint16_t
+RemoteNumaAccess::count_numa_nodes()
+{
+  auto count_nodes = std::uint16_t{ 0U };
+  while (::access(("/sys/devices/system/node/node" + std::to_string(count_nodes)).c_str(), F_OK) == 0) {
+    ++count_nodes;
+  }
+
+  return std::max<std::uint16_t>(count_nodes, 1U);
+}
+
+std::uint16_t
+RemoteNumaAccess::remote_numa_node(const std::optional<std::uint16_t> numa_node)
+{
+  const auto count_nodes = RemoteNumaAccess::count_numa_nodes();
+  if (count_nodes < 2U) {
+    throw std::runtime_error{ "Cannot create remote NUMA workload: The system has a single NUMA node." };
+  }
+
+  if (numa_node.has_value()) {
+    return numa_node.value();
+  }
+
+  auto cpu_id = 0U, local_node = 0U;
+  if (::syscall(SYS_getcpu, &cpu_id, &local_node, nullptr) != 0) {
+    local_node = 0U;
+  }
+
+  return local_node == 0U ? 1U : 0U;
+}
+
+StridedAccess::StridedAccess(const std::size_t size, const std::size_t stride)
+  : MemoryWorkload(Expectation{ "DTLB miss",
+                                [](const DataSource& data_source) {
+                                  return data_source.is_tlb_miss() || data_source.is_tlb_walk();
+                                },
+                                .5,
+                                1U,
+                                4000U })
+  , _memory(size)
+  , _stride(std::max<std::size_t>(stride, 64U))
+{
+  this->memory_range(this->_memory.data(), this->_memory.size());
+}
+
+void
+StridedAccess::run()
+{
+  auto value = std::uint64_t{ 0U };
+  for (auto offset = std::size_t{ 0U }; offset < this->_memory.size(); offset += this->_stride) {
+    value += *reinterpret_cast<const std::uint64_t*>(this->_memory.data() + offset);
+  }
+
+  asm volatile("" : "+r,m"(value) : : "memory");
+}
+
+SharingKernel::SharingKernel(const bool is_false_sharing,
+                             const std::uint16_t count_threads,
+                             const std::uint64_t count_increments)
+  : MemoryWorkload(Expectation{ "HITM",
+                                [](const DataSource& data_source) { return data_source.is_snoop_hit_modified(); },
+                                .1,
+                                20U,
+                                4000U })
+  , _is_false_sharing(is_false_sharing)
+  , _count_threads(std::max<std::uint16_t>(count_threads, 2U))
+  , _count_increments(count_increments)
+{
+  this->memory_range(&this->_line, sizeof(SharedLine));
+}
+
+void
+SharingKernel::run()
+{
+  auto threads = std::vector<std::thread>{};
+  threads.reserve(this->_count_threads);
+
+  for (auto thread_id = 0U; thread_id < this->_count_threads; ++thread_id) {
+    auto& counter = this->_line.counters[this->_is_false_sharing ? thread_id % this->_line.counters.size() : 0U];
+
+    /// Separate loads and stores (instead of atomic read-modify-writes) are sampled as regular loads; lost
+    /// increments of true sharing do not matter.
+    threads.emplace_back([&counter, count_increments = this->_count_increments]() {
+      for (auto increment = std::uint64_t{ 0U }; increment < count_increments; ++increment) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1U, std::memory_order_relaxed);
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+StoreBurst::StoreBurst(const std::size_t size, const std::size_t burst_size)
+  : MemoryWorkload(
+      Expectation{ "store", [](const DataSource& data_source) { return data_source.is_store(); }, .9, 0U, 4000U })
+  , _memory(size)
+  , _burst_size(std::max<std::size_t>(burst_size, 1U))
+{
+  this->memory_range(this->_memory.data(), this->_memory.size());
+}
+
+void
+StoreBurst::run()
+{
+  const auto count_lines = this->_memory.size() / 64U;
+
+  auto value = std::uint64_t{ 1U };
+  for (auto line = std::size_t{ 0U }; line < count_lines; line += this->_burst_size) {
+    for (auto burst_line = line; burst_line < std::min(line + this->_burst_size, count_lines); ++burst_line) {
+      std::memcpy(this->_memory.data() + burst_line * 64U, &value, sizeof(value));
+    }
+
+    /// Computation between two bursts lets the store buffer drain.
+    for (auto i = 0U; i < 64U; ++i) {
+      value = value * 6364136223846793005ULL + 1442695040888963407ULL;
+      asm volatile("" : "+r"(value));
+    }
+  }
+}
@@ -0,0 +1,392 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <perfcpp/data_source.h>
+#include <perfcpp/sample.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace perf::example {
+/**
+ * Expected data source and latency of the samples recorded while running a workload: A share of at least
+ * min_share() of the samples accessing the workload's memory should come from the expected data source, and their
+ * median latency (in cycles, see perf::Weight::cache_latency()) should lie within [min_latency(), max_latency()].
+ * The default bands are deliberately wide; calibrate them per CPU generation via MemoryWorkload::expectation().
+ */
+class Expectation
+{
+public:
+  Expectation(std::string&& source_name,
+              std::function<bool(const DataSource&)>&& is_expected_source,
+              const double min_share,
+              const std::uint32_t min_latency,
+              const std::uint32_t max_latency)
+    : _source_name(std::move(source_name))
+    , _is_expected_source(std::move(is_expected_source))
+    , _min_share(min_share)
+    , _min_latency(min_latency)
+    , _max_latency(max_latency)
+  {
+  }
+
+  ~Expectation() = default;
+
+  [[nodiscard]] const std::string& source_name() const noexcept { return _source_name; }
+  [[nodiscard]] bool is_expected_source(const DataSource& data_source) const
+  {
+    return _is_expected_source(data_source);
+  }
+  [[nodiscard]] double min_share() const noexcept { return _min_share; }
+  [[nodiscard]] std::uint32_t min_latency() const noexcept { return _min_latency; }
+  [[nodiscard]] std::uint32_t max_latency() const noexcept { return _max_latency; }
+
+private:
+  std::string _source_name;
+  std::function<bool(const DataSource&)> _is_expected_source;
+  double _min_share;
+  std::uint32_t _min_latency;
+  std::uint32_t _max_latency;
+};
+
+/**
+ * Result of checking the samples of a workload against its expectation.
+ */
+class Verdict
+{
+public:
+  Verdict(const std::uint64_t count_samples,
+          const std::uint64_t count_expected_source,
+          const std::optional<std::uint32_t> median_latency,
+          const bool is_source_in_band,
+          const bool is_latency_in_band) noexcept
+    : _count_samples(count_samples)
+    , _count_expected_source(count_expected_source)
+    , _median_latency(median_latency)
+    , _is_source_in_band(is_source_in_band)
+    , _is_latency_in_band(is_latency_in_band)
+  {
+  }
+
+  ~Verdict() = default;
+
+  /**
+   * @return Number of samples that access the memory of the workload (and have a data source).
+   */
+  [[nodiscard]] std::uint64_t count_samples() const noexcept { return _count_samples; }
+
+  /**
+   * @return Number of samples that access the memory of the workload from the expected data source.
+   */
+  [[nodiscard]] std::uint64_t count_expected_source() const noexcept { return _count_expected_source; }
+
+  /**
+   * @return Share of samples from the expected data source.
+   */
+  [[nodiscard]] double share_expected_source() const noexcept
+  {
+    return _count_samples > 0U ? double(_count_expected_source) / double(_count_samples) : .0;
+  }
+
+  /**
+   * @return Median latency of the samples with a weight, if any.
+   */
+  [[nodiscard]] std::optional<std::uint32_t> median_latency() const noexcept { return _median_latency; }
+
+  [[nodiscard]] bool is_source_in_band() const noexcept { return _is_source_in_band; }
+  [[nodiscard]] bool is_latency_in_band() const noexcept { return _is_latency_in_band; }
+
+  /**
+   * @return True, if both the data source and the latency match the expectation.
+   */
+  [[nodiscard]] bool is_passed() const noexcept { return _is_source_in_band && _is_latency_in_band; }
+
+private:
+  std::uint64_t _count_samples;
+  std::uint64_t _count_expected_source;
+  std::optional<std::uint32_t> _median_latency;
+  bool _is_source_in_band;
+  bool _is_latency_in_band;
+};
+
+/**
+ * Page-aligned memory mapped for a workload, optionally bound to a NUMA node.
+ */
+class MappedMemory
+{
+public:
+  /**
+   * Maps (and touches) memory.
+   *
+   * @param size Size in bytes.
+   * @param numa_node NUMA node to bind the memory to (optional).
+   */
+  explicit MappedMemory(std::size_t size, std::optional<std::uint16_t> numa_node = std::nullopt);
+  MappedMemory(MappedMemory&& other) noexcept
+    : _data(std::exchange(other._data, nullptr))
+    , _size(std::exchange(other._size, 0U))
+  {
+  }
+  MappedMemory(const MappedMemory&) = delete;
+
+  ~MappedMemory();
+
+  MappedMemory& operator=(MappedMemory&&) = delete;
+  MappedMemory& operator=(const MappedMemory&) = delete;
+
+  [[nodiscard]] std::byte* data() const noexcept { return _data; }
+  [[nodiscard]] std::size_t size() const noexcept { return _size; }
+
+private:
+  std::byte* _data;
+  std::size_t _size;
+};
+
+/**
+ * Workload with a known answer: Running the workload accesses memory in a way that should be served from a known
+ * level of the memory hierarchy (or cause a known effect like TLB misses or HITM snoops). Samples recorded while
+ * running the workload (with logical memory address, data source, and weight) are checked against the expectation.
+ */
+class MemoryWorkload
+{
+public:
+  virtual ~MemoryWorkload() = default;
+
+  /**
+   * @return Name of the workload.
+   */
+  [[nodiscard]] virtual std::string name() const = 0;
+
+  /**
+   * Runs the workload once.
+   */
+  virtual void run() = 0;
+
+  /**
+   * @return True, if the workload is measured with a store event (e.g., "mem-stores") instead of a load event.
+   */
+  [[nodiscard]] virtual bool is_store() const noexcept { return false; }
+
+  /**
+   * @return Expected data source and latency of the samples.
+   */
+  [[nodiscard]] const Expectation& expectation() const noexcept { return _expectation; }
+
+  /**
+   * Replaces the expectation, e.g., to calibrate the bands for a specific CPU generation.
+   *
+   * @param expectation New expectation.
+   */
+  void expectation(Expectation&& expectation) noexcept { _expectation = std::move(expectation); }
+
+  /**
+   * @return First address and end address of the memory accessed by the workload.
+   */
+  [[nodiscard]] std::pair<std::uintptr_t, std::uintptr_t> memory_range() const noexcept
+  {
+    return std::make_pair(_memory_begin, _memory_end);
+  }
+
+  /**
+   * Checks the samples that access the memory of the workload against the expectation; other samples are ignored.
+   *
+   * @param samples Samples recorded while running the workload.
+   * @return Verdict of the check.
+   */
+  [[nodiscard]] Verdict check(const std::vector<Sample>& samples) const;
+
+protected:
+  explicit MemoryWorkload(Expectation&& expectation)
+    : _expectation(std::move(expectation))
+  {
+  }
+
+  void memory_range(const void* begin, const std::size_t size) noexcept
+  {
+    _memory_begin = std::uintptr_t(begin);
+    _memory_end = _memory_begin + size;
+  }
+
+private:
+  Expectation _expectation;
+  std::uintptr_t _memory_begin{ 0U };
+  std::uintptr_t _memory_end{ 0U };
+};
+
+/**
+ * Chases pointers through a random cyclic permutation of cache lines, defeating hardware prefetchers: Every load
+ * depends on the previous one, so the latency of the level holding the working set is exposed.
+ */
+class PointerChase : public MemoryWorkload
+{
+public:
+  /// Level of the memory hierarchy the working set is sized for.
+  enum class Level : std::uint8_t
+  {
+    L1,
+    L2,
+    L3,
+    RAM
+  };
+
+  /**
+   * Creates a pointer chase with a working set sized for the given level (using the cache sizes reported by the
+   * system): Half of L1d, L2, or L3, or eight times L3 for RAM.
+   *
+   * @param level Level to hold the working set.
+   */
+  explicit PointerChase(Level level);
+
+  /**
+   * Creates a pointer chase with the given working set.
+   *
+   * @param working_set_size Size of the working set in bytes.
+   * @param expectation Expected data source and latency.
+   * @param numa_node NUMA node to bind the working set to (optional).
+   */
+  PointerChase(std::size_t working_set_size,
+               Expectation&& expectation,
+               std::optional<std::uint16_t> numa_node = std::nullopt);
+
+  ~PointerChase() override = default;
+
+  [[nodiscard]] std::string name() const override { return _name; }
+
+  void run() override;
+
+  /**
+   * @param level Level of the memory hierarchy.
+   * @return Size of the working set fitting the given level.
+   */
+  [[nodiscard]] static std::size_t working_set_size(Level level);
+
+  /**
+   * @param level Level of the memory hierarchy.
+   * @return Default expectation for chasing pointers through the given level.
+   */
+  [[nodiscard]] static Expectation default_expectation(Level level);
+
+protected:
+  std::string _name;
+
+private:
+  MappedMemory _memory;
+
+  /// Number of dependent loads per run; at least one pass over all cache lines.
+  std::uint64_t _count_loads;
+};
+
+/**
+ * Chases pointers through memory bound to a remote NUMA node; the calling thread should stay on its node (e.g., by
+ * pinning it) while running the workload.
+ */
+class RemoteNumaAccess final : public PointerChase
+{
+public:
+  /**
+   * @param working_set_size Size of the working set in bytes (should exceed the L3 cache).
+   * @param numa_node Node to bind the memory to; by default, the first node other than the node of the calling
+   * thread. Throws a std::runtime_error if the system has a single NUMA node.
+   */
+  explicit RemoteNumaAccess(std::size_t working_set_size,
+                            std::optional<std::uint16_t> numa_node = std::nullopt);
+
+  ~RemoteNumaAccess() override = default;
+
+  /**
+   * @return Number of NUMA nodes of the system.
+   */
+  [[nodiscard]] static std::uint16_t count_numa_nodes();
+
+private:
+  [[nodiscard]] static std::uint16_t remote_numa_node(std::optional<std::uint16_t> numa_node);
+};
+
+/**
+ * Reads one cache line every stride bytes; with strides of (at least) a page over a large region, nearly every load
+ * misses the data TLB.
+ */
+class StridedAccess final : public MemoryWorkload
+{
+public:
+  /**
+   * @param size Size of the accessed memory in bytes.
+   * @param stride Distance between two accesses in bytes.
+   */
+  StridedAccess(std::size_t size, std::size_t stride);
+
+  ~StridedAccess() override = default;
+
+  [[nodiscard]] std::string name() const override { return "strided-" + std::to_string(_stride); }
+
+  void run() override;
+
+private:
+  MappedMemory _memory;
+  std::size_t _stride;
+};
+
+/**
+ * Threads incrementing counters that share a cache line: Either every thread increments its own counter placed in a
+ * single cache line (false sharing), or all threads increment the same counter (true sharing). Both cause loads that
+ * hit modified lines in other cores' caches (HITM).
+ */
+class SharingKernel final : public MemoryWorkload
+{
+public:
+  /**
+   * @param is_false_sharing True for false sharing (distinct counters), false for true sharing (one counter).
+   * @param count_threads Number of threads (at most 8 for false sharing); they are spawned by every run, so record
+   * with perf::Config::include_child_threads().
+   * @param count_increments Number of increments per thread and run.
+   */
+  SharingKernel(bool is_false_sharing, std::uint16_t count_threads, std::uint64_t count_increments);
+
+  ~SharingKernel() override = default;
+
+  [[nodiscard]] std::string name() const override { return _is_false_sharing ? "false-sharing" : "true-sharing"; }
+
+  void run() override;
+
+private:
+  /// Eight counters in a single cache line.
+  struct alignas(64U) SharedLine
+  {
+    std::array<std::atomic<std::uint64_t>, 8U> counters{};
+  };
+
+  bool _is_false_sharing;
+  std::uint16_t _count_threads;
+  std::uint64_t _count_increments;
+  SharedLine _line;
+};
+
+/**
+ * Writes bursts of consecutive cache lines, separated by computation, through a region larger than the L2 cache.
+ */
+class StoreBurst final : public MemoryWorkload
+{
+public:
+  /**
+   * @param size Size of the written memory in bytes.
+   * @param burst_size Number of cache lines written per burst.
+   */
+  StoreBurst(std::size_t size, std::size_t burst_size);
+
+  ~StoreBurst() override = default;
+
+  [[nodiscard]] std::string name() const override { return "store-burst-" + std::to_string(_burst_size); }
+
+  void run() override;
+
+  [[nodiscard]] bool is_store() const noexcept override { return true; }
+
+private:
+  MappedMemory _memory;
+  std::size_t _burst_size;
+};
+}
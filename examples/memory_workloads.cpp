@@ -0,0 +1,114 @@
+#include "memory_workload.h"
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <perfcpp/hardware_info.h>
+#include <perfcpp/sampler.h>
+
+/**
+ * Creates a sampler recording logical memory addresses, data sources, and latencies of loads (or stores).
+ */
+std::unique_ptr<perf::Sampler>
+create_sampler(const perf::CounterDefinition& counter_definitions, const bool is_store)
+{
+  auto sample_config = perf::SampleConfig{};
+  sample_config.period(4000U);
+
+  /// The sharing kernels run on threads spawned by the workload.
+  sample_config.include_child_threads(true);
+
+  auto sampler = std::make_unique<perf::Sampler>(counter_definitions, sample_config);
+
+  /// Setup which counters trigger the writing of samples (depends on the underlying hardware substrate).
+  if (perf::HardwareInfo::is_amd_ibs_supported()) {
+    sampler->trigger("ibs_op_uops", perf::Precision::MustHaveZeroSkid);
+  } else if (perf::HardwareInfo::is_intel()) {
+    if (is_store) {
+      sampler->trigger("mem-stores", perf::Precision::MustHaveZeroSkid);
+    } else if (perf::HardwareInfo::is_intel_aux_counter_required()) {
+      /// Note: For sampling on Sapphire Rapids, we have to prepend an auxiliary counter.
+      sampler->trigger({ perf::Sampler::Trigger{ "mem-loads-aux", perf::Precision::MustHaveZeroSkid },
+                         perf::Sampler::Trigger{ "mem-loads", perf::Precision::MustHaveZeroSkid } });
+    } else {
+      sampler->trigger("mem-loads", perf::Precision::MustHaveZeroSkid);
+    }
+  } else {
+    return nullptr;
+  }
+
+  sampler->values().logical_memory_address(true).data_src(true);
+#ifndef PERFCPP_NO_SAMPLE_WEIGHT_STRUCT
+  sampler->values().weight_struct(true);
+#else
+  sampler->values().weight(true);
+#endif
+
+  return sampler;
+}
+
+int
+main()
+{
+  std::cout << "libperf-cpp example: Check memory sampling against workloads with known data sources and latencies "
+               "(pointer chasing per cache level, strided access, remote NUMA access, false and true sharing, and "
+               "store bursts)."
+            << std::endl;
+
+  /// Initialize counter definitions.
+  /// Note that the perf::CounterDefinition holds all counter names and must be
+  /// alive until the benchmark finishes.
+  auto counter_definitions = perf::CounterDefinition{};
+
+  /// Create the workloads.
+  auto workloads = std::vector<std::unique_ptr<perf::example::MemoryWorkload>>{};
+  workloads.emplace_back(std::make_unique<perf::example::PointerChase>(perf::example::PointerChase::Level::L1));
+  workloads.emplace_back(std::make_unique<perf::example::PointerChase>(perf::example::PointerChase::Level::L2));
+  workloads.emplace_back(std::make_unique<perf::example::PointerChase>(perf::example::PointerChase::Level::L3));
+  workloads.emplace_back(std::make_unique<perf::example::PointerChase>(perf::example::PointerChase::Level::RAM));
+  workloads.emplace_back(std::make_unique<perf::example::StridedAccess>(/* 1 GB */ 1024U * 1024U * 1024U, 4096U));
+  if (perf::example::RemoteNumaAccess::count_numa_nodes() > 1U) {
+    workloads.emplace_back(std::make_unique<perf::example::RemoteNumaAccess>(
+      perf::example::PointerChase::working_set_size(perf::example::PointerChase::Level::RAM)));
+  }
+  workloads.emplace_back(std::make_unique<perf::example::SharingKernel>(true, 2U, 1U << 24U));
+  workloads.emplace_back(std::make_unique<perf::example::SharingKernel>(false, 2U, 1U << 24U));
+  workloads.emplace_back(std::make_unique<perf::example::StoreBurst>(/* 64 MB */ 64U * 1024U * 1024U, 16U));
+
+  std::cout << "\n"
+            << std::setw(22) << "workload" << std::setw(12) << "expected" << std::setw(10) << "samples" << std::setw(10)
+            << "share" << std::setw(10) << "latency" << std::setw(8) << "result" << std::endl;
+
+  auto is_all_passed = true;
+  for (auto& workload : workloads) {
+    auto sampler = std::unique_ptr<perf::Sampler>{};
+    try {
+      sampler = create_sampler(counter_definitions, workload->is_store());
+      if (sampler == nullptr) {
+        std::cout << "Error: Memory sampling is not supported on this CPU." << std::endl;
+        return 1;
+      }
+
+      sampler->start();
+    } catch (std::runtime_error& exception) {
+      std::cerr << exception.what() << std::endl;
+      return 1;
+    }
+
+    workload->run();
+
+    sampler->stop();
+    const auto verdict = workload->check(sampler->result());
+    sampler->close();
+
+    is_all_passed &= verdict.is_passed();
+
+    const auto& expectation = workload->expectation();
+    std::cout << std::setw(22) << workload->name() << std::setw(12) << expectation.source_name() << std::setw(10)
+              << verdict.count_samples() << std::setw(10) << std::setprecision(2) << verdict.share_expected_source()
+              << std::setw(10)
+              << (verdict.median_latency().has_value() ? std::to_string(verdict.median_latency().value()) : "N/A")
+              << std::setw(8) << (verdict.is_passed() ? "ok" : "FAILED") << std::endl;
+  }
+
+  return is_all_passed ? 0 : 1;
+}
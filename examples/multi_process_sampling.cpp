@@ -0,0 +1,120 @@
+#include "access_benchmark.h"
+#include <chrono>
+#include <iostream>
+#include <perfcpp/sampler.h>
+#include <set>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+int
+main()
+{
+  std::cout << "libperf-cpp example: Record perf samples including time, instruction pointer, and thread id for an "
+               "already running process that spawns threads while being sampled."
+            << std::endl;
+
+  /// Pipe to let the child process wait until the sampler is attached.
+  int start_pipe[2];
+  if (::pipe(start_pipe) != 0) {
+    std::cerr << "Could not create pipe." << std::endl;
+    return 1;
+  }
+
+  /// The child process (i.e., the "running service") accesses an in-memory array; the first thread runs already
+  /// before the sampler is attached, the second one is spawned while sampling.
+  const auto child_process_id = ::fork();
+  if (child_process_id == 0) {
+    ::close(start_pipe[1]);
+
+    auto benchmark = perf::example::AccessBenchmark{ /*randomize the accesses*/ true,
+                                                     /* create benchmark of 512 MB */ 512U };
+    const auto run = [&benchmark](const std::size_t begin, const std::size_t end) {
+      auto value = 0ULL;
+      for (auto repetition = 0U; repetition < 4U; ++repetition) {
+        for (auto index = begin; index < end; ++index) {
+          value += benchmark[index].value;
+        }
+      }
+      asm volatile("" : "+r,m"(value) : : "memory");
+    };
+
+    auto buffer = char{ 0 };
+    auto first_thread = std::thread{ [&]() {
+      std::ignore = ::read(start_pipe[0], &buffer, 1U);
+      run(0U, benchmark.size() / 2U);
+    } };
+
+    std::this_thread::sleep_for(std::chrono::milliseconds{ 100U });
+    auto second_thread = std::thread{ [&]() { run(benchmark.size() / 2U, benchmark.size()); } };
+
+    first_thread.join();
+    second_thread.join();
+    ::_exit(0);
+  }
+  ::close(start_pipe[0]);
+
+  /// Wait for the first thread of the child to be spawned.
+  std::this_thread::sleep_for(std::chrono::milliseconds{ 50U });
+
+  /// Initialize counter definitions.
+  /// Note that the perf::CounterDefinition holds all counter names and must be
+  /// alive until the benchmark finishes.
+  auto counter_definitions = perf::CounterDefinition{};
+
+  /// Initialize sampler.
+  auto perf_config = perf::SampleConfig{};
+  perf_config.period(1000000U); /// Record every 1,000,000th event.
+
+  /// Attach to all threads of the child process; up to 8 threads can be spawned later.
+  auto sampler = perf::MultiProcessSampler{ counter_definitions, { child_process_id }, perf_config, 8U };
+
+  /// Setup event that triggers writing samples.
+  sampler.trigger("cycles");
+
+  /// Setup what data the samples should include (timestamp, instruction pointer, thread id).
+  sampler.values().time(true).instruction_pointer(true).thread_id(true);
+
+  /// Start sampling all threads of the process.
+  try {
+    sampler.start();
+  } catch (std::runtime_error& exception) {
+    std::cerr << exception.what() << std::endl;
+    ::kill(child_process_id, SIGKILL);
+    return 1;
+  }
+  std::cout << "Attached to " << sampler.thread_ids().size() << " threads of process " << child_process_id << "."
+            << std::endl;
+
+  /// Let the child process start working.
+  std::ignore = ::write(start_pipe[1], "s", 1U);
+  ::close(start_pipe[1]);
+
+  /// Attach new threads periodically, until the child exits.
+  auto status = 0;
+  while (::waitpid(child_process_id, &status, WNOHANG) == 0) {
+    if (const auto count_new_threads = sampler.attach_new_threads(); count_new_threads > 0U) {
+      std::cout << "Attached to " << count_new_threads << " new thread(s)." << std::endl;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds{ 10U });
+  }
+
+  /// Stop sampling.
+  sampler.stop();
+
+  /// Get all the recorded samples – ordered by timestamp.
+  auto samples = sampler.result(true);
+  auto thread_ids = std::set<std::uint32_t>{};
+  for (const auto& sample : samples) {
+    if (sample.thread_id().has_value()) {
+      thread_ids.insert(sample.thread_id().value());
+    }
+  }
+  std::cout << "\nRecorded " << samples.size() << " samples from " << thread_ids.size() << " threads." << std::endl;
+
+  /// Close the sampler.
+  /// Note that the sampler can only be closed after reading the samples.
+  sampler.close();
+
+  return 0;
+}
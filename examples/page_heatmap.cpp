@@ -0,0 +1,100 @@
+#include "access_benchmark.h"
+#include <iostream>
+#include <perfcpp/analyzer/page_heatmap.h>
+#include <perfcpp/hardware_info.h>
+#include <perfcpp/sample_view.h>
+#include <perfcpp/sampler.h>
+
+int
+main()
+{
+  std::cout << "libperf-cpp example: Sample memory addresses and aggregate them into a heatmap of hot and "
+               "cold pages while sampling." << std::endl;
+
+  /// Initialize counter definitions.
+  /// Note that the perf::CounterDefinition holds all counter names and must be
+  /// alive until the benchmark finishes.
+  auto counter_definitions = perf::CounterDefinition{};
+
+  /// Initialize sampler.
+  auto perf_config = perf::SampleConfig{};
+  perf_config.period(16000U); /// Record every 16,000th event.
+
+  auto sampler = perf::Sampler{ counter_definitions, perf_config };
+
+  /// Setup which counters trigger the writing of samples (depends on the underlying hardware substrate).
+  if (perf::HardwareInfo::is_amd_ibs_supported()) {
+    sampler.trigger("ibs_op_uops", perf::Precision::MustHaveZeroSkid);
+  } else if (perf::HardwareInfo::is_intel()) {
+    if (perf::HardwareInfo::is_intel_aux_counter_required()) {
+      /// Note: For sampling on Sapphire Rapids, we have to prepend an auxiliary counter.
+      sampler.trigger({ perf::Sampler::Trigger{ "mem-loads-aux", perf::Precision::MustHaveZeroSkid },
+                        perf::Sampler::Trigger{ "mem-loads", perf::Precision::MustHaveZeroSkid } });
+    } else {
+      sampler.trigger("mem-loads", perf::Precision::MustHaveZeroSkid);
+    }
+  } else {
+    std::cout << "Error: Memory sampling is not supported on this CPU." << std::endl;
+    return 1;
+  }
+
+  /// Setup which data will be included into samples (timestamp, virtual memory address, page size, data source like L1d
+  /// or RAM, and latency).
+  sampler.values().time(true).logical_memory_address(true).data_page_size(true).data_src(true);
+#ifndef PERFCPP_NO_SAMPLE_WEIGHT_STRUCT
+  sampler.values().weight_struct(true);
+#else
+  sampler.values().weight(true);
+#endif
+
+  /// Create random access benchmark.
+  auto benchmark = perf::example::AccessBenchmark{ /*randomize the accesses*/ true,
+                                                   /* create benchmark of 512 MB */ 512U };
+
+  /// Aggregate the samples per page, decaying the heat of all pages by half every 100ms (of sample timestamps), and
+  /// keep at most 16,384 pages.
+  auto heatmap = perf::analyzer::PageHeatmap{ /* window of 100ms */ 100000000ULL,
+                                              /* decay */ 0.5,
+                                              /* max pages */ 16384U };
+
+  /// Start sampling.
+  try {
+    sampler.start();
+  } catch (std::runtime_error& exception) {
+    std::cerr << exception.what() << std::endl;
+    return 1;
+  }
+
+  /// Execute the benchmark in rounds; the first half of the data is accessed in every round, the second half only in
+  /// the first round (and becomes cold). After every round, the samples are consumed directly from the buffer.
+  constexpr auto count_rounds = 8U;
+  const auto half = benchmark.size() / 2U;
+  auto value = 0ULL;
+  for (auto round = 0U; round < count_rounds; ++round) {
+    const auto end = round == 0U ? benchmark.size() : half;
+    for (auto index = 0U; index < end; ++index) {
+      value += benchmark[index].value;
+    }
+    asm volatile(""
+                 : "+r,m"(value)
+                 :
+                 : "memory"); /// We do not want the compiler to optimize away
+                              /// this unused value.
+
+    sampler.drain([&heatmap](const perf::SampleView& sample) { heatmap.consume(sample); });
+
+    std::cout << "Round " << round << ": " << heatmap.count_pages() << " pages (" << heatmap.count_windows()
+              << " windows closed)" << std::endl;
+  }
+
+  /// Stop sampling and consume the remaining samples.
+  sampler.stop();
+  sampler.drain([&heatmap](const perf::SampleView& sample) { heatmap.consume(sample); });
+
+  std::cout << "\n" << heatmap.to_string(10U) << std::flush;
+
+  /// Close the sampler.
+  sampler.close();
+
+  return 0;
+}
@@ -0,0 +1,82 @@
+#include <iostream>
+#include <perfcpp/region_profiler.h>
+#include <thread>
+#include <vector>
+
+#include "access_benchmark.h"
+
+int
+main()
+{
+  std::cout << "libperf-cpp example: Profile nested code regions (sequential and random access to an in-memory "
+               "array) on multiple threads."
+            << std::endl;
+
+  /// Initialize performance counters.
+  /// Note that the perf::CounterDefinition holds all counter names and must be
+  /// alive until the benchmark finishes.
+  auto counter_definitions = perf::CounterDefinition{};
+
+  /// The profiler is the active profiler used by PERFCPP_REGION until it is destroyed.
+  auto profiler = perf::RegionProfiler{ counter_definitions };
+
+  /// Add all the performance counters we want to record.
+  try {
+    profiler.add(std::vector<std::string>{ "instructions", "cycles", "cache-misses", "cycles-per-instruction" });
+  } catch (std::runtime_error& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  /// Create a sequential and a random access benchmark.
+  auto sequential_benchmark = perf::example::AccessBenchmark{ /*randomize the accesses*/ false,
+                                                              /* create benchmark of 128 MB */ 128U };
+  auto random_benchmark = perf::example::AccessBenchmark{ /*randomize the accesses*/ true,
+                                                          /* create benchmark of 128 MB */ 128U };
+
+  /// Every thread opens its own counters when entering its first region.
+  auto threads = std::vector<std::thread>{};
+  for (auto thread_id = 0U; thread_id < 2U; ++thread_id) {
+    threads.emplace_back([&sequential_benchmark, &random_benchmark]() {
+      try {
+        PERFCPP_REGION("benchmark");
+
+        auto value = 0ULL;
+        {
+          PERFCPP_REGION("sequential");
+          for (auto index = 0U; index < sequential_benchmark.size(); ++index) {
+            value += sequential_benchmark[index].value;
+          }
+        }
+        {
+          PERFCPP_REGION("random");
+          for (auto index = 0U; index < random_benchmark.size(); ++index) {
+            value += random_benchmark[index].value;
+          }
+        }
+        asm volatile(""
+                     : "+r,m"(value)
+                     :
+                     : "memory"); /// We do not want the compiler to optimize away
+                                  /// this unused value.
+      } catch (std::runtime_error& exception) {
+        std::cerr << exception.what() << std::endl;
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  /// Print the results of all regions, aggregated over both threads.
+  for (const auto& region : profiler.result()) {
+    std::cout << "\nRegion '" << region.name() << "' (entered " << region.count() << " times)\n";
+    for (const auto& [counter_name, counter_value] : region.inclusive()) {
+      std::cout << "  " << counter_name << ": " << counter_value << " (exclusive: "
+                << region.exclusive().get(counter_name).value_or(.0) << ")\n";
+    }
+  }
+
+  return 0;
+}
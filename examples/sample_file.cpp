@@ -0,0 +1,103 @@
+#include "access_benchmark.h"
+#include <iostream>
+#include <perfcpp/sample_file.h>
+#include <perfcpp/sampler.h>
+
+int
+main()
+{
+  std::cout << "libperf-cpp example: Stream perf samples including time and instruction pointer into a file while "
+               "sampling single-threaded random access to an in-memory array, and read the file afterward."
+            << std::endl;
+
+  /// Initialize counter definitions.
+  /// Note that the perf::CounterDefinition holds all counter names and must be
+  /// alive until the benchmark finishes.
+  auto counter_definitions = perf::CounterDefinition{};
+
+  /// A small buffer is sufficient, since the records are regularly written to the file.
+  auto sample_config = perf::SampleConfig{};
+  sample_config.buffer_pages(64U + 1U);
+
+  auto sampler = perf::Sampler{ counter_definitions, sample_config };
+
+  /// Event that generates an overflow which is samples.
+  sampler.trigger("cycles", perf::Precision::RequestZeroSkid, perf::Period{ 4000U });
+
+  /// Include Timestamp and instruction pointer into samples.
+  sampler.values().time(true).instruction_pointer(true);
+
+  /// Create random access benchmark.
+  auto benchmark = perf::example::AccessBenchmark{ /*randomize the accesses*/ true,
+                                                   /* create benchmark of 512 MB */ 512U };
+
+  const auto file_name = std::string{ "samples.perfcpp" };
+  auto count_written_bytes = 0ULL;
+
+  {
+    /// The writer drains the sampler's buffers into the file.
+    auto writer = perf::SampleWriter{ sampler, file_name };
+
+    /// Start sampling.
+    try {
+      sampler.start();
+    } catch (std::runtime_error& exception) {
+      std::cerr << exception.what() << std::endl;
+      return 1;
+    }
+
+    /// Execute the benchmark (accessing cache lines in a random order) and write the samples every 4096 accesses.
+    auto value = 0ULL;
+    for (auto index = 0U; index < benchmark.size(); ++index) {
+      value += benchmark[index].value;
+
+      if ((index & 4095U) == 0U) {
+        count_written_bytes += writer.write();
+      }
+    }
+    asm volatile(""
+                 : "+r,m"(value)
+                 :
+                 : "memory"); /// We do not want the compiler to optimize away
+                              /// this unused value.
+
+    /// Stop sampling and write the remaining samples.
+    sampler.stop();
+    count_written_bytes += writer.write();
+  }
+
+  /// Close the sampler.
+  sampler.close();
+
+  std::cout << "\nWrote " << count_written_bytes << " bytes to '" << file_name << "'." << std::endl;
+
+  /// Read the file.
+  const auto reader = perf::SampleReader{ file_name };
+
+  /// Visit all samples without copying them.
+  auto count_samples = 0ULL;
+  auto count_user_samples = 0ULL;
+  reader.for_each([&count_samples, &count_user_samples](const perf::SampleView& sample_view) {
+    ++count_samples;
+    if (sample_view.mode() == perf::Sample::Mode::User) {
+      ++count_user_samples;
+    }
+  });
+  std::cout << "Read " << count_samples << " samples (" << count_user_samples << " in user mode)." << std::endl;
+
+  /// Decode the samples into perf::Sample instances and print the first.
+  const auto samples = reader.result();
+  const auto count_show_samples = std::min<std::size_t>(samples.size(), 40U);
+  std::cout << "Here are the first " << count_show_samples << " recorded samples:\n" << std::endl;
+  for (auto index = 0U; index < count_show_samples; ++index) {
+    const auto& sample = samples[index];
+
+    if (sample.time().has_value() && sample.instruction_pointer().has_value()) {
+      std::cout << "Time = " << sample.time().value() << " | Instruction Pointer = 0x" << std::hex
+                << sample.instruction_pointer().value() << std::dec << "\n";
+    }
+  }
+  std::cout << std::flush;
+
+  return 0;
+}
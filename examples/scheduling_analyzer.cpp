@@ -0,0 +1,92 @@
+#include "access_benchmark.h"
+#include <chrono>
+#include <iostream>
+#include <perfcpp/analyzer/scheduling.h>
+#include <perfcpp/sampler.h>
+#include <perfcpp/symbolizer.h>
+#include <thread>
+
+int
+main()
+{
+  std::cout << "libperf-cpp example: Record context switches and analyze on-CPU and off-CPU time, runqueue wait, and "
+               "preemptions."
+            << std::endl;
+
+  /// Initialize counter definitions.
+  /// Note that the perf::CounterDefinition holds all counter names and must be
+  /// alive until the benchmark finishes.
+  auto counter_definitions = perf::CounterDefinition{};
+
+  /// Initialize sampler.
+  auto perf_config = perf::SampleConfig{};
+  perf_config.period(100000U); /// Record every 100,000th event.
+
+  auto sampler = perf::Sampler{ counter_definitions, perf_config };
+
+  /// Event that generates an overflow which is samples.
+  sampler.trigger("cycles");
+
+  /// Include timestamp, thread, CPU, and callchain into samples; record context switches.
+  sampler.values().time(true).thread_id(true).cpu_id(true).callchain(true).context_switch(true);
+
+  /// Create random access benchmark.
+  auto benchmark = perf::example::AccessBenchmark{ /*randomize the accesses*/ true,
+                                                   /* create benchmark of 512 MB */ 512U };
+
+  /// Start sampling.
+  try {
+    sampler.start();
+  } catch (std::runtime_error& exception) {
+    std::cerr << exception.what() << std::endl;
+    return 1;
+  }
+
+  /// Execute the benchmark in chunks, sleeping (i.e., blocking) between the chunks for increasing time.
+  auto value = 0ULL;
+  const auto count_chunks = 16U;
+  const auto chunk_size = benchmark.size() / count_chunks;
+  for (auto chunk = 0U; chunk < count_chunks; ++chunk) {
+    for (auto index = chunk * chunk_size; index < (chunk + 1U) * chunk_size; ++index) {
+      value += benchmark[index].value;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds{ 1U + chunk });
+  }
+  asm volatile(""
+               : "+r,m"(value)
+               :
+               : "memory"); /// We do not want the compiler to optimize away
+                            /// this unused value.
+
+  /// Stop sampling.
+  sampler.stop();
+
+  /// Pair the context switches into on-CPU and off-CPU intervals; off-CPU intervals are attributed to the callchain
+  /// sampled before the thread was switched out.
+  auto scheduling_analyzer = perf::analyzer::SchedulingAnalyzer{};
+  scheduling_analyzer.consume(sampler.result());
+
+  auto symbolizer = perf::Symbolizer{};
+  std::cout << "\nConsumed " << scheduling_analyzer.count_context_switches() << " context switches of "
+            << scheduling_analyzer.count_threads() << " thread(s).\n"
+            << std::endl;
+  std::cout << scheduling_analyzer.to_string(10U, &symbolizer) << std::endl;
+
+  /// Print the histogram of blocked intervals of the thread with the most off-CPU time.
+  if (const auto threads = scheduling_analyzer.threads(1U); !threads.empty()) {
+    const auto& blocked = threads.front().blocked();
+    std::cout << "Blocked intervals of thread " << threads.front().thread_id() << ":\n";
+    for (auto bucket = 1U; bucket < perf::analyzer::SchedulingAnalyzer::Histogram::size(); ++bucket) {
+      if (blocked.count(bucket) > 0U) {
+        std::cout << "\t< " << ((std::uint64_t{ 1U } << bucket) / 1000U) << " us: " << blocked.count(bucket) << "\n";
+      }
+    }
+    std::cout << "p50 = " << blocked.percentile(0.5) / 1000U << " us, p99 = " << blocked.percentile(0.99) / 1000U
+              << " us, max = " << blocked.max() / 1000U << " us" << std::endl;
+  }
+
+  /// Close the sampler.
+  sampler.close();
+
+  return 0;
+}
@@ -0,0 +1,62 @@
+#include <iostream>
+#include <perfcpp/benchmark.h>
+
+#include "access_benchmark.h"
+
+int
+main()
+{
+  std::cout << "libperf-cpp example: Benchmark random access to an in-memory array with warm-up, repetitions, and "
+               "outlier rejection."
+            << std::endl;
+
+  /// Initialize performance counters.
+  /// Note that the perf::CounterDefinition holds all counter names and must be
+  /// alive until the benchmark finishes.
+  auto counter_definitions = perf::CounterDefinition{};
+
+  /// Run 5 warm-up and 20 measured repetitions of 4 iterations each, pinned to the first CPU.
+  auto benchmark_config = perf::BenchmarkConfig{};
+  benchmark_config.warmup_repetitions(5U);
+  benchmark_config.repetitions(20U);
+  benchmark_config.iterations(4U);
+  benchmark_config.cpu_id(0U);
+
+  auto benchmark = perf::Benchmark{ counter_definitions, benchmark_config };
+
+  /// Add all the performance counters we want to record.
+  try {
+    benchmark.add(std::vector<std::string>{ "instructions", "cycles", "cache-misses", "cycles-per-instruction" });
+  } catch (std::runtime_error& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  /// Create random access benchmark.
+  auto random_access_benchmark = perf::example::AccessBenchmark{ /*randomize the accesses*/ true,
+                                                                 /* create benchmark of 16 MB */ 16U };
+
+  try {
+    /// Every iteration accesses the whole array; results are normalized to a single iteration.
+    const auto result = benchmark.run([&random_access_benchmark]() {
+      auto value = 0ULL;
+      for (auto index = 0U; index < random_access_benchmark.size(); ++index) {
+        value += random_access_benchmark[index].value;
+      }
+      asm volatile(""
+                   : "+r,m"(value)
+                   :
+                   : "memory"); /// We do not want the compiler to optimize away
+                                /// this unused value.
+    });
+
+    /// Print the median and the confidence interval of the mean per iteration.
+    std::cout << "\nMedian per iteration:\n" << result.median().to_string() << std::endl;
+    std::cout << "\nAll statistics (CSV):\n" << result.to_csv() << std::endl;
+  } catch (std::runtime_error& exception) {
+    std::cerr << exception.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,79 @@
+#include "access_benchmark.h"
+#include <iostream>
+#include <map>
+#include <perfcpp/sampler.h>
+#include <perfcpp/symbolizer.h>
+
+int
+main()
+{
+  std::cout << "libperf-cpp example: Record instruction pointers and resolve them to functions." << std::endl;
+
+  /// Initialize counter definitions.
+  /// Note that the perf::CounterDefinition holds all counter names and must be
+  /// alive until the benchmark finishes.
+  auto counter_definitions = perf::CounterDefinition{};
+
+  auto sampler = perf::Sampler{ counter_definitions };
+
+  /// Event that generates an overflow which is samples.
+  sampler.trigger("cycles", perf::Precision::RequestZeroSkid, perf::Period{ 4000U });
+
+  /// Include the instruction pointer and the process id into samples; additionally, record memory mappings to resolve
+  /// instruction pointers of libraries that are loaded while sampling.
+  sampler.values().instruction_pointer(true).thread_id(true).mmap(true);
+
+  /// Create random access benchmark.
+  auto benchmark = perf::example::AccessBenchmark{ /*randomize the accesses*/ true,
+                                                   /* create benchmark of 512 MB */ 512U };
+
+  /// Start sampling.
+  try {
+    sampler.start();
+  } catch (std::runtime_error& exception) {
+    std::cerr << exception.what() << std::endl;
+    return 1;
+  }
+
+  /// Execute the benchmark (accessing cache lines in a random order).
+  auto value = 0ULL;
+  for (auto index = 0U; index < benchmark.size(); ++index) {
+    value += benchmark[index].value;
+  }
+  asm volatile(""
+               : "+r,m"(value)
+               :
+               : "memory"); /// We do not want the compiler to optimize away
+                            /// this unused value.
+
+  /// Stop sampling.
+  sampler.stop();
+
+  /// Get all the recorded samples.
+  const auto samples = sampler.result();
+
+  /// Add the recorded memory mappings to the symbolizer and count the samples per function.
+  auto symbolizer = perf::Symbolizer{};
+  symbolizer.consume(samples);
+
+  auto samples_per_function = std::map<std::string, std::uint64_t>{};
+  for (const auto& sample : samples) {
+    if (const auto symbol = symbolizer.resolve(sample); symbol.has_value()) {
+      ++samples_per_function[symbol->demangled_name()];
+    } else if (sample.instruction_pointer().has_value()) {
+      ++samples_per_function["[unknown]"];
+    }
+  }
+
+  std::cout << "\nRecorded " << samples.size() << " samples." << std::endl;
+  for (const auto& [function, count_samples] : samples_per_function) {
+    std::cout << count_samples << "\t" << function << "\n";
+  }
+  std::cout << std::flush;
+
+  /// Close the sampler.
+  /// Note that the sampler can only be closed after reading the samples.
+  sampler.close();
+
+  return 0;
+}
@@ -0,0 +1,97 @@
+#include "access_benchmark.h"
+#include <iostream>
+#include <perfcpp/exporter/perfetto.h>
+#include <perfcpp/exporter/pprof.h>
+#include <perfcpp/sample_view.h>
+#include <perfcpp/sampler.h>
+#include <perfcpp/symbolizer.h>
+
+int
+main()
+{
+  std::cout << "libperf-cpp example: Stream samples into a Perfetto trace and a pprof profile while sampling."
+            << std::endl;
+
+  /// Initialize counter definitions.
+  /// Note that the perf::CounterDefinition holds all counter names and must be
+  /// alive until the benchmark finishes.
+  auto counter_definitions = perf::CounterDefinition{};
+
+  /// Initialize sampler.
+  auto perf_config = perf::SampleConfig{};
+  perf_config.period(100000U); /// Record every 100,000th event.
+
+  auto sampler = perf::Sampler{ counter_definitions, perf_config };
+
+  /// Event that generates an overflow which is samples.
+  sampler.trigger("cycles");
+
+  /// Include timestamp, thread, CPU, period, instruction pointer, and callchain into samples.
+  sampler.values().time(true).thread_id(true).cpu_id(true).period(true).instruction_pointer(true).callchain(true);
+
+  /// Create random access benchmark.
+  auto benchmark = perf::example::AccessBenchmark{ /*randomize the accesses*/ true,
+                                                   /* create benchmark of 512 MB */ 512U };
+
+  /// Both exporters write through a buffered file; the symbolizer names the functions.
+  auto symbolizer = perf::Symbolizer{};
+  auto trace = perf::exporter::PerfettoExporter{ "trace_export.perfetto-trace", &symbolizer };
+  auto profile = perf::exporter::PprofExporter{ "trace_export.pb", &symbolizer, "cycles" };
+
+  /// Start sampling.
+  try {
+    sampler.start();
+  } catch (std::runtime_error& exception) {
+    std::cerr << exception.what() << std::endl;
+    return 1;
+  }
+
+  /// The pprof profile states its start as wall-clock time, converted from the perf clock.
+  if (const auto time_conversion = sampler.time_conversion(); time_conversion.has_value()) {
+    profile.time_conversion(time_conversion.value());
+  }
+
+  /// Execute the benchmark (accessing cache lines in a random order), draining the buffer every 1M accesses.
+  auto value = 0ULL;
+  for (auto index = 0U; index < benchmark.size(); ++index) {
+    value += benchmark[index].value;
+
+    if (index % 1000000U == 0U) {
+      sampler.drain([&trace, &profile](const perf::SampleView& sample) {
+        trace.add(sample);
+        profile.add(sample);
+      });
+    }
+  }
+  asm volatile(""
+               : "+r,m"(value)
+               :
+               : "memory"); /// We do not want the compiler to optimize away
+                            /// this unused value.
+
+  /// Stop sampling.
+  sampler.stop();
+
+  /// Consume the remaining samples.
+  sampler.drain([&trace, &profile](const perf::SampleView& sample) {
+    trace.add(sample);
+    profile.add(sample);
+  });
+
+  std::cout << "Exported " << profile.count_samples() << " samples with " << profile.count_stacks()
+            << " distinct callchains." << std::endl;
+
+  /// Write the remaining data; the pprof profile is written when closing.
+  trace.close();
+  profile.close();
+
+  std::cout << "Wrote 'trace_export.perfetto-trace' (" << trace.size()
+            << " bytes, open at https://ui.perfetto.dev) and 'trace_export.pb' (view via 'pprof -http=: "
+               "trace_export.pb')."
+            << std::endl;
+
+  /// Close the sampler.
+  sampler.close();
+
+  return 0;
+}
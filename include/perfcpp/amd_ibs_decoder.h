@@ -0,0 +1,144 @@
+#pragma once
+
+#include "data_source.h"
+#include "weight.h"
+#include <cstdint>
+#include <cstring>
+#include <optional>
+
+namespace perf {
+/**
+ * Decodes the registers recorded by AMD Instruction Based Sampling (IBS) as raw data of the sample record (see the
+ * "AMD64 Architecture Programmer's Manual", Volume 2, chapter "Instruction-Based Sampling"). The decoder is a view on
+ * the raw data and does not copy it; it is only valid as long as the raw data is (e.g., during the callback of
+ * Sampler::for_each()).
+ */
+class AmdIbsDecoder
+{
+public:
+  /// IBS unit that recorded the sample.
+  enum class Type : std::uint8_t
+  {
+    Op = 1U,
+    Fetch = 2U
+  };
+
+  /**
+   * Creates a decoder for the raw data of an IBS sample record.
+   *
+   * @param type IBS unit that recorded the sample.
+   * @param raw_data Raw data of the sample record (the IBS capabilities followed by the IBS registers).
+   * @param size Size of the raw data in bytes.
+   */
+  AmdIbsDecoder(const Type type, const char* raw_data, const std::size_t size) noexcept
+    : _type(type)
+    , _registers(raw_data + sizeof(std::uint32_t))
+    , _count_registers(size > sizeof(std::uint32_t) ? (size - sizeof(std::uint32_t)) / sizeof(std::uint64_t) : 0U)
+  {
+    if (size >= sizeof(std::uint32_t)) {
+      std::memcpy(&_capabilities, raw_data, sizeof(std::uint32_t));
+    }
+  }
+
+  ~AmdIbsDecoder() noexcept = default;
+
+  /**
+   * Determines the IBS unit of events with the given perf type, detected via HardwareInfo::amd_ibs_op_type() and
+   * HardwareInfo::amd_ibs_fetch_type(). The L3-miss-only variants (see HardwareInfo::is_ibs_l3_filter_supported())
+   * share the type of their unit.
+   *
+   * @param perf_type Type of the event (see perf_event_attr::type).
+   * @return The IBS unit, std::nullopt for events that are not IBS events.
+   */
+  [[nodiscard]] static std::optional<Type> type_of(std::uint32_t perf_type);
+
+  /**
+   * @return IBS unit that recorded the sample.
+   */
+  [[nodiscard]] Type type() const noexcept { return _type; }
+
+  /**
+   * @return IBS capabilities of the processor (see CPUID Fn8000_001B_EAX).
+   */
+  [[nodiscard]] std::uint32_t capabilities() const noexcept { return _capabilities; }
+
+  /**
+   * @param index Index of the register, starting with IbsOpCtl (or IbsFetchCtl) at zero.
+   * @return Value of the recorded register, zero if the register was not recorded.
+   */
+  [[nodiscard]] std::uint64_t register_value(const std::size_t index) const noexcept
+  {
+    auto value = std::uint64_t{ 0U };
+    if (index < _count_registers) {
+      std::memcpy(&value, _registers + index * sizeof(std::uint64_t), sizeof(std::uint64_t));
+    }
+
+    return value;
+  }
+
+  /**
+   * @return Number of recorded registers.
+   */
+  [[nodiscard]] std::size_t count_registers() const noexcept { return _count_registers; }
+
+  /**
+   * @return True, if the sample was recorded for a load or store (IBS Op only).
+   */
+  [[nodiscard]] bool is_load_store() const noexcept
+  {
+    return _type == Type::Op && static_cast<bool>(register_value(OP_DATA3) & 0x3U);
+  }
+
+  /**
+   * @return Address of the tagged operation (IbsOpRip) or fetch (IbsFetchLinAd), if valid.
+   */
+  [[nodiscard]] std::optional<std::uintptr_t> instruction_pointer() const noexcept;
+
+  /**
+   * @return Data address of the load or store (IbsDcLinAd), if valid (IBS Op only).
+   */
+  [[nodiscard]] std::optional<std::uintptr_t> logical_memory_address() const noexcept;
+
+  /**
+   * @return Physical address of the data (IbsDcPhysAd) or fetch (IbsFetchPhysAd), if valid.
+   */
+  [[nodiscard]] std::optional<std::uintptr_t> physical_memory_address() const noexcept;
+
+  /**
+   * @return For loads and stores, the data cache miss latency (cache latency), the tag-to-retire latency
+   * (instruction retirement latency), and the TLB refill latency (var3); for fetches, the fetch latency.
+   */
+  [[nodiscard]] std::optional<Weight> weight() const noexcept;
+
+  /**
+   * @return The memory level the data (or the fetched instruction) was served from, TLB hits and misses, and
+   * snoops, encoded like perf_mem_data_src; PERF_MEM_OP_NA for operations that are neither loads nor stores.
+   */
+  [[nodiscard]] std::optional<DataSource> data_src() const noexcept;
+
+private:
+  /// Registers recorded by IBS Op.
+  constexpr static inline auto OP_RIP = std::size_t{ 1U };
+  constexpr static inline auto OP_DATA = std::size_t{ 2U };
+  constexpr static inline auto OP_DATA2 = std::size_t{ 3U };
+  constexpr static inline auto OP_DATA3 = std::size_t{ 4U };
+  constexpr static inline auto DC_LINEAR_ADDRESS = std::size_t{ 5U };
+  constexpr static inline auto DC_PHYSICAL_ADDRESS = std::size_t{ 6U };
+
+  /// Registers recorded by IBS Fetch.
+  constexpr static inline auto FETCH_CONTROL = std::size_t{ 0U };
+  constexpr static inline auto FETCH_LINEAR_ADDRESS = std::size_t{ 1U };
+  constexpr static inline auto FETCH_PHYSICAL_ADDRESS = std::size_t{ 2U };
+
+  /// Capability of extended data sources (Zen 4 and later).
+  constexpr static inline auto CAPABILITY_ZEN4 = std::uint32_t{ 1U << 11U };
+
+  Type _type;
+  const char* _registers;
+  std::size_t _count_registers;
+  std::uint32_t _capabilities{ 0U };
+
+  [[nodiscard]] DataSource op_data_source() const noexcept;
+  [[nodiscard]] DataSource fetch_data_source() const noexcept;
+};
+}
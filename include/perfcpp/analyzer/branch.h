@@ -0,0 +1,440 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <perfcpp/branch.h>
+#include <perfcpp/sample.h>
+#include <perfcpp/sample_view.h>
+#include <perfcpp/symbolizer.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace perf::analyzer {
+/**
+ * The BranchAnalyzer aggregates sampled branch stacks (LBR) into a histogram of taken branches (from→to edges) and of
+ * the address ranges executed between two consecutive branches of a stack (fall-through ranges, i.e., sequences of
+ * basic blocks). For every edge, the analyzer counts mispredictions and sums up the cycles of the block ending with the
+ * branch (where the hardware records cycles); mispredictions are also reported per type of branch.
+ * Edges and ranges are kept in compact open-addressing hash tables and can be exported in the text format of AutoFDO
+ * (see to_autofdo()), which can be fed into profile-guided optimization of compilers.
+ * Edges and ranges are aggregated per process and address. The BranchAnalyzer is not thread-safe; analyzers filled by
+ * different threads can be combined via merge().
+ */
+class BranchAnalyzer
+{
+public:
+  /// Taken branch (from→to) with the number of samples and mispredictions.
+  class Edge
+  {
+  public:
+    Edge(const std::uint32_t process_id,
+         const std::uintptr_t from,
+         const std::uintptr_t to,
+         const Branch::Type type,
+         const std::uint64_t count,
+         const std::uint64_t count_mispredicted,
+         const std::uint64_t count_cycles,
+         const std::uint64_t count_with_cycles) noexcept
+      : _process_id(process_id)
+      , _from(from)
+      , _to(to)
+      , _type(type)
+      , _count(count)
+      , _count_mispredicted(count_mispredicted)
+      , _count_cycles(count_cycles)
+      , _count_with_cycles(count_with_cycles)
+    {
+    }
+    ~Edge() = default;
+
+    /**
+     * @return Id of the process that recorded the branch.
+     */
+    [[nodiscard]] std::uint32_t process_id() const noexcept { return _process_id; }
+
+    /**
+     * @return Address of the branch instruction.
+     */
+    [[nodiscard]] std::uintptr_t from() const noexcept { return _from; }
+
+    /**
+     * @return Target address of the branch.
+     */
+    [[nodiscard]] std::uintptr_t to() const noexcept { return _to; }
+
+    /**
+     * @return Type of the branch (Branch::Type::Unknown if the type was not recorded).
+     */
+    [[nodiscard]] Branch::Type type() const noexcept { return _type; }
+
+    /**
+     * @return Number of times the branch was recorded.
+     */
+    [[nodiscard]] std::uint64_t count() const noexcept { return _count; }
+
+    /**
+     * @return Number of times the branch was recorded as mispredicted.
+     */
+    [[nodiscard]] std::uint64_t count_mispredicted() const noexcept { return _count_mispredicted; }
+
+    /**
+     * @return Share of mispredicted branches.
+     */
+    [[nodiscard]] double misprediction_rate() const noexcept
+    {
+      return _count > 0U ? double(_count_mispredicted) / double(_count) : 0.0;
+    }
+
+    /**
+     * @return Average number of cycles of the block ending with the branch, std::nullopt if the hardware did not
+     * record cycles.
+     */
+    [[nodiscard]] std::optional<double> average_cycles() const noexcept
+    {
+      if (_count_with_cycles > 0U) {
+        return double(_count_cycles) / double(_count_with_cycles);
+      }
+
+      return std::nullopt;
+    }
+
+  private:
+    std::uint32_t _process_id;
+    std::uintptr_t _from;
+    std::uintptr_t _to;
+    Branch::Type _type;
+    std::uint64_t _count;
+    std::uint64_t _count_mispredicted;
+    std::uint64_t _count_cycles;
+    std::uint64_t _count_with_cycles;
+  };
+
+  /// Address range executed without a taken branch, from the target of a branch to the next branch.
+  class Range
+  {
+  public:
+    Range(const std::uint32_t process_id,
+          const std::uintptr_t begin,
+          const std::uintptr_t end,
+          const std::uint64_t count,
+          const std::uint64_t count_cycles,
+          const std::uint64_t count_with_cycles) noexcept
+      : _process_id(process_id)
+      , _begin(begin)
+      , _end(end)
+      , _count(count)
+      , _count_cycles(count_cycles)
+      , _count_with_cycles(count_with_cycles)
+    {
+    }
+    ~Range() = default;
+
+    /**
+     * @return Id of the process that executed the range.
+     */
+    [[nodiscard]] std::uint32_t process_id() const noexcept { return _process_id; }
+
+    /**
+     * @return First address of the range (target of the preceding branch).
+     */
+    [[nodiscard]] std::uintptr_t begin() const noexcept { return _begin; }
+
+    /**
+     * @return Last address of the range (the next branch instruction, inclusive).
+     */
+    [[nodiscard]] std::uintptr_t end() const noexcept { return _end; }
+
+    /**
+     * @return Estimated number of executions of the range (and therefore of every basic block within the range).
+     */
+    [[nodiscard]] std::uint64_t count() const noexcept { return _count; }
+
+    /**
+     * @return Average number of cycles to execute the range, std::nullopt if the hardware did not record cycles.
+     */
+    [[nodiscard]] std::optional<double> average_cycles() const noexcept
+    {
+      if (_count_with_cycles > 0U) {
+        return double(_count_cycles) / double(_count_with_cycles);
+      }
+
+      return std::nullopt;
+    }
+
+  private:
+    std::uint32_t _process_id;
+    std::uintptr_t _begin;
+    std::uintptr_t _end;
+    std::uint64_t _count;
+    std::uint64_t _count_cycles;
+    std::uint64_t _count_with_cycles;
+  };
+
+  /// Number of branches and mispredictions of a single branch type.
+  class TypeStatistic
+  {
+  public:
+    TypeStatistic(const Branch::Type type, const std::uint64_t count, const std::uint64_t count_mispredicted) noexcept
+      : _type(type)
+      , _count(count)
+      , _count_mispredicted(count_mispredicted)
+    {
+    }
+    ~TypeStatistic() = default;
+
+    [[nodiscard]] Branch::Type type() const noexcept { return _type; }
+    [[nodiscard]] std::uint64_t count() const noexcept { return _count; }
+    [[nodiscard]] std::uint64_t count_mispredicted() const noexcept { return _count_mispredicted; }
+
+    /**
+     * @return Share of mispredicted branches of the type.
+     */
+    [[nodiscard]] double misprediction_rate() const noexcept
+    {
+      return _count > 0U ? double(_count_mispredicted) / double(_count) : 0.0;
+    }
+
+  private:
+    Branch::Type _type;
+    std::uint64_t _count;
+    std::uint64_t _count_mispredicted;
+  };
+
+  BranchAnalyzer() = default;
+  ~BranchAnalyzer() = default;
+
+  /**
+   * Adds the branch stack of the given sample (directly from the buffer, i.e., without copying the branches).
+   *
+   * @param sample Sample to add.
+   */
+  void consume(const SampleView& sample);
+
+  /**
+   * Adds the branch stack of the given sample.
+   *
+   * @param sample Sample to add.
+   */
+  void consume(const Sample& sample);
+
+  /**
+   * Adds the given branch stack.
+   *
+   * @param process_id Id of the process, used to resolve addresses in to_string() and to_autofdo().
+   * @param branches Branch stack, starting with the most recent branch (as recorded by the perf subsystem).
+   */
+  void add(std::uint32_t process_id, const std::vector<Branch>& branches);
+
+  /**
+   * Merges the given analyzer into this analyzer (e.g., analyzers that were filled on different threads).
+   *
+   * @param other Analyzer to merge.
+   */
+  void merge(const BranchAnalyzer& other);
+
+  /**
+   * @return Number of consumed branch stacks.
+   */
+  [[nodiscard]] std::uint64_t count_samples() const noexcept { return _count_samples; }
+
+  /**
+   * @return Number of consumed branches.
+   */
+  [[nodiscard]] std::uint64_t count_branches() const noexcept { return _count_branches; }
+
+  /**
+   * Lists the most frequently taken branches.
+   *
+   * @param count Maximal number of edges.
+   * @return Edges, ordered by the number of samples.
+   */
+  [[nodiscard]] std::vector<Edge> edges(std::size_t count = std::numeric_limits<std::size_t>::max()) const;
+
+  /**
+   * Lists the most frequently executed ranges (i.e., the estimated execution counts of basic blocks).
+   *
+   * @param count Maximal number of ranges.
+   * @return Ranges, ordered by the number of executions.
+   */
+  [[nodiscard]] std::vector<Range> ranges(std::size_t count = std::numeric_limits<std::size_t>::max()) const;
+
+  /**
+   * @return Number of branches and mispredictions per recorded branch type.
+   */
+  [[nodiscard]] std::vector<TypeStatistic> types() const;
+
+  /**
+   * Exports ranges and edges in the text format of AutoFDO (read by, e.g., create_llvm_prof and llvm-profgen), one
+   * profile per binary or library: the number of ranges, followed by one "begin-end:count" line per range, the number
+   * of edges, and one "from->to:count" line per edge; addresses are hexadecimal.
+   * Addresses are translated into addresses within the binary (see Symbolizer::translate()), such that profiles of
+   * position-independent executables and shared libraries are valid. Ranges and edges that cross binaries or are not
+   * located in a mapped file (e.g., in the kernel) are skipped.
+   *
+   * @param symbolizer Symbolizer holding the memory mappings of the sampled processes.
+   * @return Path of every binary and its profile in the AutoFDO text format, ordered by path.
+   */
+  [[nodiscard]] std::vector<std::pair<std::string, std::string>> to_autofdo(Symbolizer& symbolizer) const;
+
+  /**
+   * Formats the most frequently taken branches and the mispredictions per branch type as a table.
+   *
+   * @param count Maximal number of edges.
+   * @param symbolizer Symbolizer to resolve addresses; may be nullptr.
+   * @return Table of edges and branch types.
+   */
+  [[nodiscard]] std::string to_string(std::size_t count = 20U, Symbolizer* symbolizer = nullptr) const;
+
+private:
+  /// Values aggregated per edge.
+  struct EdgeValue
+  {
+    Branch::Type type;
+    std::uint64_t count;
+    std::uint64_t count_mispredicted;
+    std::uint64_t count_cycles;
+    std::uint64_t count_with_cycles;
+  };
+
+  /// Values aggregated per range.
+  struct RangeValue
+  {
+    std::uint64_t count;
+    std::uint64_t count_cycles;
+    std::uint64_t count_with_cycles;
+  };
+
+  /// Values aggregated per branch type.
+  struct TypeValue
+  {
+    std::uint64_t count;
+    std::uint64_t count_mispredicted;
+  };
+
+  /// Branch of the stack, taken either from a perf::Branch or a perf_branch_entry.
+  struct Entry
+  {
+    std::uintptr_t from;
+    std::uintptr_t to;
+    bool is_mispredicted;
+    std::uint16_t cycles;
+    Branch::Type type;
+  };
+
+  /**
+   * Hash table with open addressing (linear probing) that maps a process and a pair of addresses to a value; the
+   * capacity is a power of two and is doubled once the table is filled by 70%.
+   */
+  template<typename V>
+  class AddressTable
+  {
+  public:
+    struct Slot
+    {
+      std::uint32_t process_id;
+      std::uintptr_t first;
+      std::uintptr_t second;
+      V value;
+      bool is_occupied;
+    };
+
+    /**
+     * @return The value stored for the given process and pair of addresses, value-initialized if not existing.
+     */
+    [[nodiscard]] V& get(const std::uint32_t process_id, const std::uintptr_t first, const std::uintptr_t second)
+    {
+      if ((_size + 1U) * 10U > _slots.size() * 7U) {
+        grow();
+      }
+
+      auto& slot = find(_slots, process_id, first, second);
+      if (!slot.is_occupied) {
+        slot = Slot{ process_id, first, second, V{}, true };
+        ++_size;
+      }
+
+      return slot.value;
+    }
+
+    [[nodiscard]] const std::vector<Slot>& slots() const noexcept { return _slots; }
+    [[nodiscard]] std::size_t size() const noexcept { return _size; }
+
+  private:
+    std::vector<Slot> _slots;
+    std::size_t _size{ 0U };
+
+    [[nodiscard]] static Slot& find(std::vector<Slot>& slots,
+                                    const std::uint32_t process_id,
+                                    const std::uintptr_t first,
+                                    const std::uintptr_t second) noexcept
+    {
+      auto hash =
+        (std::uint64_t{ first } * 0x9E3779B97F4A7C15ULL ^ std::uint64_t{ second }) + std::uint64_t{ process_id };
+      hash ^= hash >> 29U;
+      hash *= 0xBF58476D1CE4E5B9ULL;
+      hash ^= hash >> 32U;
+
+      const auto mask = slots.size() - 1U;
+      for (auto index = std::size_t(hash) & mask;; index = (index + 1U) & mask) {
+        auto& slot = slots[index];
+        if (!slot.is_occupied ||
+            (slot.first == first && slot.second == second && slot.process_id == process_id)) {
+          return slot;
+        }
+      }
+    }
+
+    void grow()
+    {
+      auto slots = std::vector<Slot>(std::max<std::size_t>(_slots.size() * 2U, 1024U));
+      for (const auto& slot : _slots) {
+        if (slot.is_occupied) {
+          find(slots, slot.process_id, slot.first, slot.second) = slot;
+        }
+      }
+      _slots = std::move(slots);
+    }
+  };
+
+  /// Ranges longer than this are considered invalid (e.g., if the stack crosses user and kernel space).
+  constexpr static inline auto MAX_RANGE_SIZE = std::uintptr_t{ 16U * 1024U };
+
+  /// Histogram of edges, keyed by (process, from, to).
+  AddressTable<EdgeValue> _edges;
+
+  /// Histogram of ranges, keyed by (process, begin, end).
+  AddressTable<RangeValue> _ranges;
+
+  /// Branches and mispredictions per branch type (the perf subsystem encodes types in four bits).
+  std::array<TypeValue, 16U> _types{};
+
+  /// Number of consumed branch stacks.
+  std::uint64_t _count_samples{ 0U };
+
+  /// Number of consumed branches.
+  std::uint64_t _count_branches{ 0U };
+
+  [[nodiscard]] static Entry entry(const Branch& branch) noexcept;
+  [[nodiscard]] static Entry entry(const perf_branch_entry& branch) noexcept;
+
+  /**
+   * Adds the branch stack (most recent branch first) to the histograms.
+   */
+  template<typename B>
+  void add(std::uint32_t process_id, const B* branches, std::size_t size);
+
+  /**
+   * @return Name of the given address as "function+offset" (or the hexadecimal address, if not resolved).
+   */
+  [[nodiscard]] static std::string name(std::uint32_t process_id, std::uintptr_t address, Symbolizer* symbolizer);
+
+  /**
+   * @return Name of the given branch type.
+   */
+  [[nodiscard]] static const char* name(Branch::Type type) noexcept;
+};
+}
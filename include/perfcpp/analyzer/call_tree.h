@@ -0,0 +1,206 @@
+#pragma once
+
+#include <cstdint>
+#include <perfcpp/sample.h>
+#include <perfcpp/sample_view.h>
+#include <perfcpp/symbolizer.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace perf::analyzer {
+/**
+ * The CallTree folds sampled call chains (or instruction pointers, if no call chains were sampled) into a trie of
+ * call stacks, starting at the outermost frame. Every node counts the samples whose stack ends in the node (self) and
+ * the samples whose stack passes through the node (total).
+ * Nodes are allocated in a single contiguous arena and addressed by their index; child lookups use a single hash map
+ * for the entire tree. Samples of different processes are kept in separate sub-trees.
+ * The CallTree is not thread-safe; trees built by different threads can be combined via merge().
+ */
+class CallTree
+{
+public:
+  /// Hotspot, i.e., a function (or address, if not resolved) and its number of samples.
+  class Hotspot
+  {
+  public:
+    Hotspot(std::string&& name, const std::uint64_t count_self, const std::uint64_t count_total) noexcept
+      : _name(std::move(name))
+      , _count_self(count_self)
+      , _count_total(count_total)
+    {
+    }
+    ~Hotspot() = default;
+
+    /**
+     * @return Name of the function (or the address, if the function could not be resolved).
+     */
+    [[nodiscard]] const std::string& name() const noexcept { return _name; }
+
+    /**
+     * @return Number of samples in the function itself.
+     */
+    [[nodiscard]] std::uint64_t count_self() const noexcept { return _count_self; }
+
+    /**
+     * @return Number of samples in the function and the functions called by it.
+     */
+    [[nodiscard]] std::uint64_t count_total() const noexcept { return _count_total; }
+
+  private:
+    std::string _name;
+    std::uint64_t _count_self;
+    std::uint64_t _count_total;
+  };
+
+  CallTree() = default;
+  ~CallTree() = default;
+
+  /**
+   * Adds the call chain (or the instruction pointer, if the call chain was not sampled) of the given sample to the
+   * tree. Samples without process id are added to a common sub-tree.
+   *
+   * @param sample Sample to add.
+   */
+  void consume(const SampleView& sample) { consume_sample(sample); }
+
+  /**
+   * Adds the call chain (or the instruction pointer, if the call chain was not sampled) of the given sample to the
+   * tree (see consume(SampleView)).
+   *
+   * @param sample Sample to add.
+   */
+  void consume(const Sample& sample) { consume_sample(sample); }
+
+  /**
+   * Adds the given call stack to the tree.
+   *
+   * @param process_id Id of the process.
+   * @param callchain Call chain, starting with the innermost frame (as recorded by the perf subsystem).
+   * @param count Number of samples to add.
+   */
+  void add(std::uint32_t process_id, const std::vector<std::uintptr_t>& callchain, std::uint64_t count = 1U)
+  {
+    add(process_id, callchain.data(), callchain.size(), count);
+  }
+
+  /**
+   * Merges the given tree into this tree (e.g., trees that were built on different threads or CPU cores).
+   *
+   * @param other Tree to merge.
+   */
+  void merge(const CallTree& other);
+
+  /**
+   * @return Number of samples in the tree.
+   */
+  [[nodiscard]] std::uint64_t count_samples() const noexcept { return _count_samples; }
+
+  /**
+   * @return Number of nodes in the tree (excluding the root).
+   */
+  [[nodiscard]] std::size_t size() const noexcept { return _nodes.size() - 1U; }
+
+  /**
+   * Exports the tree as collapsed stacks ("outer;...;inner count" per line), the input format of flame-graph tools.
+   * Frames are printed as hexadecimal addresses.
+   *
+   * @return Collapsed stacks.
+   */
+  [[nodiscard]] std::string to_collapsed_stacks() const;
+
+  /**
+   * Exports the tree as collapsed stacks ("outer;...;inner count" per line), the input format of flame-graph tools.
+   * Frames are resolved to function names through the given symbolizer.
+   *
+   * @param symbolizer Symbolizer to resolve addresses.
+   * @return Collapsed stacks.
+   */
+  [[nodiscard]] std::string to_collapsed_stacks(Symbolizer& symbolizer) const;
+
+  /**
+   * Lists the functions (or addresses, if no symbolizer is given) with the most samples, ordered by self samples.
+   *
+   * @param count Maximal number of hotspots.
+   * @param symbolizer Symbolizer to resolve addresses; may be nullptr.
+   * @return List of hotspots.
+   */
+  [[nodiscard]] std::vector<Hotspot> hotspots(std::size_t count, Symbolizer* symbolizer = nullptr) const;
+
+  /**
+   * Formats the hotspots as a table.
+   *
+   * @param count Maximal number of hotspots.
+   * @param symbolizer Symbolizer to resolve addresses; may be nullptr.
+   * @return Table of hotspots.
+   */
+  [[nodiscard]] std::string to_string(std::size_t count = 20U, Symbolizer* symbolizer = nullptr) const;
+
+private:
+  /// Node of the tree; the root is the first node, processes are children of the root.
+  struct Node
+  {
+    std::uintptr_t address;
+    std::uint32_t process_id;
+    std::uint32_t parent;
+    std::uint32_t first_child;
+    std::uint32_t next_sibling;
+    std::uint64_t count_self;
+    std::uint64_t count_total;
+  };
+
+  /// Key of a child: id of the parent and the address.
+  struct ChildKey
+  {
+    std::uint32_t parent;
+    std::uintptr_t address;
+
+    bool operator==(const ChildKey& other) const noexcept
+    {
+      return parent == other.parent && address == other.address;
+    }
+  };
+
+  struct ChildKeyHash
+  {
+    std::size_t operator()(const ChildKey& key) const noexcept
+    {
+      return std::hash<std::uintptr_t>{}(key.address * 0x9E3779B97F4A7C15ULL ^ std::uintptr_t{ key.parent });
+    }
+  };
+
+  /// Marks a missing child or sibling.
+  constexpr static inline auto NO_NODE = std::uint32_t{ 0U };
+
+  /// Arena of all nodes.
+  std::vector<Node> _nodes{ Node{ 0U, 0U, NO_NODE, NO_NODE, NO_NODE, 0U, 0U } };
+
+  /// Children of all nodes.
+  std::unordered_map<ChildKey, std::uint32_t, ChildKeyHash> _children;
+
+  /// Number of added samples.
+  std::uint64_t _count_samples{ 0U };
+
+  /**
+   * Adds the sample (either perf::Sample or perf::SampleView) to the tree.
+   */
+  template<typename S>
+  void consume_sample(const S& sample);
+
+  /**
+   * Adds the call chain (innermost frame first) to the tree.
+   */
+  void add(std::uint32_t process_id, const std::uintptr_t* callchain, std::size_t size, std::uint64_t count);
+
+  /**
+   * @return Id of the child with the given address, created if not existing.
+   */
+  std::uint32_t child(std::uint32_t parent, std::uintptr_t address, std::uint32_t process_id);
+
+  /**
+   * Exports the tree as collapsed stacks, using the given function to translate nodes into frame names.
+   */
+  template<typename F>
+  [[nodiscard]] std::string to_collapsed_stacks(F&& frame_name) const;
+};
+}
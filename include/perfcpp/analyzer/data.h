@@ -1,12 +1,212 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <cstdint>
+#include <limits>
+#include <optional>
+#include <perfcpp/data_source.h>
+#include <perfcpp/numa_topology.h>
 #include <perfcpp/sample.h>
+#include <perfcpp/sample_batch.h>
+#include <perfcpp/sample_view.h>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace perf::analyzer {
+/**
+ * Aggregated statistics (number of loads and stores, their latency, and the data source of loads) of samples that
+ * were mapped to a member of a data type.
+ */
+class AccessStatistics
+{
+public:
+  /// Number of buckets of the latency histograms.
+  constexpr static inline auto COUNT_LATENCY_BUCKETS = std::size_t{ 18U };
+
+  /// Memory levels of the data source histogram.
+  enum class Level : std::uint8_t
+  {
+    L1,
+    LFB,
+    L2,
+    L3,
+    L4,
+    LocalRAM,
+    RemoteRAM,
+    Other
+  };
+
+  /// Number of memory levels of the data source histogram.
+  constexpr static inline auto COUNT_LEVELS = std::size_t{ 8U };
+
+  /**
+   * Histogram of latencies: Bucket 0 holds accesses with zero latency, bucket i (with i > 0) holds accesses with a
+   * latency in [2^(i-1), 2^i); the last bucket holds all higher latencies.
+   */
+  using LatencyHistogram = std::array<std::uint64_t, COUNT_LATENCY_BUCKETS>;
+
+  /// Histogram of memory levels the accesses were served from, indexed by Level.
+  using LevelHistogram = std::array<std::uint64_t, COUNT_LEVELS>;
+
+  AccessStatistics() noexcept = default;
+  ~AccessStatistics() noexcept = default;
+
+  /**
+   * Adds the given sample to the statistics.
+   *
+   * @param sample Sample (either perf::Sample or perf::SampleView) to add.
+   */
+  template<typename S>
+  void add(const S& sample) noexcept
+  {
+    ++_count_samples;
+
+    const auto weight = sample.weight();
+    const auto data_source = sample.data_src();
+    if (weight.has_value() && data_source.has_value()) {
+      const auto latency = std::uint64_t{ weight->cache_latency() };
+      const auto bucket = AccessStatistics::latency_bucket(latency);
+
+      if (data_source->is_load()) {
+        ++_count_loads;
+        _sum_load_latency += latency;
+        ++_load_latency_histogram[bucket];
+      }
+
+      if (data_source->is_store()) {
+        ++_count_stores;
+        _sum_store_latency += latency;
+        ++_store_latency_histogram[bucket];
+      }
+
+      ++_level_histogram[static_cast<std::size_t>(AccessStatistics::level(data_source.value()))];
+    }
+  }
+
+  /**
+   * Adds the statistics of another member (e.g., from a partial result).
+   *
+   * @param other Statistics to add.
+   * @return This statistics.
+   */
+  AccessStatistics& operator+=(const AccessStatistics& other) noexcept;
+
+  [[nodiscard]] std::uint64_t count_samples() const noexcept { return _count_samples; }
+  [[nodiscard]] std::uint64_t count_loads() const noexcept { return _count_loads; }
+  [[nodiscard]] std::uint64_t count_stores() const noexcept { return _count_stores; }
+  [[nodiscard]] std::uint64_t sum_load_latency() const noexcept { return _sum_load_latency; }
+  [[nodiscard]] std::uint64_t sum_store_latency() const noexcept { return _sum_store_latency; }
+  [[nodiscard]] std::uint64_t count_hits(const Level level) const noexcept
+  {
+    return _level_histogram[static_cast<std::size_t>(level)];
+  }
+  [[nodiscard]] std::uint64_t count_l1_hits() const noexcept { return count_hits(Level::L1); }
+  [[nodiscard]] std::uint64_t count_lfb_hits() const noexcept { return count_hits(Level::LFB); }
+  [[nodiscard]] std::uint64_t count_l2_hits() const noexcept { return count_hits(Level::L2); }
+  [[nodiscard]] std::uint64_t count_l3_hits() const noexcept { return count_hits(Level::L3); }
+  [[nodiscard]] std::uint64_t count_l4_hits() const noexcept { return count_hits(Level::L4); }
+  [[nodiscard]] std::uint64_t count_local_ram_hits() const noexcept { return count_hits(Level::LocalRAM); }
+  [[nodiscard]] std::uint64_t count_remote_ram_hits() const noexcept { return count_hits(Level::RemoteRAM); }
+  [[nodiscard]] const LatencyHistogram& load_latency_histogram() const noexcept { return _load_latency_histogram; }
+  [[nodiscard]] const LatencyHistogram& store_latency_histogram() const noexcept { return _store_latency_histogram; }
+  [[nodiscard]] const LevelHistogram& level_histogram() const noexcept { return _level_histogram; }
+
+  /**
+   * @return Average latency of loads, zero if no loads were sampled.
+   */
+  [[nodiscard]] std::uint64_t average_load_latency() const noexcept
+  {
+    return _count_loads > 0U ? _sum_load_latency / _count_loads : 0U;
+  }
+
+  /**
+   * @return Average latency of stores, zero if no stores were sampled.
+   */
+  [[nodiscard]] std::uint64_t average_store_latency() const noexcept
+  {
+    return _count_stores > 0U ? _sum_store_latency / _count_stores : 0U;
+  }
+
+  /**
+   * Approximates a percentile of the load latency from the histogram.
+   *
+   * @param percentile Percentile in [0, 1], e.g., 0.99.
+   * @return Lower bound of the latency bucket containing the percentile, zero if no loads were sampled.
+   */
+  [[nodiscard]] std::uint64_t load_latency_percentile(double percentile) const noexcept;
+
+  /**
+   * Translates a latency into the bucket of the latency histogram.
+   *
+   * @param latency Latency.
+   * @return Bucket of the latency.
+   */
+  [[nodiscard]] static std::size_t latency_bucket(const std::uint64_t latency) noexcept
+  {
+    if (latency == 0U) {
+      return 0U;
+    }
+
+    const auto bucket = std::size_t(64U - __builtin_clzll(latency));
+    return std::min(bucket, COUNT_LATENCY_BUCKETS - 1U);
+  }
+
+  /**
+   * @param bucket Bucket of the latency histogram.
+   * @return The smallest latency of the given bucket.
+   */
+  [[nodiscard]] static std::uint64_t latency_bucket_begin(const std::size_t bucket) noexcept
+  {
+    return bucket == 0U ? 0U : std::uint64_t{ 1U } << (bucket - 1U);
+  }
+
+  /**
+   * Translates the data source into the memory level an access was served from.
+   *
+   * @param data_source Data source of a sample.
+   * @return Memory level.
+   */
+  [[nodiscard]] static Level level(const DataSource data_source) noexcept
+  {
+    if (data_source.is_mem_l1()) {
+      return Level::L1;
+    }
+    if (data_source.is_mem_lfb()) {
+      return Level::LFB;
+    }
+    if (data_source.is_mem_l2()) {
+      return Level::L2;
+    }
+    if (data_source.is_mem_l3()) {
+      return Level::L3;
+    }
+    if (data_source.is_mem_l4()) {
+      return Level::L4;
+    }
+    if (data_source.is_mem_local_ram()) {
+      return Level::LocalRAM;
+    }
+    if (data_source.is_mem_remote_ram()) {
+      return Level::RemoteRAM;
+    }
+
+    return Level::Other;
+  }
+
+private:
+  std::uint64_t _count_samples{ 0U };
+  std::uint64_t _count_loads{ 0U };
+  std::uint64_t _count_stores{ 0U };
+  std::uint64_t _sum_load_latency{ 0U };
+  std::uint64_t _sum_store_latency{ 0U };
+  LatencyHistogram _load_latency_histogram{};
+  LatencyHistogram _store_latency_histogram{};
+  LevelHistogram _level_histogram{};
+};
+
 /**
  * The DataType projects a data object with members (attributes).
  */
@@ -29,13 +229,19 @@ public:
     [[nodiscard]] std::size_t size() const noexcept { return _size; }
     [[nodiscard]] const std::vector<Sample>& samples() const noexcept { return _samples; }
     [[nodiscard]] std::vector<Sample>& samples() noexcept { return _samples; }
+    [[nodiscard]] const AccessStatistics& statistics() const noexcept { return _statistics; }
+    [[nodiscard]] AccessStatistics& statistics() noexcept { return _statistics; }
 
   private:
     std::string _name;
     std::size_t _offset;
     std::size_t _size;
 
+    /// Samples mapped to this member (only if the analyzer is requested to keep samples).
     std::vector<Sample> _samples;
+
+    /// Statistics of all samples mapped to this member.
+    AccessStatistics _statistics;
   };
 
   DataType(std::string&& name, const std::size_t size)
@@ -158,12 +364,322 @@ public:
   }
   ~DataAnalyzerResult() = default;
 
+  /**
+   * @return List of all data types, enriched with the samples (or statistics) mapped to their members.
+   */
+  [[nodiscard]] const std::vector<DataType>& data_types() const noexcept { return _data_types; }
+
   [[nodiscard]] std::string to_string() const noexcept;
 
 private:
   std::vector<DataType> _data_types;
 };
 
+/**
+ * Result of the sharing analysis: Samples grouped by cache line (or page), reporting lines that were accessed by
+ * multiple threads or CPU cores and written by at least one of them (i.e., candidates for true and false sharing).
+ */
+class SharingAnalyzerResult
+{
+public:
+  /// Member of a data type that was sampled on a line.
+  class Member
+  {
+  public:
+    Member(std::string data_type_name, std::string name, const std::size_t offset, const std::size_t size) noexcept
+      : _data_type_name(std::move(data_type_name))
+      , _name(std::move(name))
+      , _offset(offset)
+      , _size(size)
+    {
+    }
+    ~Member() = default;
+
+    /**
+     * @return Name of the data type the member belongs to.
+     */
+    [[nodiscard]] const std::string& data_type_name() const noexcept { return _data_type_name; }
+
+    /**
+     * @return Name of the member.
+     */
+    [[nodiscard]] const std::string& name() const noexcept { return _name; }
+
+    /**
+     * @return Offset of the member within the data type.
+     */
+    [[nodiscard]] std::size_t offset() const noexcept { return _offset; }
+
+    /**
+     * @return Size of the member.
+     */
+    [[nodiscard]] std::size_t size() const noexcept { return _size; }
+
+    [[nodiscard]] std::uint64_t count_samples() const noexcept { return _count_samples; }
+    [[nodiscard]] std::uint64_t count_stores() const noexcept { return _count_stores; }
+    [[nodiscard]] std::uint64_t count_hitm() const noexcept { return _count_hitm; }
+
+    /**
+     * @return Ids of the threads that accessed the member.
+     */
+    [[nodiscard]] const std::vector<std::uint32_t>& thread_ids() const noexcept { return _thread_ids; }
+
+  private:
+    friend class DataAnalyzer;
+
+    std::string _data_type_name;
+    std::string _name;
+    std::size_t _offset;
+    std::size_t _size;
+    std::uint64_t _count_samples{ 0U };
+    std::uint64_t _count_stores{ 0U };
+    std::uint64_t _count_hitm{ 0U };
+    std::vector<std::uint32_t> _thread_ids;
+  };
+
+  /// Cache line (or page) that was accessed by multiple threads or CPU cores.
+  class Line
+  {
+  public:
+    Line(const std::uintptr_t begin, const std::size_t size) noexcept
+      : _begin(begin)
+      , _size(size)
+    {
+    }
+    ~Line() = default;
+
+    /**
+     * @return Address of the first byte of the line.
+     */
+    [[nodiscard]] std::uintptr_t begin() const noexcept { return _begin; }
+
+    /**
+     * @return Size of the line in bytes.
+     */
+    [[nodiscard]] std::size_t size() const noexcept { return _size; }
+
+    [[nodiscard]] std::uint64_t count_samples() const noexcept { return _count_samples; }
+    [[nodiscard]] std::uint64_t count_loads() const noexcept { return _count_loads; }
+    [[nodiscard]] std::uint64_t count_stores() const noexcept { return _count_stores; }
+
+    /**
+     * @return Number of accesses that hit a modified line in another core's cache.
+     */
+    [[nodiscard]] std::uint64_t count_hitm() const noexcept { return _count_hitm; }
+
+    /**
+     * @return Ids of the threads that accessed the line.
+     */
+    [[nodiscard]] const std::vector<std::uint32_t>& thread_ids() const noexcept { return _thread_ids; }
+
+    /**
+     * @return Ids of the CPU cores that accessed the line.
+     */
+    [[nodiscard]] const std::vector<std::uint32_t>& cpu_ids() const noexcept { return _cpu_ids; }
+
+    /**
+     * @return Annotated members that were sampled on the line.
+     */
+    [[nodiscard]] const std::vector<Member>& members() const noexcept { return _members; }
+
+    /**
+     * @return True, if the line was accessed by multiple threads or CPU cores and at least one access was a store or
+     * hit a modified line.
+     */
+    [[nodiscard]] bool is_shared() const noexcept
+    {
+      return (_thread_ids.size() > 1U || _cpu_ids.size() > 1U) && (_count_stores > 0U || _count_hitm > 0U);
+    }
+
+    /**
+     * @return True, if the line is shared and different members were accessed by different threads, i.e., the
+     * sharing can be resolved by placing the members on different lines.
+     */
+    [[nodiscard]] bool is_false_sharing() const noexcept;
+
+  private:
+    friend class DataAnalyzer;
+
+    std::uintptr_t _begin;
+    std::size_t _size;
+    std::uint64_t _count_samples{ 0U };
+    std::uint64_t _count_loads{ 0U };
+    std::uint64_t _count_stores{ 0U };
+    std::uint64_t _count_hitm{ 0U };
+    std::vector<std::uint32_t> _thread_ids;
+    std::vector<std::uint32_t> _cpu_ids;
+    std::vector<Member> _members;
+  };
+
+  explicit SharingAnalyzerResult(std::vector<Line>&& lines) noexcept
+    : _lines(std::move(lines))
+  {
+  }
+  ~SharingAnalyzerResult() = default;
+
+  /**
+   * @return Shared lines, ordered by the number of HITM accesses and stores (most contended first).
+   */
+  [[nodiscard]] const std::vector<Line>& lines() const noexcept { return _lines; }
+
+  [[nodiscard]] std::string to_string() const;
+
+private:
+  std::vector<Line> _lines;
+};
+
+/**
+ * Result of the NUMA analysis: memory samples broken down by the NUMA node of the accessing CPU and the NUMA node of
+ * the accessed memory, in total and per annotated data type.
+ */
+class NumaAnalyzerResult
+{
+public:
+  /// Accesses from the NUMA nodes of CPUs (rows) to the NUMA nodes of memory (columns).
+  class Traffic
+  {
+  public:
+    explicit Traffic(const std::uint16_t count_nodes)
+      : _count_nodes(count_nodes)
+      , _cells(std::size_t{ count_nodes } * count_nodes)
+    {
+    }
+    ~Traffic() = default;
+
+    /**
+     * @return Number of NUMA nodes (rows and columns of the matrix).
+     */
+    [[nodiscard]] std::uint16_t count_nodes() const noexcept { return _count_nodes; }
+
+    /**
+     * @param cpu_node NUMA node of the accessing CPU.
+     * @param memory_node NUMA node of the accessed memory.
+     * @return Number of samples from the CPU node to the memory node.
+     */
+    [[nodiscard]] std::uint64_t count_samples(const std::uint16_t cpu_node, const std::uint16_t memory_node) const
+    {
+      return _cells.at(index(cpu_node, memory_node)).count_samples;
+    }
+
+    /**
+     * @param cpu_node NUMA node of the accessing CPU.
+     * @param memory_node NUMA node of the accessed memory.
+     * @return Number of loads from the CPU node to the memory node.
+     */
+    [[nodiscard]] std::uint64_t count_loads(const std::uint16_t cpu_node, const std::uint16_t memory_node) const
+    {
+      return _cells.at(index(cpu_node, memory_node)).count_loads;
+    }
+
+    /**
+     * @param cpu_node NUMA node of the accessing CPU.
+     * @param memory_node NUMA node of the accessed memory.
+     * @return Average (cache) latency of loads from the CPU node to the memory node, std::nullopt if no load with a
+     * latency was sampled.
+     */
+    [[nodiscard]] std::optional<double> average_load_latency(std::uint16_t cpu_node, std::uint16_t memory_node) const;
+
+    /**
+     * @return Number of samples that accessed memory of the CPU's own node.
+     */
+    [[nodiscard]] std::uint64_t count_local() const noexcept;
+
+    /**
+     * @return Number of samples that accessed memory of another node.
+     */
+    [[nodiscard]] std::uint64_t count_remote() const noexcept;
+
+    [[nodiscard]] std::string to_string() const;
+
+  private:
+    friend class DataAnalyzer;
+
+    /// Accesses from one CPU node to one memory node.
+    struct Cell
+    {
+      std::uint64_t count_samples{ 0U };
+      std::uint64_t count_loads{ 0U };
+      std::uint64_t count_loads_with_latency{ 0U };
+      std::uint64_t sum_load_latency{ 0U };
+    };
+
+    [[nodiscard]] std::size_t index(const std::uint16_t cpu_node, const std::uint16_t memory_node) const noexcept
+    {
+      return std::size_t{ cpu_node } * _count_nodes + memory_node;
+    }
+
+    /**
+     * Adds the sample to the accesses from the CPU node to the memory node.
+     *
+     * @param cpu_node NUMA node of the accessing CPU.
+     * @param memory_node NUMA node of the accessed memory.
+     * @param sample Sample to add.
+     */
+    void add(std::uint16_t cpu_node, std::uint16_t memory_node, const Sample& sample);
+
+    std::uint16_t _count_nodes;
+    std::vector<Cell> _cells;
+  };
+
+  /// Traffic of the samples that were mapped to an annotated data type.
+  class DataTypeTraffic
+  {
+  public:
+    DataTypeTraffic(std::string name, const std::uint16_t count_nodes)
+      : _name(std::move(name))
+      , _traffic(count_nodes)
+    {
+    }
+    ~DataTypeTraffic() = default;
+
+    /**
+     * @return Name of the data type.
+     */
+    [[nodiscard]] const std::string& name() const noexcept { return _name; }
+
+    /**
+     * @return Accesses to instances of the data type.
+     */
+    [[nodiscard]] const Traffic& traffic() const noexcept { return _traffic; }
+
+  private:
+    friend class DataAnalyzer;
+
+    std::string _name;
+    Traffic _traffic;
+  };
+
+  NumaAnalyzerResult(Traffic&& total, std::vector<DataTypeTraffic>&& data_types, const std::uint64_t count_unresolved)
+    : _total(std::move(total))
+    , _data_types(std::move(data_types))
+    , _count_unresolved(count_unresolved)
+  {
+  }
+  ~NumaAnalyzerResult() = default;
+
+  /**
+   * @return Accesses of all resolved samples.
+   */
+  [[nodiscard]] const Traffic& total() const noexcept { return _total; }
+
+  /**
+   * @return Accesses per annotated data type, ordered by the number of remote accesses (most remote first).
+   */
+  [[nodiscard]] const std::vector<DataTypeTraffic>& data_types() const noexcept { return _data_types; }
+
+  /**
+   * @return Number of samples (with a memory address) whose CPU node or memory node could not be resolved.
+   */
+  [[nodiscard]] std::uint64_t count_unresolved() const noexcept { return _count_unresolved; }
+
+  [[nodiscard]] std::string to_string() const;
+
+private:
+  Traffic _total;
+  std::vector<DataTypeTraffic> _data_types;
+  std::uint64_t _count_unresolved;
+};
+
 class DataAnalyzer
 {
 public:
@@ -221,13 +737,184 @@ public:
 
   /**
    * Maps the given samples (with memory addresses) to data object earlier added to the analyzer.
+   * The samples are split into chunks that are mapped in parallel (using up to one thread per hardware thread).
    *
    * @param samples Samples to map.
-   * @return A list of all data types enriched with samples that map to members of the data type.
+   * @param is_keep_samples If true (default), every member keeps copies of the samples mapped to it; otherwise, only
+   * the statistics of the samples are aggregated, keeping memory consumption bounded.
+   * @return A list of all data types enriched with samples (or statistics) that map to members of the data type.
    */
-  DataAnalyzerResult map(const std::vector<Sample>& samples);
+  DataAnalyzerResult map(const std::vector<Sample>& samples, bool is_keep_samples = true);
+
+  /// Granularity of the sharing analysis.
+  enum class Granularity : std::uint8_t
+  {
+    /// Group samples by cache lines (of 64 bytes).
+    CacheLine,
+
+    /// Group samples by pages, using the sampled data page size (or the base page size, if not sampled).
+    Page
+  };
+
+  /**
+   * Groups the given samples (with memory addresses) by cache lines (or pages) and reports lines that were accessed
+   * by multiple threads or CPU cores with at least one store or HITM access (see DataSource::is_snoop_hit_modified()),
+   * together with the annotated members sampled on every line. Samples need the thread id and/or CPU id and,
+   * preferably, the data source.
+   *
+   * @param samples Samples to analyze.
+   * @param granularity Granularity of the lines; cache lines by default.
+   * @return Lines that were shared between threads or CPU cores.
+   */
+  [[nodiscard]] SharingAnalyzerResult map_lines(const std::vector<Sample>& samples,
+                                                Granularity granularity = Granularity::CacheLine) const;
+
+  /**
+   * Breaks the given samples (with memory addresses) down by the NUMA node of the CPU that accessed the memory and the
+   * NUMA node of the accessed memory, in total and per annotated data type. The CPU node is derived from the sampled
+   * CPU id; the memory node from the sampled physical address or, if not sampled, by looking up the page of the logical
+   * address in the (still running) process via move_pages(). Samples need the CPU id and, preferably, the data source
+   * and weight for load latencies.
+   *
+   * @param samples Samples to analyze.
+   * @param topology NUMA topology of the system.
+   * @return Accesses between the NUMA nodes.
+   */
+  [[nodiscard]] NumaAnalyzerResult map_numa(const std::vector<Sample>& samples,
+                                            const NumaTopology& topology = NumaTopology{}) const;
+
+  /**
+   * Maps a single sample to the data types and adds it to the statistics of the member, e.g., while draining the
+   * sampler. In contrast to map(), consumed samples are aggregated incrementally; the current result can be read at any
+   * time via result(). Data types and annotations can be added between consuming samples.
+   * Note that consuming is not thread-safe; samples of multiple threads have to be consumed by a single thread.
+   *
+   * @param sample Sample to consume.
+   */
+  void consume(const SampleView& sample) { consume_sample(sample); }
+
+  /**
+   * Maps a single sample to the data types and adds it to the statistics of the member (see consume(SampleView)).
+   *
+   * @param sample Sample to consume.
+   */
+  void consume(const Sample& sample) { consume_sample(sample); }
+
+  /**
+   * Maps all samples of the given batch to the data types and adds them to the statistics of the members (see
+   * consume(SampleView)).
+   *
+   * @param batch Batch of samples to consume.
+   */
+  void consume(const SampleBatch& batch);
+
+  /**
+   * Enables or disables keeping copies of consumed samples in the members. By default, only the statistics of
+   * consumed samples are kept, allowing to consume an unbounded number of samples with constant memory.
+   *
+   * @param is_keep_samples If true, consumed samples are copied into the member they are mapped to.
+   */
+  void keep_samples(const bool is_keep_samples) noexcept { _is_keep_consumed_samples = is_keep_samples; }
+
+  /**
+   * @return True, if consumed samples are copied into the member they are mapped to.
+   */
+  [[nodiscard]] bool is_keep_samples() const noexcept { return _is_keep_consumed_samples; }
+
+  /**
+   * @return The data types enriched with statistics (and samples, if kept) of all samples consumed since the last
+   * reset.
+   */
+  [[nodiscard]] DataAnalyzerResult result() const
+  {
+    return DataAnalyzerResult{ std::vector<DataType>{ _consumed_data_types } };
+  }
+
+  /**
+   * Discards the statistics and samples of all consumed samples.
+   */
+  void reset() { _consumed_data_types = _data_types; }
 
 private:
-  std::unordered_map<std::string, std::pair<DataType, std::vector<std::uintptr_t>>> _instances;
+  /// Minimal number of samples mapped by a single thread.
+  constexpr static inline auto MIN_SAMPLES_PER_THREAD = std::size_t{ 1U } << 16U;
+
+  /// Size of a cache line used by the sharing analysis.
+  constexpr static inline auto CACHE_LINE_SIZE = std::size_t{ 64U };
+
+  /**
+   * The Index maps memory addresses to members of annotated data types. Annotated instances (and arrays of instances)
+   * are stored as address ranges sorted by their begin; the member is identified by the offset of the address within
+   * the instance, using a table that maps every offset of the data type to the member located there.
+   * Finding the member of an address needs a binary search over the ranges; memory is proportional to the number of
+   * annotations and the size of the data types.
+   */
+  class Index
+  {
+  public:
+    /// Position of a member, i.e., the id of the data type and the id of the member within the data type.
+    using Position = std::pair<std::size_t, std::size_t>;
+
+    Index(const std::vector<DataType>& data_types,
+          const std::vector<std::vector<std::pair<std::uintptr_t, std::uint64_t>>>& annotations);
+    ~Index() = default;
+
+    /**
+     * Looks up the member at the given memory address.
+     *
+     * @param address Memory address.
+     * @return Data type id and member id, or std::nullopt if the address does not belong to any annotated member.
+     */
+    [[nodiscard]] std::optional<Position> find(std::uintptr_t address) const noexcept;
+
+  private:
+    /// Range of one or multiple (consecutive) instances of a data type.
+    struct Range
+    {
+      std::uintptr_t begin;
+      std::uintptr_t end;
+
+      /// Maximal end of this and all preceding ranges, to find ranges containing others.
+      std::uintptr_t max_end;
+
+      std::size_t data_type_id;
+      std::size_t data_type_size;
+    };
+
+    /// Marks offsets within a data type that do not belong to any member.
+    constexpr static inline auto NO_MEMBER = std::numeric_limits<std::uint32_t>::max();
+
+    /// Annotated ranges, sorted by begin.
+    std::vector<Range> _ranges;
+
+    /// Member id for every offset of every data type.
+    std::vector<std::vector<std::uint32_t>> _member_ids;
+  };
+
+  /// Registered data types.
+  std::vector<DataType> _data_types;
+
+  /// Ids of the data types by their name.
+  std::unordered_map<std::string, std::size_t> _data_type_ids;
+
+  /// Annotated instances (address and number of items) for every data type.
+  std::vector<std::vector<std::pair<std::uintptr_t, std::uint64_t>>> _annotations;
+
+  /// Data types enriched with consumed samples.
+  std::vector<DataType> _consumed_data_types;
+
+  /// Index for consuming samples; built on the first consumed sample after adding data types or annotations.
+  std::optional<Index> _consume_index;
+
+  /// Flag if consumed samples are copied into the members.
+  bool _is_keep_consumed_samples{ false };
+
+  /**
+   * Maps the sample to the data types and adds it to the consumed statistics.
+   *
+   * @param sample Sample (either perf::Sample or perf::SampleView) to consume.
+   */
+  template<typename S>
+  void consume_sample(const S& sample);
 };
 }
\ No newline at end of file
@@ -0,0 +1,288 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <perfcpp/sample.h>
+#include <perfcpp/sample_view.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace perf::analyzer {
+/**
+ * The PageHeatmap aggregates memory samples per page (using the sampled data page size, i.e., 4 KB, 2 MB, or 1 GB
+ * pages) into a decaying histogram of accesses, loads, stores, and load latency, e.g., to decide which pages should be
+ * placed in fast (DRAM) or slow (CXL) memory. Samples are consumed while draining the sampler and grouped into time
+ * windows (using the timestamp of the samples); whenever a window is closed, all values are multiplied by the decay
+ * factor, such that the heat of a page reflects recent windows more than older ones.
+ * Memory is bounded: pages whose heat decays below a threshold are dropped when closing a window and, if the
+ * maximal number of pages is reached, the coldest half of the pages is evicted.
+ * The PageHeatmap is not thread-safe.
+ */
+class PageHeatmap
+{
+public:
+  /// Address of the samples used to identify pages.
+  enum class AddressType : std::uint8_t
+  {
+    /// Logical (virtual) memory address of the sampled process (needs Sampler::Values::logical_memory_address()).
+    Logical,
+
+    /// Physical memory address (needs Sampler::Values::physical_memory_address()).
+    Physical
+  };
+
+  /// Range of (adjacent) pages with their aggregated values.
+  class Range
+  {
+  public:
+    Range(const std::uintptr_t begin,
+          const std::uintptr_t end,
+          const std::uint64_t count_pages,
+          const double heat,
+          const double loads,
+          const double stores,
+          const double sum_load_latency,
+          const double count_loads_with_latency,
+          const std::uint64_t count_window_samples) noexcept
+      : _begin(begin)
+      , _end(end)
+      , _count_pages(count_pages)
+      , _heat(heat)
+      , _loads(loads)
+      , _stores(stores)
+      , _sum_load_latency(sum_load_latency)
+      , _count_loads_with_latency(count_loads_with_latency)
+      , _count_window_samples(count_window_samples)
+    {
+    }
+    ~Range() = default;
+
+    /**
+     * @return Address of the first byte of the range.
+     */
+    [[nodiscard]] std::uintptr_t begin() const noexcept { return _begin; }
+
+    /**
+     * @return Address of the first byte after the range.
+     */
+    [[nodiscard]] std::uintptr_t end() const noexcept { return _end; }
+
+    /**
+     * @return Size of the range in bytes.
+     */
+    [[nodiscard]] std::uint64_t size() const noexcept { return _end - _begin; }
+
+    /**
+     * @return Number of pages in the range.
+     */
+    [[nodiscard]] std::uint64_t count_pages() const noexcept { return _count_pages; }
+
+    /**
+     * @return Decayed number of samples (samples of the current window count fully, samples of older windows are
+     * weighted by the decay factor per window).
+     */
+    [[nodiscard]] double heat() const noexcept { return _heat; }
+
+    /**
+     * @return Decayed number of sampled loads.
+     */
+    [[nodiscard]] double loads() const noexcept { return _loads; }
+
+    /**
+     * @return Decayed number of sampled stores.
+     */
+    [[nodiscard]] double stores() const noexcept { return _stores; }
+
+    /**
+     * @return Share of stores among the sampled loads and stores, std::nullopt if neither was sampled.
+     */
+    [[nodiscard]] std::optional<double> write_ratio() const noexcept
+    {
+      if (_loads + _stores > 0.0) {
+        return _stores / (_loads + _stores);
+      }
+
+      return std::nullopt;
+    }
+
+    /**
+     * @return Average (cache) latency of the sampled loads, std::nullopt if no load with a latency was sampled.
+     */
+    [[nodiscard]] std::optional<double> average_load_latency() const noexcept
+    {
+      if (_count_loads_with_latency > 0.0) {
+        return _sum_load_latency / _count_loads_with_latency;
+      }
+
+      return std::nullopt;
+    }
+
+    /**
+     * @return Number of samples in the current window.
+     */
+    [[nodiscard]] std::uint64_t count_window_samples() const noexcept { return _count_window_samples; }
+
+  private:
+    std::uintptr_t _begin;
+    std::uintptr_t _end;
+    std::uint64_t _count_pages;
+    double _heat;
+    double _loads;
+    double _stores;
+    double _sum_load_latency;
+    double _count_loads_with_latency;
+    std::uint64_t _count_window_samples;
+  };
+
+  /**
+   * Creates a PageHeatmap.
+   *
+   * @param window Length of a time window in nanoseconds (of the sample timestamps); 0 disables closing windows by
+   * time, windows are then only closed via close_window().
+   * @param decay Factor all values are multiplied with when a window is closed (between 0 and 1).
+   * @param max_pages Maximal number of pages kept in the heatmap.
+   * @param address_type Address used to identify pages.
+   */
+  explicit PageHeatmap(std::uint64_t window = 1000000000ULL,
+                       double decay = 0.5,
+                       std::size_t max_pages = std::size_t{ 1U } << 16U,
+                       AddressType address_type = AddressType::Logical);
+  ~PageHeatmap() = default;
+
+  /**
+   * Adds the given sample (directly from the buffer, e.g., while draining the sampler) to the page of its address.
+   * Windows that ended before the timestamp of the sample are closed first.
+   *
+   * @param sample Sample to add.
+   */
+  void consume(const SampleView& sample) { consume_sample(sample); }
+
+  /**
+   * Adds the given sample to the page of its address (see consume(SampleView)).
+   *
+   * @param sample Sample to add.
+   */
+  void consume(const Sample& sample) { consume_sample(sample); }
+
+  /**
+   * Closes the current window, i.e., multiplies the values of all pages with the decay factor and drops pages that
+   * became cold.
+   */
+  void close_window() { close_windows(1U); }
+
+  /**
+   * @return Number of consumed samples with an address.
+   */
+  [[nodiscard]] std::uint64_t count_samples() const noexcept { return _count_samples; }
+
+  /**
+   * @return Number of closed windows.
+   */
+  [[nodiscard]] std::uint64_t count_windows() const noexcept { return _count_windows; }
+
+  /**
+   * @return Number of pages currently kept in the heatmap.
+   */
+  [[nodiscard]] std::size_t count_pages() const noexcept { return _pages.size(); }
+
+  /**
+   * @return Number of pages that were evicted because the maximal number of pages was reached.
+   */
+  [[nodiscard]] std::uint64_t count_evicted_pages() const noexcept { return _count_evicted_pages; }
+
+  /**
+   * Lists the hottest pages; adjacent pages are merged into a single range.
+   *
+   * @param count Number of pages.
+   * @return Ranges covering the (up to) count hottest pages, ordered by the average heat per page (hottest first).
+   */
+  [[nodiscard]] std::vector<Range> hot(std::size_t count = 16U) const { return ranges(count, true); }
+
+  /**
+   * Lists the coldest pages that are kept in the heatmap (pages that were never sampled, or were dropped, are not
+   * known to the heatmap); adjacent pages are merged into a single range.
+   *
+   * @param count Number of pages.
+   * @return Ranges covering the (up to) count coldest pages, ordered by the average heat per page (coldest first).
+   */
+  [[nodiscard]] std::vector<Range> cold(std::size_t count = 16U) const { return ranges(count, false); }
+
+  /**
+   * Formats the hottest and coldest ranges as a table.
+   *
+   * @param count Number of hot and cold pages.
+   * @return Table of hot and cold ranges.
+   */
+  [[nodiscard]] std::string to_string(std::size_t count = 16U) const;
+
+private:
+  /// Pages whose heat decays below this value are dropped when closing a window.
+  constexpr static inline auto MIN_HEAT = 1.0 / 64.0;
+
+  /// Values aggregated per page.
+  struct Page
+  {
+    std::uint64_t size{ 0U };
+    double heat{ 0.0 };
+    double loads{ 0.0 };
+    double stores{ 0.0 };
+    double sum_load_latency{ 0.0 };
+    double count_loads_with_latency{ 0.0 };
+    std::uint64_t count_window_samples{ 0U };
+  };
+
+  /// Length of a window in nanoseconds (0 = windows are closed manually).
+  std::uint64_t _window;
+
+  /// Factor the values are multiplied with when closing a window.
+  double _decay;
+
+  std::size_t _max_pages;
+  AddressType _address_type;
+
+  /// Page size of samples without sampled data page size.
+  std::uint64_t _base_page_size;
+
+  /// Timestamp where the current window started; set with the first sample carrying a timestamp.
+  std::optional<std::uint64_t> _window_begin{ std::nullopt };
+
+  std::uint64_t _count_samples{ 0U };
+  std::uint64_t _count_windows{ 0U };
+  std::uint64_t _count_evicted_pages{ 0U };
+
+  /// Pages by their first address.
+  std::unordered_map<std::uintptr_t, Page> _pages;
+
+  template<typename S>
+  void consume_sample(const S& sample);
+
+  /**
+   * Closes all windows that ended before the given timestamp.
+   *
+   * @param time Timestamp of the current sample.
+   */
+  void advance(std::uint64_t time);
+
+  /**
+   * Closes the given number of windows, i.e., decays all values once by the decay factor per window.
+   *
+   * @param count Number of windows to close.
+   */
+  void close_windows(std::uint64_t count);
+
+  /**
+   * Evicts the coldest half of the pages.
+   */
+  void evict();
+
+  /**
+   * Selects the hottest (or coldest) pages and merges adjacent pages into ranges.
+   *
+   * @param count Number of pages.
+   * @param is_hot True, if the hottest pages should be selected; otherwise, the coldest.
+   * @return Ranges of the selected pages.
+   */
+  [[nodiscard]] std::vector<Range> ranges(std::size_t count, bool is_hot) const;
+};
+}
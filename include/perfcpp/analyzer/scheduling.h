@@ -0,0 +1,316 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <perfcpp/sample.h>
+#include <perfcpp/sample_view.h>
+#include <perfcpp/symbolizer.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace perf::analyzer {
+/**
+ * The SchedulingAnalyzer turns context switches (see Sampler::Values::context_switch()) into a scheduling timeline
+ * per thread: Switch-outs and the following switch-ins of the same thread are paired into on-CPU and off-CPU
+ * intervals. Off-CPU intervals that follow a preemption are counted as runqueue wait (the thread was runnable, but not
+ * running), the others as blocked (e.g., waiting for I/O or a lock). Every off-CPU interval is attributed to the last
+ * callchain (or instruction pointer) sampled on the thread before it was switched out.
+ * Samples are consumed incrementally (e.g., while draining the sampler); every thread occupies constant memory: the
+ * durations are aggregated in logarithmic histograms and only the callchains with the most off-CPU time are kept (see
+ * MAX_STACKS_PER_THREAD). The SchedulingAnalyzer is not thread-safe.
+ */
+class SchedulingAnalyzer
+{
+public:
+  /// Maximal number of off-CPU callchains kept per thread.
+  constexpr static inline auto MAX_STACKS_PER_THREAD = std::size_t{ 8U };
+
+  /// Maximal depth of the callchains kept per thread.
+  constexpr static inline auto MAX_CALLCHAIN_DEPTH = std::size_t{ 32U };
+
+  /// Histogram of durations with one bucket per power of two nanoseconds.
+  class Histogram
+  {
+  public:
+    /**
+     * Adds a duration to the histogram.
+     *
+     * @param duration Duration in nanoseconds.
+     */
+    void add(std::uint64_t duration) noexcept;
+
+    /**
+     * @return Number of durations.
+     */
+    [[nodiscard]] std::uint64_t count() const noexcept { return _count; }
+
+    /**
+     * @return Sum of all durations in nanoseconds.
+     */
+    [[nodiscard]] std::uint64_t sum() const noexcept { return _sum; }
+
+    /**
+     * @return Longest duration in nanoseconds.
+     */
+    [[nodiscard]] std::uint64_t max() const noexcept { return _max; }
+
+    /**
+     * @param bucket Id of the bucket.
+     * @return Number of durations in [2^(bucket-1), 2^bucket) nanoseconds (bucket 0 holds durations of 0ns).
+     */
+    [[nodiscard]] std::uint64_t count(const std::size_t bucket) const noexcept
+    {
+      return bucket < _buckets.size() ? _buckets[bucket] : 0U;
+    }
+
+    /**
+     * @return Number of buckets.
+     */
+    [[nodiscard]] static constexpr std::size_t size() noexcept { return 65U; }
+
+    /**
+     * Estimates the given percentile by the upper bound of the bucket holding it (exact for the maximum).
+     *
+     * @param percentile Percentile between 0 and 1 (e.g., 0.99).
+     * @return Estimated duration of the percentile in nanoseconds.
+     */
+    [[nodiscard]] std::uint64_t percentile(double percentile) const noexcept;
+
+  private:
+    std::array<std::uint64_t, 65U> _buckets{};
+    std::uint64_t _count{ 0U };
+    std::uint64_t _sum{ 0U };
+    std::uint64_t _max{ 0U };
+  };
+
+  /// Callchain with the off-CPU time attributed to it.
+  class Stack
+  {
+  public:
+    /**
+     * @return Callchain (or instruction pointer) sampled before the thread was switched out, most recent call first.
+     */
+    [[nodiscard]] const std::vector<std::uintptr_t>& callchain() const noexcept { return _callchain; }
+
+    /**
+     * @return Off-CPU time in nanoseconds; may be overestimated if other callchains were displaced, since a new
+     * callchain takes over the time of the displaced one (space-saving).
+     */
+    [[nodiscard]] std::uint64_t off_cpu_time() const noexcept { return _off_cpu_time; }
+
+    /**
+     * @return Number of off-CPU intervals.
+     */
+    [[nodiscard]] std::uint64_t count() const noexcept { return _count; }
+
+  private:
+    friend SchedulingAnalyzer;
+
+    std::vector<std::uintptr_t> _callchain;
+    std::uint64_t _hash{ 0U };
+    std::uint64_t _off_cpu_time{ 0U };
+    std::uint64_t _count{ 0U };
+  };
+
+  /// Scheduling statistics of a single thread.
+  class Thread
+  {
+  public:
+    /**
+     * @return Id of the thread.
+     */
+    [[nodiscard]] std::uint32_t thread_id() const noexcept { return _thread_id; }
+
+    /**
+     * @return Id of the process.
+     */
+    [[nodiscard]] std::uint32_t process_id() const noexcept { return _process_id; }
+
+    /**
+     * @return Durations the thread was running (from switch-in to switch-out).
+     */
+    [[nodiscard]] const Histogram& on_cpu() const noexcept { return _on_cpu; }
+
+    /**
+     * @return Durations the thread waited in the runqueue after being preempted (from switch-out to switch-in).
+     */
+    [[nodiscard]] const Histogram& runqueue() const noexcept { return _runqueue; }
+
+    /**
+     * @return Durations the thread was blocked after switching out voluntarily (from switch-out to switch-in).
+     */
+    [[nodiscard]] const Histogram& blocked() const noexcept { return _blocked; }
+
+    /**
+     * @return Total time on CPU in nanoseconds.
+     */
+    [[nodiscard]] std::uint64_t on_cpu_time() const noexcept { return _on_cpu.sum(); }
+
+    /**
+     * @return Total time off CPU (runqueue wait and blocked) in nanoseconds.
+     */
+    [[nodiscard]] std::uint64_t off_cpu_time() const noexcept { return _runqueue.sum() + _blocked.sum(); }
+
+    /**
+     * @return Number of switch-outs.
+     */
+    [[nodiscard]] std::uint64_t count_switches() const noexcept { return _count_switches; }
+
+    /**
+     * @return Number of switch-outs due to preemption (involuntary context switches).
+     */
+    [[nodiscard]] std::uint64_t count_preemptions() const noexcept { return _count_preemptions; }
+
+    /**
+     * @return Number of switch-ins on a different CPU than the preceding switch-out.
+     */
+    [[nodiscard]] std::uint64_t count_migrations() const noexcept { return _count_migrations; }
+
+    /**
+     * @return Longest off-CPU interval in nanoseconds.
+     */
+    [[nodiscard]] std::uint64_t longest_off_cpu_time() const noexcept { return _longest_off_cpu_time; }
+
+    /**
+     * @return Timestamp of the switch-out that started the longest off-CPU interval.
+     */
+    [[nodiscard]] std::uint64_t longest_off_cpu_begin() const noexcept { return _longest_off_cpu_begin; }
+
+    /**
+     * @return Callchain sampled before the longest off-CPU interval (empty if none was sampled).
+     */
+    [[nodiscard]] const std::vector<std::uintptr_t>& longest_off_cpu_callchain() const noexcept
+    {
+      return _longest_off_cpu_callchain;
+    }
+
+    /**
+     * @return Callchains with the most off-CPU time, ordered by the off-CPU time (longest first).
+     */
+    [[nodiscard]] std::vector<Stack> off_cpu_stacks() const;
+
+  private:
+    friend SchedulingAnalyzer;
+
+    std::uint32_t _thread_id{ 0U };
+    std::uint32_t _process_id{ 0U };
+    Histogram _on_cpu;
+    Histogram _runqueue;
+    Histogram _blocked;
+    std::uint64_t _count_switches{ 0U };
+    std::uint64_t _count_preemptions{ 0U };
+    std::uint64_t _count_migrations{ 0U };
+
+    /// State of the last context switch.
+    bool _is_on_cpu{ false };
+    bool _is_preempted{ false };
+    std::optional<std::uint64_t> _last_switch_time{ std::nullopt };
+    std::optional<std::uint32_t> _last_switch_cpu_id{ std::nullopt };
+
+    /// Last sampled callchain and its hash.
+    std::vector<std::uintptr_t> _callchain;
+    std::uint64_t _callchain_hash{ 0U };
+
+    std::uint64_t _longest_off_cpu_time{ 0U };
+    std::uint64_t _longest_off_cpu_begin{ 0U };
+    std::vector<std::uintptr_t> _longest_off_cpu_callchain;
+
+    /// Callchains with the most off-CPU time (at most MAX_STACKS_PER_THREAD).
+    std::vector<Stack> _stacks;
+  };
+
+  SchedulingAnalyzer() = default;
+  ~SchedulingAnalyzer() = default;
+
+  /**
+   * Consumes a sample: context switches are paired into on-CPU and off-CPU intervals (needs the thread id and the
+   * timestamp, see Sampler::Values::thread_id() and Sampler::Values::time()); other samples update the last
+   * callchain of their thread.
+   *
+   * @param sample Sample to consume.
+   */
+  void consume(const Sample& sample);
+
+  /**
+   * Consumes a sample directly from the buffer (e.g., within Sampler::drain()) to update the last callchain of its
+   * thread. Note that context switches are only decoded into perf::Sample objects.
+   *
+   * @param sample Sample to consume.
+   */
+  void consume(const SampleView& sample);
+
+  /**
+   * Consumes a list of samples (see consume(const Sample&)).
+   *
+   * @param samples Samples to consume.
+   */
+  void consume(const std::vector<Sample>& samples)
+  {
+    for (const auto& sample : samples) {
+      consume(sample);
+    }
+  }
+
+  /**
+   * @return Number of consumed context switches.
+   */
+  [[nodiscard]] std::uint64_t count_context_switches() const noexcept { return _count_context_switches; }
+
+  /**
+   * @return Number of threads.
+   */
+  [[nodiscard]] std::size_t count_threads() const noexcept { return _threads.size(); }
+
+  /**
+   * @param thread_id Id of the thread.
+   * @return Statistics of the given thread, nullptr if no context switch of the thread was consumed.
+   */
+  [[nodiscard]] const Thread* thread(std::uint32_t thread_id) const noexcept;
+
+  /**
+   * @param count Number of threads.
+   * @return The (up to) count threads with the most off-CPU time, longest first.
+   */
+  [[nodiscard]] std::vector<Thread> threads(std::size_t count = std::numeric_limits<std::size_t>::max()) const;
+
+  /**
+   * Formats the threads with the most off-CPU time and their top off-CPU callchain as a table.
+   *
+   * @param count Number of threads.
+   * @param symbolizer Symbolizer to resolve the callchains to functions; may be nullptr.
+   * @return Table of threads.
+   */
+  [[nodiscard]] std::string to_string(std::size_t count = 16U, Symbolizer* symbolizer = nullptr) const;
+
+private:
+  std::uint64_t _count_context_switches{ 0U };
+  std::unordered_map<std::uint32_t, Thread> _threads;
+
+  /**
+   * Replaces the last callchain of the thread.
+   *
+   * @param thread_id Id of the thread.
+   * @param process_id Id of the process.
+   * @param callchain Callchain (may contain context markers).
+   * @param size Number of entries of the callchain.
+   * @param instruction_pointer Instruction pointer, used if the callchain is empty.
+   */
+  template<typename A>
+  void update_callchain(std::uint32_t thread_id,
+                        std::uint32_t process_id,
+                        const A* callchain,
+                        std::size_t size,
+                        std::optional<std::uintptr_t> instruction_pointer);
+
+  /**
+   * Attributes an off-CPU interval to the last callchain of the thread.
+   *
+   * @param thread Thread that was off CPU.
+   * @param duration Duration of the interval in nanoseconds.
+   */
+  static void attribute(Thread& thread, std::uint64_t duration);
+};
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "sample.h"
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace perf {
+/**
+ * Decodes the packets written by the Arm Statistical Profiling Extension (SPE) into the AUX area into perf::Sample
+ * objects: Every SPE record (a sequence of packets terminated by an END or TIMESTAMP packet) becomes one sample with
+ * the instruction pointer, the virtual and physical data address, the latencies (see perf::Weight), and the data
+ * source (see perf::DataSource). The decoder is streaming: Packets and records may be split across calls to feed(),
+ * e.g., when the AUX area wraps around or is drained while recording.
+ */
+class ArmSpeDecoder
+{
+public:
+  ArmSpeDecoder() = default;
+  ~ArmSpeDecoder() = default;
+
+  /**
+   * Decodes the given chunk of SPE packets. Incomplete packets and records are kept until the next chunk is fed.
+   *
+   * @param data Chunk of SPE packets (e.g., from perf::Sampler::drain_aux()).
+   * @param size Size of the chunk in bytes.
+   */
+  void feed(const std::uint8_t* data, std::size_t size);
+
+  /**
+   * @return Samples decoded from all complete records since the last call to take().
+   */
+  [[nodiscard]] std::vector<Sample> take() noexcept { return std::exchange(_samples, std::vector<Sample>{}); }
+
+  /**
+   * Drops incomplete packets and records, e.g., when the next chunk does not continue the previous one (snapshots).
+   */
+  void reset() noexcept
+  {
+    _pending_packet.clear();
+    _record = Record{};
+  }
+
+private:
+  /// Packet headers (see "Arm Architecture Reference Manual", chapter "Statistical Profiling Extension").
+  constexpr static inline auto PAD_HEADER = std::uint8_t{ 0x00U };
+  constexpr static inline auto END_HEADER = std::uint8_t{ 0x01U };
+  constexpr static inline auto TIMESTAMP_HEADER = std::uint8_t{ 0x71U };
+  constexpr static inline auto EXTENDED_HEADER = std::uint8_t{ 0x20U };
+
+  /// Values of a record decoded so far.
+  struct Record
+  {
+    std::optional<std::uint64_t> instruction_pointer{ std::nullopt };
+    Sample::Mode mode{ Sample::Mode::Unknown };
+    std::optional<std::uint64_t> virtual_address{ std::nullopt };
+    std::optional<std::uint64_t> physical_address{ std::nullopt };
+    std::uint16_t total_latency{ 0U };
+    std::uint16_t issue_latency{ 0U };
+    std::uint16_t translation_latency{ 0U };
+    bool is_latency{ false };
+    std::uint64_t events{ 0U };
+    std::optional<std::uint16_t> data_source{ std::nullopt };
+    bool is_load_store{ false };
+    bool is_store{ false };
+    std::optional<std::uint64_t> timestamp{ std::nullopt };
+  };
+
+  /// Bytes of a packet that was split across two chunks.
+  std::vector<std::uint8_t> _pending_packet;
+
+  /// Record that is currently decoded.
+  Record _record;
+
+  /// Samples decoded from complete records.
+  std::vector<Sample> _samples;
+
+  /**
+   * Determines the size of the packet starting at the given data.
+   *
+   * @param data Begin of the packet.
+   * @param size Number of available bytes.
+   * @return Size of the packet (header and payload), std::nullopt if the header is incomplete.
+   */
+  [[nodiscard]] static std::optional<std::size_t> packet_size(const std::uint8_t* data, std::size_t size) noexcept;
+
+  /**
+   * Decodes a single (complete) packet into the current record; finishes the record on END and TIMESTAMP packets.
+   *
+   * @param packet Begin of the packet.
+   * @param size Size of the packet.
+   */
+  void decode(const std::uint8_t* packet, std::size_t size);
+
+  /**
+   * Translates the current record into a sample (if it carries an instruction pointer) and starts a new record.
+   */
+  void finish_record();
+
+  /**
+   * Translates the data source and the events of a load or store into the encoding of perf_mem_data_src.
+   *
+   * @param record Decoded record.
+   * @return Data source of the record.
+   */
+  [[nodiscard]] static DataSource data_source(const Record& record) noexcept;
+};
+}
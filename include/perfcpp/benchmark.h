@@ -0,0 +1,355 @@
+#pragma once
+
+#include "config.h"
+#include "counter.h"
+#include "counter_definition.h"
+#include "event_counter.h"
+#include <cstdint>
+#include <optional>
+#include <sched.h>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace perf {
+class BenchmarkConfig
+{
+public:
+  BenchmarkConfig() noexcept = default;
+  ~BenchmarkConfig() noexcept = default;
+  BenchmarkConfig(const BenchmarkConfig&) noexcept = default;
+  BenchmarkConfig& operator=(const BenchmarkConfig&) noexcept = default;
+
+  [[nodiscard]] std::uint32_t warmup_repetitions() const noexcept { return _warmup_repetitions; }
+  [[nodiscard]] std::uint32_t repetitions() const noexcept { return _repetitions; }
+  [[nodiscard]] std::uint64_t iterations() const noexcept { return _iterations; }
+  [[nodiscard]] std::optional<std::uint16_t> cpu_id() const noexcept { return _cpu_id; }
+  [[nodiscard]] double outlier_threshold() const noexcept { return _outlier_threshold; }
+
+  /**
+   * Specify the number of repetitions that are executed (with counters enabled) before measuring, e.g., to warm up
+   * caches and branch predictors.
+   *
+   * @param warmup_repetitions Number of unrecorded repetitions.
+   */
+  void warmup_repetitions(const std::uint32_t warmup_repetitions) noexcept
+  {
+    _warmup_repetitions = warmup_repetitions;
+  }
+
+  /**
+   * Specify the number of measured repetitions; every repetition enables the counters once.
+   *
+   * @param repetitions Number of measured repetitions.
+   */
+  void repetitions(const std::uint32_t repetitions) noexcept { _repetitions = repetitions; }
+
+  /**
+   * Specify the number of times the workload is executed per repetition. Results are normalized to a single
+   * iteration.
+   *
+   * @param iterations Number of iterations per repetition.
+   */
+  void iterations(const std::uint64_t iterations) noexcept { _iterations = iterations; }
+
+  /**
+   * Pins the benchmarking thread to the given CPU while running the benchmark.
+   *
+   * @param cpu_id Id of the CPU.
+   */
+  void cpu_id(const std::uint16_t cpu_id) noexcept { _cpu_id = cpu_id; }
+
+  /**
+   * Specify the threshold for rejecting outliers, as a multiple of the interquartile range: Values of a counter below
+   * the first quartile or above the third quartile by more than threshold * IQR are excluded from the statistics of
+   * that counter.
+   *
+   * @param outlier_threshold Multiple of the interquartile range; 0 keeps all values.
+   */
+  void outlier_threshold(const double outlier_threshold) noexcept { _outlier_threshold = outlier_threshold; }
+
+private:
+  std::uint32_t _warmup_repetitions{ 3U };
+  std::uint32_t _repetitions{ 30U };
+  std::uint64_t _iterations{ 1U };
+  std::optional<std::uint16_t> _cpu_id{ std::nullopt };
+  double _outlier_threshold{ 1.5 };
+};
+
+/**
+ * Statistics over all repetitions of a benchmark, per counter and metric (normalized to a single iteration).
+ * Every statistic is provided as a CounterResult, which can be printed via to_json(), to_csv(), or to_string().
+ */
+class BenchmarkResult
+{
+public:
+  /**
+   * Computes the statistics of the given repetitions.
+   *
+   * @param repetitions Results of all repetitions, listing the same counters and metrics in the same order.
+   * @param outlier_threshold Multiple of the interquartile range to reject outliers (see BenchmarkConfig).
+   */
+  BenchmarkResult(std::vector<CounterResult>&& repetitions, double outlier_threshold);
+  ~BenchmarkResult() = default;
+
+  /**
+   * @return Results of all measured repetitions, including outliers.
+   */
+  [[nodiscard]] const std::vector<CounterResult>& repetitions() const noexcept { return _repetitions; }
+
+  /**
+   * @return Arithmetic mean of every counter and metric.
+   */
+  [[nodiscard]] CounterResult mean() const { return statistic(&Statistics::mean); }
+
+  /**
+   * @return Median of every counter and metric.
+   */
+  [[nodiscard]] CounterResult median() const { return statistic(&Statistics::median); }
+
+  /**
+   * @return Minimum of every counter and metric.
+   */
+  [[nodiscard]] CounterResult min() const { return statistic(&Statistics::min); }
+
+  /**
+   * @return Maximum of every counter and metric.
+   */
+  [[nodiscard]] CounterResult max() const { return statistic(&Statistics::max); }
+
+  /**
+   * @return Sample variance of every counter and metric.
+   */
+  [[nodiscard]] CounterResult variance() const { return statistic(&Statistics::variance); }
+
+  /**
+   * @return Sample standard deviation of every counter and metric.
+   */
+  [[nodiscard]] CounterResult standard_deviation() const { return statistic(&Statistics::standard_deviation); }
+
+  /**
+   * @return Lower bound of the 95% confidence interval of the mean of every counter and metric.
+   */
+  [[nodiscard]] CounterResult confidence_interval_lower() const
+  {
+    return statistic(&Statistics::confidence_interval_lower);
+  }
+
+  /**
+   * @return Upper bound of the 95% confidence interval of the mean of every counter and metric.
+   */
+  [[nodiscard]] CounterResult confidence_interval_upper() const
+  {
+    return statistic(&Statistics::confidence_interval_upper);
+  }
+
+  /**
+   * @return Number of repetitions rejected as outliers, per counter and metric.
+   */
+  [[nodiscard]] CounterResult outliers() const { return statistic(&Statistics::outliers); }
+
+  /**
+   * Converts the statistics into JSON format: One object per statistic, each formatted by CounterResult::to_json().
+   *
+   * @return Statistics in JSON format.
+   */
+  [[nodiscard]] std::string to_json() const;
+
+  /**
+   * Converts the statistics into CSV format with the columns statistic, counter, and value; the rows of every
+   * statistic are formatted by CounterResult::to_csv().
+   *
+   * @param delimiter Char to separate columns (',' by default).
+   * @param print_header If true, the header will be printed first (true by default).
+   * @return Statistics in CSV format.
+   */
+  [[nodiscard]] std::string to_csv(char delimiter = ',', bool print_header = true) const;
+
+private:
+  struct Statistics
+  {
+    double mean;
+    double median;
+    double min;
+    double max;
+    double variance;
+    double standard_deviation;
+    double confidence_interval_lower;
+    double confidence_interval_upper;
+    double outliers;
+  };
+
+  std::vector<CounterResult> _repetitions;
+
+  /// Statistics per counter and metric, in the order of the results.
+  std::vector<std::pair<std::string_view, Statistics>> _statistics;
+
+  [[nodiscard]] CounterResult statistic(double Statistics::* member) const;
+
+  /// Statistics and their names, in the order printed by to_json() and to_csv().
+  [[nodiscard]] std::vector<std::pair<std::string_view, CounterResult>> statistics() const;
+
+  /**
+   * Computes the statistics of the given values, rejecting outliers.
+   *
+   * @param values Values of a single counter (will be sorted).
+   * @param outlier_threshold Multiple of the interquartile range to reject outliers.
+   * @return Statistics of the values.
+   */
+  [[nodiscard]] static Statistics compute(std::vector<double>& values, double outlier_threshold);
+
+  /**
+   * @param sorted_values Sorted list of values.
+   * @param quantile Quantile in [0, 1].
+   * @return The quantile of the values, interpolating linearly between neighboring values.
+   */
+  [[nodiscard]] static double quantile(const std::vector<double>& sorted_values, double quantile) noexcept;
+
+  /**
+   * @param degrees_of_freedom Degrees of freedom.
+   * @return Two-sided 95% quantile of the Student's t-distribution.
+   */
+  [[nodiscard]] static double t_quantile(std::size_t degrees_of_freedom) noexcept;
+};
+
+/**
+ * The Benchmark runs a workload repeatedly and reports statistics of its counters and metrics per iteration:
+ * The counters are opened once per run, and every (warm-up and measured) repetition only enables and disables them
+ * around the iterations of the workload.
+ */
+class Benchmark
+{
+public:
+  /**
+   * Creates a benchmark.
+   *
+   * @param counter_definitions Definitions of the counters; must be alive as long as the benchmark and its results.
+   * @param benchmark_config Repetitions, iterations, pinning, and outlier rejection of the benchmark.
+   * @param config Configuration of the counters.
+   */
+  explicit Benchmark(const CounterDefinition& counter_definitions,
+                     BenchmarkConfig benchmark_config = {},
+                     Config config = {})
+    : _benchmark_config(benchmark_config)
+    , _event_counter(counter_definitions, config)
+  {
+  }
+
+  ~Benchmark() = default;
+
+  /**
+   * Add the specified counter to the list of monitored performance counters.
+   * The counter must exist within the counter definitions.
+   *
+   * @param counter_name Name of the counter.
+   * @return True, if the counter could be added.
+   */
+  bool add(std::string&& counter_name) { return _event_counter.add(std::move(counter_name)); }
+
+  /**
+   * Add the specified counter to the list of monitored performance counters.
+   * The counter must exist within the counter definitions.
+   *
+   * @param counter_name Name of the counter.
+   * @return True, if the counter could be added.
+   */
+  bool add(const std::string& counter_name) { return _event_counter.add(counter_name); }
+
+  /**
+   * Add the specified counters to the list of monitored performance counters.
+   * The counters must exist within the counter definitions.
+   *
+   * @param counter_names List of names of the counters.
+   * @return True, if the counters could be added.
+   */
+  bool add(std::vector<std::string>&& counter_names) { return _event_counter.add(std::move(counter_names)); }
+
+  /**
+   * Add the specified counters to the list of monitored performance counters.
+   * The counters must exist within the counter definitions.
+   *
+   * @param counter_names List of names of the counters.
+   * @return True, if the counters could be added.
+   */
+  bool add(const std::vector<std::string>& counter_names) { return _event_counter.add(counter_names); }
+
+  /**
+   * @return Configuration of the benchmark.
+   */
+  [[nodiscard]] BenchmarkConfig config() const noexcept { return _benchmark_config; }
+
+  /**
+   * Update the configuration of the benchmark.
+   *
+   * @param benchmark_config New config.
+   */
+  void config(BenchmarkConfig benchmark_config) noexcept { _benchmark_config = benchmark_config; }
+
+  /**
+   * Runs the workload (pinned to the configured CPU, if any): First all warm-up repetitions, then all measured
+   * repetitions, each calling the workload the configured number of iterations.
+   *
+   * @param workload Callable executed once per iteration.
+   * @return Statistics of all measured repetitions, normalized to a single iteration.
+   */
+  template<typename F>
+  [[nodiscard]] BenchmarkResult run(F&& workload)
+  {
+    const auto pinning = CpuPinning{ _benchmark_config.cpu_id() };
+
+    auto repetitions = std::vector<CounterResult>{};
+    repetitions.reserve(_benchmark_config.repetitions());
+
+    _event_counter.open();
+
+    for (auto repetition = 0U; repetition < _benchmark_config.warmup_repetitions(); ++repetition) {
+      repeat(workload);
+    }
+
+    for (auto repetition = 0U; repetition < _benchmark_config.repetitions(); ++repetition) {
+      repeat(workload);
+      repetitions.emplace_back(_event_counter.interval_result(_benchmark_config.iterations()));
+    }
+
+    _event_counter.close();
+
+    return BenchmarkResult{ std::move(repetitions), _benchmark_config.outlier_threshold() };
+  }
+
+private:
+  /**
+   * Pins the calling thread to a CPU and restores the previous affinity on destruction.
+   */
+  class CpuPinning
+  {
+  public:
+    explicit CpuPinning(std::optional<std::uint16_t> cpu_id);
+    CpuPinning(CpuPinning&&) = delete;
+    CpuPinning(const CpuPinning&) = delete;
+
+    ~CpuPinning();
+
+    CpuPinning& operator=(CpuPinning&&) = delete;
+    CpuPinning& operator=(const CpuPinning&) = delete;
+
+  private:
+    /// Affinity before pinning, if the thread was pinned.
+    std::optional<cpu_set_t> _previous_affinity{ std::nullopt };
+  };
+
+  BenchmarkConfig _benchmark_config;
+
+  EventCounter _event_counter;
+
+  template<typename F>
+  void repeat(F& workload)
+  {
+    _event_counter.start();
+    for (auto iteration = std::uint64_t{ 0U }; iteration < _benchmark_config.iterations(); ++iteration) {
+      workload();
+    }
+    _event_counter.stop();
+  }
+};
+}
@@ -30,19 +30,46 @@ enum BranchType : std::uint64_t
   Conditional = PERF_SAMPLE_BRANCH_COND,
   TransactionalMemoryAbort = PERF_SAMPLE_BRANCH_ABORT_TX,
   InTransaction = PERF_SAMPLE_BRANCH_IN_TX,
-  NotInTransaction = PERF_SAMPLE_BRANCH_NO_TX
+  NotInTransaction = PERF_SAMPLE_BRANCH_NO_TX,
+#ifndef PERFCPP_NO_SAMPLE_BRANCH_TYPE
+  SaveType = PERF_SAMPLE_BRANCH_TYPE_SAVE
+#else
+  SaveType = 1ULL << 61
+#endif
 };
 
 class Branch
 {
 public:
+  /// Type of the branch as classified by the perf subsystem (PERF_BR_*, requires perf::BranchType::SaveType).
+  enum class Type : std::uint8_t
+  {
+    Unknown = 0U,
+    Conditional = 1U,
+    Unconditional = 2U,
+    IndirectJump = 3U,
+    Call = 4U,
+    IndirectCall = 5U,
+    Return = 6U,
+    SystemCall = 7U,
+    SystemReturn = 8U,
+    ConditionalCall = 9U,
+    ConditionalReturn = 10U,
+    ExceptionReturn = 11U,
+    Interrupt = 12U,
+    SystemError = 13U,
+    NotInTransaction = 14U,
+    Extended = 15U
+  };
+
   Branch(const std::uintptr_t instruction_pointer_from,
          const std::uintptr_t instruction_pointer_to,
          const bool is_mispredicted,
          const bool is_predicted,
          const bool is_in_transaction,
          const bool is_transaction_abort,
-         const std::uint16_t cycles)
+         const std::uint16_t cycles,
+         const Type type = Type::Unknown)
     : _instruction_pointer_from(instruction_pointer_from)
     , _instruction_pointer_to(instruction_pointer_to)
     , _is_mispredicted(is_mispredicted)
@@ -50,6 +77,7 @@ public:
     , _is_in_transaction(is_in_transaction)
     , _is_transaction_abort(is_transaction_abort)
     , _cycles(cycles)
+    , _type(type)
   {
   }
 
@@ -88,6 +116,11 @@ public:
    */
   [[nodiscard]] std::uint16_t cycles() const noexcept { return _cycles; }
 
+  /**
+   * @return The type of the branch (Type::Unknown if not recorded, see perf::BranchType::SaveType).
+   */
+  [[nodiscard]] Type type() const noexcept { return _type; }
+
 private:
   std::uintptr_t _instruction_pointer_from;
   std::uintptr_t _instruction_pointer_to;
@@ -96,5 +129,6 @@ private:
   bool _is_in_transaction;
   bool _is_transaction_abort;
   std::uint16_t _cycles;
+  Type _type;
 };
 }
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace perf {
+/**
+ * Handle of a cgroup (e.g., of a container), opened from the cgroup file system. Counters and samplers monitor all
+ * processes of the cgroup when the handle is set in the config (see Config::cgroup()); the kernel filters the events
+ * per CPU, no process needs to be attached. The handle needs to be alive while opening the counters.
+ */
+class CGroupHandle
+{
+public:
+  /// Mount point of the cgroup (v2) file system, used for relative paths.
+  constexpr static inline auto MOUNT_POINT = "/sys/fs/cgroup";
+
+  /**
+   * Opens the cgroup. Throws a std::runtime_error if the cgroup cannot be opened.
+   *
+   * @param path Absolute path of the cgroup or path relative to the cgroup file system (e.g., "system.slice/docker").
+   */
+  explicit CGroupHandle(std::string path);
+  CGroupHandle(CGroupHandle&& other) noexcept;
+  CGroupHandle(const CGroupHandle&) = delete;
+
+  ~CGroupHandle();
+
+  CGroupHandle& operator=(CGroupHandle&& other) noexcept;
+  CGroupHandle& operator=(const CGroupHandle&) = delete;
+
+  /**
+   * @return Path of the cgroup.
+   */
+  [[nodiscard]] const std::string& path() const noexcept { return _path; }
+
+  /**
+   * @return File descriptor of the cgroup's directory.
+   */
+  [[nodiscard]] std::int32_t file_descriptor() const noexcept { return _file_descriptor; }
+
+  /**
+   * @return Id of the cgroup as recorded into samples (see Sampler::Values::cgroup()), which is the inode number of the
+   * cgroup's directory.
+   */
+  [[nodiscard]] std::uint64_t id() const noexcept { return _id; }
+
+private:
+  std::string _path;
+  std::int32_t _file_descriptor{ -1 };
+  std::uint64_t _id{ 0U };
+};
+}
@@ -1,11 +1,15 @@
 #pragma once
 
 #include "branch.h"
+#include "cgroup_handle.h"
 #include "period.h"
 #include "precision.h"
 #include "registers.h"
 #include <cstdint>
 #include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
 
 namespace perf {
 class Config
@@ -28,8 +32,13 @@ public:
 
   [[nodiscard]] bool is_debug() const noexcept { return _is_debug; }
 
+  [[nodiscard]] bool is_user_level_read() const noexcept { return _is_user_level_read; }
+
+  [[nodiscard]] bool is_pack_groups() const noexcept { return _is_pack_groups; }
+
   [[nodiscard]] std::optional<std::uint16_t> cpu_id() const noexcept { return _cpu_id; }
   [[nodiscard]] pid_t process_id() const noexcept { return _process_id; }
+  [[nodiscard]] std::optional<std::int32_t> cgroup_file_descriptor() const noexcept { return _cgroup_file_descriptor; }
 
   /**
    * Specify the number of maximum groups per EventCounter.
@@ -102,6 +111,29 @@ public:
    */
   void is_debug(const bool is_debug) noexcept { _is_debug = is_debug; }
 
+  /**
+   * If set to true (false by default), the EventCounter reads the counters from user-level via the rdpmc instruction
+   * instead of issuing a read() system call, which reduces the overhead of start(), stop(), and live_result()
+   * significantly. Reading from user-level is only possible when monitoring the calling thread (i.e., no specific
+   * process, CPU, or child threads); the counters fall back to the read() system call if the hardware does not
+   * support rdpmc or the counter is not scheduled on the hardware.
+   *
+   * @param is_user_level_read Flag indicating that counters should be read from user-level.
+   */
+  void user_level_read(const bool is_user_level_read) noexcept { _is_user_level_read = is_user_level_read; }
+
+  /**
+   * If set to true (false by default), the EventCounter does not fill groups in the order counters were added, but
+   * packs the counters into as few groups as the hardware can schedule at once when opening: The size of core groups is
+   * derived from the number of general-purpose and fixed counters of the PMU (see perf::HardwareInfo); counters that
+   * would occupy a fixed counter (e.g., instructions and cycles on Intel) do not take a general-purpose counter.
+   * Counters required by the same metric are kept in the same group, if possible. If the number of counters cannot be
+   * detected, max_counters_per_group() is used as the group size.
+   *
+   * @param is_pack_groups Flag indicating that counters should be packed into groups when opening.
+   */
+  void pack_groups(const bool is_pack_groups) noexcept { _is_pack_groups = is_pack_groups; }
+
   /**
    * If specified, the EventCounter or Sampler will monitor only that specified CPU.
    *
@@ -116,6 +148,15 @@ public:
    */
   void process_id(const pid_t process_id) noexcept { _process_id = process_id; }
 
+  /**
+   * If specified, the EventCounter or Sampler will monitor all processes of the cgroup instead of a process, filtered
+   * by the kernel. Cgroups can only be monitored on specific CPUs (e.g., via MultiCoreEventCounter or
+   * MultiCoreSampler); the cgroup needs to be alive while opening.
+   *
+   * @param cgroup Cgroup to monitor.
+   */
+  void cgroup(const CGroupHandle& cgroup) noexcept { _cgroup_file_descriptor = cgroup.file_descriptor(); }
+
 private:
   std::uint8_t _max_groups{ 5U };
   std::uint8_t _max_counters_per_group{ 4U };
@@ -129,8 +170,13 @@ private:
 
   bool _is_debug{ false };
 
+  bool _is_user_level_read{ false };
+
+  bool _is_pack_groups{ false };
+
   std::optional<std::uint16_t> _cpu_id{ std::nullopt };
   pid_t _process_id{ 0 };
+  std::optional<std::int32_t> _cgroup_file_descriptor{ std::nullopt };
 };
 
 class SampleConfig final : public Config
@@ -154,6 +200,59 @@ public:
    */
   [[nodiscard]] PeriodOrFrequency period_for_frequency() const noexcept { return _period_or_frequency; }
 
+  /**
+   * @return Number of samples after which the perf subsystem signals (e.g., via poll) that the buffer can be read.
+   */
+  [[nodiscard]] std::optional<std::uint32_t> wakeup_events() const noexcept { return _wakeup_events; }
+
+  /**
+   * @return Number of bytes in the buffer after which the perf subsystem signals that the buffer can be read.
+   */
+  [[nodiscard]] std::optional<std::uint32_t> wakeup_watermark() const noexcept { return _wakeup_watermark; }
+
+  /**
+   * @return Signal that is delivered to the thread opening the sampler when the perf subsystem signals that the buffer
+   * can be read, if any.
+   */
+  [[nodiscard]] std::optional<std::int32_t> wakeup_signal() const noexcept { return _wakeup_signal; }
+
+  /**
+   * @return Number of pages to allocate for the AUX area that receives hardware traces (e.g., Arm SPE or Intel PT);
+   * zero if no AUX area is mapped.
+   */
+  [[nodiscard]] std::uint64_t aux_pages() const noexcept { return _aux_pages; }
+
+  /**
+   * @return True, if the AUX area is mapped in snapshot mode, where the hardware continuously overwrites the oldest
+   * trace data.
+   */
+  [[nodiscard]] bool is_aux_snapshot() const noexcept { return _is_aux_snapshot; }
+
+  /**
+   * @return Filter expressions applied by the kernel via PERF_EVENT_IOC_SET_FILTER when opening the sampler.
+   */
+  [[nodiscard]] const std::vector<std::string>& filters() const noexcept { return _filters; }
+
+  /**
+   * @return Address filters applied by the kernel via PERF_EVENT_IOC_SET_FILTER when opening the sampler.
+   */
+  [[nodiscard]] const std::vector<std::string>& address_filters() const noexcept { return _address_filters; }
+
+  /**
+   * @return File descriptor of the BPF program attached to the triggers when opening the sampler, if any.
+   */
+  [[nodiscard]] std::optional<std::int32_t> bpf_program() const noexcept { return _bpf_program_file_descriptor; }
+
+  /**
+   * @return True, if the kernel omits kernel-level entries from sampled callchains.
+   */
+  [[nodiscard]] bool is_exclude_callchain_kernel() const noexcept { return _is_exclude_callchain_kernel; }
+
+  /**
+   * @return True, if the kernel omits user-level entries from sampled callchains.
+   */
+  [[nodiscard]] bool is_exclude_callchain_user() const noexcept { return _is_exclude_callchain_user; }
+
   /**
    * Default frequency to sample, if not specified along with a trigger. The frequency denotes to samples per second.
    * Note that either frequency or period can be specified.
@@ -213,6 +312,124 @@ public:
    */
   void buffer_pages(const std::uint64_t buffer_pages) noexcept { _buffer_pages = buffer_pages; }
 
+  /**
+   * Signal readers of the buffer (e.g., a background drain thread) after every <count_events> samples.
+   * Note that either wakeup events or wakeup watermark can be specified; by default, the perf subsystem signals when
+   * the buffer is half full.
+   *
+   * @param count_events Number of samples after which the buffer is signaled to be readable.
+   */
+  void wakeup_events(const std::uint32_t count_events) noexcept
+  {
+    _wakeup_events = count_events;
+    _wakeup_watermark = std::nullopt;
+  }
+
+  /**
+   * Signal readers of the buffer (e.g., a background drain thread) when the buffer holds at least <bytes> bytes.
+   * Note that either wakeup events or wakeup watermark can be specified; by default, the perf subsystem signals when
+   * the buffer is half full.
+   *
+   * @param bytes Number of bytes after which the buffer is signaled to be readable.
+   */
+  void wakeup_watermark(const std::uint32_t bytes) noexcept
+  {
+    _wakeup_watermark = bytes;
+    _wakeup_events = std::nullopt;
+  }
+
+  /**
+   * Delivers the given signal (via F_SETSIG) to the thread that opens the sampler whenever the perf subsystem signals
+   * that the buffer can be read (see wakeup_events() and wakeup_watermark()). When installing the handler with
+   * SA_SIGINFO, siginfo_t::si_fd holds the file descriptor of the signaling buffer. Note that samples should not be
+   * read within the handler (reading allocates memory); instead, the handler should wake up the reading thread, or
+   * the signal should be consumed via sigwaitinfo() or signalfd().
+   *
+   * @param signal Signal to deliver, preferably a real-time signal (e.g., SIGRTMIN), which is queued.
+   */
+  void wakeup_signal(const std::int32_t signal) noexcept { _wakeup_signal = signal; }
+
+  /**
+   * Specifies the number of pages allocated for the AUX area, which receives the trace of hardware-tracing events
+   * (e.g., "arm_spe" or "intel_pt") next to the user-level buffer. The number of pages must be a power of two.
+   *
+   * @param aux_pages Number of pages allocated for the AUX area; zero to map no AUX area.
+   */
+  void aux_pages(const std::uint64_t aux_pages) noexcept { _aux_pages = aux_pages; }
+
+  /**
+   * Maps the AUX area in snapshot mode: The hardware keeps overwriting the oldest trace data instead of stopping
+   * when the area is full, and the most recent trace is read on demand via Sampler::aux_snapshot() (e.g., after an
+   * interesting event occurred).
+   *
+   * @param is_aux_snapshot True, if the AUX area should be mapped in snapshot mode.
+   */
+  void aux_snapshot(const bool is_aux_snapshot) noexcept { _is_aux_snapshot = is_aux_snapshot; }
+
+  /**
+   * Adds a filter expression that is handed to the kernel (via PERF_EVENT_IOC_SET_FILTER) when opening the sampler,
+   * such that uninteresting samples are dropped before they reach the buffer. Tracepoints accept ftrace filter
+   * expressions (e.g., "prev_pid == 1234"). The kernel holds a single filter per event: Multiple expressions are
+   * combined by "&&" (samples need to pass all of them). Expressions cannot be combined with address filters (see
+   * address_filter()); the sampler throws when opening if the kernel rejects the filter.
+   *
+   * @param filter Filter expression in the format of the kernel.
+   */
+  void filter(std::string filter) { _filters.emplace_back(std::move(filter)); }
+
+  /**
+   * Restricts the trigger to an address range (via PERF_EVENT_IOC_SET_FILTER), which is only supported by PMUs
+   * with address filters (e.g., "intel_pt" or Arm CoreSight). Multiple ranges are handed to the kernel as one list,
+   * samples within any of the ranges are recorded.
+   *
+   * @param begin First address of the range; an offset into the object file, if an object is given.
+   * @param size Size of the range in bytes.
+   * @param object Path of the object file (e.g., a shared library) the range refers to; kernel addresses otherwise.
+   */
+  void address_filter(const std::uintptr_t begin,
+                      const std::uint64_t size,
+                      const std::optional<std::string>& object = std::nullopt)
+  {
+    auto filter = std::stringstream{};
+    filter << "filter 0x" << std::hex << begin << "/0x" << size;
+    if (object.has_value()) {
+      filter << "@" << object.value();
+    }
+
+    _address_filters.emplace_back(filter.str());
+  }
+
+  /**
+   * Attaches a loaded BPF program (of type BPF_PROG_TYPE_PERF_EVENT) to the triggers (via PERF_EVENT_IOC_SET_BPF)
+   * when opening the sampler. The program is invoked by the kernel on every overflow; samples for which the program
+   * returns zero are dropped before they reach the buffer. The file descriptor needs to be valid while opening; the
+   * kernel keeps a reference to the program afterward.
+   *
+   * @param file_descriptor File descriptor of the loaded BPF program (e.g., via bpf_program__fd() of libbpf).
+   */
+  void bpf_program(const std::int32_t file_descriptor) noexcept { _bpf_program_file_descriptor = file_descriptor; }
+
+  /**
+   * If set, the kernel omits kernel-level entries (e.g., system calls or interrupt handlers) from sampled callchains,
+   * which shrinks samples when only the user-level stack is of interest.
+   *
+   * @param is_exclude_callchain_kernel Flag indicating that kernel-level callchain entries should be omitted.
+   */
+  void exclude_callchain_kernel(const bool is_exclude_callchain_kernel) noexcept
+  {
+    _is_exclude_callchain_kernel = is_exclude_callchain_kernel;
+  }
+
+  /**
+   * If set, the kernel omits user-level entries from sampled callchains.
+   *
+   * @param is_exclude_callchain_user Flag indicating that user-level callchain entries should be omitted.
+   */
+  void exclude_callchain_user(const bool is_exclude_callchain_user) noexcept
+  {
+    _is_exclude_callchain_user = is_exclude_callchain_user;
+  }
+
 private:
   /// Number of pages allocated for the user-level buffer.
   std::uint64_t _buffer_pages{ 8192U + 1U };
@@ -222,5 +439,31 @@ private:
 
   /// Default precision for sampling, if not specified for a trigger.
   Precision _precise_ip{ Precision::MustHaveConstantSkid /* Enable PEBS by default */ };
+
+  /// Number of samples after which readers of the buffer are signaled.
+  std::optional<std::uint32_t> _wakeup_events{ std::nullopt };
+
+  /// Number of bytes after which readers of the buffer are signaled.
+  std::optional<std::uint32_t> _wakeup_watermark{ std::nullopt };
+
+  /// Signal delivered when readers of the buffer are signaled.
+  std::optional<std::int32_t> _wakeup_signal{ std::nullopt };
+
+  /// Number of pages allocated for the AUX area (none by default).
+  std::uint64_t _aux_pages{ 0U };
+
+  /// Flag if the AUX area is overwritten continuously.
+  bool _is_aux_snapshot{ false };
+
+  /// Filter expressions and address filters handed to the kernel when opening.
+  std::vector<std::string> _filters;
+  std::vector<std::string> _address_filters;
+
+  /// BPF program attached to the triggers when opening.
+  std::optional<std::int32_t> _bpf_program_file_descriptor{ std::nullopt };
+
+  /// Flags if kernel-level or user-level entries are omitted from callchains.
+  bool _is_exclude_callchain_kernel{ false };
+  bool _is_exclude_callchain_user{ false };
 };
 }
\ No newline at end of file
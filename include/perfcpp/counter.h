@@ -9,6 +9,9 @@
 #include <vector>
 
 namespace perf {
+template<std::size_t S>
+struct CounterReadFormat;
+
 class CounterConfig
 {
 public:
@@ -45,6 +48,24 @@ public:
 
   [[nodiscard]] bool is_auxiliary() const noexcept { return _event_id == 0x8203; }
 
+  /**
+   * @return True, if the config encodes Intel's slots event (event 0x00, umask 0x04), which leads top-down groups.
+   */
+  [[nodiscard]] bool is_intel_topdown_slots() const noexcept
+  {
+    return _type == PERF_TYPE_RAW && core_event_id() == 0x0400U;
+  }
+
+  /**
+   * @return True, if the config encodes one of Intel's top-down metric events (event 0x00, umask 0x80-0x87), which
+   *  are read from the PERF_METRICS register and need the slots event as group leader.
+   */
+  [[nodiscard]] bool is_intel_topdown_metric() const noexcept
+  {
+    return _type == PERF_TYPE_RAW && (core_event_id() & 0xFFU) == 0U && core_event_id() >= 0x8000U &&
+           core_event_id() <= 0x87FFU;
+  }
+
 private:
   std::uint32_t _type;
   std::uint64_t _event_id;
@@ -52,6 +73,9 @@ private:
   std::uint8_t _precise_ip{ 0U };
   bool _is_frequency{ false };
   std::uint64_t _period_or_frequency{ 4000ULL };
+
+  /// Event id without the extended PMU type (bits 32-63 select the PMU of raw events on hybrid processors).
+  [[nodiscard]] std::uint64_t core_event_id() const noexcept { return _event_id & 0xFFFFFFFFULL; }
 };
 
 class CounterResult
@@ -81,6 +105,32 @@ public:
    */
   [[nodiscard]] std::optional<double> get(std::string_view name) const noexcept;
 
+  /**
+   * Resolves the position of the counter or metric with the given name. Results produced by the same EventCounter
+   * (i.e., the same counters and metrics added in the same order) share their positions: The index can be resolved
+   * once and used to access the value of subsequent results in constant time.
+   *
+   * @param name Name of the counter or metric.
+   * @return The index of the result, or std::nullopt if the result has no counter or metric with the requested name.
+   */
+  [[nodiscard]] std::optional<std::size_t> index(std::string_view name) const noexcept;
+
+  /**
+   * Access the name and value of the result at the given index (see index()).
+   *
+   * @param index Index of the result.
+   * @return Name and value of the counter or metric.
+   */
+  [[nodiscard]] const std::pair<std::string_view, double>& operator[](const std::size_t index) const noexcept
+  {
+    return _results[index];
+  }
+
+  /**
+   * @return Number of counters and metrics in the result.
+   */
+  [[nodiscard]] std::size_t size() const noexcept { return _results.size(); }
+
   [[nodiscard]] iterator begin() { return _results.begin(); }
   [[nodiscard]] iterator end() { return _results.end(); }
   [[nodiscard]] const_iterator begin() const { return _results.begin(); }
@@ -121,6 +171,11 @@ public:
 
   ~Counter() noexcept = default;
 
+  /**
+   * @return Configuration of the counter.
+   */
+  [[nodiscard]] const CounterConfig& config() const noexcept { return _config; }
+
   /**
    * @return ID of the counter.
    */
@@ -136,6 +191,8 @@ public:
    * architectures.
    */
   [[nodiscard]] bool is_auxiliary() const noexcept { return _config.is_auxiliary(); }
+  [[nodiscard]] bool is_intel_topdown_slots() const noexcept { return _config.is_intel_topdown_slots(); }
+  [[nodiscard]] bool is_intel_topdown_metric() const noexcept { return _config.is_intel_topdown_metric(); }
 
   /**
    * Opens the counter using the perf subsystem via the perf_event_open system call.
@@ -151,6 +208,7 @@ public:
    * if this is the group leader.
    * @param cpu_id ID of the CPU to monitor.
    * @param process_id ID of the process to monitor.
+   * @param cgroup_file_descriptor File descriptor of the cgroup to monitor instead of a process, std::nullopt if none.
    * @param is_inherit True, if child-threads should be monitored.
    * @param is_include_kernel True, if kernel-activity should be monitored.
    * @param is_include_user True, if user-activity should be monitored.
@@ -163,8 +221,13 @@ public:
    * @param user_registers Mask of sampled user registers, std::nullopt of sampling is disabled.
    * @param kernel_registers Mask of sampled kernel registers, std::nullopt of sampling is disabled.
    * @param max_callstack Maximal size of sampled callstacks, std::nullopt of sampling is disabled.
+   * @param is_exclude_callchain_kernel True, if kernel-level entries should be omitted from sampled callchains.
+   * @param is_exclude_callchain_user True, if user-level entries should be omitted from sampled callchains.
    * @param is_include_context_switch True, if context switches should be sampled, ignored if sampling is disabled.
    * @param is_include_cgroup True, if cgroups should be sampled, ignored if sampling is disabled.
+   * @param is_include_mmap True, if memory mappings (mmap) should be sampled, ignored if sampling is disabled.
+   * @param wakeup_events Number of samples after which the buffer is signaled as readable, std::nullopt for default.
+   * @param wakeup_watermark Number of bytes after which the buffer is signaled as readable, std::nullopt for default.
    */
   void open(bool is_print_debug,
             bool is_group_leader,
@@ -172,6 +235,7 @@ public:
             std::int64_t group_leader_file_descriptor,
             std::optional<std::uint16_t> cpu_id,
             pid_t process_id,
+            std::optional<std::int32_t> cgroup_file_descriptor,
             bool is_inherit,
             bool is_include_kernel,
             bool is_include_user,
@@ -184,8 +248,31 @@ public:
             std::optional<std::uint64_t> user_registers,
             std::optional<std::uint64_t> kernel_registers,
             std::optional<std::uint16_t> max_callstack,
+            bool is_exclude_callchain_kernel,
+            bool is_exclude_callchain_user,
             bool is_include_context_switch,
-            bool is_include_cgroup);
+            bool is_include_cgroup,
+            bool is_include_mmap,
+            std::optional<std::uint32_t> wakeup_events,
+            std::optional<std::uint32_t> wakeup_watermark);
+
+  /**
+   * Maps the metadata page of the counter into memory, which allows reading the counter from user-level (through the
+   * rdpmc instruction) without a system call.
+   *
+   * @return True, if the page could be mapped.
+   */
+  bool map_user_level_page();
+
+  /**
+   * Reads the value of the counter via rdpmc, using the mapped metadata page. Reading is only possible if the page
+   * was mapped, the hardware supports rdpmc, the counter is currently scheduled on the PMU, and the counter is
+   * monitoring the calling thread.
+   *
+   * @param value Value to read the counter into (including the enabled and running times).
+   * @return True, if reading was successful. If false, the counter needs to be read via the read() system call.
+   */
+  [[nodiscard]] bool read_user_level(CounterReadFormat<1U>& value) const noexcept;
 
   /**
    * Closes the counter and resets the file descriptor.
@@ -206,19 +293,53 @@ private:
   std::uint64_t _id{ 0U };
   std::int64_t _file_descriptor{ -1 };
 
+  /// Metadata page of the counter, mapped only if the counter is read from user-level.
+  perf_event_mmap_page* _user_level_page{ nullptr };
+
   /**
    * Do the "final" perf_event_open system call with the provided parameters.
    *
-   * @param process_id ID of the process to monitor.
+   * @param process_id ID of the process to monitor (or the file descriptor of the cgroup, see flags).
    * @param cpu_id ID of the CPU to monitor.
    * @param is_group_leader True, if this counter is the group leader.
    * @param group_leader_file_descriptor File descriptor of the group leader.
+   * @param flags Flags of the system call (e.g., PERF_FLAG_PID_CGROUP).
    * @return The file descriptor, which is returned by the system call (-1 in case the call was not successful).
    */
   std::int64_t perf_event_open(pid_t process_id,
                                std::int32_t cpu_id,
                                bool is_group_leader,
-                               std::int64_t group_leader_file_descriptor);
+                               std::int64_t group_leader_file_descriptor,
+                               std::uint64_t flags);
+
+#if defined(__x86_64__) || defined(__i386__)
+  /**
+   * Reads the given hardware performance counter via the rdpmc instruction.
+   *
+   * @param counter Index of the hardware performance counter.
+   * @return Raw value of the hardware performance counter.
+   */
+  [[nodiscard]] static std::uint64_t rdpmc(const std::uint32_t counter) noexcept
+  {
+    auto low = std::uint32_t{ 0U };
+    auto high = std::uint32_t{ 0U };
+    asm volatile("rdpmc" : "=a"(low), "=d"(high) : "c"(counter));
+
+    return (std::uint64_t{ high } << 32U) | low;
+  }
+
+  /**
+   * @return Current value of the time stamp counter.
+   */
+  [[nodiscard]] static std::uint64_t rdtsc() noexcept
+  {
+    auto low = std::uint32_t{ 0U };
+    auto high = std::uint32_t{ 0U };
+    asm volatile("rdtsc" : "=a"(low), "=d"(high));
+
+    return (std::uint64_t{ high } << 32U) | low;
+  }
+#endif
 
   /**
    * Prints a name of a type (e.g., sample, branch, ...) to the stream if the type is set in the mask.
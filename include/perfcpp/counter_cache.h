@@ -0,0 +1,121 @@
+#pragma once
+
+#include "counter.h"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace perf {
+/**
+ * Binary format of counter definition caches, written by CounterCache::write() and mapped by the CounterCache.
+ * A file starts with a header, followed by an array of entries (sorted by name) and the table of all names (not
+ * terminated). Counters are resolved by binary search over the entries, without parsing or hashing the file.
+ */
+class CounterCacheFile
+{
+public:
+  /// Identifies perf-cpp counter caches.
+  constexpr static inline auto MAGIC = std::uint64_t{ 0x3152544E554F4350ULL }; /// "PCOUNTR1"
+
+  /// Version of the format.
+  constexpr static inline auto VERSION = std::uint32_t{ 1U };
+
+  struct Header
+  {
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t count_counters;
+    std::uint64_t names_size;
+  };
+
+  struct Entry
+  {
+    std::uint32_t name_offset;
+    std::uint32_t name_length;
+    std::uint32_t type;
+    std::uint32_t reserved;
+    std::uint64_t event_id;
+    std::uint64_t event_id_extension_1;
+    std::uint64_t event_id_extension_2;
+  };
+};
+
+/**
+ * The CounterCache maps a counter definition cache into memory and resolves counter names without copying them:
+ * Names returned by the cache point into the mapped file and are valid as long as the cache is alive.
+ */
+class CounterCache
+{
+public:
+  /**
+   * Maps the file into memory and validates its header and entries.
+   *
+   * @param file_name Name of the file.
+   */
+  explicit CounterCache(const std::string& file_name);
+  CounterCache(CounterCache&&) = delete;
+  CounterCache(const CounterCache&) = delete;
+
+  ~CounterCache();
+
+  CounterCache& operator=(CounterCache&&) = delete;
+  CounterCache& operator=(const CounterCache&) = delete;
+
+  /**
+   * Writes the given counters into a cache file (counters with duplicate names are written once).
+   *
+   * @param file_name Name of the file.
+   * @param counters Names and configurations of the counters.
+   */
+  static void write(const std::string& file_name, std::vector<std::pair<std::string_view, CounterConfig>>&& counters);
+
+  /**
+   * Checks if the given file starts with the header of a counter cache.
+   *
+   * @param file_name Name of the file.
+   * @return True, if the file is a counter cache.
+   */
+  [[nodiscard]] static bool is_cache(const std::string& file_name);
+
+  /**
+   * Looks up the counter with the given name.
+   *
+   * @param name Name of the counter.
+   * @return Name (pointing into the mapped file) and configuration, or std::nullopt if the cache has no such counter.
+   */
+  [[nodiscard]] std::optional<std::pair<std::string_view, CounterConfig>> counter(std::string_view name) const noexcept;
+
+  /**
+   * @return Number of counters in the cache.
+   */
+  [[nodiscard]] std::size_t size() const noexcept { return _count_counters; }
+
+  /**
+   * @param index Index of the counter (counters are sorted by name).
+   * @return The name of the counter at the given index.
+   */
+  [[nodiscard]] std::string_view name(const std::size_t index) const noexcept { return name(_entries[index]); }
+
+private:
+  /// Memory-mapped file.
+  const std::uint8_t* _data{ nullptr };
+
+  /// Size of the file.
+  std::size_t _size{ 0U };
+
+  /// Entries, sorted by name.
+  const CounterCacheFile::Entry* _entries{ nullptr };
+  std::size_t _count_counters{ 0U };
+
+  /// Table of all names.
+  const char* _names{ nullptr };
+
+  [[nodiscard]] std::string_view name(const CounterCacheFile::Entry& entry) const noexcept
+  {
+    return std::string_view{ _names + entry.name_offset, entry.name_length };
+  }
+};
+}
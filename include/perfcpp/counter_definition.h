@@ -1,13 +1,18 @@
 #pragma once
 
 #include "counter.h"
+#include "counter_cache.h"
+#include "formula_metric.h"
 #include "metric.h"
 #include <algorithm>
 #include <cstdint>
+#include <forward_list>
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 namespace perf {
 class CounterDefinition
@@ -37,63 +42,160 @@ public:
 
   void add(std::string&& name, CounterConfig config)
   {
-    _counter_configs.insert(std::make_pair(std::move(name), config));
+    if (_counter_configs.find(name) == _counter_configs.end() && !is_cached(name)) {
+      _counter_configs.insert(std::make_pair(intern(std::move(name)), config));
+    }
   }
 
   void add(std::string&& name, std::unique_ptr<Metric>&& metric)
   {
-    _metrics.insert(std::make_pair(std::move(name), std::move(metric)));
+    if (_metrics.find(name) == _metrics.end()) {
+      _metrics.insert(std::make_pair(intern(std::move(name)), std::move(metric)));
+    }
   }
 
-  void add(std::unique_ptr<Metric>&& metric) { _metrics.insert(std::make_pair(metric->name(), std::move(metric))); }
+  /**
+   * Adds a metric defined by a formula over counters, e.g., add("ipc", "instructions / cycles").
+   * Throws a std::runtime_error if the formula is invalid.
+   *
+   * @param name Name of the metric.
+   * @param formula Formula of the metric (see perf::FormulaMetric).
+   */
+  void add(std::string&& name, const std::string_view formula)
+  {
+    auto metric = std::make_unique<FormulaMetric>(name, formula);
+    add(std::move(name), std::move(metric));
+  }
 
-  [[nodiscard]] std::optional<std::pair<std::string_view, CounterConfig>> counter(std::string&& name) const noexcept
+  void add(std::unique_ptr<Metric>&& metric)
   {
-    return counter(name);
+    auto name = metric->name();
+    add(std::move(name), std::move(metric));
   }
+
+  /**
+   * Looks up the counter with the given name. The returned name is interned, i.e., it refers to the definition's own
+   * copy of the name and remains valid as long as the definition lives.
+   *
+   * @param name Name of the counter.
+   * @return Interned name and configuration of the counter, or std::nullopt if no counter with that name exists.
+   */
   [[nodiscard]] std::optional<std::pair<std::string_view, CounterConfig>> counter(
-    const std::string& name) const noexcept;
+    std::string_view name) const noexcept;
   [[nodiscard]] std::optional<std::pair<std::string_view, CounterConfig>> counter(
-    const std::string_view name) const noexcept
+    const std::string& name) const noexcept
   {
-    return counter(std::string{ name });
+    return counter(std::string_view{ name });
   }
-  [[nodiscard]] bool is_metric(const std::string& name) const noexcept { return _metrics.find(name) != _metrics.end(); }
-  [[nodiscard]] bool is_metric(std::string_view name) const noexcept { return is_metric(std::string{ name }); }
-  [[nodiscard]] std::optional<std::pair<std::string_view, Metric&>> metric(const std::string& name) const noexcept;
-  [[nodiscard]] std::optional<std::pair<std::string_view, Metric&>> metric(std::string&& name) const noexcept
+  [[nodiscard]] std::optional<std::pair<std::string_view, CounterConfig>> counter(std::string&& name) const noexcept
   {
-    return metric(name);
+    return counter(std::string_view{ name });
   }
-  [[nodiscard]] std::optional<std::pair<std::string_view, Metric&>> metric(const std::string_view name) const noexcept
+  [[nodiscard]] std::optional<std::pair<std::string_view, CounterConfig>> counter(const char* name) const noexcept
   {
-    return metric(std::string{ name.data(), name.size() });
+    return counter(std::string_view{ name });
   }
 
+  [[nodiscard]] bool is_metric(const std::string_view name) const noexcept
+  {
+    return _metrics.find(name) != _metrics.end();
+  }
+  [[nodiscard]] bool is_metric(const std::string& name) const noexcept { return is_metric(std::string_view{ name }); }
+  [[nodiscard]] bool is_metric(const char* name) const noexcept { return is_metric(std::string_view{ name }); }
+
   /**
-   * @return List names of all available counters.
+   * Looks up the metric with the given name. The returned name is interned (see counter()).
+   *
+   * @param name Name of the metric.
+   * @return Interned name and the metric, or std::nullopt if no metric with that name exists.
    */
-  [[nodiscard]] std::vector<std::string> names() const
+  [[nodiscard]] std::optional<std::pair<std::string_view, Metric&>> metric(std::string_view name) const noexcept;
+  [[nodiscard]] std::optional<std::pair<std::string_view, Metric&>> metric(const std::string& name) const noexcept
   {
-    auto names = std::vector<std::string>{};
-    std::transform(_counter_configs.begin(), _counter_configs.end(), std::back_inserter(names), [](const auto& config) {
-      return config.first;
-    });
-    return names;
+    return metric(std::string_view{ name });
+  }
+  [[nodiscard]] std::optional<std::pair<std::string_view, Metric&>> metric(std::string&& name) const noexcept
+  {
+    return metric(std::string_view{ name });
+  }
+  [[nodiscard]] std::optional<std::pair<std::string_view, Metric&>> metric(const char* name) const noexcept
+  {
+    return metric(std::string_view{ name });
   }
 
+  /**
+   * @return List names of all available counters.
+   */
+  [[nodiscard]] std::vector<std::string> names() const;
+
   /**
    * Reads and adds counters from the provided CSV file with counter configurations.
+   * Lines in the format "name = formula" define metrics (see perf::FormulaMetric).
    * @param csv_filename CSV file with counter configurations.
    */
   void read_counter_configuration(const std::string& csv_filename);
 
+  /**
+   * Maps the provided counter cache (written by write_counter_cache()) into memory. Counters of the cache are resolved
+   * on lookup (binary search), the cache is neither parsed nor copied into the definition.
+   *
+   * @param cache_filename File written by write_counter_cache().
+   */
+  void read_counter_cache(const std::string& cache_filename)
+  {
+    _counter_caches.emplace_back(std::make_unique<CounterCache>(cache_filename));
+  }
+
+  /**
+   * Writes all counters of the definition (including counters read from CSV files and caches, but no metrics) into
+   * a binary cache, which can be loaded by read_counter_cache() or the constructor much faster than the CSV file.
+   *
+   * @param cache_filename Name of the file.
+   */
+  void write_counter_cache(const std::string& cache_filename) const;
+
 private:
+  /// Storage for the names of all counters and metrics. The maps below are keyed by views into this storage, which
+  /// allows probing them with a std::string_view without creating a temporary std::string (C++17 has no heterogeneous
+  /// lookup for unordered containers). Elements of a std::forward_list never move, not even when the list is moved.
+  std::forward_list<std::string> _names;
+
   /// List of added counter configurations.
-  std::unordered_map<std::string, CounterConfig> _counter_configs;
+  std::unordered_map<std::string_view, CounterConfig> _counter_configs;
 
   /// List of added metrics.
-  std::unordered_map<std::string, std::unique_ptr<Metric>> _metrics;
+  std::unordered_map<std::string_view, std::unique_ptr<Metric>> _metrics;
+
+  /// Mapped counter caches; counters are looked up in the caches if not found in _counter_configs.
+  std::vector<std::unique_ptr<CounterCache>> _counter_caches;
+
+  /**
+   * @param name Name of the counter.
+   * @return True, if any of the mapped caches holds a counter with the given name.
+   */
+  [[nodiscard]] bool is_cached(const std::string_view name) const noexcept
+  {
+    return std::any_of(_counter_caches.begin(), _counter_caches.end(), [name](const auto& cache) {
+      return cache->counter(name).has_value();
+    });
+  }
+
+  /**
+   * Stores the given name and returns a view that remains valid as long as the definition lives.
+   *
+   * @param name Name to store.
+   * @return View on the stored name.
+   */
+  [[nodiscard]] std::string_view intern(std::string&& name)
+  {
+    return std::string_view{ _names.emplace_front(std::move(name)) };
+  }
+
+  /**
+   * @param text Text to trim.
+   * @return The text without leading and trailing whitespace.
+   */
+  [[nodiscard]] static std::string_view trim(std::string_view text) noexcept;
 
   /**
    * Add all generalized counters to the counter config.
@@ -109,5 +211,17 @@ private:
    * If the system is an Intel, read some PEBS counters, if supported.
    */
   void initialize_intel_pebs_counters();
+
+  /**
+   * Add hardware-tracing events that write into the AUX area (Arm SPE and Intel PT), if supported.
+   */
+  void initialize_aux_counters();
+
+  /**
+   * Add the counters and metrics of the top-down microarchitecture analysis (level 1 and 2), if supported: Intel
+   * processors with the PERF_METRICS register (slots and topdown-* events) or AMD processors with pipeline utilization
+   * events (Zen 4 and later).
+   */
+  void initialize_topdown_metrics();
 };
 }
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "sample_batch.h"
+#include "sample_view.h"
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace perf {
+/**
+ * The CounterDelta computes the differences of the counter values recorded with samples (PERF_SAMPLE_READ) between
+ * consecutive samples of the same counter group, i.e., the events that occurred since the previous sample of the same
+ * thread or CPU core – the basis of per-sample metrics like instructions per cycle. The differences are corrected for
+ * multiplexing using the time the counters were enabled and running in between. The previous values are kept per
+ * group (identified by the id of the group's first counter), such that samples of multiple threads or CPU cores can
+ * be interleaved; after the first sample of every group, no memory is allocated.
+ */
+class CounterDelta
+{
+public:
+  CounterDelta() = default;
+  ~CounterDelta() = default;
+
+  /**
+   * Computes the differences between the counter values of the given sample and the previous sample of the same group.
+   *
+   * @param sample Sample (e.g., within Sampler::drain()).
+   * @return True, if a previous sample of the same group was seen and the differences are available via values();
+   * false, if there was no previous sample or a counter went backwards (e.g., after a reset), making this sample the
+   * new baseline.
+   */
+  bool update(const SampleView& sample);
+
+  /**
+   * Computes the differences between the counter values of the given row and the previous row of the same group.
+   *
+   * @param row Row of a SampleBatch.
+   * @return True, if a previous row of the same group was seen and the differences are available via values();
+   * false, if there was no previous row or a counter went backwards (e.g., after a reset), making this row the
+   * new baseline.
+   */
+  bool update(const SampleBatch::Row& row);
+
+  /**
+   * @return Differences of the last updated sample, in the order of the counter names.
+   */
+  [[nodiscard]] const std::vector<double>& values() const noexcept { return _values; }
+
+  /**
+   * @param name Name of the counter.
+   * @return The difference of the counter with the given name, std::nullopt if the counter was not sampled or the last
+   * update had no previous sample.
+   */
+  [[nodiscard]] std::optional<double> value(std::string_view name) const noexcept;
+
+  /**
+   * Computes the ratio of two differences, e.g., ratio("instructions", "cycles") for the instructions per cycle since
+   * the previous sample.
+   *
+   * @param numerator Name of the counter in the numerator.
+   * @param denominator Name of the counter in the denominator.
+   * @return The ratio, std::nullopt if one of the counters is not available or the denominator is zero.
+   */
+  [[nodiscard]] std::optional<double> ratio(std::string_view numerator, std::string_view denominator) const noexcept;
+
+  /**
+   * Forgets the previous values of all groups.
+   */
+  void reset() noexcept
+  {
+    _previous.clear();
+    _values.clear();
+  }
+
+private:
+  /// Values of the previous sample of a group.
+  struct Previous
+  {
+    std::vector<std::uint64_t> values;
+    std::optional<std::uint64_t> time_enabled;
+    std::optional<std::uint64_t> time_running;
+  };
+
+  /// Previous values, by the id of the group's first counter.
+  std::unordered_map<std::uint64_t, Previous> _previous;
+
+  /// Names of the counters of the last updated sample.
+  const std::vector<std::string_view>* _names{ nullptr };
+
+  /// Differences of the last updated sample.
+  std::vector<double> _values;
+
+  /**
+   * Computes the differences to the previous values of the group and replaces them by the given values.
+   *
+   * @param group_id Id of the group.
+   * @param names Names of the counters.
+   * @param values Raw values of the counters.
+   * @param time_enabled Time the counters were enabled.
+   * @param time_running Time the counters were running.
+   * @return True, if previous values were known.
+   */
+  template<typename V>
+  bool update(std::uint64_t group_id,
+              const std::vector<std::string_view>& names,
+              Span<V> values,
+              std::optional<std::uint64_t> time_enabled,
+              std::optional<std::uint64_t> time_running);
+};
+}
@@ -0,0 +1,224 @@
+#pragma once
+
+#include "config.h"
+#include "counter.h"
+#include "counter_definition.h"
+#include "event_counter.h"
+#include "group.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace perf {
+/**
+ * The CounterTimeSeries records hardware performance counters periodically, creating a time series of counter values
+ * (e.g., to see how IPC or cache misses change over the runtime of a long-running job).
+ * A background thread reads the counters at a configurable interval and stores the (multiplexing-corrected) deltas
+ * of every interval into a preallocated ring; if the ring is full, the oldest intervals are overwritten.
+ * Recording does not allocate memory once started.
+ */
+class CounterTimeSeries
+{
+public:
+  /// Single interval of the time series.
+  class Interval
+  {
+  public:
+    Interval(const std::chrono::nanoseconds begin, const std::chrono::nanoseconds end, CounterResult&& result) noexcept
+      : _begin(begin)
+      , _end(end)
+      , _result(std::move(result))
+    {
+    }
+
+    ~Interval() = default;
+
+    /**
+     * @return Begin of the interval, relative to starting the time series.
+     */
+    [[nodiscard]] std::chrono::nanoseconds begin() const noexcept { return _begin; }
+
+    /**
+     * @return End of the interval, relative to starting the time series.
+     */
+    [[nodiscard]] std::chrono::nanoseconds end() const noexcept { return _end; }
+
+    /**
+     * @return Counter and metric values of the interval.
+     */
+    [[nodiscard]] const CounterResult& result() const noexcept { return _result; }
+
+  private:
+    std::chrono::nanoseconds _begin;
+    std::chrono::nanoseconds _end;
+    CounterResult _result;
+  };
+
+  /**
+   * Creates a time series.
+   *
+   * @param counter_definitions Definitions of the counters; must be alive as long as the time series.
+   * @param interval Interval between two reads of the counters.
+   * @param capacity Maximal number of intervals kept in the ring.
+   * @param config Configuration of the counters.
+   */
+  CounterTimeSeries(const CounterDefinition& counter_definitions,
+                    std::chrono::milliseconds interval,
+                    std::size_t capacity,
+                    Config config = {});
+
+  CounterTimeSeries(CounterTimeSeries&&) = delete;
+  CounterTimeSeries(const CounterTimeSeries&) = delete;
+
+  ~CounterTimeSeries() { stop(); }
+
+  CounterTimeSeries& operator=(CounterTimeSeries&&) = delete;
+  CounterTimeSeries& operator=(const CounterTimeSeries&) = delete;
+
+  /**
+   * Add the specified counter to the list of monitored performance counters.
+   * The counter must exist within the counter definitions.
+   *
+   * @param counter_name Name of the counter.
+   * @return True, if the counter could be added.
+   */
+  bool add(std::string&& counter_name) { return _event_counter.add(std::move(counter_name)); }
+
+  /**
+   * Add the specified counter to the list of monitored performance counters.
+   * The counter must exist within the counter definitions.
+   *
+   * @param counter_name Name of the counter.
+   * @return True, if the counter could be added.
+   */
+  bool add(const std::string& counter_name) { return _event_counter.add(counter_name); }
+
+  /**
+   * Add the specified counters to the list of monitored performance counters.
+   * The counters must exist within the counter definitions.
+   *
+   * @param counter_names List of names of the counters.
+   * @return True, if the counters could be added.
+   */
+  bool add(std::vector<std::string>&& counter_names) { return _event_counter.add(std::move(counter_names)); }
+
+  /**
+   * Add the specified counters to the list of monitored performance counters.
+   * The counters must exist within the counter definitions.
+   *
+   * @param counter_names List of names of the counters.
+   * @return True, if the counters could be added.
+   */
+  bool add(const std::vector<std::string>& counter_names) { return _event_counter.add(counter_names); }
+
+  /**
+   * Opens and starts the counters and the background thread reading the counters periodically.
+   * Previously recorded intervals are discarded.
+   *
+   * @return True, if the counters could be started.
+   */
+  bool start();
+
+  /**
+   * Records the last (partial) interval, stops the background thread, and closes the counters.
+   */
+  void stop();
+
+  /**
+   * @return Number of intervals in the ring.
+   */
+  [[nodiscard]] std::size_t size() const;
+
+  /**
+   * @return Number of intervals that were overwritten since the ring was full.
+   */
+  [[nodiscard]] std::uint64_t count_lost_intervals() const;
+
+  /**
+   * Returns the recorded intervals (oldest first), including counters and metrics. Can be called while recording.
+   *
+   * @param normalization Normalization value, default = 1.
+   * @return List of intervals.
+   */
+  [[nodiscard]] std::vector<Interval> result(std::uint64_t normalization = 1U) const;
+
+  /**
+   * Converts the time series to a CSV-formatted string, one interval per row, starting with the begin and end (in
+   * nanoseconds relative to starting the time series) followed by one column per counter and metric.
+   *
+   * @param delimiter Char to separate columns (',' by default).
+   * @param print_header If true, the header will be printed first (true by default).
+   * @param normalization Normalization value, default = 1.
+   * @return Time series in CSV format.
+   */
+  [[nodiscard]] std::string to_csv(char delimiter = ',',
+                                   bool print_header = true,
+                                   std::uint64_t normalization = 1U) const;
+
+private:
+  /// Counters to read.
+  EventCounter _event_counter;
+
+  /// Interval between two reads.
+  std::chrono::milliseconds _interval;
+
+  /// Maximal number of intervals.
+  std::size_t _capacity;
+
+  /// Number of hardware events per interval.
+  std::size_t _count_values{ 0U };
+
+  /// Values read at the begin of the current interval (one per group).
+  std::vector<CounterReadFormat<Group::MAX_MEMBERS>> _previous_values;
+
+  /// Values read at the end of the current interval (one per group).
+  std::vector<CounterReadFormat<Group::MAX_MEMBERS>> _current_values;
+
+  /// Point in time the time series was started.
+  std::chrono::steady_clock::time_point _start_time;
+
+  /// Begin of the current interval, relative to the start time.
+  std::chrono::nanoseconds _interval_begin{ 0U };
+
+  /// Ring of begin and end times of the intervals.
+  std::vector<std::pair<std::chrono::nanoseconds, std::chrono::nanoseconds>> _times;
+
+  /// Ring of hardware-event values of the intervals (_count_values per interval).
+  std::vector<double> _values;
+
+  /// Position of the next interval in the ring.
+  std::size_t _head{ 0U };
+
+  /// Number of intervals in the ring.
+  std::size_t _size{ 0U };
+
+  /// Number of overwritten intervals.
+  std::uint64_t _count_lost_intervals{ 0U };
+
+  /// Guards the ring.
+  mutable std::mutex _mutex;
+
+  /// Wakes the background thread up when stopping.
+  std::condition_variable _stop_condition;
+
+  /// Flag to stop the background thread.
+  bool _is_stop_requested{ false };
+
+  /// Thread reading the counters periodically.
+  std::thread _thread;
+
+  /**
+   * Reads the counters periodically until stopping is requested.
+   */
+  void run();
+
+  /**
+   * Reads the counters and appends the interval since the last read to the ring.
+   */
+  void record();
+};
+}
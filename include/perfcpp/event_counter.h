@@ -4,16 +4,21 @@
 #include "counter.h"
 #include "counter_definition.h"
 #include "group.h"
+#include "thread_registry.h"
 #include <chrono>
+#include <functional>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
 
 namespace perf {
-class EventCounter
+/// Aligned to cache lines, since event counters of different threads are often stored next to each other.
+class alignas(64U) EventCounter
 {
   friend class MultiEventCounterBase;
+  friend class CounterTimeSeries;
 
 private:
   class Event
@@ -49,6 +54,11 @@ private:
     [[nodiscard]] std::uint8_t in_group_id() const noexcept { return _in_group_id; }
 
     void is_hidden(const bool is_hidden) noexcept { _is_hidden = is_hidden; }
+    void position(const std::uint8_t group_id, const std::uint8_t in_group_id) noexcept
+    {
+      _group_id = group_id;
+      _in_group_id = in_group_id;
+    }
 
   private:
     std::string_view _name;
@@ -65,9 +75,16 @@ public:
   {
   }
   EventCounter(EventCounter&&) noexcept = default;
-  EventCounter(const EventCounter&) = default;
 
-  ~EventCounter() = default;
+  /**
+   * Copies the configuration and the added counters; the copy is not opened, even if the copied counter is (opened
+   * counters are bound to their file descriptors, which are closed by the owning EventCounter only).
+   *
+   * @param other EventCounter to copy.
+   */
+  EventCounter(const EventCounter& other);
+
+  ~EventCounter() { close(); }
 
   /**
    * Add the specified counter to the list of monitored performance counters.
@@ -106,25 +123,78 @@ public:
   bool add(const std::vector<std::string>& counter_names);
 
   /**
-   * Opens and starts recording performance counters.
+   * Opens the performance counters without starting them. When opened explicitly, the counters can be started and
+   * stopped multiple times (each only enabling and disabling the counters) until close() is called; the results are
+   * accumulated over all intervals.
+   */
+  void open();
+
+  /**
+   * Starts recording performance counters. Opens the counters if they were not opened before.
    *
    * @return True, of the performance counters could be started.
    */
   bool start();
 
   /**
-   * Stops and closes recording performance counters.
+   * Stops recording performance counters. If the counters were not opened explicitly via open(), they are closed.
    */
   void stop();
 
   /**
-   * Returns the result of the performance measurement.
+   * Closes the performance counters. The results stay accessible until the counters are opened again.
+   */
+  void close();
+
+  /**
+   * Returns the result of the performance measurement, accumulated over all intervals (start/stop) since opening.
    *
    * @param normalization Normalization value, default = 1.
    * @return List of counter names and values.
    */
   [[nodiscard]] CounterResult result(std::uint64_t normalization = 1U) const;
 
+  /**
+   * Returns the result of the last interval between start() and stop().
+   *
+   * @param normalization Normalization value, default = 1.
+   * @return List of counter names and values.
+   */
+  [[nodiscard]] CounterResult interval_result(std::uint64_t normalization = 1U) const;
+
+  /**
+   * Returns the result of the performance measurement up to now, without stopping the counters.
+   * The counters need to be started. Reading is cheap if the counters are read from user-level (see
+   * perf::Config::user_level_read()), allowing live results at a fine granularity.
+   *
+   * @param normalization Normalization value, default = 1.
+   * @return List of counter names and values.
+   */
+  [[nodiscard]] CounterResult live_result(std::uint64_t normalization = 1U) const;
+
+  /**
+   * Reads the current values of all hardware events (including hidden ones, in the order they were added) without
+   * stopping the counters and without building a result. Together with to_result(), this allows to build results
+   * from differences between two reads, e.g., when measuring many small code regions.
+   *
+   * @param hardware_event_values Buffer for one value per hardware event (see count_hardware_events()).
+   * @return True, if the counters are started and could be read.
+   */
+  [[nodiscard]] bool live_values(std::vector<double>& hardware_event_values) const;
+
+  /**
+   * Builds the result of all requested counters and metrics from values as read by live_values().
+   *
+   * @param hardware_event_values One value per hardware event, in the order of live_values().
+   * @return List of counter names and values.
+   */
+  [[nodiscard]] CounterResult to_result(const std::vector<double>& hardware_event_values) const;
+
+  /**
+   * @return Number of hardware events (including those only required by metrics) measured by the counter.
+   */
+  [[nodiscard]] std::size_t count_hardware_events() const noexcept;
+
   /**
    * @return Configuration of the counter.
    */
@@ -148,6 +218,15 @@ private:
   /// Real counters to measure.
   std::vector<Group> _groups;
 
+  /// Flag if the counters are opened.
+  bool _is_opened{ false };
+
+  /// Flag if the counters were opened by start() and need to be closed by stop().
+  bool _is_close_on_stop{ false };
+
+  /// Flag if the counters are started.
+  bool _is_started{ false };
+
   /**
    * Add the specified counter to the list of monitored performance counters.
    * The counters must exist within the counter definitions.
@@ -158,6 +237,19 @@ private:
    * @return True, if the counter was added.
    */
   void add(std::string_view counter_name, CounterConfig counter, bool is_hidden);
+
+  /**
+   * Distributes all hardware events into as few groups as the PMU can schedule at once (see Config::pack_groups()).
+   */
+  void pack_groups();
+
+  /**
+   * Builds the result of all requested counters and metrics from the given hardware-event values.
+   *
+   * @param hardware_event_values List of (normalized) values of all hardware events, including hidden ones.
+   * @return List of counter names and values.
+   */
+  [[nodiscard]] CounterResult to_result(std::vector<std::pair<std::string_view, double>>&& hardware_event_values) const;
 };
 
 class MultiEventCounterBase
@@ -172,6 +264,15 @@ protected:
 
   [[nodiscard]] static CounterResult result(const std::vector<EventCounter>& event_counter,
                                             std::uint64_t normalization = 1U);
+
+  /**
+   * Writes the accumulated values of all hardware events (in the order of EventCounter::live_values()) of the given
+   * event counter.
+   *
+   * @param event_counter Event counter to read the values from.
+   * @param hardware_event_values Buffer for one value per hardware event.
+   */
+  static void accumulated_values(const EventCounter& event_counter, double* hardware_event_values) noexcept;
 };
 
 /**
@@ -246,6 +347,16 @@ public:
    */
   bool start(std::uint16_t thread_id) { return this->_thread_local_counter[thread_id].start(); }
 
+  /**
+   * Returns the id of the calling thread, registering the thread on its first call: Threads (e.g., workers of a thread
+   * pool) claim the next unused id instead of choosing one. When a registered thread exits, its counters are
+   * stopped and closed; the results are kept. Ids of exited threads are not handed out again, num_threads limits the
+   * number of threads that can register. Registered ids should not be mixed with ids chosen by the caller.
+   *
+   * @return Id of the calling thread.
+   */
+  [[nodiscard]] std::uint16_t local_thread_id() { return std::uint16_t(this->_thread_registry.slot()); }
+
   /**
    * Stops and closes recording performance counters.
    *
@@ -287,6 +398,14 @@ public:
 
 private:
   std::vector<perf::EventCounter> _thread_local_counter;
+
+  /// Assigns ids to threads calling local_thread_id(); must be destroyed before the counters.
+  ThreadRegistry _thread_registry;
+
+  /**
+   * Creates the registry, retiring the counters of exiting threads.
+   */
+  void initialize_thread_registry();
 };
 
 using EventCounterMT = MultiThreadEventCounter;
@@ -385,7 +504,11 @@ private:
 /**
  * Wrapper for EventCounter to record counters on different CPU cores.
  * CPU ids have to be specified. The counter can be started/stopped at once.
- * The results will be aggregated.
+ * The results will be aggregated, or broken down per CPU or per socket.
+ *
+ * For system-wide counting, the counters of all CPUs can be opened, started, stopped, and read in parallel by a set
+ * of reader threads (see reader_threads()), which keeps the skew between the CPUs low; counters of other CPUs can only
+ * be read via read() system calls (not via rdpmc).
  */
 class MultiCoreEventCounter final : private MultiEventCounterBase
 {
@@ -401,7 +524,13 @@ public:
   {
   }
 
-  ~MultiCoreEventCounter() = default;
+  MultiCoreEventCounter(MultiCoreEventCounter&&) noexcept;
+  MultiCoreEventCounter(const MultiCoreEventCounter&) = delete;
+
+  ~MultiCoreEventCounter();
+
+  MultiCoreEventCounter& operator=(MultiCoreEventCounter&&) noexcept;
+  MultiCoreEventCounter& operator=(const MultiCoreEventCounter&) = delete;
 
   /**
    * Add the specified counter to the list of monitored performance counters.
@@ -449,17 +578,38 @@ public:
   }
 
   /**
-   * Opens and starts recording performance counters for the given thread.
+   * Sets the number of threads (including the calling thread) that open, start, stop, and read the counters of the
+   * CPUs in parallel; every thread handles a contiguous range of CPUs. The threads are kept alive until the counters
+   * are closed, such that periodic reads (e.g., via live_values()) do not spawn threads.
+   *
+   * @param count_threads Number of reader threads; one reads all CPUs on the calling thread (default).
+   */
+  void reader_threads(std::uint16_t count_threads);
+
+  /**
+   * Opens the counters of all CPUs without starting them (see EventCounter::open()). When opened explicitly, the
+   * counters can be started and stopped multiple times until close() is called.
+   */
+  void open();
+
+  /**
+   * Opens (if not opened explicitly via open()) and starts recording performance counters on all CPUs. All counters
+   * are opened before any is enabled, such that the counters of all CPUs start nearly simultaneously.
    *
    * @return True, of the performance counters could be started.
    */
   bool start();
 
   /**
-   * Stops and closes recording performance counters.
+   * Stops recording performance counters on all CPUs and closes them, if they were not opened explicitly via open().
    */
   void stop();
 
+  /**
+   * Closes the counters of all CPUs and releases the reader threads. The results stay accessible.
+   */
+  void close();
+
   /**
    * Returns the result of the performance measurement.
    *
@@ -471,7 +621,137 @@ public:
     return MultiEventCounterBase::result(_cpu_local_counter, normalization);
   }
 
+  /**
+   * Returns the result of the performance measurement per CPU.
+   *
+   * @param normalization Normalization value, default = 1.
+   * @return One result per CPU, in the order of cpu_ids().
+   */
+  [[nodiscard]] std::vector<CounterResult> result_per_cpu(std::uint64_t normalization = 1U) const;
+
+  /**
+   * Returns the result of the performance measurement per socket (physical package).
+   *
+   * @param normalization Normalization value, default = 1.
+   * @return One result per socket that holds at least one of the CPUs, as pairs of socket id and result.
+   */
+  [[nodiscard]] std::vector<std::pair<std::uint16_t, CounterResult>> result_per_socket(
+    std::uint64_t normalization = 1U) const;
+
+  /**
+   * Reads the current values of all hardware events on all CPUs in parallel (see reader_threads()) without stopping
+   * the counters. The values of the CPUs are stored one after another, i.e., the value of hardware event e on the
+   * c-th CPU is located at index c * count_hardware_events() + e. Building results from the differences of two reads
+   * (see to_result()) yields per-interval values.
+   *
+   * @param hardware_event_values Buffer for the values of all CPUs; resized if needed.
+   * @return True, if the counters are started and could be read on all CPUs.
+   */
+  [[nodiscard]] bool live_values(std::vector<double>& hardware_event_values);
+
+  /**
+   * Returns the result of the performance measurement up to now, aggregated over all CPUs, without stopping the
+   * counters.
+   *
+   * @param normalization Normalization value, default = 1.
+   * @return List of counter names and values.
+   */
+  [[nodiscard]] CounterResult live_result(std::uint64_t normalization = 1U);
+
+  /**
+   * Builds the result of all requested counters and metrics, aggregated over all CPUs, from values as read by
+   * live_values(). Values are summed by index; names are only resolved once for the aggregated values.
+   *
+   * @param hardware_event_values Values of all CPUs, in the layout of live_values().
+   * @param normalization Normalization value, default = 1.
+   * @return List of counter names and values.
+   */
+  [[nodiscard]] CounterResult to_result(const std::vector<double>& hardware_event_values,
+                                        std::uint64_t normalization = 1U) const;
+
+  /**
+   * Builds the results per CPU from values as read by live_values().
+   *
+   * @param hardware_event_values Values of all CPUs, in the layout of live_values().
+   * @param normalization Normalization value, default = 1.
+   * @return One result per CPU, in the order of cpu_ids().
+   */
+  [[nodiscard]] std::vector<CounterResult> to_result_per_cpu(const std::vector<double>& hardware_event_values,
+                                                             std::uint64_t normalization = 1U) const;
+
+  /**
+   * Builds the results per socket (physical package) from values as read by live_values().
+   *
+   * @param hardware_event_values Values of all CPUs, in the layout of live_values().
+   * @param normalization Normalization value, default = 1.
+   * @return One result per socket that holds at least one of the CPUs, as pairs of socket id and result.
+   */
+  [[nodiscard]] std::vector<std::pair<std::uint16_t, CounterResult>> to_result_per_socket(
+    const std::vector<double>& hardware_event_values,
+    std::uint64_t normalization = 1U) const;
+
+  /**
+   * @return Number of hardware events (including those only required by metrics) measured per CPU.
+   */
+  [[nodiscard]] std::size_t count_hardware_events() const noexcept
+  {
+    return _cpu_local_counter.front().count_hardware_events();
+  }
+
+  /**
+   * @return Ids of the recorded CPUs.
+   */
+  [[nodiscard]] const std::vector<std::uint16_t>& cpu_ids() const noexcept { return _cpu_ids; }
+
+  /**
+   * @return Id of the socket (physical package) of every recorded CPU, in the order of cpu_ids().
+   */
+  [[nodiscard]] const std::vector<std::uint16_t>& socket_ids() const noexcept { return _socket_ids; }
+
 private:
+  /// Threads that process the CPUs in parallel.
+  class ReaderPool;
+
   std::vector<perf::EventCounter> _cpu_local_counter;
+
+  /// Ids of the recorded CPUs and their sockets.
+  std::vector<std::uint16_t> _cpu_ids;
+  std::vector<std::uint16_t> _socket_ids;
+
+  /// Number of threads that process the CPUs in parallel (including the calling thread).
+  std::uint16_t _count_reader_threads{ 1U };
+
+  /// Reader threads, created on first use and released when closing.
+  std::unique_ptr<ReaderPool> _reader_pool;
+
+  /// Buffers for reading the values of every CPU.
+  std::vector<std::vector<double>> _cpu_values;
+
+  /// Flag if the counters are opened.
+  bool _is_opened{ false };
+
+  /// Flag if the counters were opened by start() and need to be closed by stop().
+  bool _is_close_on_stop{ false };
+
+  /**
+   * Invokes the callback for every CPU (by index), in parallel if more than one reader thread is requested. If the
+   * callback throws an exception for any CPU, the exception is re-thrown after all reader threads finished.
+   *
+   * @param callback Callback that is invoked with the index of every CPU.
+   */
+  void for_each_cpu(const std::function<void(std::size_t)>& callback);
+
+  /**
+   * @return Values of all hardware events of all CPUs accumulated until the counters were stopped.
+   */
+  [[nodiscard]] std::vector<double> accumulated_values() const;
+
+  /**
+   * Reads the socket (physical package) of the given CPU from the kernel.
+   *
+   * @param cpu_id Id of the CPU.
+   * @return Id of the socket; zero if unknown.
+   */
+  [[nodiscard]] static std::uint16_t socket_of_cpu(std::uint16_t cpu_id);
 };
 }
\ No newline at end of file
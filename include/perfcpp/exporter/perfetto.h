@@ -0,0 +1,176 @@
+#pragma once
+
+#include "protobuf.h"
+#include <cstdint>
+#include <optional>
+#include <perfcpp/counter_time_series.h>
+#include <perfcpp/sample.h>
+#include <perfcpp/sample_view.h>
+#include <perfcpp/symbolizer.h>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace perf::exporter {
+/**
+ * The PerfettoExporter streams samples into a trace in the protobuf format of Perfetto (https://perfetto.dev), which
+ * can be opened in the Perfetto UI (https://ui.perfetto.dev) or queried with the trace processor:
+ * samples are written as instant events on the track of their thread (annotated with the instruction pointer,
+ * addresses, latency, and CPU), context switches as "running" slices of the thread, and counter values (e.g., of a
+ * perf::CounterTimeSeries) as counter tracks. Every packet is written when it is added (through a buffered file),
+ * such that the exporter can consume the samples while draining the sampler without keeping them in memory.
+ * Timestamps are written as recorded (e.g., by the perf clock, see Sampler::Values::time()).
+ */
+class PerfettoExporter
+{
+public:
+  /**
+   * Creates (or truncates) the trace file.
+   *
+   * @param file_name Name of the trace file.
+   * @param symbolizer Symbolizer to name sample events by the function of the instruction pointer; may be nullptr.
+   */
+  explicit PerfettoExporter(const std::string& file_name, Symbolizer* symbolizer = nullptr);
+  PerfettoExporter(PerfettoExporter&&) = delete;
+  PerfettoExporter(const PerfettoExporter&) = delete;
+
+  /**
+   * Closes the exporter (see close()); write errors are ignored.
+   */
+  ~PerfettoExporter();
+
+  PerfettoExporter& operator=(PerfettoExporter&&) = delete;
+  PerfettoExporter& operator=(const PerfettoExporter&) = delete;
+
+  /**
+   * Writes the sample (directly from the buffer, e.g., within Sampler::drain()) as an instant event. Samples without
+   * timestamp are skipped.
+   *
+   * @param sample Sample to write.
+   */
+  void add(const SampleView& sample) { add_sample(sample); }
+
+  /**
+   * Writes the sample as an instant event or, if the sample is a context switch, as the begin or end of a "running"
+   * slice on the thread's track. Samples without timestamp are skipped.
+   *
+   * @param sample Sample to write.
+   */
+  void add(const Sample& sample);
+
+  /**
+   * Writes all given samples (see add(const Sample&)).
+   *
+   * @param samples Samples to write.
+   */
+  void add(const std::vector<Sample>& samples)
+  {
+    for (const auto& sample : samples) {
+      add(sample);
+    }
+  }
+
+  /**
+   * Writes a value of the counter track with the given name (the track is created with the first value).
+   *
+   * @param name Name of the counter track.
+   * @param time Timestamp of the value in nanoseconds.
+   * @param value Value of the counter.
+   */
+  void add_counter(std::string_view name, std::uint64_t time, double value);
+
+  /**
+   * Writes all counters and metrics of the given time series as counter tracks; every value is written at the begin
+   * of its interval.
+   *
+   * @param intervals Intervals of a perf::CounterTimeSeries (see CounterTimeSeries::result()).
+   * @param time_offset Timestamp (in nanoseconds) the time series was started at, added to the (relative) times of
+   * the intervals.
+   */
+  void add(const std::vector<CounterTimeSeries::Interval>& intervals, std::uint64_t time_offset = 0U);
+
+  /**
+   * Ends all open "running" slices at the last written timestamp and closes the file. Throws a std::runtime_error if
+   * the file cannot be written.
+   */
+  void close();
+
+  /**
+   * @return Number of bytes written to the trace.
+   */
+  [[nodiscard]] std::uint64_t size() const noexcept { return _file.size(); }
+
+private:
+  /// Sequence all packets are written on.
+  constexpr static inline auto SEQUENCE_ID = std::uint32_t{ 1U };
+
+  /// Track of samples without thread id.
+  constexpr static inline auto GLOBAL_TRACK_UUID = std::uint64_t{ 1U };
+
+  /// Prefixes of the track uuids (in the upper byte) for processes, threads, and counters.
+  constexpr static inline auto PROCESS_TRACK_PREFIX = std::uint64_t{ 1U } << 56U;
+  constexpr static inline auto THREAD_TRACK_PREFIX = std::uint64_t{ 2U } << 56U;
+  constexpr static inline auto COUNTER_TRACK_PREFIX = std::uint64_t{ 3U } << 56U;
+
+  /// Types of track events.
+  constexpr static inline auto TYPE_SLICE_BEGIN = std::uint64_t{ 1U };
+  constexpr static inline auto TYPE_SLICE_END = std::uint64_t{ 2U };
+  constexpr static inline auto TYPE_INSTANT = std::uint64_t{ 3U };
+  constexpr static inline auto TYPE_COUNTER = std::uint64_t{ 4U };
+
+  ProtobufFile _file;
+  Symbolizer* _symbolizer;
+
+  /// Flag if the first packet (which clears the incremental state of the sequence) was written.
+  bool _is_first_packet_written{ false };
+
+  /// Tracks whose descriptors were written.
+  std::unordered_set<std::uint64_t> _tracks;
+
+  /// Threads with an open "running" slice.
+  std::unordered_set<std::uint64_t> _running_threads;
+
+  /// Uuids of the counter tracks by their name.
+  std::unordered_map<std::string, std::uint64_t> _counter_tracks;
+
+  /// Last written timestamp.
+  std::uint64_t _last_time{ 0U };
+
+  /// Messages reused for every packet to avoid allocations.
+  ProtobufMessage _packet;
+  ProtobufMessage _event;
+  ProtobufMessage _annotation;
+
+  template<typename S>
+  void add_sample(const S& sample);
+
+  /**
+   * Writes the descriptor of the thread's track (and the track of its process) if not already written.
+   *
+   * @return Uuid of the track.
+   */
+  std::uint64_t thread_track(std::optional<std::uint32_t> process_id, std::optional<std::uint32_t> thread_id);
+
+  /**
+   * Adds a debug annotation with the given name and value to the current event.
+   */
+  void annotate(std::string_view name, std::uint64_t value, bool is_pointer);
+
+  /**
+   * Writes the current event as a packet at the given time.
+   */
+  void write_event(std::uint64_t time);
+
+  /**
+   * Writes the given track descriptor as a packet.
+   */
+  void write_track_descriptor(const ProtobufMessage& track_descriptor);
+
+  /**
+   * Writes the packet, adding the sequence id (and, for the first packet, the flag to clear the incremental state).
+   */
+  void write_packet();
+};
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "protobuf.h"
+#include <cstdint>
+#include <optional>
+#include <perfcpp/sample.h>
+#include <perfcpp/sample_view.h>
+#include <perfcpp/symbolizer.h>
+#include <perfcpp/time_conversion.h>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace perf::exporter {
+/**
+ * The PprofExporter aggregates the callchains (or instruction pointers, if no callchain was sampled) of samples into a
+ * profile in the protobuf format of pprof (https://github.com/google/pprof), which can be read by `pprof`,
+ * `go tool pprof`, and many profile viewers. Samples are consumed incrementally (e.g., while draining the sampler);
+ * only the distinct callchains with their number of samples and summed periods are kept in memory. The profile is
+ * written (uncompressed, which pprof accepts) when the exporter is closed. The start time of the profile is converted
+ * from the perf clock into the wall clock if a time conversion is set (see time_conversion()).
+ */
+class PprofExporter
+{
+public:
+  /**
+   * Creates (or truncates) the profile file.
+   *
+   * @param file_name Name of the profile file.
+   * @param symbolizer Symbolizer to resolve addresses into functions; may be nullptr (pprof can symbolize addresses
+   * itself, e.g., via --symbolize).
+   * @param event_name Name of the sampled event, used as type of the summed periods (e.g., "cycles").
+   */
+  explicit PprofExporter(const std::string& file_name,
+                         Symbolizer* symbolizer = nullptr,
+                         std::string event_name = "events");
+  PprofExporter(PprofExporter&&) = delete;
+  PprofExporter(const PprofExporter&) = delete;
+
+  /**
+   * Closes the exporter (see close()); write errors are ignored.
+   */
+  ~PprofExporter();
+
+  PprofExporter& operator=(PprofExporter&&) = delete;
+  PprofExporter& operator=(const PprofExporter&) = delete;
+
+  /**
+   * Adds the callchain of the given sample (directly from the buffer, e.g., within Sampler::drain()).
+   *
+   * @param sample Sample to add.
+   */
+  void add(const SampleView& sample) { add_sample(sample); }
+
+  /**
+   * Adds the callchain of the given sample.
+   *
+   * @param sample Sample to add.
+   */
+  void add(const Sample& sample) { add_sample(sample); }
+
+  /**
+   * Sets the conversion of perf timestamps into the system clock (see Sampler::time_conversion()), used to write the
+   * start of the profile as wall-clock time. Without a conversion, the profile only states the duration.
+   *
+   * @param time_conversion Conversion of perf timestamps.
+   */
+  void time_conversion(const TimeConversion& time_conversion) { _time_conversion = time_conversion; }
+
+  /**
+   * @return Number of added samples.
+   */
+  [[nodiscard]] std::uint64_t count_samples() const noexcept { return _count_samples; }
+
+  /**
+   * @return Number of distinct callchains (per process).
+   */
+  [[nodiscard]] std::size_t count_stacks() const noexcept { return _stacks.size(); }
+
+  /**
+   * Writes the profile and closes the file; later samples are ignored. Throws a std::runtime_error if the file cannot
+   * be written.
+   */
+  void close();
+
+private:
+  /// Callchain of a process; the same addresses in different processes may belong to different code.
+  using StackKey = std::pair<std::uint32_t, std::vector<std::uintptr_t>>;
+
+  /// Values aggregated per callchain.
+  struct Stack
+  {
+    std::uint64_t count_samples;
+    std::uint64_t sum_periods;
+  };
+
+  struct StackHash
+  {
+    std::size_t operator()(const StackKey& key) const noexcept
+    {
+      auto hash = (std::uint64_t{ 0xCBF29CE484222325ULL } ^ key.first) * 0x100000001B3ULL;
+      for (const auto address : key.second) {
+        hash = (hash ^ address) * 0x100000001B3ULL;
+      }
+      return std::size_t(hash);
+    }
+  };
+
+  /// Address within a process, identifying a location.
+  using LocationKey = std::pair<std::uint32_t, std::uintptr_t>;
+
+  struct LocationHash
+  {
+    std::size_t operator()(const LocationKey& key) const noexcept
+    {
+      return std::size_t((key.second ^ (std::uint64_t{ key.first } << 48U)) * 0x9E3779B97F4A7C15ULL);
+    }
+  };
+
+  ProtobufFile _file;
+  Symbolizer* _symbolizer;
+  std::string _event_name;
+  bool _is_closed{ false };
+
+  std::uint64_t _count_samples{ 0U };
+  std::uint64_t _first_time{ 0U };
+  std::uint64_t _last_time{ 0U };
+  std::optional<TimeConversion> _time_conversion;
+
+  /// Distinct callchains (process id and addresses, leaf first).
+  std::unordered_map<StackKey, Stack, StackHash> _stacks;
+
+  /// Process id and callchain of the current sample, reused to avoid allocations.
+  StackKey _stack_key;
+
+  template<typename S>
+  void add_sample(const S& sample);
+
+  /**
+   * Adds the string to the string table (if not already present).
+   *
+   * @return Index of the string in the table.
+   */
+  static std::uint64_t string_id(std::vector<std::string>& strings,
+                                 std::unordered_map<std::string, std::uint64_t>& string_ids,
+                                 std::string_view string);
+};
+}
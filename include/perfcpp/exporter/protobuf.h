@@ -0,0 +1,193 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace perf::exporter {
+/**
+ * Minimal encoder of protocol buffer messages (varints, 64-bit values, and length-delimited fields), sufficient to
+ * write the trace and profile formats of the exporters without depending on the protobuf library. Nested messages
+ * are encoded into their own ProtobufMessage and appended to the parent.
+ */
+class ProtobufMessage
+{
+public:
+  ProtobufMessage() = default;
+  ~ProtobufMessage() = default;
+
+  /**
+   * Appends a varint field (int32, int64, uint32, uint64, bool, enum).
+   */
+  ProtobufMessage& varint(const std::uint32_t field, const std::uint64_t value)
+  {
+    tag(field, WireType::Varint);
+    raw_varint(value);
+    return *this;
+  }
+
+  /**
+   * Appends a double field.
+   */
+  ProtobufMessage& float64(const std::uint32_t field, const double value)
+  {
+    tag(field, WireType::Fixed64);
+    auto bits = std::uint64_t{ 0U };
+    std::memcpy(&bits, &value, sizeof(double));
+    for (auto byte = 0U; byte < sizeof(std::uint64_t); ++byte) {
+      _data.push_back(std::uint8_t(bits >> (byte * 8U)));
+    }
+    return *this;
+  }
+
+  /**
+   * Appends a string (or bytes) field.
+   */
+  ProtobufMessage& string(const std::uint32_t field, const std::string_view value)
+  {
+    tag(field, WireType::LengthDelimited);
+    raw_varint(value.size());
+    _data.insert(_data.end(), value.begin(), value.end());
+    return *this;
+  }
+
+  /**
+   * Appends a nested message.
+   */
+  ProtobufMessage& message(const std::uint32_t field, const ProtobufMessage& message)
+  {
+    tag(field, WireType::LengthDelimited);
+    raw_varint(message._data.size());
+    _data.insert(_data.end(), message._data.begin(), message._data.end());
+    return *this;
+  }
+
+  /**
+   * Appends a packed repeated varint field.
+   */
+  template<typename T>
+  ProtobufMessage& packed_varints(const std::uint32_t field, const std::vector<T>& values)
+  {
+    if (values.empty()) {
+      return *this;
+    }
+
+    auto packed = ProtobufMessage{};
+    for (const auto value : values) {
+      packed.raw_varint(std::uint64_t(value));
+    }
+
+    tag(field, WireType::LengthDelimited);
+    raw_varint(packed._data.size());
+    _data.insert(_data.end(), packed._data.begin(), packed._data.end());
+    return *this;
+  }
+
+  /**
+   * Appends the fields of the given message (at the same level).
+   */
+  ProtobufMessage& append(const ProtobufMessage& message)
+  {
+    _data.insert(_data.end(), message._data.begin(), message._data.end());
+    return *this;
+  }
+
+  [[nodiscard]] const std::vector<std::uint8_t>& data() const noexcept { return _data; }
+  [[nodiscard]] bool empty() const noexcept { return _data.empty(); }
+
+  /**
+   * Removes the content but keeps the allocated memory for reuse.
+   */
+  void clear() noexcept { _data.clear(); }
+
+private:
+  enum WireType : std::uint8_t
+  {
+    Varint = 0U,
+    Fixed64 = 1U,
+    LengthDelimited = 2U
+  };
+
+  std::vector<std::uint8_t> _data;
+
+  void tag(const std::uint32_t field, const WireType wire_type)
+  {
+    raw_varint((std::uint64_t{ field } << 3U) | wire_type);
+  }
+
+  void raw_varint(std::uint64_t value)
+  {
+    while (value >= 0x80U) {
+      _data.push_back(std::uint8_t(value | 0x80U));
+      value >>= 7U;
+    }
+    _data.push_back(std::uint8_t(value));
+  }
+};
+
+/**
+ * File that top-level fields of a protocol buffer message are streamed into. Fields are collected in a buffer that is
+ * written to the file whenever it exceeds the buffer size, such that arbitrarily large messages can be written with
+ * bounded memory.
+ */
+class ProtobufFile
+{
+public:
+  /**
+   * Creates (or truncates) the file; throws if the file cannot be created.
+   *
+   * @param file_name Name of the file.
+   * @param buffer_size Number of bytes buffered before writing to the file.
+   */
+  explicit ProtobufFile(const std::string& file_name, std::size_t buffer_size = std::size_t{ 1U } << 20U);
+  ProtobufFile(ProtobufFile&&) = delete;
+  ProtobufFile(const ProtobufFile&) = delete;
+
+  /**
+   * Closes the file; write errors are ignored (call close() to observe them).
+   */
+  ~ProtobufFile();
+
+  ProtobufFile& operator=(ProtobufFile&&) = delete;
+  ProtobufFile& operator=(const ProtobufFile&) = delete;
+
+  /**
+   * Appends the message as a (length-delimited) top-level field.
+   *
+   * @param field Number of the field.
+   * @param message Message to write.
+   */
+  void write(std::uint32_t field, const ProtobufMessage& message);
+
+  /**
+   * Appends the fields of the message as top-level fields.
+   *
+   * @param message Fields to write.
+   */
+  void append(const ProtobufMessage& message);
+
+  /**
+   * Writes the buffer to the file; throws a std::runtime_error if the file cannot be written.
+   */
+  void flush();
+
+  /**
+   * Flushes the buffer and closes the file; throws a std::runtime_error if the buffer cannot be written (the file is
+   * closed anyway).
+   */
+  void close();
+
+  /**
+   * @return Number of bytes written (including the buffer).
+   */
+  [[nodiscard]] std::uint64_t size() const noexcept { return _size; }
+
+private:
+  std::int32_t _file_descriptor{ -1 };
+  std::size_t _buffer_size;
+  ProtobufMessage _buffer;
+  std::uint64_t _size{ 0U };
+};
+}
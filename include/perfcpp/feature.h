@@ -29,6 +29,10 @@
 #define PERFCPP_NO_SAMPLE_PHYS_ADDR
 #endif
 
+#if LINUX_VERSION_CODE < KERNEL_VERSION(4, 14, 0)
+#define PERFCPP_NO_SAMPLE_BRANCH_TYPE
+#endif
+
 #if LINUX_VERSION_CODE < KERNEL_VERSION(4, 17, 0)
 #define PERFCPP_NO_RECORD_MISC_SWITCH_OUT_PREEMPT
 #endif
@@ -38,6 +42,10 @@
 #define PERFCPP_NO_SAMPLE_CGROUP
 #endif
 
+#if LINUX_VERSION_CODE < KERNEL_VERSION(5, 9, 0)
+#define PERFCPP_NO_USER_TIME_SHORT
+#endif
+
 #if LINUX_VERSION_CODE < KERNEL_VERSION(5, 11, 0)
 #define PERFCPP_NO_SAMPLE_DATA_PAGE_SIZE
 #define PERFCPP_NO_SAMPLE_CODE_PAGE_SIZE
@@ -45,6 +53,7 @@
 
 #if LINUX_VERSION_CODE < KERNEL_VERSION(5, 12, 0)
 #define PERFCPP_NO_SAMPLE_WEIGHT_STRUCT
+#define PERFCPP_NO_RECORD_MMAP_BUILD_ID
 #endif
 
 #if LINUX_VERSION_CODE < KERNEL_VERSION(5, 13, 0)
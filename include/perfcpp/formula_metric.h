@@ -0,0 +1,167 @@
+#pragma once
+
+#include "counter.h"
+#include "metric.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace perf {
+/**
+ * Metric defined by an arithmetic formula over counters, e.g., "instructions / cycles".
+ * The formula is parsed once and compiled into a sequence of stack instructions over the required counters; counters
+ * are referenced by their position (slot) in required_counter_names(), not by name.
+ *
+ * Formulas consist of counter names, numbers, parentheses, and the operators +, -, *, and /. Since counter names may
+ * contain hyphens (e.g., "L1-dcache-loads"), a subtraction needs whitespace around the operator ("a - b"; "a-b" is
+ * the counter named "a-b").
+ */
+class FormulaMetric final : public Metric
+{
+public:
+  /// Maximal depth of the evaluation stack and maximal nesting of parentheses and negations in the formula.
+  constexpr static inline auto MAX_STACK_DEPTH = std::size_t{ 32U };
+
+  /// Maximal number of distinct counters per formula.
+  constexpr static inline auto MAX_COUNTERS = std::size_t{ 64U };
+
+  /**
+   * Parses and compiles the formula. Throws a std::runtime_error if the formula is invalid.
+   *
+   * @param name Name of the metric.
+   * @param formula Formula of the metric.
+   */
+  FormulaMetric(std::string name, std::string_view formula);
+  ~FormulaMetric() override = default;
+
+  [[nodiscard]] std::string name() const override { return _name; }
+  [[nodiscard]] std::vector<std::string> required_counter_names() const override { return _counter_names; }
+
+  /**
+   * @return The formula as given when creating the metric.
+   */
+  [[nodiscard]] const std::string& formula() const noexcept { return _formula; }
+
+  /**
+   * Calculates the metric from a single result.
+   *
+   * @param result Result holding all required counters.
+   * @return Value of the metric, or std::nullopt if any required counter is missing.
+   */
+  [[nodiscard]] std::optional<double> calculate(const CounterResult& result) const override;
+
+  /**
+   * Calculates the metric for many results at once (e.g., intervals of a time series, results of threads, or results
+   * of samples). Positions of the counters are resolved once and reused as long as the results share their layout.
+   *
+   * @param begin Iterator to the first element.
+   * @param end Iterator behind the last element.
+   * @param to_result Callable translating an element to a const CounterResult* (nullptr if the element has none).
+   * @return One value per element, std::nullopt for elements missing a required counter.
+   */
+  template<typename Iterator, typename F>
+  [[nodiscard]] std::vector<std::optional<double>> calculate(Iterator begin, Iterator end, F&& to_result) const
+  {
+    auto columns = std::vector<std::vector<double>>(_counter_names.size());
+    auto is_valid = std::vector<bool>{};
+    auto slots = std::vector<std::optional<std::size_t>>(_counter_names.size(), std::nullopt);
+
+    for (auto iterator = begin; iterator != end; ++iterator) {
+      const CounterResult* result = to_result(*iterator);
+      is_valid.push_back(result != nullptr && gather(*result, slots, columns));
+    }
+
+    const auto values = evaluate(columns, is_valid.size());
+
+    auto result = std::vector<std::optional<double>>{};
+    result.reserve(values.size());
+    for (auto i = 0U; i < values.size(); ++i) {
+      result.push_back(is_valid[i] ? std::make_optional(values[i]) : std::nullopt);
+    }
+
+    return result;
+  }
+
+  /**
+   * Calculates the metric for many results at once.
+   *
+   * @param results List of results.
+   * @return One value per result, std::nullopt for results missing a required counter.
+   */
+  [[nodiscard]] std::vector<std::optional<double>> calculate(const std::vector<CounterResult>& results) const
+  {
+    return calculate(results.begin(), results.end(), [](const CounterResult& result) { return &result; });
+  }
+
+  /**
+   * Evaluates the formula over columns of counter values: columns[i] holds the values of the i-th counter of
+   * required_counter_names(), all columns have the same length. The formula is evaluated block-wise, every
+   * instruction processes a block of values in a tight loop.
+   *
+   * @param columns One column of values per required counter.
+   * @param count_rows Number of rows (i.e., the length of every column).
+   * @return One value of the metric per row.
+   */
+  [[nodiscard]] std::vector<double> evaluate(const std::vector<std::vector<double>>& columns,
+                                             std::size_t count_rows) const;
+
+private:
+  enum class OpCode : std::uint8_t
+  {
+    Constant,
+    Counter,
+    Negate,
+    Add,
+    Subtract,
+    Multiply,
+    Divide
+  };
+
+  struct Instruction
+  {
+    OpCode op_code;
+    std::uint32_t slot;
+    double constant;
+  };
+
+  /// Number of rows evaluated at once by evaluate().
+  constexpr static inline auto BLOCK_SIZE = std::size_t{ 64U };
+
+  /// Marks a counter whose position within results is not yet resolved.
+  constexpr static inline auto UNRESOLVED = std::numeric_limits<std::size_t>::max();
+
+  std::string _name;
+  std::string _formula;
+
+  /// Names of the counters, the position of a name is the slot referenced by instructions.
+  std::vector<std::string> _counter_names;
+
+  /// Instructions in post-fix order.
+  std::vector<Instruction> _instructions;
+
+  /// Positions of the counters resolved by the last call of calculate() for a single result (UNRESOLVED if none yet).
+  /// Atomic, since the metric may be shared by counters of different threads; positions are verified before use.
+  mutable std::array<std::atomic<std::size_t>, MAX_COUNTERS> _resolved_indices;
+
+  /**
+   * Appends the values of the required counters of the result to the columns. Slots resolved for earlier results are
+   * verified and reused.
+   *
+   * @param result Result to read the counters from.
+   * @param slots Positions of the counters within the results, updated if the layout changes.
+   * @param columns Columns to append the values to.
+   * @return True, if the result holds all required counters (otherwise, zeros are appended).
+   */
+  bool gather(const CounterResult& result,
+              std::vector<std::optional<std::size_t>>& slots,
+              std::vector<std::vector<double>>& columns) const;
+
+  /// Recursive-descent parser compiling the formula into instructions.
+  class Parser;
+};
+}
@@ -11,8 +11,8 @@ namespace perf {
 class Group
 {
 public:
-  /// Number of maximal members per group.
-  constexpr static inline auto MAX_MEMBERS = 8U;
+  /// Number of maximal members per group (large enough for Intel's slots event and all eight top-down metric events).
+  constexpr static inline auto MAX_MEMBERS = 12U;
 
   Group() = default;
   Group(Group&&) noexcept = default;
@@ -43,7 +43,9 @@ public:
   void close();
 
   /**
-   * Starts monitoring the counters in the group.
+   * Starts monitoring the counters in the group. The group can be started and stopped multiple times while opened;
+   * the results of all intervals are accumulated. Groups that are read from user-level are enabled only once and
+   * stay enabled until closed; starting and stopping will only read the counters.
    *
    * @return True, if the counters could be started.
    */
@@ -74,6 +76,11 @@ public:
    */
   [[nodiscard]] bool read(CounterReadFormat<MAX_MEMBERS>& value) const;
 
+  /**
+   * @return True, if the counters of the group are read from user-level (via rdpmc) when possible.
+   */
+  [[nodiscard]] bool is_user_level_read() const noexcept { return _is_user_level_read; }
+
   /**
    * @return Number of counters in the group.
    */
@@ -100,6 +107,44 @@ public:
    */
   [[nodiscard]] double get(std::size_t index) const;
 
+  /**
+   * Reads the result of counter at the given index, accumulated over all intervals (start/stop) since opening the
+   * group.
+   *
+   * @param index Index of the counter to read the result for.
+   * @return Accumulated result of the counter.
+   */
+  [[nodiscard]] double accumulated(const std::size_t index) const noexcept
+  {
+    return index < _members.size() ? _accumulated_values[index] : .0;
+  }
+
+  /**
+   * Calculates the result of the counter at the given index from the start value and the given value, which was read
+   * while the group was still running (e.g., for live results).
+   *
+   * @param index Index of the counter to read the result for.
+   * @param value Value read from the running group.
+   * @return Result of the counter.
+   */
+  [[nodiscard]] double get(std::size_t index, const CounterReadFormat<MAX_MEMBERS>& value) const
+  {
+    return get(index, _start_value, value);
+  }
+
+  /**
+   * Calculates the result of the counter at the given index between two values read from the group, including the
+   * multiplexing correction for that interval.
+   *
+   * @param index Index of the counter to read the result for.
+   * @param start_value Value at the begin of the interval.
+   * @param end_value Value at the end of the interval.
+   * @return Result of the counter.
+   */
+  [[nodiscard]] double get(std::size_t index,
+                           const CounterReadFormat<MAX_MEMBERS>& start_value,
+                           const CounterReadFormat<MAX_MEMBERS>& end_value) const;
+
   /**
    * Grants access to the counter at the given index.
    *
@@ -134,6 +179,47 @@ private:
   /// After stopping the group, we calculate the multiplexing correction once from start- and end-values.
   double _multiplexing_correction{};
 
+  /// Results of the counters, accumulated over all intervals since opening the group.
+  std::array<double, Group::MAX_MEMBERS> _accumulated_values{};
+
+  /// Flag if the counters are read from user-level (via rdpmc) when possible.
+  bool _is_user_level_read{ false };
+
+  /// Flag if the group is enabled.
+  bool _is_enabled{ false };
+
+  /**
+   * Reads all counters of the group from user-level (via rdpmc).
+   *
+   * @param value Value to read the counters into.
+   * @return True, if all counters could be read from user-level.
+   */
+  [[nodiscard]] bool read_user_level(CounterReadFormat<MAX_MEMBERS>& value) const noexcept;
+
+  /**
+   * Calculates the result of the counter at the given index from the given start and end values.
+   *
+   * @param index Index of the counter to read the result for.
+   * @param start_value Value at the begin of the measurement.
+   * @param end_value Value at the end of the measurement.
+   * @param multiplexing_correction Correction for multiplexing.
+   * @return Result of the counter.
+   */
+  [[nodiscard]] double get(std::size_t index,
+                           const CounterReadFormat<MAX_MEMBERS>& start_value,
+                           const CounterReadFormat<MAX_MEMBERS>& end_value,
+                           double multiplexing_correction) const;
+
+  /**
+   * Calculates the correction for multiplexing between the given start and end values.
+   *
+   * @param start_value Value at the begin of the measurement.
+   * @param end_value Value at the end of the measurement.
+   * @return Ratio of time enabled and time running; zero if the counters were not running.
+   */
+  [[nodiscard]] static double multiplexing_correction(const CounterReadFormat<MAX_MEMBERS>& start_value,
+                                                      const CounterReadFormat<MAX_MEMBERS>& end_value) noexcept;
+
   /**
    * Reads the value of a specific counter (identified by the given ID) from the provided value set.
    *
@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <optional>
 #include <string>
+#include <string_view>
 #if defined(__x86_64__) || defined(__i386__)
 #include <cpuid.h>
 #endif
@@ -100,6 +101,60 @@ public:
    */
   [[nodiscard]] static std::optional<std::uint32_t> amd_ibs_fetch_type();
 
+  /**
+   * @return The config type of the Arm Statistical Profiling Extension (SPE), if exposed by the kernel.
+   */
+  [[nodiscard]] static std::optional<std::uint32_t> arm_spe_type();
+
+  /**
+   * @return The config type of Intel Processor Trace (PT), if exposed by the kernel.
+   */
+  [[nodiscard]] static std::optional<std::uint32_t> intel_pt_type();
+
+  /**
+   * @return Number of general-purpose counters of the core PMU (per hardware thread), std::nullopt if not detectable.
+   */
+  [[nodiscard]] static std::optional<std::uint8_t> count_general_purpose_counters() noexcept;
+
+  /**
+   * @return Number of fixed-function counters of the core PMU (Intel only; 0 otherwise).
+   */
+  [[nodiscard]] static std::uint8_t count_fixed_counters() noexcept;
+
+  /**
+   * @return True, if the NMI watchdog is enabled, which permanently occupies a hardware counter.
+   */
+  [[nodiscard]] static bool is_nmi_watchdog_enabled();
+
+  /**
+   * @return The type of the PMU of the performance cores on hybrid Intel processors, std::nullopt on other processors.
+   */
+  [[nodiscard]] static std::optional<std::uint32_t> intel_hybrid_core_type();
+
+  /**
+   * Reads the config (event and umask) of Intel's slots or top-down metric event (e.g., "topdown-retiring") as exposed
+   * by the kernel. On hybrid processors, the event is read from the PMU of the performance cores and has to be opened
+   * with that PMU's type (see intel_hybrid_core_type()).
+   *
+   * @param event_name Name of the event.
+   * @return Config of the event, std::nullopt if the event is not supported.
+   */
+  [[nodiscard]] static std::optional<std::uint64_t> intel_topdown_event_id(std::string_view event_name);
+
+  /**
+   * @return True, if the processor reports top-down metrics via the PERF_METRICS register (Ice Lake and later).
+   */
+  [[nodiscard]] static bool is_intel_perf_metrics_supported()
+  {
+    return intel_topdown_event_id("slots").has_value() && intel_topdown_event_id("topdown-retiring").has_value();
+  }
+
+  /**
+   * @return Number of dispatch slots per cycle of AMD processors with pipeline utilization events (Zen 4: 6, Zen 5: 8),
+   *  std::nullopt for other processors.
+   */
+  [[nodiscard]] static std::optional<std::uint8_t> amd_dispatch_width() noexcept;
+
 private:
   /**
    * Tries to read the type from the provided file.
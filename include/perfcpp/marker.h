@@ -0,0 +1,306 @@
+#pragma once
+
+#include "sample.h"
+#include "sample_view.h"
+#include "time_conversion.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace perf {
+/**
+ * Markers tag regions of the application (e.g., requests or queries) with a user-defined id at low cost: Entering and
+ * leaving a region records the cycle counter (see TimeConversion::cycles()) and the id of the region that is active
+ * afterward into a ring owned by the calling thread, without system calls or locks. A MarkerTimeline reads the rings
+ * and joins samples (via their thread id and timestamp) to the region that was active when the sample was recorded.
+ *
+ * Rings hold the latest RING_CAPACITY markers per thread; markers that are overwritten before they were read by a
+ * timeline are counted as lost. When a thread exits, its ring is retired and freed by the next timeline update that
+ * read all of its markers.
+ */
+class Marker
+{
+public:
+  /// Id indicating that no region is active.
+  constexpr static inline auto NO_REGION = std::numeric_limits<std::uint64_t>::max();
+
+  /// Number of markers kept per thread (power of two).
+  constexpr static inline auto RING_CAPACITY = std::size_t{ 16384U };
+
+  /// Maximal nesting depth of regions; deeper regions are recorded, but leaving them restores the deepest known region.
+  constexpr static inline auto MAX_DEPTH = std::size_t{ 64U };
+
+  /**
+   * Scope that enters a region on construction and leaves the region on destruction.
+   */
+  class Scope
+  {
+  public:
+    explicit Scope(const std::uint64_t region_id) noexcept { Marker::begin(region_id); }
+    Scope(Scope&&) = delete;
+    Scope(const Scope&) = delete;
+
+    ~Scope() { Marker::end(); }
+
+    Scope& operator=(Scope&&) = delete;
+    Scope& operator=(const Scope&) = delete;
+  };
+
+  /**
+   * Enters the region with the given id on the calling thread; regions can be nested.
+   *
+   * @param region_id Id of the region (e.g., the id of a request), must not be NO_REGION.
+   */
+  static void begin(const std::uint64_t region_id) noexcept
+  {
+    auto* ring = Marker::ring();
+    if (ring == nullptr) {
+      return;
+    }
+
+    if (ring->_depth < MAX_DEPTH) {
+      ring->_region_stack[ring->_depth] = region_id;
+    }
+    ++ring->_depth;
+
+    ring->push(TimeConversion::cycles(), region_id);
+  }
+
+  /**
+   * Leaves the latest region entered on the calling thread; the enclosing region (if any) becomes active again.
+   */
+  static void end() noexcept
+  {
+    auto* ring = Marker::ring();
+    if (ring == nullptr || ring->_depth == 0U) {
+      return;
+    }
+    --ring->_depth;
+
+    const auto active_region_id =
+      ring->_depth == 0U ? NO_REGION : ring->_region_stack[std::min(ring->_depth, MAX_DEPTH) - 1U];
+    ring->push(TimeConversion::cycles(), active_region_id);
+  }
+
+private:
+  friend class MarkerTimeline;
+
+  /**
+   * Ring of markers of a single thread. Only the owning thread writes; readers validate entries through a per-entry
+   * sequence number (like a sequence lock), since the owner may overwrite entries while they are read.
+   */
+  class alignas(64U) Ring
+  {
+  public:
+    Ring(std::uint64_t id, std::uint32_t thread_id);
+
+    /**
+     * Appends a marker, overwriting the oldest marker if the ring is full.
+     *
+     * @param cycles Value of the cycle counter.
+     * @param region_id Id of the region that is active from now on.
+     */
+    void push(const std::uint64_t cycles, const std::uint64_t region_id) noexcept
+    {
+      const auto head = _head.load(std::memory_order_relaxed);
+      auto& entry = _entries[head & (RING_CAPACITY - 1U)];
+
+      entry.sequence.store(0U, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      entry.cycles.store(cycles, std::memory_order_relaxed);
+      entry.region_id.store(region_id, std::memory_order_relaxed);
+      entry.sequence.store(head + 1U, std::memory_order_release);
+
+      _head.store(head + 1U, std::memory_order_release);
+    }
+
+    /**
+     * Reads the marker at the given position.
+     *
+     * @param position Position of the marker (number of markers pushed before).
+     * @param cycles Receives the value of the cycle counter.
+     * @param region_id Receives the id of the active region.
+     * @return True, if the marker was read; false, if it was overwritten.
+     */
+    [[nodiscard]] bool read(std::uint64_t position, std::uint64_t& cycles, std::uint64_t& region_id) const noexcept;
+
+    [[nodiscard]] std::uint64_t id() const noexcept { return _id; }
+    [[nodiscard]] std::uint32_t thread_id() const noexcept { return _thread_id; }
+    [[nodiscard]] std::uint64_t head() const noexcept { return _head.load(std::memory_order_acquire); }
+
+    /**
+     * @return True, if the owning thread exited, i.e., no markers will be pushed anymore.
+     */
+    [[nodiscard]] bool is_retired() const noexcept { return _is_retired.load(std::memory_order_acquire); }
+
+  private:
+    friend Marker;
+
+    struct Entry
+    {
+      std::atomic<std::uint64_t> sequence{ 0U };
+      std::atomic<std::uint64_t> cycles{ 0U };
+      std::atomic<std::uint64_t> region_id{ 0U };
+    };
+
+    /// Unique id of the ring (thread ids may be reused by the kernel).
+    std::uint64_t _id;
+
+    /// Id of the owning thread (as reported in samples).
+    std::uint32_t _thread_id;
+
+    /// Number of markers pushed so far.
+    std::atomic<std::uint64_t> _head{ 0U };
+
+    /// Set when the owning thread exits.
+    std::atomic<bool> _is_retired{ false };
+
+    std::unique_ptr<Entry[]> _entries;
+
+    /// Stack of entered regions; only accessed by the owning thread.
+    std::size_t _depth{ 0U };
+    std::array<std::uint64_t, MAX_DEPTH> _region_stack{};
+  };
+
+  /// Ring of the calling thread, registered on first use.
+  static inline thread_local Ring* _thread_ring{ nullptr };
+
+  /**
+   * @return The ring of the calling thread, nullptr if the thread is exiting.
+   */
+  [[nodiscard]] static Ring* ring() noexcept
+  {
+    if (_thread_ring == nullptr) {
+      _thread_ring = Marker::register_thread();
+    }
+
+    return _thread_ring;
+  }
+
+  /// Registry of the rings of all threads.
+  class Registry;
+
+  /// Retires the ring of a thread when the thread exits.
+  class RingOwner;
+
+  [[nodiscard]] static Registry& registry();
+
+  /**
+   * Creates and registers the ring of the calling thread. Rings stay alive after their thread exits, until a timeline
+   * read all of their markers (see reclaim()).
+   *
+   * @return The ring of the calling thread, nullptr if the thread is exiting.
+   */
+  [[nodiscard]] static Ring* register_thread();
+
+  /**
+   * @return Rings of all threads that recorded markers and were not reclaimed, yet.
+   */
+  [[nodiscard]] static std::vector<std::shared_ptr<const Ring>> rings();
+
+  /**
+   * Removes the (retired) ring with the given id from the registry; the ring is freed once no timeline reads it.
+   *
+   * @param ring_id Id of the ring.
+   */
+  static void reclaim(std::uint64_t ring_id);
+};
+
+/**
+ * The MarkerTimeline reads the markers of all threads (see Marker), translates their cycles into perf timestamps, and
+ * keeps the transitions between regions per thread. Samples are joined to regions via region(), which needs the
+ * samples to record the thread id and the time (see Sampler::Values::thread_id() and Sampler::Values::time()).
+ * Calling update() before every drain joins samples while sampling.
+ */
+class MarkerTimeline
+{
+public:
+  /**
+   * @param time_conversion Conversion between cycles and perf timestamps (see Sampler::time_conversion()).
+   */
+  explicit MarkerTimeline(TimeConversion time_conversion)
+    : _time_conversion(time_conversion)
+  {
+  }
+  ~MarkerTimeline() = default;
+
+  /**
+   * Reads all markers that were recorded since the last update.
+   */
+  void update();
+
+  /**
+   * Removes all transitions before the given time, keeping the region that is active at that time. Samples recorded
+   * before the time can no longer be joined afterward.
+   *
+   * @param time Perf timestamp in nanoseconds.
+   */
+  void prune(std::uint64_t time);
+
+  /**
+   * Returns the region that was active on the given thread at the given time.
+   *
+   * @param thread_id Id of the thread.
+   * @param time Perf timestamp in nanoseconds.
+   * @return Id of the innermost active region, std::nullopt if no region was active.
+   */
+  [[nodiscard]] std::optional<std::uint64_t> region(std::uint32_t thread_id, std::uint64_t time) const;
+
+  /**
+   * @param sample Sample recording the thread id and the time.
+   * @return Id of the region that was active when the sample was recorded, std::nullopt if none was active.
+   */
+  [[nodiscard]] std::optional<std::uint64_t> region(const Sample& sample) const
+  {
+    if (sample.thread_id().has_value() && sample.time().has_value()) {
+      return region(sample.thread_id().value(), sample.time().value());
+    }
+
+    return std::nullopt;
+  }
+
+  /**
+   * @param sample_view View on a sample recording the thread id and the time.
+   * @return Id of the region that was active when the sample was recorded, std::nullopt if none was active.
+   */
+  [[nodiscard]] std::optional<std::uint64_t> region(const SampleView& sample_view) const
+  {
+    const auto thread_id = sample_view.thread_id();
+    const auto time = sample_view.time();
+    if (thread_id.has_value() && time.has_value()) {
+      return region(thread_id.value(), time.value());
+    }
+
+    return std::nullopt;
+  }
+
+  /**
+   * @return Number of markers that were overwritten before they were read.
+   */
+  [[nodiscard]] std::uint64_t count_lost() const noexcept { return _count_lost; }
+
+private:
+  /// Begin of the (active) region at the given time.
+  struct Transition
+  {
+    std::uint64_t time;
+    std::uint64_t region_id;
+  };
+
+  TimeConversion _time_conversion;
+
+  /// Number of markers read per ring, by the id of the ring.
+  std::unordered_map<std::uint64_t, std::uint64_t> _read_positions;
+
+  /// Transitions per thread, ordered by time (also if rings of different threads share a reused thread id).
+  std::unordered_map<std::uint32_t, std::vector<Transition>> _transitions;
+
+  std::uint64_t _count_lost{ 0U };
+};
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace perf {
+/**
+ * The NumaTopology maps CPUs and memory to NUMA nodes, as reported by the kernel (/sys/devices/system/node). Physical
+ * addresses are mapped via the memory blocks of every node; logical addresses are looked up page by page via the
+ * move_pages() system call. Systems without NUMA information are seen as a single node holding all CPUs and memory.
+ */
+class NumaTopology
+{
+public:
+  /**
+   * Reads the topology of the system.
+   */
+  NumaTopology();
+  ~NumaTopology() = default;
+
+  /**
+   * @return Number of NUMA nodes.
+   */
+  [[nodiscard]] std::uint16_t count_nodes() const noexcept { return std::uint16_t(_cpu_ids.size()); }
+
+  /**
+   * @param cpu_id Id of the CPU.
+   * @return The NUMA node of the given CPU, std::nullopt if the CPU is not known.
+   */
+  [[nodiscard]] std::optional<std::uint16_t> node_of_cpu(const std::uint32_t cpu_id) const noexcept
+  {
+    if (cpu_id < _node_of_cpu.size() && _node_of_cpu[cpu_id] != NO_NODE) {
+      return _node_of_cpu[cpu_id];
+    }
+
+    return std::nullopt;
+  }
+
+  /**
+   * @param node NUMA node.
+   * @return List of CPUs of the given NUMA node.
+   */
+  [[nodiscard]] const std::vector<std::uint16_t>& cpus(std::uint16_t node) const noexcept;
+
+  /**
+   * @param physical_address Physical memory address (e.g., Sample::physical_memory_address()).
+   * @return The NUMA node of the memory, std::nullopt if the address is not within a known memory block.
+   */
+  [[nodiscard]] std::optional<std::uint16_t> node_of_physical_address(std::uint64_t physical_address) const noexcept;
+
+  /**
+   * Looks up the NUMA nodes of the pages that back the given logical addresses via move_pages(). Querying other
+   * processes needs the permission to trace them; pages that are not (or no longer) mapped yield std::nullopt.
+   *
+   * @param process_id Process that owns the addresses (0 for the calling process).
+   * @param logical_addresses Logical memory addresses.
+   * @return The NUMA node for every given address.
+   */
+  [[nodiscard]] static std::vector<std::optional<std::uint16_t>> nodes_of_logical_addresses(
+    std::uint32_t process_id,
+    const std::vector<std::uintptr_t>& logical_addresses);
+
+  /**
+   * Parses a list of CPUs in the format of the kernel (e.g., "0-3,8,10-11").
+   *
+   * @param cpu_list List of CPUs.
+   * @return Ids of the CPUs.
+   */
+  [[nodiscard]] static std::vector<std::uint16_t> parse_cpu_list(const std::string& cpu_list);
+
+private:
+  /// Marks CPUs without a node.
+  constexpr static inline auto NO_NODE = std::uint16_t{ 0xFFFFU };
+
+  /// Physical memory range of a node.
+  struct MemoryRange
+  {
+    std::uint64_t begin;
+    std::uint64_t end;
+    std::uint16_t node;
+  };
+
+  /// CPUs of every node.
+  std::vector<std::vector<std::uint16_t>> _cpu_ids;
+
+  /// Node of every CPU (indexed by the id of the CPU).
+  std::vector<std::uint16_t> _node_of_cpu;
+
+  /// Physical memory ranges of all nodes, sorted by begin; adjacent blocks of the same node are merged.
+  std::vector<MemoryRange> _memory_ranges;
+};
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include "sample_arena.h"
+#include "sample_batch.h"
+#include "sampler.h"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace perf {
+/**
+ * The PeriodController adapts the sampling period of a sampler at runtime, such that the sampler records roughly a
+ * target number of samples per second: Whenever samples are drained, the controller compares the observed sample rate
+ * with the target and adjusts the period (via Sampler::update_period()). Lost samples (PERF_RECORD_LOST) increase the
+ * period by at least the share of lost samples; throttling by the perf subsystem (PERF_RECORD_THROTTLE) at least
+ * doubles the period.
+ * The controller records the period of every sample (Values::period()) so that samples can be weighted even though the
+ * period changes; therefore, the controller has to be created before the sampler is opened. Only samplers that sample
+ * with a period (not a frequency) can be controlled. The same period is applied to all triggers of the sampler.
+ */
+class PeriodController
+{
+public:
+  class Config
+  {
+  public:
+    Config() noexcept = default;
+    ~Config() noexcept = default;
+
+    /**
+     * Sets the number of samples per second the controller aims for (per sampler, i.e., per CPU core or thread).
+     *
+     * @param target_samples_per_second Targeted number of samples per second.
+     * @return Config.
+     */
+    Config& target_samples_per_second(const std::uint64_t target_samples_per_second) noexcept
+    {
+      _target_samples_per_second = target_samples_per_second;
+      return *this;
+    }
+
+    /**
+     * Sets the range of periods the controller may choose.
+     *
+     * @param min_period Smallest period.
+     * @param max_period Largest period.
+     * @return Config.
+     */
+    Config& period_range(const std::uint64_t min_period, const std::uint64_t max_period) noexcept
+    {
+      _min_period = min_period;
+      _max_period = max_period;
+      return *this;
+    }
+
+    /**
+     * Sets the factor the period changes by at most per update (e.g., 4.0 allows to shrink the period to a quarter or
+     * to grow it by four).
+     *
+     * @param max_adjustment Maximal factor per update.
+     * @return Config.
+     */
+    Config& max_adjustment(const double max_adjustment) noexcept
+    {
+      _max_adjustment = max_adjustment;
+      return *this;
+    }
+
+    /**
+     * Sets the relative deviation from the target rate that is tolerated without changing the period.
+     *
+     * @param tolerance Tolerated deviation (e.g., 0.2 for 20%).
+     * @return Config.
+     */
+    Config& tolerance(const double tolerance) noexcept
+    {
+      _tolerance = tolerance;
+      return *this;
+    }
+
+    [[nodiscard]] std::uint64_t target_samples_per_second() const noexcept { return _target_samples_per_second; }
+    [[nodiscard]] std::uint64_t min_period() const noexcept { return _min_period; }
+    [[nodiscard]] std::uint64_t max_period() const noexcept { return _max_period; }
+    [[nodiscard]] double max_adjustment() const noexcept { return _max_adjustment; }
+    [[nodiscard]] double tolerance() const noexcept { return _tolerance; }
+
+  private:
+    std::uint64_t _target_samples_per_second{ 1000U };
+    std::uint64_t _min_period{ 1000U };
+    std::uint64_t _max_period{ std::uint64_t{ 1U } << 32U };
+    double _max_adjustment{ 4.0 };
+    double _tolerance{ 0.2 };
+  };
+
+  /**
+   * Period that was set at a specific point in time.
+   */
+  class Change
+  {
+  public:
+    Change(const std::chrono::steady_clock::time_point time, const std::uint64_t period) noexcept
+      : _time(time)
+      , _period(period)
+    {
+    }
+    ~Change() noexcept = default;
+
+    /**
+     * @return Point in time the period was set.
+     */
+    [[nodiscard]] std::chrono::steady_clock::time_point time() const noexcept { return _time; }
+
+    /**
+     * @return The period that was set.
+     */
+    [[nodiscard]] std::uint64_t period() const noexcept { return _period; }
+
+  private:
+    std::chrono::steady_clock::time_point _time;
+    std::uint64_t _period;
+  };
+
+  /**
+   * Creates a controller for the given sampler, starting with the period of the sampler's config.
+   * Throws a std::runtime_error, if the sampler samples with a frequency.
+   *
+   * @param sampler Sampler to control; needs to outlive the controller.
+   * @param config Config of the controller.
+   */
+  explicit PeriodController(Sampler& sampler, Config config = {});
+  ~PeriodController() = default;
+
+  /**
+   * Adapts the period to the samples that were drained since the last update.
+   *
+   * @param count_samples Number of drained samples.
+   * @param count_loss Number of lost samples.
+   * @param count_throttle Number of throttle records.
+   * @return Period in effect after the update.
+   */
+  std::uint64_t update(std::uint64_t count_samples, std::uint64_t count_loss, std::uint64_t count_throttle);
+
+  /**
+   * Adapts the period to the given (drained) batch of samples.
+   *
+   * @param batch Samples drained since the last update.
+   * @return Period in effect after the update.
+   */
+  std::uint64_t update(const SampleBatch& batch)
+  {
+    return update(batch.size(), batch.count_loss(), batch.count_throttle());
+  }
+
+  /**
+   * Adapts the period to the given (drained) arena of samples.
+   *
+   * @param arena Samples drained since the last update.
+   * @return Period in effect after the update.
+   */
+  std::uint64_t update(const SampleArena& arena)
+  {
+    return update(arena.size(), arena.count_loss(), arena.count_throttle());
+  }
+
+  /**
+   * @return The period currently in effect.
+   */
+  [[nodiscard]] std::uint64_t period() const noexcept { return _period; }
+
+  /**
+   * @return All periods that were set (starting with the initial period), in the order they were set.
+   */
+  [[nodiscard]] const std::vector<Change>& history() const noexcept { return _history; }
+
+private:
+  Sampler& _sampler;
+  Config _config;
+
+  /// Period in effect.
+  std::uint64_t _period;
+
+  /// Point in time of the last update.
+  std::chrono::steady_clock::time_point _last_update;
+
+  std::vector<Change> _history;
+};
+}
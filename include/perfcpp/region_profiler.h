@@ -0,0 +1,361 @@
+#pragma once
+
+#include "config.h"
+#include "counter.h"
+#include "counter_definition.h"
+#include "event_counter.h"
+#include "thread_registry.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/// Helpers to create unique names of variables per line.
+#define PERFCPP_CONCAT_INNER(a, b) a##b
+#define PERFCPP_CONCAT(a, b) PERFCPP_CONCAT_INNER(a, b)
+
+/**
+ * Profiles the enclosing scope as region with the given name, using the active RegionProfiler (if any).
+ * The id of the region is resolved once per call site.
+ */
+#define PERFCPP_REGION(name)                                                                                           \
+  static const auto PERFCPP_CONCAT(perfcpp_region_id_, __LINE__) = perf::RegionProfiler::region(name);                \
+  const auto PERFCPP_CONCAT(perfcpp_region_scope_, __LINE__) =                                                         \
+    perf::RegionProfiler::Scope{ PERFCPP_CONCAT(perfcpp_region_id_, __LINE__) }
+
+namespace perf {
+/**
+ * The RegionProfiler records hardware events for named code regions (scopes) on arbitrary threads:
+ * Every thread lazily opens its own counters when entering its first region. Entering and leaving a region reads the
+ * counters (from user-level, see Config::user_level_read()) and accumulates the differences into a table owned by
+ * the thread, so that the threads never synchronize while profiling. Nested regions are attributed both
+ * inclusively (including nested regions) and exclusively (excluding nested regions). When a thread exits, its counters
+ * are closed; the table of the thread is kept for aggregation.
+ *
+ * The profiler needs to outlive all regions entered on any thread.
+ */
+class RegionProfiler
+{
+private:
+  class ThreadProfile;
+
+public:
+  /// Maximal number of distinct regions (over all profilers).
+  constexpr static inline auto MAX_REGIONS = std::size_t{ 4096U };
+
+  /**
+   * Scope that enters a region on construction and leaves the region on destruction.
+   */
+  class Scope
+  {
+  public:
+    /**
+     * Enters the region on the given profiler. If the profiler is nullptr, the scope is not recorded.
+     *
+     * @param profiler Profiler to record the region.
+     * @param region_id Id of the region, see RegionProfiler::region().
+     */
+    Scope(RegionProfiler* profiler, const std::uint32_t region_id)
+      : _thread_profile(profiler != nullptr ? profiler->enter(region_id) : nullptr)
+    {
+    }
+
+    /**
+     * Enters the region on the active profiler (see RegionProfiler::active()).
+     *
+     * @param region_id Id of the region, see RegionProfiler::region().
+     */
+    explicit Scope(const std::uint32_t region_id)
+      : Scope(RegionProfiler::active(), region_id)
+    {
+    }
+
+    Scope(Scope&&) = delete;
+    Scope(const Scope&) = delete;
+
+    ~Scope() { RegionProfiler::leave(_thread_profile); }
+
+    Scope& operator=(Scope&&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  private:
+    ThreadProfile* _thread_profile;
+  };
+
+  /**
+   * Aggregated result of a single region.
+   */
+  class RegionResult
+  {
+  public:
+    RegionResult(std::string&& name, const std::uint64_t count, CounterResult&& inclusive, CounterResult&& exclusive)
+      : _name(std::move(name))
+      , _count(count)
+      , _inclusive(std::move(inclusive))
+      , _exclusive(std::move(exclusive))
+    {
+    }
+    ~RegionResult() = default;
+
+    /**
+     * @return Name of the region.
+     */
+    [[nodiscard]] const std::string& name() const noexcept { return _name; }
+
+    /**
+     * @return Number of times the region was entered.
+     */
+    [[nodiscard]] std::uint64_t count() const noexcept { return _count; }
+
+    /**
+     * @return Counters and metrics of the region, including nested regions.
+     */
+    [[nodiscard]] const CounterResult& inclusive() const noexcept { return _inclusive; }
+
+    /**
+     * @return Counters and metrics of the region, excluding nested regions.
+     */
+    [[nodiscard]] const CounterResult& exclusive() const noexcept { return _exclusive; }
+
+  private:
+    std::string _name;
+    std::uint64_t _count;
+    CounterResult _inclusive;
+    CounterResult _exclusive;
+  };
+
+  /**
+   * Creates a profiler and sets it as the active profiler used by PERFCPP_REGION.
+   *
+   * @param counter_list Definitions of the counters.
+   * @param config Configuration of the counters; counters are always read from user-level.
+   */
+  explicit RegionProfiler(const CounterDefinition& counter_list, Config config = {});
+  RegionProfiler(RegionProfiler&&) = delete;
+  RegionProfiler(const RegionProfiler&) = delete;
+
+  ~RegionProfiler();
+
+  RegionProfiler& operator=(RegionProfiler&&) = delete;
+  RegionProfiler& operator=(const RegionProfiler&) = delete;
+
+  /**
+   * Add the specified counter to the list of profiled counters, before any region is entered.
+   * The counter must exist within the counter definitions.
+   *
+   * @param counter_name Name of the counter.
+   * @return True, if the counter could be added.
+   */
+  bool add(std::string&& counter_name);
+
+  /**
+   * Add the specified counter to the list of profiled counters, before any region is entered.
+   * The counter must exist within the counter definitions.
+   *
+   * @param counter_name Name of the counter.
+   * @return True, if the counter could be added.
+   */
+  bool add(const std::string& counter_name) { return add(std::string{ counter_name }); }
+
+  /**
+   * Add the specified counters to the list of profiled counters, before any region is entered.
+   * The counters must exist within the counter definitions.
+   *
+   * @param counter_names List of names of the counters.
+   * @return True, if the counters could be added.
+   */
+  bool add(std::vector<std::string>&& counter_names);
+
+  /**
+   * Add the specified counters to the list of profiled counters, before any region is entered.
+   * The counters must exist within the counter definitions.
+   *
+   * @param counter_names List of names of the counters.
+   * @return True, if the counters could be added.
+   */
+  bool add(const std::vector<std::string>& counter_names) { return add(std::vector<std::string>{ counter_names }); }
+
+  /**
+   * Returns the id of the region with the given name, registering the region on first use.
+   * Ids are shared by all profilers; resolving the id once per call site keeps the name lookup off the hot path.
+   *
+   * @param name Name of the region.
+   * @return Id of the region.
+   */
+  [[nodiscard]] static std::uint32_t region(std::string_view name);
+
+  /**
+   * @return The profiler used by PERFCPP_REGION, or nullptr if no profiler is active.
+   */
+  [[nodiscard]] static RegionProfiler* active() noexcept { return _active_profiler.load(std::memory_order_acquire); }
+
+  /**
+   * Sets this profiler as the profiler used by PERFCPP_REGION.
+   */
+  void activate() noexcept { _active_profiler.store(this, std::memory_order_release); }
+
+  /**
+   * Aggregates the results of all threads, per region. Threads can continue profiling while aggregating.
+   *
+   * @return List of results of all regions that were entered at least once.
+   */
+  [[nodiscard]] std::vector<RegionResult> result() const;
+
+private:
+  /// Source of profiler ids, identifying profilers in thread-local caches.
+  static inline std::atomic<std::uint64_t> _next_profiler_id{ 1U };
+
+  /// Profiler used by PERFCPP_REGION.
+  static inline std::atomic<RegionProfiler*> _active_profiler{ nullptr };
+
+  /// Id of the profiler.
+  std::uint64_t _id;
+
+  /// Template for the counters of all threads, never started itself.
+  EventCounter _event_counter;
+
+  /// Profiles of all threads that entered a region, indexed by the slot of the thread (nullptr if not yet created);
+  /// only registering, exiting, and aggregating threads lock the mutex.
+  mutable std::mutex _thread_profiles_mutex;
+  std::vector<std::unique_ptr<ThreadProfile>> _thread_profiles;
+
+  /// Assigns slots to threads and retires the profiles of exiting threads; must be destroyed before the profiles.
+  ThreadRegistry _thread_registry;
+
+  /**
+   * Enters the region on the calling thread, opening the thread's counters on the first call.
+   *
+   * @param region_id Id of the region.
+   * @return The profile of the calling thread, or nullptr if the region cannot be recorded.
+   */
+  [[nodiscard]] ThreadProfile* enter(std::uint32_t region_id);
+
+  /**
+   * Leaves the latest region entered on the given thread profile.
+   *
+   * @param thread_profile Profile returned when entering the region (may be nullptr).
+   */
+  static void leave(ThreadProfile* thread_profile) noexcept;
+
+  /**
+   * @return The profile of the calling thread, created on first use.
+   */
+  [[nodiscard]] ThreadProfile& thread_profile();
+
+  /// Registry of region names, mapping to their ids.
+  class Registry;
+
+  [[nodiscard]] static Registry& registry();
+};
+
+/**
+ * Profile of a single thread: The counters of the thread, the stack of entered regions, and one table row per region.
+ * Only the owning thread writes the table; other threads read it when aggregating results.
+ */
+class RegionProfiler::ThreadProfile
+{
+public:
+  explicit ThreadProfile(const EventCounter& event_counter);
+  ThreadProfile(ThreadProfile&&) = delete;
+  ThreadProfile(const ThreadProfile&) = delete;
+
+  ~ThreadProfile();
+
+  ThreadProfile& operator=(ThreadProfile&&) = delete;
+  ThreadProfile& operator=(const ThreadProfile&) = delete;
+
+  [[nodiscard]] const EventCounter& event_counter() const noexcept { return _event_counter; }
+
+  /**
+   * Pushes the region and reads the start values.
+   *
+   * @param region_id Id of the region.
+   * @return True, if the counters could be read.
+   */
+  [[nodiscard]] bool enter(std::uint32_t region_id);
+
+  /**
+   * Reads the end values, pops the latest region, and accumulates the differences into the table.
+   */
+  void leave() noexcept;
+
+  /**
+   * Stops and closes the counters when the owning thread exits. Regions entered afterward are not recorded, the
+   * table stays available for aggregation.
+   */
+  void retire() noexcept;
+
+  /**
+   * Adds the accumulated values of the region to the given sums.
+   *
+   * @param region_id Id of the region.
+   * @param count Sum of the number of times the region was entered.
+   * @param inclusive Sums of the inclusive values (one per hardware event).
+   * @param exclusive Sums of the exclusive values (one per hardware event).
+   */
+  void aggregate(std::uint32_t region_id,
+                 std::uint64_t& count,
+                 std::vector<double>& inclusive,
+                 std::vector<double>& exclusive) const noexcept;
+
+private:
+  /// Cache line holding values of the table; rows are padded to full cache lines.
+  struct alignas(64U) CacheLine
+  {
+    std::array<std::atomic<double>, 8U> values;
+  };
+
+  /// The table is allocated in chunks of regions when first used, chunks are never moved.
+  constexpr static inline auto REGIONS_PER_CHUNK = std::size_t{ 64U };
+
+  EventCounter _event_counter;
+
+  /// Number of hardware events.
+  std::size_t _count_hardware_events;
+
+  /// Number of cache lines per row (count, inclusive values, and exclusive values).
+  std::size_t _row_size;
+
+  std::array<std::atomic<CacheLine*>, MAX_REGIONS / REGIONS_PER_CHUNK> _chunks{};
+
+  /// Ids of the entered regions.
+  std::vector<std::uint32_t> _region_stack;
+
+  /// Start values and accumulated inclusive values of nested regions, per entered region.
+  std::vector<double> _value_stack;
+
+  /// Number of times each region is currently entered, to count the inclusive values of recursion once.
+  std::vector<std::uint32_t> _region_depth;
+
+  /// Buffer for reading the counters.
+  std::vector<double> _current_values;
+
+  /**
+   * @param region_id Id of the region.
+   * @return The first cache line of the row of the region, or nullptr, if the region was not recorded yet.
+   */
+  [[nodiscard]] CacheLine* row(std::uint32_t region_id) const noexcept;
+
+  /**
+   * @param region_id Id of the region.
+   * @return The first cache line of the row of the region, allocating its chunk on first use.
+   */
+  [[nodiscard]] CacheLine* row_or_allocate(std::uint32_t region_id);
+
+  [[nodiscard]] static std::atomic<double>& value(CacheLine* row, const std::size_t index) noexcept
+  {
+    return row[index / 8U].values[index % 8U];
+  }
+
+  /// Only the owning thread writes values, a relaxed load and store is enough to avoid torn reads by aggregation.
+  static void add(std::atomic<double>& value, const double delta) noexcept
+  {
+    value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+  }
+};
+}
@@ -106,6 +106,82 @@ private:
   bool _is_throttle;
 };
 
+class Mmap
+{
+public:
+  Mmap(const std::uint32_t process_id,
+       const std::uint32_t thread_id,
+       const std::uintptr_t address,
+       const std::uint64_t length,
+       const std::uint64_t page_offset,
+       const std::optional<std::uint64_t> inode,
+       const std::optional<std::uint32_t> protection,
+       std::string&& path) noexcept
+    : _process_id(process_id)
+    , _thread_id(thread_id)
+    , _address(address)
+    , _length(length)
+    , _page_offset(page_offset)
+    , _inode(inode)
+    , _protection(protection)
+    , _path(std::move(path))
+  {
+  }
+  ~Mmap() = default;
+
+  /**
+   * @return Id of the process that mapped the memory.
+   */
+  [[nodiscard]] std::uint32_t process_id() const noexcept { return _process_id; }
+
+  /**
+   * @return Id of the thread that mapped the memory.
+   */
+  [[nodiscard]] std::uint32_t thread_id() const noexcept { return _thread_id; }
+
+  /**
+   * @return Start address of the mapped memory.
+   */
+  [[nodiscard]] std::uintptr_t address() const noexcept { return _address; }
+
+  /**
+   * @return Length of the mapped memory in bytes.
+   */
+  [[nodiscard]] std::uint64_t length() const noexcept { return _length; }
+
+  /**
+   * @return Offset of the mapping within the mapped file.
+   */
+  [[nodiscard]] std::uint64_t page_offset() const noexcept { return _page_offset; }
+
+  /**
+   * @return Inode of the mapped file, or std::nullopt if not provided (only provided by MMAP2 records without build
+   * id).
+   */
+  [[nodiscard]] std::optional<std::uint64_t> inode() const noexcept { return _inode; }
+
+  /**
+   * @return Protection of the mapping (e.g., PROT_EXEC), or std::nullopt if not provided (only provided by MMAP2
+   * records).
+   */
+  [[nodiscard]] std::optional<std::uint32_t> protection() const noexcept { return _protection; }
+
+  /**
+   * @return Path of the mapped file (or a pseudo path like "[vdso]" or "//anon").
+   */
+  [[nodiscard]] const std::string& path() const noexcept { return _path; }
+
+private:
+  std::uint32_t _process_id;
+  std::uint32_t _thread_id;
+  std::uintptr_t _address;
+  std::uint64_t _length;
+  std::uint64_t _page_offset;
+  std::optional<std::uint64_t> _inode{ std::nullopt };
+  std::optional<std::uint32_t> _protection{ std::nullopt };
+  std::string _path;
+};
+
 class Sample
 {
 public:
@@ -134,7 +210,7 @@ public:
   void thread_id(const std::uint32_t thread_id) noexcept { _thread_id = thread_id; }
   void timestamp(const std::uint64_t timestamp) noexcept { _time = timestamp; }
   void stream_id(const std::uint64_t stream_id) noexcept { _stream_id = stream_id; }
-  void raw(std::vector<char>&& raw) noexcept { _raw_data = raw; }
+  void raw(std::vector<char>&& raw) noexcept { _raw_data = std::move(raw); }
   void logical_memory_address(const std::uintptr_t logical_memory_address) noexcept
   {
     _logical_memory_address = logical_memory_address;
@@ -169,6 +245,7 @@ public:
   void cgroup(CGroup&& cgroup) noexcept { _cgroup = std::move(cgroup); }
   void context_switch(ContextSwitch&& context_switch) noexcept { _context_switch = context_switch; }
   void throttle(Throttle&& throttle) noexcept { _throttle = throttle; }
+  void mmap(Mmap&& mmap) noexcept { _mmap = std::move(mmap); }
   void is_exact_ip(const bool is_exact_ip) noexcept { _is_exact_ip = is_exact_ip; }
 
   /*
@@ -393,6 +470,12 @@ public:
    */
   [[nodiscard]] std::optional<Throttle> throttle() const noexcept { return _throttle; }
 
+  /*
+   * Retrieves a memory mapping (recorded when a process maps memory, e.g., when loading a library).
+   * @return An optional containing the memory mapping if available.
+   */
+  [[nodiscard]] const std::optional<Mmap>& mmap() const noexcept { return _mmap; }
+
   /*
    * Indicates whether the instruction pointer in the sample is exact.
    * @return True if the instruction pointer is exact; otherwise, false.
@@ -430,6 +513,7 @@ private:
   std::optional<CGroup> _cgroup{ std::nullopt };
   std::optional<ContextSwitch> _context_switch{ std::nullopt };
   std::optional<Throttle> _throttle{ std::nullopt };
+  std::optional<Mmap> _mmap{ std::nullopt };
   bool _is_exact_ip{ false };
 };
 }
\ No newline at end of file
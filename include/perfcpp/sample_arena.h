@@ -0,0 +1,183 @@
+#pragma once
+
+#include "sample.h"
+#include "sample_view.h"
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+namespace perf {
+/**
+ * The SampleArena holds copies of sample records in a single contiguous block of memory. Samples are accessed as
+ * perf::SampleView, i.e., values are decoded lazily and variable-sized values (callchains, branch stacks, registers,
+ * and raw data) are spans into the arena – no memory is allocated per sample.
+ * In contrast to the views passed to Sampler::for_each(), the records live as long as the arena, independent of the
+ * user-level buffer. Clearing the arena keeps its memory, so that an arena can be reused for multiple calls to
+ * Sampler::drain(SampleArena&) without allocating.
+ * Records other than samples (e.g., context switches or memory mappings) are not stored; lost samples are counted.
+ */
+class SampleArena
+{
+public:
+  /**
+   * Iterator over the samples of the arena, yielding a SampleView per sample.
+   */
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = SampleView;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = SampleView;
+
+    const_iterator(const SampleArena& arena, const std::size_t index) noexcept
+      : _arena(&arena)
+      , _index(index)
+    {
+    }
+    ~const_iterator() noexcept = default;
+
+    [[nodiscard]] SampleView operator*() const noexcept { return (*_arena)[_index]; }
+
+    const_iterator& operator++() noexcept
+    {
+      ++_index;
+      return *this;
+    }
+
+    const_iterator operator++(int) noexcept
+    {
+      auto previous = *this;
+      ++_index;
+      return previous;
+    }
+
+    [[nodiscard]] bool operator==(const const_iterator& other) const noexcept { return _index == other._index; }
+    [[nodiscard]] bool operator!=(const const_iterator& other) const noexcept { return _index != other._index; }
+
+  private:
+    const SampleArena* _arena;
+    std::size_t _index;
+  };
+
+  SampleArena() = default;
+  ~SampleArena() = default;
+
+  /**
+   * @return Number of samples in the arena.
+   */
+  [[nodiscard]] std::size_t size() const noexcept { return _records.size(); }
+
+  /**
+   * @return True, if the arena holds no samples.
+   */
+  [[nodiscard]] bool empty() const noexcept { return _records.empty(); }
+
+  /**
+   * @return Number of samples that were lost by the perf subsystem (PERF_RECORD_LOST) while reading into the arena.
+   */
+  [[nodiscard]] std::uint64_t count_loss() const noexcept { return _count_loss; }
+
+  /**
+   * @return Number of throttle records (PERF_RECORD_THROTTLE) that were read into the arena.
+   */
+  [[nodiscard]] std::uint64_t count_throttle() const noexcept { return _count_throttle; }
+
+  /**
+   * @return Number of bytes of all stored records.
+   */
+  [[nodiscard]] std::size_t size_in_bytes() const noexcept { return _data.size() * sizeof(std::uint64_t); }
+
+  /**
+   * Accesses the sample at the given index. The view (including all spans) is valid until the arena is cleared,
+   * refilled, or destroyed.
+   *
+   * @param index Index of the sample.
+   * @return View on the sample.
+   */
+  [[nodiscard]] SampleView operator[](const std::size_t index) const noexcept
+  {
+    const auto& record = _records[index];
+    return SampleView{ reinterpret_cast<const perf_event_header*>(_data.data() + record.offset),
+                       _layouts[record.layout] };
+  }
+
+  [[nodiscard]] const_iterator begin() const noexcept { return const_iterator{ *this, 0U }; }
+  [[nodiscard]] const_iterator end() const noexcept { return const_iterator{ *this, _records.size() }; }
+
+  /**
+   * Translates all samples into perf::Sample objects (allocates memory for every sample).
+   *
+   * @return List of samples.
+   */
+  [[nodiscard]] std::vector<Sample> to_samples() const;
+
+  /**
+   * Removes all samples, but keeps the allocated memory for reuse.
+   */
+  void clear() noexcept;
+
+  /**
+   * Reserves memory for the given number of bytes of records and the given number of samples.
+   *
+   * @param size_in_bytes Number of bytes of records.
+   * @param count_samples Number of samples.
+   */
+  void reserve(std::size_t size_in_bytes, std::size_t count_samples);
+
+  /**
+   * Adds the layout of the records of a sample counter; records added afterward are decoded using this layout.
+   *
+   * @param layout Layout of the following records.
+   */
+  void layout(const SampleLayout& layout);
+
+  /**
+   * Copies the given sample record into the arena, using the most recently added layout.
+   *
+   * @param header Header of the sample record.
+   */
+  void add(const perf_event_header* header);
+
+  /**
+   * Adds the given number of lost samples.
+   *
+   * @param count_loss Number of lost samples.
+   */
+  void add_loss(const std::uint64_t count_loss) noexcept { _count_loss += count_loss; }
+
+  /**
+   * Counts a throttle record, i.e., the perf subsystem throttled sampling since samples were generated too fast.
+   */
+  void add_throttle() noexcept { ++_count_throttle; }
+
+  /**
+   * Sorts the samples by their timestamp (if sampled). Only the index is sorted, the records are not moved.
+   */
+  void sort_by_time();
+
+private:
+  /// Position of a record within the arena and the index of its layout.
+  struct Record
+  {
+    std::size_t offset;
+    std::uint32_t layout;
+  };
+
+  /// Records, stored as 64bit words (records are 8-byte aligned and padded by the perf subsystem).
+  std::vector<std::uint64_t> _data;
+
+  /// Position of every sample record.
+  std::vector<Record> _records;
+
+  /// Layouts of the records (one per sample counter).
+  std::vector<SampleLayout> _layouts;
+
+  /// Number of lost samples.
+  std::uint64_t _count_loss{ 0U };
+
+  /// Number of throttle records.
+  std::uint64_t _count_throttle{ 0U };
+};
+}
@@ -0,0 +1,455 @@
+#pragma once
+
+#include "data_source.h"
+#include "sample.h"
+#include "sample_view.h"
+#include "transaction.h"
+#include "weight.h"
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace perf {
+/**
+ * The SampleBatch stores samples column-wise (struct of arrays): Every sampled value (e.g., instruction pointer, time,
+ * or memory address) is kept in a contiguous array, and only values that were actually sampled occupy memory. Compared
+ * to a list of perf::Sample – which reserves space for every possible value – a batch of samples with few values is
+ * much smaller and can be scanned column by column (e.g., all memory addresses) in a cache-friendly way.
+ * Rows are accessed through the lightweight SampleBatch::Row, which offers the accessors of perf::Sample.
+ * Callchains are stored as a single array of addresses plus the offset of every sample's callchain. Counter values
+ * (PERF_SAMPLE_READ) are stored raw (not corrected for multiplexing) in a single array with one value per counter and
+ * row; the names of the counters are kept once per batch. Branch stacks, registers, and raw data are not stored (see
+ * perf::SampleArena to keep complete records).
+ */
+class SampleBatch
+{
+private:
+  /**
+   * Column of values; the column is empty as long as no sample provided a value.
+   */
+  template<typename T>
+  class Column
+  {
+  public:
+    /**
+     * @return True, if any sample provided a value for this column.
+     */
+    [[nodiscard]] bool is_present() const noexcept { return _is_present; }
+
+    [[nodiscard]] const std::vector<T>& values() const noexcept { return _values; }
+
+    /**
+     * @return The value of the given row, std::nullopt if the column is not present.
+     */
+    [[nodiscard]] std::optional<T> get(const std::size_t row) const noexcept
+    {
+      if (_is_present) {
+        return _values[row];
+      }
+
+      return std::nullopt;
+    }
+
+    /**
+     * Appends the value of the given row; rows without a value are filled with zero once the column is present.
+     */
+    void push_back(const std::size_t row, const std::optional<T> value)
+    {
+      if (value.has_value()) {
+        if (!_is_present) {
+          _is_present = true;
+          _values.resize(row, T{ 0U });
+        }
+        _values.push_back(value.value());
+      } else if (_is_present) {
+        _values.push_back(T{ 0U });
+      }
+    }
+
+    /**
+     * Reorders the values to the given order of rows.
+     */
+    void permute(const std::vector<std::size_t>& order)
+    {
+      if (_is_present) {
+        auto values = std::vector<T>{};
+        values.reserve(_values.size());
+        for (const auto row : order) {
+          values.push_back(_values[row]);
+        }
+        _values = std::move(values);
+      }
+    }
+
+    void clear() noexcept
+    {
+      _values.clear();
+      _is_present = false;
+    }
+
+    [[nodiscard]] std::size_t size_in_bytes() const noexcept { return _values.size() * sizeof(T); }
+
+  private:
+    std::vector<T> _values;
+    bool _is_present{ false };
+  };
+
+public:
+  /**
+   * View on a single sample (row) of the batch.
+   */
+  class Row
+  {
+  public:
+    Row(const SampleBatch& batch, const std::size_t index) noexcept
+      : _batch(&batch)
+      , _index(index)
+    {
+    }
+    ~Row() noexcept = default;
+
+    [[nodiscard]] std::size_t index() const noexcept { return _index; }
+
+    [[nodiscard]] Sample::Mode mode() const noexcept { return _batch->_modes[_index]; }
+    [[nodiscard]] bool is_exact_ip() const noexcept { return static_cast<bool>(_batch->_is_exact_ips[_index]); }
+    [[nodiscard]] std::optional<std::uint64_t> sample_id() const noexcept { return _batch->_sample_ids.get(_index); }
+    [[nodiscard]] std::optional<std::uintptr_t> instruction_pointer() const noexcept
+    {
+      return _batch->_instruction_pointers.get(_index);
+    }
+    [[nodiscard]] std::optional<std::uint32_t> process_id() const noexcept
+    {
+      return _batch->_process_ids.get(_index);
+    }
+    [[nodiscard]] std::optional<std::uint32_t> thread_id() const noexcept { return _batch->_thread_ids.get(_index); }
+    [[nodiscard]] std::optional<std::uint64_t> time() const noexcept { return _batch->_times.get(_index); }
+    [[nodiscard]] std::optional<std::uint64_t> stream_id() const noexcept { return _batch->_stream_ids.get(_index); }
+    [[nodiscard]] std::optional<std::uintptr_t> logical_memory_address() const noexcept
+    {
+      return _batch->_logical_memory_addresses.get(_index);
+    }
+    [[nodiscard]] std::optional<std::uint32_t> cpu_id() const noexcept { return _batch->_cpu_ids.get(_index); }
+    [[nodiscard]] std::optional<std::uint64_t> period() const noexcept { return _batch->_periods.get(_index); }
+    [[nodiscard]] std::optional<Weight> weight() const noexcept { return _batch->_weights.get(_index); }
+    [[nodiscard]] std::optional<DataSource> data_src() const noexcept { return _batch->_data_sources.get(_index); }
+    [[nodiscard]] std::optional<TransactionAbort> transaction_abort() const noexcept
+    {
+      return _batch->_transaction_aborts.get(_index);
+    }
+    [[nodiscard]] std::optional<std::uintptr_t> physical_memory_address() const noexcept
+    {
+      return _batch->_physical_memory_addresses.get(_index);
+    }
+    [[nodiscard]] std::optional<std::uint64_t> cgroup_id() const noexcept { return _batch->_cgroup_ids.get(_index); }
+    [[nodiscard]] std::optional<std::uint64_t> data_page_size() const noexcept
+    {
+      return _batch->_data_page_sizes.get(_index);
+    }
+    [[nodiscard]] std::optional<std::uint64_t> code_page_size() const noexcept
+    {
+      return _batch->_code_page_sizes.get(_index);
+    }
+
+    /**
+     * @return The callchain (instruction pointers); empty if not sampled.
+     */
+    [[nodiscard]] Span<std::uintptr_t> callchain() const noexcept
+    {
+      if (_batch->_callchain_offsets.empty()) {
+        return Span<std::uintptr_t>{};
+      }
+
+      const auto begin = _batch->_callchain_offsets[_index];
+      const auto end = _batch->_callchain_offsets[_index + 1U];
+      return Span<std::uintptr_t>{ _batch->_callchains.data() + begin, end - begin };
+    }
+
+    /**
+     * @return The raw counter values of the row (not corrected for multiplexing) in the order of
+     * SampleBatch::counter_names(); empty if not sampled.
+     */
+    [[nodiscard]] Span<std::uint64_t> counter_values() const noexcept
+    {
+      const auto count_counters = _batch->_counter_names.size();
+      if (_batch->_counter_values.empty() || count_counters == 0U) {
+        return Span<std::uint64_t>{};
+      }
+
+      return Span<std::uint64_t>{ _batch->_counter_values.data() + _index * count_counters, count_counters };
+    }
+
+    /**
+     * @return Time (in nanoseconds) the counters were enabled, std::nullopt if not sampled.
+     */
+    [[nodiscard]] std::optional<std::uint64_t> counter_time_enabled() const noexcept
+    {
+      return _batch->_counter_times_enabled.get(_index);
+    }
+
+    /**
+     * @return Time (in nanoseconds) the counters were running, std::nullopt if not sampled.
+     */
+    [[nodiscard]] std::optional<std::uint64_t> counter_time_running() const noexcept
+    {
+      return _batch->_counter_times_running.get(_index);
+    }
+
+    /**
+     * @return The id of the first counter of the group that recorded the counter values (identifies the thread or CPU
+     * the values belong to), std::nullopt if not sampled.
+     */
+    [[nodiscard]] std::optional<std::uint64_t> counter_group_id() const noexcept
+    {
+      return _batch->_counter_group_ids.get(_index);
+    }
+
+    /**
+     * @return Names of the counters in the order of counter_values().
+     */
+    [[nodiscard]] const std::vector<std::string_view>& counter_names() const noexcept
+    {
+      return _batch->_counter_names;
+    }
+
+    /**
+     * Reads the value of the counter with the given name, corrected for multiplexing.
+     *
+     * @param name Name of the counter.
+     * @return The value of the counter, std::nullopt if not sampled.
+     */
+    [[nodiscard]] std::optional<double> counter_value(std::string_view name) const noexcept;
+
+    /**
+     * Copies all values of the row into a (self-contained) Sample.
+     *
+     * @return Sample holding a copy of all values of the row.
+     */
+    [[nodiscard]] Sample to_sample() const;
+
+  private:
+    const SampleBatch* _batch;
+    std::size_t _index;
+
+    /**
+     * @return Factor to correct the counter values for multiplexing (time enabled / time running).
+     */
+    [[nodiscard]] double multiplexing_correction() const noexcept;
+  };
+
+  /**
+   * Iterator over the rows of the batch.
+   */
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Row;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = Row;
+
+    const_iterator(const SampleBatch& batch, const std::size_t index) noexcept
+      : _batch(&batch)
+      , _index(index)
+    {
+    }
+    ~const_iterator() noexcept = default;
+
+    [[nodiscard]] Row operator*() const noexcept { return Row{ *_batch, _index }; }
+
+    const_iterator& operator++() noexcept
+    {
+      ++_index;
+      return *this;
+    }
+
+    const_iterator operator++(int) noexcept
+    {
+      auto previous = *this;
+      ++_index;
+      return previous;
+    }
+
+    [[nodiscard]] bool operator==(const const_iterator& other) const noexcept { return _index == other._index; }
+    [[nodiscard]] bool operator!=(const const_iterator& other) const noexcept { return _index != other._index; }
+
+  private:
+    const SampleBatch* _batch;
+    std::size_t _index;
+  };
+
+  SampleBatch() = default;
+  ~SampleBatch() = default;
+
+  /**
+   * @return Number of samples in the batch.
+   */
+  [[nodiscard]] std::size_t size() const noexcept { return _modes.size(); }
+
+  /**
+   * @return True, if the batch holds no samples.
+   */
+  [[nodiscard]] bool empty() const noexcept { return _modes.empty(); }
+
+  /**
+   * @return Number of samples that were lost by the perf subsystem (PERF_RECORD_LOST) while reading into the batch.
+   */
+  [[nodiscard]] std::uint64_t count_loss() const noexcept { return _count_loss; }
+
+  /**
+   * @return Number of throttle records (PERF_RECORD_THROTTLE) that were read into the batch.
+   */
+  [[nodiscard]] std::uint64_t count_throttle() const noexcept { return _count_throttle; }
+
+  /**
+   * @return Number of bytes occupied by the values of all columns.
+   */
+  [[nodiscard]] std::size_t size_in_bytes() const noexcept;
+
+  [[nodiscard]] Row operator[](const std::size_t index) const noexcept { return Row{ *this, index }; }
+
+  [[nodiscard]] const_iterator begin() const noexcept { return const_iterator{ *this, 0U }; }
+  [[nodiscard]] const_iterator end() const noexcept { return const_iterator{ *this, size() }; }
+
+  /**
+   * Columns of the batch; a column is empty if the value was not sampled.
+   */
+  [[nodiscard]] Span<std::uintptr_t> instruction_pointers() const noexcept { return span(_instruction_pointers); }
+  [[nodiscard]] Span<std::uint32_t> process_ids() const noexcept { return span(_process_ids); }
+  [[nodiscard]] Span<std::uint32_t> thread_ids() const noexcept { return span(_thread_ids); }
+  [[nodiscard]] Span<std::uint64_t> times() const noexcept { return span(_times); }
+  [[nodiscard]] Span<std::uintptr_t> logical_memory_addresses() const noexcept
+  {
+    return span(_logical_memory_addresses);
+  }
+  [[nodiscard]] Span<std::uint32_t> cpu_ids() const noexcept { return span(_cpu_ids); }
+  [[nodiscard]] Span<std::uint64_t> periods() const noexcept { return span(_periods); }
+  [[nodiscard]] Span<Weight> weights() const noexcept { return span(_weights); }
+  [[nodiscard]] Span<DataSource> data_sources() const noexcept { return span(_data_sources); }
+  [[nodiscard]] Span<std::uintptr_t> physical_memory_addresses() const noexcept
+  {
+    return span(_physical_memory_addresses);
+  }
+
+  /**
+   * @return Names of the counters recorded with the samples (PERF_SAMPLE_READ); empty if no counter values were
+   * sampled.
+   */
+  [[nodiscard]] const std::vector<std::string_view>& counter_names() const noexcept { return _counter_names; }
+
+  /**
+   * @return The raw counter values of all rows; the values of row i span [i * counter_names().size(), (i + 1) *
+   * counter_names().size()).
+   */
+  [[nodiscard]] Span<std::uint64_t> counter_values() const noexcept
+  {
+    return Span<std::uint64_t>{ _counter_values.data(), _counter_values.size() };
+  }
+
+  /**
+   * Appends the values of the given sample as a new row.
+   *
+   * @param sample Sample to add.
+   */
+  void add(const SampleView& sample) { add_sample(sample); }
+
+  /**
+   * Appends the values of the given sample as a new row.
+   *
+   * @param sample Sample to add.
+   */
+  void add(const Sample& sample) { add_sample(sample); }
+
+  /**
+   * Adds the given number of lost samples.
+   *
+   * @param count_loss Number of lost samples.
+   */
+  void add_loss(const std::uint64_t count_loss) noexcept { _count_loss += count_loss; }
+
+  /**
+   * Counts a throttle record, i.e., the perf subsystem throttled sampling since samples were generated too fast.
+   */
+  void add_throttle() noexcept { ++_count_throttle; }
+
+  /**
+   * Translates all rows into perf::Sample objects.
+   *
+   * @return List of samples.
+   */
+  [[nodiscard]] std::vector<Sample> to_samples() const;
+
+  /**
+   * Sorts the rows by their timestamp (if sampled).
+   */
+  void sort_by_time();
+
+  /**
+   * Removes all samples, but keeps the allocated memory of the columns for reuse.
+   */
+  void clear() noexcept;
+
+private:
+  std::vector<Sample::Mode> _modes;
+  std::vector<std::uint8_t> _is_exact_ips;
+  Column<std::uint64_t> _sample_ids;
+  Column<std::uintptr_t> _instruction_pointers;
+  Column<std::uint32_t> _process_ids;
+  Column<std::uint32_t> _thread_ids;
+  Column<std::uint64_t> _times;
+  Column<std::uint64_t> _stream_ids;
+  Column<std::uintptr_t> _logical_memory_addresses;
+  Column<std::uint32_t> _cpu_ids;
+  Column<std::uint64_t> _periods;
+  Column<Weight> _weights;
+  Column<DataSource> _data_sources;
+  Column<TransactionAbort> _transaction_aborts;
+  Column<std::uintptr_t> _physical_memory_addresses;
+  Column<std::uint64_t> _cgroup_ids;
+  Column<std::uint64_t> _data_page_sizes;
+  Column<std::uint64_t> _code_page_sizes;
+
+  /// Names of the sampled counters (in the order of the values in every row).
+  std::vector<std::string_view> _counter_names;
+
+  /// Raw values of all counters; one value per counter and row (empty as long as no sample provided counter values).
+  std::vector<std::uint64_t> _counter_values;
+  Column<std::uint64_t> _counter_times_enabled;
+  Column<std::uint64_t> _counter_times_running;
+  Column<std::uint64_t> _counter_group_ids;
+
+  /// Addresses of all callchains; the callchain of row i spans [offsets[i], offsets[i+1]).
+  std::vector<std::uintptr_t> _callchains;
+  std::vector<std::size_t> _callchain_offsets;
+
+  /// Number of lost samples.
+  std::uint64_t _count_loss{ 0U };
+
+  /// Number of throttle records.
+  std::uint64_t _count_throttle{ 0U };
+
+  template<typename T>
+  [[nodiscard]] static Span<T> span(const Column<T>& column) noexcept
+  {
+    return Span<T>{ column.values().data(), column.values().size() };
+  }
+
+  /**
+   * Appends the sample (either perf::Sample or perf::SampleView) as a new row.
+   */
+  template<typename S>
+  void add_sample(const S& sample);
+
+  /**
+   * Prepares the storage of the counter values for the given row: Earlier rows without counter values are filled
+   * with zeros, as are rows whose number of values does not match the number of counters.
+   *
+   * @param row Row to add.
+   * @param count_values Number of counter values of the row.
+   * @return True, if the values of the row should be appended.
+   */
+  [[nodiscard]] bool reserve_counter_values(std::size_t row, std::size_t count_values);
+};
+}
@@ -0,0 +1,241 @@
+#pragma once
+
+#include "counter.h"
+#include "sample.h"
+#include "sample_view.h"
+#include "sampler.h"
+#include <cstdint>
+#include <linux/perf_event.h>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace perf {
+/**
+ * Binary format of sample files written by the SampleWriter and read by the SampleReader.
+ * A file starts with a header describing the layout of the records (one layout per trigger group of the sampler,
+ * including the sampled counters), followed by chunks of records. Records are stored in the layout written by the
+ * perf subsystem; every chunk holds the records drained from the buffer of a single trigger group.
+ * All sizes are padded to 8 bytes to preserve the alignment of the records.
+ */
+class SampleFile
+{
+public:
+  /// Identifies perf-cpp sample files.
+  constexpr static inline auto MAGIC = std::uint64_t{ 0x31454C504D415350ULL }; /// "PSAMPLE1"
+
+  /// Version of the format.
+  constexpr static inline auto VERSION = std::uint32_t{ 1U };
+
+  struct Header
+  {
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t count_layouts;
+  };
+
+  struct LayoutHeader
+  {
+    std::uint64_t mask;
+    std::uint32_t count_user_registers;
+    std::uint32_t count_kernel_registers;
+    std::uint32_t count_counters;
+
+    /// IBS unit the raw data is decoded for (see AmdIbsDecoder::Type; zero if none) in bits 7:0; bit 8 is set if the
+    /// raw data is also copied into samples.
+    std::uint32_t amd_ibs;
+  };
+
+  /// Followed by the name of the counter (padded to 8 bytes).
+  struct CounterHeader
+  {
+    std::uint32_t type;
+    std::uint32_t name_length;
+    std::uint64_t event_id;
+    std::uint64_t event_id_extension_1;
+    std::uint64_t event_id_extension_2;
+  };
+
+  /// Followed by <size> bytes of records.
+  struct ChunkHeader
+  {
+    std::uint32_t layout_id;
+    std::uint32_t reserved;
+    std::uint64_t size;
+  };
+
+  /**
+   * @return The given size, padded to 8 bytes.
+   */
+  [[nodiscard]] static std::size_t padded(const std::size_t size) noexcept { return (size + 7U) & ~std::size_t{ 7U }; }
+};
+
+/**
+ * The SampleWriter streams the records of a sampler to a file, without decoding them. Every call to write() drains
+ * the buffers of the sampler (i.e., the written records are consumed) and copies the raw records into the file.
+ * This allows long sampling sessions with bounded memory; the file can be analyzed later using the SampleReader.
+ */
+class SampleWriter
+{
+public:
+  /**
+   * Creates (or truncates) the file. The header is written with the first call to write().
+   *
+   * @param sampler Sampler to write the records of; needs to be alive as long as the writer.
+   * @param file_name Name of the file.
+   */
+  SampleWriter(Sampler& sampler, const std::string& file_name);
+  SampleWriter(SampleWriter&&) = delete;
+  SampleWriter(const SampleWriter&) = delete;
+
+  ~SampleWriter() { close(); }
+
+  SampleWriter& operator=(SampleWriter&&) = delete;
+  SampleWriter& operator=(const SampleWriter&) = delete;
+
+  /**
+   * Drains the buffers of the sampler and writes all new records to the file. The sampler needs to be opened.
+   *
+   * @return Number of bytes written.
+   */
+  std::uint64_t write();
+
+  /**
+   * Closes the file.
+   */
+  void close();
+
+private:
+  /// Sampler to drain.
+  Sampler& _sampler;
+
+  /// File descriptor of the file.
+  std::int32_t _file_descriptor{ -1 };
+
+  /// Flag if the header was already written.
+  bool _is_header_written{ false };
+
+  /**
+   * Writes the header, describing the layouts of the sampler's records.
+   */
+  void write_header();
+
+  /**
+   * Writes the given data to the file; throws if the data cannot be written.
+   *
+   * @param data Data to write.
+   * @param size Number of bytes to write.
+   */
+  void write(const void* data, std::size_t size);
+};
+
+/**
+ * The SampleReader maps a file written by the SampleWriter into memory and iterates over the records without copying
+ * them.
+ */
+class SampleReader
+{
+public:
+  /**
+   * Maps the file into memory and reads the header.
+   *
+   * @param file_name Name of the file.
+   */
+  explicit SampleReader(const std::string& file_name);
+  SampleReader(SampleReader&&) = delete;
+  SampleReader(const SampleReader&) = delete;
+
+  ~SampleReader();
+
+  SampleReader& operator=(SampleReader&&) = delete;
+  SampleReader& operator=(const SampleReader&) = delete;
+
+  /**
+   * @return Layouts of the records, one per trigger group of the sampler.
+   */
+  [[nodiscard]] const std::vector<SampleLayout>& layouts() const noexcept { return _layouts; }
+
+  /**
+   * @return Names and configurations of the counters recorded with the samples of every layout.
+   */
+  [[nodiscard]] const std::vector<std::vector<std::pair<std::string_view, CounterConfig>>>& counters() const noexcept
+  {
+    return _counters;
+  }
+
+  /**
+   * Invokes the callback for every sample record in the file (other records, e.g., loss records, are skipped).
+   * The SampleView passed to the callback is valid as long as the reader is alive.
+   *
+   * @param callback Callback that is invoked with a const SampleView& for every sample record.
+   */
+  template<typename F>
+  void for_each(F&& callback) const
+  {
+    this->for_each_record([&callback](const perf_event_header* header, const SampleLayout& layout) {
+      if (header->type == PERF_RECORD_SAMPLE) {
+        callback(SampleView{ header, layout });
+      }
+    });
+  }
+
+  /**
+   * @param sort_by_time Flag to sort the samples by timestamp attribute (if sampled).
+   * @return List of all samples in the file.
+   */
+  [[nodiscard]] std::vector<Sample> result(bool sort_by_time = true) const;
+
+private:
+  /// Memory-mapped file.
+  const std::uint8_t* _data{ nullptr };
+
+  /// Size of the file.
+  std::size_t _size{ 0U };
+
+  /// Start of the first chunk.
+  std::size_t _chunks_begin{ 0U };
+
+  /// Layouts of the records.
+  std::vector<SampleLayout> _layouts;
+
+  /// Counters of every layout.
+  std::vector<std::vector<std::pair<std::string_view, CounterConfig>>> _counters;
+
+  /**
+   * Invokes the callback for every record in the file.
+   *
+   * @param callback Callback that is invoked with the header of the record and its layout.
+   */
+  template<typename F>
+  void for_each_record(F&& callback) const
+  {
+    auto position = _chunks_begin;
+    while (position + sizeof(SampleFile::ChunkHeader) <= _size) {
+      const auto* chunk = reinterpret_cast<const SampleFile::ChunkHeader*>(_data + position);
+      position += sizeof(SampleFile::ChunkHeader);
+
+      /// Skip truncated or corrupted chunks.
+      if (chunk->layout_id >= _layouts.size() || position + chunk->size > _size) {
+        return;
+      }
+
+      const auto& layout = _layouts[chunk->layout_id];
+      const auto chunk_end = position + chunk->size;
+      while (position + sizeof(perf_event_header) <= chunk_end) {
+        const auto* header = reinterpret_cast<const perf_event_header*>(_data + position);
+
+        /// Skip the rest of the chunk if the record is corrupted or exceeds the chunk.
+        if (header->size < sizeof(perf_event_header) || position + header->size > chunk_end) {
+          break;
+        }
+
+        callback(header, layout);
+        position += header->size;
+      }
+
+      position = chunk_end;
+    }
+  }
+};
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "sample_batch.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace perf {
+/**
+ * The SampleQueue hands batches of samples from producers (e.g., the threads draining the samplers in the background,
+ * see MultiSamplerBase::background_drain(SampleQueue&)) to consumers (e.g., aggregation or export threads) without
+ * locks. The queue is a bounded ring of slots (each on its own cache line) that are claimed through a per-slot sequence
+ * number, such that any number of producers and consumers can access the queue concurrently.
+ * Batches are exchanged by swapping: Pushing a batch hands its memory to the queue and returns an (empty) batch
+ * previously popped by a consumer; popping hands the consumer's old batch back to the queue. Once the slots are
+ * populated, the queue does not allocate memory and its size stays fixed.
+ * If the queue is full, the backpressure policy decides whether producers wait for consumers or batches are dropped
+ * (and counted).
+ */
+class SampleQueue
+{
+public:
+  /// Behavior when pushing into a full queue.
+  enum class Backpressure : std::uint8_t
+  {
+    /// Wait until a consumer pops a batch.
+    Block,
+
+    /// Drop the pushed (newest) batch.
+    DropNewest,
+
+    /// Drop the oldest batch in the queue to make room for the pushed one.
+    DropOldest
+  };
+
+  /**
+   * Creates a queue.
+   *
+   * @param capacity Maximal number of batches in the queue (rounded up to the next power of two).
+   * @param backpressure Behavior when pushing into a full queue.
+   */
+  explicit SampleQueue(std::size_t capacity = 64U, Backpressure backpressure = Backpressure::Block);
+  SampleQueue(SampleQueue&&) = delete;
+  SampleQueue(const SampleQueue&) = delete;
+  ~SampleQueue() = default;
+
+  SampleQueue& operator=(SampleQueue&&) = delete;
+  SampleQueue& operator=(const SampleQueue&) = delete;
+
+  /**
+   * Pushes the batch into the queue. The batch is swapped with the (cleared) batch the slot held before, i.e., the
+   * given batch can be re-filled without allocating memory.
+   *
+   * @param batch Batch to push; empty after the call.
+   * @return True, if the batch was queued; false, if it was dropped or the queue is closed.
+   */
+  bool push(SampleBatch& batch);
+
+  /**
+   * Pushes the batch into the queue without waiting and without applying the backpressure policy (see push()).
+   *
+   * @param batch Batch to push; empty after the call, if the batch was queued.
+   * @return True, if the batch was queued; false, if the queue is full.
+   */
+  bool try_push(SampleBatch& batch);
+
+  /**
+   * Pops the oldest batch from the queue without waiting. The batch is swapped with the given one, which is handed
+   * back to the producers.
+   *
+   * @param batch Batch that receives the popped samples.
+   * @return True, if a batch was popped; false, if the queue is empty.
+   */
+  bool try_pop(SampleBatch& batch);
+
+  /**
+   * Pops the oldest batch from the queue, waiting until a batch is pushed or the queue is closed.
+   *
+   * @param batch Batch that receives the popped samples.
+   * @return True, if a batch was popped; false, if the queue is closed and empty.
+   */
+  bool pop(SampleBatch& batch);
+
+  /**
+   * Closes the queue: Further batches are not queued and waiting producers and consumers return. Batches that are
+   * already queued can still be popped.
+   */
+  void close() noexcept { _is_closed.store(true, std::memory_order_release); }
+
+  /**
+   * @return True, if the queue is closed.
+   */
+  [[nodiscard]] bool is_closed() const noexcept { return _is_closed.load(std::memory_order_acquire); }
+
+  /**
+   * @return Behavior when pushing into a full queue.
+   */
+  [[nodiscard]] Backpressure backpressure() const noexcept { return _backpressure; }
+
+  /**
+   * @return Maximal number of batches in the queue.
+   */
+  [[nodiscard]] std::size_t capacity() const noexcept { return _mask + 1U; }
+
+  /**
+   * @return Number of batches in the queue (a snapshot, while producers and consumers are active).
+   */
+  [[nodiscard]] std::size_t size() const noexcept;
+
+  /**
+   * @return Number of batches that were queued.
+   */
+  [[nodiscard]] std::uint64_t count_pushed_batches() const noexcept
+  {
+    return _count_pushed_batches.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @return Number of batches that were dropped because the queue was full.
+   */
+  [[nodiscard]] std::uint64_t count_dropped_batches() const noexcept
+  {
+    return _count_dropped_batches.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @return Number of samples in the dropped batches.
+   */
+  [[nodiscard]] std::uint64_t count_dropped_samples() const noexcept
+  {
+    return _count_dropped_samples.load(std::memory_order_relaxed);
+  }
+
+private:
+  /// Size of a cache line; slots and positions are aligned to avoid false sharing between producers and consumers.
+  constexpr static inline auto CACHE_LINE_SIZE = std::size_t{ 64U };
+
+  struct alignas(CACHE_LINE_SIZE) Slot
+  {
+    /// Equals the position for writing into the slot and position + 1 for reading from the slot.
+    std::atomic<std::uint64_t> sequence{ 0U };
+    SampleBatch batch;
+  };
+
+  /// Ring of slots.
+  std::unique_ptr<Slot[]> _slots;
+
+  /// Capacity - 1 (the capacity is a power of two).
+  std::uint64_t _mask;
+
+  Backpressure _backpressure;
+
+  /// Next position to push into.
+  alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> _push_position{ 0U };
+
+  /// Next position to pop from.
+  alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> _pop_position{ 0U };
+
+  alignas(CACHE_LINE_SIZE) std::atomic<bool> _is_closed{ false };
+  std::atomic<std::uint64_t> _count_pushed_batches{ 0U };
+  std::atomic<std::uint64_t> _count_dropped_batches{ 0U };
+  std::atomic<std::uint64_t> _count_dropped_samples{ 0U };
+
+  /**
+   * Waits a moment before retrying a push or pop: first spinning, then yielding, and finally sleeping.
+   *
+   * @param attempt Number of failed attempts.
+   */
+  static void backoff(std::uint32_t attempt);
+};
+}
@@ -0,0 +1,493 @@
+#pragma once
+
+#include "amd_ibs_decoder.h"
+#include "counter.h"
+#include "data_source.h"
+#include "feature.h"
+#include "sample.h"
+#include "transaction.h"
+#include "weight.h"
+#include <array>
+#include <cstdint>
+#include <linux/perf_event.h>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace perf {
+/**
+ * Read-only view on a contiguous sequence of elements (like std::span, which is not available in C++17).
+ */
+template<typename T>
+class Span
+{
+public:
+  using value_type = T;
+  using const_iterator = const T*;
+
+  Span() noexcept = default;
+  Span(const T* data, const std::size_t size) noexcept
+    : _data(data)
+    , _size(size)
+  {
+  }
+
+  ~Span() noexcept = default;
+
+  [[nodiscard]] const T* data() const noexcept { return _data; }
+  [[nodiscard]] std::size_t size() const noexcept { return _size; }
+  [[nodiscard]] bool empty() const noexcept { return _size == 0U; }
+
+  [[nodiscard]] const T& operator[](const std::size_t index) const noexcept { return _data[index]; }
+
+  [[nodiscard]] const_iterator begin() const noexcept { return _data; }
+  [[nodiscard]] const_iterator end() const noexcept { return _data + _size; }
+
+private:
+  const T* _data{ nullptr };
+  std::size_t _size{ 0U };
+};
+
+/**
+ * The SampleLayout describes the values included in the sample records of a single sample counter (i.e., the sample
+ * type mask and the number of sampled registers and counters). The layout is fixed once the sampler is opened.
+ * Since the mask does not change, the layout precomputes the offset of every value: Values are grouped into segments
+ * that are separated by variable-sized values (e.g., the callchain); the offset of a value within its segment is
+ * static. Decoding a record only needs to resolve the sizes of the (few) variable-sized values.
+ */
+class SampleLayout
+{
+public:
+  /**
+   * Values of a sample record, in the order they are written by the perf subsystem.
+   */
+  enum class Field : std::uint8_t
+  {
+    SampleId,
+    InstructionPointer,
+    ThreadId,
+    Time,
+    StreamId,
+    LogicalMemoryAddress,
+    CpuId,
+    Period,
+    CounterValues,
+    Callchain,
+    Raw,
+    Branches,
+    UserRegisters,
+    Weight,
+    DataSource,
+    TransactionAbort,
+    KernelRegisters,
+    PhysicalMemoryAddress,
+    CGroupId,
+    DataPageSize,
+    CodePageSize,
+    Count
+  };
+
+  /// Maximal number of variable-sized values (counter values, callchain, raw, branches, user and kernel registers).
+  constexpr static inline auto MAX_VARIABLE_FIELDS = std::size_t{ 6U };
+
+  SampleLayout() noexcept = default;
+  SampleLayout(std::uint64_t mask,
+               std::size_t count_user_registers,
+               std::size_t count_kernel_registers,
+               std::vector<std::string_view> counter_names);
+
+  ~SampleLayout() noexcept = default;
+
+  /**
+   * @return True, if the given perf field (e.g., PERF_SAMPLE_TIME) is included in the records.
+   */
+  [[nodiscard]] bool is_set(const std::uint64_t perf_field) const noexcept
+  {
+    return static_cast<bool>(_mask & perf_field);
+  }
+
+  [[nodiscard]] std::uint64_t mask() const noexcept { return _mask; }
+  [[nodiscard]] std::size_t count_user_registers() const noexcept { return _count_user_registers; }
+  [[nodiscard]] std::size_t count_kernel_registers() const noexcept { return _count_kernel_registers; }
+  [[nodiscard]] const std::vector<std::string_view>& counter_names() const noexcept { return _counter_names; }
+
+  /**
+   * Lets the records be decoded as AMD IBS samples (see Sampler::Values::amd_ibs()); the mask has to include the raw
+   * data (PERF_SAMPLE_RAW).
+   *
+   * @param type IBS unit that records the samples.
+   * @param is_copy_raw True, if the raw data should (also) be copied into perf::Sample objects.
+   */
+  void amd_ibs(const AmdIbsDecoder::Type type, const bool is_copy_raw) noexcept
+  {
+    _amd_ibs_type = type;
+    _is_copy_raw = is_copy_raw;
+  }
+
+  /**
+   * @return The IBS unit if the records are decoded as AMD IBS samples, std::nullopt otherwise.
+   */
+  [[nodiscard]] std::optional<AmdIbsDecoder::Type> amd_ibs_type() const noexcept { return _amd_ibs_type; }
+
+  /**
+   * @return True, if the raw data is copied into perf::Sample objects.
+   */
+  [[nodiscard]] bool is_copy_raw() const noexcept { return _is_copy_raw; }
+
+  /**
+   * @return Offset of the value within its segment.
+   */
+  [[nodiscard]] std::uint16_t offset(const Field field) const noexcept
+  {
+    return _offsets[static_cast<std::size_t>(field)];
+  }
+
+  /**
+   * @return Segment of the value, i.e., the number of variable-sized values preceding the value.
+   */
+  [[nodiscard]] std::uint8_t segment(const Field field) const noexcept
+  {
+    return _segments[static_cast<std::size_t>(field)];
+  }
+
+  /**
+   * @return Number of variable-sized values included in the records.
+   */
+  [[nodiscard]] std::size_t count_variable_fields() const noexcept { return _count_variable_fields; }
+
+  /**
+   * @return The variable-sized values included in the records, in the order they are written.
+   */
+  [[nodiscard]] const std::array<Field, MAX_VARIABLE_FIELDS>& variable_fields() const noexcept
+  {
+    return _variable_fields;
+  }
+
+private:
+  /// Mask of sampled values (PERF_SAMPLE_*).
+  std::uint64_t _mask{ 0ULL };
+
+  /// Number of sampled user-level registers.
+  std::size_t _count_user_registers{ 0U };
+
+  /// Number of sampled kernel-level registers.
+  std::size_t _count_kernel_registers{ 0U };
+
+  /// Names of the counters recorded with every sample (PERF_SAMPLE_READ).
+  std::vector<std::string_view> _counter_names;
+
+  /// IBS unit, if the raw data is decoded as AMD IBS registers.
+  std::optional<AmdIbsDecoder::Type> _amd_ibs_type{ std::nullopt };
+
+  /// Flag if the raw data is copied into perf::Sample objects (false if only requested for decoding IBS).
+  bool _is_copy_raw{ true };
+
+  /// Offset of every value within its segment.
+  std::array<std::uint16_t, static_cast<std::size_t>(Field::Count)> _offsets{};
+
+  /// Segment of every value.
+  std::array<std::uint8_t, static_cast<std::size_t>(Field::Count)> _segments{};
+
+  /// Variable-sized values, in the order they are written.
+  std::array<Field, MAX_VARIABLE_FIELDS> _variable_fields{};
+  std::size_t _count_variable_fields{ 0U };
+};
+
+/**
+ * The SampleView is a lightweight, non-owning view on a single sample record within the user-level buffer.
+ * In contrast to perf::Sample, values are decoded only when they are accessed, and variable-sized values (e.g.,
+ * callchains or branch stacks) are exposed as spans into the record – no memory is allocated.
+ * The view (including all spans) is only valid as long as the underlying record is not consumed, i.e., within the
+ * callback of Sampler::for_each() and Sampler::drain().
+ */
+class SampleView
+{
+public:
+  /// Value and ID of a counter, recorded with PERF_SAMPLE_READ.
+  using CounterValue = CounterReadFormat<1U>::value;
+
+  SampleView(const perf_event_header* header, const SampleLayout& layout) noexcept;
+  ~SampleView() noexcept = default;
+
+  /**
+   * @return The mode in which the sample was taken (e.g., Kernel, User, Hypervisor).
+   */
+  [[nodiscard]] Sample::Mode mode() const noexcept;
+
+  /**
+   * @return True, if the instruction pointer points to the instruction that caused the sample.
+   */
+  [[nodiscard]] bool is_exact_ip() const noexcept { return static_cast<bool>(_misc & PERF_RECORD_MISC_EXACT_IP); }
+
+  [[nodiscard]] std::optional<std::uint64_t> sample_id() const noexcept
+  {
+    return read_if<std::uint64_t>(PERF_SAMPLE_IDENTIFIER, Field::SampleId);
+  }
+
+  [[nodiscard]] std::optional<std::uintptr_t> instruction_pointer() const noexcept
+  {
+    return read_if<std::uintptr_t>(PERF_SAMPLE_IP, Field::InstructionPointer);
+  }
+
+  [[nodiscard]] std::optional<std::uint32_t> process_id() const noexcept
+  {
+    return read_if<std::uint32_t>(PERF_SAMPLE_TID, Field::ThreadId);
+  }
+
+  [[nodiscard]] std::optional<std::uint32_t> thread_id() const noexcept
+  {
+    return read_if<std::uint32_t>(PERF_SAMPLE_TID, Field::ThreadId, sizeof(std::uint32_t));
+  }
+
+  [[nodiscard]] std::optional<std::uint64_t> time() const noexcept
+  {
+    return read_if<std::uint64_t>(PERF_SAMPLE_TIME, Field::Time);
+  }
+
+  [[nodiscard]] std::optional<std::uint64_t> stream_id() const noexcept
+  {
+    return read_if<std::uint64_t>(PERF_SAMPLE_STREAM_ID, Field::StreamId);
+  }
+
+  [[nodiscard]] std::optional<std::uintptr_t> logical_memory_address() const noexcept
+  {
+    if (const auto amd_ibs = this->amd_ibs(); amd_ibs.has_value()) {
+      return amd_ibs->logical_memory_address();
+    }
+
+    return read_if<std::uintptr_t>(PERF_SAMPLE_ADDR, Field::LogicalMemoryAddress);
+  }
+
+  [[nodiscard]] std::optional<std::uint32_t> cpu_id() const noexcept
+  {
+    return read_if<std::uint32_t>(PERF_SAMPLE_CPU, Field::CpuId);
+  }
+
+  [[nodiscard]] std::optional<std::uint64_t> period() const noexcept
+  {
+    return read_if<std::uint64_t>(PERF_SAMPLE_PERIOD, Field::Period);
+  }
+
+  /**
+   * @return The raw counter values recorded with the sample (not corrected for multiplexing); empty if not sampled.
+   */
+  [[nodiscard]] Span<CounterValue> counter_values() const noexcept;
+
+  /**
+   * Reads the value of the counter with the given name, corrected for multiplexing.
+   *
+   * @param name Name of the counter (either a trigger or a counter requested via Sampler::Values::counter()).
+   * @return The value of the counter, std::nullopt if not sampled.
+   */
+  [[nodiscard]] std::optional<double> counter_value(std::string_view name) const noexcept;
+
+  /**
+   * @return All counter values including their names, corrected for multiplexing (allocates memory).
+   */
+  [[nodiscard]] std::optional<CounterResult> counter_result() const;
+
+  /**
+   * @return Names of the counters in the order of counter_values(); shared by all samples of the sampler.
+   */
+  [[nodiscard]] const std::vector<std::string_view>& counter_names() const noexcept
+  {
+    return _layout->counter_names();
+  }
+
+  /**
+   * @return Time (in nanoseconds) the counters were enabled, std::nullopt if no counter values were sampled.
+   */
+  [[nodiscard]] std::optional<std::uint64_t> counter_time_enabled() const noexcept
+  {
+    return read_if<std::uint64_t>(PERF_SAMPLE_READ, Field::CounterValues, sizeof(std::uint64_t));
+  }
+
+  /**
+   * @return Time (in nanoseconds) the counters were running (i.e., scheduled on the PMU), std::nullopt if no counter
+   * values were sampled.
+   */
+  [[nodiscard]] std::optional<std::uint64_t> counter_time_running() const noexcept
+  {
+    return read_if<std::uint64_t>(PERF_SAMPLE_READ, Field::CounterValues, sizeof(std::uint64_t) * 2U);
+  }
+
+  /**
+   * @return The callchain (instruction pointers); empty if not sampled.
+   */
+  [[nodiscard]] Span<std::uint64_t> callchain() const noexcept;
+
+  /**
+   * @return The raw data; empty if not sampled.
+   */
+  [[nodiscard]] Span<char> raw() const noexcept;
+
+  /**
+   * @return Decoder for the IBS registers in the raw data, if the sample was recorded by an AMD IBS trigger and
+   * decoding was requested (see Sampler::Values::amd_ibs()). Decoded values take precedence over the values recorded
+   * by the perf subsystem for the memory addresses, the weight, and the data source.
+   */
+  [[nodiscard]] std::optional<AmdIbsDecoder> amd_ibs() const noexcept
+  {
+    if (const auto type = _layout->amd_ibs_type(); type.has_value()) {
+      const auto raw = this->raw();
+      return AmdIbsDecoder{ type.value(), raw.data(), raw.size() };
+    }
+
+    return std::nullopt;
+  }
+
+  /**
+   * @return The branch stack as recorded by the perf subsystem; empty if not sampled.
+   */
+  [[nodiscard]] Span<perf_branch_entry> branches() const noexcept;
+
+  [[nodiscard]] std::optional<std::uint64_t> user_registers_abi() const noexcept
+  {
+    return read_if<std::uint64_t>(PERF_SAMPLE_REGS_USER, Field::UserRegisters);
+  }
+
+  /**
+   * @return Values of the sampled user-level registers; empty if not sampled.
+   */
+  [[nodiscard]] Span<std::uint64_t> user_registers() const noexcept
+  {
+    return registers(PERF_SAMPLE_REGS_USER, Field::UserRegisters, _layout->count_user_registers());
+  }
+
+  [[nodiscard]] std::optional<Weight> weight() const noexcept;
+
+  [[nodiscard]] std::optional<DataSource> data_src() const noexcept
+  {
+    if (const auto amd_ibs = this->amd_ibs(); amd_ibs.has_value()) {
+      return amd_ibs->data_src();
+    }
+
+    if (const auto data_source = read_if<std::uint64_t>(PERF_SAMPLE_DATA_SRC, Field::DataSource);
+        data_source.has_value()) {
+      return DataSource{ data_source.value() };
+    }
+
+    return std::nullopt;
+  }
+
+  [[nodiscard]] std::optional<TransactionAbort> transaction_abort() const noexcept
+  {
+    if (const auto transaction = read_if<std::uint64_t>(PERF_SAMPLE_TRANSACTION, Field::TransactionAbort);
+        transaction.has_value()) {
+      return TransactionAbort{ transaction.value() };
+    }
+
+    return std::nullopt;
+  }
+
+  [[nodiscard]] std::optional<std::uint64_t> kernel_registers_abi() const noexcept
+  {
+    return read_if<std::uint64_t>(PERF_SAMPLE_REGS_INTR, Field::KernelRegisters);
+  }
+
+  /**
+   * @return Values of the sampled kernel-level registers; empty if not sampled.
+   */
+  [[nodiscard]] Span<std::uint64_t> kernel_registers() const noexcept
+  {
+    return registers(PERF_SAMPLE_REGS_INTR, Field::KernelRegisters, _layout->count_kernel_registers());
+  }
+
+  [[nodiscard]] std::optional<std::uintptr_t> physical_memory_address() const noexcept
+  {
+    if (const auto amd_ibs = this->amd_ibs(); amd_ibs.has_value()) {
+      return amd_ibs->physical_memory_address();
+    }
+
+#ifndef PERFCPP_NO_SAMPLE_PHYS_ADDR
+    return read_if<std::uintptr_t>(PERF_SAMPLE_PHYS_ADDR, Field::PhysicalMemoryAddress);
+#else
+    return std::nullopt;
+#endif
+  }
+
+  [[nodiscard]] std::optional<std::uint64_t> cgroup_id() const noexcept
+  {
+    return read_if<std::uint64_t>(PERF_SAMPLE_CGROUP, Field::CGroupId);
+  }
+
+  [[nodiscard]] std::optional<std::uint64_t> data_page_size() const noexcept
+  {
+#ifndef PERFCPP_NO_SAMPLE_DATA_PAGE_SIZE
+    return read_if<std::uint64_t>(PERF_SAMPLE_DATA_PAGE_SIZE, Field::DataPageSize);
+#else
+    return std::nullopt;
+#endif
+  }
+
+  [[nodiscard]] std::optional<std::uint64_t> code_page_size() const noexcept
+  {
+#ifndef PERFCPP_NO_SAMPLE_CODE_PAGE_SIZE
+    return read_if<std::uint64_t>(PERF_SAMPLE_CODE_PAGE_SIZE, Field::CodePageSize);
+#else
+    return std::nullopt;
+#endif
+  }
+
+  /**
+   * Decodes all values of the record into a (self-contained) Sample.
+   *
+   * @return Sample holding a copy of all recorded values.
+   */
+  [[nodiscard]] Sample to_sample() const;
+
+private:
+  using Field = SampleLayout::Field;
+
+  /// First byte of the record (after the header).
+  const std::uint8_t* _data;
+
+  /// Layout describing which values are included.
+  const SampleLayout* _layout;
+
+  /// Misc field of the record header.
+  std::uint16_t _misc;
+
+  /// Start (in bytes, from _data) of every segment, i.e., the record start followed by the end of every
+  /// variable-sized value.
+  std::array<std::uint16_t, SampleLayout::MAX_VARIABLE_FIELDS + 1U> _segment_starts{};
+
+  /**
+   * @return Offset (in bytes, from _data) of the given value.
+   */
+  [[nodiscard]] std::uint16_t offset(const Field field) const noexcept
+  {
+    return _segment_starts[_layout->segment(field)] + _layout->offset(field);
+  }
+
+  /**
+   * @return The size of the variable-sized value that starts at the given position.
+   */
+  [[nodiscard]] std::uint16_t variable_size(Field field, std::uint16_t position) const noexcept;
+
+  template<typename T>
+  [[nodiscard]] T read(const Field field, const std::size_t offset = 0U) const noexcept
+  {
+    return *reinterpret_cast<const T*>(_data + this->offset(field) + offset);
+  }
+
+  template<typename T>
+  [[nodiscard]] std::optional<T> read_if(const std::uint64_t perf_field,
+                                         const Field field,
+                                         const std::size_t offset = 0U) const noexcept
+  {
+    if (_layout->is_set(perf_field)) {
+      return read<T>(field, offset);
+    }
+
+    return std::nullopt;
+  }
+
+  /**
+   * Reads the registers following the ABI (the perf subsystem does not record any registers if the ABI is "none").
+   */
+  [[nodiscard]] Span<std::uint64_t> registers(std::uint64_t perf_field,
+                                              Field field,
+                                              std::size_t count_registers) const noexcept;
+};
+}
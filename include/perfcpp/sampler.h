@@ -1,23 +1,46 @@
 #pragma once
 
+#include "arm_spe_decoder.h"
 #include "config.h"
 #include "counter_definition.h"
 #include "feature.h"
 #include "group.h"
+#include "numa_topology.h"
 #include "sample.h"
+#include "sample_arena.h"
+#include "sample_batch.h"
+#include "sample_queue.h"
+#include "sample_view.h"
+#include "thread_registry.h"
+#include "time_conversion.h"
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstring>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 namespace perf {
+class SampleDrainer;
+class SampleWriter;
 class MultiSamplerBase;
 class MultiThreadSampler;
 class MultiCoreSampler;
-class Sampler
+class MultiProcessSampler;
+
+/// Aligned to cache lines, since samplers of different threads are often stored next to each other.
+class alignas(64U) Sampler
 {
+  friend SampleDrainer;
+  friend SampleWriter;
   friend MultiSamplerBase;
 
 public:
@@ -197,6 +220,25 @@ public:
       return *this;
     }
 
+    Values& mmap(const bool include) noexcept
+    {
+      _is_include_mmap = include;
+      return *this;
+    }
+
+    /**
+     * Decodes the registers recorded by AMD IBS triggers (e.g., "ibs_op") into the logical and physical memory
+     * address, the latency (weight), and the data source of samples. The registers are recorded as raw data, which
+     * is decoded in place from the buffer and only copied into samples if requested via raw().
+     *
+     * @param include True, if samples of IBS triggers should be decoded.
+     */
+    Values& amd_ibs(const bool include) noexcept
+    {
+      _is_decode_amd_ibs = include;
+      return *this;
+    }
+
     [[nodiscard]] bool is_set(const std::uint64_t perf_field) const noexcept
     {
       return static_cast<bool>(_mask & perf_field);
@@ -221,6 +263,8 @@ public:
 
     bool _is_include_context_switch{ false };
     bool _is_include_throttle{ false };
+    bool _is_include_mmap{ false };
+    bool _is_decode_amd_ibs{ false };
 
     void set(const std::uint64_t perf_field, const bool is_enabled) noexcept
     {
@@ -439,10 +483,194 @@ public:
    */
   void close();
 
+  /**
+   * Changes the sampling period of all triggers while the sampler is opened (via PERF_EVENT_IOC_PERIOD). The period
+   * takes effect with the next overflow; samples recorded with Values::period() carry the period in effect.
+   *
+   * @param period New sampling period.
+   * @return True, if the period was changed for all triggers.
+   */
+  bool update_period(std::uint64_t period);
+
   /**
    * @return List of sampled events after closing the sampler.
    */
   [[nodiscard]] std::vector<Sample> result(bool sort_by_time = true) const;
+
+  /**
+   * Reads all samples that were recorded since the last call to drain() and hands the consumed space of the
+   * user-level buffer back to the perf subsystem. In contrast to result(), drain() can be called while the sampler is
+   * running, which enables long sampling sessions with a small buffer (see SampleConfig::buffer_pages()).
+   *
+   * @param sort_by_time Flag to sort the samples by timestamp attribute (if sampled).
+   * @return List of sampled events recorded since the last drain.
+   */
+  [[nodiscard]] std::vector<Sample> drain(bool sort_by_time = true);
+
+  /**
+   * Copies all sample records into the given arena (see result()). The arena is cleared before; its memory is reused.
+   * In contrast to result(), no memory is allocated per sample.
+   *
+   * @param arena Arena that receives the sample records.
+   * @param sort_by_time Flag to sort the samples by timestamp attribute (if sampled).
+   */
+  void result(SampleArena& arena, bool sort_by_time = true) const;
+
+  /**
+   * Copies all sample records that were recorded since the last drain into the given arena and hands the consumed
+   * space of the user-level buffer back to the perf subsystem (see drain()). The arena is cleared before; its memory
+   * is reused, which makes repeated draining free of allocations once the arena has grown.
+   *
+   * @param arena Arena that receives the sample records.
+   * @param sort_by_time Flag to sort the samples by timestamp attribute (if sampled).
+   */
+  void drain(SampleArena& arena, bool sort_by_time = true);
+
+  /**
+   * Reads all samples into the given batch, which stores only the sampled values column-wise (see result()). The
+   * batch is cleared before; its memory is reused.
+   *
+   * @param batch Batch that receives the samples.
+   * @param sort_by_time Flag to sort the samples by timestamp attribute (if sampled).
+   */
+  void result(SampleBatch& batch, bool sort_by_time = true) const;
+
+  /**
+   * Reads all samples that were recorded since the last drain into the given batch and hands the consumed space of the
+   * user-level buffer back to the perf subsystem (see drain()). The batch is cleared before; its memory is reused.
+   *
+   * @param batch Batch that receives the samples.
+   * @param sort_by_time Flag to sort the samples by timestamp attribute (if sampled).
+   */
+  void drain(SampleBatch& batch, bool sort_by_time = true);
+
+  /**
+   * Invokes the callback for every sample record in the user-level buffer, without translating the records into
+   * perf::Sample objects. The SampleView passed to the callback decodes values lazily from the buffer and is only
+   * valid during the callback. Like result(), the records are not consumed; records other than samples (e.g., loss or
+   * context switch records) are skipped.
+   *
+   * @param callback Callback that is invoked with a const SampleView& for every sample record.
+   */
+  template<typename F>
+  void for_each(F&& callback) const
+  {
+    this->visit_samples(callback, false);
+  }
+
+  /**
+   * Invokes the callback for every sample record that was recorded since the last drain (see for_each()) and hands
+   * the consumed space of the user-level buffer back to the perf subsystem.
+   *
+   * @param callback Callback that is invoked with a const SampleView& for every sample record.
+   */
+  template<typename F, typename = std::enable_if_t<std::is_invocable_v<F&, const SampleView&>>>
+  void drain(F&& callback)
+  {
+    this->visit_samples(callback, true);
+  }
+
+  /**
+   * Invokes the callback with the raw trace data that was written into the AUX area (see SampleConfig::aux_pages())
+   * since the last drain and hands the consumed space back to the perf subsystem. Since the AUX area is a ring, the
+   * data of every trigger is passed in up to two contiguous chunks, which are only valid during the callback. Note
+   * that the user-level buffer still receives the PERF_RECORD_AUX records, which are consumed by drain().
+   *
+   * @param callback Callback that is invoked with (const std::uint8_t* data, std::size_t size) for every chunk.
+   */
+  template<typename F>
+  void drain_aux(F&& callback)
+  {
+    if (this->_config.is_aux_snapshot()) {
+      throw std::runtime_error{ "Cannot drain the AUX area in snapshot mode, use aux_snapshot() instead." };
+    }
+
+    for (const auto& sample_counter : this->_sample_counter) {
+      sample_counter.read_aux(
+        [&callback](const std::uint8_t* first, const std::size_t first_size, const std::uint8_t* second,
+                    const std::size_t second_size) {
+          if (first_size > 0U) {
+            callback(first, first_size);
+          }
+          if (second_size > 0U) {
+            callback(second, second_size);
+          }
+        },
+        true);
+    }
+  }
+
+  /**
+   * Reads the parameters to translate between sample timestamps (see Sample::time()) and the cycle counter (e.g.,
+   * rdtsc) or the system clock from the metadata page of the buffer. The sampler needs to be opened.
+   *
+   * @return The conversion, or std::nullopt if the sampler is not opened or the time cannot be converted.
+   */
+  [[nodiscard]] std::optional<TimeConversion> time_conversion() const;
+
+  /**
+   * Returns the file descriptors of all counters that own a user-level buffer. The file descriptors become readable
+   * (POLLIN/EPOLLIN) when the perf subsystem signals new records (see SampleConfig::wakeup_events() and
+   * SampleConfig::wakeup_watermark()) and can be registered at an existing event loop (e.g., epoll or io_uring), which
+   * calls drain() once a file descriptor is ready. The file descriptors are owned by the sampler and valid until the
+   * sampler is closed.
+   *
+   * @return List of file descriptors of all counters that own a user-level buffer.
+   */
+  [[nodiscard]] std::vector<std::int64_t> buffer_file_descriptors() const;
+
+  /**
+   * Blocks (via poll()) until the perf subsystem signals that the buffer can be read (see
+   * SampleConfig::wakeup_events() and SampleConfig::wakeup_watermark()) or the timeout expires. Buffers of counters
+   * that hung up (e.g., since the monitored process exited) are no longer waited for once they are drained.
+   *
+   * @param timeout Maximal time to wait; waits without limit if std::nullopt.
+   * @return True, if at least one buffer can be read; false, if the timeout expired or all counters hung up and their
+   * buffers are drained (i.e., no further records will arrive).
+   */
+  [[nodiscard]] bool wait(std::optional<std::chrono::milliseconds> timeout = std::nullopt) const;
+
+  /**
+   * Waits until the perf subsystem signals that the buffer can be read (see wait()) and invokes the callback for every
+   * sample record that was recorded since the last drain (see drain(callback)). Calling poll() in a loop reacts to
+   * new records without busy polling; with SampleConfig::wakeup_events(1U), the callback is invoked shortly after
+   * every overflow.
+   *
+   * @param callback Callback that is invoked with a const SampleView& for every sample record.
+   * @param timeout Maximal time to wait; waits without limit if std::nullopt.
+   * @return True, if the buffer was signaled and drained; false, if the timeout expired.
+   */
+  template<typename F, typename = std::enable_if_t<std::is_invocable_v<F&, const SampleView&>>>
+  bool poll(F&& callback, const std::optional<std::chrono::milliseconds> timeout = std::nullopt)
+  {
+    if (!this->wait(timeout)) {
+      return false;
+    }
+
+    this->visit_samples(callback, true);
+    return true;
+  }
+
+  /**
+   * Copies the most recent trace data from the AUX area, which has to be mapped in snapshot mode (see
+   * SampleConfig::aux_snapshot()). While recording, the trace is stopped during the copy such that the hardware
+   * flushes its data, and continues afterward.
+   *
+   * @return Trace data of all triggers (oldest data first); at most the size of the AUX area per trigger.
+   */
+  [[nodiscard]] std::vector<std::uint8_t> aux_snapshot();
+
+  /**
+   * Decodes the Arm SPE records written into the AUX area since the last drain (see drain_aux()) into samples. The
+   * samples provide the instruction pointer, the logical and physical memory address, the latencies (total, issue,
+   * and translation latency as perf::Weight), and the data source; timestamps are ticks of the generic timer. Records
+   * that are split by the end of the drained data are completed by the next call. In snapshot mode, feed the data
+   * returned by aux_snapshot() into a perf::ArmSpeDecoder instead.
+   *
+   * @return List of samples decoded since the last drain.
+   */
+  [[nodiscard]] std::vector<Sample> drain_arm_spe();
+
 private:
   /**
    * Represents a counter that is configured to sample;
@@ -464,13 +692,189 @@ private:
 
     ~SampleCounter();
 
-    void buffer(void* buffer, const std::uint64_t buffer_pages) noexcept { _buffer = buffer; _buffer_pages = buffer_pages; }
+    void buffer(void* buffer, const std::uint64_t buffer_pages, const std::int64_t buffer_file_descriptor) noexcept
+    {
+      _buffer = buffer;
+      _buffer_pages = buffer_pages;
+      _buffer_file_descriptor = buffer_file_descriptor;
+    }
 
     [[nodiscard]] Group& group() noexcept { return _group; }
     [[nodiscard]] const Group& group() const noexcept { return _group; }
     [[nodiscard]] void* buffer() const noexcept { return _buffer; }
+    [[nodiscard]] std::uint64_t buffer_pages() const noexcept { return _buffer_pages; }
+    [[nodiscard]] std::int64_t buffer_file_descriptor() const noexcept { return _buffer_file_descriptor; }
+
+    /**
+     * @return True, if the user-level buffer holds records that were not consumed, yet.
+     */
+    [[nodiscard]] bool has_records() const noexcept
+    {
+      if (_buffer == nullptr) {
+        return false;
+      }
+
+      const auto* mmap_page = reinterpret_cast<const perf_event_mmap_page*>(_buffer);
+      return __atomic_load_n(&mmap_page->data_head, __ATOMIC_ACQUIRE) > mmap_page->data_tail;
+    }
+
+    void aux_buffer(void* aux_buffer, const std::uint64_t aux_pages) noexcept
+    {
+      _aux_buffer = aux_buffer;
+      _aux_pages = aux_pages;
+    }
+
+    [[nodiscard]] void* aux_buffer() const noexcept { return _aux_buffer; }
+    [[nodiscard]] std::uint64_t aux_pages() const noexcept { return _aux_pages; }
+    [[nodiscard]] ArmSpeDecoder& arm_spe_decoder() noexcept { return _arm_spe_decoder; }
+
+    void layout(SampleLayout&& layout) noexcept { _layout = std::move(layout); }
+    [[nodiscard]] const SampleLayout& layout() const noexcept { return _layout; }
     [[nodiscard]] const std::vector<std::string_view>& counter_names() const noexcept { return _counter_names; }
 
+    /**
+     * Invokes the callback for every record in the user-level buffer that was not consumed, yet (i.e., records between
+     * data_tail and data_head). Records that wrap around the end of the ring buffer are copied into a contiguous chunk
+     * of memory before they are handed to the callback; the header is only valid during the callback.
+     *
+     * @param callback Callback that is invoked with the header of every record.
+     * @param is_consume If true, data_tail will be advanced to enable the perf subsystem to overwrite the read records.
+     */
+    template<typename F>
+    void read_records(F&& callback, const bool is_consume) const
+    {
+      if (_buffer == nullptr) {
+        return;
+      }
+
+      auto* mmap_page = reinterpret_cast<perf_event_mmap_page*>(_buffer);
+
+      /// The kernel publishes data_head after writing the records; the acquire-load ensures that we see the records.
+      const auto head = __atomic_load_n(&mmap_page->data_head, __ATOMIC_ACQUIRE);
+
+      /// We are the only writer of data_tail.
+      const auto tail = mmap_page->data_tail;
+
+      /// When the ringbuffer is empty or already read, there is nothing to do.
+      if (tail >= head) {
+        return;
+      }
+
+      /// The data section of the buffer starts at page 1 (from 0) and spans the remaining (2^n) pages.
+      auto* data = reinterpret_cast<std::uint8_t*>(_buffer) + 4096U;
+      const auto data_size = (_buffer_pages - 1U) * 4096U;
+
+      /// Memory for records that wrap around the end of the buffer (allocated only when needed).
+      auto wrapped_record = std::vector<std::uint8_t>{};
+
+      auto position = tail;
+      while (position < head) {
+        const auto offset = position % data_size;
+        auto* event_header = reinterpret_cast<perf_event_header*>(data + offset);
+        const auto record_size = std::uint64_t{ event_header->size };
+
+        /// Records are at least as large as their header; everything else indicates a corrupted buffer.
+        if (record_size < sizeof(perf_event_header)) {
+          break;
+        }
+
+        /// Copy both parts of records that are split by the end of the buffer into contiguous memory.
+        if (offset + record_size > data_size) {
+          wrapped_record.resize(record_size);
+          const auto size_until_end = data_size - offset;
+          std::memcpy(wrapped_record.data(), data + offset, size_until_end);
+          std::memcpy(wrapped_record.data() + size_until_end, data, record_size - size_until_end);
+          event_header = reinterpret_cast<perf_event_header*>(wrapped_record.data());
+        }
+
+        callback(event_header);
+
+        /// Go to the next record.
+        position += record_size;
+      }
+
+      /// Publish the consumed records. The release-store ensures that all reads complete before the kernel is allowed
+      /// to overwrite the space.
+      if (is_consume) {
+        __atomic_store_n(&mmap_page->data_tail, head, __ATOMIC_RELEASE);
+      }
+    }
+
+    /**
+     * Invokes the callback with the raw records in the user-level buffer that were not consumed, yet. Since the buffer
+     * is a ring, the records are passed as two contiguous chunks; the second chunk is only non-empty if the records
+     * wrap around the end of the buffer.
+     *
+     * @param callback Callback that is invoked with (first chunk, size of first chunk, second chunk, size of second).
+     * @param is_consume If true, data_tail will be advanced to enable the perf subsystem to overwrite the read records.
+     */
+    template<typename F>
+    void read_raw(F&& callback, const bool is_consume) const
+    {
+      if (_buffer == nullptr) {
+        return;
+      }
+
+      auto* mmap_page = reinterpret_cast<perf_event_mmap_page*>(_buffer);
+      const auto head = __atomic_load_n(&mmap_page->data_head, __ATOMIC_ACQUIRE);
+      const auto tail = mmap_page->data_tail;
+
+      if (tail >= head) {
+        return;
+      }
+
+      auto* data = reinterpret_cast<std::uint8_t*>(_buffer) + 4096U;
+      const auto data_size = (_buffer_pages - 1U) * 4096U;
+
+      const auto offset = tail % data_size;
+      const auto size = head - tail;
+      const auto size_until_end = std::min<std::uint64_t>(size, data_size - offset);
+
+      callback(data + offset, size_until_end, data, size - size_until_end);
+
+      if (is_consume) {
+        __atomic_store_n(&mmap_page->data_tail, head, __ATOMIC_RELEASE);
+      }
+    }
+
+    /**
+     * Invokes the callback with the trace data in the AUX area that was not consumed, yet (i.e., data between aux_tail
+     * and aux_head), passed as two contiguous chunks like read_raw(). In snapshot mode, the kernel ignores aux_tail
+     * and overwrites old data; only the most recent data (at most the size of the AUX area) is passed.
+     *
+     * @param callback Callback that is invoked with (first chunk, size of first chunk, second chunk, size of second).
+     * @param is_consume If true, aux_tail will be advanced to enable the perf subsystem to overwrite the read data.
+     */
+    template<typename F>
+    void read_aux(F&& callback, const bool is_consume) const
+    {
+      if (_buffer == nullptr || _aux_buffer == nullptr) {
+        return;
+      }
+
+      auto* mmap_page = reinterpret_cast<perf_event_mmap_page*>(_buffer);
+      const auto head = __atomic_load_n(&mmap_page->aux_head, __ATOMIC_ACQUIRE);
+      const auto tail = mmap_page->aux_tail;
+
+      if (tail >= head) {
+        return;
+      }
+
+      auto* data = reinterpret_cast<std::uint8_t*>(_aux_buffer);
+      const auto data_size = _aux_pages * 4096U;
+
+      const auto begin = std::max<std::uint64_t>(tail, head > data_size ? head - data_size : 0U);
+      const auto offset = begin % data_size;
+      const auto size = head - begin;
+      const auto size_until_end = std::min<std::uint64_t>(size, data_size - offset);
+
+      callback(data + offset, size_until_end, data, size - size_until_end);
+
+      if (is_consume) {
+        __atomic_store_n(&mmap_page->aux_tail, head, __ATOMIC_RELEASE);
+      }
+    }
+
   private:
     /// Group including the leader that is responsible for sampling.
     Group _group;
@@ -481,8 +885,23 @@ private:
     /// Number of pages allocated in the mmap-ed buffer.
     std::uint64_t _buffer_pages{ 0U };
 
+    /// File descriptor of the counter the buffer is mapped to (can be polled for new records).
+    std::int64_t _buffer_file_descriptor{ -1 };
+
+    /// Mmap-ed AUX area that receives hardware traces (if requested).
+    void* _aux_buffer{ nullptr };
+
+    /// Number of pages allocated in the AUX area.
+    std::uint64_t _aux_pages{ 0U };
+
+    /// Decoder for Arm SPE records that are split across drains of the AUX area.
+    ArmSpeDecoder _arm_spe_decoder;
+
     /// List of counter names if counter values are sampled.
     std::vector<std::string_view> _counter_names;
+
+    /// Layout of the sample records, needed to decode the records.
+    SampleLayout _layout;
   };
 
   /**
@@ -540,6 +959,7 @@ private:
 
     [[nodiscard]] bool is_sample_event() const noexcept { return _type == PERF_RECORD_SAMPLE; }
     [[nodiscard]] bool is_loss_event() const noexcept { return _type == PERF_RECORD_LOST_SAMPLES; }
+    [[nodiscard]] bool is_lost_event() const noexcept { return _type == PERF_RECORD_LOST; }
     [[nodiscard]] bool is_context_switch_event() const noexcept
     {
 #ifndef PERFCPP_NO_RECORD_SWITCH
@@ -569,6 +989,19 @@ private:
       return _type == PERF_RECORD_THROTTLE || _type == PERF_RECORD_UNTHROTTLE;
     }
     [[nodiscard]] bool is_throttle() const noexcept { return _type == PERF_RECORD_THROTTLE; }
+    [[nodiscard]] bool is_mmap_event() const noexcept
+    {
+      return _type == PERF_RECORD_MMAP || _type == PERF_RECORD_MMAP2;
+    }
+    [[nodiscard]] bool is_mmap2() const noexcept { return _type == PERF_RECORD_MMAP2; }
+    [[nodiscard]] bool is_mmap_build_id() const noexcept
+    {
+#ifndef PERFCPP_NO_RECORD_MMAP_BUILD_ID
+      return _misc & PERF_RECORD_MISC_MMAP_BUILD_ID;
+#else
+      return false;
+#endif
+    }
 
     [[nodiscard]] bool is_exact_ip() const noexcept { return _misc & PERF_RECORD_MISC_EXACT_IP; }
     [[nodiscard]] bool is_context_switch_out() const noexcept
@@ -603,6 +1036,34 @@ private:
    */
   [[nodiscard]] SampleCounter transform_trigger_to_sample_counter(const std::vector<std::tuple<std::string_view, std::optional<Precision>, std::optional<PeriodOrFrequency>>>& triggers) const;
 
+  /**
+   * Reads all unconsumed records from the user-level buffer of the given sample counter and translates them into
+   * samples.
+   *
+   * @param sample_counter Sample counter to read the records from.
+   * @param is_consume If true, the read records are handed back to the perf subsystem.
+   * @param result List the read samples will be appended to.
+   */
+  void read_samples(const SampleCounter& sample_counter, bool is_consume, std::vector<Sample>& result) const;
+
+  /**
+   * Copies the sample records from the sample counter's buffer into the arena.
+   *
+   * @param sample_counter Sample counter to read the records from.
+   * @param is_consume If true, the read records are handed back to the perf subsystem.
+   * @param arena Arena that receives the records.
+   */
+  void read_samples(const SampleCounter& sample_counter, bool is_consume, SampleArena& arena) const;
+
+  /**
+   * Reads the samples from the sample counter's buffer into the batch.
+   *
+   * @param sample_counter Sample counter to read the records from.
+   * @param is_consume If true, the read records are handed back to the perf subsystem.
+   * @param batch Batch that receives the samples.
+   */
+  void read_samples(const SampleCounter& sample_counter, bool is_consume, SampleBatch& batch) const;
+
   /**
    * Reads the sample_id struct from the data located at sample_ptr into the provided sample.
    *
@@ -611,17 +1072,46 @@ private:
   void read_sample_id(UserLevelBufferEntry& entry, Sample& sample) const noexcept;
 
   /**
-   * Translates the current entry from the user-level buffer into a "normal" sample.
+   * Invokes the callback for every sample record of all sample counters.
    *
-   * @param entry Entry of the user-level buffer.
-   * @param sample_counter The SampleCounter the entry is linked to in order to get the recorded counters (if any).
+   * @param callback Callback that is invoked with a const SampleView& for every sample record.
+   * @param is_consume If true, the read records are handed back to the perf subsystem.
+   */
+  template<typename F>
+  void visit_samples(F& callback, const bool is_consume) const
+  {
+    for (const auto& sample_counter : this->_sample_counter) {
+      sample_counter.read_records(
+        [&callback, &sample_counter](perf_event_header* event_header) {
+          if (event_header->type == PERF_RECORD_SAMPLE) {
+            callback(SampleView{ event_header, sample_counter.layout() });
+          }
+        },
+        is_consume);
+    }
+  }
+
+  /**
+   * Hands the filters and the BPF program of the config to the kernel (via PERF_EVENT_IOC_SET_FILTER and
+   * PERF_EVENT_IOC_SET_BPF).
+   *
+   * @param file_descriptor File descriptor of the sampling counter.
+   * @param config Config holding the filters.
+   */
+  static void apply_filters(std::int32_t file_descriptor, const SampleConfig& config);
+
+  /**
+   * Lets the kernel deliver the given signal to the calling thread whenever the buffer is signaled to be readable (via
+   * F_SETSIG and F_SETOWN_EX).
    *
-   * @return Sample.
+   * @param file_descriptor File descriptor of the counter owning the buffer.
+   * @param signal Signal to deliver.
    */
-  [[nodiscard]] perf::Sample read_sample_event(UserLevelBufferEntry entry, const SampleCounter& sample_counter) const;
+  static void apply_wakeup_signal(std::int32_t file_descriptor, std::int32_t signal);
 
   /**
-   * Translates the current entry from the user-level buffer into a lost sample.
+   * Translates the current entry from the user-level buffer into a lost sample, for records that report samples lost
+   * by the hardware or kernel (PERF_RECORD_LOST_SAMPLES).
    *
    * @param entry Entry of the user-level buffer.
    *
@@ -629,6 +1119,16 @@ private:
    */
   [[nodiscard]] perf::Sample read_loss_event(UserLevelBufferEntry entry) const;
 
+  /**
+   * Translates the current entry from the user-level buffer into a lost sample, for records that report samples lost
+   * due to a full buffer (PERF_RECORD_LOST, which records the id of the event before the number of lost samples).
+   *
+   * @param entry Entry of the user-level buffer.
+   *
+   * @return Sample containing the loss.
+   */
+  [[nodiscard]] perf::Sample read_lost_event(UserLevelBufferEntry entry) const;
+
   /**
    * Translates the current entry from the user-level buffer into a context switch sample.
    *
@@ -656,6 +1156,15 @@ private:
    */
   [[nodiscard]] perf::Sample read_throttle_event(UserLevelBufferEntry entry) const;
 
+  /**
+   * Translates the current entry from the user-level buffer into a memory mapping sample.
+   *
+   * @param entry Entry of the user-level buffer.
+   *
+   * @return Sample containing the memory mapping.
+   */
+  [[nodiscard]] perf::Sample read_mmap_event(UserLevelBufferEntry entry) const;
+
   const CounterDefinition& _counter_definitions;
 
   /// List of triggers. Each trigger will open an individual group of counters.
@@ -677,6 +1186,158 @@ private:
   /// This enables the user to open the sampler specifically – or open the
   /// sampler when starting.
   bool _is_opened{ false };
+
+  /// Flag if the sampler is started (and not stopped).
+  bool _is_recording{ false };
+};
+
+/**
+ * The SampleDrainer reads the user-level buffers of multiple samplers in the background. Worker threads wait (via
+ * epoll) until the perf subsystem signals new records (see SampleConfig::wakeup_events() and
+ * SampleConfig::wakeup_watermark()) and move the records into a per-sampler queue. Samplers are identified by their
+ * index; all samplers with the same index modulo the number of threads are drained by the same thread.
+ */
+class SampleDrainer
+{
+public:
+  /**
+   * Creates the given number of worker threads; the samplers are distributed round robin.
+   *
+   * @param count_samplers Number of samplers.
+   * @param count_threads Number of worker threads.
+   * @param queue Queue the drained samples are pushed into (as batches); if nullptr, the samples are queued per sampler
+   * until result() or drain() is called.
+   */
+  SampleDrainer(std::size_t count_samplers, std::uint16_t count_threads, SampleQueue* queue = nullptr);
+
+  /**
+   * Creates one worker thread per list of CPUs; every worker is pinned to its CPUs (e.g., the CPUs of a NUMA node),
+   * unless the list is empty.
+   *
+   * @param worker_ids Id of the worker thread that drains the sampler, for every sampler.
+   * @param worker_cpu_ids CPUs every worker thread is pinned to.
+   * @param queue Queue the drained samples are pushed into (as batches); may be nullptr.
+   */
+  SampleDrainer(std::vector<std::size_t>&& worker_ids,
+                std::vector<std::vector<std::uint16_t>>&& worker_cpu_ids,
+                SampleQueue* queue = nullptr);
+  SampleDrainer(SampleDrainer&&) = delete;
+  SampleDrainer(const SampleDrainer&) = delete;
+
+  /**
+   * Stops and joins all worker threads.
+   */
+  ~SampleDrainer();
+
+  SampleDrainer& operator=(SampleDrainer&&) = delete;
+  SampleDrainer& operator=(const SampleDrainer&) = delete;
+
+  /**
+   * Registers the (opened) sampler with the given id to be drained in the background.
+   * Registering an already registered sampler has no effect.
+   *
+   * @param sampler_id Id of the sampler.
+   * @param sampler Sampler to drain.
+   */
+  void add(std::size_t sampler_id, Sampler& sampler);
+
+  /**
+   * Stops draining the sampler with the given id and discards all queued samples; when draining into a SampleQueue,
+   * the remaining samples of the buffer are pushed into the queue, first.
+   * When the function returns, the worker threads no longer access the sampler (i.e., it can be closed).
+   *
+   * @param sampler_id Id of the sampler.
+   */
+  void remove(std::size_t sampler_id);
+
+  /**
+   * @param sampler_id Id of the sampler.
+   * @return List of all queued samples followed by the samples that are currently in the user-level buffer.
+   */
+  [[nodiscard]] std::vector<Sample> result(std::size_t sampler_id) const;
+
+  /**
+   * Takes all queued samples and drains the user-level buffer of the sampler.
+   *
+   * @param sampler_id Id of the sampler.
+   * @return List of all samples that were recorded since the last call to drain().
+   */
+  [[nodiscard]] std::vector<Sample> drain(std::size_t sampler_id);
+
+private:
+  /**
+   * State of a single sampler, shared between the worker thread and the user.
+   */
+  struct Slot
+  {
+    /// Guards the sampler and the queued samples.
+    mutable std::mutex mutex;
+
+    /// The drained sampler, nullptr if not registered.
+    Sampler* sampler{ nullptr };
+
+    /// File descriptors registered in the epoll instance of the worker thread.
+    std::vector<std::int64_t> file_descriptors;
+
+    /// Samples that were drained by the worker thread but not taken by the user, yet.
+    std::vector<Sample> samples;
+  };
+
+  /**
+   * Waits for events of the samplers registered at the given epoll instance and drains their buffers.
+   *
+   * @param epoll_file_descriptor Epoll instance of the worker thread.
+   * @param cpu_ids CPUs the worker thread is pinned to; not pinned if empty.
+   */
+  void run(std::int32_t epoll_file_descriptor, const std::vector<std::uint16_t>& cpu_ids);
+
+  /**
+   * Pushes the batch into the queue. With blocking backpressure, waits until the batch is queued, the queue is closed,
+   * or the drainer stops.
+   *
+   * @param batch Batch to push.
+   */
+  void enqueue(SampleBatch& batch);
+
+  /**
+   * @param count_samplers Number of samplers.
+   * @param count_threads Number of worker threads.
+   * @return Worker ids that distribute the samplers round robin over the worker threads.
+   */
+  [[nodiscard]] static std::vector<std::size_t> round_robin(std::size_t count_samplers, std::uint16_t count_threads);
+
+  /**
+   * @param sampler_id Id of the sampler.
+   * @return The epoll instance that is responsible for the given sampler.
+   */
+  [[nodiscard]] std::int32_t epoll_file_descriptor(const std::size_t sampler_id) const noexcept
+  {
+    return _epoll_file_descriptors[_worker_ids[sampler_id]];
+  }
+
+  /// One slot per sampler.
+  std::vector<std::unique_ptr<Slot>> _slots;
+
+  /// Id of the worker thread (and its epoll instance) for every sampler.
+  std::vector<std::size_t> _worker_ids;
+
+  /// CPUs every worker thread is pinned to.
+  std::vector<std::vector<std::uint16_t>> _worker_cpu_ids;
+
+  /// One epoll instance per worker thread.
+  std::vector<std::int32_t> _epoll_file_descriptors;
+
+  /// Queue the samples are pushed into, nullptr if the samples are queued per sampler.
+  SampleQueue* _queue;
+
+  /// Event file descriptor to signal the worker threads to stop.
+  std::int32_t _stop_file_descriptor{ -1 };
+
+  /// Set when the drainer stops, to release worker threads waiting for the queue.
+  std::atomic<bool> _is_stopping{ false };
+
+  /// Worker threads.
+  std::vector<std::thread> _threads;
 };
 
 class MultiSamplerBase
@@ -699,22 +1360,84 @@ public:
    */
   [[nodiscard]] SampleConfig& config() noexcept { return _config; }
 
+  /**
+   * Drains the user-level buffers of all samplers in the background, using the given number of threads. The threads
+   * are woken up by the perf subsystem (see SampleConfig::wakeup_events() and SampleConfig::wakeup_watermark()) and
+   * queue the samples until result() or drain() is called. This allows long-running sampling sessions with small
+   * buffers without the need to call drain() periodically.
+   * Should be called before opening or starting the samplers; samplers that are already opened will be registered.
+   *
+   * @param count_threads Number of threads that drain the buffers.
+   */
+  void background_drain(std::uint16_t count_threads = 1U);
+
+  /**
+   * Drains the user-level buffers of all samplers in the background (see background_drain(count_threads)) and pushes
+   * the samples as batches into the given queue, from which other threads can consume them. The policy of the queue
+   * decides whether the worker threads wait for the consumers (and the buffers may overflow) or drop batches. When
+   * closing the sampler, the remaining samples are pushed into the queue. The queue must outlive the sampler; since
+   * the batches refer to the names of the counters, they should be consumed before the sampler is closed.
+   *
+   * @param queue Queue the samples are pushed into.
+   * @param count_threads Number of threads that drain the buffers.
+   */
+  void background_drain(SampleQueue& queue, std::uint16_t count_threads = 1U);
+
   /**
    * Closes the sampler, including mapped buffer.
    */
-  void close()
+  void close();
+
+  /**
+   * @return List of sampled events after stopping the sampler.
+   */
+  [[nodiscard]] std::vector<Sample> result(bool sort_by_time = true) const;
+
+  /**
+   * Reads all samples recorded since the last drain from all samplers and hands the consumed buffer space back to the
+   * perf subsystem. drain() can be called while the samplers are running.
+   *
+   * @param sort_by_time Flag to sort the samples by timestamp attribute (if sampled).
+   * @return List of sampled events recorded since the last drain.
+   */
+  [[nodiscard]] std::vector<Sample> drain(bool sort_by_time = true);
+
+  /**
+   * Invokes the callback for every sample record in the user-level buffers of all samplers (one sampler after another),
+   * without translating the records into perf::Sample objects (see Sampler::for_each()).
+   * Cannot be combined with draining the buffers in the background.
+   *
+   * @param callback Callback that is invoked with a const SampleView& for every sample record.
+   */
+  template<typename F>
+  void for_each(F&& callback) const
   {
-    for (auto& sampler : samplers()) {
-      sampler.close();
+    if (_drainer != nullptr) {
+      throw std::runtime_error{ "Cannot visit samples while draining the buffers in the background." };
+    }
+
+    for (const auto& sampler : samplers()) {
+      sampler.for_each(callback);
     }
   }
 
   /**
-   * @return List of sampled events after stopping the sampler.
+   * Invokes the callback for every sample record that was recorded since the last drain in all samplers (one sampler
+   * after another) and hands the consumed space of the user-level buffers back to the perf subsystem (see
+   * Sampler::drain(callback)). Cannot be combined with draining the buffers in the background.
+   *
+   * @param callback Callback that is invoked with a const SampleView& for every sample record.
    */
-  [[nodiscard]] std::vector<Sample> result(const bool sort_by_time = true) const
+  template<typename F, typename = std::enable_if_t<std::is_invocable_v<F&, const SampleView&>>>
+  void drain(F&& callback)
   {
-    return result(samplers(), sort_by_time);
+    if (_drainer != nullptr) {
+      throw std::runtime_error{ "Cannot drain samples via callback while draining the buffers in the background." };
+    }
+
+    for (auto& sampler : samplers()) {
+      sampler.drain(callback);
+    }
   }
 
 protected:
@@ -723,6 +1446,16 @@ protected:
   {
   }
 
+  MultiSamplerBase(MultiSamplerBase&&) noexcept = default;
+
+  /**
+   * Drains the user-level buffers of all samplers in the background, using the given drainer; samplers that are
+   * already opened will be registered (see background_drain(count_threads)).
+   *
+   * @param drainer Drainer that distributes the samplers to its worker threads.
+   */
+  void background_drain(std::unique_ptr<SampleDrainer>&& drainer);
+
   /**
    * @return A list of multiple samplers.
    */
@@ -734,13 +1467,42 @@ protected:
   [[nodiscard]] virtual const std::vector<Sampler>& samplers() const noexcept = 0;
 
   /**
-   * Creates a single result from multiple samplers.
+   * Invokes the callback for all samplers in parallel (using up to one thread per hardware thread, including the calling
+   * thread). If the callback throws an exception for any sampler, the exception is re-thrown after all threads finished.
+   *
+   * @param count_samplers Number of samplers.
+   * @param callback Callback that is invoked with the id of every sampler.
+   */
+  template<typename F>
+  static void for_each_parallel(std::size_t count_samplers, F&& callback);
+
+  /**
+   * Reads the results of all samplers in parallel (using up to one thread per hardware thread).
+   *
+   * @param count_samplers Number of samplers.
+   * @param sort_by_time Flag to sort the result of every sampler by timestamp attribute.
+   * @param read Callback that reads the result of the sampler with the given id.
+   * @return List of results, one per sampler.
+   */
+  template<typename F>
+  [[nodiscard]] static std::vector<std::vector<Sample>> read_parallel(std::size_t count_samplers,
+                                                                      bool sort_by_time,
+                                                                      F&& read);
+
+  /**
+   * Creates a single result from the results of multiple samplers. If requested, the result is ordered by time using a
+   * k-way merge, which expects the results of every sampler to be ordered by time (see read_parallel()).
    *
-   * @param sampler List of samplers.
-   * @param sort_by_time Flag to sort the result by timestamp attribute (if sampled).
+   * @param results List of results, one per sampler.
+   * @param sort_by_time Flag to merge the results by timestamp attribute.
    * @return Single list of results from all incoming samplers.
    */
-  [[nodiscard]] static std::vector<Sample> result(const std::vector<Sampler>& sampler, bool sort_by_time);
+  [[nodiscard]] static std::vector<Sample> merge(std::vector<std::vector<Sample>>&& results, bool sort_by_time);
+
+  /**
+   * @return True, if all opened samplers record the timestamp.
+   */
+  [[nodiscard]] bool is_all_timed() const;
 
   /**
    * Initializes the given trigger(s) for the given list of samplers.
@@ -761,40 +1523,44 @@ protected:
   /**
    * Initializes the given sampler with values and config.
    *
-   * @param sampler Sampler to open.
+   * @param sampler_id Id of the sampler to open.
    */
-  void open(Sampler& sampler) { open(sampler, _config); }
+  void open(const std::size_t sampler_id) { open(sampler_id, _config); }
 
   /**
    * Initializes the given sampler with values and config.
    *
-   * @param sampler Sampler to open.
+   * @param sampler_id Id of the sampler to open.
    * @param config Config for that sampler.
    */
-  void open(Sampler& sampler, SampleConfig config);
+  void open(std::size_t sampler_id, SampleConfig config);
 
   /**
    * Initializes the given sampler with values and config.
    * After initialization, the sampler will be started.
    *
-   * @param sampler Sampler to start.
+   * @param sampler_id Id of the sampler to start.
    */
-  void start(Sampler& sampler) { start(sampler, _config); }
+  void start(const std::size_t sampler_id) { start(sampler_id, _config); }
 
   /**
    * Initializes the given sampler with values and config.
    * After initialization, the sampler will be started.
    *
-   * @param sampler Sampler to start.
+   * @param sampler_id Id of the sampler to start.
    * @param config Config for that sampler.
    */
-  void start(Sampler& sampler, SampleConfig config);
+  void start(std::size_t sampler_id, SampleConfig config);
 
   /// Values to record into every sample.
   Sampler::Values _values;
 
   /// Perf config.
   SampleConfig _config;
+
+  /// Background drain of the samplers' buffers, nullptr if not requested.
+  /// Derived classes need to reset the drainer before the samplers are destroyed.
+  std::unique_ptr<SampleDrainer> _drainer;
 };
 
 class MultiThreadSampler final : public MultiSamplerBase
@@ -806,7 +1572,7 @@ public:
 
   MultiThreadSampler(MultiThreadSampler&&) noexcept = default;
 
-  ~MultiThreadSampler() = default;
+  ~MultiThreadSampler() { _drainer.reset(); }
 
   /**
    * Set the trigger for sampling to a single counter.
@@ -928,7 +1694,7 @@ public:
    *
    * @param thread_id Id of the thread to start.
    */
-  void open(const std::uint16_t thread_id) { MultiSamplerBase::open(_thread_local_samplers[thread_id]); }
+  void open(const std::uint16_t thread_id) { MultiSamplerBase::open(thread_id); }
 
   /**
    * Opens and starts recording performance counters on a specific thread.
@@ -938,7 +1704,7 @@ public:
    */
   bool start(const std::uint16_t thread_id)
   {
-    MultiSamplerBase::start(_thread_local_samplers[thread_id]);
+    MultiSamplerBase::start(thread_id);
     return true;
   }
 
@@ -949,6 +1715,16 @@ public:
    */
   void stop(const std::uint16_t thread_id) { _thread_local_samplers[thread_id].stop(); }
 
+  /**
+   * Returns the id of the calling thread, registering the thread on its first call: Threads (e.g., workers of a thread
+   * pool) claim the next unused id instead of choosing one. When a registered thread exits, its sampler is stopped;
+   * the samples are kept until the sampler is closed. Ids of exited threads are not handed out again, num_threads
+   * limits the number of threads that can register. Registered ids should not be mixed with ids chosen by the caller.
+   *
+   * @return Id of the calling thread.
+   */
+  [[nodiscard]] std::uint16_t local_thread_id() { return std::uint16_t(_thread_registry.slot()); }
+
   /**
    * Stops recording performance counters for all threads.
    */
@@ -962,6 +1738,9 @@ public:
 private:
   std::vector<Sampler> _thread_local_samplers;
 
+  /// Assigns ids to threads calling local_thread_id(); must be destroyed before the samplers.
+  ThreadRegistry _thread_registry;
+
   /**
    * @return A list of multiple samplers.
    */
@@ -982,7 +1761,7 @@ public:
 
   MultiCoreSampler(MultiCoreSampler&&) noexcept = default;
 
-  ~MultiCoreSampler() = default;
+  ~MultiCoreSampler() { _drainer.reset(); }
 
   /**
    * Set the trigger for sampling to a single counter.
@@ -1112,6 +1891,32 @@ public:
    */
   bool start();
 
+  /**
+   * Drains the user-level buffers in the background with one worker thread per NUMA node (see
+   * background_drain(count_threads)). Every worker is pinned to the CPUs of its node and drains the samplers of the
+   * node's CPUs, such that the buffers (which the perf subsystem allocates on the node of the CPU) are read and the
+   * samples are allocated without crossing nodes.
+   *
+   * @param topology NUMA topology of the system.
+   */
+  void background_drain_per_node(const NumaTopology& topology = NumaTopology{})
+  {
+    background_drain_per_node(topology, nullptr);
+  }
+
+  /**
+   * Drains the user-level buffers in the background with one worker thread per NUMA node (see
+   * background_drain_per_node(topology)) and pushes the samples as batches into the given queue (see
+   * background_drain(queue, count_threads)).
+   *
+   * @param queue Queue the samples are pushed into.
+   * @param topology NUMA topology of the system.
+   */
+  void background_drain_per_node(SampleQueue& queue, const NumaTopology& topology = NumaTopology{})
+  {
+    background_drain_per_node(topology, &queue);
+  }
+
   /**
    * Stops the sampler.
    */
@@ -1133,6 +1938,14 @@ private:
    */
   [[nodiscard]] const std::vector<Sampler>& samplers() const noexcept override { return _core_local_samplers; }
 
+  /**
+   * Drains the user-level buffers in the background with one worker thread per NUMA node.
+   *
+   * @param topology NUMA topology of the system.
+   * @param queue Queue the samples are pushed into; may be nullptr.
+   */
+  void background_drain_per_node(const NumaTopology& topology, SampleQueue* queue);
+
   /// List of samplers.
   std::vector<Sampler> _core_local_samplers;
 
@@ -1140,9 +1953,264 @@ private:
   std::vector<std::uint16_t> _core_ids;
 };
 
+/**
+ * The MultiProcessSampler attaches to already running processes: Every thread of the given processes (as listed in
+ * /proc/<pid>/task) is recorded by its own sampler. The perf subsystem cannot map the buffer of inherited per-thread
+ * events; instead, a number of spare samplers is reserved for threads that are spawned later, which are attached when
+ * opening the sampler and via attach_new_threads(). Attaching to processes of other users needs the permission to
+ * trace them (see perf_event_paranoid).
+ * The number of buffer pages of the config is the budget for all (including the spare) samplers: Every sampler gets an
+ * equal share (at least MIN_BUFFER_PAGES pages), such that the memory does not grow with the number of threads.
+ */
+class MultiProcessSampler final : public MultiSamplerBase
+{
+public:
+  /// Minimal number of pages of the user-level buffer per thread (without the metadata page).
+  constexpr static inline auto MIN_BUFFER_PAGES = std::uint64_t{ 16U };
+
+  /**
+   * Creates a sampler for all threads of the given processes.
+   *
+   * @param counter_list List of counters.
+   * @param process_ids Ids of the processes to attach to.
+   * @param config Config of the samplers.
+   * @param count_spare_threads Number of threads that can be attached after creating the sampler.
+   */
+  explicit MultiProcessSampler(const CounterDefinition& counter_list,
+                               std::vector<pid_t>&& process_ids,
+                               SampleConfig config = {},
+                               std::uint16_t count_spare_threads = 64U);
+
+  MultiProcessSampler(MultiProcessSampler&&) noexcept = default;
+
+  ~MultiProcessSampler() { _drainer.reset(); }
+
+  /**
+   * Set the trigger for sampling to a single counter.
+   *
+   * @param trigger_name Name of the counter that "triggers" sample recording.
+   * @return MultiProcessSampler
+   */
+  MultiProcessSampler& trigger(std::string&& trigger_name)
+  {
+    return trigger(std::vector<std::vector<Sampler::Trigger>>{
+      std::vector<Sampler::Trigger>{ Sampler::Trigger{ std::move(trigger_name) } } });
+  }
+
+  /**
+   * Set the trigger for sampling to a single counter.
+   *
+   * @param trigger_name Name of the counter that "triggers" sample recording.
+   * @param precision Precision of the event.
+   * @return MultiProcessSampler
+   */
+  MultiProcessSampler& trigger(std::string&& trigger_name, const Precision precision)
+  {
+    return trigger(std::vector<std::vector<Sampler::Trigger>>{
+      std::vector<Sampler::Trigger>{ Sampler::Trigger{ std::move(trigger_name), precision } } });
+  }
+
+  /**
+   * Set the trigger for sampling to a single counter.
+   *
+   * @param trigger_name Name of the counter that "triggers" sample recording.
+   * @param period Sampling period of the event.
+   * @return MultiProcessSampler
+   */
+  MultiProcessSampler& trigger(std::string&& trigger_name, const class Period period)
+  {
+    return trigger(std::vector<std::vector<Sampler::Trigger>>{
+      std::vector<Sampler::Trigger>{ Sampler::Trigger{ std::move(trigger_name), period } } });
+  }
+
+  /**
+   * Set the trigger for sampling to a single counter.
+   *
+   * @param trigger_name Name of the counter that "triggers" sample recording.
+   * @param frequency Sampling frequency of the event.
+   * @return MultiProcessSampler
+   */
+  MultiProcessSampler& trigger(std::string&& trigger_name, const Frequency frequency)
+  {
+    return trigger(std::vector<std::vector<Sampler::Trigger>>{
+      std::vector<Sampler::Trigger>{ Sampler::Trigger{ std::move(trigger_name), frequency } } });
+  }
+
+  /**
+   * Set the trigger for sampling to a single counter.
+   *
+   * @param trigger_name Name of the counter that "triggers" sample recording.
+   * @param precision Precision of the event.
+   * @param period Sampling period of the event.
+   * @return MultiProcessSampler
+   */
+  MultiProcessSampler& trigger(std::string&& trigger_name, const Precision precision, const class Period period)
+  {
+    return trigger(std::vector<std::vector<Sampler::Trigger>>{
+      std::vector<Sampler::Trigger>{ Sampler::Trigger{ std::move(trigger_name), precision, period } } });
+  }
+
+  /**
+   * Set the trigger for sampling to a list of different counters (e.g., mem loads and mem stores).
+   *
+   * @param trigger_name Name of the counters that "triggers" sample recording.
+   * @return MultiProcessSampler
+   */
+  MultiProcessSampler& trigger(std::vector<std::string>&& trigger_names)
+  {
+    return trigger(std::vector<std::vector<std::string>>{ std::move(trigger_names) });
+  }
+
+  /**
+   * Set the trigger for sampling to a list of different counters (e.g., mem loads and mem stores).
+   *
+   * @param triggers List of triggers tuples that "trigger" sample recording.
+   * @return MultiProcessSampler
+   */
+  MultiProcessSampler& trigger(std::vector<Sampler::Trigger>&& triggers)
+  {
+    return trigger(std::vector<std::vector<Sampler::Trigger>>{ std::move(triggers) });
+  }
+
+  /**
+   * Set the trigger for sampling to a list of different counters (e.g., mem loads and mem stores).
+   * Counters of the outer list will be grouped together, to enable auxiliary counter (e.g., needed
+   * for Intel's Sapphire Rapids architecture).
+   *
+   * @param trigger_name Group of names of the counters that "triggers" sample recording.
+   * @return MultiProcessSampler
+   */
+  MultiProcessSampler& trigger(std::vector<std::vector<std::string>>&& trigger_names)
+  {
+    MultiSamplerBase::trigger(_thread_samplers, std::move(trigger_names));
+    return *this;
+  }
+
+  /**
+   * Set the trigger for sampling to a list of different counters (e.g., mem loads and mem stores).
+   * Counters of the outer list will be grouped together, to enable auxiliary counter (e.g., needed
+   * for Intel's Sapphire Rapids architecture).
+   *
+   * @param triggers Group of names and precisions of the counters that "trigger" sample recording.
+   * @return MultiProcessSampler
+   */
+  MultiProcessSampler& trigger(std::vector<std::vector<Sampler::Trigger>>&& triggers)
+  {
+    MultiSamplerBase::trigger(_thread_samplers, std::move(triggers));
+    return *this;
+  }
+
+  /**
+   * Opens recording performance counters for all threads of the processes, including threads spawned since the sampler
+   * was created. Threads that exited in the meantime are skipped.
+   */
+  void open();
+
+  /**
+   * Opens and starts recording performance counters for all threads of the processes.
+   *
+   * @return True, of the performance counters could be started.
+   */
+  bool start();
+
+  /**
+   * Stops the sampler.
+   */
+  void stop()
+  {
+    for (auto& sampler : this->_thread_samplers) {
+      sampler.stop();
+    }
+    this->_is_recording = false;
+  }
+
+  /**
+   * Lists the threads of the processes again and attaches the threads that were spawned since, using the spare
+   * samplers. The new threads are opened and, if the sampler is recording, started. Should be called periodically
+   * (e.g., when draining) to follow processes that spawn threads.
+   *
+   * @return Number of attached threads.
+   */
+  std::size_t attach_new_threads();
+
+  /**
+   * @return Number of threads that could not be attached, because all spare samplers were in use.
+   */
+  [[nodiscard]] std::uint64_t count_missed_threads() const noexcept { return _count_missed_threads; }
+
+  /**
+   * @return Ids of the processes the sampler is attached to.
+   */
+  [[nodiscard]] const std::vector<pid_t>& process_ids() const noexcept { return _process_ids; }
+
+  /**
+   * @return Ids of the attached threads, one per sampler in use.
+   */
+  [[nodiscard]] const std::vector<pid_t>& thread_ids() const noexcept { return _thread_ids; }
+
+  /**
+   * Lists the threads of a process.
+   *
+   * @param process_id Id of the process.
+   * @return Ids of all threads of the process.
+   */
+  [[nodiscard]] static std::vector<pid_t> threads_of(pid_t process_id);
+
+private:
+  /**
+   * @return A list of multiple samplers.
+   */
+  [[nodiscard]] std::vector<Sampler>& samplers() noexcept override { return _thread_samplers; }
+
+  /**
+   * @return A list of multiple samplers.
+   */
+  [[nodiscard]] const std::vector<Sampler>& samplers() const noexcept override { return _thread_samplers; }
+
+  /**
+   * @param buffer_pages Number of pages for all samplers, including one metadata page per sampler.
+   * @param count_samplers Number of samplers.
+   * @return Number of pages per sampler (a power of two plus the metadata page).
+   */
+  [[nodiscard]] static std::uint64_t buffer_pages_per_sampler(std::uint64_t buffer_pages, std::size_t count_samplers);
+
+  /**
+   * Opens the samplers of the attached threads starting with the given id, in parallel. Samplers of threads that
+   * exited are closed and skipped.
+   *
+   * @param first_sampler_id Id of the first sampler to open.
+   */
+  void open(std::size_t first_sampler_id);
+
+  /**
+   * Lists the threads of the processes and assigns threads that are not attached, yet, to spare samplers.
+   */
+  void list_threads();
+
+  /// List of samplers, one per thread and spare thread.
+  std::vector<Sampler> _thread_samplers;
+
+  /// Processes to record.
+  std::vector<pid_t> _process_ids;
+
+  /// Thread of every sampler in use.
+  std::vector<pid_t> _thread_ids;
+
+  /// Flag for every sampler whose thread exited before opening.
+  std::vector<std::uint8_t> _is_exited;
+
+  /// Flag if the sampler was started (and not stopped); attached threads are started immediately.
+  bool _is_recording{ false };
+
+  std::uint64_t _count_missed_threads{ 0U };
+};
+
 class SampleTimestampComparator
 {
 public:
-  bool operator()(const Sample& left, const Sample& right) const { return left.time().value() < right.time().value(); }
+  bool operator()(const Sample& left, const Sample& right) const
+  {
+    return left.time().value_or(0U) < right.time().value_or(0U);
+  }
 };
 }
\ No newline at end of file
@@ -0,0 +1,311 @@
+#pragma once
+
+#include "sample.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace perf {
+/**
+ * Symbol an instruction pointer was resolved to.
+ * The name and module are views into memory owned by the Symbolizer; they are valid as long as the Symbolizer is alive.
+ */
+class Symbol
+{
+public:
+  Symbol(const std::string_view name, const std::string_view module, const std::uintptr_t offset) noexcept
+    : _name(name)
+    , _module(module)
+    , _offset(offset)
+  {
+  }
+  ~Symbol() noexcept = default;
+
+  /**
+   * @return (Mangled) name of the symbol.
+   */
+  [[nodiscard]] std::string_view name() const noexcept { return _name; }
+
+  /**
+   * @return Path of the binary or library containing the symbol ("[kernel]" for kernel symbols).
+   */
+  [[nodiscard]] std::string_view module() const noexcept { return _module; }
+
+  /**
+   * @return Offset of the resolved address from the start of the symbol.
+   */
+  [[nodiscard]] std::uintptr_t offset() const noexcept { return _offset; }
+
+  /**
+   * @return Demangled name of the symbol, or the name if it cannot be demangled.
+   */
+  [[nodiscard]] std::string demangled_name() const;
+
+private:
+  std::string_view _name;
+  std::string_view _module;
+  std::uintptr_t _offset;
+};
+
+/**
+ * Address within a binary or library, as used by the symbol table of the file (i.e., independent of where the file was
+ * loaded into a process). The module is a view into memory owned by the Symbolizer; it is valid as long as the
+ * Symbolizer is alive.
+ */
+class BinaryAddress
+{
+public:
+  BinaryAddress(const std::string_view module, const std::uintptr_t address) noexcept
+    : _module(module)
+    , _address(address)
+  {
+  }
+  ~BinaryAddress() noexcept = default;
+
+  /**
+   * @return Path of the binary or library.
+   */
+  [[nodiscard]] std::string_view module() const noexcept { return _module; }
+
+  /**
+   * @return Virtual address within the binary or library (e.g., as expected by llvm-profgen or addr2line).
+   */
+  [[nodiscard]] std::uintptr_t address() const noexcept { return _address; }
+
+private:
+  std::string_view _module;
+  std::uintptr_t _address;
+};
+
+/**
+ * The Symbolizer resolves sampled instruction pointers and call chains to symbols (functions) of the executed binaries
+ * and libraries. It keeps a sorted index of the memory mappings of every process, which is initialized from
+ * /proc/<pid>/maps on first use and updated from memory mapping records (see perf::Sampler::Values::mmap()).
+ * The symbol tables of mapped ELF files are parsed once and shared between processes; the files are memory-mapped
+ * instead of copied. Resolved addresses are cached per process.
+ * The Symbolizer is not thread-safe.
+ */
+class Symbolizer
+{
+public:
+  Symbolizer() = default;
+  Symbolizer(Symbolizer&&) noexcept = default;
+  Symbolizer(const Symbolizer&) = delete;
+  ~Symbolizer() = default;
+
+  Symbolizer& operator=(Symbolizer&&) noexcept = default;
+  Symbolizer& operator=(const Symbolizer&) = delete;
+
+  /**
+   * Reads the current (executable) memory mappings of the given process from /proc/<pid>/maps. This is needed for
+   * mappings that were established before sampling started, if the process may exit before resolving its samples.
+   *
+   * @param process_id Id of the process.
+   * @return True, if the mappings could be read.
+   */
+  bool add_process(std::uint32_t process_id);
+
+  /**
+   * Adds a memory mapping (e.g., from a sampled memory mapping record) to the address space of the mapping process,
+   * replacing overlapping mappings.
+   *
+   * @param mmap Memory mapping.
+   */
+  void add(const Mmap& mmap);
+
+  /**
+   * Adds the memory mapping of the given sample, if the sample is a memory mapping record; other samples are ignored.
+   *
+   * @param sample Sample.
+   */
+  void consume(const Sample& sample)
+  {
+    if (sample.mmap().has_value()) {
+      add(sample.mmap().value());
+    }
+  }
+
+  /**
+   * Adds the memory mappings of all memory mapping records in the given list of samples.
+   *
+   * @param samples List of samples.
+   */
+  void consume(const std::vector<Sample>& samples)
+  {
+    for (const auto& sample : samples) {
+      consume(sample);
+    }
+  }
+
+  /**
+   * Resolves the given address of the given process to a symbol.
+   *
+   * @param process_id Id of the process.
+   * @param address Address, e.g., an instruction pointer.
+   * @return Symbol containing the address, std::nullopt if the address could not be resolved.
+   */
+  [[nodiscard]] std::optional<Symbol> resolve(std::uint32_t process_id, std::uintptr_t address);
+
+  /**
+   * Resolves the instruction pointer of the given sample (the sample needs the process id and instruction pointer).
+   *
+   * @param sample Sample.
+   * @return Symbol containing the instruction pointer, std::nullopt if it could not be resolved.
+   */
+  [[nodiscard]] std::optional<Symbol> resolve(const Sample& sample);
+
+  /**
+   * Resolves every address of the given call chain; context markers (e.g., PERF_CONTEXT_USER) resolve to std::nullopt.
+   *
+   * @param process_id Id of the process.
+   * @param callchain Call chain.
+   * @return List of symbols, one for each address of the call chain.
+   */
+  [[nodiscard]] std::vector<std::optional<Symbol>> resolve(std::uint32_t process_id,
+                                                           const std::vector<std::uintptr_t>& callchain);
+
+  /**
+   * Translates the given (runtime) address of the given process into the address within the mapped binary or library,
+   * e.g., to export profiles of position-independent executables and shared libraries. Kernel addresses are not
+   * translated.
+   *
+   * @param process_id Id of the process.
+   * @param address Address, e.g., an instruction pointer.
+   * @return Binary and address within the binary, std::nullopt if the address is not located in a mapped file.
+   */
+  [[nodiscard]] std::optional<BinaryAddress> translate(std::uint32_t process_id, std::uintptr_t address);
+
+private:
+  /// Maximal number of cached addresses per process; the cache is reset when exceeded.
+  constexpr static inline auto MAX_CACHED_ADDRESSES = std::size_t{ 1U } << 20U;
+
+  /**
+   * Memory-mapped ELF file with its (sorted) function symbols.
+   */
+  class Image
+  {
+  public:
+    /**
+     * Maps and parses the ELF file at the given path. If the file cannot be read, the image has no symbols.
+     *
+     * @param path Path of the ELF file.
+     */
+    explicit Image(std::string&& path);
+
+    Image(Image&&) = delete;
+    Image(const Image&) = delete;
+    ~Image();
+
+    Image& operator=(Image&&) = delete;
+    Image& operator=(const Image&) = delete;
+
+    /**
+     * @return Path of the ELF file.
+     */
+    [[nodiscard]] const std::string& path() const noexcept { return _path; }
+
+    /**
+     * Resolves the given offset within the file to a symbol.
+     *
+     * @param file_offset Offset within the file.
+     * @return Symbol containing the offset, std::nullopt if not found.
+     */
+    [[nodiscard]] std::optional<Symbol> find(std::uint64_t file_offset) const noexcept;
+
+    /**
+     * Translates the given offset within the file into the virtual address used by the symbol table.
+     *
+     * @param file_offset Offset within the file.
+     * @return Virtual address of the offset (the offset itself, if not located in a loadable segment).
+     */
+    [[nodiscard]] std::uint64_t virtual_address(std::uint64_t file_offset) const noexcept;
+
+  private:
+    /// Function symbol, the name is an offset into the string table.
+    struct ElfSymbol
+    {
+      std::uint64_t address;
+      std::uint64_t size;
+      std::uint32_t name;
+    };
+
+    /// Loadable segment to translate file offsets into virtual addresses.
+    struct Segment
+    {
+      std::uint64_t file_offset;
+      std::uint64_t virtual_address;
+      std::uint64_t size;
+    };
+
+    std::string _path;
+
+    /// The memory-mapped file.
+    void* _data{ nullptr };
+    std::size_t _size{ 0U };
+
+    /// String table of the symbol table (within the mapped file).
+    const char* _strings{ nullptr };
+    std::size_t _strings_size{ 0U };
+
+    std::vector<Segment> _segments;
+
+    /// Function symbols, sorted by address.
+    std::vector<ElfSymbol> _symbols;
+
+    void parse() noexcept;
+  };
+
+  /// Mapping of (a part of) an image into the address space of a process.
+  struct Mapping
+  {
+    std::uintptr_t begin;
+    std::uintptr_t end;
+    std::uint64_t page_offset;
+    std::shared_ptr<Image> image;
+  };
+
+  /// Memory mappings of a process, sorted by begin, and the resolved addresses.
+  struct AddressSpace
+  {
+    std::vector<Mapping> mappings;
+    std::unordered_map<std::uintptr_t, std::optional<Symbol>> cache;
+  };
+
+  /// Address space of every process.
+  std::unordered_map<std::uint32_t, AddressSpace> _address_spaces;
+
+  /// Images, shared by all processes, by their path.
+  std::unordered_map<std::string, std::shared_ptr<Image>> _images;
+
+  /// Kernel symbols (address and name), sorted by address; loaded from /proc/kallsyms on first use.
+  std::optional<std::vector<std::pair<std::uintptr_t, std::string>>> _kernel_symbols{ std::nullopt };
+
+  /**
+   * @return The address space of the given process, initialized from /proc/<pid>/maps if the process is unknown.
+   */
+  AddressSpace& address_space(std::uint32_t process_id);
+
+  /**
+   * @return The mapping of the given address space containing the given address, nullptr if not mapped.
+   */
+  [[nodiscard]] static const Mapping* mapping(const AddressSpace& address_space, std::uintptr_t address) noexcept;
+
+  /**
+   * Adds the mapping to the address space, replacing (parts of) overlapping mappings.
+   */
+  void add(AddressSpace& address_space,
+           std::uintptr_t begin,
+           std::uintptr_t end,
+           std::uint64_t page_offset,
+           std::string&& path);
+
+  /**
+   * Resolves the given kernel address to a kernel symbol.
+   */
+  [[nodiscard]] std::optional<Symbol> resolve_kernel(std::uintptr_t address);
+};
+}
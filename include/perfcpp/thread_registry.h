@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace perf {
+/**
+ * The ThreadRegistry assigns slots (e.g., the thread ids of MultiThreadEventCounter and MultiThreadSampler) to threads
+ * that register themselves on first use: Slots are claimed lock-free and remembered by a thread-local handle. When a
+ * registered thread exits, its slot is retired through the given callback (e.g., stopping its counters, keeping the
+ * results); retired slots are not handed out again.
+ */
+class ThreadRegistry
+{
+public:
+  /**
+   * Creates a registry without slots.
+   */
+  ThreadRegistry() noexcept = default;
+
+  /**
+   * Creates a registry.
+   *
+   * @param capacity Number of slots.
+   * @param retire Callback invoked (on the exiting thread) with the slot of every registered thread that exits.
+   */
+  ThreadRegistry(std::size_t capacity, std::function<void(std::size_t)>&& retire);
+  ThreadRegistry(ThreadRegistry&&) noexcept = default;
+  ThreadRegistry(const ThreadRegistry&) = delete;
+
+  /**
+   * Detaches the registry: Threads exiting afterward no longer invoke the retire callback.
+   */
+  ~ThreadRegistry();
+
+  /**
+   * Detaches the current registry and takes over the given one.
+   */
+  ThreadRegistry& operator=(ThreadRegistry&& other) noexcept;
+  ThreadRegistry& operator=(const ThreadRegistry&) = delete;
+
+  /**
+   * Returns the slot of the calling thread, claiming a slot on the first call of the thread.
+   * Throws a std::runtime_error if all slots were claimed.
+   *
+   * @return Slot of the calling thread.
+   */
+  [[nodiscard]] std::size_t slot();
+
+  /**
+   * @return Number of slots claimed so far (including retired ones).
+   */
+  [[nodiscard]] std::size_t size() const noexcept;
+
+  /**
+   * @return Number of slots.
+   */
+  [[nodiscard]] std::size_t capacity() const noexcept;
+
+private:
+  /// State shared with the thread-local handles of registered threads, outliving the registry while threads exit.
+  class State;
+
+  /// Thread-local list of registries the thread is registered at.
+  class ThreadHandle;
+
+  std::shared_ptr<State> _state;
+};
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <linux/perf_event.h>
+#include <optional>
+
+namespace perf {
+/**
+ * The TimeConversion translates between timestamps of the perf clock (e.g., Sample::time()) and the cycle counter of
+ * the CPU (rdtsc on x86, cntvct_el0 on Arm), using the parameters (time_zero, time_mult, and time_shift) that the
+ * kernel exposes in the metadata page of a counter (see Sampler::time_conversion()). In addition, perf timestamps can
+ * be translated to the system (wall) clock, based on an offset that is measured when creating the conversion.
+ *
+ * Only samples recorded with the default perf clock can be translated.
+ */
+class TimeConversion
+{
+public:
+  /**
+   * Creates a conversion from the parameters of the metadata page.
+   *
+   * @param time_zero Perf time at cycle zero.
+   * @param time_multiplier Multiplier to translate cycles into nanoseconds.
+   * @param time_shift Shift to translate cycles into nanoseconds.
+   * @param time_cycles Reference cycles, if the hardware counter has less than 64 bits (cap_user_time_short).
+   * @param time_mask Mask of the valid cycle bits, if the hardware counter has less than 64 bits.
+   */
+  TimeConversion(std::uint64_t time_zero,
+                 std::uint32_t time_multiplier,
+                 std::uint16_t time_shift,
+                 std::uint64_t time_cycles = 0U,
+                 std::uint64_t time_mask = 0U) noexcept;
+  ~TimeConversion() = default;
+
+  /**
+   * Reads the conversion parameters from the metadata page of a counter.
+   *
+   * @param page Metadata page (the first page of the buffer of a sampler).
+   * @return The conversion, or std::nullopt if the kernel or the CPU does not support converting the time (see
+   * cap_user_time_zero).
+   */
+  [[nodiscard]] static std::optional<TimeConversion> from(const perf_event_mmap_page* page) noexcept;
+
+  /**
+   * @return Current value of the cycle counter that is used by the perf clock (zero, if not supported by the
+   * architecture).
+   */
+  [[nodiscard]] static std::uint64_t cycles() noexcept
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    auto low = std::uint32_t{ 0U };
+    auto high = std::uint32_t{ 0U };
+    asm volatile("rdtsc" : "=a"(low), "=d"(high));
+
+    return (std::uint64_t{ high } << 32U) | low;
+#elif defined(__aarch64__)
+    auto value = std::uint64_t{ 0U };
+    asm volatile("isb; mrs %0, cntvct_el0" : "=r"(value));
+
+    return value;
+#else
+    return 0U;
+#endif
+  }
+
+  /**
+   * Translates cycles into a perf timestamp.
+   *
+   * @param cycles Value of the cycle counter (see cycles()).
+   * @return Perf timestamp in nanoseconds.
+   */
+  [[nodiscard]] std::uint64_t to_perf_time(std::uint64_t cycles) const noexcept;
+
+  /**
+   * Translates a perf timestamp into cycles.
+   *
+   * @param perf_time Perf timestamp in nanoseconds (e.g., Sample::time()).
+   * @return Value of the cycle counter.
+   */
+  [[nodiscard]] std::uint64_t to_cycles(std::uint64_t perf_time) const noexcept;
+
+  /**
+   * Translates a perf timestamp into the system clock. The offset between both clocks is measured when creating the
+   * conversion; adjustments of the system clock afterward (e.g., by NTP) are not reflected.
+   *
+   * @param perf_time Perf timestamp in nanoseconds (e.g., Sample::time()).
+   * @return Point in time of the system clock.
+   */
+  [[nodiscard]] std::chrono::system_clock::time_point to_system_time(std::uint64_t perf_time) const noexcept;
+
+  /**
+   * @return The current perf timestamp in nanoseconds.
+   */
+  [[nodiscard]] std::uint64_t now() const noexcept { return to_perf_time(TimeConversion::cycles()); }
+
+private:
+  std::uint64_t _time_zero;
+  std::uint32_t _time_multiplier;
+  std::uint16_t _time_shift;
+  std::uint64_t _time_cycles;
+  std::uint64_t _time_mask;
+
+  /// Offset (in nanoseconds) of the system clock relative to the perf clock.
+  std::int64_t _system_clock_offset{ 0 };
+};
+}
@@ -0,0 +1,283 @@
+#include <linux/perf_event.h>
+#include <perfcpp/amd_ibs_decoder.h>
+#include <perfcpp/hardware_info.h>
+
+std::optional<perf::AmdIbsDecoder::Type>
+perf::AmdIbsDecoder::type_of(const std::uint32_t perf_type)
+{
+  if (!HardwareInfo::is_amd_ibs_supported()) {
+    return std::nullopt;
+  }
+
+  if (const auto op_type = HardwareInfo::amd_ibs_op_type(); op_type.has_value() && op_type.value() == perf_type) {
+    return Type::Op;
+  }
+
+  if (const auto fetch_type = HardwareInfo::amd_ibs_fetch_type();
+      fetch_type.has_value() && fetch_type.value() == perf_type) {
+    return Type::Fetch;
+  }
+
+  return std::nullopt;
+}
+
+std::optional<std::uintptr_t>
+perf::AmdIbsDecoder::instruction_pointer() const noexcept
+{
+  if (this->_type == Type::Op) {
+    /// IbsOpData[38]: IbsRipInvalid.
+    if (this->count_registers() > OP_DATA && !static_cast<bool>(this->register_value(OP_DATA) & (1ULL << 38U))) {
+      return this->register_value(OP_RIP);
+    }
+  } else if (this->count_registers() > FETCH_LINEAR_ADDRESS) {
+    /// IbsFetchCtl[49]: IbsFetchVal.
+    if (static_cast<bool>(this->register_value(FETCH_CONTROL) & (1ULL << 49U))) {
+      return this->register_value(FETCH_LINEAR_ADDRESS);
+    }
+  }
+
+  return std::nullopt;
+}
+
+std::optional<std::uintptr_t>
+perf::AmdIbsDecoder::logical_memory_address() const noexcept
+{
+  /// IbsOpData3[17]: IbsDcLinAddrValid.
+  if (this->_type == Type::Op && this->count_registers() > DC_LINEAR_ADDRESS &&
+      static_cast<bool>(this->register_value(OP_DATA3) & (1ULL << 17U))) {
+    return this->register_value(DC_LINEAR_ADDRESS);
+  }
+
+  return std::nullopt;
+}
+
+std::optional<std::uintptr_t>
+perf::AmdIbsDecoder::physical_memory_address() const noexcept
+{
+  constexpr auto address_mask = (1ULL << 52U) - 1U;
+
+  if (this->_type == Type::Op) {
+    /// IbsOpData3[18]: IbsDcPhyAddrValid.
+    if (this->count_registers() > DC_PHYSICAL_ADDRESS &&
+        static_cast<bool>(this->register_value(OP_DATA3) & (1ULL << 18U))) {
+      return this->register_value(DC_PHYSICAL_ADDRESS) & address_mask;
+    }
+  } else if (this->count_registers() > FETCH_PHYSICAL_ADDRESS) {
+    /// IbsFetchCtl[52]: IbsPhyAddrValid.
+    if (static_cast<bool>(this->register_value(FETCH_CONTROL) & (1ULL << 52U))) {
+      return this->register_value(FETCH_PHYSICAL_ADDRESS) & address_mask;
+    }
+  }
+
+  return std::nullopt;
+}
+
+std::optional<perf::Weight>
+perf::AmdIbsDecoder::weight() const noexcept
+{
+  if (this->_type == Type::Fetch) {
+    /// IbsFetchCtl[47:32]: IbsFetchLat.
+    if (this->count_registers() > FETCH_CONTROL) {
+      return Weight{ static_cast<std::uint32_t>((this->register_value(FETCH_CONTROL) >> 32U) & 0xFFFFU) };
+    }
+
+    return std::nullopt;
+  }
+
+  if (this->count_registers() <= OP_DATA3 || !this->is_load_store()) {
+    return std::nullopt;
+  }
+
+  const auto op_data3 = this->register_value(OP_DATA3);
+
+  /// IbsOpData3[47:32]: IbsDcMissLat, valid for loads that missed the data cache (IbsDcMiss, bit 7).
+  const auto is_load_miss = static_cast<bool>(op_data3 & 0x1U) && static_cast<bool>(op_data3 & (1ULL << 7U));
+  const auto cache_latency = is_load_miss ? static_cast<std::uint32_t>((op_data3 >> 32U) & 0xFFFFU) : 0U;
+
+  /// IbsOpData[31:16]: IbsTagToRetCtr; IbsOpData3[63:48]: IbsTlbRefillLat.
+  const auto tag_to_retire_latency = static_cast<std::uint16_t>((this->register_value(OP_DATA) >> 16U) & 0xFFFFU);
+  const auto tlb_refill_latency = static_cast<std::uint16_t>(op_data3 >> 48U);
+
+  return Weight{ cache_latency, tag_to_retire_latency, tlb_refill_latency };
+}
+
+std::optional<perf::DataSource>
+perf::AmdIbsDecoder::data_src() const noexcept
+{
+  if (this->_type == Type::Fetch) {
+    if (this->count_registers() > FETCH_CONTROL) {
+      return this->fetch_data_source();
+    }
+  } else if (this->count_registers() > OP_DATA3) {
+    return this->op_data_source();
+  }
+
+  return std::nullopt;
+}
+
+perf::DataSource
+perf::AmdIbsDecoder::op_data_source() const noexcept
+{
+  auto data_source = perf_mem_data_src{};
+  data_source.val = 0U;
+
+  const auto op_data3 = this->register_value(OP_DATA3);
+  const auto is_bit = [op_data3](const std::uint8_t bit) { return static_cast<bool>(op_data3 & (1ULL << bit)); };
+
+  /// IbsOpData3[0]: IbsLdOp, [1]: IbsStOp.
+  const auto is_load = is_bit(0U);
+  if (!is_load && !is_bit(1U)) {
+    data_source.mem_op = PERF_MEM_OP_NA;
+    data_source.mem_lvl = PERF_MEM_LVL_NA;
+    data_source.mem_snoop = PERF_MEM_SNOOP_NA;
+    data_source.mem_dtlb = PERF_MEM_TLB_NA;
+    data_source.mem_lock = PERF_MEM_LOCK_NA;
+    return DataSource{ data_source.val };
+  }
+  data_source.mem_op = is_load ? PERF_MEM_OP_LOAD : PERF_MEM_OP_STORE;
+
+  /// TLB: IbsOpData3[2]: IbsDcL1TlbMiss, [3]: IbsDcL2TlbMiss (only valid with a valid linear address, bit 17).
+  if (!is_bit(17U)) {
+    data_source.mem_dtlb = PERF_MEM_TLB_NA;
+  } else if (!is_bit(2U)) {
+    data_source.mem_dtlb = PERF_MEM_TLB_L1 | PERF_MEM_TLB_HIT;
+  } else if (!is_bit(3U)) {
+    data_source.mem_dtlb = PERF_MEM_TLB_L2 | PERF_MEM_TLB_HIT;
+  } else {
+    data_source.mem_dtlb = PERF_MEM_TLB_L2 | PERF_MEM_TLB_MISS | PERF_MEM_TLB_WK;
+  }
+
+  /// IbsOpData3[15]: IbsDcLockedOp.
+  data_source.mem_lock = is_bit(15U) ? PERF_MEM_LOCK_LOCKED : PERF_MEM_LOCK_NA;
+  data_source.mem_snoop = PERF_MEM_SNOOP_NA;
+
+  /// IbsOpData3[7]: IbsDcMiss.
+  if (!is_bit(7U)) {
+    data_source.mem_lvl = PERF_MEM_LVL_L1 | PERF_MEM_LVL_HIT;
+    data_source.mem_lvl_num = PERF_MEM_LVLNUM_L1;
+    return DataSource{ data_source.val };
+  }
+
+  /// IbsOpData3[20]: IbsL2Miss.
+  if (!is_bit(20U)) {
+    data_source.mem_lvl = PERF_MEM_LVL_L2 | PERF_MEM_LVL_HIT;
+    data_source.mem_lvl_num = PERF_MEM_LVLNUM_L2;
+    return DataSource{ data_source.val };
+  }
+
+  /// The data source (IbsOpData2) is only valid for loads.
+  if (!is_load || this->count_registers() <= OP_DATA2) {
+    data_source.mem_lvl = PERF_MEM_LVL_NA;
+    return DataSource{ data_source.val };
+  }
+
+  /// IbsOpData2[2:0]: DataSrc, [4]: RmtNode, [5]: CacheHitSt, [7:6]: DataSrcHi (Zen 4 and later).
+  const auto op_data2 = this->register_value(OP_DATA2);
+  const auto is_remote_node = static_cast<bool>(op_data2 & (1ULL << 4U));
+  const auto is_hit_modified = static_cast<bool>(op_data2 & (1ULL << 5U));
+  const auto is_extended = static_cast<bool>(this->_capabilities & CAPABILITY_ZEN4);
+  const auto source = is_extended ? ((op_data2 >> 3U) & 0x18U) | (op_data2 & 0x7U) : op_data2 & 0x7U;
+
+  if (is_remote_node) {
+    data_source.mem_remote = PERF_MEM_REMOTE_REMOTE;
+  }
+
+  /// Sources shared by both encodings: Local L3 or CCX cache (1 on Zen 4, 2 before), DRAM (3), and I/O (7).
+  if ((is_extended && source == 1U) || (!is_extended && source == 2U)) {
+    data_source.mem_lvl = PERF_MEM_LVL_L3 | PERF_MEM_LVL_HIT;
+    data_source.mem_lvl_num = PERF_MEM_LVLNUM_L3;
+    data_source.mem_snoop = is_hit_modified ? PERF_MEM_SNOOP_HITM : PERF_MEM_SNOOP_HIT;
+  } else if (source == 3U) {
+    data_source.mem_lvl = (is_remote_node ? PERF_MEM_LVL_REM_RAM1 : PERF_MEM_LVL_LOC_RAM) | PERF_MEM_LVL_HIT;
+    data_source.mem_lvl_num = PERF_MEM_LVLNUM_RAM;
+  } else if (source == 7U) {
+    data_source.mem_lvl = PERF_MEM_LVL_IO | PERF_MEM_LVL_HIT;
+#ifdef PERF_MEM_LVLNUM_IO
+    data_source.mem_lvl_num = PERF_MEM_LVLNUM_IO;
+#endif
+  } else if (!is_extended && source == 4U) {
+    /// Cache of another CCX or a remote node.
+    data_source.mem_lvl = PERF_MEM_LVL_REM_CCE1 | PERF_MEM_LVL_HIT;
+    data_source.mem_lvl_num = PERF_MEM_LVLNUM_ANY_CACHE;
+    data_source.mem_remote = PERF_MEM_REMOTE_REMOTE;
+    data_source.mem_snoop = is_hit_modified ? PERF_MEM_SNOOP_HITM : PERF_MEM_SNOOP_HIT;
+  } else if (is_extended && (source == 2U || source == 5U)) {
+    /// Cache of another CCX in the same node (near, 2) or in another node (far, 5).
+    data_source.mem_lvl = (source == 2U ? PERF_MEM_LVL_REM_CCE1 : PERF_MEM_LVL_REM_CCE2) | PERF_MEM_LVL_HIT;
+    data_source.mem_lvl_num = PERF_MEM_LVLNUM_ANY_CACHE;
+    data_source.mem_remote = PERF_MEM_REMOTE_REMOTE;
+    data_source.mem_snoop = is_hit_modified ? PERF_MEM_SNOOP_HITM : PERF_MEM_SNOOP_HIT;
+#if defined(PERF_MEM_HOPS_1) && defined(PERF_MEM_HOPS_2)
+    data_source.mem_hops = source == 2U ? PERF_MEM_HOPS_1 : PERF_MEM_HOPS_2;
+#endif
+  } else if (is_extended && source == 6U) {
+#ifdef PERF_MEM_LVLNUM_PMEM
+    data_source.mem_lvl = PERF_MEM_LVL_HIT;
+    data_source.mem_lvl_num = PERF_MEM_LVLNUM_PMEM;
+#else
+    data_source.mem_lvl = PERF_MEM_LVL_NA;
+#endif
+  } else if (is_extended && (source == 8U || source == 12U)) {
+    /// Extension memory (e.g., CXL, 8) or memory of a peer agent (12).
+    data_source.mem_lvl = PERF_MEM_LVL_HIT;
+    data_source.mem_lvl_num = PERF_MEM_LVLNUM_RAM;
+#ifdef PERF_MEM_LVLNUM_CXL
+    if (source == 8U) {
+      data_source.mem_lvl_num = PERF_MEM_LVLNUM_CXL;
+    }
+#endif
+  } else {
+    data_source.mem_lvl = PERF_MEM_LVL_NA;
+  }
+
+  return DataSource{ data_source.val };
+}
+
+perf::DataSource
+perf::AmdIbsDecoder::fetch_data_source() const noexcept
+{
+  auto data_source = perf_mem_data_src{};
+  data_source.val = 0U;
+  data_source.mem_op = PERF_MEM_OP_EXEC;
+  data_source.mem_snoop = PERF_MEM_SNOOP_NA;
+  data_source.mem_lock = PERF_MEM_LOCK_NA;
+
+  const auto fetch_control = this->register_value(FETCH_CONTROL);
+  const auto is_bit = [fetch_control](const std::uint8_t bit) {
+    return static_cast<bool>(fetch_control & (1ULL << bit));
+  };
+
+  /// TLB: IbsFetchCtl[55]: IbsL1TlbMiss, [56]: IbsL2TlbMiss (only valid with a valid physical address, bit 52).
+  if (!is_bit(52U)) {
+    data_source.mem_dtlb = PERF_MEM_TLB_NA;
+  } else if (!is_bit(55U)) {
+    data_source.mem_dtlb = PERF_MEM_TLB_L1 | PERF_MEM_TLB_HIT;
+  } else if (!is_bit(56U)) {
+    data_source.mem_dtlb = PERF_MEM_TLB_L2 | PERF_MEM_TLB_HIT;
+  } else {
+    data_source.mem_dtlb = PERF_MEM_TLB_L2 | PERF_MEM_TLB_MISS | PERF_MEM_TLB_WK;
+  }
+
+  /// Levels are only valid for completed fetches: IbsFetchCtl[50]: IbsFetchComp, [51]: IbsIcMiss, [58]: IbsL2Miss,
+  /// and [61]: IbsFetchL3Miss (Zen 4 and later).
+  if (!is_bit(50U)) {
+    data_source.mem_lvl = PERF_MEM_LVL_NA;
+  } else if (!is_bit(51U)) {
+    data_source.mem_lvl = PERF_MEM_LVL_L1 | PERF_MEM_LVL_HIT;
+    data_source.mem_lvl_num = PERF_MEM_LVLNUM_L1;
+  } else if (!is_bit(58U)) {
+    data_source.mem_lvl = PERF_MEM_LVL_L2 | PERF_MEM_LVL_HIT;
+    data_source.mem_lvl_num = PERF_MEM_LVLNUM_L2;
+  } else if (!static_cast<bool>(this->_capabilities & CAPABILITY_ZEN4)) {
+    data_source.mem_lvl = PERF_MEM_LVL_L2 | PERF_MEM_LVL_MISS;
+    data_source.mem_lvl_num = PERF_MEM_LVLNUM_ANY_CACHE;
+  } else if (!is_bit(61U)) {
+    data_source.mem_lvl = PERF_MEM_LVL_L3 | PERF_MEM_LVL_HIT;
+    data_source.mem_lvl_num = PERF_MEM_LVLNUM_L3;
+  } else {
+    data_source.mem_lvl = PERF_MEM_LVL_L3 | PERF_MEM_LVL_MISS;
+    data_source.mem_lvl_num = PERF_MEM_LVLNUM_RAM;
+  }
+
+  return DataSource{ data_source.val };
+}
@@ -0,0 +1,367 @@
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <perfcpp/analyzer/branch.h>
+#include <sstream>
+#include <tuple>
+
+void
+perf::analyzer::BranchAnalyzer::consume(const perf::SampleView& sample)
+{
+  if (const auto branches = sample.branches(); !branches.empty()) {
+    this->add(sample.process_id().value_or(0U), branches.data(), branches.size());
+  }
+}
+
+void
+perf::analyzer::BranchAnalyzer::consume(const perf::Sample& sample)
+{
+  if (const auto& branches = sample.branches(); branches.has_value() && !branches->empty()) {
+    this->add(sample.process_id().value_or(0U), branches->data(), branches->size());
+  }
+}
+
+void
+perf::analyzer::BranchAnalyzer::add(const std::uint32_t process_id, const std::vector<perf::Branch>& branches)
+{
+  if (!branches.empty()) {
+    this->add(process_id, branches.data(), branches.size());
+  }
+}
+
+perf::analyzer::BranchAnalyzer::Entry
+perf::analyzer::BranchAnalyzer::entry(const perf::Branch& branch) noexcept
+{
+  return Entry{ branch.instruction_pointer_from(),
+                branch.instruction_pointer_to(),
+                branch.is_mispredicted(),
+                branch.cycles(),
+                branch.type() };
+}
+
+perf::analyzer::BranchAnalyzer::Entry
+perf::analyzer::BranchAnalyzer::entry(const perf_branch_entry& branch) noexcept
+{
+#ifndef PERFCPP_NO_SAMPLE_BRANCH_TYPE
+  const auto type = static_cast<Branch::Type>(branch.type);
+#else
+  const auto type = Branch::Type::Unknown;
+#endif
+
+  return Entry{ branch.from, branch.to, static_cast<bool>(branch.mispred), std::uint16_t(branch.cycles), type };
+}
+
+template<typename B>
+void
+perf::analyzer::BranchAnalyzer::add(const std::uint32_t process_id, const B* branches, const std::size_t size)
+{
+  ++this->_count_samples;
+  this->_count_branches += size;
+
+  for (auto index = std::size_t{ 0U }; index < size; ++index) {
+    const auto branch = BranchAnalyzer::entry(branches[index]);
+
+    auto& edge = this->_edges.get(process_id, branch.from, branch.to);
+    if (edge.count == 0U) {
+      edge.type = branch.type;
+    }
+    ++edge.count;
+    edge.count_mispredicted += static_cast<std::uint64_t>(branch.is_mispredicted);
+
+    /// The cycles of an entry are the cycles since the preceding (older) branch, i.e., of the block ending with the
+    /// branch.
+    if (branch.cycles > 0U) {
+      edge.count_cycles += branch.cycles;
+      ++edge.count_with_cycles;
+    }
+
+    auto& type = this->_types[static_cast<std::uint8_t>(branch.type) & 0xFU];
+    ++type.count;
+    type.count_mispredicted += static_cast<std::uint64_t>(branch.is_mispredicted);
+
+    /// The stack starts with the most recent branch; the range from the target of the preceding branch to this branch
+    /// was executed without another taken branch.
+    if (index + 1U < size) {
+      const auto begin = BranchAnalyzer::entry(branches[index + 1U]).to;
+      const auto end = branch.from;
+      if (begin == 0U || end < begin || end - begin > BranchAnalyzer::MAX_RANGE_SIZE) {
+        continue;
+      }
+
+      auto& range = this->_ranges.get(process_id, begin, end);
+      ++range.count;
+      if (branch.cycles > 0U) {
+        range.count_cycles += branch.cycles;
+        ++range.count_with_cycles;
+      }
+    }
+  }
+}
+
+template void perf::analyzer::BranchAnalyzer::add<perf::Branch>(std::uint32_t, const perf::Branch*, std::size_t);
+template void perf::analyzer::BranchAnalyzer::add<perf_branch_entry>(std::uint32_t,
+                                                                      const perf_branch_entry*,
+                                                                      std::size_t);
+
+void
+perf::analyzer::BranchAnalyzer::merge(const perf::analyzer::BranchAnalyzer& other)
+{
+  this->_count_samples += other._count_samples;
+  this->_count_branches += other._count_branches;
+
+  for (const auto& slot : other._edges.slots()) {
+    if (slot.is_occupied) {
+      auto& edge = this->_edges.get(slot.process_id, slot.first, slot.second);
+      if (edge.count == 0U) {
+        edge.type = slot.value.type;
+      }
+      edge.count += slot.value.count;
+      edge.count_mispredicted += slot.value.count_mispredicted;
+      edge.count_cycles += slot.value.count_cycles;
+      edge.count_with_cycles += slot.value.count_with_cycles;
+    }
+  }
+
+  for (const auto& slot : other._ranges.slots()) {
+    if (slot.is_occupied) {
+      auto& range = this->_ranges.get(slot.process_id, slot.first, slot.second);
+      range.count += slot.value.count;
+      range.count_cycles += slot.value.count_cycles;
+      range.count_with_cycles += slot.value.count_with_cycles;
+    }
+  }
+
+  for (auto type = 0U; type < this->_types.size(); ++type) {
+    this->_types[type].count += other._types[type].count;
+    this->_types[type].count_mispredicted += other._types[type].count_mispredicted;
+  }
+}
+
+std::vector<perf::analyzer::BranchAnalyzer::Edge>
+perf::analyzer::BranchAnalyzer::edges(const std::size_t count) const
+{
+  auto edges = std::vector<Edge>{};
+  edges.reserve(this->_edges.size());
+  for (const auto& slot : this->_edges.slots()) {
+    if (slot.is_occupied) {
+      edges.emplace_back(slot.process_id,
+                         slot.first,
+                         slot.second,
+                         slot.value.type,
+                         slot.value.count,
+                         slot.value.count_mispredicted,
+                         slot.value.count_cycles,
+                         slot.value.count_with_cycles);
+    }
+  }
+
+  const auto count_edges = std::min(count, edges.size());
+  std::partial_sort(edges.begin(),
+                    edges.begin() + std::int64_t(count_edges),
+                    edges.end(),
+                    [](const auto& left, const auto& right) {
+                      return left.count() > right.count() ||
+                             (left.count() == right.count() && left.from() < right.from());
+                    });
+  edges.erase(edges.begin() + std::int64_t(count_edges), edges.end());
+
+  return edges;
+}
+
+std::vector<perf::analyzer::BranchAnalyzer::Range>
+perf::analyzer::BranchAnalyzer::ranges(const std::size_t count) const
+{
+  auto ranges = std::vector<Range>{};
+  ranges.reserve(this->_ranges.size());
+  for (const auto& slot : this->_ranges.slots()) {
+    if (slot.is_occupied) {
+      ranges.emplace_back(slot.process_id,
+                          slot.first,
+                          slot.second,
+                          slot.value.count,
+                          slot.value.count_cycles,
+                          slot.value.count_with_cycles);
+    }
+  }
+
+  const auto count_ranges = std::min(count, ranges.size());
+  std::partial_sort(ranges.begin(),
+                    ranges.begin() + std::int64_t(count_ranges),
+                    ranges.end(),
+                    [](const auto& left, const auto& right) {
+                      return left.count() > right.count() ||
+                             (left.count() == right.count() && left.begin() < right.begin());
+                    });
+  ranges.erase(ranges.begin() + std::int64_t(count_ranges), ranges.end());
+
+  return ranges;
+}
+
+std::vector<perf::analyzer::BranchAnalyzer::TypeStatistic>
+perf::analyzer::BranchAnalyzer::types() const
+{
+  auto types = std::vector<TypeStatistic>{};
+  for (auto type = 0U; type < this->_types.size(); ++type) {
+    if (this->_types[type].count > 0U) {
+      types.emplace_back(
+        static_cast<Branch::Type>(type), this->_types[type].count, this->_types[type].count_mispredicted);
+    }
+  }
+
+  return types;
+}
+
+std::vector<std::pair<std::string, std::string>>
+perf::analyzer::BranchAnalyzer::to_autofdo(perf::Symbolizer& symbolizer) const
+{
+  /// Ranges and edges per binary, keyed by the addresses within the binary; processes running the same binary (at
+  /// different load addresses) are combined.
+  struct Profile
+  {
+    std::map<std::pair<std::uintptr_t, std::uintptr_t>, std::uint64_t> ranges;
+    std::map<std::pair<std::uintptr_t, std::uintptr_t>, std::uint64_t> edges;
+  };
+  auto profiles = std::map<std::string_view, Profile>{};
+
+  /// Translates both addresses into the same binary; pairs crossing binaries cannot be expressed in a profile.
+  const auto translate = [&symbolizer](const std::uint32_t process_id,
+                                       const std::uintptr_t first,
+                                       const std::uintptr_t second)
+    -> std::optional<std::tuple<std::string_view, std::uintptr_t, std::uintptr_t>> {
+    const auto first_address = symbolizer.translate(process_id, first);
+    const auto second_address = symbolizer.translate(process_id, second);
+    if (!first_address.has_value() || !second_address.has_value() ||
+        first_address->module() != second_address->module()) {
+      return std::nullopt;
+    }
+
+    return std::make_tuple(first_address->module(), first_address->address(), second_address->address());
+  };
+
+  for (const auto& slot : this->_ranges.slots()) {
+    if (slot.is_occupied) {
+      if (const auto range = translate(slot.process_id, slot.first, slot.second); range.has_value()) {
+        const auto& [module, begin, end] = range.value();
+        profiles[module].ranges[std::make_pair(begin, end)] += slot.value.count;
+      }
+    }
+  }
+
+  for (const auto& slot : this->_edges.slots()) {
+    if (slot.is_occupied) {
+      if (const auto edge = translate(slot.process_id, slot.first, slot.second); edge.has_value()) {
+        const auto& [module, from, to] = edge.value();
+        profiles[module].edges[std::make_pair(from, to)] += slot.value.count;
+      }
+    }
+  }
+
+  auto result = std::vector<std::pair<std::string, std::string>>{};
+  result.reserve(profiles.size());
+  for (const auto& [module, profile] : profiles) {
+    auto stream = std::stringstream{};
+
+    stream << profile.ranges.size() << "\n" << std::hex;
+    for (const auto& [range, count] : profile.ranges) {
+      stream << range.first << "-" << range.second << ":" << std::dec << count << std::hex << "\n";
+    }
+
+    stream << std::dec << profile.edges.size() << "\n" << std::hex;
+    for (const auto& [edge, count] : profile.edges) {
+      stream << edge.first << "->" << edge.second << ":" << std::dec << count << std::hex << "\n";
+    }
+
+    result.emplace_back(std::string{ module }, stream.str());
+  }
+
+  return result;
+}
+
+std::string
+perf::analyzer::BranchAnalyzer::to_string(const std::size_t count, perf::Symbolizer* symbolizer) const
+{
+  auto stream = std::stringstream{};
+  stream << std::setw(12) << "count" << std::setw(10) << "mispred %" << std::setw(10) << "cycles" << std::setw(16)
+         << "type"
+         << "   branch\n";
+
+  for (const auto& edge : this->edges(count)) {
+    stream << std::setw(12) << edge.count() << std::setw(10) << std::fixed << std::setprecision(2)
+           << (100.0 * edge.misprediction_rate()) << std::setw(10);
+    if (const auto cycles = edge.average_cycles(); cycles.has_value()) {
+      stream << cycles.value();
+    } else {
+      stream << "-";
+    }
+    stream << std::setw(16) << BranchAnalyzer::name(edge.type()) << "   "
+           << BranchAnalyzer::name(edge.process_id(), edge.from(), symbolizer) << " -> "
+           << BranchAnalyzer::name(edge.process_id(), edge.to(), symbolizer) << "\n";
+  }
+
+  stream << "\n" << std::setw(16) << "type" << std::setw(12) << "count" << std::setw(12) << "mispred %"
+         << "\n";
+  for (const auto& type : this->types()) {
+    stream << std::setw(16) << BranchAnalyzer::name(type.type()) << std::setw(12) << type.count() << std::setw(12)
+           << std::fixed << std::setprecision(2) << (100.0 * type.misprediction_rate()) << "\n";
+  }
+
+  return stream.str();
+}
+
+std::string
+perf::analyzer::BranchAnalyzer::name(const std::uint32_t process_id,
+                                     const std::uintptr_t address,
+                                     perf::Symbolizer* symbolizer)
+{
+  auto stream = std::stringstream{};
+  if (symbolizer != nullptr) {
+    if (const auto symbol = symbolizer->resolve(process_id, address); symbol.has_value()) {
+      stream << symbol->demangled_name() << "+0x" << std::hex << symbol->offset();
+      return stream.str();
+    }
+  }
+
+  stream << "0x" << std::hex << address;
+  return stream.str();
+}
+
+const char*
+perf::analyzer::BranchAnalyzer::name(const perf::Branch::Type type) noexcept
+{
+  switch (type) {
+    case Branch::Type::Unknown:
+      return "unknown";
+    case Branch::Type::Conditional:
+      return "cond";
+    case Branch::Type::Unconditional:
+      return "uncond";
+    case Branch::Type::IndirectJump:
+      return "ind";
+    case Branch::Type::Call:
+      return "call";
+    case Branch::Type::IndirectCall:
+      return "ind_call";
+    case Branch::Type::Return:
+      return "ret";
+    case Branch::Type::SystemCall:
+      return "syscall";
+    case Branch::Type::SystemReturn:
+      return "sysret";
+    case Branch::Type::ConditionalCall:
+      return "cond_call";
+    case Branch::Type::ConditionalReturn:
+      return "cond_ret";
+    case Branch::Type::ExceptionReturn:
+      return "eret";
+    case Branch::Type::Interrupt:
+      return "irq";
+    case Branch::Type::SystemError:
+      return "serror";
+    case Branch::Type::NotInTransaction:
+      return "no_tx";
+    case Branch::Type::Extended:
+      return "extended";
+  }
+
+  return "unknown";
+}
@@ -0,0 +1,288 @@
+#include <algorithm>
+#include <iomanip>
+#include <linux/perf_event.h>
+#include <map>
+#include <perfcpp/analyzer/call_tree.h>
+#include <sstream>
+#include <type_traits>
+
+template<typename S>
+void
+perf::analyzer::CallTree::consume_sample(const S& sample)
+{
+  const auto process_id = sample.process_id().value_or(0U);
+
+  if constexpr (std::is_same_v<S, SampleView>) {
+    const auto callchain = sample.callchain();
+    if (!callchain.empty()) {
+      this->add(process_id, reinterpret_cast<const std::uintptr_t*>(callchain.data()), callchain.size(), 1U);
+      return;
+    }
+  } else {
+    if (const auto& callchain = sample.callchain(); callchain.has_value() && !callchain->empty()) {
+      this->add(process_id, callchain->data(), callchain->size(), 1U);
+      return;
+    }
+  }
+
+  /// Fall back to the instruction pointer if no call chain was sampled.
+  if (const auto instruction_pointer = sample.instruction_pointer(); instruction_pointer.has_value()) {
+    const auto address = std::uintptr_t{ instruction_pointer.value() };
+    this->add(process_id, &address, 1U, 1U);
+  }
+}
+
+template void perf::analyzer::CallTree::consume_sample<perf::Sample>(const perf::Sample&);
+template void perf::analyzer::CallTree::consume_sample<perf::SampleView>(const perf::SampleView&);
+
+void
+perf::analyzer::CallTree::add(const std::uint32_t process_id,
+                              const std::uintptr_t* callchain,
+                              const std::size_t size,
+                              const std::uint64_t count)
+{
+  this->_count_samples += count;
+  this->_nodes.front().count_total += count;
+
+  /// Processes are the children of the root.
+  auto node_id = this->child(0U, std::uintptr_t{ process_id }, process_id);
+  this->_nodes[node_id].count_total += count;
+
+  /// The call chain starts with the innermost frame; the tree starts with the outermost.
+  for (auto index = size; index > 0U; --index) {
+    const auto address = callchain[index - 1U];
+
+    /// Skip context markers (PERF_CONTEXT_KERNEL, PERF_CONTEXT_USER, ...).
+    if (address >= std::uintptr_t(PERF_CONTEXT_MAX)) {
+      continue;
+    }
+
+    node_id = this->child(node_id, address, process_id);
+    this->_nodes[node_id].count_total += count;
+  }
+
+  this->_nodes[node_id].count_self += count;
+}
+
+void
+perf::analyzer::CallTree::merge(const perf::analyzer::CallTree& other)
+{
+  this->_count_samples += other._count_samples;
+  this->_nodes.front().count_total += other._nodes.front().count_total;
+
+  /// Nodes are created after their parents, so parents are always mapped before their children.
+  auto node_ids = std::vector<std::uint32_t>(other._nodes.size(), 0U);
+  for (auto other_node_id = 1U; other_node_id < other._nodes.size(); ++other_node_id) {
+    const auto& other_node = other._nodes[other_node_id];
+
+    const auto node_id = this->child(node_ids[other_node.parent], other_node.address, other_node.process_id);
+    this->_nodes[node_id].count_self += other_node.count_self;
+    this->_nodes[node_id].count_total += other_node.count_total;
+
+    node_ids[other_node_id] = node_id;
+  }
+}
+
+std::uint32_t
+perf::analyzer::CallTree::child(const std::uint32_t parent,
+                                const std::uintptr_t address,
+                                const std::uint32_t process_id)
+{
+  const auto [iterator, is_inserted] =
+    this->_children.try_emplace(ChildKey{ parent, address }, std::uint32_t(this->_nodes.size()));
+
+  if (is_inserted) {
+    const auto node_id = iterator->second;
+    this->_nodes.push_back(Node{ address, process_id, parent, NO_NODE, this->_nodes[parent].first_child, 0U, 0U });
+    this->_nodes[parent].first_child = node_id;
+  }
+
+  return iterator->second;
+}
+
+std::string
+perf::analyzer::CallTree::to_collapsed_stacks() const
+{
+  return this->to_collapsed_stacks([](const Node& node) {
+    auto stream = std::stringstream{};
+    stream << "0x" << std::hex << node.address;
+    return stream.str();
+  });
+}
+
+std::string
+perf::analyzer::CallTree::to_collapsed_stacks(perf::Symbolizer& symbolizer) const
+{
+  return this->to_collapsed_stacks([&symbolizer](const Node& node) {
+    if (const auto symbol = symbolizer.resolve(node.process_id, node.address); symbol.has_value()) {
+      return symbol->demangled_name();
+    }
+
+    auto stream = std::stringstream{};
+    stream << "0x" << std::hex << node.address;
+    return stream.str();
+  });
+}
+
+template<typename F>
+std::string
+perf::analyzer::CallTree::to_collapsed_stacks(F&& frame_name) const
+{
+  /// Different addresses within the same function yield the same stack; stacks are aggregated by their names.
+  auto stacks = std::map<std::string, std::uint64_t>{};
+
+  /// Only prefix the stacks with the process, if the tree contains multiple processes.
+  const auto first_process_node_id = this->_nodes.front().first_child;
+  const auto is_print_process =
+    first_process_node_id != NO_NODE && this->_nodes[first_process_node_id].next_sibling != NO_NODE;
+
+  /// Depth-first traversal, keeping the names of the frames on the current stack.
+  auto stack = std::vector<std::pair<std::uint32_t, std::size_t>>{};
+  auto path = std::string{};
+
+  for (auto process_node_id = this->_nodes.front().first_child; process_node_id != NO_NODE;
+       process_node_id = this->_nodes[process_node_id].next_sibling) {
+    path.clear();
+    if (is_print_process) {
+      path.append("pid ").append(std::to_string(this->_nodes[process_node_id].process_id));
+    }
+
+    for (auto child_id = this->_nodes[process_node_id].first_child; child_id != NO_NODE;
+         child_id = this->_nodes[child_id].next_sibling) {
+      stack.emplace_back(child_id, path.size());
+    }
+
+    while (!stack.empty()) {
+      const auto [node_id, path_length] = stack.back();
+      stack.pop_back();
+
+      const auto& node = this->_nodes[node_id];
+      path.resize(path_length);
+      if (!path.empty()) {
+        path.push_back(';');
+      }
+
+      /// Flame-graph tools use semicolons and spaces as separators.
+      auto name = frame_name(node);
+      std::replace(name.begin(), name.end(), ';', ':');
+      std::replace(name.begin(), name.end(), ' ', '_');
+      path.append(name);
+
+      if (node.count_self > 0U) {
+        stacks[path] += node.count_self;
+      }
+
+      const auto current_path_length = path.size();
+      for (auto child_id = node.first_child; child_id != NO_NODE; child_id = this->_nodes[child_id].next_sibling) {
+        stack.emplace_back(child_id, current_path_length);
+      }
+    }
+  }
+
+  auto stream = std::stringstream{};
+  for (const auto& [stack_path, count_samples] : stacks) {
+    stream << stack_path << " " << count_samples << "\n";
+  }
+
+  return stream.str();
+}
+
+std::vector<perf::analyzer::CallTree::Hotspot>
+perf::analyzer::CallTree::hotspots(const std::size_t count, perf::Symbolizer* symbolizer) const
+{
+  /// Translate every frame into an (interned) name.
+  auto names = std::vector<std::string>{};
+  auto name_ids = std::unordered_map<std::string, std::uint32_t>{};
+  auto node_name_ids = std::vector<std::uint32_t>(this->_nodes.size(), 0U);
+
+  for (auto node_id = 1U; node_id < this->_nodes.size(); ++node_id) {
+    const auto& node = this->_nodes[node_id];
+
+    /// Process nodes have no name.
+    if (node.parent == 0U) {
+      continue;
+    }
+
+    auto name = std::string{};
+    if (symbolizer != nullptr) {
+      if (const auto symbol = symbolizer->resolve(node.process_id, node.address); symbol.has_value()) {
+        name = symbol->demangled_name();
+      }
+    }
+    if (name.empty()) {
+      auto stream = std::stringstream{};
+      stream << "0x" << std::hex << node.address;
+      name = stream.str();
+    }
+
+    const auto [iterator, is_inserted] = name_ids.try_emplace(name, std::uint32_t(names.size() + 1U));
+    if (is_inserted) {
+      names.push_back(std::move(name));
+    }
+    node_name_ids[node_id] = iterator->second;
+  }
+
+  /// Aggregate the samples per name. Total samples of recursive calls are only counted once (at the outermost call).
+  auto count_self = std::vector<std::uint64_t>(names.size() + 1U, 0U);
+  auto count_total = std::vector<std::uint64_t>(names.size() + 1U, 0U);
+  for (auto node_id = 1U; node_id < this->_nodes.size(); ++node_id) {
+    const auto name_id = node_name_ids[node_id];
+    if (name_id == 0U) {
+      continue;
+    }
+
+    const auto& node = this->_nodes[node_id];
+    count_self[name_id] += node.count_self;
+
+    auto is_recursive = false;
+    for (auto ancestor_id = node.parent; ancestor_id != 0U; ancestor_id = this->_nodes[ancestor_id].parent) {
+      if (node_name_ids[ancestor_id] == name_id) {
+        is_recursive = true;
+        break;
+      }
+    }
+
+    if (!is_recursive) {
+      count_total[name_id] += node.count_total;
+    }
+  }
+
+  auto hotspots = std::vector<Hotspot>{};
+  hotspots.reserve(names.size());
+  for (auto name_id = 1U; name_id <= names.size(); ++name_id) {
+    hotspots.emplace_back(std::move(names[name_id - 1U]), count_self[name_id], count_total[name_id]);
+  }
+
+  const auto count_hotspots = std::min(count, hotspots.size());
+  std::partial_sort(hotspots.begin(),
+                    hotspots.begin() + std::int64_t(count_hotspots),
+                    hotspots.end(),
+                    [](const auto& left, const auto& right) {
+                      return left.count_self() > right.count_self() ||
+                             (left.count_self() == right.count_self() && left.count_total() > right.count_total());
+                    });
+  hotspots.erase(hotspots.begin() + std::int64_t(count_hotspots), hotspots.end());
+
+  return hotspots;
+}
+
+std::string
+perf::analyzer::CallTree::to_string(const std::size_t count, perf::Symbolizer* symbolizer) const
+{
+  const auto hotspots = this->hotspots(count, symbolizer);
+
+  auto stream = std::stringstream{};
+  stream << std::setw(12) << "self" << std::setw(10) << "self %" << std::setw(12) << "total" << std::setw(10)
+         << "total %"
+         << "   function\n";
+
+  const auto count_samples = double(std::max<std::uint64_t>(this->_count_samples, 1U));
+  for (const auto& hotspot : hotspots) {
+    stream << std::setw(12) << hotspot.count_self() << std::setw(10) << std::fixed << std::setprecision(2)
+           << (100.0 * double(hotspot.count_self()) / count_samples) << std::setw(12) << hotspot.count_total()
+           << std::setw(10) << (100.0 * double(hotspot.count_total()) / count_samples) << "   " << hotspot.name()
+           << "\n";
+  }
+
+  return stream.str();
+}
@@ -1,28 +1,36 @@
 #include <algorithm>
+#include <exception>
 #include <iomanip>
+#include <iterator>
 #include <perfcpp/analyzer/data.h>
 #include <sstream>
 #include <stdexcept>
-#include <unordered_set>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unistd.h>
+#include <unordered_map>
 
 void
 perf::analyzer::DataAnalyzer::add(perf::analyzer::DataType&& data_type)
 {
-  auto name = data_type.name();
-
-  if (this->_instances.find(name) != this->_instances.end()) {
-    throw std::runtime_error{ std::string{ "Data type " }.append(name).append(" is already registered.") };
+  if (this->_data_type_ids.find(data_type.name()) != this->_data_type_ids.end()) {
+    throw std::runtime_error{ std::string{ "Data type " }.append(data_type.name()).append(" is already registered.") };
   }
 
-  this->_instances.insert(
-    std::make_pair(std::move(name), std::make_pair(std::move(data_type), std::vector<std::uintptr_t>{})));
+  this->_data_type_ids.insert(std::make_pair(data_type.name(), this->_data_types.size()));
+  this->_data_types.push_back(std::move(data_type));
+  this->_consumed_data_types.push_back(this->_data_types.back());
+  this->_annotations.emplace_back();
+  this->_consume_index.reset();
 }
 
 void
 perf::analyzer::DataAnalyzer::annotate(const std::string& name, const std::uintptr_t reference)
 {
-  if (auto iterator = _instances.find(name); iterator != _instances.end()) {
-    iterator->second.second.push_back(reference);
+  if (auto iterator = this->_data_type_ids.find(name); iterator != this->_data_type_ids.end()) {
+    this->_annotations[iterator->second].emplace_back(reference, 1U);
+    this->_consume_index.reset();
   }
 }
 
@@ -31,63 +39,601 @@ perf::analyzer::DataAnalyzer::annotate(const std::string& name,
                                        const void* reference,
                                        const std::uint64_t items_in_array)
 {
-  if (auto iterator = _instances.find(name); iterator != _instances.end()) {
-    auto& data_type = std::get<0>(iterator->second);
-    const auto data_type_size = data_type.size();
+  if (auto iterator = this->_data_type_ids.find(name); iterator != this->_data_type_ids.end()) {
+    this->_annotations[iterator->second].emplace_back(std::uintptr_t(reference), items_in_array);
+    this->_consume_index.reset();
+  }
+}
+
+perf::analyzer::DataAnalyzerResult
+perf::analyzer::DataAnalyzer::map(const std::vector<Sample>& samples, const bool is_keep_samples)
+{
+  const auto index = Index{ this->_data_types, this->_annotations };
+
+  const auto count_threads = std::max<std::size_t>(
+    1U,
+    std::min<std::size_t>(samples.size() / DataAnalyzer::MIN_SAMPLES_PER_THREAD,
+                          std::size_t{ std::thread::hardware_concurrency() }));
+  const auto count_samples_per_thread = (samples.size() + count_threads - 1U) / count_threads;
+
+  /// Every thread maps a consecutive chunk of samples into its own (partial) result.
+  auto partial_results = std::vector<std::vector<DataType>>(count_threads, this->_data_types);
+  auto exceptions = std::vector<std::exception_ptr>(count_threads);
+  const auto map_chunk = [&](const std::size_t thread_id) {
+    try {
+      auto& data_types = partial_results[thread_id];
+
+      const auto begin = std::min(samples.size(), thread_id * count_samples_per_thread);
+      const auto end = std::min(samples.size(), begin + count_samples_per_thread);
+      for (auto sample_id = begin; sample_id < end; ++sample_id) {
+        const auto& sample = samples[sample_id];
+        if (sample.logical_memory_address().has_value()) {
+          if (const auto position = index.find(sample.logical_memory_address().value()); position.has_value()) {
+            auto& member = data_types[position->first].members()[position->second];
+            member.statistics().add(sample);
+
+            if (is_keep_samples) {
+              member.samples().emplace_back(sample);
+            }
+          }
+        }
+      }
+    } catch (...) {
+      exceptions[thread_id] = std::current_exception();
+    }
+  };
+
+  /// Spawn threads for all but the first chunk, which is mapped by the calling thread.
+  auto threads = std::vector<std::thread>{};
+  threads.reserve(count_threads - 1U);
+  for (auto thread_id = std::size_t{ 1U }; thread_id < count_threads; ++thread_id) {
+    threads.emplace_back(map_chunk, thread_id);
+  }
+  map_chunk(0U);
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
 
-    const auto array_begin = std::uintptr_t(reference);
-    const auto array_end = array_begin + data_type_size * items_in_array;
+  for (const auto& exception : exceptions) {
+    if (exception != nullptr) {
+      std::rethrow_exception(exception);
+    }
+  }
 
-    for (auto addr = array_begin; addr < array_end; addr += data_type_size) {
-      std::get<1>(iterator->second).emplace_back(addr);
+  /// Merge the partial results into the first one; samples stay in the order of the input.
+  auto& data_types = partial_results.front();
+  for (auto thread_id = std::size_t{ 1U }; thread_id < count_threads; ++thread_id) {
+    auto& partial_data_types = partial_results[thread_id];
+    for (auto data_type_id = 0U; data_type_id < data_types.size(); ++data_type_id) {
+      auto& members = data_types[data_type_id].members();
+      auto& partial_members = partial_data_types[data_type_id].members();
+      for (auto member_id = 0U; member_id < members.size(); ++member_id) {
+        auto& member = members[member_id];
+        auto& partial_member = partial_members[member_id];
+
+        member.statistics() += partial_member.statistics();
+        std::move(partial_member.samples().begin(),
+                  partial_member.samples().end(),
+                  std::back_inserter(member.samples()));
+      }
     }
+
+    partial_data_types.clear();
   }
+
+  return DataAnalyzerResult{ std::move(data_types) };
 }
 
-perf::analyzer::DataAnalyzerResult
-perf::analyzer::DataAnalyzer::map(const std::vector<Sample>& samples)
-{
-  auto instances = this->_instances;
-
-  auto member_map = std::vector<std::pair<DataType::Member*, std::unordered_set<std::uintptr_t>>>{};
-  member_map.reserve(instances.size() * 8U);
-
-  for (auto& [_, data_type_and_instances] : instances) {
-    auto& data_type = std::get<0>(data_type_and_instances);
-    const auto& data_type_instances = std::get<1>(data_type_and_instances);
-    for (auto& member : data_type.members()) {
-      auto member_instances = std::unordered_set<std::uintptr_t>{};
-      member_instances.reserve(data_type_instances.size() * member.size());
-      for (const auto instance : data_type_instances) {
-        for (auto member_byte = instance + member.offset(); member_byte < instance + member.offset() + member.size();
-             ++member_byte) {
-          member_instances.insert(member_byte);
+perf::analyzer::SharingAnalyzerResult
+perf::analyzer::DataAnalyzer::map_lines(const std::vector<Sample>& samples, const Granularity granularity) const
+{
+  const auto index = Index{ this->_data_types, this->_annotations };
+  const auto base_page_size = std::size_t(::sysconf(_SC_PAGESIZE));
+
+  /// Adds the id to the (small, unsorted) list of ids, if not already present.
+  const auto add_id = [](std::vector<std::uint32_t>& ids, const std::uint32_t id) {
+    if (std::find(ids.begin(), ids.end(), id) == ids.end()) {
+      ids.emplace_back(id);
+    }
+  };
+
+  auto lines = std::vector<SharingAnalyzerResult::Line>{};
+  auto line_ids = std::unordered_map<std::uintptr_t, std::size_t>{};
+
+  /// Members on every line, identified by their position in the data types.
+  auto member_positions = std::vector<std::vector<Index::Position>>{};
+
+  for (const auto& sample : samples) {
+    const auto address = sample.logical_memory_address();
+    if (!address.has_value()) {
+      continue;
+    }
+
+    auto line_size = DataAnalyzer::CACHE_LINE_SIZE;
+    if (granularity == Granularity::Page) {
+      line_size = std::size_t(sample.data_page_size().value_or(base_page_size));
+      if (line_size == 0U) {
+        line_size = base_page_size;
+      }
+    }
+    const auto line_begin = address.value() - (address.value() % line_size);
+
+    auto [iterator, is_inserted] = line_ids.try_emplace(line_begin, lines.size());
+    if (is_inserted) {
+      lines.emplace_back(line_begin, line_size);
+      member_positions.emplace_back();
+    }
+    auto& line = lines[iterator->second];
+
+    const auto data_source = sample.data_src();
+    const auto is_load = data_source.has_value() && data_source->is_load();
+    const auto is_store = data_source.has_value() && data_source->is_store();
+    const auto is_hitm = data_source.has_value() && data_source->is_snoop_hit_modified();
+
+    ++line._count_samples;
+    line._count_loads += is_load;
+    line._count_stores += is_store;
+    line._count_hitm += is_hitm;
+
+    if (sample.thread_id().has_value()) {
+      add_id(line._thread_ids, sample.thread_id().value());
+    }
+    if (sample.cpu_id().has_value()) {
+      add_id(line._cpu_ids, sample.cpu_id().value());
+    }
+
+    /// Attribute the sample to the annotated member.
+    if (const auto position = index.find(address.value()); position.has_value()) {
+      auto& positions = member_positions[iterator->second];
+      auto member_iterator = std::find(positions.begin(), positions.end(), position.value());
+      if (member_iterator == positions.end()) {
+        const auto& data_type = this->_data_types[position->first];
+        const auto& data_type_member = data_type.members()[position->second];
+        line._members.emplace_back(
+          data_type.name(), data_type_member.name(), data_type_member.offset(), data_type_member.size());
+        member_iterator = positions.insert(positions.end(), position.value());
+      }
+
+      auto& member = line._members[std::size_t(std::distance(positions.begin(), member_iterator))];
+      ++member._count_samples;
+      member._count_stores += is_store;
+      member._count_hitm += is_hitm;
+      if (sample.thread_id().has_value()) {
+        add_id(member._thread_ids, sample.thread_id().value());
+      }
+    }
+  }
+
+  /// Keep shared lines only, most contended lines first.
+  lines.erase(std::remove_if(lines.begin(), lines.end(), [](const auto& line) { return !line.is_shared(); }),
+              lines.end());
+  std::sort(lines.begin(), lines.end(), [](const auto& left, const auto& right) {
+    return std::make_tuple(left.count_hitm(), left.count_stores(), left.count_samples()) >
+           std::make_tuple(right.count_hitm(), right.count_stores(), right.count_samples());
+  });
+
+  return SharingAnalyzerResult{ std::move(lines) };
+}
+
+bool
+perf::analyzer::SharingAnalyzerResult::Line::is_false_sharing() const noexcept
+{
+  if (!this->is_shared() || this->_members.size() < 2U) {
+    return false;
+  }
+
+  /// The sharing is false if there is a written member whose accessing threads do not access all other members.
+  for (const auto& member : this->_members) {
+    if (member.count_stores() == 0U && member.count_hitm() == 0U) {
+      continue;
+    }
+
+    for (const auto& other_member : this->_members) {
+      if (&member == &other_member) {
+        continue;
+      }
+
+      for (const auto thread_id : other_member.thread_ids()) {
+        if (std::find(member.thread_ids().begin(), member.thread_ids().end(), thread_id) == member.thread_ids().end()) {
+          return true;
         }
       }
+    }
+  }
+
+  return false;
+}
+
+std::string
+perf::analyzer::SharingAnalyzerResult::to_string() const
+{
+  auto stream = std::stringstream{};
+
+  for (auto line_id = 0U; line_id < this->_lines.size(); ++line_id) {
+    const auto& line = this->_lines[line_id];
 
-      member_map.emplace_back(&member, std::move(member_instances));
+    if (line_id > 0U) {
+      stream << "\n";
+    }
+
+    stream << "Line 0x" << std::hex << line.begin() << std::dec << " (" << line.size() << "B) {\n"
+           << "  samples: " << line.count_samples() << ", loads: " << line.count_loads()
+           << ", stores: " << line.count_stores() << ", HITM: " << line.count_hitm()
+           << ", threads: " << line.thread_ids().size() << ", CPUs: " << line.cpu_ids().size()
+           << (line.is_false_sharing() ? " (false sharing)" : "") << "\n";
+
+    for (const auto& member : line.members()) {
+      stream << "  " << member.data_type_name() << "::" << member.name() << " (offset " << member.offset() << ", "
+             << member.size() << "B): samples: " << member.count_samples() << ", stores: " << member.count_stores()
+             << ", HITM: " << member.count_hitm() << ", threads: " << member.thread_ids().size() << "\n";
     }
+
+    stream << "}\n";
   }
 
+  return stream.str();
+}
+
+perf::analyzer::NumaAnalyzerResult
+perf::analyzer::DataAnalyzer::map_numa(const std::vector<Sample>& samples, const NumaTopology& topology) const
+{
+  const auto index = Index{ this->_data_types, this->_annotations };
+  const auto count_nodes = std::max(topology.count_nodes(), std::uint16_t{ 1U });
+  const auto page_size = std::uintptr_t(::sysconf(_SC_PAGESIZE));
+
+  /// The kernel reports a physical address of zero if the address could not be translated.
+  const auto physical_address = [](const Sample& sample) -> std::optional<std::uint64_t> {
+    if (const auto address = sample.physical_memory_address(); address.has_value() && address.value() != 0U) {
+      return address;
+    }
+    return std::nullopt;
+  };
+
+  /// Collect the pages of samples without physical address per process, to look up their nodes in one batch each.
+  auto pages_per_process = std::unordered_map<std::uint32_t, std::vector<std::uintptr_t>>{};
   for (const auto& sample : samples) {
-    if (sample.logical_memory_address().has_value()) {
-      const auto memory_address = sample.logical_memory_address().value();
+    if (const auto address = sample.logical_memory_address();
+        address.has_value() && !physical_address(sample).has_value()) {
+      pages_per_process[sample.process_id().value_or(0U)].emplace_back(address.value() - (address.value() % page_size));
+    }
+  }
 
-      for (auto& member : member_map) {
-        if (auto iterator = std::get<1>(member).find(memory_address); iterator != std::get<1>(member).end()) {
-          std::get<0>(member)->samples().emplace_back(sample);
-          break;
+  using PageNodes = std::unordered_map<std::uintptr_t, std::optional<std::uint16_t>>;
+  auto page_nodes = std::unordered_map<std::uint32_t, PageNodes>{};
+  for (auto& [process_id, pages] : pages_per_process) {
+    std::sort(pages.begin(), pages.end());
+    pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+
+    const auto nodes = NumaTopology::nodes_of_logical_addresses(process_id, pages);
+    auto& nodes_of_process = page_nodes[process_id];
+    for (auto page_id = 0U; page_id < pages.size(); ++page_id) {
+      nodes_of_process.emplace(pages[page_id], nodes[page_id]);
+    }
+  }
+
+  auto total = NumaAnalyzerResult::Traffic{ count_nodes };
+  auto data_types = std::vector<NumaAnalyzerResult::DataTypeTraffic>{};
+  data_types.reserve(this->_data_types.size());
+  for (const auto& data_type : this->_data_types) {
+    data_types.emplace_back(data_type.name(), count_nodes);
+  }
+  auto count_unresolved = std::uint64_t{ 0U };
+
+  for (const auto& sample : samples) {
+    const auto logical_address = sample.logical_memory_address();
+    const auto physical = physical_address(sample);
+    if (!logical_address.has_value() && !physical.has_value()) {
+      continue;
+    }
+
+    auto cpu_node = std::optional<std::uint16_t>{ std::nullopt };
+    if (const auto cpu_id = sample.cpu_id(); cpu_id.has_value()) {
+      cpu_node = topology.node_of_cpu(cpu_id.value());
+    }
+
+    auto memory_node = std::optional<std::uint16_t>{ std::nullopt };
+    if (physical.has_value()) {
+      memory_node = topology.node_of_physical_address(physical.value());
+    } else {
+      const auto& nodes_of_process = page_nodes[sample.process_id().value_or(0U)];
+      if (const auto iterator = nodes_of_process.find(logical_address.value() - (logical_address.value() % page_size));
+          iterator != nodes_of_process.end()) {
+        memory_node = iterator->second;
+      }
+    }
+
+    if (!cpu_node.has_value() || !memory_node.has_value() || cpu_node.value() >= count_nodes ||
+        memory_node.value() >= count_nodes) {
+      ++count_unresolved;
+      continue;
+    }
+
+    total.add(cpu_node.value(), memory_node.value(), sample);
+
+    if (logical_address.has_value()) {
+      if (const auto position = index.find(logical_address.value()); position.has_value()) {
+        data_types[position->first]._traffic.add(cpu_node.value(), memory_node.value(), sample);
+      }
+    }
+  }
+
+  /// Keep data types that were accessed, most remote accesses first.
+  data_types.erase(std::remove_if(data_types.begin(),
+                                  data_types.end(),
+                                  [](const auto& data_type) {
+                                    return data_type.traffic().count_local() + data_type.traffic().count_remote() == 0U;
+                                  }),
+                   data_types.end());
+  std::stable_sort(data_types.begin(), data_types.end(), [](const auto& left, const auto& right) {
+    return left.traffic().count_remote() > right.traffic().count_remote();
+  });
+
+  return NumaAnalyzerResult{ std::move(total), std::move(data_types), count_unresolved };
+}
+
+void
+perf::analyzer::NumaAnalyzerResult::Traffic::add(const std::uint16_t cpu_node,
+                                                 const std::uint16_t memory_node,
+                                                 const perf::Sample& sample)
+{
+  auto& cell = this->_cells[this->index(cpu_node, memory_node)];
+  ++cell.count_samples;
+
+  if (const auto data_source = sample.data_src(); data_source.has_value() && data_source->is_load()) {
+    ++cell.count_loads;
+    if (const auto weight = sample.weight(); weight.has_value() && weight->cache_latency() > 0U) {
+      ++cell.count_loads_with_latency;
+      cell.sum_load_latency += weight->cache_latency();
+    }
+  }
+}
+
+std::optional<double>
+perf::analyzer::NumaAnalyzerResult::Traffic::average_load_latency(const std::uint16_t cpu_node,
+                                                                  const std::uint16_t memory_node) const
+{
+  const auto& cell = this->_cells.at(this->index(cpu_node, memory_node));
+  if (cell.count_loads_with_latency == 0U) {
+    return std::nullopt;
+  }
+
+  return double(cell.sum_load_latency) / double(cell.count_loads_with_latency);
+}
+
+std::uint64_t
+perf::analyzer::NumaAnalyzerResult::Traffic::count_local() const noexcept
+{
+  auto count = std::uint64_t{ 0U };
+  for (auto node = std::uint16_t{ 0U }; node < this->_count_nodes; ++node) {
+    count += this->_cells[this->index(node, node)].count_samples;
+  }
+
+  return count;
+}
+
+std::uint64_t
+perf::analyzer::NumaAnalyzerResult::Traffic::count_remote() const noexcept
+{
+  auto count = std::uint64_t{ 0U };
+  for (const auto& cell : this->_cells) {
+    count += cell.count_samples;
+  }
+
+  return count - this->count_local();
+}
+
+std::string
+perf::analyzer::NumaAnalyzerResult::Traffic::to_string() const
+{
+  auto stream = std::stringstream{};
+
+  const auto count_local = this->count_local();
+  const auto count_remote = this->count_remote();
+  stream << "  samples: " << (count_local + count_remote) << ", local: " << count_local << ", remote: " << count_remote;
+  if (count_local + count_remote > 0U) {
+    stream << " (" << std::fixed << std::setprecision(2)
+           << (100.0 * double(count_remote) / double(count_local + count_remote)) << "% remote)";
+  }
+  stream << "\n";
+
+  /// One row per CPU node, one column (samples | average load latency) per memory node.
+  stream << "  " << std::setw(10) << "CPU node";
+  for (auto memory_node = std::uint16_t{ 0U }; memory_node < this->_count_nodes; ++memory_node) {
+    stream << std::setw(20) << (std::string{ "memory node " } + std::to_string(memory_node));
+  }
+  stream << "\n";
+
+  for (auto cpu_node = std::uint16_t{ 0U }; cpu_node < this->_count_nodes; ++cpu_node) {
+    stream << "  " << std::setw(10) << cpu_node;
+    for (auto memory_node = std::uint16_t{ 0U }; memory_node < this->_count_nodes; ++memory_node) {
+      auto cell = std::stringstream{};
+      cell << this->count_samples(cpu_node, memory_node) << " | ";
+      if (const auto latency = this->average_load_latency(cpu_node, memory_node); latency.has_value()) {
+        cell << std::fixed << std::setprecision(1) << latency.value();
+      } else {
+        cell << "-";
+      }
+      stream << std::setw(20) << cell.str();
+    }
+    stream << "\n";
+  }
+
+  return stream.str();
+}
+
+std::string
+perf::analyzer::NumaAnalyzerResult::to_string() const
+{
+  auto stream = std::stringstream{};
+
+  stream << "Total (samples | average load latency) {\n" << this->_total.to_string() << "}\n";
+  for (const auto& data_type : this->_data_types) {
+    stream << "\nDataType " << data_type.name() << " {\n" << data_type.traffic().to_string() << "}\n";
+  }
+
+  if (this->_count_unresolved > 0U) {
+    stream << "\nUnresolved samples: " << this->_count_unresolved << "\n";
+  }
+
+  return stream.str();
+}
+
+template<typename S>
+void
+perf::analyzer::DataAnalyzer::consume_sample(const S& sample)
+{
+  const auto address = sample.logical_memory_address();
+  if (!address.has_value()) {
+    return;
+  }
+
+  if (!this->_consume_index.has_value()) {
+    this->_consume_index.emplace(this->_data_types, this->_annotations);
+  }
+
+  if (const auto position = this->_consume_index->find(address.value()); position.has_value()) {
+    auto& member = this->_consumed_data_types[position->first].members()[position->second];
+    member.statistics().add(sample);
+
+    if (this->_is_keep_consumed_samples) {
+      if constexpr (std::is_same_v<S, Sample>) {
+        member.samples().emplace_back(sample);
+      } else {
+        member.samples().emplace_back(sample.to_sample());
+      }
+    }
+  }
+}
+
+template void perf::analyzer::DataAnalyzer::consume_sample<perf::Sample>(const perf::Sample&);
+template void perf::analyzer::DataAnalyzer::consume_sample<perf::SampleView>(const perf::SampleView&);
+template void perf::analyzer::DataAnalyzer::consume_sample<perf::SampleBatch::Row>(const perf::SampleBatch::Row&);
+
+void
+perf::analyzer::DataAnalyzer::consume(const perf::SampleBatch& batch)
+{
+  /// Without sampled addresses, no sample can be mapped.
+  if (batch.logical_memory_addresses().empty()) {
+    return;
+  }
+
+  /// Rows are views into the columns of the batch; samples are only copied if they are kept.
+  for (const auto row : batch) {
+    this->consume_sample(row);
+  }
+}
+
+perf::analyzer::AccessStatistics&
+perf::analyzer::AccessStatistics::operator+=(const perf::analyzer::AccessStatistics& other) noexcept
+{
+  this->_count_samples += other._count_samples;
+  this->_count_loads += other._count_loads;
+  this->_count_stores += other._count_stores;
+  this->_sum_load_latency += other._sum_load_latency;
+  this->_sum_store_latency += other._sum_store_latency;
+
+  for (auto bucket = 0U; bucket < AccessStatistics::COUNT_LATENCY_BUCKETS; ++bucket) {
+    this->_load_latency_histogram[bucket] += other._load_latency_histogram[bucket];
+    this->_store_latency_histogram[bucket] += other._store_latency_histogram[bucket];
+  }
+
+  for (auto level = 0U; level < AccessStatistics::COUNT_LEVELS; ++level) {
+    this->_level_histogram[level] += other._level_histogram[level];
+  }
+
+  return *this;
+}
+
+std::uint64_t
+perf::analyzer::AccessStatistics::load_latency_percentile(const double percentile) const noexcept
+{
+  if (this->_count_loads == 0U) {
+    return 0U;
+  }
+
+  const auto rank = std::uint64_t(std::clamp(percentile, 0.0, 1.0) * double(this->_count_loads));
+  auto count_loads = std::uint64_t{ 0U };
+  for (auto bucket = 0U; bucket < AccessStatistics::COUNT_LATENCY_BUCKETS; ++bucket) {
+    count_loads += this->_load_latency_histogram[bucket];
+    if (count_loads > rank) {
+      return AccessStatistics::latency_bucket_begin(bucket);
+    }
+  }
+
+  return AccessStatistics::latency_bucket_begin(AccessStatistics::COUNT_LATENCY_BUCKETS - 1U);
+}
+
+perf::analyzer::DataAnalyzer::Index::Index(
+  const std::vector<DataType>& data_types,
+  const std::vector<std::vector<std::pair<std::uintptr_t, std::uint64_t>>>& annotations)
+{
+  this->_member_ids.reserve(data_types.size());
+  for (auto data_type_id = 0U; data_type_id < data_types.size(); ++data_type_id) {
+    const auto& data_type = data_types[data_type_id];
+
+    /// Map every offset of the data type to the member located there (the first member wins if members overlap).
+    auto member_ids = std::vector<std::uint32_t>(data_type.size(), Index::NO_MEMBER);
+    const auto& members = data_type.members();
+    for (auto member_id = std::uint32_t{ 0U }; member_id < members.size(); ++member_id) {
+      const auto& member = members[member_id];
+      const auto member_end = std::min(member.offset() + member.size(), data_type.size());
+      for (auto offset = member.offset(); offset < member_end; ++offset) {
+        if (member_ids[offset] == Index::NO_MEMBER) {
+          member_ids[offset] = member_id;
         }
       }
     }
+    this->_member_ids.emplace_back(std::move(member_ids));
+
+    /// Add a range for every annotation; data types without size cannot be mapped.
+    if (data_type.size() > 0U) {
+      for (const auto& [begin, count_items] : annotations[data_type_id]) {
+        if (count_items > 0U) {
+          const auto end = begin + data_type.size() * count_items;
+          this->_ranges.push_back(Range{ begin, end, 0U, data_type_id, data_type.size() });
+        }
+      }
+    }
+  }
+
+  std::sort(this->_ranges.begin(), this->_ranges.end(), [](const auto& left, const auto& right) {
+    return left.begin < right.begin;
+  });
+
+  auto max_end = std::uintptr_t{ 0U };
+  for (auto& range : this->_ranges) {
+    max_end = std::max(max_end, range.end);
+    range.max_end = max_end;
   }
+}
+
+std::optional<perf::analyzer::DataAnalyzer::Index::Position>
+perf::analyzer::DataAnalyzer::Index::find(const std::uintptr_t address) const noexcept
+{
+  /// Find the last range that begins at or before the address.
+  auto iterator = std::upper_bound(this->_ranges.begin(),
+                                   this->_ranges.end(),
+                                   address,
+                                   [](const std::uintptr_t value, const Range& range) { return value < range.begin; });
+
+  /// Walk back as long as preceding ranges may contain the address (only the case for overlapping annotations).
+  while (iterator != this->_ranges.begin()) {
+    --iterator;
+
+    if (iterator->max_end <= address) {
+      break;
+    }
 
-  auto data_object = std::vector<DataType>{};
-  for (auto& [_, data_type] : instances) {
-    data_object.push_back(std::move(std::get<0>(data_type)));
+    if (address < iterator->end) {
+      const auto offset = (address - iterator->begin) % iterator->data_type_size;
+      if (const auto member_id = this->_member_ids[iterator->data_type_id][offset]; member_id != Index::NO_MEMBER) {
+        return std::make_pair(iterator->data_type_id, std::size_t{ member_id });
+      }
+    }
   }
 
-  return DataAnalyzerResult{ std::move(data_object) };
+  return std::nullopt;
 }
 
 std::string
@@ -109,36 +655,7 @@ perf::analyzer::DataAnalyzerResult::to_string() const noexcept
     auto members = std::vector<std::vector<std::string>>{};
 
     for (const auto& member : data_type.members()) {
-      auto sum_load_latency = 0ULL;
-      auto sum_store_latency = 0ULL;
-      auto count_loads = 0ULL;
-      auto count_stores = 0ULL;
-      auto count_l1 = 0ULL;
-      auto count_lfb = 0ULL;
-      auto count_l2 = 0ULL;
-      auto count_l3 = 0ULL;
-      auto count_l4 = 0ULL;
-      auto count_local_ram = 0ULL;
-      auto count_remote_ram = 0ULL;
-      for (const auto& sample : member.samples()) {
-        if (sample.weight().has_value() && sample.data_src().has_value()) {
-          sum_load_latency +=
-            (static_cast<std::uint64_t>(sample.data_src().value().is_load()) * sample.weight().value().cache_latency());
-          sum_store_latency += (static_cast<std::uint64_t>(sample.data_src().value().is_store()) *
-                                sample.weight().value().cache_latency());
-
-          count_loads += sample.data_src().value().is_load();
-          count_stores += sample.data_src().value().is_store();
-          count_l1 += sample.data_src().value().is_mem_l1();
-          count_lfb += sample.data_src().value().is_mem_lfb();
-          count_l2 += sample.data_src().value().is_mem_l2();
-          count_l3 += sample.data_src().value().is_mem_l3();
-          count_l4 += sample.data_src().value().is_mem_l4();
-
-          count_local_ram += sample.data_src().value().is_mem_local_ram();
-          count_remote_ram += sample.data_src().value().is_mem_remote_ram();
-        }
-      }
+      const auto& statistics = member.statistics();
 
       auto columns = std::vector<std::string>{};
       columns.reserve(column_headers.size());
@@ -146,17 +663,17 @@ perf::analyzer::DataAnalyzerResult::to_string() const noexcept
       columns.emplace_back(std::to_string(member.offset()).append(": "));
       columns.emplace_back(
         std::string{ member.name() }.append(" (").append(std::to_string(member.size())).append("B)"));
-      columns.emplace_back(std::to_string(member.samples().size()));
-      columns.emplace_back(std::to_string(count_loads));
-      columns.emplace_back(count_loads > 0U ? std::to_string(sum_load_latency / count_loads) : "0");
-      columns.emplace_back(std::to_string(count_l1));
-      columns.emplace_back(std::to_string(count_lfb));
-      columns.emplace_back(std::to_string(count_l2));
-      columns.emplace_back(std::to_string(count_l3));
-      columns.emplace_back(std::to_string(count_local_ram));
-      columns.emplace_back(std::to_string(count_remote_ram));
-      columns.emplace_back(std::to_string(count_stores));
-      columns.emplace_back(count_stores > 0U ? std::to_string(sum_store_latency / count_stores) : "0");
+      columns.emplace_back(std::to_string(statistics.count_samples()));
+      columns.emplace_back(std::to_string(statistics.count_loads()));
+      columns.emplace_back(std::to_string(statistics.average_load_latency()));
+      columns.emplace_back(std::to_string(statistics.count_l1_hits()));
+      columns.emplace_back(std::to_string(statistics.count_lfb_hits()));
+      columns.emplace_back(std::to_string(statistics.count_l2_hits()));
+      columns.emplace_back(std::to_string(statistics.count_l3_hits()));
+      columns.emplace_back(std::to_string(statistics.count_local_ram_hits()));
+      columns.emplace_back(std::to_string(statistics.count_remote_ram_hits()));
+      columns.emplace_back(std::to_string(statistics.count_stores()));
+      columns.emplace_back(std::to_string(statistics.average_store_latency()));
 
       for (auto i = 0U; i < max_sizes.size(); ++i) {
         max_sizes[i] = std::max(max_sizes[i], columns[i].size());
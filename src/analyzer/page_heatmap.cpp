@@ -0,0 +1,254 @@
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <perfcpp/analyzer/page_heatmap.h>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+
+perf::analyzer::PageHeatmap::PageHeatmap(const std::uint64_t window,
+                                         const double decay,
+                                         const std::size_t max_pages,
+                                         const AddressType address_type)
+  : _window(window)
+  , _decay(decay)
+  , _max_pages(max_pages)
+  , _address_type(address_type)
+  , _base_page_size(std::uint64_t(::sysconf(_SC_PAGESIZE)))
+{
+  if (decay < 0.0 || decay > 1.0) {
+    throw std::runtime_error{ "The decay of the PageHeatmap must be between 0 and 1." };
+  }
+
+  if (max_pages < 2U) {
+    throw std::runtime_error{ "The PageHeatmap needs to keep at least two pages." };
+  }
+
+  this->_pages.reserve(max_pages);
+}
+
+template<typename S>
+void
+perf::analyzer::PageHeatmap::consume_sample(const S& sample)
+{
+  auto address = std::optional<std::uint64_t>{ std::nullopt };
+  if (this->_address_type == AddressType::Logical) {
+    address = sample.logical_memory_address();
+  } else if (const auto physical_address = sample.physical_memory_address();
+             physical_address.has_value() && physical_address.value() != 0U) {
+    address = physical_address;
+  }
+
+  if (!address.has_value()) {
+    return;
+  }
+
+  if (const auto time = sample.time(); time.has_value()) {
+    this->advance(time.value());
+  }
+
+  auto page_size = sample.data_page_size().value_or(this->_base_page_size);
+  if (page_size == 0U) {
+    page_size = this->_base_page_size;
+  }
+  const auto page_begin = address.value() - (address.value() % page_size);
+
+  if (this->_pages.size() >= this->_max_pages && this->_pages.find(page_begin) == this->_pages.end()) {
+    this->evict();
+  }
+
+  auto& page = this->_pages[page_begin];
+  page.size = page_size;
+  page.heat += 1.0;
+  ++page.count_window_samples;
+  ++this->_count_samples;
+
+  if (const auto data_source = sample.data_src(); data_source.has_value()) {
+    if (data_source->is_load()) {
+      page.loads += 1.0;
+      if (const auto weight = sample.weight(); weight.has_value() && weight->cache_latency() > 0U) {
+        page.sum_load_latency += double(weight->cache_latency());
+        page.count_loads_with_latency += 1.0;
+      }
+    } else if (data_source->is_store()) {
+      page.stores += 1.0;
+    }
+  }
+}
+
+template void perf::analyzer::PageHeatmap::consume_sample<perf::Sample>(const perf::Sample&);
+template void perf::analyzer::PageHeatmap::consume_sample<perf::SampleView>(const perf::SampleView&);
+
+void
+perf::analyzer::PageHeatmap::advance(const std::uint64_t time)
+{
+  if (this->_window == 0U) {
+    return;
+  }
+
+  if (!this->_window_begin.has_value()) {
+    this->_window_begin = time;
+    return;
+  }
+
+  /// Samples of different CPUs may arrive slightly out of order; they are added to the current window.
+  if (time >= this->_window_begin.value() + this->_window) {
+    const auto count_windows = (time - this->_window_begin.value()) / this->_window;
+    this->_window_begin = this->_window_begin.value() + count_windows * this->_window;
+    this->close_windows(count_windows);
+  }
+}
+
+void
+perf::analyzer::PageHeatmap::close_windows(const std::uint64_t count)
+{
+  if (count == 0U) {
+    return;
+  }
+
+  this->_count_windows += count;
+
+  const auto factor = std::pow(this->_decay, double(std::min(count, std::uint64_t{ 64U })));
+  for (auto iterator = this->_pages.begin(); iterator != this->_pages.end();) {
+    auto& page = iterator->second;
+    page.heat *= factor;
+    page.loads *= factor;
+    page.stores *= factor;
+    page.sum_load_latency *= factor;
+    page.count_loads_with_latency *= factor;
+    page.count_window_samples = 0U;
+
+    if (page.heat < PageHeatmap::MIN_HEAT) {
+      iterator = this->_pages.erase(iterator);
+    } else {
+      ++iterator;
+    }
+  }
+}
+
+void
+perf::analyzer::PageHeatmap::evict()
+{
+  auto heats = std::vector<double>{};
+  heats.reserve(this->_pages.size());
+  for (const auto& [_, page] : this->_pages) {
+    heats.emplace_back(page.heat);
+  }
+
+  /// Evict all pages that are not hotter than the median (at least half of the pages).
+  const auto median = heats.begin() + std::int64_t(heats.size() / 2U);
+  std::nth_element(heats.begin(), median, heats.end());
+  const auto threshold = *median;
+
+  for (auto iterator = this->_pages.begin(); iterator != this->_pages.end();) {
+    if (iterator->second.heat <= threshold) {
+      iterator = this->_pages.erase(iterator);
+      ++this->_count_evicted_pages;
+    } else {
+      ++iterator;
+    }
+  }
+}
+
+std::vector<perf::analyzer::PageHeatmap::Range>
+perf::analyzer::PageHeatmap::ranges(const std::size_t count, const bool is_hot) const
+{
+  auto pages = std::vector<std::pair<std::uintptr_t, const Page*>>{};
+  pages.reserve(this->_pages.size());
+  for (const auto& [begin, page] : this->_pages) {
+    pages.emplace_back(begin, &page);
+  }
+
+  /// Select the hottest (or coldest) pages.
+  const auto count_pages = std::min(count, pages.size());
+  std::partial_sort(pages.begin(),
+                    pages.begin() + std::int64_t(count_pages),
+                    pages.end(),
+                    [is_hot](const auto& left, const auto& right) {
+                      if (left.second->heat != right.second->heat) {
+                        return is_hot ? left.second->heat > right.second->heat
+                                      : left.second->heat < right.second->heat;
+                      }
+                      return left.first < right.first;
+                    });
+  pages.erase(pages.begin() + std::int64_t(count_pages), pages.end());
+
+  /// Merge adjacent pages into ranges.
+  std::sort(pages.begin(), pages.end(), [](const auto& left, const auto& right) { return left.first < right.first; });
+
+  auto ranges = std::vector<Range>{};
+  for (auto index = std::size_t{ 0U }; index < pages.size();) {
+    const auto begin = pages[index].first;
+    auto end = begin;
+    auto count_range_pages = std::uint64_t{ 0U };
+    auto page = Page{};
+
+    for (; index < pages.size() && pages[index].first == end; ++index) {
+      end += pages[index].second->size;
+      ++count_range_pages;
+      page.heat += pages[index].second->heat;
+      page.loads += pages[index].second->loads;
+      page.stores += pages[index].second->stores;
+      page.sum_load_latency += pages[index].second->sum_load_latency;
+      page.count_loads_with_latency += pages[index].second->count_loads_with_latency;
+      page.count_window_samples += pages[index].second->count_window_samples;
+    }
+
+    ranges.emplace_back(begin,
+                        end,
+                        count_range_pages,
+                        page.heat,
+                        page.loads,
+                        page.stores,
+                        page.sum_load_latency,
+                        page.count_loads_with_latency,
+                        page.count_window_samples);
+  }
+
+  std::sort(ranges.begin(), ranges.end(), [is_hot](const auto& left, const auto& right) {
+    const auto left_heat = left.heat() / double(left.count_pages());
+    const auto right_heat = right.heat() / double(right.count_pages());
+    return is_hot ? left_heat > right_heat : left_heat < right_heat;
+  });
+
+  return ranges;
+}
+
+std::string
+perf::analyzer::PageHeatmap::to_string(const std::size_t count) const
+{
+  auto stream = std::stringstream{};
+
+  const auto print = [&stream](const char* title, const std::vector<Range>& ranges) {
+    stream << title << "\n"
+           << std::setw(20) << "begin" << std::setw(20) << "end" << std::setw(8) << "pages" << std::setw(12) << "heat"
+           << std::setw(10) << "window" << std::setw(10) << "write %" << std::setw(10) << "latency"
+           << "\n";
+
+    for (const auto& range : ranges) {
+      stream << std::hex << std::setw(20) << range.begin() << std::setw(20) << range.end() << std::dec << std::setw(8)
+             << range.count_pages() << std::fixed << std::setprecision(2) << std::setw(12) << range.heat()
+             << std::setw(10) << range.count_window_samples() << std::setw(10);
+      if (const auto write_ratio = range.write_ratio(); write_ratio.has_value()) {
+        stream << (100.0 * write_ratio.value());
+      } else {
+        stream << "-";
+      }
+      stream << std::setw(10);
+      if (const auto latency = range.average_load_latency(); latency.has_value()) {
+        stream << latency.value();
+      } else {
+        stream << "-";
+      }
+      stream << "\n";
+    }
+  };
+
+  stream << "Pages: " << this->_pages.size() << ", samples: " << this->_count_samples
+         << ", windows: " << this->_count_windows << ", evicted pages: " << this->_count_evicted_pages << "\n\n";
+  print("Hot ranges", this->hot(count));
+  stream << "\n";
+  print("Cold ranges", this->cold(count));
+
+  return stream.str();
+}
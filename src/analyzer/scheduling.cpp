@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <linux/perf_event.h>
+#include <perfcpp/analyzer/scheduling.h>
+#include <sstream>
+
+void
+perf::analyzer::SchedulingAnalyzer::Histogram::add(const std::uint64_t duration) noexcept
+{
+  /// Bucket b holds durations in [2^(b-1), 2^b).
+  auto bucket = std::size_t{ 0U };
+  for (auto value = duration; value > 0U; value >>= 1U) {
+    ++bucket;
+  }
+
+  ++this->_buckets[bucket];
+  ++this->_count;
+  this->_sum += duration;
+  this->_max = std::max(this->_max, duration);
+}
+
+std::uint64_t
+perf::analyzer::SchedulingAnalyzer::Histogram::percentile(const double percentile) const noexcept
+{
+  if (this->_count == 0U) {
+    return 0U;
+  }
+
+  const auto rank = std::max(std::uint64_t{ 1U },
+                             std::uint64_t(std::ceil(std::min(1.0, percentile) * double(this->_count))));
+
+  auto count = std::uint64_t{ 0U };
+  for (auto bucket = std::size_t{ 0U }; bucket < this->_buckets.size(); ++bucket) {
+    count += this->_buckets[bucket];
+    if (count >= rank) {
+      if (bucket == 0U) {
+        return 0U;
+      }
+
+      /// The upper bound of the last bucket is the longest duration.
+      const auto upper_bound = bucket < 64U ? (std::uint64_t{ 1U } << bucket) - 1U : this->_max;
+      return std::min(upper_bound, this->_max);
+    }
+  }
+
+  return this->_max;
+}
+
+std::vector<perf::analyzer::SchedulingAnalyzer::Stack>
+perf::analyzer::SchedulingAnalyzer::Thread::off_cpu_stacks() const
+{
+  auto stacks = this->_stacks;
+  std::sort(stacks.begin(), stacks.end(), [](const auto& left, const auto& right) {
+    return left.off_cpu_time() > right.off_cpu_time();
+  });
+
+  return stacks;
+}
+
+void
+perf::analyzer::SchedulingAnalyzer::consume(const perf::Sample& sample)
+{
+  const auto thread_id = sample.thread_id();
+
+  /// The idle task (thread id 0) runs on every CPU whenever no other thread does; it is not analyzed.
+  if (!thread_id.has_value() || thread_id.value() == 0U) {
+    return;
+  }
+
+  const auto& context_switch = sample.context_switch();
+  if (!context_switch.has_value()) {
+    const auto& callchain = sample.callchain();
+    this->update_callchain(thread_id.value(),
+                           sample.process_id().value_or(0U),
+                           callchain.has_value() ? callchain->data() : nullptr,
+                           callchain.has_value() ? callchain->size() : 0U,
+                           sample.instruction_pointer());
+    return;
+  }
+
+  const auto time = sample.time();
+  if (!time.has_value()) {
+    return;
+  }
+  ++this->_count_context_switches;
+
+  auto& thread = this->_threads[thread_id.value()];
+  thread._thread_id = thread_id.value();
+  if (const auto process_id = sample.process_id(); process_id.has_value()) {
+    thread._process_id = process_id.value();
+  }
+
+  const auto last_time = thread._last_switch_time;
+  const auto duration =
+    last_time.has_value() && time.value() > last_time.value() ? time.value() - last_time.value() : 0U;
+
+  if (context_switch->is_out()) {
+    /// Running since the last switch-in.
+    if (thread._is_on_cpu && last_time.has_value()) {
+      thread._on_cpu.add(duration);
+    }
+
+    ++thread._count_switches;
+    thread._count_preemptions += static_cast<std::uint64_t>(context_switch->is_preempt());
+    thread._is_preempted = context_switch->is_preempt();
+    thread._is_on_cpu = false;
+  } else {
+    /// Off CPU since the last switch-out.
+    if (!thread._is_on_cpu && last_time.has_value()) {
+      if (thread._is_preempted) {
+        thread._runqueue.add(duration);
+      } else {
+        thread._blocked.add(duration);
+      }
+
+      if (thread._last_switch_cpu_id.has_value() && sample.cpu_id().has_value() &&
+          thread._last_switch_cpu_id.value() != sample.cpu_id().value()) {
+        ++thread._count_migrations;
+      }
+
+      if (duration > thread._longest_off_cpu_time) {
+        thread._longest_off_cpu_time = duration;
+        thread._longest_off_cpu_begin = last_time.value();
+        thread._longest_off_cpu_callchain = thread._callchain;
+      }
+
+      SchedulingAnalyzer::attribute(thread, duration);
+    }
+
+    thread._is_on_cpu = true;
+  }
+
+  thread._last_switch_time = time;
+  thread._last_switch_cpu_id = sample.cpu_id();
+}
+
+void
+perf::analyzer::SchedulingAnalyzer::consume(const perf::SampleView& sample)
+{
+  const auto thread_id = sample.thread_id();
+  if (!thread_id.has_value() || thread_id.value() == 0U) {
+    return;
+  }
+
+  const auto callchain = sample.callchain();
+  this->update_callchain(thread_id.value(),
+                         sample.process_id().value_or(0U),
+                         callchain.data(),
+                         callchain.size(),
+                         sample.instruction_pointer());
+}
+
+const perf::analyzer::SchedulingAnalyzer::Thread*
+perf::analyzer::SchedulingAnalyzer::thread(const std::uint32_t thread_id) const noexcept
+{
+  if (const auto iterator = this->_threads.find(thread_id); iterator != this->_threads.end()) {
+    return &iterator->second;
+  }
+
+  return nullptr;
+}
+
+std::vector<perf::analyzer::SchedulingAnalyzer::Thread>
+perf::analyzer::SchedulingAnalyzer::threads(const std::size_t count) const
+{
+  auto threads = std::vector<Thread>{};
+  threads.reserve(this->_threads.size());
+  for (const auto& [_, thread] : this->_threads) {
+    threads.push_back(thread);
+  }
+
+  const auto count_threads = std::min(count, threads.size());
+  std::partial_sort(threads.begin(),
+                    threads.begin() + std::int64_t(count_threads),
+                    threads.end(),
+                    [](const auto& left, const auto& right) {
+                      return left.off_cpu_time() > right.off_cpu_time() ||
+                             (left.off_cpu_time() == right.off_cpu_time() && left.thread_id() < right.thread_id());
+                    });
+  threads.erase(threads.begin() + std::int64_t(count_threads), threads.end());
+
+  return threads;
+}
+
+template<typename A>
+void
+perf::analyzer::SchedulingAnalyzer::update_callchain(const std::uint32_t thread_id,
+                                                     const std::uint32_t process_id,
+                                                     const A* callchain,
+                                                     const std::size_t size,
+                                                     const std::optional<std::uintptr_t> instruction_pointer)
+{
+  auto& thread = this->_threads[thread_id];
+  thread._thread_id = thread_id;
+  thread._process_id = process_id;
+
+  /// Only the most recent calls are kept; context markers (e.g., PERF_CONTEXT_USER) are skipped.
+  thread._callchain.clear();
+  for (auto index = std::size_t{ 0U }; index < size && thread._callchain.size() < MAX_CALLCHAIN_DEPTH; ++index) {
+    if (std::uint64_t(callchain[index]) < std::uint64_t(PERF_CONTEXT_MAX)) {
+      thread._callchain.push_back(std::uintptr_t(callchain[index]));
+    }
+  }
+
+  if (thread._callchain.empty() && instruction_pointer.has_value()) {
+    thread._callchain.push_back(instruction_pointer.value());
+  }
+
+  /// FNV-1a over the addresses.
+  auto hash = std::uint64_t{ 14695981039346656037ULL };
+  for (const auto address : thread._callchain) {
+    hash = (hash ^ address) * 1099511628211ULL;
+  }
+  thread._callchain_hash = hash;
+}
+
+void
+perf::analyzer::SchedulingAnalyzer::attribute(perf::analyzer::SchedulingAnalyzer::Thread& thread,
+                                              const std::uint64_t duration)
+{
+  if (thread._callchain.empty()) {
+    return;
+  }
+
+  auto& stacks = thread._stacks;
+  const auto iterator = std::find_if(stacks.begin(), stacks.end(), [&thread](const Stack& stack) {
+    return stack._hash == thread._callchain_hash && stack._callchain == thread._callchain;
+  });
+
+  if (iterator != stacks.end()) {
+    iterator->_off_cpu_time += duration;
+    ++iterator->_count;
+    return;
+  }
+
+  if (stacks.size() < MAX_STACKS_PER_THREAD) {
+    auto& stack = stacks.emplace_back();
+    stack._callchain = thread._callchain;
+    stack._hash = thread._callchain_hash;
+    stack._off_cpu_time = duration;
+    stack._count = 1U;
+    return;
+  }
+
+  /// Space-saving: The callchain with the least off-CPU time is replaced; the new callchain takes over its time.
+  auto& stack = *std::min_element(stacks.begin(), stacks.end(), [](const Stack& left, const Stack& right) {
+    return left._off_cpu_time < right._off_cpu_time;
+  });
+  stack._callchain = thread._callchain;
+  stack._hash = thread._callchain_hash;
+  stack._off_cpu_time += duration;
+  stack._count += 1U;
+}
+
+std::string
+perf::analyzer::SchedulingAnalyzer::to_string(const std::size_t count, perf::Symbolizer* symbolizer) const
+{
+  const auto milliseconds = [](const std::uint64_t nanoseconds) { return double(nanoseconds) / 1000000.0; };
+
+  auto stream = std::stringstream{};
+  stream << std::setw(10) << "thread" << std::setw(10) << "process" << std::setw(12) << "on-cpu ms" << std::setw(12)
+         << "off-cpu ms" << std::setw(12) << "runqueue ms" << std::setw(12) << "blocked ms" << std::setw(10)
+         << "switches" << std::setw(10) << "preempt" << std::setw(12) << "p99 off us" << std::setw(12) << "max off us"
+         << "   top off-cpu callchain\n";
+
+  for (const auto& thread : this->threads(count)) {
+    const auto p99_off_cpu = std::max(thread.runqueue().percentile(0.99), thread.blocked().percentile(0.99));
+
+    stream << std::setw(10) << thread.thread_id() << std::setw(10) << thread.process_id() << std::fixed
+           << std::setprecision(2) << std::setw(12) << milliseconds(thread.on_cpu_time()) << std::setw(12)
+           << milliseconds(thread.off_cpu_time()) << std::setw(12) << milliseconds(thread.runqueue().sum())
+           << std::setw(12) << milliseconds(thread.blocked().sum()) << std::setw(10) << thread.count_switches()
+           << std::setw(10) << thread.count_preemptions() << std::setw(12) << double(p99_off_cpu) / 1000.0
+           << std::setw(12) << double(thread.longest_off_cpu_time()) / 1000.0 << "   ";
+
+    const auto stacks = thread.off_cpu_stacks();
+    if (stacks.empty()) {
+      stream << "-";
+    } else {
+      const auto& callchain = stacks.front().callchain();
+      for (auto index = 0U; index < std::min<std::size_t>(callchain.size(), 4U); ++index) {
+        if (index > 0U) {
+          stream << " <- ";
+        }
+
+        auto is_resolved = false;
+        if (symbolizer != nullptr) {
+          if (const auto symbol = symbolizer->resolve(thread.process_id(), callchain[index]); symbol.has_value()) {
+            stream << symbol->demangled_name();
+            is_resolved = true;
+          }
+        }
+
+        if (!is_resolved) {
+          stream << "0x" << std::hex << callchain[index] << std::dec;
+        }
+      }
+    }
+    stream << "\n";
+  }
+
+  return stream.str();
+}
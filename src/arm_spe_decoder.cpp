@@ -0,0 +1,256 @@
+#include <algorithm>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <perfcpp/arm_spe_decoder.h>
+
+void
+perf::ArmSpeDecoder::feed(const std::uint8_t* data, const std::size_t size)
+{
+  auto position = std::size_t{ 0U };
+
+  /// Complete the packet that was split by the end of the last chunk.
+  while (!this->_pending_packet.empty() && position < size) {
+    this->_pending_packet.push_back(data[position++]);
+
+    const auto pending_size = ArmSpeDecoder::packet_size(this->_pending_packet.data(), this->_pending_packet.size());
+    if (pending_size.has_value() && pending_size.value() == this->_pending_packet.size()) {
+      this->decode(this->_pending_packet.data(), this->_pending_packet.size());
+      this->_pending_packet.clear();
+    }
+  }
+
+  while (position < size) {
+    const auto count_available = size - position;
+    const auto size_of_packet = ArmSpeDecoder::packet_size(data + position, count_available);
+
+    /// Keep packets that are not complete until the next chunk arrives.
+    if (!size_of_packet.has_value() || size_of_packet.value() > count_available) {
+      this->_pending_packet.assign(data + position, data + size);
+      return;
+    }
+
+    this->decode(data + position, size_of_packet.value());
+    position += size_of_packet.value();
+  }
+}
+
+std::optional<std::size_t>
+perf::ArmSpeDecoder::packet_size(const std::uint8_t* data, const std::size_t size) noexcept
+{
+  if (size == 0U) {
+    return std::nullopt;
+  }
+
+  const auto header = data[0U];
+  if (header == ArmSpeDecoder::PAD_HEADER || header == ArmSpeDecoder::END_HEADER) {
+    return 1U;
+  }
+
+  /// The payload size is encoded in bits 5:4 of the (last) header byte.
+  if ((header & 0xFCU) == ArmSpeDecoder::EXTENDED_HEADER) {
+    if (size < 2U) {
+      return std::nullopt;
+    }
+    return 2U + (1U << ((data[1U] >> 4U) & 0x3U));
+  }
+
+  return 1U + (1U << ((header >> 4U) & 0x3U));
+}
+
+void
+perf::ArmSpeDecoder::decode(const std::uint8_t* packet, const std::size_t size)
+{
+  auto header = packet[0U];
+  if (header == ArmSpeDecoder::PAD_HEADER) {
+    return;
+  }
+
+  if (header == ArmSpeDecoder::END_HEADER) {
+    this->finish_record();
+    return;
+  }
+
+  /// Extended headers widen the index of address and counter packets.
+  auto index = std::uint8_t{ 0U };
+  auto header_size = std::size_t{ 1U };
+  if ((header & 0xFCU) == ArmSpeDecoder::EXTENDED_HEADER) {
+    index = static_cast<std::uint8_t>((header & 0x3U) << 3U);
+    header = packet[1U];
+    header_size = 2U;
+  }
+  index |= static_cast<std::uint8_t>(header & 0x7U);
+
+  /// Payloads are little endian.
+  auto payload = std::uint64_t{ 0U };
+  std::memcpy(&payload, packet + header_size, std::min<std::size_t>(size - header_size, sizeof(payload)));
+
+  if (header == ArmSpeDecoder::TIMESTAMP_HEADER) {
+    this->_record.timestamp = payload;
+    this->finish_record();
+  } else if ((header & 0xCFU) == 0x42U) {
+    /// Events packet.
+    this->_record.events = payload;
+  } else if ((header & 0xCFU) == 0x43U) {
+    /// Data source packet.
+    this->_record.data_source = static_cast<std::uint16_t>(payload);
+  } else if ((header & 0xFCU) == 0x48U) {
+    /// Operation type packet; class 1 denotes loads, stores, and atomics (bit 0 of the payload is set for stores).
+    this->_record.is_load_store = (header & 0x3U) == 1U;
+    this->_record.is_store = this->_record.is_load_store && static_cast<bool>(payload & 0x1U);
+  } else if ((header & 0xF8U) == 0xB0U) {
+    /// Address packet: Addresses are stored in bits 55:0; instruction addresses carry the exception level in 62:61.
+    auto address = payload & 0x00FFFFFFFFFFFFFFULL;
+    if (index != 3U && static_cast<bool>(address & (1ULL << 55U))) {
+      address |= 0xFF00000000000000ULL;
+    }
+
+    if (index == 0U) {
+      this->_record.instruction_pointer = address;
+      switch ((payload >> 61U) & 0x3U) {
+        case 0U:
+          this->_record.mode = Sample::Mode::User;
+          break;
+        case 1U:
+          this->_record.mode = Sample::Mode::Kernel;
+          break;
+        case 2U:
+          this->_record.mode = Sample::Mode::Hypervisor;
+          break;
+        default:
+          this->_record.mode = Sample::Mode::Unknown;
+      }
+    } else if (index == 2U) {
+      this->_record.virtual_address = address;
+    } else if (index == 3U) {
+      this->_record.physical_address = address;
+    }
+  } else if ((header & 0xF8U) == 0x98U) {
+    /// Counter packet: Total latency (0), issue latency (1), and translation latency (2) in cycles.
+    const auto latency = static_cast<std::uint16_t>(payload);
+    if (index == 0U) {
+      this->_record.total_latency = latency;
+    } else if (index == 1U) {
+      this->_record.issue_latency = latency;
+    } else if (index == 2U) {
+      this->_record.translation_latency = latency;
+    }
+    this->_record.is_latency = true;
+  }
+}
+
+void
+perf::ArmSpeDecoder::finish_record()
+{
+  if (this->_record.instruction_pointer.has_value()) {
+    auto sample = Sample{ this->_record.mode };
+    sample.instruction_pointer(this->_record.instruction_pointer.value());
+
+    if (this->_record.virtual_address.has_value()) {
+      sample.logical_memory_address(this->_record.virtual_address.value());
+    }
+
+    if (this->_record.physical_address.has_value()) {
+      sample.physical_memory_address(this->_record.physical_address.value());
+    }
+
+    if (this->_record.is_latency) {
+      sample.weight(
+        Weight{ this->_record.total_latency, this->_record.issue_latency, this->_record.translation_latency });
+    }
+
+    if (this->_record.is_load_store) {
+      sample.data_src(ArmSpeDecoder::data_source(this->_record));
+    }
+
+    /// Timestamps are ticks of the generic timer.
+    if (this->_record.timestamp.has_value()) {
+      sample.timestamp(this->_record.timestamp.value());
+    }
+
+    this->_samples.push_back(std::move(sample));
+  }
+
+  this->_record = Record{};
+}
+
+perf::DataSource
+perf::ArmSpeDecoder::data_source(const Record& record) noexcept
+{
+  auto data_source = perf_mem_data_src{};
+  data_source.val = 0U;
+  data_source.mem_op = record.is_store ? PERF_MEM_OP_STORE : PERF_MEM_OP_LOAD;
+
+  /// Events: L1D access (bit 2), L1D refill (3), TLB access (4), TLB walk (5), LLC access (8), LLC miss (9), and
+  /// remote access (10).
+  const auto is_event = [events = record.events](const std::uint8_t bit) {
+    return static_cast<bool>(events & (1ULL << bit));
+  };
+
+  if (is_event(5U)) {
+    data_source.mem_dtlb = PERF_MEM_TLB_WK | PERF_MEM_TLB_MISS;
+  } else if (is_event(4U)) {
+    data_source.mem_dtlb = PERF_MEM_TLB_L1 | PERF_MEM_TLB_HIT;
+  }
+
+  if (record.data_source.has_value()) {
+    /// Data sources as implemented by Neoverse cores.
+    switch (record.data_source.value()) {
+      case 0U:
+        data_source.mem_lvl = PERF_MEM_LVL_L1 | PERF_MEM_LVL_HIT;
+        data_source.mem_lvl_num = PERF_MEM_LVLNUM_L1;
+        break;
+      case 8U:
+        data_source.mem_lvl = PERF_MEM_LVL_L2 | PERF_MEM_LVL_HIT;
+        data_source.mem_lvl_num = PERF_MEM_LVLNUM_L2;
+        break;
+      case 9U:
+        /// Peer core: Snooped from the private cache of another core.
+        data_source.mem_lvl = PERF_MEM_LVL_L2 | PERF_MEM_LVL_HIT;
+        data_source.mem_lvl_num = PERF_MEM_LVLNUM_L2;
+        data_source.mem_snoop = PERF_MEM_SNOOP_HITM;
+        break;
+      case 10U:
+      case 11U:
+        /// Local cluster or system cache.
+        data_source.mem_lvl = PERF_MEM_LVL_L3 | PERF_MEM_LVL_HIT;
+        data_source.mem_lvl_num = PERF_MEM_LVLNUM_L3;
+        break;
+      case 12U:
+        /// Peer cluster.
+        data_source.mem_lvl = PERF_MEM_LVL_L3 | PERF_MEM_LVL_HIT;
+        data_source.mem_lvl_num = PERF_MEM_LVLNUM_L3;
+        data_source.mem_snoop = PERF_MEM_SNOOP_HITM;
+        break;
+      case 13U:
+        /// Remote chip.
+        data_source.mem_lvl = PERF_MEM_LVL_REM_CCE1;
+        data_source.mem_lvl_num = PERF_MEM_LVLNUM_ANY_CACHE;
+        data_source.mem_remote = PERF_MEM_REMOTE_REMOTE;
+        break;
+      case 14U:
+        data_source.mem_lvl = PERF_MEM_LVL_LOC_RAM | PERF_MEM_LVL_HIT;
+        data_source.mem_lvl_num = PERF_MEM_LVLNUM_RAM;
+        break;
+      default:
+        data_source.mem_lvl = PERF_MEM_LVL_NA;
+    }
+  } else if (is_event(2U) && !is_event(3U)) {
+    /// Without a data source packet, derive the level from the cache events.
+    data_source.mem_lvl = PERF_MEM_LVL_L1 | PERF_MEM_LVL_HIT;
+    data_source.mem_lvl_num = PERF_MEM_LVLNUM_L1;
+  } else if (is_event(8U) && !is_event(9U)) {
+    data_source.mem_lvl = PERF_MEM_LVL_L3 | PERF_MEM_LVL_HIT;
+    data_source.mem_lvl_num = PERF_MEM_LVLNUM_L3;
+  } else if (is_event(9U)) {
+    data_source.mem_lvl = PERF_MEM_LVL_L3 | PERF_MEM_LVL_MISS;
+    data_source.mem_lvl_num = PERF_MEM_LVLNUM_RAM;
+  } else {
+    data_source.mem_lvl = PERF_MEM_LVL_NA;
+  }
+
+  if (is_event(10U)) {
+    data_source.mem_remote = PERF_MEM_REMOTE_REMOTE;
+  }
+
+  return DataSource{ data_source.val };
+}
@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <perfcpp/benchmark.h>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+perf::Benchmark::CpuPinning::CpuPinning(const std::optional<std::uint16_t> cpu_id)
+{
+  if (!cpu_id.has_value()) {
+    return;
+  }
+
+  auto previous_affinity = cpu_set_t{};
+  CPU_ZERO(&previous_affinity);
+  if (::sched_getaffinity(0, sizeof(cpu_set_t), &previous_affinity) != 0) {
+    throw std::runtime_error{ "Cannot pin benchmark: Reading the CPU affinity failed." };
+  }
+
+  auto affinity = cpu_set_t{};
+  CPU_ZERO(&affinity);
+  CPU_SET(cpu_id.value(), &affinity);
+  if (::sched_setaffinity(0, sizeof(cpu_set_t), &affinity) != 0) {
+    throw std::runtime_error{ std::string{ "Cannot pin benchmark: CPU " }
+                                .append(std::to_string(cpu_id.value()))
+                                .append(" is not available.") };
+  }
+
+  this->_previous_affinity = previous_affinity;
+}
+
+perf::Benchmark::CpuPinning::~CpuPinning()
+{
+  if (this->_previous_affinity.has_value()) {
+    ::sched_setaffinity(0, sizeof(cpu_set_t), &this->_previous_affinity.value());
+  }
+}
+
+perf::BenchmarkResult::BenchmarkResult(std::vector<CounterResult>&& repetitions, const double outlier_threshold)
+  : _repetitions(std::move(repetitions))
+{
+  if (this->_repetitions.empty()) {
+    return;
+  }
+
+  /// All repetitions list the same counters and metrics in the same order.
+  auto values = std::vector<double>{};
+  values.reserve(this->_repetitions.size());
+
+  auto counter_id = std::size_t{ 0U };
+  for (const auto& [name, _] : this->_repetitions.front()) {
+    values.clear();
+    for (const auto& repetition : this->_repetitions) {
+      values.push_back(std::next(repetition.begin(), std::int64_t(counter_id))->second);
+    }
+
+    this->_statistics.emplace_back(name, BenchmarkResult::compute(values, outlier_threshold));
+    ++counter_id;
+  }
+}
+
+perf::BenchmarkResult::Statistics
+perf::BenchmarkResult::compute(std::vector<double>& values, const double outlier_threshold)
+{
+  std::sort(values.begin(), values.end());
+
+  /// Reject values outside Tukey's fences.
+  const auto count_values = values.size();
+  if (outlier_threshold > .0 && values.size() >= 4U) {
+    const auto first_quartile = BenchmarkResult::quantile(values, .25);
+    const auto third_quartile = BenchmarkResult::quantile(values, .75);
+    const auto fence = outlier_threshold * (third_quartile - first_quartile);
+
+    const auto begin = std::lower_bound(values.begin(), values.end(), first_quartile - fence);
+    const auto end = std::upper_bound(begin, values.end(), third_quartile + fence);
+    values = std::vector<double>{ begin, end };
+  }
+
+  auto statistics = Statistics{};
+  statistics.outliers = double(count_values - values.size());
+  statistics.min = values.front();
+  statistics.max = values.back();
+  statistics.median = BenchmarkResult::quantile(values, .5);
+  statistics.mean = std::accumulate(values.begin(), values.end(), .0) / double(values.size());
+
+  if (values.size() > 1U) {
+    auto sum_of_squares = .0;
+    for (const auto value : values) {
+      sum_of_squares += (value - statistics.mean) * (value - statistics.mean);
+    }
+    statistics.variance = sum_of_squares / double(values.size() - 1U);
+  } else {
+    statistics.variance = .0;
+  }
+  statistics.standard_deviation = std::sqrt(statistics.variance);
+
+  const auto margin = values.size() > 1U ? BenchmarkResult::t_quantile(values.size() - 1U) *
+                                             statistics.standard_deviation / std::sqrt(double(values.size()))
+                                         : .0;
+  statistics.confidence_interval_lower = statistics.mean - margin;
+  statistics.confidence_interval_upper = statistics.mean + margin;
+
+  return statistics;
+}
+
+double
+perf::BenchmarkResult::quantile(const std::vector<double>& sorted_values, const double quantile) noexcept
+{
+  const auto position = quantile * double(sorted_values.size() - 1U);
+  const auto lower = std::size_t(std::floor(position));
+  const auto upper = std::min(lower + 1U, sorted_values.size() - 1U);
+
+  return sorted_values[lower] + (position - double(lower)) * (sorted_values[upper] - sorted_values[lower]);
+}
+
+double
+perf::BenchmarkResult::t_quantile(const std::size_t degrees_of_freedom) noexcept
+{
+  constexpr auto quantiles = std::array<double, 30U>{ 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306,
+                                                      2.262,  2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120,
+                                                      2.110,  2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064,
+                                                      2.060,  2.056, 2.052, 2.048, 2.045, 2.042 };
+
+  if (degrees_of_freedom <= quantiles.size()) {
+    return quantiles[degrees_of_freedom - 1U];
+  }
+
+  /// Beyond the table, use the quantile of the next smaller tabulated degree of freedom (slightly conservative).
+  if (degrees_of_freedom < 40U) {
+    return 2.042;
+  }
+  if (degrees_of_freedom < 60U) {
+    return 2.021;
+  }
+  if (degrees_of_freedom < 120U) {
+    return 2.000;
+  }
+
+  return 1.980;
+}
+
+perf::CounterResult
+perf::BenchmarkResult::statistic(double Statistics::* member) const
+{
+  auto results = std::vector<std::pair<std::string_view, double>>{};
+  results.reserve(this->_statistics.size());
+
+  for (const auto& [name, statistics] : this->_statistics) {
+    results.emplace_back(name, statistics.*member);
+  }
+
+  return CounterResult{ std::move(results) };
+}
+
+std::vector<std::pair<std::string_view, perf::CounterResult>>
+perf::BenchmarkResult::statistics() const
+{
+  return { { "mean", this->mean() },
+           { "median", this->median() },
+           { "min", this->min() },
+           { "max", this->max() },
+           { "variance", this->variance() },
+           { "standard_deviation", this->standard_deviation() },
+           { "confidence_interval_lower", this->confidence_interval_lower() },
+           { "confidence_interval_upper", this->confidence_interval_upper() },
+           { "outliers", this->outliers() } };
+}
+
+std::string
+perf::BenchmarkResult::to_json() const
+{
+  auto json_stream = std::stringstream{};
+
+  json_stream << "{\"repetitions\": " << this->_repetitions.size();
+  for (const auto& [name, result] : this->statistics()) {
+    json_stream << ",\"" << name << "\": " << result.to_json();
+  }
+  json_stream << "}";
+
+  return json_stream.str();
+}
+
+std::string
+perf::BenchmarkResult::to_csv(const char delimiter, const bool print_header) const
+{
+  auto csv_stream = std::stringstream{};
+
+  if (print_header) {
+    csv_stream << "statistic" << delimiter << "counter" << delimiter << "value";
+  }
+
+  auto is_first_row = !print_header;
+  for (const auto& [name, result] : this->statistics()) {
+    /// Prefix every row of the statistic's CSV with the name of the statistic.
+    auto rows = std::stringstream{ result.to_csv(delimiter, false) };
+    for (auto row = std::string{}; std::getline(rows, row);) {
+      if (!std::exchange(is_first_row, false)) {
+        csv_stream << "\n";
+      }
+      csv_stream << name << delimiter << row;
+    }
+  }
+
+  return csv_stream.str();
+}
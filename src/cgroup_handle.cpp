@@ -0,0 +1,58 @@
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <perfcpp/cgroup_handle.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+perf::CGroupHandle::CGroupHandle(std::string path)
+  : _path(std::move(path))
+{
+  if (this->_path.empty() || this->_path.front() != '/') {
+    this->_path = std::string{ MOUNT_POINT }.append("/").append(this->_path);
+  }
+
+  this->_file_descriptor = ::open(this->_path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (this->_file_descriptor < 0) {
+    throw std::runtime_error{ std::string{ "Cannot open cgroup '" }.append(this->_path).append("': ").append(
+      std::strerror(errno)) };
+  }
+
+  struct stat cgroup_stat
+  {};
+  if (::fstat(this->_file_descriptor, &cgroup_stat) == 0) {
+    this->_id = std::uint64_t(cgroup_stat.st_ino);
+  }
+}
+
+perf::CGroupHandle::CGroupHandle(CGroupHandle&& other) noexcept
+  : _path(std::move(other._path))
+  , _file_descriptor(std::exchange(other._file_descriptor, -1))
+  , _id(other._id)
+{
+}
+
+perf::CGroupHandle::~CGroupHandle()
+{
+  if (this->_file_descriptor > -1) {
+    ::close(this->_file_descriptor);
+  }
+}
+
+perf::CGroupHandle&
+perf::CGroupHandle::operator=(CGroupHandle&& other) noexcept
+{
+  if (this != &other) {
+    if (this->_file_descriptor > -1) {
+      ::close(this->_file_descriptor);
+    }
+
+    this->_path = std::move(other._path);
+    this->_file_descriptor = std::exchange(other._file_descriptor, -1);
+    this->_id = other._id;
+  }
+
+  return *this;
+}
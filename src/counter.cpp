@@ -7,6 +7,7 @@
 #include <perfcpp/feature.h>
 #include <sstream>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <sys/syscall.h>
 #include <unistd.h>
 #include <utility>
@@ -14,10 +15,28 @@
 std::optional<double>
 perf::CounterResult::get(std::string_view name) const noexcept
 {
+  if (const auto index = this->index(name); index.has_value()) {
+    return this->_results[index.value()].second;
+  }
+
+  return std::nullopt;
+}
+
+std::optional<std::size_t>
+perf::CounterResult::index(const std::string_view name) const noexcept
+{
+  /// Names of results are interned by the CounterDefinition: Names handed out by the definition (e.g., from an
+  /// EventCounter's events) are found by comparing the pointer, without comparing the characters.
+  for (auto i = 0U; i < this->_results.size(); ++i) {
+    if (this->_results[i].first.data() == name.data() && this->_results[i].first.size() == name.size()) {
+      return i;
+    }
+  }
+
   if (auto iterator = std::find_if(
-        this->_results.begin(), this->_results.end(), [&name](const auto res) { return name == res.first; });
+        this->_results.begin(), this->_results.end(), [&name](const auto& res) { return name == res.first; });
       iterator != this->_results.end()) {
-    return iterator->second;
+    return std::size_t(std::distance(this->_results.begin(), iterator));
   }
 
   return std::nullopt;
@@ -111,6 +130,7 @@ perf::Counter::open(const bool is_print_debug,
                     const std::int64_t group_leader_file_descriptor,
                     const std::optional<std::uint16_t> cpu_id,
                     const pid_t process_id,
+                    const std::optional<std::int32_t> cgroup_file_descriptor,
                     const bool is_inherit,
                     const bool is_include_kernel,
                     const bool is_include_user,
@@ -123,8 +143,13 @@ perf::Counter::open(const bool is_print_debug,
                     const std::optional<std::uint64_t> user_registers,
                     const std::optional<std::uint64_t> kernel_registers,
                     const std::optional<std::uint16_t> max_callstack,
+                    const bool is_exclude_callchain_kernel,
+                    const bool is_exclude_callchain_user,
                     const bool is_include_context_switch,
-                    const bool is_include_cgroup)
+                    const bool is_include_cgroup,
+                    const bool is_include_mmap,
+                    const std::optional<std::uint32_t> wakeup_events,
+                    const std::optional<std::uint32_t> wakeup_watermark)
 {
   std::memset(&this->_event_attribute, 0, sizeof(perf_event_attr));
   this->_event_attribute.type = this->_config.type();
@@ -161,6 +186,9 @@ perf::Counter::open(const bool is_print_debug,
       }
 #endif
 
+      this->_event_attribute.exclude_callchain_kernel = is_exclude_callchain_kernel;
+      this->_event_attribute.exclude_callchain_user = is_exclude_callchain_user;
+
       if (user_registers.has_value()) {
         this->_event_attribute.sample_regs_user = user_registers.value();
       }
@@ -176,6 +204,18 @@ perf::Counter::open(const bool is_print_debug,
 #ifndef PERFCPP_NO_RECORD_CGROUP
       this->_event_attribute.cgroup = is_include_cgroup;
 #endif
+
+      /// Memory mappings are recorded as MMAP2 records (including the protection of the mapping).
+      this->_event_attribute.mmap = is_include_mmap;
+      this->_event_attribute.mmap2 = is_include_mmap;
+
+      /// Set when the perf subsystem signals that the buffer can be read (e.g., via poll).
+      if (wakeup_watermark.has_value()) {
+        this->_event_attribute.watermark = 1U;
+        this->_event_attribute.wakeup_watermark = wakeup_watermark.value();
+      } else if (wakeup_events.has_value()) {
+        this->_event_attribute.wakeup_events = wakeup_events.value();
+      }
     }
   }
 
@@ -193,6 +233,15 @@ perf::Counter::open(const bool is_print_debug,
   /// integer for that case).
   const std::int32_t real_cpu_id = cpu_id.has_value() ? std::int32_t{ cpu_id.value() } : -1;
 
+  /// When monitoring a cgroup, the kernel expects the file descriptor of the cgroup instead of a process id. Cgroups
+  /// can only be monitored per CPU.
+  if (cgroup_file_descriptor.has_value() && !cpu_id.has_value()) {
+    throw std::runtime_error{ "Cannot open counter: Monitoring a cgroup requires a specific CPU." };
+  }
+  const auto real_process_id =
+    cgroup_file_descriptor.has_value() ? pid_t{ cgroup_file_descriptor.value() } : process_id;
+  const auto flags = cgroup_file_descriptor.has_value() ? std::uint64_t{ PERF_FLAG_PID_CGROUP } : std::uint64_t{ 0U };
+
   if (sample_type.has_value()) {
     /// For sampling, we try to adjust the precision (precise_ip) if we cannot successfully open the counter with the
     /// provided value.
@@ -203,7 +252,7 @@ perf::Counter::open(const bool is_print_debug,
 
       /// Try to open using the perf subsystem.
       this->_file_descriptor =
-        this->perf_event_open(process_id, real_cpu_id, is_group_leader, group_leader_file_descriptor);
+        this->perf_event_open(real_process_id, real_cpu_id, is_group_leader, group_leader_file_descriptor, flags);
 
       /// If opening the file descriptor not successful or the error indicates that adjusting (decreasing) the precision
       /// does not help, we are done.
@@ -215,7 +264,7 @@ perf::Counter::open(const bool is_print_debug,
     /// For monitoring statistics over time (not sampling), we do not need to adjust the precision; a single try is
     /// enough.
     this->_file_descriptor =
-      this->perf_event_open(process_id, real_cpu_id, is_group_leader, group_leader_file_descriptor);
+      this->perf_event_open(real_process_id, real_cpu_id, is_group_leader, group_leader_file_descriptor, flags);
   }
 
   /// Read and set the counter's id.
@@ -226,7 +275,14 @@ perf::Counter::open(const bool is_print_debug,
 
   /// Print debug output, if requested.
   if (is_print_debug) {
-    std::cout << this->to_string(is_group_leader, group_leader_file_descriptor, process_id, real_cpu_id) << std::flush;
+    std::cout << this->to_string(is_group_leader,
+                                 group_leader_file_descriptor,
+                                 cgroup_file_descriptor.has_value() ? std::nullopt : std::make_optional(process_id),
+                                 real_cpu_id);
+    if (cgroup_file_descriptor.has_value()) {
+      std::cout << "    cgroup: file descriptor " << cgroup_file_descriptor.value() << "\n";
+    }
+    std::cout << std::flush;
   }
 
   if (this->_file_descriptor < 0LL) {
@@ -236,9 +292,113 @@ perf::Counter::open(const bool is_print_debug,
   }
 }
 
+bool
+perf::Counter::map_user_level_page()
+{
+  if (this->_file_descriptor < 0LL) {
+    return false;
+  }
+
+  if (this->_user_level_page == nullptr) {
+    auto* page = ::mmap(nullptr,
+                        std::size_t(::getpagesize()),
+                        PROT_READ,
+                        MAP_SHARED,
+                        static_cast<std::int32_t>(this->_file_descriptor),
+                        0);
+    if (page == MAP_FAILED) {
+      return false;
+    }
+
+    this->_user_level_page = reinterpret_cast<perf_event_mmap_page*>(page);
+  }
+
+  return true;
+}
+
+bool
+perf::Counter::read_user_level(CounterReadFormat<1U>& value) const noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+  if (this->_user_level_page == nullptr) {
+    return false;
+  }
+
+  /// The page is updated by the kernel whenever the counter is scheduled; the lock acts as a sequence lock.
+  const volatile auto* page = this->_user_level_page;
+
+  auto sequence = std::uint32_t{ 0U };
+  auto index = std::uint32_t{ 0U };
+  auto count = std::int64_t{ 0 };
+  auto time_enabled = std::uint64_t{ 0U };
+  auto time_running = std::uint64_t{ 0U };
+
+  do {
+    sequence = page->lock;
+    asm volatile("" ::: "memory");
+
+    /// Reading via rdpmc (and calculating the time since the last update) needs to be supported by the hardware.
+    if (!page->cap_user_rdpmc || !page->cap_user_time) {
+      return false;
+    }
+
+    /// An index of zero indicates that the counter is currently not scheduled on the PMU.
+    index = page->index;
+    if (index == 0U) {
+      return false;
+    }
+
+    time_enabled = page->time_enabled;
+    time_running = page->time_running;
+
+    /// Calculate the time since the enabled and running times were updated by the kernel.
+    auto cycles = Counter::rdtsc();
+    const auto time_offset = page->time_offset;
+    const auto time_multiplier = std::uint64_t{ page->time_mult };
+    const auto time_shift = std::uint16_t{ page->time_shift };
+#ifndef PERFCPP_NO_USER_TIME_SHORT
+    if (page->cap_user_time_short) {
+      cycles = page->time_cycles + ((cycles - page->time_cycles) & page->time_mask);
+    }
+#endif
+
+    const auto quotient = cycles >> time_shift;
+    const auto remainder = cycles & ((std::uint64_t{ 1U } << time_shift) - 1U);
+    const auto delta = time_offset + quotient * time_multiplier + ((remainder * time_multiplier) >> time_shift);
+    time_enabled += delta;
+    time_running += delta;
+
+    /// The hardware counter holds only pmc_width bits; the value needs to be sign-extended.
+    const auto width = std::uint16_t{ page->pmc_width };
+    auto pmc = static_cast<std::int64_t>(Counter::rdpmc(index - 1U));
+    pmc <<= 64U - width;
+    pmc >>= 64U - width;
+
+    count = page->offset + pmc;
+
+    asm volatile("" ::: "memory");
+  } while (page->lock != sequence);
+
+  value.count_members = 1U;
+  value.time_enabled = time_enabled;
+  value.time_running = time_running;
+  value.values[0U].value = static_cast<std::uint64_t>(count);
+  value.values[0U].id = this->_id;
+
+  return true;
+#else
+  static_cast<void>(value);
+  return false;
+#endif
+}
+
 void
 perf::Counter::close()
 {
+  if (auto* page = std::exchange(this->_user_level_page, nullptr); page != nullptr) {
+    ::munmap(page, std::size_t(::getpagesize()));
+  }
+
   if (const auto file_descriptor = std::exchange(_file_descriptor, -1LL); file_descriptor > -1LL) {
     ::close(static_cast<std::int32_t>(file_descriptor));
   }
@@ -248,14 +408,15 @@ std::int64_t
 perf::Counter::perf_event_open(pid_t process_id,
                                std::int32_t cpu_id,
                                bool is_group_leader,
-                               std::int64_t group_leader_file_descriptor)
+                               std::int64_t group_leader_file_descriptor,
+                               std::uint64_t flags)
 {
   return ::syscall(__NR_perf_event_open,
                    &this->_event_attribute,
                    process_id,
                    cpu_id,
                    is_group_leader ? -1LL : group_leader_file_descriptor,
-                   0);
+                   flags);
 }
 
 std::string
@@ -392,6 +553,12 @@ perf::Counter::to_string(const std::optional<bool> is_group_leader,
     stream << "        mmap: " << this->_event_attribute.mmap << "\n";
   }
 
+  if (this->_event_attribute.watermark > 0U) {
+    stream << "        wakeup_watermark: " << this->_event_attribute.wakeup_watermark << "\n";
+  } else if (this->_event_attribute.wakeup_events > 0U) {
+    stream << "        wakeup_events: " << this->_event_attribute.wakeup_events << "\n";
+  }
+
   if (this->_event_attribute.sample_id_all > 0U) {
     stream << "        sample_id_all: " << this->_event_attribute.sample_id_all << "\n";
   }
@@ -461,8 +628,15 @@ perf::Counter::to_string(const std::optional<bool> is_group_leader,
                                                        is_print_delimiter);
     is_print_delimiter = Counter::print_type_to_stream(
       stream, this->_event_attribute.branch_sample_type, PERF_SAMPLE_BRANCH_IN_TX, "BRANCH_IN_TX", is_print_delimiter);
-    Counter::print_type_to_stream(
+    is_print_delimiter = Counter::print_type_to_stream(
       stream, this->_event_attribute.branch_sample_type, PERF_SAMPLE_BRANCH_NO_TX, "BRANCH_NO_TX", is_print_delimiter);
+#ifndef PERFCPP_NO_SAMPLE_BRANCH_TYPE
+    Counter::print_type_to_stream(stream,
+                                  this->_event_attribute.branch_sample_type,
+                                  PERF_SAMPLE_BRANCH_TYPE_SAVE,
+                                  "BRANCH_TYPE_SAVE",
+                                  is_print_delimiter);
+#endif
 
     stream << "\n";
   }
@@ -506,12 +680,21 @@ perf::Counter::to_string(const std::optional<bool> is_group_leader,
   if (this->_event_attribute.exclude_guest > 0U) {
     stream << "        exclude_guest: " << this->_event_attribute.exclude_guest << "\n";
   }
+  if (this->_event_attribute.exclude_callchain_kernel > 0U) {
+    stream << "        exclude_callchain_kernel: " << this->_event_attribute.exclude_callchain_kernel << "\n";
+  }
+  if (this->_event_attribute.exclude_callchain_user > 0U) {
+    stream << "        exclude_callchain_user: " << this->_event_attribute.exclude_callchain_user << "\n";
+  }
   if (this->_event_attribute.context_switch > 0U) {
     stream << "        context_switch: " << this->_event_attribute.context_switch << "\n";
   }
   if (this->_event_attribute.cgroup > 0U) {
     stream << "        cgroup: " << this->_event_attribute.cgroup << "\n";
   }
+  if (this->_event_attribute.mmap2 > 0U) {
+    stream << "        mmap2: " << this->_event_attribute.mmap2 << "\n";
+  }
 
   return stream.str();
 }
@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <perfcpp/counter_cache.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+perf::CounterCache::CounterCache(const std::string& file_name)
+{
+  const auto file_descriptor = ::open(file_name.c_str(), O_RDONLY | O_CLOEXEC);
+  if (file_descriptor < 0) {
+    throw std::runtime_error{ std::string{ "Cannot open counter cache '" }.append(file_name).append("': ").append(
+      std::strerror(errno)) };
+  }
+
+  struct stat file_stat
+  {};
+  if (::fstat(file_descriptor, &file_stat) != 0 || std::size_t(file_stat.st_size) < sizeof(CounterCacheFile::Header)) {
+    ::close(file_descriptor);
+    throw std::runtime_error{ std::string{ "Counter cache '" }.append(file_name).append("' is invalid.") };
+  }
+
+  this->_size = std::size_t(file_stat.st_size);
+  auto* data = ::mmap(nullptr, this->_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+  ::close(file_descriptor);
+
+  if (data == MAP_FAILED) {
+    throw std::runtime_error{ std::string{ "Cannot map counter cache '" }.append(file_name).append("': ").append(
+      std::strerror(errno)) };
+  }
+  this->_data = reinterpret_cast<const std::uint8_t*>(data);
+
+  /// Read the header.
+  const auto* header = reinterpret_cast<const CounterCacheFile::Header*>(this->_data);
+  if (header->magic != CounterCacheFile::MAGIC || header->version != CounterCacheFile::VERSION) {
+    ::munmap(data, this->_size);
+    throw std::runtime_error{
+      std::string{ "Counter cache '" }.append(file_name).append("' has an unsupported format.")
+    };
+  }
+
+  const auto entries_size = std::size_t{ header->count_counters } * sizeof(CounterCacheFile::Entry);
+  if (sizeof(CounterCacheFile::Header) + entries_size + header->names_size > this->_size) {
+    ::munmap(data, this->_size);
+    throw std::runtime_error{ std::string{ "Counter cache '" }.append(file_name).append("' is truncated.") };
+  }
+
+  this->_entries = reinterpret_cast<const CounterCacheFile::Entry*>(this->_data + sizeof(CounterCacheFile::Header));
+  this->_count_counters = header->count_counters;
+  this->_names = reinterpret_cast<const char*>(this->_data + sizeof(CounterCacheFile::Header) + entries_size);
+
+  /// Verify that all names are within the name table; the names are not copied.
+  const auto is_valid = std::all_of(
+    this->_entries, this->_entries + this->_count_counters, [names_size = header->names_size](const auto& entry) {
+      return std::uint64_t{ entry.name_offset } + entry.name_length <= names_size;
+    });
+  if (!is_valid) {
+    ::munmap(data, this->_size);
+    throw std::runtime_error{ std::string{ "Counter cache '" }.append(file_name).append("' is invalid.") };
+  }
+}
+
+perf::CounterCache::~CounterCache()
+{
+  if (this->_data != nullptr) {
+    ::munmap(const_cast<std::uint8_t*>(this->_data), this->_size);
+  }
+}
+
+void
+perf::CounterCache::write(const std::string& file_name,
+                          std::vector<std::pair<std::string_view, CounterConfig>>&& counters)
+{
+  /// Sort the counters by name (keeping the first of multiple counters with the same name) to allow binary search.
+  std::stable_sort(counters.begin(), counters.end(), [](const auto& left, const auto& right) {
+    return std::get<0>(left) < std::get<0>(right);
+  });
+  const auto is_same_name = [](const auto& left, const auto& right) { return std::get<0>(left) == std::get<0>(right); };
+  counters.erase(std::unique(counters.begin(), counters.end(), is_same_name), counters.end());
+
+  auto entries = std::vector<CounterCacheFile::Entry>{};
+  entries.reserve(counters.size());
+  auto names = std::string{};
+  for (const auto& [name, config] : counters) {
+    const auto event_id_extension = config.event_id_extension();
+    entries.push_back(CounterCacheFile::Entry{ std::uint32_t(names.size()),
+                                               std::uint32_t(name.size()),
+                                               config.type(),
+                                               0U,
+                                               config.event_id(),
+                                               event_id_extension[0U],
+                                               event_id_extension[1U] });
+    names.append(name);
+  }
+
+  const auto header =
+    CounterCacheFile::Header{ CounterCacheFile::MAGIC, CounterCacheFile::VERSION, std::uint32_t(entries.size()),
+                              std::uint64_t(names.size()) };
+
+  auto output_file = std::ofstream{ file_name, std::ios::binary | std::ios::trunc };
+  if (!output_file.is_open()) {
+    throw std::runtime_error{ std::string{ "Cannot open counter cache '" }.append(file_name).append("'.") };
+  }
+
+  output_file.write(reinterpret_cast<const char*>(&header), sizeof(CounterCacheFile::Header));
+  output_file.write(reinterpret_cast<const char*>(entries.data()),
+                    std::streamsize(entries.size() * sizeof(CounterCacheFile::Entry)));
+  output_file.write(names.data(), std::streamsize(names.size()));
+
+  if (!output_file.good()) {
+    throw std::runtime_error{ std::string{ "Cannot write counter cache '" }.append(file_name).append("'.") };
+  }
+}
+
+bool
+perf::CounterCache::is_cache(const std::string& file_name)
+{
+  auto input_file = std::ifstream{ file_name, std::ios::binary };
+  auto magic = std::uint64_t{ 0U };
+
+  return input_file.read(reinterpret_cast<char*>(&magic), sizeof(magic)) && magic == CounterCacheFile::MAGIC;
+}
+
+std::optional<std::pair<std::string_view, perf::CounterConfig>>
+perf::CounterCache::counter(const std::string_view name) const noexcept
+{
+  const auto* end = this->_entries + this->_count_counters;
+  const auto* entry =
+    std::lower_bound(this->_entries, end, name, [this](const auto& entry, const std::string_view counter_name) {
+      return this->name(entry) < counter_name;
+    });
+
+  if (entry != end && this->name(*entry) == name) {
+    return std::make_optional(std::make_pair(
+      this->name(*entry),
+      CounterConfig{ entry->type, entry->event_id, entry->event_id_extension_1, entry->event_id_extension_2 }));
+  }
+
+  return std::nullopt;
+}
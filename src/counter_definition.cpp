@@ -1,4 +1,5 @@
 #include <fstream>
+#include <iterator>
 #include <perfcpp/counter_definition.h>
 #include <perfcpp/feature.h>
 #include <perfcpp/hardware_info.h>
@@ -11,33 +12,96 @@ perf::CounterDefinition::CounterDefinition()
   this->initialize_generalized_counters();
   this->initialize_amd_ibs_counters();
   this->initialize_intel_pebs_counters();
+  this->initialize_aux_counters();
+  this->initialize_topdown_metrics();
 }
 
 perf::CounterDefinition::CounterDefinition(const std::string& config_file) : CounterDefinition()
 {
-  this->read_counter_configuration(config_file);
+  if (CounterCache::is_cache(config_file)) {
+    this->read_counter_cache(config_file);
+  } else {
+    this->read_counter_configuration(config_file);
+  }
 }
 
 std::optional<std::pair<std::string_view, perf::CounterConfig>>
-perf::CounterDefinition::counter(const std::string& name) const noexcept
+perf::CounterDefinition::counter(const std::string_view name) const noexcept
 {
   if (auto iterator = this->_counter_configs.find(name); iterator != this->_counter_configs.end()) {
-    return std::make_optional(std::make_pair(std::string_view(iterator->first), iterator->second));
+    return std::make_optional(std::make_pair(iterator->first, iterator->second));
+  }
+
+  for (const auto& cache : this->_counter_caches) {
+    if (auto counter = cache->counter(name); counter.has_value()) {
+      return counter;
+    }
   }
 
   return std::nullopt;
 }
 
 std::optional<std::pair<std::string_view, perf::Metric&>>
-perf::CounterDefinition::metric(const std::string& name) const noexcept
+perf::CounterDefinition::metric(const std::string_view name) const noexcept
 {
-  if (auto iterator = _metrics.find(name); iterator != _metrics.end()) {
-    return std::make_optional(std::make_pair(std::string_view(iterator->first), std::ref(*iterator->second)));
+  if (auto iterator = this->_metrics.find(name); iterator != this->_metrics.end()) {
+    return std::make_optional(std::make_pair(iterator->first, std::ref(*iterator->second)));
   }
 
   return std::nullopt;
 }
 
+std::vector<std::string>
+perf::CounterDefinition::names() const
+{
+  auto names = std::vector<std::string>{};
+  names.reserve(this->_counter_configs.size());
+  std::transform(this->_counter_configs.begin(),
+                 this->_counter_configs.end(),
+                 std::back_inserter(names),
+                 [](const auto& config) { return std::string{ config.first }; });
+
+  /// Counters of the caches that are shadowed by added counters (e.g., generalized counters) are listed once.
+  for (const auto& cache : this->_counter_caches) {
+    for (auto i = 0U; i < cache->size(); ++i) {
+      if (const auto name = cache->name(i); this->counter(name)->first.data() == name.data()) {
+        names.emplace_back(name);
+      }
+    }
+  }
+
+  return names;
+}
+
+void
+perf::CounterDefinition::write_counter_cache(const std::string& cache_filename) const
+{
+  auto counters = std::vector<std::pair<std::string_view, CounterConfig>>{};
+  counters.reserve(this->_counter_configs.size());
+  std::copy(this->_counter_configs.begin(), this->_counter_configs.end(), std::back_inserter(counters));
+
+  for (const auto& cache : this->_counter_caches) {
+    for (auto i = 0U; i < cache->size(); ++i) {
+      if (auto counter = cache->counter(cache->name(i)); counter.has_value()) {
+        counters.emplace_back(std::move(counter.value()));
+      }
+    }
+  }
+
+  CounterCache::write(cache_filename, std::move(counters));
+}
+
+std::string_view
+perf::CounterDefinition::trim(std::string_view text) noexcept
+{
+  const auto begin = text.find_first_not_of(" \t\r");
+  if (begin == std::string_view::npos) {
+    return std::string_view{};
+  }
+
+  return text.substr(begin, text.find_last_not_of(" \t\r") - begin + 1U);
+}
+
 void
 perf::CounterDefinition::initialize_generalized_counters()
 {
@@ -143,6 +207,26 @@ perf::CounterDefinition::initialize_amd_ibs_counters()
   }
 }
 
+void
+perf::CounterDefinition::initialize_aux_counters()
+{
+  /// Arm SPE: Timestamps (ts_enable, bit 0) and jitter (bit 16); filters for branches (bit 32), loads (bit 33),
+  /// and stores (bit 34).
+  if (const auto arm_spe_type = HardwareInfo::arm_spe_type(); arm_spe_type.has_value()) {
+    constexpr auto default_config = (1ULL << 0U) | (1ULL << 16U);
+    this->add("arm_spe", CounterConfig{ arm_spe_type.value(), default_config });
+    this->add("arm_spe_branches", CounterConfig{ arm_spe_type.value(), default_config | (1ULL << 32U) });
+    this->add("arm_spe_loads", CounterConfig{ arm_spe_type.value(), default_config | (1ULL << 33U) });
+    this->add("arm_spe_stores", CounterConfig{ arm_spe_type.value(), default_config | (1ULL << 34U) });
+    this->add("arm_spe_memory", CounterConfig{ arm_spe_type.value(), default_config | (3ULL << 33U) });
+  }
+
+  /// Intel PT: Control-flow trace with timestamps (tsc, bit 10).
+  if (const auto intel_pt_type = HardwareInfo::intel_pt_type(); intel_pt_type.has_value()) {
+    this->add("intel_pt", CounterConfig{ intel_pt_type.value(), 1ULL << 10U });
+  }
+}
+
 void
 perf::CounterDefinition::initialize_intel_pebs_counters()
 {
@@ -179,6 +263,15 @@ perf::CounterDefinition::read_counter_configuration(const std::string& csv_filen
   if (input_file.is_open()) {
     std::string line;
     while (std::getline(input_file, line)) {
+      /// Formula metrics are defined as "name = formula".
+      if (const auto assignment = line.find('='); assignment != std::string::npos) {
+        const auto name = CounterDefinition::trim(std::string_view{ line }.substr(0U, assignment));
+        if (!name.empty()) {
+          this->add(std::string{ name }, CounterDefinition::trim(std::string_view{ line }.substr(assignment + 1U)));
+        }
+        continue;
+      }
+
       auto line_stream = std::istringstream{ line };
 
       std::string name;
@@ -224,4 +317,92 @@ perf::CounterDefinition::read_counter_configuration(const std::string& csv_filen
       }
     }
   }
-}
\ No newline at end of file
+}
+
+void
+perf::CounterDefinition::initialize_topdown_metrics()
+{
+  if (HardwareInfo::is_intel_perf_metrics_supported()) {
+    /// The kernel reports every top-down metric event as its fraction of the slots. On hybrid processors, the events
+    /// are only available on the PMU of the performance cores.
+    const auto type = HardwareInfo::intel_hybrid_core_type().value_or(PERF_TYPE_RAW);
+    for (const auto* event_name : { "slots",
+                                    "topdown-retiring",
+                                    "topdown-bad-spec",
+                                    "topdown-fe-bound",
+                                    "topdown-be-bound",
+                                    "topdown-heavy-ops",
+                                    "topdown-br-mispredict",
+                                    "topdown-fetch-lat",
+                                    "topdown-mem-bound" }) {
+      if (const auto event_id = HardwareInfo::intel_topdown_event_id(event_name); event_id.has_value()) {
+        this->add(event_name, type, event_id.value());
+      }
+    }
+
+    /// Level 1: Every metric is normalized by the sum of all level 1 events.
+    constexpr auto total =
+      std::string_view{ "(topdown-retiring + topdown-bad-spec + topdown-fe-bound + topdown-be-bound)" };
+    const auto share = [total](const std::string_view events) {
+      return std::string{ "(" }.append(events).append(") / ").append(total);
+    };
+
+    this->add("tma-retiring", share("topdown-retiring"));
+    this->add("tma-bad-speculation", share("topdown-bad-spec"));
+    this->add("tma-frontend-bound", share("topdown-fe-bound"));
+    this->add("tma-backend-bound", share("topdown-be-bound"));
+
+    /// Level 2 (Sapphire Rapids and later).
+    if (this->counter(std::string_view{ "topdown-heavy-ops" }).has_value()) {
+      this->add("tma-heavy-operations", share("topdown-heavy-ops"));
+      this->add("tma-light-operations", share("topdown-retiring - topdown-heavy-ops"));
+      this->add("tma-branch-mispredicts", share("topdown-br-mispredict"));
+      this->add("tma-machine-clears", share("topdown-bad-spec - topdown-br-mispredict"));
+      this->add("tma-fetch-latency", share("topdown-fetch-lat"));
+      this->add("tma-fetch-bandwidth", share("topdown-fe-bound - topdown-fetch-lat"));
+      this->add("tma-memory-bound", share("topdown-mem-bound"));
+      this->add("tma-core-bound", share("topdown-be-bound - topdown-mem-bound"));
+    }
+  } else if (const auto dispatch_width = HardwareInfo::amd_dispatch_width(); dispatch_width.has_value()) {
+    /// Pipeline utilization events (PMCx1A0 and others; event select bits 11:8 are encoded into bits 35:32).
+    this->add("ls_not_halted_cyc", PERF_TYPE_RAW, 0x0076U);
+    this->add("de_src_op_disp.all", PERF_TYPE_RAW, 0x07AAU);
+    this->add("ex_ret_ops", PERF_TYPE_RAW, 0x00C1U);
+    this->add("ex_ret_ucode_ops", PERF_TYPE_RAW, (1ULL << 32U) | 0x00C1U);
+    this->add("de_no_dispatch_per_slot.no_ops_from_frontend", PERF_TYPE_RAW, (1ULL << 32U) | 0x01A0U);
+    this->add("de_no_dispatch_per_slot.no_ops_from_frontend.cmask_0x6",
+              PERF_TYPE_RAW,
+              (1ULL << 32U) | (0x06ULL << 24U) | 0x01A0U);
+    this->add("de_no_dispatch_per_slot.backend_stalls", PERF_TYPE_RAW, (1ULL << 32U) | 0x1EA0U);
+    this->add("de_no_dispatch_per_slot.smt_contention", PERF_TYPE_RAW, (1ULL << 32U) | 0x60A0U);
+    this->add("ex_no_retire.not_complete", PERF_TYPE_RAW, 0x02D6U);
+    this->add("ex_no_retire.load_not_complete", PERF_TYPE_RAW, 0xA2D6U);
+
+    /// Level 1: Every metric is normalized by the number of dispatch slots.
+    const auto width = std::to_string(dispatch_width.value());
+    const auto total = std::string{ "(" }.append(width).append(" * ls_not_halted_cyc)");
+    const auto share = [&total](const std::string_view events) {
+      return std::string{ "(" }.append(events).append(") / ").append(total);
+    };
+
+    this->add("tma-retiring", share("ex_ret_ops"));
+    this->add("tma-bad-speculation", share("de_src_op_disp.all - ex_ret_ops"));
+    this->add("tma-frontend-bound", share("de_no_dispatch_per_slot.no_ops_from_frontend"));
+    this->add("tma-backend-bound", share("de_no_dispatch_per_slot.backend_stalls"));
+    this->add("tma-smt-contention", share("de_no_dispatch_per_slot.smt_contention"));
+
+    /// Level 2: Cycles without any op from the frontend are attributed to latency, the remaining slots to bandwidth.
+    const auto fetch_latency = width + " * de_no_dispatch_per_slot.no_ops_from_frontend.cmask_0x6";
+    this->add("tma-heavy-operations", share("ex_ret_ucode_ops"));
+    this->add("tma-light-operations", share("ex_ret_ops - ex_ret_ucode_ops"));
+    this->add("tma-fetch-latency", share(fetch_latency));
+    this->add("tma-fetch-bandwidth",
+              share(std::string{ "de_no_dispatch_per_slot.no_ops_from_frontend - " }.append(fetch_latency)));
+    this->add("tma-memory-bound",
+              share("de_no_dispatch_per_slot.backend_stalls * ex_no_retire.load_not_complete / "
+                    "ex_no_retire.not_complete"));
+    this->add("tma-core-bound",
+              share("de_no_dispatch_per_slot.backend_stalls * (1 - ex_no_retire.load_not_complete / "
+                    "ex_no_retire.not_complete)"));
+  }
+}
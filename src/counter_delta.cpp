@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <iterator>
+#include <perfcpp/counter_delta.h>
+#include <type_traits>
+
+bool
+perf::CounterDelta::update(const perf::SampleView& sample)
+{
+  const auto values = sample.counter_values();
+  if (values.empty()) {
+    this->_values.clear();
+    return false;
+  }
+
+  return this->update(
+    values[0U].id, sample.counter_names(), values, sample.counter_time_enabled(), sample.counter_time_running());
+}
+
+bool
+perf::CounterDelta::update(const perf::SampleBatch::Row& row)
+{
+  const auto values = row.counter_values();
+  if (values.empty()) {
+    this->_values.clear();
+    return false;
+  }
+
+  return this->update(row.counter_group_id().value_or(0U),
+                      row.counter_names(),
+                      values,
+                      row.counter_time_enabled(),
+                      row.counter_time_running());
+}
+
+template<typename V>
+bool
+perf::CounterDelta::update(const std::uint64_t group_id,
+                           const std::vector<std::string_view>& names,
+                           const perf::Span<V> values,
+                           const std::optional<std::uint64_t> time_enabled,
+                           const std::optional<std::uint64_t> time_running)
+{
+  this->_names = &names;
+  this->_values.clear();
+
+  const auto value_of = [&values](const std::size_t counter_id) -> std::uint64_t {
+    if constexpr (std::is_same_v<V, SampleView::CounterValue>) {
+      return values[counter_id].value;
+    } else {
+      return values[counter_id];
+    }
+  };
+
+  auto& previous = this->_previous[group_id];
+  auto is_previous_known = previous.values.size() == values.size();
+
+  /// Counters that went backwards (e.g., after a reset) make the row a new baseline instead of a (wrapped) difference.
+  for (auto counter_id = 0U; is_previous_known && counter_id < values.size(); ++counter_id) {
+    is_previous_known = value_of(counter_id) >= previous.values[counter_id];
+  }
+
+  if (is_previous_known) {
+    /// Correct the differences by the share of time the counters were running since the previous sample.
+    auto multiplexing_correction = 1.0;
+    if (time_enabled.has_value() && time_running.has_value() && previous.time_enabled.has_value() &&
+        previous.time_running.has_value() && time_running.value() > previous.time_running.value()) {
+      multiplexing_correction = double(time_enabled.value() - previous.time_enabled.value()) /
+                                double(time_running.value() - previous.time_running.value());
+    }
+
+    for (auto counter_id = 0U; counter_id < values.size(); ++counter_id) {
+      this->_values.push_back(double(value_of(counter_id) - previous.values[counter_id]) * multiplexing_correction);
+    }
+  }
+
+  previous.values.resize(values.size());
+  for (auto counter_id = 0U; counter_id < values.size(); ++counter_id) {
+    previous.values[counter_id] = value_of(counter_id);
+  }
+  previous.time_enabled = time_enabled;
+  previous.time_running = time_running;
+
+  return is_previous_known;
+}
+
+std::optional<double>
+perf::CounterDelta::value(const std::string_view name) const noexcept
+{
+  if (this->_names == nullptr || this->_values.size() != this->_names->size()) {
+    return std::nullopt;
+  }
+
+  const auto iterator = std::find(this->_names->begin(), this->_names->end(), name);
+  if (iterator == this->_names->end()) {
+    return std::nullopt;
+  }
+
+  return this->_values[std::size_t(std::distance(this->_names->begin(), iterator))];
+}
+
+std::optional<double>
+perf::CounterDelta::ratio(const std::string_view numerator, const std::string_view denominator) const noexcept
+{
+  const auto numerator_value = this->value(numerator);
+  const auto denominator_value = this->value(denominator);
+  if (!numerator_value.has_value() || !denominator_value.has_value() || denominator_value.value() == 0.0) {
+    return std::nullopt;
+  }
+
+  return numerator_value.value() / denominator_value.value();
+}
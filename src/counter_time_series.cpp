@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <perfcpp/counter_time_series.h>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+perf::CounterTimeSeries::CounterTimeSeries(const perf::CounterDefinition& counter_definitions,
+                                           const std::chrono::milliseconds interval,
+                                           const std::size_t capacity,
+                                           perf::Config config)
+  : _event_counter(counter_definitions, config)
+  , _interval(interval)
+  , _capacity(std::max<std::size_t>(capacity, 1U))
+{
+  /// The counters are read from the background thread; reading from user-level is only valid for the monitored
+  /// thread itself.
+  config.user_level_read(false);
+  this->_event_counter.config(config);
+}
+
+bool
+perf::CounterTimeSeries::start()
+{
+  if (this->_thread.joinable()) {
+    throw std::runtime_error{ "Cannot start time series: Time series is already started." };
+  }
+
+  this->_event_counter.open();
+  this->_event_counter.start();
+
+  const auto& groups = this->_event_counter._groups;
+  const auto& events = this->_event_counter._counters;
+
+  /// Allocate the ring once; recording will not allocate any memory.
+  this->_count_values = std::size_t(
+    std::count_if(events.begin(), events.end(), [](const auto& event) { return event.is_counter(); }));
+  this->_times.resize(this->_capacity);
+  this->_values.resize(this->_capacity * this->_count_values);
+  this->_previous_values.resize(groups.size());
+  this->_current_values.resize(groups.size());
+
+  {
+    const auto lock = std::lock_guard{ this->_mutex };
+    this->_head = 0U;
+    this->_size = 0U;
+    this->_count_lost_intervals = 0U;
+    this->_is_stop_requested = false;
+  }
+
+  /// Read the values at the begin of the first interval.
+  for (auto group_id = 0U; group_id < groups.size(); ++group_id) {
+    std::ignore = groups[group_id].read(this->_previous_values[group_id]);
+  }
+  this->_start_time = std::chrono::steady_clock::now();
+  this->_interval_begin = std::chrono::nanoseconds{ 0U };
+
+  this->_thread = std::thread{ &CounterTimeSeries::run, this };
+
+  return true;
+}
+
+void
+perf::CounterTimeSeries::stop()
+{
+  if (!this->_thread.joinable()) {
+    return;
+  }
+
+  {
+    const auto lock = std::lock_guard{ this->_mutex };
+    this->_is_stop_requested = true;
+  }
+  this->_stop_condition.notify_one();
+  this->_thread.join();
+
+  /// Record the last (partial) interval.
+  this->record();
+
+  this->_event_counter.stop();
+  this->_event_counter.close();
+}
+
+std::size_t
+perf::CounterTimeSeries::size() const
+{
+  const auto lock = std::lock_guard{ this->_mutex };
+  return this->_size;
+}
+
+std::uint64_t
+perf::CounterTimeSeries::count_lost_intervals() const
+{
+  const auto lock = std::lock_guard{ this->_mutex };
+  return this->_count_lost_intervals;
+}
+
+void
+perf::CounterTimeSeries::run()
+{
+  auto next_read = this->_start_time + this->_interval;
+
+  while (true) {
+    {
+      auto lock = std::unique_lock{ this->_mutex };
+      if (this->_stop_condition.wait_until(lock, next_read, [this] { return this->_is_stop_requested; })) {
+        return;
+      }
+    }
+
+    this->record();
+    next_read += this->_interval;
+  }
+}
+
+void
+perf::CounterTimeSeries::record()
+{
+  const auto& groups = this->_event_counter._groups;
+  const auto& events = this->_event_counter._counters;
+
+  /// Read the values at the end of the interval.
+  for (auto group_id = 0U; group_id < groups.size(); ++group_id) {
+    std::ignore = groups[group_id].read(this->_current_values[group_id]);
+  }
+  const auto interval_end =
+    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - this->_start_time);
+
+  {
+    const auto lock = std::lock_guard{ this->_mutex };
+
+    this->_times[this->_head] = std::make_pair(this->_interval_begin, interval_end);
+
+    /// Store the (multiplexing-corrected) delta of every hardware event.
+    auto* values = this->_values.data() + this->_head * this->_count_values;
+    for (const auto& event : events) {
+      if (event.is_counter()) {
+        *values = groups[event.group_id()].get(event.in_group_id(),
+                                               this->_previous_values[event.group_id()],
+                                               this->_current_values[event.group_id()]);
+        ++values;
+      }
+    }
+
+    this->_head = (this->_head + 1U) % this->_capacity;
+    if (this->_size < this->_capacity) {
+      ++this->_size;
+    } else {
+      ++this->_count_lost_intervals;
+    }
+  }
+
+  /// The end of this interval is the begin of the next one.
+  std::swap(this->_previous_values, this->_current_values);
+  this->_interval_begin = interval_end;
+}
+
+std::vector<perf::CounterTimeSeries::Interval>
+perf::CounterTimeSeries::result(const std::uint64_t normalization) const
+{
+  const auto& events = this->_event_counter._counters;
+
+  const auto lock = std::lock_guard{ this->_mutex };
+
+  auto result = std::vector<Interval>{};
+  result.reserve(this->_size);
+
+  /// The oldest interval is located at the head, if the ring is full.
+  const auto first = (this->_head + this->_capacity - this->_size) % this->_capacity;
+  for (auto index = 0U; index < this->_size; ++index) {
+    const auto position = (first + index) % this->_capacity;
+
+    auto hardware_event_values = std::vector<std::pair<std::string_view, double>>{};
+    hardware_event_values.reserve(this->_count_values);
+
+    const auto* values = this->_values.data() + position * this->_count_values;
+    for (const auto& event : events) {
+      if (event.is_counter()) {
+        hardware_event_values.emplace_back(event.name(), *values / double(normalization));
+        ++values;
+      }
+    }
+
+    const auto [begin, end] = this->_times[position];
+    result.emplace_back(begin, end, this->_event_counter.to_result(std::move(hardware_event_values)));
+  }
+
+  return result;
+}
+
+std::string
+perf::CounterTimeSeries::to_csv(const char delimiter, const bool print_header, const std::uint64_t normalization) const
+{
+  const auto intervals = this->result(normalization);
+
+  auto csv_stream = std::stringstream{};
+
+  if (print_header) {
+    csv_stream << "begin" << delimiter << "end";
+    if (!intervals.empty()) {
+      for (const auto& [name, _] : intervals.front().result()) {
+        csv_stream << delimiter << name;
+      }
+    }
+    csv_stream << "\n";
+  }
+
+  for (auto i = 0U; i < intervals.size(); ++i) {
+    if (i > 0U) {
+      csv_stream << "\n";
+    }
+
+    const auto& interval = intervals[i];
+    csv_stream << interval.begin().count() << delimiter << interval.end().count();
+    for (const auto& [_, value] : interval.result()) {
+      csv_stream << delimiter << value;
+    }
+  }
+
+  return csv_stream.str();
+}
@@ -1,7 +1,33 @@
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <mutex>
 #include <numeric>
+#include <perfcpp/hardware_info.h>
 #include <perfcpp/perf.h>
 #include <stdexcept>
+#include <thread>
+#include <utility>
+
+perf::EventCounter::EventCounter(const perf::EventCounter& other)
+  : _counter_definitions(other._counter_definitions)
+  , _config(other._config)
+  , _counters(other._counters)
+{
+  /// Rebuild the groups from the configurations of their members, leaving out the state of opened counters.
+  this->_groups.reserve(other._groups.size());
+  for (const auto& group : other._groups) {
+    auto& group_copy = this->_groups.emplace_back();
+    for (auto member_index = std::size_t{ 0U }; member_index < group.size(); ++member_index) {
+      group_copy.add(group.member(member_index).config());
+    }
+  }
+}
+
 bool
 perf::EventCounter::add(std::string&& counter_name)
 {
@@ -62,14 +88,66 @@ perf::EventCounter::add(std::string_view counter_name, perf::CounterConfig count
     return;
   }
 
+  /// When packing groups, all counters are collected in a single group and distributed when opening.
+  const auto is_pack_groups = this->_config.is_pack_groups();
+
+  /// Intel's top-down metric events (Ice Lake and later) are read from the PERF_METRICS register: They need to be in a
+  /// group led by the slots event and do not occupy general-purpose counters.
+  const auto is_topdown_group = [](const Group& group) {
+    return group.size() > 0U && group.member(0U).is_intel_topdown_slots();
+  };
+  const auto is_intel = HardwareInfo::is_intel();
+
+  if (is_intel && counter.is_intel_topdown_metric()) {
+    /// Add the slots event (hidden, if not requested) to lead the group of the top-down metric events.
+    const auto is_slots_added = std::any_of(this->_counters.begin(), this->_counters.end(), [this](const auto& event) {
+      return event.is_counter() && this->_groups[event.group_id()].member(event.in_group_id()).is_intel_topdown_slots();
+    });
+    if (!is_slots_added) {
+      if (auto slots = this->_counter_definitions.counter(std::string_view{ "slots" }); slots.has_value()) {
+        this->add(std::get<0>(slots.value()), std::get<1>(slots.value()), true);
+      } else {
+        throw std::runtime_error{ std::string{ "Cannot add top-down metric event '" }
+                                    .append(counter_name)
+                                    .append("': Missing the 'slots' event.") };
+      }
+    }
+
+    if (!is_pack_groups) {
+      auto group = std::find_if(this->_groups.begin(), this->_groups.end(), is_topdown_group);
+      if (group->size() >= Group::MAX_MEMBERS) {
+        throw std::runtime_error{ "Cannot add more top-down metric events: Reached maximum number of group members." };
+      }
+
+      const auto group_id = std::uint8_t(std::distance(this->_groups.begin(), group));
+      this->_counters.emplace_back(counter_name, is_hidden, group_id, std::uint8_t(group->size()));
+      group->add(counter);
+      return;
+    }
+  } else if (is_intel && counter.is_intel_topdown_slots() && !is_pack_groups) {
+    /// The slots event leads a group of its own.
+    if (this->_groups.size() >= this->_config.max_groups()) {
+      throw std::runtime_error{ "Cannot add the slots event: Reached maximum number of groups." };
+    }
+
+    this->_groups.emplace_back();
+    this->_counters.emplace_back(counter_name, is_hidden, std::uint8_t(this->_groups.size() - 1U), 0U);
+    this->_groups.back().add(counter);
+    return;
+  }
+
+  /// Other counters are not added to the group of top-down metric events.
+  const auto is_latest_group_full =
+    !is_pack_groups && !this->_groups.empty() &&
+    (is_topdown_group(this->_groups.back()) || this->_groups.back().size() >= this->_config.max_counters_per_group());
+
   /// Check if space for more counters left: If the latest group is "full", check, if there is space for another group.
-  if (this->_groups.size() == this->_config.max_groups() &&
-      this->_groups.back().size() >= this->_config.max_counters_per_group()) {
+  if (this->_groups.size() == this->_config.max_groups() && is_latest_group_full) {
     throw std::runtime_error{ "Cannot add more counters: Reached maximum number of groups and maximum number of counters in the latest group." };
   }
 
   /// If the latest group is "full", add a new group. We already verified that there will be enough space.
-  if (this->_groups.empty() || this->_groups.back().size() >= this->_config.max_counters_per_group()) {
+  if (this->_groups.empty() || is_latest_group_full) {
     this->_groups.emplace_back();
   }
 
@@ -97,18 +175,284 @@ perf::EventCounter::add(const std::vector<std::string>& counter_names)
   return this->add(std::vector<std::string>(counter_names));
 }
 
-bool
-perf::EventCounter::start()
+void
+perf::EventCounter::open()
 {
+  /// Do not open again, if the counters were already opened.
+  /// The is_open flag will be reset on closing the counters.
+  if (std::exchange(this->_is_opened, true)) {
+    return;
+  }
+
+  if (this->_config.is_pack_groups()) {
+    this->pack_groups();
+  }
+
   /// Open all counters. If one of them fails, group.open() will throw an exception.
   for (auto& group : this->_groups) {
     group.open(this->_config);
   }
+}
+
+void
+perf::EventCounter::pack_groups()
+{
+  /// Hardware event that needs to be placed in a group.
+  struct Entry
+  {
+    std::size_t event_index;
+    CounterConfig config;
+    std::uint32_t pmu;
+    std::optional<std::uint8_t> fixed_counter;
+  };
+
+  /// Group that is filled with entries.
+  struct Bin
+  {
+    std::uint32_t pmu;
+    std::vector<std::size_t> entries;
+    std::uint8_t count_general_purpose{ 0U };
+    std::uint8_t fixed_counter_mask{ 0U };
+  };
+
+  /// Events of the software context (software events, tracepoints, and breakpoints) can be grouped freely.
+  constexpr auto SOFTWARE_PMU = std::numeric_limits<std::uint32_t>::max();
+
+  /// Core events (hardware, cache, and raw events) share the general-purpose and fixed counters of the core PMU.
+  constexpr auto CORE_PMU = std::uint32_t{ PERF_TYPE_RAW };
+
+  /// Intel's slots and top-down metric events are grouped together (led by slots) and occupy no general-purpose
+  /// counter.
+  constexpr auto TOPDOWN_PMU = std::numeric_limits<std::uint32_t>::max() - 1U;
+  const auto is_intel = HardwareInfo::is_intel();
+
+  const auto detected_count_general_purpose = HardwareInfo::count_general_purpose_counters();
+  auto count_fixed_counters = HardwareInfo::count_fixed_counters();
+  auto core_group_size = detected_count_general_purpose.value_or(this->_config.max_counters_per_group());
+  if (detected_count_general_purpose.has_value() && HardwareInfo::is_nmi_watchdog_enabled()) {
+    if (count_fixed_counters > 1U) {
+      /// The watchdog counts cycles and occupies the fixed cycle counter.
+      count_fixed_counters = 1U;
+    } else if (core_group_size > 1U) {
+      --core_group_size;
+    }
+  }
+
+  /// Fixed counter (instructions: 0, cycles: 1, reference cycles: 2) an event is counted on, if any.
+  const auto fixed_counter = [count_fixed_counters](const CounterConfig& config) -> std::optional<std::uint8_t> {
+    auto counter = std::optional<std::uint8_t>{ std::nullopt };
+    if (config.type() == PERF_TYPE_HARDWARE) {
+      if (config.event_id() == PERF_COUNT_HW_INSTRUCTIONS) {
+        counter = 0U;
+      } else if (config.event_id() == PERF_COUNT_HW_CPU_CYCLES) {
+        counter = 1U;
+      } else if (config.event_id() == PERF_COUNT_HW_REF_CPU_CYCLES) {
+        counter = 2U;
+      }
+    } else if (config.type() == PERF_TYPE_RAW) {
+      if (config.event_id() == 0x00C0U) {
+        counter = 0U;
+      } else if (config.event_id() == 0x003CU) {
+        counter = 1U;
+      } else if (config.event_id() == 0x0300U) {
+        counter = 2U;
+      }
+    }
+
+    if (counter.has_value() && counter.value() < count_fixed_counters) {
+      return counter;
+    }
+    return std::nullopt;
+  };
+
+  /// Collect all hardware events.
+  auto entries = std::vector<Entry>{};
+  for (auto event_index = 0U; event_index < this->_counters.size(); ++event_index) {
+    const auto& event = this->_counters[event_index];
+    if (!event.is_counter()) {
+      continue;
+    }
+
+    const auto& config = this->_groups[event.group_id()].member(event.in_group_id()).config();
+    auto pmu = config.type();
+    if (pmu == PERF_TYPE_SOFTWARE || pmu == PERF_TYPE_TRACEPOINT || pmu == PERF_TYPE_BREAKPOINT) {
+      pmu = SOFTWARE_PMU;
+    } else if (is_intel && (config.is_intel_topdown_slots() || config.is_intel_topdown_metric())) {
+      pmu = TOPDOWN_PMU;
+    } else if (pmu == PERF_TYPE_HARDWARE || pmu == PERF_TYPE_HW_CACHE || pmu == PERF_TYPE_RAW) {
+      pmu = CORE_PMU;
+    }
+
+    entries.push_back(Entry{ event_index, config, pmu, pmu == CORE_PMU ? fixed_counter(config) : std::nullopt });
+  }
+
+  /// Units of entries that should be placed in the same group: The counters required by each metric, followed by every
+  /// single entry.
+  auto units = std::vector<std::vector<std::size_t>>{};
+  for (const auto& event : this->_counters) {
+    if (event.is_counter()) {
+      continue;
+    }
+
+    if (auto metric = this->_counter_definitions.metric(event.name()); metric.has_value()) {
+      auto unit = std::vector<std::size_t>{};
+      for (const auto& counter_name : std::get<1>(metric.value()).required_counter_names()) {
+        for (auto entry_id = 0U; entry_id < entries.size(); ++entry_id) {
+          if (this->_counters[entries[entry_id].event_index].name() == counter_name) {
+            unit.push_back(entry_id);
+          }
+        }
+      }
+      units.emplace_back(std::move(unit));
+    }
+  }
+  for (auto entry_id = 0U; entry_id < entries.size(); ++entry_id) {
+    units.emplace_back(std::vector<std::size_t>{ entry_id });
+  }
+
+  /// Place large units first (first-fit decreasing).
+  std::stable_sort(units.begin(), units.end(), [](const auto& left, const auto& right) {
+    return left.size() > right.size();
+  });
+
+  const auto group_size = [this, core_group_size](const std::uint32_t pmu) -> std::size_t {
+    if (pmu == SOFTWARE_PMU || pmu == TOPDOWN_PMU) {
+      return Group::MAX_MEMBERS;
+    }
+    return std::min<std::size_t>(pmu == CORE_PMU ? core_group_size : this->_config.max_counters_per_group(),
+                                 Group::MAX_MEMBERS);
+  };
+
+  /// Places the entry into the bin, if it fits.
+  const auto place = [&entries, &group_size](Bin& bin, const std::size_t entry_id, const bool is_dry_run) {
+    const auto& entry = entries[entry_id];
+    if (bin.pmu != entry.pmu || bin.entries.size() >= Group::MAX_MEMBERS) {
+      return false;
+    }
+
+    if (entry.fixed_counter.has_value() &&
+        !static_cast<bool>(bin.fixed_counter_mask & (std::uint8_t(1U) << entry.fixed_counter.value()))) {
+      if (!is_dry_run) {
+        bin.fixed_counter_mask |= std::uint8_t(1U) << entry.fixed_counter.value();
+        bin.entries.push_back(entry_id);
+      }
+      return true;
+    }
+
+    if (bin.count_general_purpose >= group_size(bin.pmu)) {
+      return false;
+    }
+
+    if (!is_dry_run) {
+      ++bin.count_general_purpose;
+      bin.entries.push_back(entry_id);
+    }
+    return true;
+  };
+
+  auto bins = std::vector<Bin>{};
+  auto is_placed = std::vector<bool>(entries.size(), false);
+  for (const auto& unit : units) {
+    /// Entries of the unit that are not placed yet (e.g., by another metric), split by their PMU.
+    auto pending_entries = std::vector<std::size_t>{};
+    for (const auto entry_id : unit) {
+      if (!is_placed[entry_id] &&
+          std::find(pending_entries.begin(), pending_entries.end(), entry_id) == pending_entries.end()) {
+        pending_entries.push_back(entry_id);
+      }
+    }
+
+    while (!pending_entries.empty()) {
+      const auto pmu = entries[pending_entries.front()].pmu;
+      auto pmu_entries = std::vector<std::size_t>{};
+      for (const auto entry_id : pending_entries) {
+        if (entries[entry_id].pmu == pmu) {
+          pmu_entries.push_back(entry_id);
+        }
+      }
+      const auto is_same_pmu = [&entries, pmu](const auto entry_id) { return entries[entry_id].pmu == pmu; };
+      pending_entries.erase(std::remove_if(pending_entries.begin(), pending_entries.end(), is_same_pmu),
+                            pending_entries.end());
+
+      /// Try to place all entries of the unit into the same bin: Simulate the placement on a copy of each bin.
+      const auto fits = [&place, &pmu_entries](Bin bin) {
+        return std::all_of(pmu_entries.begin(), pmu_entries.end(), [&place, &bin](const auto entry_id) {
+          return place(bin, entry_id, false);
+        });
+      };
+
+      auto bin_iterator = std::find_if(bins.begin(), bins.end(), fits);
+      if (bin_iterator == bins.end() && fits(Bin{ pmu, {}, 0U, 0U })) {
+        bin_iterator = bins.insert(bins.end(), Bin{ pmu, {}, 0U, 0U });
+      }
+
+      if (bin_iterator != bins.end()) {
+        for (const auto entry_id : pmu_entries) {
+          place(*bin_iterator, entry_id, false);
+        }
+      } else {
+        /// The unit does not fit into a single group; place the entries individually.
+        for (const auto entry_id : pmu_entries) {
+          auto bin = std::find_if(
+            bins.begin(), bins.end(), [&place, entry_id](Bin& candidate) { return place(candidate, entry_id, true); });
+          if (bin == bins.end()) {
+            bin = bins.insert(bins.end(), Bin{ pmu, {}, 0U, 0U });
+          }
+          place(*bin, entry_id, false);
+        }
+      }
+
+      for (const auto entry_id : pmu_entries) {
+        is_placed[entry_id] = true;
+      }
+    }
+  }
+
+  if (bins.size() > this->_config.max_groups()) {
+    throw std::runtime_error{ std::string{ "Cannot schedule counters: Packing needs " }
+                                .append(std::to_string(bins.size()))
+                                .append(" groups, maximal number of groups: ")
+                                .append(std::to_string(std::size_t{ this->_config.max_groups() })) };
+  }
+
+  /// The slots event has to lead the group of top-down metric events.
+  for (auto& bin : bins) {
+    if (bin.pmu == TOPDOWN_PMU) {
+      std::stable_partition(bin.entries.begin(), bin.entries.end(), [&entries](const auto entry_id) {
+        return entries[entry_id].config.is_intel_topdown_slots();
+      });
+    }
+  }
+
+  /// Rebuild the groups and update the position of every hardware event.
+  auto groups = std::vector<Group>{};
+  groups.reserve(bins.size());
+  for (const auto& bin : bins) {
+    auto& group = groups.emplace_back();
+    for (const auto entry_id : bin.entries) {
+      const auto& entry = entries[entry_id];
+      this->_counters[entry.event_index].position(std::uint8_t(groups.size() - 1U), std::uint8_t(group.size()));
+      group.add(entry.config);
+    }
+  }
+
+  this->_groups = std::move(groups);
+}
+
+bool
+perf::EventCounter::start()
+{
+  /// Open the counters, if the user did not open them explicitly; they will be closed on stop().
+  if (!this->_is_opened) {
+    this->open();
+    this->_is_close_on_stop = true;
+  }
 
   /// Start all counters. If one of them fails, group.start() will throw an exception.
   for (auto& group : this->_groups) {
     group.start();
   }
+  this->_is_started = true;
 
   /// If no exception was thrown, we are good to go.
   return true;
@@ -117,15 +461,33 @@ perf::EventCounter::start()
 void
 perf::EventCounter::stop()
 {
+  if (!std::exchange(this->_is_started, false)) {
+    return;
+  }
+
   /// Stop all counters. If one of them fails, group.stop() will throw an exception.
   for (auto& group : this->_groups) {
     group.stop();
   }
 
-  /// Close all counters. If one of them fails, group.close() will throw an exception.
-  for (auto& group : this->_groups) {
-    group.close();
+  /// Close all counters, if they were opened by start().
+  if (this->_is_close_on_stop) {
+    this->close();
+  }
+}
+
+void
+perf::EventCounter::close()
+{
+  if (std::exchange(this->_is_opened, false)) {
+    /// Close all counters. If one of them fails, group.close() will throw an exception.
+    for (auto& group : this->_groups) {
+      group.close();
+    }
   }
+
+  this->_is_close_on_stop = false;
+  this->_is_started = false;
 }
 
 perf::CounterResult
@@ -135,6 +497,24 @@ perf::EventCounter::result(std::uint64_t normalization) const
   auto hardware_event_values = std::vector<std::pair<std::string_view, double>>{};
   hardware_event_values.reserve(this->_counters.size());
 
+  /// Copy only the hardware-event values.
+  for (const auto& event : this->_counters) {
+    if (event.is_counter()) {
+      const auto value = this->_groups[event.group_id()].accumulated(event.in_group_id()) / double(normalization);
+      hardware_event_values.emplace_back(event.name(), value);
+    }
+  }
+
+  return this->to_result(std::move(hardware_event_values));
+}
+
+perf::CounterResult
+perf::EventCounter::interval_result(std::uint64_t normalization) const
+{
+  /// Build result with all counters, including hidden ones.
+  auto hardware_event_values = std::vector<std::pair<std::string_view, double>>{};
+  hardware_event_values.reserve(this->_counters.size());
+
   /// Copy only the hardware-event values.
   for (const auto& event : this->_counters) {
     if (event.is_counter()) {
@@ -143,6 +523,105 @@ perf::EventCounter::result(std::uint64_t normalization) const
     }
   }
 
+  return this->to_result(std::move(hardware_event_values));
+}
+
+perf::CounterResult
+perf::EventCounter::live_result(const std::uint64_t normalization) const
+{
+  if (!this->_is_opened) {
+    throw std::runtime_error{ "Cannot read counters: Counters need to be started before reading live results." };
+  }
+
+  /// If the counters are currently not started, the accumulated result is up to date.
+  if (!this->_is_started) {
+    return this->result(normalization);
+  }
+
+  /// Read the current values of all groups, without stopping them.
+  auto live_values = std::vector<CounterReadFormat<Group::MAX_MEMBERS>>(this->_groups.size());
+  for (auto group_id = 0U; group_id < this->_groups.size(); ++group_id) {
+    if (!this->_groups[group_id].read(live_values[group_id])) {
+      throw std::runtime_error{ "Cannot read counters: Counters need to be started before reading live results." };
+    }
+  }
+
+  /// Build result with all counters, including hidden ones.
+  auto hardware_event_values = std::vector<std::pair<std::string_view, double>>{};
+  hardware_event_values.reserve(this->_counters.size());
+
+  /// Copy only the hardware-event values.
+  for (const auto& event : this->_counters) {
+    if (event.is_counter()) {
+      const auto& group = this->_groups[event.group_id()];
+      const auto value =
+        (group.accumulated(event.in_group_id()) + group.get(event.in_group_id(), live_values[event.group_id()])) /
+        double(normalization);
+      hardware_event_values.emplace_back(event.name(), value);
+    }
+  }
+
+  return this->to_result(std::move(hardware_event_values));
+}
+
+bool
+perf::EventCounter::live_values(std::vector<double>& hardware_event_values) const
+{
+  if (!this->_is_started) {
+    return false;
+  }
+
+  hardware_event_values.resize(this->count_hardware_events());
+
+  /// Read one group after another, the buffer is reused for every group.
+  auto live_value = CounterReadFormat<Group::MAX_MEMBERS>{};
+  for (auto group_id = 0U; group_id < this->_groups.size(); ++group_id) {
+    const auto& group = this->_groups[group_id];
+    if (!group.read(live_value)) {
+      return false;
+    }
+
+    auto index = std::size_t{ 0U };
+    for (const auto& event : this->_counters) {
+      if (event.is_counter()) {
+        if (event.group_id() == group_id) {
+          hardware_event_values[index] =
+            group.accumulated(event.in_group_id()) + group.get(event.in_group_id(), live_value);
+        }
+        ++index;
+      }
+    }
+  }
+
+  return true;
+}
+
+perf::CounterResult
+perf::EventCounter::to_result(const std::vector<double>& hardware_event_values) const
+{
+  auto named_hardware_event_values = std::vector<std::pair<std::string_view, double>>{};
+  named_hardware_event_values.reserve(hardware_event_values.size());
+
+  auto index = std::size_t{ 0U };
+  for (const auto& event : this->_counters) {
+    if (event.is_counter() && index < hardware_event_values.size()) {
+      named_hardware_event_values.emplace_back(event.name(), hardware_event_values[index++]);
+    }
+  }
+
+  return this->to_result(std::move(named_hardware_event_values));
+}
+
+std::size_t
+perf::EventCounter::count_hardware_events() const noexcept
+{
+  return std::size_t(
+    std::count_if(this->_counters.begin(), this->_counters.end(), [](const auto& event) { return event.is_counter(); }));
+}
+
+perf::CounterResult
+perf::EventCounter::to_result(std::vector<std::pair<std::string_view, double>>&& hardware_event_values) const
+{
   /// This result only contains hardware-event values to either copy the value (if the event is requested) or use the value for calculating a metric.
   auto hardware_events_result = CounterResult{ std::move(hardware_event_values) };
 
@@ -206,53 +685,35 @@ perf::MultiEventCounterBase::result(const std::vector<perf::EventCounter>& event
 {
   /// The reference_event_counter is used to access counters (all EventCounters from the list are required to have the same counters but different values).
   const auto& reference_event_counter = event_counters.front();
+  const auto count_hardware_events = reference_event_counter.count_hardware_events();
 
-  /// Build one result of only hardware-event values over all EventCounters by aggregating their values.
-  auto aggregated_hardware_event_values = std::vector<std::pair<std::string_view, double>>{};
-  aggregated_hardware_event_values.reserve(reference_event_counter._counters.size());
-
-  /// For every (hardware) event, accumulate the results for every EventCounter from event_counters.
-  for (const auto& event : reference_event_counter._counters) {
-    if (event.is_counter()) {
-
-      /// Add up the values from all individual EventCounters in event_counters.
-      const auto value = std::accumulate(
-        event_counters.begin(),
-        event_counters.end(),
-        .0,
-        [id = event.group_id(), in_group_id = event.in_group_id()](const double sum, const auto& event_counter) {
-          return sum + event_counter._groups[id].get(in_group_id);
-      });
-
-      /// Normalize the value (by the given normalization parameter) and add to the aggregated results.
-      aggregated_hardware_event_values.emplace_back(event.name(), value / double(normalization));
+  /// Sum up the values of all EventCounters by the index of the hardware event; names are only resolved once when
+  /// building the result from the aggregated values.
+  auto aggregated_values = std::vector<double>(count_hardware_events, .0);
+  auto values = std::vector<double>(count_hardware_events);
+  for (const auto& event_counter : event_counters) {
+    MultiEventCounterBase::accumulated_values(event_counter, values.data());
+    for (auto index = std::size_t{ 0U }; index < count_hardware_events; ++index) {
+      aggregated_values[index] += values[index];
     }
   }
 
-  /// This result only contains hardware-event values to either copy the value (if the event is requested) or use the value for calculating a metric.
-  auto hardware_event_results = CounterResult{ std::move(aggregated_hardware_event_values) };
-
-  /// List of all requested values (hardware-events and metrics)
-  auto result = std::vector<std::pair<std::string_view, double>>{};
-  result.reserve(reference_event_counter._counters.size());
+  for (auto& value : aggregated_values) {
+    value /= double(normalization);
+  }
 
-  for (const auto& event : reference_event_counter._counters) {
-    /// First, add all hardware events that were requested to be shown: event.is_hidden() indicates that the event was only required by a metric but not requested by the user.
-    if (event.is_counter() && !event.is_hidden()) {
-      if (const auto value = hardware_event_results.get(event.name()); value.has_value()) {
-        result.emplace_back(event.name(), value.value());
-      }
-    }
+  return reference_event_counter.to_result(aggregated_values);
+}
 
-    /// If the event is a metric (not a hardware event), calculate the value of the metric and add it to the result.
-    else if (auto metric = reference_event_counter._counter_definitions.metric(event.name()); metric.has_value()) {
-      if (auto value = std::get<1>(metric.value()).calculate(hardware_event_results); value.has_value()) {
-        result.emplace_back(std::get<0>(metric.value()), value.value());
-      }
+void
+perf::MultiEventCounterBase::accumulated_values(const perf::EventCounter& event_counter,
+                                                double* hardware_event_values) noexcept
+{
+  for (const auto& event : event_counter._counters) {
+    if (event.is_counter()) {
+      *hardware_event_values++ = event_counter._groups[event.group_id()].accumulated(event.in_group_id());
     }
   }
-
-  return CounterResult{ std::move(result) };
 }
 
 perf::MultiThreadEventCounter::MultiThreadEventCounter(const perf::CounterDefinition& counter_list,
@@ -263,6 +724,8 @@ perf::MultiThreadEventCounter::MultiThreadEventCounter(const perf::CounterDefini
   for (auto i = 0U; i < num_threads; ++i) {
     this->_thread_local_counter.emplace_back(counter_list, config);
   }
+
+  this->initialize_thread_registry();
 }
 
 perf::MultiThreadEventCounter::MultiThreadEventCounter(perf::EventCounter&& event_counter,
@@ -273,6 +736,19 @@ perf::MultiThreadEventCounter::MultiThreadEventCounter(perf::EventCounter&& even
     this->_thread_local_counter.push_back(event_counter);
   }
   this->_thread_local_counter.emplace_back(std::move(event_counter));
+
+  this->initialize_thread_registry();
+}
+
+void
+perf::MultiThreadEventCounter::initialize_thread_registry()
+{
+  this->_thread_registry =
+    ThreadRegistry{ this->_thread_local_counter.size(),
+                    [event_counters = this->_thread_local_counter.data()](const std::size_t thread_id) {
+                      event_counters[thread_id].stop();
+                      event_counters[thread_id].close();
+                    } };
 }
 
 perf::MultiProcessEventCounter::MultiProcessEventCounter(const perf::CounterDefinition& counter_list,
@@ -335,7 +811,10 @@ perf::MultiCoreEventCounter::MultiCoreEventCounter(const perf::CounterDefinition
   for (const auto cpu_id : cpu_ids) {
     config.cpu_id(cpu_id);
     this->_cpu_local_counter.emplace_back(counter_list, config);
+    this->_socket_ids.push_back(MultiCoreEventCounter::socket_of_cpu(cpu_id));
   }
+
+  this->_cpu_ids = std::move(cpu_ids);
 }
 
 perf::MultiCoreEventCounter::MultiCoreEventCounter(perf::EventCounter&& event_counter,
@@ -356,22 +835,356 @@ perf::MultiCoreEventCounter::MultiCoreEventCounter(perf::EventCounter&& event_co
   config.cpu_id(cpu_ids.back());
   event_counter.config(config);
   this->_cpu_local_counter.push_back(std::move(event_counter));
+
+  for (const auto cpu_id : cpu_ids) {
+    this->_socket_ids.push_back(MultiCoreEventCounter::socket_of_cpu(cpu_id));
+  }
+  this->_cpu_ids = std::move(cpu_ids);
+}
+
+/**
+ * Threads that process the CPUs in parallel. The threads wait for a task, run it with their id, and signal the calling
+ * thread (which runs the task with id zero) when finished; they are kept alive to avoid spawning threads per read.
+ */
+class perf::MultiCoreEventCounter::ReaderPool
+{
+public:
+  explicit ReaderPool(const std::size_t count_threads)
+  {
+    this->_threads.reserve(count_threads - 1U);
+    for (auto thread_id = std::size_t{ 1U }; thread_id < count_threads; ++thread_id) {
+      this->_threads.emplace_back([this, thread_id] { this->work(thread_id); });
+    }
+  }
+
+  ReaderPool(ReaderPool&&) = delete;
+  ReaderPool(const ReaderPool&) = delete;
+
+  ~ReaderPool()
+  {
+    {
+      const auto lock = std::lock_guard{ this->_mutex };
+      this->_is_stopped = true;
+    }
+    this->_wakeup.notify_all();
+
+    for (auto& thread : this->_threads) {
+      thread.join();
+    }
+  }
+
+  ReaderPool& operator=(ReaderPool&&) = delete;
+  ReaderPool& operator=(const ReaderPool&) = delete;
+
+  [[nodiscard]] std::size_t count_threads() const noexcept { return this->_threads.size() + 1U; }
+
+  /**
+   * Runs the task on all threads, including the calling thread, and waits until all threads finished.
+   *
+   * @param task Task that is invoked with the id of every thread; must not throw.
+   */
+  void run(const std::function<void(std::size_t)>& task)
+  {
+    {
+      const auto lock = std::lock_guard{ this->_mutex };
+      this->_task = &task;
+      this->_count_pending = this->_threads.size();
+      ++this->_generation;
+    }
+    this->_wakeup.notify_all();
+
+    task(0U);
+
+    auto lock = std::unique_lock{ this->_mutex };
+    this->_finished.wait(lock, [this] { return this->_count_pending == 0U; });
+    this->_task = nullptr;
+  }
+
+private:
+  std::mutex _mutex;
+  std::condition_variable _wakeup;
+  std::condition_variable _finished;
+
+  /// Current task, its generation, and the number of threads that did not finish it, yet.
+  const std::function<void(std::size_t)>* _task{ nullptr };
+  std::uint64_t _generation{ 0U };
+  std::size_t _count_pending{ 0U };
+
+  bool _is_stopped{ false };
+
+  std::vector<std::thread> _threads;
+
+  void work(const std::size_t thread_id)
+  {
+    auto generation = std::uint64_t{ 0U };
+
+    while (true) {
+      const std::function<void(std::size_t)>* task = nullptr;
+      {
+        auto lock = std::unique_lock{ this->_mutex };
+        this->_wakeup.wait(lock, [this, generation] { return this->_is_stopped || this->_generation != generation; });
+        if (this->_is_stopped) {
+          return;
+        }
+
+        generation = this->_generation;
+        task = this->_task;
+      }
+
+      (*task)(thread_id);
+
+      const auto lock = std::lock_guard{ this->_mutex };
+      if (--this->_count_pending == 0U) {
+        this->_finished.notify_one();
+      }
+    }
+  }
+};
+
+perf::MultiCoreEventCounter::MultiCoreEventCounter(perf::MultiCoreEventCounter&&) noexcept = default;
+
+perf::MultiCoreEventCounter::~MultiCoreEventCounter() = default;
+
+perf::MultiCoreEventCounter&
+perf::MultiCoreEventCounter::operator=(perf::MultiCoreEventCounter&&) noexcept = default;
+
+void
+perf::MultiCoreEventCounter::reader_threads(const std::uint16_t count_threads)
+{
+  this->_count_reader_threads = std::max<std::uint16_t>(1U, count_threads);
+}
+
+void
+perf::MultiCoreEventCounter::for_each_cpu(const std::function<void(std::size_t)>& callback)
+{
+  const auto count_cpus = this->_cpu_local_counter.size();
+  const auto count_threads =
+    std::max<std::size_t>(1U, std::min<std::size_t>(this->_count_reader_threads, count_cpus));
+
+  if (count_threads == 1U) {
+    for (auto cpu_index = std::size_t{ 0U }; cpu_index < count_cpus; ++cpu_index) {
+      callback(cpu_index);
+    }
+    return;
+  }
+
+  if (this->_reader_pool == nullptr || this->_reader_pool->count_threads() != count_threads) {
+    this->_reader_pool = std::make_unique<ReaderPool>(count_threads);
+  }
+
+  /// Every thread processes a contiguous range of CPUs. Exceptions are caught per thread and re-thrown in the calling
+  /// thread.
+  const auto cpus_per_thread = (count_cpus + count_threads - 1U) / count_threads;
+  auto exceptions = std::vector<std::exception_ptr>(count_threads);
+  this->_reader_pool->run([&callback, &exceptions, count_cpus, cpus_per_thread](const std::size_t thread_id) {
+    try {
+      const auto begin = std::min(count_cpus, thread_id * cpus_per_thread);
+      const auto end = std::min(count_cpus, begin + cpus_per_thread);
+      for (auto cpu_index = begin; cpu_index < end; ++cpu_index) {
+        callback(cpu_index);
+      }
+    } catch (...) {
+      exceptions[thread_id] = std::current_exception();
+    }
+  });
+
+  for (const auto& exception : exceptions) {
+    if (exception != nullptr) {
+      std::rethrow_exception(exception);
+    }
+  }
+}
+
+void
+perf::MultiCoreEventCounter::open()
+{
+  if (this->_is_opened) {
+    return;
+  }
+
+  /// Opening takes time on machines with many CPUs; the counters are opened by the reader threads.
+  this->for_each_cpu([this](const std::size_t cpu_index) { this->_cpu_local_counter[cpu_index].open(); });
+  this->_is_opened = true;
 }
 
 bool
 perf::MultiCoreEventCounter::start()
 {
-  for (auto& event_counter : this->_cpu_local_counter) {
-    event_counter.start();
+  /// Open all counters first, to enable them near-simultaneously in a separate (and fast) phase afterward.
+  if (!this->_is_opened) {
+    this->open();
+    this->_is_close_on_stop = true;
   }
 
+  this->for_each_cpu([this](const std::size_t cpu_index) { this->_cpu_local_counter[cpu_index].start(); });
+
   return true;
 }
 
 void
 perf::MultiCoreEventCounter::stop()
 {
-  for (auto& event_counter : this->_cpu_local_counter) {
-    event_counter.stop();
+  this->for_each_cpu([this](const std::size_t cpu_index) { this->_cpu_local_counter[cpu_index].stop(); });
+
+  if (this->_is_close_on_stop) {
+    this->close();
   }
-}
\ No newline at end of file
+}
+
+void
+perf::MultiCoreEventCounter::close()
+{
+  this->for_each_cpu([this](const std::size_t cpu_index) { this->_cpu_local_counter[cpu_index].close(); });
+
+  this->_reader_pool.reset();
+  this->_is_opened = false;
+  this->_is_close_on_stop = false;
+}
+
+bool
+perf::MultiCoreEventCounter::live_values(std::vector<double>& hardware_event_values)
+{
+  const auto count_hardware_events = this->count_hardware_events();
+  hardware_event_values.resize(this->_cpu_local_counter.size() * count_hardware_events);
+  this->_cpu_values.resize(this->_cpu_local_counter.size());
+
+  auto is_read = std::atomic<bool>{ true };
+  this->for_each_cpu([this, &hardware_event_values, &is_read, count_hardware_events](const std::size_t cpu_index) {
+    auto& cpu_values = this->_cpu_values[cpu_index];
+    if (!this->_cpu_local_counter[cpu_index].live_values(cpu_values)) {
+      is_read.store(false, std::memory_order_relaxed);
+      return;
+    }
+
+    std::copy(cpu_values.begin(),
+              cpu_values.end(),
+              hardware_event_values.begin() + std::ptrdiff_t(cpu_index * count_hardware_events));
+  });
+
+  return is_read.load(std::memory_order_relaxed);
+}
+
+perf::CounterResult
+perf::MultiCoreEventCounter::live_result(const std::uint64_t normalization)
+{
+  auto hardware_event_values = std::vector<double>{};
+  if (!this->live_values(hardware_event_values)) {
+    throw std::runtime_error{ "Cannot read counters: Counters need to be started before reading live results." };
+  }
+
+  return this->to_result(hardware_event_values, normalization);
+}
+
+std::vector<perf::CounterResult>
+perf::MultiCoreEventCounter::result_per_cpu(const std::uint64_t normalization) const
+{
+  return this->to_result_per_cpu(this->accumulated_values(), normalization);
+}
+
+std::vector<std::pair<std::uint16_t, perf::CounterResult>>
+perf::MultiCoreEventCounter::result_per_socket(const std::uint64_t normalization) const
+{
+  return this->to_result_per_socket(this->accumulated_values(), normalization);
+}
+
+perf::CounterResult
+perf::MultiCoreEventCounter::to_result(const std::vector<double>& hardware_event_values,
+                                       const std::uint64_t normalization) const
+{
+  const auto count_hardware_events = this->count_hardware_events();
+
+  /// Sum up the values of all CPUs by the index of the hardware event.
+  auto aggregated_values = std::vector<double>(count_hardware_events, .0);
+  for (auto cpu_index = std::size_t{ 0U }; cpu_index < this->_cpu_local_counter.size(); ++cpu_index) {
+    const auto* cpu_values = hardware_event_values.data() + cpu_index * count_hardware_events;
+    for (auto index = std::size_t{ 0U }; index < count_hardware_events; ++index) {
+      aggregated_values[index] += cpu_values[index];
+    }
+  }
+
+  for (auto& value : aggregated_values) {
+    value /= double(normalization);
+  }
+
+  return this->_cpu_local_counter.front().to_result(aggregated_values);
+}
+
+std::vector<perf::CounterResult>
+perf::MultiCoreEventCounter::to_result_per_cpu(const std::vector<double>& hardware_event_values,
+                                               const std::uint64_t normalization) const
+{
+  const auto count_hardware_events = this->count_hardware_events();
+
+  auto results = std::vector<CounterResult>{};
+  results.reserve(this->_cpu_local_counter.size());
+
+  auto cpu_values = std::vector<double>(count_hardware_events);
+  for (auto cpu_index = std::size_t{ 0U }; cpu_index < this->_cpu_local_counter.size(); ++cpu_index) {
+    const auto* values = hardware_event_values.data() + cpu_index * count_hardware_events;
+    std::transform(values, values + count_hardware_events, cpu_values.begin(), [normalization](const double value) {
+      return value / double(normalization);
+    });
+    results.push_back(this->_cpu_local_counter[cpu_index].to_result(cpu_values));
+  }
+
+  return results;
+}
+
+std::vector<std::pair<std::uint16_t, perf::CounterResult>>
+perf::MultiCoreEventCounter::to_result_per_socket(const std::vector<double>& hardware_event_values,
+                                                  const std::uint64_t normalization) const
+{
+  const auto count_hardware_events = this->count_hardware_events();
+
+  /// Sum up the values of all CPUs per socket by the index of the hardware event.
+  auto aggregated_values = std::map<std::uint16_t, std::vector<double>>{};
+  for (auto cpu_index = std::size_t{ 0U }; cpu_index < this->_cpu_local_counter.size(); ++cpu_index) {
+    auto& socket_values = aggregated_values[this->_socket_ids[cpu_index]];
+    socket_values.resize(count_hardware_events, .0);
+
+    const auto* cpu_values = hardware_event_values.data() + cpu_index * count_hardware_events;
+    for (auto index = std::size_t{ 0U }; index < count_hardware_events; ++index) {
+      socket_values[index] += cpu_values[index];
+    }
+  }
+
+  auto results = std::vector<std::pair<std::uint16_t, CounterResult>>{};
+  results.reserve(aggregated_values.size());
+  for (auto& [socket_id, socket_values] : aggregated_values) {
+    for (auto& value : socket_values) {
+      value /= double(normalization);
+    }
+    results.emplace_back(socket_id, this->_cpu_local_counter.front().to_result(socket_values));
+  }
+
+  return results;
+}
+
+std::vector<double>
+perf::MultiCoreEventCounter::accumulated_values() const
+{
+  const auto count_hardware_events = this->count_hardware_events();
+
+  auto hardware_event_values = std::vector<double>(this->_cpu_local_counter.size() * count_hardware_events);
+  for (auto cpu_index = std::size_t{ 0U }; cpu_index < this->_cpu_local_counter.size(); ++cpu_index) {
+    MultiEventCounterBase::accumulated_values(this->_cpu_local_counter[cpu_index],
+                                              hardware_event_values.data() + cpu_index * count_hardware_events);
+  }
+
+  return hardware_event_values;
+}
+
+std::uint16_t
+perf::MultiCoreEventCounter::socket_of_cpu(const std::uint16_t cpu_id)
+{
+  auto package_file = std::ifstream{ std::string{ "/sys/devices/system/cpu/cpu" }
+                                       .append(std::to_string(cpu_id))
+                                       .append("/topology/physical_package_id") };
+
+  auto package_id = std::int32_t{ 0 };
+  if (package_file >> package_id && package_id >= 0) {
+    return std::uint16_t(package_id);
+  }
+
+  return 0U;
+}
@@ -0,0 +1,230 @@
+#include <algorithm>
+#include <perfcpp/exporter/perfetto.h>
+#include <type_traits>
+
+perf::exporter::PerfettoExporter::PerfettoExporter(const std::string& file_name, perf::Symbolizer* symbolizer)
+  : _file(file_name)
+  , _symbolizer(symbolizer)
+{
+}
+
+void
+perf::exporter::PerfettoExporter::add(const perf::Sample& sample)
+{
+  const auto context_switch = sample.context_switch();
+  if (!context_switch.has_value()) {
+    this->add_sample(sample);
+    return;
+  }
+
+  const auto time = sample.time();
+  if (!time.has_value()) {
+    return;
+  }
+
+  const auto track_uuid = this->thread_track(sample.process_id(), sample.thread_id());
+
+  /// Switching in begins a "running" slice, switching out ends it; ends without a begin are skipped.
+  if (context_switch->is_in()) {
+    if (!this->_running_threads.insert(track_uuid).second) {
+      return;
+    }
+
+    this->_event.clear();
+    this->_event.varint(9U, PerfettoExporter::TYPE_SLICE_BEGIN).varint(11U, track_uuid).string(23U, "running");
+  } else {
+    if (this->_running_threads.erase(track_uuid) == 0U) {
+      return;
+    }
+
+    this->_event.clear();
+    this->_event.varint(9U, PerfettoExporter::TYPE_SLICE_END).varint(11U, track_uuid);
+    if (context_switch->is_preempt()) {
+      this->annotate("preempted", 1U, false);
+    }
+  }
+
+  this->write_event(time.value());
+}
+
+template<typename S>
+void
+perf::exporter::PerfettoExporter::add_sample(const S& sample)
+{
+  const auto time = sample.time();
+  if (!time.has_value()) {
+    return;
+  }
+
+  const auto track_uuid = this->thread_track(sample.process_id(), sample.thread_id());
+  const auto instruction_pointer = sample.instruction_pointer();
+
+  auto name = std::string_view{ "sample" };
+  auto symbol = std::optional<Symbol>{ std::nullopt };
+  if (this->_symbolizer != nullptr && instruction_pointer.has_value()) {
+    symbol = this->_symbolizer->resolve(sample.process_id().value_or(0U), instruction_pointer.value());
+    if (symbol.has_value()) {
+      name = symbol->name();
+    }
+  }
+
+  this->_event.clear();
+  this->_event.varint(9U, PerfettoExporter::TYPE_INSTANT).varint(11U, track_uuid).string(23U, name);
+
+  if (instruction_pointer.has_value()) {
+    this->annotate("ip", instruction_pointer.value(), true);
+  }
+  if (const auto address = sample.logical_memory_address(); address.has_value()) {
+    this->annotate("address", address.value(), true);
+  }
+  if (const auto address = sample.physical_memory_address(); address.has_value() && address.value() != 0U) {
+    this->annotate("physical_address", address.value(), true);
+  }
+  if (const auto weight = sample.weight(); weight.has_value() && weight->cache_latency() > 0U) {
+    this->annotate("latency", weight->cache_latency(), false);
+  }
+  if (const auto cpu_id = sample.cpu_id(); cpu_id.has_value()) {
+    this->annotate("cpu", cpu_id.value(), false);
+  }
+  if (const auto period = sample.period(); period.has_value()) {
+    this->annotate("period", period.value(), false);
+  }
+
+  this->write_event(time.value());
+}
+
+template void perf::exporter::PerfettoExporter::add_sample<perf::Sample>(const perf::Sample&);
+template void perf::exporter::PerfettoExporter::add_sample<perf::SampleView>(const perf::SampleView&);
+
+void
+perf::exporter::PerfettoExporter::add_counter(const std::string_view name, const std::uint64_t time, const double value)
+{
+  auto iterator = this->_counter_tracks.find(std::string{ name });
+  if (iterator == this->_counter_tracks.end()) {
+    const auto track_uuid = PerfettoExporter::COUNTER_TRACK_PREFIX | this->_counter_tracks.size();
+    iterator = this->_counter_tracks.emplace(std::string{ name }, track_uuid).first;
+
+    auto track_descriptor = ProtobufMessage{};
+    track_descriptor.varint(1U, track_uuid).string(2U, name).message(8U, ProtobufMessage{});
+    this->write_track_descriptor(track_descriptor);
+  }
+
+  this->_event.clear();
+  this->_event.varint(9U, PerfettoExporter::TYPE_COUNTER).varint(11U, iterator->second).float64(44U, value);
+  this->write_event(time);
+}
+
+void
+perf::exporter::PerfettoExporter::add(const std::vector<perf::CounterTimeSeries::Interval>& intervals,
+                                      const std::uint64_t time_offset)
+{
+  for (const auto& interval : intervals) {
+    const auto time = time_offset + std::uint64_t(interval.begin().count());
+    for (const auto& [name, value] : interval.result()) {
+      this->add_counter(name, time, value);
+    }
+  }
+}
+
+perf::exporter::PerfettoExporter::~PerfettoExporter()
+{
+  try {
+    this->close();
+  } catch (...) {
+    /// Destructors must not throw (e.g., if the disk is full); call close() to observe write errors.
+  }
+}
+
+void
+perf::exporter::PerfettoExporter::close()
+{
+  for (const auto track_uuid : this->_running_threads) {
+    this->_event.clear();
+    this->_event.varint(9U, PerfettoExporter::TYPE_SLICE_END).varint(11U, track_uuid);
+    this->write_event(this->_last_time);
+  }
+  this->_running_threads.clear();
+
+  this->_file.close();
+}
+
+std::uint64_t
+perf::exporter::PerfettoExporter::thread_track(const std::optional<std::uint32_t> process_id,
+                                               const std::optional<std::uint32_t> thread_id)
+{
+  if (!thread_id.has_value()) {
+    if (this->_tracks.insert(PerfettoExporter::GLOBAL_TRACK_UUID).second) {
+      auto track_descriptor = ProtobufMessage{};
+      track_descriptor.varint(1U, PerfettoExporter::GLOBAL_TRACK_UUID).string(2U, "samples");
+      this->write_track_descriptor(track_descriptor);
+    }
+
+    return PerfettoExporter::GLOBAL_TRACK_UUID;
+  }
+
+  const auto pid = process_id.value_or(thread_id.value());
+  const auto track_uuid = PerfettoExporter::THREAD_TRACK_PREFIX | thread_id.value();
+  if (this->_tracks.insert(track_uuid).second) {
+    /// The process track groups the threads of the process.
+    if (const auto process_track_uuid = PerfettoExporter::PROCESS_TRACK_PREFIX | pid;
+        this->_tracks.insert(process_track_uuid).second) {
+      auto process = ProtobufMessage{};
+      process.varint(1U, pid);
+
+      auto track_descriptor = ProtobufMessage{};
+      track_descriptor.varint(1U, process_track_uuid).message(3U, process);
+      this->write_track_descriptor(track_descriptor);
+    }
+
+    auto thread = ProtobufMessage{};
+    thread.varint(1U, pid).varint(2U, thread_id.value());
+
+    auto track_descriptor = ProtobufMessage{};
+    track_descriptor.varint(1U, track_uuid).message(4U, thread);
+    this->write_track_descriptor(track_descriptor);
+  }
+
+  return track_uuid;
+}
+
+void
+perf::exporter::PerfettoExporter::annotate(const std::string_view name,
+                                           const std::uint64_t value,
+                                           const bool is_pointer)
+{
+  this->_annotation.clear();
+  this->_annotation.string(10U, name).varint(is_pointer ? 7U : 3U, value);
+  this->_event.message(4U, this->_annotation);
+}
+
+void
+perf::exporter::PerfettoExporter::write_event(const std::uint64_t time)
+{
+  this->_last_time = std::max(this->_last_time, time);
+
+  this->_packet.clear();
+  this->_packet.varint(8U, time).message(11U, this->_event);
+  this->write_packet();
+}
+
+void
+perf::exporter::PerfettoExporter::write_track_descriptor(const perf::exporter::ProtobufMessage& track_descriptor)
+{
+  this->_packet.clear();
+  this->_packet.message(60U, track_descriptor);
+  this->write_packet();
+}
+
+void
+perf::exporter::PerfettoExporter::write_packet()
+{
+  this->_packet.varint(10U, PerfettoExporter::SEQUENCE_ID);
+  if (!this->_is_first_packet_written) {
+    /// SEQ_INCREMENTAL_STATE_CLEARED
+    this->_packet.varint(13U, 1U);
+    this->_is_first_packet_written = true;
+  }
+
+  /// Trace { repeated TracePacket packet = 1; }
+  this->_file.write(1U, this->_packet);
+}
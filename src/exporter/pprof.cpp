@@ -0,0 +1,200 @@
+#include <algorithm>
+#include <chrono>
+#include <linux/perf_event.h>
+#include <perfcpp/exporter/pprof.h>
+#include <type_traits>
+
+perf::exporter::PprofExporter::PprofExporter(const std::string& file_name,
+                                             perf::Symbolizer* symbolizer,
+                                             std::string event_name)
+  : _file(file_name)
+  , _symbolizer(symbolizer)
+  , _event_name(std::move(event_name))
+{
+}
+
+template<typename S>
+void
+perf::exporter::PprofExporter::add_sample(const S& sample)
+{
+  if (this->_is_closed) {
+    return;
+  }
+
+  this->_stack_key.first = sample.process_id().value_or(0U);
+  auto& addresses = this->_stack_key.second;
+  addresses.clear();
+
+  /// Skip context markers (PERF_CONTEXT_KERNEL, PERF_CONTEXT_USER, ...).
+  const auto add_address = [&addresses](const std::uintptr_t address) {
+    if (address < std::uintptr_t(PERF_CONTEXT_MAX)) {
+      addresses.push_back(address);
+    }
+  };
+
+  if constexpr (std::is_same_v<S, SampleView>) {
+    for (const auto address : sample.callchain()) {
+      add_address(std::uintptr_t(address));
+    }
+  } else {
+    if (const auto& callchain = sample.callchain(); callchain.has_value()) {
+      for (const auto address : callchain.value()) {
+        add_address(address);
+      }
+    }
+  }
+
+  /// Without callchain, the profile is flat.
+  if (addresses.empty()) {
+    if (const auto instruction_pointer = sample.instruction_pointer(); instruction_pointer.has_value()) {
+      addresses.push_back(instruction_pointer.value());
+    } else {
+      return;
+    }
+  }
+
+  auto [iterator, _] = this->_stacks.try_emplace(this->_stack_key, Stack{ 0U, 0U });
+  ++iterator->second.count_samples;
+  iterator->second.sum_periods += sample.period().value_or(1U);
+
+  if (const auto time = sample.time(); time.has_value()) {
+    if (this->_last_time == 0U || time.value() < this->_first_time) {
+      this->_first_time = time.value();
+    }
+    this->_last_time = std::max(this->_last_time, time.value());
+  }
+  ++this->_count_samples;
+}
+
+template void perf::exporter::PprofExporter::add_sample<perf::Sample>(const perf::Sample&);
+template void perf::exporter::PprofExporter::add_sample<perf::SampleView>(const perf::SampleView&);
+
+perf::exporter::PprofExporter::~PprofExporter()
+{
+  try {
+    this->close();
+  } catch (...) {
+    /// Destructors must not throw (e.g., if the disk is full); call close() to observe write errors.
+  }
+}
+
+void
+perf::exporter::PprofExporter::close()
+{
+  if (this->_is_closed) {
+    return;
+  }
+  this->_is_closed = true;
+
+  /// The string table starts with the empty string.
+  auto strings = std::vector<std::string>{ std::string{} };
+  auto string_ids = std::unordered_map<std::string, std::uint64_t>{ { std::string{}, 0U } };
+
+  auto value_type = [&strings, &string_ids](const std::string_view type, const std::string_view unit) {
+    auto message = ProtobufMessage{};
+    message.varint(1U, PprofExporter::string_id(strings, string_ids, type))
+      .varint(2U, PprofExporter::string_id(strings, string_ids, unit));
+    return message;
+  };
+
+  /// Profile.sample_type: number of samples and summed periods.
+  this->_file.write(1U, value_type("samples", "count"));
+  this->_file.write(1U, value_type(this->_event_name, "count"));
+
+  /// Profile.sample: one per distinct callchain; locations are created for every distinct address of every process,
+  /// since processes may map different code at the same address.
+  auto location_ids = std::unordered_map<LocationKey, std::uint64_t, LocationHash>{};
+  auto locations = std::vector<LocationKey>{};
+  auto sample = ProtobufMessage{};
+  auto sample_location_ids = std::vector<std::uint64_t>{};
+  for (const auto& [stack_key, stack] : this->_stacks) {
+    const auto& [process_id, addresses] = stack_key;
+
+    sample_location_ids.clear();
+    for (const auto address : addresses) {
+      auto [iterator, is_inserted] =
+        location_ids.try_emplace(LocationKey{ process_id, address }, location_ids.size() + 1U);
+      if (is_inserted) {
+        locations.emplace_back(process_id, address);
+      }
+      sample_location_ids.push_back(iterator->second);
+    }
+
+    sample.clear();
+    sample.packed_varints(1U, sample_location_ids)
+      .packed_varints(2U, std::vector<std::uint64_t>{ stack.count_samples, stack.sum_periods });
+    this->_file.write(2U, sample);
+  }
+
+  /// Profile.location and Profile.function.
+  auto function_ids = std::unordered_map<std::string, std::uint64_t>{};
+  auto location = ProtobufMessage{};
+  auto line = ProtobufMessage{};
+  for (auto location_id = 0U; location_id < locations.size(); ++location_id) {
+    const auto [process_id, address] = locations[location_id];
+
+    location.clear();
+    location.varint(1U, location_id + 1U).varint(3U, address);
+
+    if (this->_symbolizer != nullptr) {
+      if (const auto symbol = this->_symbolizer->resolve(process_id, address); symbol.has_value()) {
+        auto [iterator, is_inserted] =
+          function_ids.try_emplace(std::string{ symbol->name() }, function_ids.size() + 1U);
+        if (is_inserted) {
+          auto function = ProtobufMessage{};
+          function.varint(1U, iterator->second)
+            .varint(2U, PprofExporter::string_id(strings, string_ids, symbol->demangled_name()))
+            .varint(3U, PprofExporter::string_id(strings, string_ids, symbol->name()))
+            .varint(4U, PprofExporter::string_id(strings, string_ids, symbol->module()));
+          this->_file.write(5U, function);
+        }
+
+        line.clear();
+        line.varint(1U, iterator->second);
+        location.message(4U, line);
+      }
+    }
+
+    this->_file.write(4U, location);
+  }
+
+  /// Profile.time_nanos, duration_nanos, period_type, period, and default_sample_type. Perf timestamps follow the
+  /// perf clock (which is neither the monotonic nor the system clock), pprof expects the time since the Unix epoch:
+  /// The start is only written if it can be converted.
+  auto header = ProtobufMessage{};
+  if (this->_last_time > 0U) {
+    if (this->_time_conversion.has_value()) {
+      const auto start_time = this->_time_conversion->to_system_time(this->_first_time);
+      header.varint(
+        9U,
+        std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(start_time.time_since_epoch()).count()));
+    }
+    header.varint(10U, this->_last_time - this->_first_time);
+  }
+  header.message(11U, value_type(this->_event_name, "count")).varint(12U, 1U);
+  header.varint(14U, PprofExporter::string_id(strings, string_ids, this->_event_name));
+  this->_file.append(header);
+
+  /// Profile.string_table
+  auto string_table = ProtobufMessage{};
+  for (const auto& string : strings) {
+    string_table.string(6U, string);
+  }
+  this->_file.append(string_table);
+
+  this->_file.close();
+  this->_stacks.clear();
+}
+
+std::uint64_t
+perf::exporter::PprofExporter::string_id(std::vector<std::string>& strings,
+                                         std::unordered_map<std::string, std::uint64_t>& string_ids,
+                                         const std::string_view string)
+{
+  auto [iterator, is_inserted] = string_ids.try_emplace(std::string{ string }, strings.size());
+  if (is_inserted) {
+    strings.emplace_back(string);
+  }
+
+  return iterator->second;
+}
@@ -0,0 +1,90 @@
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <perfcpp/exporter/protobuf.h>
+#include <stdexcept>
+#include <unistd.h>
+
+perf::exporter::ProtobufFile::ProtobufFile(const std::string& file_name, const std::size_t buffer_size)
+  : _buffer_size(buffer_size)
+{
+  this->_file_descriptor = ::open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (this->_file_descriptor < 0) {
+    throw std::runtime_error{ std::string{ "Cannot create file '" }
+                                .append(file_name)
+                                .append("': ")
+                                .append(std::strerror(errno)) };
+  }
+}
+
+perf::exporter::ProtobufFile::~ProtobufFile()
+{
+  try {
+    this->close();
+  } catch (...) {
+    /// Destructors must not throw (e.g., if the disk is full).
+  }
+}
+
+void
+perf::exporter::ProtobufFile::write(const std::uint32_t field, const perf::exporter::ProtobufMessage& message)
+{
+  const auto size_before = this->_buffer.data().size();
+  this->_buffer.message(field, message);
+  this->_size += this->_buffer.data().size() - size_before;
+
+  if (this->_buffer.data().size() >= this->_buffer_size) {
+    this->flush();
+  }
+}
+
+void
+perf::exporter::ProtobufFile::append(const perf::exporter::ProtobufMessage& message)
+{
+  this->_buffer.append(message);
+  this->_size += message.data().size();
+
+  if (this->_buffer.data().size() >= this->_buffer_size) {
+    this->flush();
+  }
+}
+
+void
+perf::exporter::ProtobufFile::flush()
+{
+  if (this->_file_descriptor < 0) {
+    return;
+  }
+
+  const auto& data = this->_buffer.data();
+  auto written = std::size_t{ 0U };
+  while (written < data.size()) {
+    const auto result = ::write(this->_file_descriptor, data.data() + written, data.size() - written);
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error{ std::string{ "Cannot write to file: " }.append(std::strerror(errno)) };
+    }
+    written += std::size_t(result);
+  }
+
+  this->_buffer.clear();
+}
+
+void
+perf::exporter::ProtobufFile::close()
+{
+  if (this->_file_descriptor > -1) {
+    try {
+      this->flush();
+    } catch (...) {
+      ::close(this->_file_descriptor);
+      this->_file_descriptor = -1;
+      throw;
+    }
+
+    ::close(this->_file_descriptor);
+    this->_file_descriptor = -1;
+  }
+}
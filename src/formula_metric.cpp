@@ -0,0 +1,376 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdlib>
+#include <perfcpp/formula_metric.h>
+#include <stdexcept>
+#include <utility>
+
+/**
+ * Recursive-descent parser for the grammar
+ *    expression := term (('+' | '-') term)*
+ *    term       := factor (('*' | '/') factor)*
+ *    factor     := '-' factor | number | counter | '(' expression ')'
+ * emitting instructions in post-fix order.
+ */
+class perf::FormulaMetric::Parser
+{
+public:
+  explicit Parser(FormulaMetric& metric) noexcept
+    : _metric(metric)
+    , _formula(metric._formula)
+  {
+  }
+  ~Parser() noexcept = default;
+
+  void parse()
+  {
+    this->parse_expression();
+
+    this->skip_whitespace();
+    if (this->_position < this->_formula.size()) {
+      this->throw_error("unexpected character");
+    }
+
+    if (this->_max_depth > MAX_STACK_DEPTH) {
+      this->throw_error("formula is nested too deeply");
+    }
+  }
+
+private:
+  FormulaMetric& _metric;
+  std::string_view _formula;
+  std::size_t _position{ 0U };
+
+  /// Depth of the evaluation stack, tracked to verify that the formula fits into the stack when evaluating.
+  std::size_t _depth{ 0U };
+  std::size_t _max_depth{ 0U };
+
+  /// Nesting of parentheses and negations, bounded to not exceed the (call) stack while parsing.
+  std::size_t _nesting{ 0U };
+
+  [[nodiscard]] static bool is_counter_begin(const char character) noexcept
+  {
+    return std::isalpha(static_cast<unsigned char>(character)) || character == '_';
+  }
+
+  [[nodiscard]] static bool is_counter_character(const char character) noexcept
+  {
+    return std::isalnum(static_cast<unsigned char>(character)) || character == '_' || character == '.' ||
+           character == ':';
+  }
+
+  [[noreturn]] void throw_error(const std::string_view message) const
+  {
+    throw std::runtime_error{ std::string{ "Cannot parse formula '" }
+                                .append(this->_formula)
+                                .append("' of metric '")
+                                .append(this->_metric._name)
+                                .append("' at position ")
+                                .append(std::to_string(this->_position))
+                                .append(": ")
+                                .append(message)
+                                .append(".") };
+  }
+
+  void skip_whitespace() noexcept
+  {
+    while (this->_position < this->_formula.size() &&
+           std::isspace(static_cast<unsigned char>(this->_formula[this->_position]))) {
+      ++this->_position;
+    }
+  }
+
+  [[nodiscard]] std::optional<char> peek() noexcept
+  {
+    this->skip_whitespace();
+    if (this->_position < this->_formula.size()) {
+      return this->_formula[this->_position];
+    }
+
+    return std::nullopt;
+  }
+
+  void emit(const OpCode op_code, const std::uint32_t slot = 0U, const double constant = 0.0)
+  {
+    this->_metric._instructions.push_back(Instruction{ op_code, slot, constant });
+
+    /// Loading a value pushes onto the stack, binary operators pop two values and push one.
+    if (op_code == OpCode::Constant || op_code == OpCode::Counter) {
+      this->_max_depth = std::max(this->_max_depth, ++this->_depth);
+    } else if (op_code != OpCode::Negate) {
+      --this->_depth;
+    }
+  }
+
+  void enter_nesting()
+  {
+    if (++this->_nesting > MAX_STACK_DEPTH) {
+      this->throw_error("formula is nested too deeply");
+    }
+  }
+
+  void parse_expression()
+  {
+    this->parse_term();
+
+    for (auto character = this->peek(); character == '+' || character == '-'; character = this->peek()) {
+      ++this->_position;
+      this->parse_term();
+      this->emit(character == '+' ? OpCode::Add : OpCode::Subtract);
+    }
+  }
+
+  void parse_term()
+  {
+    this->parse_factor();
+
+    for (auto character = this->peek(); character == '*' || character == '/'; character = this->peek()) {
+      ++this->_position;
+      this->parse_factor();
+      this->emit(character == '*' ? OpCode::Multiply : OpCode::Divide);
+    }
+  }
+
+  void parse_factor()
+  {
+    const auto character = this->peek();
+    if (!character.has_value()) {
+      this->throw_error("unexpected end");
+    }
+
+    if (character == '-') {
+      ++this->_position;
+      this->enter_nesting();
+      this->parse_factor();
+      --this->_nesting;
+      this->emit(OpCode::Negate);
+    } else if (character == '(') {
+      ++this->_position;
+      this->enter_nesting();
+      this->parse_expression();
+      if (this->peek() != ')') {
+        this->throw_error("expected ')'");
+      }
+      --this->_nesting;
+      ++this->_position;
+    } else if (std::isdigit(static_cast<unsigned char>(character.value())) || character == '.') {
+      this->parse_number();
+    } else if (is_counter_begin(character.value())) {
+      this->parse_counter();
+    } else {
+      this->throw_error("unexpected character");
+    }
+  }
+
+  void parse_number()
+  {
+    /// The formula is not null-terminated; copy the digits for strtod.
+    auto end = this->_position;
+    while (end < this->_formula.size() &&
+           (std::isalnum(static_cast<unsigned char>(this->_formula[end])) || this->_formula[end] == '.' ||
+            ((this->_formula[end] == '+' || this->_formula[end] == '-') &&
+             (this->_formula[end - 1U] == 'e' || this->_formula[end - 1U] == 'E')))) {
+      ++end;
+    }
+
+    const auto number = std::string{ this->_formula.substr(this->_position, end - this->_position) };
+    char* number_end = nullptr;
+    const auto value = std::strtod(number.c_str(), &number_end);
+    if (number_end != number.c_str() + number.size()) {
+      this->throw_error("invalid number");
+    }
+
+    this->_position = end;
+    this->emit(OpCode::Constant, 0U, value);
+  }
+
+  void parse_counter()
+  {
+    /// Hyphens are part of the name if followed by another character of a name (e.g., "L1-dcache-loads").
+    auto end = this->_position + 1U;
+    while (end < this->_formula.size() &&
+           (is_counter_character(this->_formula[end]) ||
+            (this->_formula[end] == '-' && end + 1U < this->_formula.size() &&
+             is_counter_character(this->_formula[end + 1U])))) {
+      ++end;
+    }
+
+    const auto name = this->_formula.substr(this->_position, end - this->_position);
+
+    auto& counter_names = this->_metric._counter_names;
+    auto slot = std::size_t(std::distance(counter_names.begin(),
+                                          std::find(counter_names.begin(), counter_names.end(), name)));
+    if (slot == counter_names.size()) {
+      if (counter_names.size() == MAX_COUNTERS) {
+        this->throw_error("too many counters");
+      }
+      counter_names.emplace_back(name);
+    }
+
+    this->_position = end;
+    this->emit(OpCode::Counter, std::uint32_t(slot));
+  }
+};
+
+perf::FormulaMetric::FormulaMetric(std::string name, const std::string_view formula)
+  : _name(std::move(name))
+  , _formula(formula)
+{
+  Parser{ *this }.parse();
+
+  for (auto& index : this->_resolved_indices) {
+    index.store(UNRESOLVED, std::memory_order_relaxed);
+  }
+}
+
+std::optional<double>
+perf::FormulaMetric::calculate(const CounterResult& result) const
+{
+  auto values = std::array<double, MAX_COUNTERS>{};
+  for (auto slot = 0U; slot < this->_counter_names.size(); ++slot) {
+    const auto& name = this->_counter_names[slot];
+
+    /// Results of the same event counter share their layout: verify the resolved position before looking up the name.
+    auto index = this->_resolved_indices[slot].load(std::memory_order_relaxed);
+    if (index >= result.size() || result[index].first != name) {
+      if (const auto resolved_index = result.index(name); resolved_index.has_value()) {
+        index = resolved_index.value();
+        this->_resolved_indices[slot].store(index, std::memory_order_relaxed);
+      } else {
+        return std::nullopt;
+      }
+    }
+
+    values[slot] = result[index].second;
+  }
+
+  auto stack = std::array<double, MAX_STACK_DEPTH>{};
+  auto top = std::size_t{ 0U };
+  for (const auto& instruction : this->_instructions) {
+    switch (instruction.op_code) {
+      case OpCode::Constant:
+        stack[top++] = instruction.constant;
+        break;
+      case OpCode::Counter:
+        stack[top++] = values[instruction.slot];
+        break;
+      case OpCode::Negate:
+        stack[top - 1U] = -stack[top - 1U];
+        break;
+      case OpCode::Add:
+        --top;
+        stack[top - 1U] += stack[top];
+        break;
+      case OpCode::Subtract:
+        --top;
+        stack[top - 1U] -= stack[top];
+        break;
+      case OpCode::Multiply:
+        --top;
+        stack[top - 1U] *= stack[top];
+        break;
+      case OpCode::Divide:
+        --top;
+        stack[top - 1U] /= stack[top];
+        break;
+    }
+  }
+
+  return stack[0U];
+}
+
+std::vector<double>
+perf::FormulaMetric::evaluate(const std::vector<std::vector<double>>& columns, const std::size_t count_rows) const
+{
+  auto result = std::vector<double>(count_rows);
+
+  /// One block of rows per stack entry.
+  auto stack = std::vector<std::array<double, BLOCK_SIZE>>(MAX_STACK_DEPTH);
+
+  for (auto block_begin = std::size_t{ 0U }; block_begin < count_rows; block_begin += BLOCK_SIZE) {
+    const auto block_size = std::min(BLOCK_SIZE, count_rows - block_begin);
+
+    auto top = std::size_t{ 0U };
+    for (const auto& instruction : this->_instructions) {
+      switch (instruction.op_code) {
+        case OpCode::Constant:
+          std::fill_n(stack[top++].begin(), block_size, instruction.constant);
+          break;
+        case OpCode::Counter:
+          std::copy_n(columns[instruction.slot].begin() + std::int64_t(block_begin), block_size, stack[top++].begin());
+          break;
+        case OpCode::Negate: {
+          auto& operand = stack[top - 1U];
+          for (auto i = 0U; i < block_size; ++i) {
+            operand[i] = -operand[i];
+          }
+          break;
+        }
+        case OpCode::Add: {
+          auto& left = stack[top - 2U];
+          const auto& right = stack[--top];
+          for (auto i = 0U; i < block_size; ++i) {
+            left[i] += right[i];
+          }
+          break;
+        }
+        case OpCode::Subtract: {
+          auto& left = stack[top - 2U];
+          const auto& right = stack[--top];
+          for (auto i = 0U; i < block_size; ++i) {
+            left[i] -= right[i];
+          }
+          break;
+        }
+        case OpCode::Multiply: {
+          auto& left = stack[top - 2U];
+          const auto& right = stack[--top];
+          for (auto i = 0U; i < block_size; ++i) {
+            left[i] *= right[i];
+          }
+          break;
+        }
+        case OpCode::Divide: {
+          auto& left = stack[top - 2U];
+          const auto& right = stack[--top];
+          for (auto i = 0U; i < block_size; ++i) {
+            left[i] /= right[i];
+          }
+          break;
+        }
+      }
+    }
+
+    std::copy_n(stack[0U].begin(), block_size, result.begin() + std::int64_t(block_begin));
+  }
+
+  return result;
+}
+
+bool
+perf::FormulaMetric::gather(const CounterResult& result,
+                            std::vector<std::optional<std::size_t>>& slots,
+                            std::vector<std::vector<double>>& columns) const
+{
+  auto is_complete = true;
+
+  for (auto slot = 0U; slot < this->_counter_names.size(); ++slot) {
+    const auto& name = this->_counter_names[slot];
+
+    /// Results of the same event counter share their layout: verify the resolved position before looking up the name.
+    auto& index = slots[slot];
+    if (!index.has_value() || index.value() >= result.size() || result[index.value()].first != name) {
+      index = result.index(name);
+    }
+
+    if (index.has_value()) {
+      columns[slot].push_back(result[index.value()].second);
+    } else {
+      columns[slot].push_back(0.0);
+      is_complete = false;
+    }
+  }
+
+  return is_complete;
+}
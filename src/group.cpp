@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cerrno>
 #include <iostream>
 #include <perfcpp/group.h>
@@ -24,6 +25,7 @@ perf::Group::open(const perf::Config config)
                  group_leader_file_descriptor,
                  config.cpu_id(),
                  config.process_id(),
+                 config.cgroup_file_descriptor(),
                  config.is_include_child_threads(),
                  config.is_include_kernel(),
                  config.is_include_user(),
@@ -36,8 +38,13 @@ perf::Group::open(const perf::Config config)
                  /* user_registers */ std::nullopt,
                  /* kernel_registers */ std::nullopt,
                  /* max_callstack */ std::nullopt,
+                 /* is_exclude_callchain_kernel */ false,
+                 /* is_exclude_callchain_user */ false,
                  /* is_include_context_switch */ false,
-                 /* is_include_cgroup */ false);
+                 /* is_include_cgroup */ false,
+                 /* is_include_mmap */ false,
+                 /* wakeup_events */ std::nullopt,
+                 /* wakeup_watermark */ std::nullopt);
 
     /// Set the group leader file descriptor.
     if (is_group_leader) {
@@ -45,6 +52,18 @@ perf::Group::open(const perf::Config config)
     }
   }
 
+  this->_accumulated_values.fill(.0);
+  this->_is_enabled = false;
+
+  /// Reading from user-level is only possible if the counters monitor the calling thread.
+  this->_is_user_level_read = config.is_user_level_read() && config.process_id() == 0 && !config.cpu_id().has_value() &&
+                              !config.is_include_child_threads();
+  if (this->_is_user_level_read) {
+    for (auto& counter : this->_members) {
+      this->_is_user_level_read &= counter.map_user_level_page();
+    }
+  }
+
   /// If we cannot open any counter, we will throw an exception.
   return true;
 }
@@ -55,6 +74,8 @@ perf::Group::close()
   for (auto& counter : this->_members) {
     counter.close();
   }
+
+  this->_is_enabled = false;
 }
 
 bool
@@ -64,8 +85,11 @@ perf::Group::start()
     throw std::runtime_error{ "Cannot start an empty group." };
   }
 
-  /// Enable the counters.
-  this->enable();
+  /// Enable the counters. Counters read from user-level stay enabled, since reading does not need the kernel.
+  if (!this->_is_user_level_read || !this->_is_enabled) {
+    this->enable();
+    this->_is_enabled = true;
+  }
 
   /// Read the counter values at start time.
   return this->read(this->_start_value);
@@ -92,11 +116,18 @@ perf::Group::stop()
   const auto is_read_successful = this->read(this->_end_value);
 
   /// Disable counter group.
-  this->disable();
+  if (!this->_is_user_level_read) {
+    this->disable();
+    this->_is_enabled = false;
+  }
 
   /// Calculate multiplexing correction.
-  this->_multiplexing_correction = double(this->_end_value.time_enabled - this->_start_value.time_enabled) /
-                                   double(this->_end_value.time_running - this->_start_value.time_running);
+  this->_multiplexing_correction = Group::multiplexing_correction(this->_start_value, this->_end_value);
+
+  /// Accumulate the results of this interval.
+  for (auto index = 0U; index < this->_members.size(); ++index) {
+    this->_accumulated_values[index] += this->get(index);
+  }
 
   return is_read_successful;
 }
@@ -112,6 +143,11 @@ perf::Group::disable() const
 bool
 perf::Group::read(CounterReadFormat<MAX_MEMBERS>& value) const
 {
+  /// Try to read the counters from user-level first; fall back to the system call if that is not possible.
+  if (this->_is_user_level_read && this->read_user_level(value)) {
+    return true;
+  }
+
   const auto leader_file_descriptor = static_cast<std::int32_t>(this->leader_file_descriptor());
 
   const auto read_size = ::read(leader_file_descriptor, &value, sizeof(std::remove_reference<decltype(value)>::type));
@@ -119,6 +155,37 @@ perf::Group::read(CounterReadFormat<MAX_MEMBERS>& value) const
   return read_size > 0ULL;
 }
 
+bool
+perf::Group::read_user_level(CounterReadFormat<MAX_MEMBERS>& value) const noexcept
+{
+  auto counter_value = CounterReadFormat<1U>{};
+
+  /// Top-down metric events are derived from the PERF_METRICS register by the kernel and cannot be read via rdpmc.
+  if (std::any_of(this->_members.begin(), this->_members.end(), [](const auto& member) {
+        return member.is_intel_topdown_metric();
+      })) {
+    return false;
+  }
+
+  for (auto member_id = 0U; member_id < this->_members.size(); ++member_id) {
+    if (!this->_members[member_id].read_user_level(counter_value)) {
+      return false;
+    }
+
+    /// All members of a group are scheduled together; we use the times of the group leader.
+    if (member_id == 0U) {
+      value.time_enabled = counter_value.time_enabled;
+      value.time_running = counter_value.time_running;
+    }
+
+    value.values[member_id] = { counter_value.values[0U].value, counter_value.values[0U].id };
+  }
+
+  value.count_members = this->_members.size();
+
+  return true;
+}
+
 bool
 perf::Group::add(perf::CounterConfig counter)
 {
@@ -128,20 +195,50 @@ perf::Group::add(perf::CounterConfig counter)
 
 double
 perf::Group::get(const std::size_t index) const
+{
+  return this->get(index, this->_start_value, this->_end_value, this->_multiplexing_correction);
+}
+
+double
+perf::Group::get(const std::size_t index,
+                 const CounterReadFormat<MAX_MEMBERS>& start_value,
+                 const CounterReadFormat<MAX_MEMBERS>& end_value) const
+{
+  return this->get(index, start_value, end_value, Group::multiplexing_correction(start_value, end_value));
+}
+
+double
+perf::Group::multiplexing_correction(const CounterReadFormat<MAX_MEMBERS>& start_value,
+                                     const CounterReadFormat<MAX_MEMBERS>& end_value) noexcept
+{
+  /// If the counters were not scheduled at all, there is nothing to correct.
+  if (end_value.time_running > start_value.time_running) {
+    return double(end_value.time_enabled - start_value.time_enabled) /
+           double(end_value.time_running - start_value.time_running);
+  }
+
+  return .0;
+}
+
+double
+perf::Group::get(const std::size_t index,
+                 const CounterReadFormat<MAX_MEMBERS>& start_value,
+                 const CounterReadFormat<MAX_MEMBERS>& end_value,
+                 const double multiplexing_correction) const
 {
   if (index < this->_members.size()) {
     const auto& counter = this->_members[index];
 
     /// Read start and end values for the requested counter.
-    const auto counter_start_value = Group::value_for_id(this->_start_value, counter.id());
-    const auto counter_end_value = Group::value_for_id(this->_end_value, counter.id());
+    const auto counter_start_value = Group::value_for_id(start_value, counter.id());
+    const auto counter_end_value = Group::value_for_id(end_value, counter.id());
 
     /// Correct and return the result, if the counter was found.
     if (counter_start_value.has_value() && counter_end_value.has_value()) {
       const auto result = double(counter_end_value.value() - counter_start_value.value());
 
       /// Fall back to zero, of the counter value is 0 (or lower).
-      return std::max(.0, result) * this->_multiplexing_correction;
+      return std::max(.0, result) * multiplexing_correction;
     }
   }
 
@@ -2,6 +2,7 @@
 #include <fstream>
 #include <perfcpp/hardware_info.h>
 #include <sstream>
+#include <utility>
 
 std::optional<std::uint64_t>
 perf::HardwareInfo::intel_pebs_mem_loads_aux_event_id()
@@ -33,6 +34,70 @@ perf::HardwareInfo::intel_pebs_mem_stores_event_id()
   return std::nullopt;
 }
 
+std::optional<std::uint8_t>
+perf::HardwareInfo::count_general_purpose_counters() noexcept
+{
+  std::optional<std::uint8_t> count_counters{ std::nullopt };
+
+#if defined(__x86_64__) || defined(__i386__)
+  std::uint32_t eax, ebx, ecx, edx;
+
+  if (HardwareInfo::is_intel()) {
+    /// Architectural performance monitoring leaf: EAX[15:8] holds the number of general-purpose counters.
+    if (__get_cpuid_count(0xA, 0, &eax, &ebx, &ecx, &edx)) {
+      count_counters = std::uint8_t((eax >> 8U) & 0xFFU);
+    }
+  } else if (HardwareInfo::is_amd()) {
+    /// PerfMonV2 reports the number of core counters in EBX[3:0] of leaf 0x80000022.
+    if (__get_cpuid_count(0x80000000, 0, &eax, &ebx, &ecx, &edx) && eax >= 0x80000022 &&
+        __get_cpuid_count(0x80000022, 0, &eax, &ebx, &ecx, &edx) && (ebx & 0xFU) > 0U) {
+      count_counters = std::uint8_t(ebx & 0xFU);
+    } else if (__get_cpuid_count(0x80000001, 0, &eax, &ebx, &ecx, &edx)) {
+      /// Processors with core performance counter extensions (PerfCtrExtCore) provide six counters, others four.
+      count_counters = std::uint8_t(static_cast<bool>(ecx & (std::uint32_t(1U) << 23U)) ? 6U : 4U);
+    }
+  }
+#endif
+
+  /// Virtual machines may report zero counters if the PMU is not virtualized.
+  if (count_counters.has_value() && count_counters.value() == 0U) {
+    return std::nullopt;
+  }
+
+  return count_counters;
+}
+
+std::uint8_t
+perf::HardwareInfo::count_fixed_counters() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+  if (HardwareInfo::is_intel()) {
+    std::uint32_t eax, ebx, ecx, edx;
+
+    /// Fixed counters are reported from version 2 (EAX[7:0]) in EDX[4:0].
+    if (__get_cpuid_count(0xA, 0, &eax, &ebx, &ecx, &edx) && (eax & 0xFFU) > 1U) {
+      return std::uint8_t(edx & 0x1FU);
+    }
+  }
+#endif
+
+  return 0U;
+}
+
+bool
+perf::HardwareInfo::is_nmi_watchdog_enabled()
+{
+  auto nmi_watchdog_stream = std::ifstream{ "/proc/sys/kernel/nmi_watchdog" };
+  if (nmi_watchdog_stream.is_open()) {
+    auto is_enabled = 0;
+    if (nmi_watchdog_stream >> is_enabled) {
+      return is_enabled != 0;
+    }
+  }
+
+  return false;
+}
+
 std::optional<std::uint32_t>
 perf::HardwareInfo::amd_ibs_op_type()
 {
@@ -53,6 +118,68 @@ perf::HardwareInfo::amd_ibs_fetch_type()
   return std::nullopt;
 }
 
+std::optional<std::uint32_t>
+perf::HardwareInfo::arm_spe_type()
+{
+  return HardwareInfo::parse_type_from_file("/sys/bus/event_source/devices/arm_spe_0/type");
+}
+
+std::optional<std::uint32_t>
+perf::HardwareInfo::intel_pt_type()
+{
+  return HardwareInfo::parse_type_from_file("/sys/bus/event_source/devices/intel_pt/type");
+}
+
+std::optional<std::uint32_t>
+perf::HardwareInfo::intel_hybrid_core_type()
+{
+  if (HardwareInfo::is_intel()) {
+    return HardwareInfo::parse_type_from_file("/sys/bus/event_source/devices/cpu_core/type");
+  }
+
+  return std::nullopt;
+}
+
+std::optional<std::uint64_t>
+perf::HardwareInfo::intel_topdown_event_id(const std::string_view event_name)
+{
+  if (HardwareInfo::is_intel()) {
+    /// Hybrid processors expose the top-down events only on the PMU of the performance cores.
+    const auto* pmu_name = HardwareInfo::intel_hybrid_core_type().has_value() ? "cpu_core" : "cpu";
+    auto path = std::string{ "/sys/bus/event_source/devices/" }.append(pmu_name).append("/events/").append(event_name);
+    return HardwareInfo::parse_event_umask_from_file(std::move(path));
+  }
+
+  return std::nullopt;
+}
+
+std::optional<std::uint8_t>
+perf::HardwareInfo::amd_dispatch_width() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+  if (HardwareInfo::is_amd()) {
+    std::uint32_t eax, ebx, ecx, edx;
+    if (__get_cpuid(0x1, &eax, &ebx, &ecx, &edx)) {
+      const auto base_family = (eax >> 8U) & 0xFU;
+      const auto family = base_family == 0xFU ? base_family + ((eax >> 20U) & 0xFFU) : base_family;
+      const auto model = ((eax >> 4U) & 0xFU) | (((eax >> 16U) & 0xFU) << 4U);
+
+      /// Zen 4 (family 19h, models 10h-1Fh, 60h-7Fh, A0h-AFh) dispatches six, Zen 5 (family 1Ah) eight ops per cycle.
+      if (family == 0x19U && ((model >= 0x10U && model <= 0x1FU) || (model >= 0x60U && model <= 0x7FU) ||
+                              (model >= 0xA0U && model <= 0xAFU))) {
+        return 6U;
+      }
+
+      if (family == 0x1AU) {
+        return 8U;
+      }
+    }
+  }
+#endif
+
+  return std::nullopt;
+}
+
 std::optional<std::uint32_t>
 perf::HardwareInfo::parse_type_from_file(std::string&& path)
 {
@@ -117,7 +244,7 @@ perf::HardwareInfo::parse_event_umask_from_file(std::string&& path)
 
       /// Combine event and umask to a single event id.
       if (event.has_value() && umask.has_value()) {
-        return std::stoull(/* combine <umask><event> */ umask.value().append(event.value()), nullptr, 16);
+        return std::stoull(event.value(), nullptr, 16) | (std::stoull(umask.value(), nullptr, 16) << 8U);
       }
     }
   }
@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <iterator>
+#include <mutex>
+#include <perfcpp/marker.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * Rings of all threads that recorded markers and were not reclaimed, yet; timelines share the ownership of the rings
+ * while reading them.
+ */
+class perf::Marker::Registry
+{
+public:
+  std::mutex mutex;
+  std::vector<std::shared_ptr<Ring>> rings;
+  std::uint64_t next_ring_id{ 0U };
+};
+
+/**
+ * Owner of the ring of a thread (as thread-local object), retiring the ring when the thread exits.
+ */
+class perf::Marker::RingOwner
+{
+public:
+  explicit RingOwner(Ring* ring) noexcept
+    : _ring(ring)
+  {
+  }
+  RingOwner(RingOwner&&) = delete;
+  RingOwner(const RingOwner&) = delete;
+
+  ~RingOwner()
+  {
+    _ring->_is_retired.store(true, std::memory_order_release);
+
+    /// Markers recorded after the owner was destroyed (e.g., by destructors of other thread-local objects) are dropped,
+    /// since the ring may be reclaimed at any time.
+    _thread_ring = nullptr;
+    _is_exited = true;
+  }
+
+  RingOwner& operator=(RingOwner&&) = delete;
+  RingOwner& operator=(const RingOwner&) = delete;
+
+  /// Flag that the thread is exiting (and its ring was retired).
+  static inline thread_local bool _is_exited{ false };
+
+private:
+  Ring* _ring;
+};
+
+perf::Marker::Registry&
+perf::Marker::registry()
+{
+  static auto registry = Registry{};
+  return registry;
+}
+
+perf::Marker::Ring::Ring(const std::uint64_t id, const std::uint32_t thread_id)
+  : _id(id)
+  , _thread_id(thread_id)
+  , _entries(std::make_unique<Entry[]>(RING_CAPACITY))
+{
+}
+
+bool
+perf::Marker::Ring::read(const std::uint64_t position, std::uint64_t& cycles, std::uint64_t& region_id) const noexcept
+{
+  const auto& entry = this->_entries[position & (RING_CAPACITY - 1U)];
+
+  const auto sequence = entry.sequence.load(std::memory_order_acquire);
+  if (sequence != position + 1U) {
+    return false;
+  }
+
+  cycles = entry.cycles.load(std::memory_order_relaxed);
+  region_id = entry.region_id.load(std::memory_order_relaxed);
+
+  /// The entry was overwritten while reading, if the sequence changed.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return entry.sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+perf::Marker::Ring*
+perf::Marker::register_thread()
+{
+  if (RingOwner::_is_exited) {
+    return nullptr;
+  }
+
+  auto* ring = static_cast<Ring*>(nullptr);
+  {
+    auto& registry = Marker::registry();
+    const auto lock = std::lock_guard{ registry.mutex };
+
+    ring = registry.rings
+             .emplace_back(std::make_shared<Ring>(registry.next_ring_id++,
+                                                  static_cast<std::uint32_t>(::syscall(SYS_gettid))))
+             .get();
+  }
+
+  /// The owner is destroyed when the thread exits.
+  static thread_local auto owner = RingOwner{ ring };
+
+  return ring;
+}
+
+std::vector<std::shared_ptr<const perf::Marker::Ring>>
+perf::Marker::rings()
+{
+  auto& registry = Marker::registry();
+  const auto lock = std::lock_guard{ registry.mutex };
+
+  return { registry.rings.begin(), registry.rings.end() };
+}
+
+void
+perf::Marker::reclaim(const std::uint64_t ring_id)
+{
+  auto& registry = Marker::registry();
+  const auto lock = std::lock_guard{ registry.mutex };
+
+  registry.rings.erase(std::remove_if(registry.rings.begin(),
+                                      registry.rings.end(),
+                                      [ring_id](const auto& ring) { return ring->id() == ring_id; }),
+                       registry.rings.end());
+}
+
+void
+perf::MarkerTimeline::update()
+{
+  const auto rings = Marker::rings();
+
+  /// Forget the read positions of rings that were reclaimed (e.g., by another timeline).
+  for (auto iterator = this->_read_positions.begin(); iterator != this->_read_positions.end();) {
+    const auto is_registered = std::any_of(
+      rings.begin(), rings.end(), [ring_id = iterator->first](const auto& ring) { return ring->id() == ring_id; });
+    iterator = is_registered ? std::next(iterator) : this->_read_positions.erase(iterator);
+  }
+
+  for (const auto& ring_pointer : rings) {
+    const auto& ring = *ring_pointer;
+    auto& read_position = this->_read_positions[ring.id()];
+
+    /// The owning thread does not push markers after retiring; all markers are read if retired before reading the head.
+    const auto is_retired = ring.is_retired();
+    const auto head = ring.head();
+
+    /// Markers that were overwritten since the last update are lost.
+    if (head - read_position > Marker::RING_CAPACITY) {
+      this->_count_lost += head - read_position - Marker::RING_CAPACITY;
+      read_position = head - Marker::RING_CAPACITY;
+    }
+
+    auto& transitions = this->_transitions[ring.thread_id()];
+    const auto count_transitions = transitions.size();
+    for (; read_position < head; ++read_position) {
+      auto cycles = std::uint64_t{ 0U };
+      auto region_id = std::uint64_t{ 0U };
+      if (!ring.read(read_position, cycles, region_id)) {
+        ++this->_count_lost;
+        continue;
+      }
+
+      transitions.push_back(Transition{ this->_time_conversion.to_perf_time(cycles), region_id });
+    }
+
+    /// Rings of different threads share the transitions if the kernel reused the thread id; keep them ordered by time.
+    const auto middle = transitions.begin() + std::ptrdiff_t(count_transitions);
+    if (middle != transitions.begin() && middle != transitions.end() && std::prev(middle)->time > middle->time) {
+      std::inplace_merge(transitions.begin(), middle, transitions.end(), [](const auto& left, const auto& right) {
+        return left.time < right.time;
+      });
+    }
+
+    /// Free the rings of exited threads once all their markers were read.
+    if (is_retired) {
+      Marker::reclaim(ring.id());
+      this->_read_positions.erase(ring.id());
+    }
+  }
+}
+
+void
+perf::MarkerTimeline::prune(const std::uint64_t time)
+{
+  for (auto& [thread_id, transitions] : this->_transitions) {
+    /// Keep the latest transition before the time, which defines the region active at the time.
+    const auto iterator = std::upper_bound(
+      transitions.begin(), transitions.end(), time, [](const auto value, const Transition& transition) {
+        return value < transition.time;
+      });
+    if (iterator != transitions.begin()) {
+      transitions.erase(transitions.begin(), std::prev(iterator));
+    }
+  }
+}
+
+std::optional<std::uint64_t>
+perf::MarkerTimeline::region(const std::uint32_t thread_id, const std::uint64_t time) const
+{
+  const auto transitions_iterator = this->_transitions.find(thread_id);
+  if (transitions_iterator == this->_transitions.end()) {
+    return std::nullopt;
+  }
+
+  const auto& transitions = transitions_iterator->second;
+  const auto iterator =
+    std::upper_bound(transitions.begin(), transitions.end(), time, [](const auto value, const Transition& transition) {
+      return value < transition.time;
+    });
+  if (iterator == transitions.begin()) {
+    return std::nullopt;
+  }
+
+  const auto region_id = std::prev(iterator)->region_id;
+  if (region_id == Marker::NO_REGION) {
+    return std::nullopt;
+  }
+
+  return region_id;
+}
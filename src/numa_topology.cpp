@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <dirent.h>
+#include <fstream>
+#include <iterator>
+#include <perfcpp/numa_topology.h>
+#include <sstream>
+#include <string_view>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+perf::NumaTopology::NumaTopology()
+{
+  auto online_file = std::ifstream{ "/sys/devices/system/node/online" };
+  auto online_nodes = std::string{};
+  std::getline(online_file, online_nodes);
+  const auto node_ids = NumaTopology::parse_cpu_list(online_nodes);
+
+  /// Without NUMA information, all CPUs belong to a single node.
+  if (node_ids.empty()) {
+    this->_cpu_ids.emplace_back();
+    for (auto cpu_id = 0U; cpu_id < std::max(1U, std::thread::hardware_concurrency()); ++cpu_id) {
+      this->_cpu_ids.front().push_back(std::uint16_t(cpu_id));
+      this->_node_of_cpu.push_back(0U);
+    }
+
+    return;
+  }
+
+  this->_cpu_ids.resize(std::size_t(*std::max_element(node_ids.begin(), node_ids.end())) + 1U);
+
+  /// Size of the memory blocks (hexadecimal, without prefix).
+  auto block_size = std::uint64_t{ 0U };
+  auto block_size_file = std::ifstream{ "/sys/devices/system/memory/block_size_bytes" };
+  block_size_file >> std::hex >> block_size;
+
+  for (const auto node : node_ids) {
+    const auto node_path = std::string{ "/sys/devices/system/node/node" }.append(std::to_string(node));
+
+    auto cpu_list_file = std::ifstream{ node_path + "/cpulist" };
+    auto cpu_list = std::string{};
+    std::getline(cpu_list_file, cpu_list);
+
+    this->_cpu_ids[node] = NumaTopology::parse_cpu_list(cpu_list);
+    for (const auto cpu_id : this->_cpu_ids[node]) {
+      if (cpu_id >= this->_node_of_cpu.size()) {
+        this->_node_of_cpu.resize(std::size_t(cpu_id) + 1U, NO_NODE);
+      }
+      this->_node_of_cpu[cpu_id] = node;
+    }
+
+    /// Every "memoryN" entry of the node is the N-th memory block.
+    if (block_size == 0U) {
+      continue;
+    }
+
+    if (auto* directory = ::opendir(node_path.c_str()); directory != nullptr) {
+      while (const auto* entry = ::readdir(directory)) {
+        const auto name = std::string_view{ entry->d_name };
+        if (name.size() > 6U && name.substr(0U, 6U) == "memory" &&
+            std::all_of(name.begin() + 6, name.end(), [](const char c) { return c >= '0' && c <= '9'; })) {
+          const auto block_id = std::stoull(std::string{ name.substr(6U) });
+          this->_memory_ranges.push_back(MemoryRange{ block_id * block_size, (block_id + 1U) * block_size, node });
+        }
+      }
+      ::closedir(directory);
+    }
+  }
+
+  /// Sort the blocks and merge adjacent blocks of the same node.
+  std::sort(this->_memory_ranges.begin(), this->_memory_ranges.end(), [](const auto& left, const auto& right) {
+    return left.begin < right.begin;
+  });
+
+  auto merged_ranges = std::vector<MemoryRange>{};
+  for (const auto& range : this->_memory_ranges) {
+    if (!merged_ranges.empty() && merged_ranges.back().end == range.begin && merged_ranges.back().node == range.node) {
+      merged_ranges.back().end = range.end;
+    } else {
+      merged_ranges.push_back(range);
+    }
+  }
+  this->_memory_ranges = std::move(merged_ranges);
+}
+
+const std::vector<std::uint16_t>&
+perf::NumaTopology::cpus(const std::uint16_t node) const noexcept
+{
+  static const auto no_cpus = std::vector<std::uint16_t>{};
+  return node < this->_cpu_ids.size() ? this->_cpu_ids[node] : no_cpus;
+}
+
+std::optional<std::uint16_t>
+perf::NumaTopology::node_of_physical_address(const std::uint64_t physical_address) const noexcept
+{
+  if (this->_memory_ranges.empty()) {
+    return this->_cpu_ids.size() == 1U ? std::make_optional(std::uint16_t{ 0U }) : std::nullopt;
+  }
+
+  /// Find the last range that begins at or before the address.
+  const auto iterator = std::upper_bound(
+    this->_memory_ranges.begin(),
+    this->_memory_ranges.end(),
+    physical_address,
+    [](const std::uint64_t address, const MemoryRange& range) { return address < range.begin; });
+
+  if (iterator != this->_memory_ranges.begin() && physical_address < std::prev(iterator)->end) {
+    return std::prev(iterator)->node;
+  }
+
+  return std::nullopt;
+}
+
+std::vector<std::optional<std::uint16_t>>
+perf::NumaTopology::nodes_of_logical_addresses(const std::uint32_t process_id,
+                                               const std::vector<std::uintptr_t>& logical_addresses)
+{
+  auto nodes = std::vector<std::optional<std::uint16_t>>(logical_addresses.size(), std::nullopt);
+  if (logical_addresses.empty()) {
+    return nodes;
+  }
+
+  const auto page_size = std::uintptr_t(::sysconf(_SC_PAGESIZE));
+  auto pages = std::vector<void*>{};
+  pages.reserve(logical_addresses.size());
+  for (const auto address : logical_addresses) {
+    pages.push_back(reinterpret_cast<void*>(address - (address % page_size)));
+  }
+
+  /// Without target nodes, move_pages() only reports the node of every page (or a negative error code).
+  auto status = std::vector<int>(pages.size(), -1);
+  if (::syscall(SYS_move_pages, process_id, pages.size(), pages.data(), nullptr, status.data(), 0) != 0) {
+    return nodes;
+  }
+
+  for (auto index = 0U; index < status.size(); ++index) {
+    if (status[index] >= 0) {
+      nodes[index] = std::uint16_t(status[index]);
+    }
+  }
+
+  return nodes;
+}
+
+std::vector<std::uint16_t>
+perf::NumaTopology::parse_cpu_list(const std::string& cpu_list)
+{
+  auto cpu_ids = std::vector<std::uint16_t>{};
+
+  auto stream = std::stringstream{ cpu_list };
+  auto range = std::string{};
+  while (std::getline(stream, range, ',')) {
+    if (range.empty() || range.front() < '0' || range.front() > '9') {
+      continue;
+    }
+
+    const auto separator = range.find('-');
+    const auto first = std::stoul(range.substr(0U, separator));
+    const auto last = separator != std::string::npos ? std::stoul(range.substr(separator + 1U)) : first;
+    for (auto cpu_id = first; cpu_id <= last; ++cpu_id) {
+      cpu_ids.push_back(std::uint16_t(cpu_id));
+    }
+  }
+
+  return cpu_ids;
+}
@@ -0,0 +1,70 @@
+#include <algorithm>
+#include <cmath>
+#include <perfcpp/period_controller.h>
+#include <stdexcept>
+#include <variant>
+
+perf::PeriodController::PeriodController(perf::Sampler& sampler, perf::PeriodController::Config config)
+  : _sampler(sampler)
+  , _config(config)
+  , _period(0U)
+  , _last_update(std::chrono::steady_clock::now())
+{
+  const auto period_or_frequency = sampler.config().period_for_frequency();
+  if (!std::holds_alternative<Period>(period_or_frequency)) {
+    throw std::runtime_error("Adapting the sampling period requires the sampler to sample with a period.");
+  }
+
+  this->_period =
+    std::clamp(std::get<Period>(period_or_frequency).get(), this->_config.min_period(), this->_config.max_period());
+  sampler.config().period(this->_period);
+
+  /// Record the period in effect with every sample.
+  sampler.values().period(true);
+
+  this->_history.emplace_back(this->_last_update, this->_period);
+}
+
+std::uint64_t
+perf::PeriodController::update(const std::uint64_t count_samples,
+                               const std::uint64_t count_loss,
+                               const std::uint64_t count_throttle)
+{
+  const auto now = std::chrono::steady_clock::now();
+  const auto seconds = std::chrono::duration<double>(now - this->_last_update).count();
+  if (seconds <= 0.0) {
+    return this->_period;
+  }
+  this->_last_update = now;
+
+  /// Lost samples were generated, too; the rate of generated samples is what the period controls.
+  const auto observed_samples_per_second = double(count_samples + count_loss) / seconds;
+  const auto target_samples_per_second = double(std::max<std::uint64_t>(this->_config.target_samples_per_second(), 1U));
+
+  /// A larger period yields proportionally fewer samples.
+  auto factor = observed_samples_per_second / target_samples_per_second;
+  if (count_throttle > 0U) {
+    /// Being throttled means that the current period is far too small.
+    factor = std::max(factor, 2.0);
+  } else if (count_loss > 0U) {
+    /// Losing samples means that the period is too small; grow it by (at least) the share of lost samples.
+    const auto lost_share = double(count_loss) / double(count_samples + count_loss);
+    factor = std::max(factor, 1.0 + lost_share);
+  } else if (std::abs(factor - 1.0) <= this->_config.tolerance()) {
+    return this->_period;
+  }
+
+  const auto max_adjustment = std::max(this->_config.max_adjustment(), 1.0);
+  factor = std::clamp(factor, 1.0 / max_adjustment, max_adjustment);
+
+  const auto period = std::clamp(std::uint64_t(std::llround(double(this->_period) * factor)),
+                                 this->_config.min_period(),
+                                 this->_config.max_period());
+  if (period != this->_period && this->_sampler.update_period(period)) {
+    this->_period = period;
+    this->_sampler.config().period(period);
+    this->_history.emplace_back(now, period);
+  }
+
+  return this->_period;
+}
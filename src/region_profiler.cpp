@@ -0,0 +1,326 @@
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <perfcpp/region_profiler.h>
+#include <stdexcept>
+#include <unordered_map>
+
+/**
+ * Names of all regions; the position of a name is the id of the region.
+ */
+class perf::RegionProfiler::Registry
+{
+public:
+  [[nodiscard]] std::uint32_t id(const std::string_view name)
+  {
+    auto lock = std::lock_guard{ this->_mutex };
+
+    if (const auto iterator = this->_ids.find(name); iterator != this->_ids.end()) {
+      return iterator->second;
+    }
+
+    if (this->_names.size() == MAX_REGIONS) {
+      throw std::runtime_error{
+        std::string{ "Cannot register region '" }.append(name).append("': Too many regions.")
+      };
+    }
+
+    /// References to elements of the deque stay valid when adding names.
+    const auto id = std::uint32_t(this->_names.size());
+    const auto& interned_name = this->_names.emplace_back(name);
+    this->_ids.insert(std::make_pair(std::string_view{ interned_name }, id));
+
+    return id;
+  }
+
+  [[nodiscard]] std::vector<std::string> names()
+  {
+    auto lock = std::lock_guard{ this->_mutex };
+    return std::vector<std::string>{ this->_names.begin(), this->_names.end() };
+  }
+
+private:
+  std::mutex _mutex;
+  std::deque<std::string> _names;
+  std::unordered_map<std::string_view, std::uint32_t> _ids;
+};
+
+perf::RegionProfiler::Registry&
+perf::RegionProfiler::registry()
+{
+  static auto registry = Registry{};
+  return registry;
+}
+
+std::uint32_t
+perf::RegionProfiler::region(const std::string_view name)
+{
+  return RegionProfiler::registry().id(name);
+}
+
+perf::RegionProfiler::RegionProfiler(const CounterDefinition& counter_list, Config config)
+  : _id(_next_profiler_id.fetch_add(1U, std::memory_order_relaxed))
+  , _event_counter(counter_list, config)
+  , _thread_registry(std::numeric_limits<std::size_t>::max(), [this](const std::size_t slot) {
+    /// Close the counters of the exiting thread; its slot is never handed out again.
+    auto lock = std::lock_guard{ this->_thread_profiles_mutex };
+    if (slot < this->_thread_profiles.size() && this->_thread_profiles[slot] != nullptr) {
+      this->_thread_profiles[slot]->retire();
+    }
+  })
+{
+  /// Regions are entered and left frequently; reading via read() would dominate the region.
+  config.user_level_read(true);
+  this->_event_counter.config(config);
+
+  this->activate();
+}
+
+perf::RegionProfiler::~RegionProfiler()
+{
+  auto* profiler = this;
+  _active_profiler.compare_exchange_strong(profiler, nullptr, std::memory_order_acq_rel);
+}
+
+bool
+perf::RegionProfiler::add(std::string&& counter_name)
+{
+  auto lock = std::lock_guard{ this->_thread_profiles_mutex };
+  if (!this->_thread_profiles.empty()) {
+    throw std::runtime_error{ "Cannot add counters: Regions were already profiled." };
+  }
+
+  return this->_event_counter.add(std::move(counter_name));
+}
+
+bool
+perf::RegionProfiler::add(std::vector<std::string>&& counter_names)
+{
+  auto lock = std::lock_guard{ this->_thread_profiles_mutex };
+  if (!this->_thread_profiles.empty()) {
+    throw std::runtime_error{ "Cannot add counters: Regions were already profiled." };
+  }
+
+  return this->_event_counter.add(std::move(counter_names));
+}
+
+perf::RegionProfiler::ThreadProfile*
+perf::RegionProfiler::enter(const std::uint32_t region_id)
+{
+  auto& thread_profile = this->thread_profile();
+  return thread_profile.enter(region_id) ? &thread_profile : nullptr;
+}
+
+void
+perf::RegionProfiler::leave(ThreadProfile* thread_profile) noexcept
+{
+  if (thread_profile != nullptr) {
+    thread_profile->leave();
+  }
+}
+
+perf::RegionProfiler::ThreadProfile&
+perf::RegionProfiler::thread_profile()
+{
+  /// The latest profile used by this thread; the id of the profiler guards against profilers at reused addresses.
+  thread_local auto cached_profiler_id = std::uint64_t{ 0U };
+  thread_local ThreadProfile* cached_profile = nullptr;
+
+  if (cached_profiler_id == this->_id) {
+    return *cached_profile;
+  }
+
+  /// Unlike ids of threads (std::thread::id), slots of exited threads are never handed out again.
+  const auto slot = this->_thread_registry.slot();
+
+  auto lock = std::lock_guard{ this->_thread_profiles_mutex };
+  if (this->_thread_profiles.size() <= slot) {
+    this->_thread_profiles.resize(slot + 1U);
+  }
+
+  auto& profile = this->_thread_profiles[slot];
+  if (profile == nullptr) {
+    profile = std::make_unique<ThreadProfile>(this->_event_counter);
+  }
+
+  cached_profiler_id = this->_id;
+  cached_profile = profile.get();
+
+  return *cached_profile;
+}
+
+std::vector<perf::RegionProfiler::RegionResult>
+perf::RegionProfiler::result() const
+{
+  const auto names = RegionProfiler::registry().names();
+  const auto count_hardware_events = this->_event_counter.count_hardware_events();
+
+  auto results = std::vector<RegionResult>{};
+
+  auto lock = std::lock_guard{ this->_thread_profiles_mutex };
+  for (auto region_id = 0U; region_id < names.size(); ++region_id) {
+    auto count = std::uint64_t{ 0U };
+    auto inclusive = std::vector<double>(count_hardware_events, .0);
+    auto exclusive = std::vector<double>(count_hardware_events, .0);
+
+    /// Read the tables of all threads without interrupting them.
+    for (const auto& thread_profile : this->_thread_profiles) {
+      if (thread_profile != nullptr) {
+        thread_profile->aggregate(region_id, count, inclusive, exclusive);
+      }
+    }
+
+    if (count > 0U) {
+      results.emplace_back(std::string{ names[region_id] },
+                           count,
+                           this->_event_counter.to_result(inclusive),
+                           this->_event_counter.to_result(exclusive));
+    }
+  }
+
+  return results;
+}
+
+perf::RegionProfiler::ThreadProfile::ThreadProfile(const EventCounter& event_counter)
+  : _event_counter(event_counter)
+  , _count_hardware_events(event_counter.count_hardware_events())
+  , _row_size((1U + 2U * _count_hardware_events + 7U) / 8U)
+  , _current_values(_count_hardware_events, .0)
+{
+  /// The counters measure the thread that creates the profile and run until the thread exits or the profiler is
+  /// destroyed.
+  this->_event_counter.start();
+}
+
+perf::RegionProfiler::ThreadProfile::~ThreadProfile()
+{
+  this->_event_counter.stop();
+
+  for (auto& chunk : this->_chunks) {
+    delete[] chunk.load(std::memory_order_relaxed);
+  }
+}
+
+void
+perf::RegionProfiler::ThreadProfile::retire() noexcept
+{
+  try {
+    this->_event_counter.stop();
+    this->_event_counter.close();
+  } catch (...) {
+    /// Retiring runs while the thread exits and must not throw.
+  }
+}
+
+bool
+perf::RegionProfiler::ThreadProfile::enter(const std::uint32_t region_id)
+{
+  /// Allocate the row (and the stacks) here, leaving the region must not fail.
+  if (region_id >= MAX_REGIONS || this->row_or_allocate(region_id) == nullptr) {
+    return false;
+  }
+
+  if (this->_region_depth.size() <= region_id) {
+    this->_region_depth.resize(region_id + 1U, 0U);
+  }
+
+  const auto depth = this->_region_stack.size();
+  const auto frame_size = 2U * this->_count_hardware_events;
+  if (this->_value_stack.size() < (depth + 1U) * frame_size) {
+    this->_value_stack.resize((depth + 1U) * frame_size);
+  }
+
+  /// Read the counters as late as possible to exclude the bookkeeping from the region.
+  auto* start_values = this->_value_stack.data() + depth * frame_size;
+  std::fill_n(start_values + this->_count_hardware_events, this->_count_hardware_events, .0);
+  if (!this->_event_counter.live_values(this->_current_values)) {
+    return false;
+  }
+  std::copy(this->_current_values.begin(), this->_current_values.end(), start_values);
+
+  this->_region_stack.push_back(region_id);
+  ++this->_region_depth[region_id];
+
+  return true;
+}
+
+void
+perf::RegionProfiler::ThreadProfile::leave() noexcept
+{
+  /// Read the counters as early as possible to exclude the bookkeeping from the region.
+  const auto is_read = this->_event_counter.live_values(this->_current_values);
+
+  const auto region_id = this->_region_stack.back();
+  this->_region_stack.pop_back();
+  const auto is_outermost = --this->_region_depth[region_id] == 0U;
+
+  if (!is_read) {
+    return;
+  }
+
+  const auto depth = this->_region_stack.size();
+  const auto frame_size = 2U * this->_count_hardware_events;
+  const auto* start_values = this->_value_stack.data() + depth * frame_size;
+  const auto* nested_values = start_values + this->_count_hardware_events;
+  auto* parent_nested_values =
+    depth > 0U ? this->_value_stack.data() + (depth - 1U) * frame_size + this->_count_hardware_events : nullptr;
+
+  /// Row layout: count, inclusive values, exclusive values.
+  auto* row = this->row(region_id);
+  ThreadProfile::add(ThreadProfile::value(row, 0U), 1.0);
+
+  for (auto i = 0U; i < this->_count_hardware_events; ++i) {
+    const auto delta = this->_current_values[i] - start_values[i];
+
+    /// Recursive regions are already counted by their outermost instance.
+    if (is_outermost) {
+      ThreadProfile::add(ThreadProfile::value(row, 1U + i), delta);
+    }
+    ThreadProfile::add(ThreadProfile::value(row, 1U + this->_count_hardware_events + i), delta - nested_values[i]);
+
+    if (parent_nested_values != nullptr) {
+      parent_nested_values[i] += delta;
+    }
+  }
+}
+
+void
+perf::RegionProfiler::ThreadProfile::aggregate(const std::uint32_t region_id,
+                                               std::uint64_t& count,
+                                               std::vector<double>& inclusive,
+                                               std::vector<double>& exclusive) const noexcept
+{
+  auto* row = this->row(region_id);
+  if (row == nullptr) {
+    return;
+  }
+
+  count += std::uint64_t(ThreadProfile::value(row, 0U).load(std::memory_order_relaxed));
+  for (auto i = 0U; i < this->_count_hardware_events && i < inclusive.size(); ++i) {
+    inclusive[i] += ThreadProfile::value(row, 1U + i).load(std::memory_order_relaxed);
+    exclusive[i] += ThreadProfile::value(row, 1U + this->_count_hardware_events + i).load(std::memory_order_relaxed);
+  }
+}
+
+perf::RegionProfiler::ThreadProfile::CacheLine*
+perf::RegionProfiler::ThreadProfile::row(const std::uint32_t region_id) const noexcept
+{
+  auto* chunk = this->_chunks[region_id / REGIONS_PER_CHUNK].load(std::memory_order_acquire);
+  if (chunk == nullptr) {
+    return nullptr;
+  }
+
+  return chunk + (region_id % REGIONS_PER_CHUNK) * this->_row_size;
+}
+
+perf::RegionProfiler::ThreadProfile::CacheLine*
+perf::RegionProfiler::ThreadProfile::row_or_allocate(const std::uint32_t region_id)
+{
+  auto& chunk = this->_chunks[region_id / REGIONS_PER_CHUNK];
+  if (chunk.load(std::memory_order_relaxed) == nullptr) {
+    /// Publish the zero-initialized chunk to aggregating threads.
+    chunk.store(new CacheLine[REGIONS_PER_CHUNK * this->_row_size](), std::memory_order_release);
+  }
+
+  return this->row(region_id);
+}
@@ -0,0 +1,64 @@
+#include <algorithm>
+#include <cstring>
+#include <perfcpp/sample_arena.h>
+
+std::vector<perf::Sample>
+perf::SampleArena::to_samples() const
+{
+  auto samples = std::vector<Sample>{};
+  samples.reserve(this->_records.size());
+
+  for (const auto sample : *this) {
+    samples.push_back(sample.to_sample());
+  }
+
+  return samples;
+}
+
+void
+perf::SampleArena::clear() noexcept
+{
+  this->_data.clear();
+  this->_records.clear();
+  this->_layouts.clear();
+  this->_count_loss = 0U;
+  this->_count_throttle = 0U;
+}
+
+void
+perf::SampleArena::reserve(const std::size_t size_in_bytes, const std::size_t count_samples)
+{
+  this->_data.reserve((size_in_bytes + sizeof(std::uint64_t) - 1U) / sizeof(std::uint64_t));
+  this->_records.reserve(count_samples);
+}
+
+void
+perf::SampleArena::layout(const perf::SampleLayout& layout)
+{
+  this->_layouts.push_back(layout);
+}
+
+void
+perf::SampleArena::add(const perf_event_header* header)
+{
+  const auto offset = this->_data.size();
+  const auto count_words = (std::size_t{ header->size } + sizeof(std::uint64_t) - 1U) / sizeof(std::uint64_t);
+
+  this->_data.resize(offset + count_words);
+  std::memcpy(this->_data.data() + offset, header, header->size);
+
+  this->_records.push_back(Record{ offset, std::uint32_t(this->_layouts.size() - 1U) });
+}
+
+void
+perf::SampleArena::sort_by_time()
+{
+  const auto time = [this](const Record& record) {
+    const auto* header = reinterpret_cast<const perf_event_header*>(this->_data.data() + record.offset);
+    return SampleView{ header, this->_layouts[record.layout] }.time().value_or(0U);
+  };
+
+  std::stable_sort(this->_records.begin(), this->_records.end(), [&time](const Record& left, const Record& right) {
+    return time(left) < time(right);
+  });
+}
@@ -0,0 +1,373 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <perfcpp/sample_batch.h>
+#include <type_traits>
+
+template<typename S>
+void
+perf::SampleBatch::add_sample(const S& sample)
+{
+  const auto row = this->_modes.size();
+
+  this->_modes.push_back(sample.mode());
+  this->_is_exact_ips.push_back(static_cast<std::uint8_t>(sample.is_exact_ip()));
+
+  this->_sample_ids.push_back(row, sample.sample_id());
+  this->_instruction_pointers.push_back(row, sample.instruction_pointer());
+  this->_process_ids.push_back(row, sample.process_id());
+  this->_thread_ids.push_back(row, sample.thread_id());
+  this->_times.push_back(row, sample.time());
+  this->_stream_ids.push_back(row, sample.stream_id());
+  this->_logical_memory_addresses.push_back(row, sample.logical_memory_address());
+  this->_cpu_ids.push_back(row, sample.cpu_id());
+  this->_periods.push_back(row, sample.period());
+  this->_weights.push_back(row, sample.weight());
+  this->_data_sources.push_back(row, sample.data_src());
+  this->_transaction_aborts.push_back(row, sample.transaction_abort());
+  this->_physical_memory_addresses.push_back(row, sample.physical_memory_address());
+  this->_cgroup_ids.push_back(row, sample.cgroup_id());
+  this->_data_page_sizes.push_back(row, sample.data_page_size());
+  this->_code_page_sizes.push_back(row, sample.code_page_size());
+
+  /// The callchain of a perf::Sample is optional, the view returns an empty span if not sampled.
+  auto callchain = Span<std::uintptr_t>{};
+  if constexpr (std::is_same_v<S, SampleView>) {
+    const auto sampled_callchain = sample.callchain();
+    callchain = Span<std::uintptr_t>{ reinterpret_cast<const std::uintptr_t*>(sampled_callchain.data()),
+                                      sampled_callchain.size() };
+  } else {
+    if (sample.callchain().has_value()) {
+      callchain = Span<std::uintptr_t>{ sample.callchain()->data(), sample.callchain()->size() };
+    }
+  }
+
+  if (!callchain.empty() || !this->_callchain_offsets.empty()) {
+    /// Earlier rows have no callchain.
+    if (this->_callchain_offsets.empty()) {
+      this->_callchain_offsets.resize(row + 1U, 0U);
+    }
+
+    this->_callchains.insert(this->_callchains.end(), callchain.begin(), callchain.end());
+    this->_callchain_offsets.push_back(this->_callchains.size());
+  }
+
+  /// Counter values are stored raw; the names are taken from the first sample that provides counter values. Samples
+  /// with a different number of counters get zero values.
+  if constexpr (std::is_same_v<S, SampleView>) {
+    const auto values = sample.counter_values();
+    if (!values.empty() && this->_counter_names.empty()) {
+      this->_counter_names = sample.counter_names();
+    }
+
+    if (this->reserve_counter_values(row, values.size())) {
+      for (const auto& value : values) {
+        this->_counter_values.push_back(value.value);
+      }
+    }
+
+    this->_counter_times_enabled.push_back(row, sample.counter_time_enabled());
+    this->_counter_times_running.push_back(row, sample.counter_time_running());
+    this->_counter_group_ids.push_back(
+      row, values.empty() ? std::nullopt : std::make_optional<std::uint64_t>(values[0U].id));
+  } else {
+    const auto& counter_result = sample.counter_result();
+    const auto count_values = counter_result.has_value() ? counter_result->size() : 0U;
+    if (count_values > 0U && this->_counter_names.empty()) {
+      for (const auto& [name, _] : counter_result.value()) {
+        this->_counter_names.push_back(name);
+      }
+    }
+
+    /// Values of a perf::Sample are already corrected for multiplexing.
+    if (this->reserve_counter_values(row, count_values)) {
+      for (const auto& [_, value] : counter_result.value()) {
+        this->_counter_values.push_back(std::uint64_t(std::llround(value)));
+      }
+    }
+
+    this->_counter_times_enabled.push_back(row, std::nullopt);
+    this->_counter_times_running.push_back(row, std::nullopt);
+    this->_counter_group_ids.push_back(row, std::nullopt);
+  }
+}
+
+bool
+perf::SampleBatch::reserve_counter_values(const std::size_t row, const std::size_t count_values)
+{
+  const auto count_counters = this->_counter_names.size();
+  if (count_counters == 0U || (count_values == 0U && this->_counter_values.empty())) {
+    return false;
+  }
+
+  /// Earlier rows have no counter values.
+  if (this->_counter_values.empty()) {
+    this->_counter_values.resize(row * count_counters, 0U);
+  }
+
+  if (count_values != count_counters) {
+    this->_counter_values.resize(this->_counter_values.size() + count_counters, 0U);
+    return false;
+  }
+
+  return true;
+}
+
+std::optional<double>
+perf::SampleBatch::Row::counter_value(const std::string_view name) const noexcept
+{
+  const auto& counter_names = this->_batch->_counter_names;
+  const auto values = this->counter_values();
+  const auto iterator = std::find(counter_names.begin(), counter_names.end(), name);
+  if (values.empty() || iterator == counter_names.end()) {
+    return std::nullopt;
+  }
+
+  return double(values[std::size_t(std::distance(counter_names.begin(), iterator))]) *
+         this->multiplexing_correction();
+}
+
+double
+perf::SampleBatch::Row::multiplexing_correction() const noexcept
+{
+  /// Values without times (i.e., taken from a perf::Sample) are already corrected.
+  const auto time_enabled = this->counter_time_enabled();
+  const auto time_running = this->counter_time_running();
+  if (time_enabled.has_value() && time_running.has_value() && time_running.value() > 0U) {
+    return double(time_enabled.value()) / double(time_running.value());
+  }
+
+  return 1.0;
+}
+
+template void perf::SampleBatch::add_sample<perf::Sample>(const perf::Sample&);
+template void perf::SampleBatch::add_sample<perf::SampleView>(const perf::SampleView&);
+
+std::size_t
+perf::SampleBatch::size_in_bytes() const noexcept
+{
+  return this->_modes.size() * sizeof(Sample::Mode) + this->_is_exact_ips.size() * sizeof(std::uint8_t) +
+         this->_sample_ids.size_in_bytes() + this->_instruction_pointers.size_in_bytes() +
+         this->_process_ids.size_in_bytes() + this->_thread_ids.size_in_bytes() + this->_times.size_in_bytes() +
+         this->_stream_ids.size_in_bytes() + this->_logical_memory_addresses.size_in_bytes() +
+         this->_cpu_ids.size_in_bytes() + this->_periods.size_in_bytes() + this->_weights.size_in_bytes() +
+         this->_data_sources.size_in_bytes() + this->_transaction_aborts.size_in_bytes() +
+         this->_physical_memory_addresses.size_in_bytes() + this->_cgroup_ids.size_in_bytes() +
+         this->_data_page_sizes.size_in_bytes() + this->_code_page_sizes.size_in_bytes() +
+         this->_callchains.size() * sizeof(std::uintptr_t) + this->_callchain_offsets.size() * sizeof(std::size_t) +
+         this->_counter_values.size() * sizeof(std::uint64_t) + this->_counter_times_enabled.size_in_bytes() +
+         this->_counter_times_running.size_in_bytes() + this->_counter_group_ids.size_in_bytes();
+}
+
+std::vector<perf::Sample>
+perf::SampleBatch::to_samples() const
+{
+  auto samples = std::vector<Sample>{};
+  samples.reserve(this->size());
+
+  for (const auto row : *this) {
+    samples.push_back(row.to_sample());
+  }
+
+  return samples;
+}
+
+void
+perf::SampleBatch::sort_by_time()
+{
+  if (!this->_times.is_present()) {
+    return;
+  }
+
+  const auto& times = this->_times.values();
+  if (std::is_sorted(times.begin(), times.end())) {
+    return;
+  }
+
+  auto order = std::vector<std::size_t>(this->size());
+  std::iota(order.begin(), order.end(), 0U);
+  std::stable_sort(
+    order.begin(), order.end(), [&times](const auto left, const auto right) { return times[left] < times[right]; });
+
+  /// Reorder modes and flags (which are always present).
+  auto modes = std::vector<Sample::Mode>{};
+  auto is_exact_ips = std::vector<std::uint8_t>{};
+  modes.reserve(order.size());
+  is_exact_ips.reserve(order.size());
+  for (const auto row : order) {
+    modes.push_back(this->_modes[row]);
+    is_exact_ips.push_back(this->_is_exact_ips[row]);
+  }
+  this->_modes = std::move(modes);
+  this->_is_exact_ips = std::move(is_exact_ips);
+
+  this->_sample_ids.permute(order);
+  this->_instruction_pointers.permute(order);
+  this->_process_ids.permute(order);
+  this->_thread_ids.permute(order);
+  this->_times.permute(order);
+  this->_stream_ids.permute(order);
+  this->_logical_memory_addresses.permute(order);
+  this->_cpu_ids.permute(order);
+  this->_periods.permute(order);
+  this->_weights.permute(order);
+  this->_data_sources.permute(order);
+  this->_transaction_aborts.permute(order);
+  this->_physical_memory_addresses.permute(order);
+  this->_cgroup_ids.permute(order);
+  this->_data_page_sizes.permute(order);
+  this->_code_page_sizes.permute(order);
+  this->_counter_times_enabled.permute(order);
+  this->_counter_times_running.permute(order);
+  this->_counter_group_ids.permute(order);
+
+  if (!this->_counter_values.empty()) {
+    const auto count_counters = this->_counter_names.size();
+    auto counter_values = std::vector<std::uint64_t>{};
+    counter_values.reserve(this->_counter_values.size());
+    for (const auto row : order) {
+      counter_values.insert(counter_values.end(),
+                            this->_counter_values.begin() + std::int64_t(row * count_counters),
+                            this->_counter_values.begin() + std::int64_t((row + 1U) * count_counters));
+    }
+    this->_counter_values = std::move(counter_values);
+  }
+
+  if (!this->_callchain_offsets.empty()) {
+    auto callchains = std::vector<std::uintptr_t>{};
+    auto callchain_offsets = std::vector<std::size_t>{ 0U };
+    callchains.reserve(this->_callchains.size());
+    callchain_offsets.reserve(this->_callchain_offsets.size());
+
+    for (const auto row : order) {
+      callchains.insert(callchains.end(),
+                        this->_callchains.begin() + std::int64_t(this->_callchain_offsets[row]),
+                        this->_callchains.begin() + std::int64_t(this->_callchain_offsets[row + 1U]));
+      callchain_offsets.push_back(callchains.size());
+    }
+
+    this->_callchains = std::move(callchains);
+    this->_callchain_offsets = std::move(callchain_offsets);
+  }
+}
+
+void
+perf::SampleBatch::clear() noexcept
+{
+  this->_modes.clear();
+  this->_is_exact_ips.clear();
+  this->_sample_ids.clear();
+  this->_instruction_pointers.clear();
+  this->_process_ids.clear();
+  this->_thread_ids.clear();
+  this->_times.clear();
+  this->_stream_ids.clear();
+  this->_logical_memory_addresses.clear();
+  this->_cpu_ids.clear();
+  this->_periods.clear();
+  this->_weights.clear();
+  this->_data_sources.clear();
+  this->_transaction_aborts.clear();
+  this->_physical_memory_addresses.clear();
+  this->_cgroup_ids.clear();
+  this->_data_page_sizes.clear();
+  this->_code_page_sizes.clear();
+  this->_callchains.clear();
+  this->_callchain_offsets.clear();
+  this->_counter_names.clear();
+  this->_counter_values.clear();
+  this->_counter_times_enabled.clear();
+  this->_counter_times_running.clear();
+  this->_counter_group_ids.clear();
+  this->_count_loss = 0U;
+  this->_count_throttle = 0U;
+}
+
+perf::Sample
+perf::SampleBatch::Row::to_sample() const
+{
+  auto sample = Sample{ this->mode() };
+
+  sample.is_exact_ip(this->is_exact_ip());
+
+  if (const auto sample_id = this->sample_id(); sample_id.has_value()) {
+    sample.sample_id(sample_id.value());
+  }
+
+  if (const auto instruction_pointer = this->instruction_pointer(); instruction_pointer.has_value()) {
+    sample.instruction_pointer(instruction_pointer.value());
+  }
+
+  if (const auto process_id = this->process_id(); process_id.has_value()) {
+    sample.process_id(process_id.value());
+  }
+
+  if (const auto thread_id = this->thread_id(); thread_id.has_value()) {
+    sample.thread_id(thread_id.value());
+  }
+
+  if (const auto time = this->time(); time.has_value()) {
+    sample.timestamp(time.value());
+  }
+
+  if (const auto stream_id = this->stream_id(); stream_id.has_value()) {
+    sample.stream_id(stream_id.value());
+  }
+
+  if (const auto logical_memory_address = this->logical_memory_address(); logical_memory_address.has_value()) {
+    sample.logical_memory_address(logical_memory_address.value());
+  }
+
+  if (const auto cpu_id = this->cpu_id(); cpu_id.has_value()) {
+    sample.cpu_id(cpu_id.value());
+  }
+
+  if (const auto period = this->period(); period.has_value()) {
+    sample.period(period.value());
+  }
+
+  if (const auto callchain = this->callchain(); !callchain.empty()) {
+    sample.callchain(std::vector<std::uintptr_t>(callchain.begin(), callchain.end()));
+  }
+
+  if (const auto weight = this->weight(); weight.has_value()) {
+    sample.weight(weight.value());
+  }
+
+  if (const auto data_source = this->data_src(); data_source.has_value()) {
+    sample.data_src(data_source.value());
+  }
+
+  if (const auto transaction_abort = this->transaction_abort(); transaction_abort.has_value()) {
+    sample.transaction_abort(transaction_abort.value());
+  }
+
+  if (const auto physical_memory_address = this->physical_memory_address(); physical_memory_address.has_value()) {
+    sample.physical_memory_address(physical_memory_address.value());
+  }
+
+  if (const auto cgroup_id = this->cgroup_id(); cgroup_id.has_value()) {
+    sample.cgroup_id(cgroup_id.value());
+  }
+
+  if (const auto data_page_size = this->data_page_size(); data_page_size.has_value()) {
+    sample.data_page_size(data_page_size.value());
+  }
+
+  if (const auto code_page_size = this->code_page_size(); code_page_size.has_value()) {
+    sample.code_page_size(code_page_size.value());
+  }
+
+  if (const auto counter_values = this->counter_values(); !counter_values.empty()) {
+    auto counter_results = std::vector<std::pair<std::string_view, double>>{};
+    counter_results.reserve(counter_values.size());
+    const auto multiplexing_correction = this->multiplexing_correction();
+    for (auto counter_id = 0U; counter_id < counter_values.size(); ++counter_id) {
+      counter_results.emplace_back(this->_batch->_counter_names[counter_id],
+                                   double(counter_values[counter_id]) * multiplexing_correction);
+    }
+    sample.counter_result(CounterResult{ std::move(counter_results) });
+  }
+
+  return sample;
+}
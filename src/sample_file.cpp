@@ -0,0 +1,239 @@
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <perfcpp/sample_file.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+perf::SampleWriter::SampleWriter(perf::Sampler& sampler, const std::string& file_name)
+  : _sampler(sampler)
+{
+  this->_file_descriptor = ::open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (this->_file_descriptor < 0) {
+    throw std::runtime_error{ std::string{ "Cannot open sample file '" }.append(file_name).append("': ").append(
+      std::strerror(errno)) };
+  }
+}
+
+void
+perf::SampleWriter::close()
+{
+  if (this->_file_descriptor > -1) {
+    ::close(this->_file_descriptor);
+    this->_file_descriptor = -1;
+  }
+}
+
+std::uint64_t
+perf::SampleWriter::write()
+{
+  if (this->_file_descriptor < 0) {
+    throw std::runtime_error{ "Sample file is already closed." };
+  }
+
+  if (!this->_sampler._is_opened) {
+    throw std::runtime_error{ "Sampler needs to be opened before writing samples." };
+  }
+
+  if (!std::exchange(this->_is_header_written, true)) {
+    this->write_header();
+  }
+
+  auto count_written_bytes = std::uint64_t{ 0U };
+
+  for (auto layout_id = 0U; layout_id < this->_sampler._sample_counter.size(); ++layout_id) {
+    /// The records are only consumed if they were written successfully (write() throws otherwise).
+    this->_sampler._sample_counter[layout_id].read_raw(
+      [this, layout_id, &count_written_bytes](const std::uint8_t* first_chunk,
+                                              const std::uint64_t first_chunk_size,
+                                              const std::uint8_t* second_chunk,
+                                              const std::uint64_t second_chunk_size) {
+        const auto chunk_header = SampleFile::ChunkHeader{ layout_id, 0U, first_chunk_size + second_chunk_size };
+        this->write(&chunk_header, sizeof(SampleFile::ChunkHeader));
+        this->write(first_chunk, first_chunk_size);
+        this->write(second_chunk, second_chunk_size);
+
+        count_written_bytes += sizeof(SampleFile::ChunkHeader) + chunk_header.size;
+      },
+      true);
+  }
+
+  return count_written_bytes;
+}
+
+void
+perf::SampleWriter::write_header()
+{
+  const auto& sample_counters = this->_sampler._sample_counter;
+
+  const auto header =
+    SampleFile::Header{ SampleFile::MAGIC, SampleFile::VERSION, static_cast<std::uint32_t>(sample_counters.size()) };
+  this->write(&header, sizeof(SampleFile::Header));
+
+  constexpr auto padding = std::array<char, 8U>{};
+
+  for (const auto& sample_counter : sample_counters) {
+    const auto& layout = sample_counter.layout();
+
+    /// Bits 7:0 hold the IBS unit, bit 8 marks that the raw data is included into the samples.
+    auto amd_ibs = std::uint32_t{ 0U };
+    if (layout.amd_ibs_type().has_value()) {
+      amd_ibs = static_cast<std::uint32_t>(layout.amd_ibs_type().value()) | (layout.is_copy_raw() ? 0x100U : 0U);
+    }
+    const auto layout_header = SampleFile::LayoutHeader{ layout.mask(),
+                                                         static_cast<std::uint32_t>(layout.count_user_registers()),
+                                                         static_cast<std::uint32_t>(layout.count_kernel_registers()),
+                                                         static_cast<std::uint32_t>(layout.counter_names().size()),
+                                                         amd_ibs };
+    this->write(&layout_header, sizeof(SampleFile::LayoutHeader));
+
+    /// Write the name and config of every counter (taken from the counter definitions).
+    for (const auto counter_name : layout.counter_names()) {
+      auto counter_header = SampleFile::CounterHeader{ 0U, static_cast<std::uint32_t>(counter_name.size()), 0U, 0U, 0U };
+      if (const auto counter = this->_sampler._counter_definitions.counter(counter_name); counter.has_value()) {
+        const auto& config = counter->second;
+        counter_header.type = config.type();
+        counter_header.event_id = config.event_id();
+        counter_header.event_id_extension_1 = config.event_id_extension()[0U];
+        counter_header.event_id_extension_2 = config.event_id_extension()[1U];
+      }
+
+      this->write(&counter_header, sizeof(SampleFile::CounterHeader));
+      this->write(counter_name.data(), counter_name.size());
+      this->write(padding.data(), SampleFile::padded(counter_name.size()) - counter_name.size());
+    }
+  }
+}
+
+void
+perf::SampleWriter::write(const void* data, const std::size_t size)
+{
+  const auto* bytes = reinterpret_cast<const std::uint8_t*>(data);
+
+  auto count_written_bytes = std::size_t{ 0U };
+  while (count_written_bytes < size) {
+    const auto result = ::write(this->_file_descriptor, bytes + count_written_bytes, size - count_written_bytes);
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      throw std::runtime_error{ std::string{ "Cannot write sample file: " }.append(std::strerror(errno)) };
+    }
+
+    count_written_bytes += std::size_t(result);
+  }
+}
+
+perf::SampleReader::SampleReader(const std::string& file_name)
+{
+  const auto file_descriptor = ::open(file_name.c_str(), O_RDONLY | O_CLOEXEC);
+  if (file_descriptor < 0) {
+    throw std::runtime_error{ std::string{ "Cannot open sample file '" }.append(file_name).append("': ").append(
+      std::strerror(errno)) };
+  }
+
+  struct stat file_stat
+  {};
+  if (::fstat(file_descriptor, &file_stat) != 0 || std::size_t(file_stat.st_size) < sizeof(SampleFile::Header)) {
+    ::close(file_descriptor);
+    throw std::runtime_error{ std::string{ "Sample file '" }.append(file_name).append("' is invalid.") };
+  }
+
+  this->_size = std::size_t(file_stat.st_size);
+  auto* data = ::mmap(nullptr, this->_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+  ::close(file_descriptor);
+
+  if (data == MAP_FAILED) {
+    throw std::runtime_error{ std::string{ "Cannot map sample file '" }.append(file_name).append("': ").append(
+      std::strerror(errno)) };
+  }
+  this->_data = reinterpret_cast<const std::uint8_t*>(data);
+
+  /// Read the header.
+  const auto* header = reinterpret_cast<const SampleFile::Header*>(this->_data);
+  if (header->magic != SampleFile::MAGIC || header->version != SampleFile::VERSION) {
+    ::munmap(data, this->_size);
+    throw std::runtime_error{ std::string{ "Sample file '" }.append(file_name).append("' has an unsupported format.") };
+  }
+
+  auto position = sizeof(SampleFile::Header);
+  const auto is_readable = [this, &position](const std::size_t size) { return position + size <= this->_size; };
+
+  /// Read the layouts. The layouts are not modified anymore, since SampleViews point to them.
+  this->_layouts.reserve(header->count_layouts);
+  this->_counters.reserve(header->count_layouts);
+  for (auto layout_id = 0U; layout_id < header->count_layouts; ++layout_id) {
+    if (!is_readable(sizeof(SampleFile::LayoutHeader))) {
+      ::munmap(data, this->_size);
+      throw std::runtime_error{ std::string{ "Sample file '" }.append(file_name).append("' is truncated.") };
+    }
+
+    const auto* layout_header = reinterpret_cast<const SampleFile::LayoutHeader*>(this->_data + position);
+    position += sizeof(SampleFile::LayoutHeader);
+
+    auto counter_names = std::vector<std::string_view>{};
+    auto counters = std::vector<std::pair<std::string_view, CounterConfig>>{};
+    for (auto counter_id = 0U; counter_id < layout_header->count_counters; ++counter_id) {
+      const auto* counter_header = reinterpret_cast<const SampleFile::CounterHeader*>(this->_data + position);
+      if (!is_readable(sizeof(SampleFile::CounterHeader)) ||
+          !is_readable(sizeof(SampleFile::CounterHeader) + SampleFile::padded(counter_header->name_length))) {
+        ::munmap(data, this->_size);
+        throw std::runtime_error{ std::string{ "Sample file '" }.append(file_name).append("' is truncated.") };
+      }
+      position += sizeof(SampleFile::CounterHeader);
+
+      const auto name =
+        std::string_view{ reinterpret_cast<const char*>(this->_data + position), counter_header->name_length };
+      position += SampleFile::padded(counter_header->name_length);
+
+      counter_names.push_back(name);
+      counters.emplace_back(name,
+                            CounterConfig{ counter_header->type,
+                                           counter_header->event_id,
+                                           counter_header->event_id_extension_1,
+                                           counter_header->event_id_extension_2 });
+    }
+
+    auto& layout = this->_layouts.emplace_back(layout_header->mask,
+                                               layout_header->count_user_registers,
+                                               layout_header->count_kernel_registers,
+                                               std::move(counter_names));
+    if (const auto amd_ibs_type = layout_header->amd_ibs & 0xFFU; amd_ibs_type != 0U) {
+      layout.amd_ibs(static_cast<AmdIbsDecoder::Type>(amd_ibs_type),
+                     static_cast<bool>(layout_header->amd_ibs & 0x100U));
+    }
+    this->_counters.emplace_back(std::move(counters));
+  }
+
+  this->_chunks_begin = position;
+}
+
+perf::SampleReader::~SampleReader()
+{
+  if (this->_data != nullptr) {
+    ::munmap(const_cast<std::uint8_t*>(this->_data), this->_size);
+  }
+}
+
+std::vector<perf::Sample>
+perf::SampleReader::result(const bool sort_by_time) const
+{
+  auto result = std::vector<Sample>{};
+
+  this->for_each([&result](const SampleView& sample_view) { result.push_back(sample_view.to_sample()); });
+
+  /// Sort the samples if requested and all layouts include the time.
+  const auto is_all_timed = std::all_of(this->_layouts.begin(), this->_layouts.end(), [](const SampleLayout& layout) {
+    return layout.is_set(PERF_SAMPLE_TIME);
+  });
+  if (sort_by_time && is_all_timed) {
+    std::sort(result.begin(), result.end(), SampleTimestampComparator{});
+  }
+
+  return result;
+}
@@ -0,0 +1,146 @@
+#include <chrono>
+#include <perfcpp/sample_queue.h>
+#include <thread>
+
+perf::SampleQueue::SampleQueue(const std::size_t capacity, const perf::SampleQueue::Backpressure backpressure)
+  : _backpressure(backpressure)
+{
+  auto size = std::size_t{ 2U };
+  while (size < capacity) {
+    size *= 2U;
+  }
+
+  this->_slots = std::make_unique<Slot[]>(size);
+  this->_mask = size - 1U;
+
+  for (auto position = std::size_t{ 0U }; position < size; ++position) {
+    this->_slots[position].sequence.store(position, std::memory_order_relaxed);
+  }
+}
+
+bool
+perf::SampleQueue::push(perf::SampleBatch& batch)
+{
+  for (auto attempt = 0U;; ++attempt) {
+    if (this->is_closed()) {
+      return false;
+    }
+
+    if (this->try_push(batch)) {
+      return true;
+    }
+
+    if (this->_backpressure == Backpressure::DropNewest) {
+      this->_count_dropped_batches.fetch_add(1U, std::memory_order_relaxed);
+      this->_count_dropped_samples.fetch_add(batch.size(), std::memory_order_relaxed);
+      batch.clear();
+      return false;
+    }
+
+    if (this->_backpressure == Backpressure::DropOldest) {
+      /// The dropped batch is replaced by an empty one; its memory is released.
+      auto dropped_batch = SampleBatch{};
+      if (this->try_pop(dropped_batch)) {
+        this->_count_dropped_batches.fetch_add(1U, std::memory_order_relaxed);
+        this->_count_dropped_samples.fetch_add(dropped_batch.size(), std::memory_order_relaxed);
+      }
+      continue;
+    }
+
+    SampleQueue::backoff(attempt);
+  }
+}
+
+bool
+perf::SampleQueue::try_push(perf::SampleBatch& batch)
+{
+  auto position = this->_push_position.load(std::memory_order_relaxed);
+
+  while (true) {
+    auto& slot = this->_slots[position & this->_mask];
+    const auto sequence = slot.sequence.load(std::memory_order_acquire);
+    const auto difference = std::int64_t(sequence - position);
+
+    if (difference == 0) {
+      /// The slot is free; claim the position.
+      if (this->_push_position.compare_exchange_weak(position, position + 1U, std::memory_order_relaxed)) {
+        std::swap(slot.batch, batch);
+        batch.clear();
+        slot.sequence.store(position + 1U, std::memory_order_release);
+        this->_count_pushed_batches.fetch_add(1U, std::memory_order_relaxed);
+        return true;
+      }
+    } else if (difference < 0) {
+      /// The slot was not popped since the last round, i.e., the queue is full.
+      return false;
+    } else {
+      position = this->_push_position.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+bool
+perf::SampleQueue::try_pop(perf::SampleBatch& batch)
+{
+  auto position = this->_pop_position.load(std::memory_order_relaxed);
+
+  while (true) {
+    auto& slot = this->_slots[position & this->_mask];
+    const auto sequence = slot.sequence.load(std::memory_order_acquire);
+    const auto difference = std::int64_t(sequence - (position + 1U));
+
+    if (difference == 0) {
+      /// The slot holds a batch; claim the position.
+      if (this->_pop_position.compare_exchange_weak(position, position + 1U, std::memory_order_relaxed)) {
+        std::swap(slot.batch, batch);
+        slot.sequence.store(position + this->_mask + 1U, std::memory_order_release);
+        return true;
+      }
+    } else if (difference < 0) {
+      /// The slot was not pushed, yet, i.e., the queue is empty.
+      return false;
+    } else {
+      position = this->_pop_position.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+bool
+perf::SampleQueue::pop(perf::SampleBatch& batch)
+{
+  for (auto attempt = 0U;; ++attempt) {
+    if (this->try_pop(batch)) {
+      return true;
+    }
+
+    /// Batches pushed before closing are popped first.
+    if (this->is_closed()) {
+      return this->try_pop(batch);
+    }
+
+    SampleQueue::backoff(attempt);
+  }
+}
+
+std::size_t
+perf::SampleQueue::size() const noexcept
+{
+  const auto pop_position = this->_pop_position.load(std::memory_order_relaxed);
+  const auto push_position = this->_push_position.load(std::memory_order_relaxed);
+
+  return push_position > pop_position ? std::size_t(push_position - pop_position) : 0U;
+}
+
+void
+perf::SampleQueue::backoff(const std::uint32_t attempt)
+{
+  if (attempt < 64U) {
+    return;
+  }
+
+  if (attempt < 128U) {
+    std::this_thread::yield();
+  } else {
+    std::this_thread::sleep_for(std::chrono::microseconds{ 50U });
+  }
+}
@@ -0,0 +1,389 @@
+#include <algorithm>
+#include <iterator>
+#include <perfcpp/sample_view.h>
+
+perf::SampleLayout::SampleLayout(const std::uint64_t mask,
+                                 const std::size_t count_user_registers,
+                                 const std::size_t count_kernel_registers,
+                                 std::vector<std::string_view> counter_names)
+  : _mask(mask)
+  , _count_user_registers(count_user_registers)
+  , _count_kernel_registers(count_kernel_registers)
+  , _counter_names(std::move(counter_names))
+{
+  /// Offset within the current segment; a new segment starts after every variable-sized value.
+  auto position = std::uint16_t{ 0U };
+
+  const auto add = [this, &position](const std::uint64_t perf_field, const Field field, const std::size_t size) {
+    if (this->is_set(perf_field)) {
+      this->_offsets[static_cast<std::size_t>(field)] = position;
+      this->_segments[static_cast<std::size_t>(field)] = static_cast<std::uint8_t>(this->_count_variable_fields);
+      position += static_cast<std::uint16_t>(size);
+    }
+  };
+
+  const auto add_variable = [this, &position](const std::uint64_t perf_field, const Field field) {
+    if (this->is_set(perf_field)) {
+      this->_offsets[static_cast<std::size_t>(field)] = position;
+      this->_segments[static_cast<std::size_t>(field)] = static_cast<std::uint8_t>(this->_count_variable_fields);
+      this->_variable_fields[this->_count_variable_fields++] = field;
+      position = 0U;
+    }
+  };
+
+  add(PERF_SAMPLE_IDENTIFIER, Field::SampleId, sizeof(std::uint64_t));
+  add(PERF_SAMPLE_IP, Field::InstructionPointer, sizeof(std::uint64_t));
+  add(PERF_SAMPLE_TID, Field::ThreadId, sizeof(std::uint32_t) * 2U);
+  add(PERF_SAMPLE_TIME, Field::Time, sizeof(std::uint64_t));
+  add(PERF_SAMPLE_STREAM_ID, Field::StreamId, sizeof(std::uint64_t));
+  add(PERF_SAMPLE_ADDR, Field::LogicalMemoryAddress, sizeof(std::uint64_t));
+  add(PERF_SAMPLE_CPU, Field::CpuId, sizeof(std::uint32_t) * 2U);
+  add(PERF_SAMPLE_PERIOD, Field::Period, sizeof(std::uint64_t));
+  add_variable(PERF_SAMPLE_READ, Field::CounterValues);
+  add_variable(PERF_SAMPLE_CALLCHAIN, Field::Callchain);
+  add_variable(PERF_SAMPLE_RAW, Field::Raw);
+  add_variable(PERF_SAMPLE_BRANCH_STACK, Field::Branches);
+  add_variable(PERF_SAMPLE_REGS_USER, Field::UserRegisters);
+#ifndef PERFCPP_NO_SAMPLE_WEIGHT_STRUCT
+  add(PERF_SAMPLE_WEIGHT | PERF_SAMPLE_WEIGHT_STRUCT, Field::Weight, sizeof(std::uint64_t));
+#else
+  add(PERF_SAMPLE_WEIGHT, Field::Weight, sizeof(std::uint64_t));
+#endif
+  add(PERF_SAMPLE_DATA_SRC, Field::DataSource, sizeof(std::uint64_t));
+  add(PERF_SAMPLE_TRANSACTION, Field::TransactionAbort, sizeof(std::uint64_t));
+  add_variable(PERF_SAMPLE_REGS_INTR, Field::KernelRegisters);
+#ifndef PERFCPP_NO_SAMPLE_PHYS_ADDR
+  add(PERF_SAMPLE_PHYS_ADDR, Field::PhysicalMemoryAddress, sizeof(std::uint64_t));
+#endif
+  add(PERF_SAMPLE_CGROUP, Field::CGroupId, sizeof(std::uint64_t));
+#ifndef PERFCPP_NO_SAMPLE_DATA_PAGE_SIZE
+  add(PERF_SAMPLE_DATA_PAGE_SIZE, Field::DataPageSize, sizeof(std::uint64_t));
+#endif
+#ifndef PERFCPP_NO_SAMPLE_CODE_PAGE_SIZE
+  add(PERF_SAMPLE_CODE_PAGE_SIZE, Field::CodePageSize, sizeof(std::uint64_t));
+#endif
+}
+
+perf::SampleView::SampleView(const perf_event_header* header, const perf::SampleLayout& layout) noexcept
+  : _data(reinterpret_cast<const std::uint8_t*>(header + 1U))
+  , _layout(&layout)
+  , _misc(header->misc)
+{
+  /// Only the sizes of variable-sized values need to be resolved; all other offsets are precomputed by the layout.
+  /// For layouts without variable-sized values (e.g., instruction pointer, thread id, and time), this is a no-op.
+  const auto& variable_fields = layout.variable_fields();
+  for (auto index = 0U; index < layout.count_variable_fields(); ++index) {
+    const auto field = variable_fields[index];
+    const auto position = static_cast<std::uint16_t>(this->_segment_starts[index] + layout.offset(field));
+    this->_segment_starts[index + 1U] = position + this->variable_size(field, position);
+  }
+}
+
+std::uint16_t
+perf::SampleView::variable_size(const Field field, const std::uint16_t position) const noexcept
+{
+  const auto* data = this->_data + position;
+
+  switch (field) {
+    case Field::CounterValues:
+      /// Number of counters, time enabled, time running, and the (value, id) pair of every counter.
+      return static_cast<std::uint16_t>(sizeof(std::uint64_t) * 3U +
+                                        sizeof(CounterValue) * *reinterpret_cast<const std::uint64_t*>(data));
+    case Field::Callchain:
+      return static_cast<std::uint16_t>(sizeof(std::uint64_t) * (1U + *reinterpret_cast<const std::uint64_t*>(data)));
+    case Field::Raw:
+      return static_cast<std::uint16_t>(sizeof(std::uint32_t) + *reinterpret_cast<const std::uint32_t*>(data));
+    case Field::Branches:
+      return static_cast<std::uint16_t>(sizeof(std::uint64_t) +
+                                        sizeof(perf_branch_entry) * *reinterpret_cast<const std::uint64_t*>(data));
+    case Field::UserRegisters:
+    case Field::KernelRegisters: {
+      /// Registers are only recorded if the ABI is known.
+      if (*reinterpret_cast<const std::uint64_t*>(data) == PERF_SAMPLE_REGS_ABI_NONE) {
+        return sizeof(std::uint64_t);
+      }
+
+      const auto count_registers = field == Field::UserRegisters ? this->_layout->count_user_registers()
+                                                                 : this->_layout->count_kernel_registers();
+      return static_cast<std::uint16_t>(sizeof(std::uint64_t) * (1U + count_registers));
+    }
+    default:
+      return 0U;
+  }
+}
+
+perf::Sample::Mode
+perf::SampleView::mode() const noexcept
+{
+  if (static_cast<bool>(this->_misc & PERF_RECORD_MISC_KERNEL)) {
+    return Sample::Mode::Kernel;
+  } else if (static_cast<bool>(this->_misc & PERF_RECORD_MISC_USER)) {
+    return Sample::Mode::User;
+  } else if (static_cast<bool>(this->_misc & PERF_RECORD_MISC_HYPERVISOR)) {
+    return Sample::Mode::Hypervisor;
+  } else if (static_cast<bool>(this->_misc & PERF_RECORD_MISC_GUEST_KERNEL)) {
+    return Sample::Mode::GuestKernel;
+  } else if (static_cast<bool>(this->_misc & PERF_RECORD_MISC_GUEST_USER)) {
+    return Sample::Mode::GuestUser;
+  }
+
+  return Sample::Mode::Unknown;
+}
+
+perf::Span<perf::SampleView::CounterValue>
+perf::SampleView::counter_values() const noexcept
+{
+  if (!this->_layout->is_set(PERF_SAMPLE_READ)) {
+    return Span<CounterValue>{};
+  }
+
+  const auto count_counters = this->read<std::uint64_t>(Field::CounterValues);
+  return Span<CounterValue>{
+    reinterpret_cast<const CounterValue*>(this->_data + this->offset(Field::CounterValues) + sizeof(std::uint64_t) * 3U),
+    count_counters
+  };
+}
+
+std::optional<double>
+perf::SampleView::counter_value(const std::string_view name) const noexcept
+{
+  const auto values = this->counter_values();
+  const auto& counter_names = this->_layout->counter_names();
+  if (values.size() != counter_names.size()) {
+    return std::nullopt;
+  }
+
+  const auto iterator = std::find(counter_names.begin(), counter_names.end(), name);
+  if (iterator == counter_names.end()) {
+    return std::nullopt;
+  }
+  const auto index = std::size_t(std::distance(counter_names.begin(), iterator));
+
+  /// Time enabled and running for correction.
+  const auto time_enabled = this->read<std::uint64_t>(Field::CounterValues, sizeof(std::uint64_t));
+  const auto time_running = this->read<std::uint64_t>(Field::CounterValues, sizeof(std::uint64_t) * 2U);
+  const auto multiplexing_correction = double(time_enabled) / double(time_running);
+
+  return double(values[index].value) * multiplexing_correction;
+}
+
+std::optional<perf::CounterResult>
+perf::SampleView::counter_result() const
+{
+  const auto values = this->counter_values();
+  const auto& counter_names = this->_layout->counter_names();
+
+  /// Only translate the counters if the number matches the number of specified counters.
+  if (!this->_layout->is_set(PERF_SAMPLE_READ) || values.size() != counter_names.size()) {
+    return std::nullopt;
+  }
+
+  const auto time_enabled = this->read<std::uint64_t>(Field::CounterValues, sizeof(std::uint64_t));
+  const auto time_running = this->read<std::uint64_t>(Field::CounterValues, sizeof(std::uint64_t) * 2U);
+  const auto multiplexing_correction = double(time_enabled) / double(time_running);
+
+  auto counter_results = std::vector<std::pair<std::string_view, double>>{};
+  counter_results.reserve(values.size());
+
+  /// Add each counter and its value (corrected) to the result set.
+  for (auto counter_id = 0U; counter_id < values.size(); ++counter_id) {
+    counter_results.emplace_back(counter_names[counter_id], double(values[counter_id].value) * multiplexing_correction);
+  }
+
+  return CounterResult{ std::move(counter_results) };
+}
+
+perf::Span<std::uint64_t>
+perf::SampleView::callchain() const noexcept
+{
+  if (!this->_layout->is_set(PERF_SAMPLE_CALLCHAIN)) {
+    return Span<std::uint64_t>{};
+  }
+
+  return Span<std::uint64_t>{
+    reinterpret_cast<const std::uint64_t*>(this->_data + this->offset(Field::Callchain) + sizeof(std::uint64_t)),
+    this->read<std::uint64_t>(Field::Callchain)
+  };
+}
+
+perf::Span<char>
+perf::SampleView::raw() const noexcept
+{
+  if (!this->_layout->is_set(PERF_SAMPLE_RAW)) {
+    return Span<char>{};
+  }
+
+  return Span<char>{ reinterpret_cast<const char*>(this->_data + this->offset(Field::Raw) + sizeof(std::uint32_t)),
+                     this->read<std::uint32_t>(Field::Raw) };
+}
+
+perf::Span<perf_branch_entry>
+perf::SampleView::branches() const noexcept
+{
+  if (!this->_layout->is_set(PERF_SAMPLE_BRANCH_STACK)) {
+    return Span<perf_branch_entry>{};
+  }
+
+  return Span<perf_branch_entry>{
+    reinterpret_cast<const perf_branch_entry*>(this->_data + this->offset(Field::Branches) + sizeof(std::uint64_t)),
+    this->read<std::uint64_t>(Field::Branches)
+  };
+}
+
+std::optional<perf::Weight>
+perf::SampleView::weight() const noexcept
+{
+  if (const auto amd_ibs = this->amd_ibs(); amd_ibs.has_value()) {
+    return amd_ibs->weight();
+  }
+
+  if (this->_layout->is_set(PERF_SAMPLE_WEIGHT)) {
+    return perf::Weight{ static_cast<std::uint32_t>(this->read<std::uint64_t>(Field::Weight)) };
+  }
+
+#ifndef PERFCPP_NO_SAMPLE_WEIGHT_STRUCT
+  if (this->_layout->is_set(PERF_SAMPLE_WEIGHT_STRUCT)) {
+    const auto weight_struct = this->read<perf_sample_weight>(Field::Weight);
+    return perf::Weight{ weight_struct.var1_dw, weight_struct.var2_w, weight_struct.var3_w };
+  }
+#endif
+
+  return std::nullopt;
+}
+
+perf::Span<std::uint64_t>
+perf::SampleView::registers(const std::uint64_t perf_field,
+                            const Field field,
+                            const std::size_t count_registers) const noexcept
+{
+  if (!this->_layout->is_set(perf_field) || this->read<std::uint64_t>(field) == PERF_SAMPLE_REGS_ABI_NONE) {
+    return Span<std::uint64_t>{};
+  }
+
+  return Span<std::uint64_t>{
+    reinterpret_cast<const std::uint64_t*>(this->_data + this->offset(field) + sizeof(std::uint64_t)), count_registers
+  };
+}
+
+perf::Sample
+perf::SampleView::to_sample() const
+{
+  auto sample = Sample{ this->mode() };
+
+  sample.is_exact_ip(this->is_exact_ip());
+
+  if (const auto sample_id = this->sample_id(); sample_id.has_value()) {
+    sample.sample_id(sample_id.value());
+  }
+
+  if (const auto instruction_pointer = this->instruction_pointer(); instruction_pointer.has_value()) {
+    sample.instruction_pointer(instruction_pointer.value());
+  }
+
+  if (this->_layout->is_set(PERF_SAMPLE_TID)) {
+    sample.process_id(this->process_id().value());
+    sample.thread_id(this->thread_id().value());
+  }
+
+  if (const auto time = this->time(); time.has_value()) {
+    sample.timestamp(time.value());
+  }
+
+  if (const auto stream_id = this->stream_id(); stream_id.has_value()) {
+    sample.stream_id(stream_id.value());
+  }
+
+  if (const auto logical_memory_address = this->logical_memory_address(); logical_memory_address.has_value()) {
+    sample.logical_memory_address(logical_memory_address.value());
+  }
+
+  if (const auto cpu_id = this->cpu_id(); cpu_id.has_value()) {
+    sample.cpu_id(cpu_id.value());
+  }
+
+  if (const auto period = this->period(); period.has_value()) {
+    sample.period(period.value());
+  }
+
+  if (auto counter_result = this->counter_result(); counter_result.has_value()) {
+    sample.counter_result(std::move(counter_result.value()));
+  }
+
+  if (const auto callchain = this->callchain(); !callchain.empty()) {
+    sample.callchain(std::vector<std::uintptr_t>(callchain.begin(), callchain.end()));
+  }
+
+  if (this->_layout->is_set(PERF_SAMPLE_RAW) && this->_layout->is_copy_raw()) {
+    const auto raw = this->raw();
+    sample.raw(std::vector<char>(raw.begin(), raw.end()));
+  }
+
+  if (const auto branches = this->branches(); !branches.empty()) {
+    auto sampled_branches = std::vector<Branch>{};
+    sampled_branches.reserve(branches.size());
+
+    for (const auto& branch : branches) {
+#ifndef PERFCPP_NO_SAMPLE_BRANCH_TYPE
+      sampled_branches.emplace_back(branch.from,
+                                    branch.to,
+                                    branch.mispred,
+                                    branch.predicted,
+                                    branch.in_tx,
+                                    branch.abort,
+                                    branch.cycles,
+                                    static_cast<Branch::Type>(branch.type));
+#else
+      sampled_branches.emplace_back(
+        branch.from, branch.to, branch.mispred, branch.predicted, branch.in_tx, branch.abort, branch.cycles);
+#endif
+    }
+
+    sample.branches(std::move(sampled_branches));
+  }
+
+  if (const auto abi = this->user_registers_abi(); abi.has_value()) {
+    sample.user_registers_abi(abi.value());
+
+    if (const auto user_registers = this->user_registers(); !user_registers.empty()) {
+      sample.user_registers(std::vector<std::uint64_t>(user_registers.begin(), user_registers.end()));
+    }
+  }
+
+  if (const auto weight = this->weight(); weight.has_value()) {
+    sample.weight(weight.value());
+  }
+
+  if (const auto data_source = this->data_src(); data_source.has_value()) {
+    sample.data_src(data_source.value());
+  }
+
+  if (const auto transaction_abort = this->transaction_abort(); transaction_abort.has_value()) {
+    sample.transaction_abort(transaction_abort.value());
+  }
+
+  if (const auto abi = this->kernel_registers_abi(); abi.has_value()) {
+    sample.kernel_registers_abi(abi.value());
+
+    if (const auto kernel_registers = this->kernel_registers(); !kernel_registers.empty()) {
+      sample.kernel_registers(std::vector<std::uint64_t>(kernel_registers.begin(), kernel_registers.end()));
+    }
+  }
+
+  if (const auto physical_memory_address = this->physical_memory_address(); physical_memory_address.has_value()) {
+    sample.physical_memory_address(physical_memory_address.value());
+  }
+
+  if (const auto cgroup_id = this->cgroup_id(); cgroup_id.has_value()) {
+    sample.cgroup_id(cgroup_id.value());
+  }
+
+  if (const auto data_page_size = this->data_page_size(); data_page_size.has_value()) {
+    sample.data_page_size(data_page_size.value());
+  }
+
+  if (const auto code_page_size = this->code_page_size(); code_page_size.has_value()) {
+    sample.code_page_size(code_page_size.value());
+  }
+
+  return sample;
+}
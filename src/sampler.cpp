@@ -1,7 +1,24 @@
 #include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <exception>
+#include <fcntl.h>
+#include <limits>
+#include <perfcpp/hardware_info.h>
 #include <perfcpp/sampler.h>
+#include <poll.h>
+#include <queue>
+#include <sched.h>
 #include <stdexcept>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
 #include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 #include <utility>
 
 perf::Sampler&
@@ -83,6 +100,13 @@ perf::Sampler::open()
     /// Detect, if the leader is an auxiliary (specifically for Sapphire Rapids).
     const auto is_leader_auxiliary_counter = sample_counter.group().member(0U).is_auxiliary();
 
+    /// Samples of AMD IBS triggers are decoded from the raw IBS registers, if requested.
+    const auto amd_ibs_type = this->_values._is_decode_amd_ibs
+                                ? AmdIbsDecoder::type_of(sample_counter.group().member(0U).config().type())
+                                : std::nullopt;
+    const auto sample_type =
+      this->_values.get() | (amd_ibs_type.has_value() ? std::uint64_t{ PERF_SAMPLE_RAW } : std::uint64_t{ 0U });
+
     auto group_leader_file_descriptor = -1LL;
 
     /// Open the conunters.
@@ -110,6 +134,7 @@ perf::Sampler::open()
         group_leader_file_descriptor,
         this->_config.cpu_id(),
         this->_config.process_id(),
+        this->_config.cgroup_file_descriptor(),
         this->_config.is_include_child_threads(),
         this->_config.is_include_kernel(),
         this->_config.is_include_user(),
@@ -117,15 +142,20 @@ perf::Sampler::open()
         this->_config.is_include_idle(),
         this->_config.is_include_guest(),
         this->_values.is_set(PERF_SAMPLE_READ),
-        this->_values.get(),
+        sample_type,
         this->_values.is_set(PERF_SAMPLE_BRANCH_STACK) ? std::make_optional(this->_values.branch_mask()) : std::nullopt,
         this->_values.is_set(PERF_SAMPLE_REGS_USER) ? std::make_optional(this->_values.user_registers().mask())
                                                     : std::nullopt,
         this->_values.is_set(PERF_SAMPLE_REGS_INTR) ? std::make_optional(this->_values.kernel_registers().mask())
                                                     : std::nullopt,
         this->_values.is_set(PERF_SAMPLE_CALLCHAIN) ? std::make_optional(this->_values.max_call_stack()) : std::nullopt,
+        this->_config.is_exclude_callchain_kernel(),
+        this->_config.is_exclude_callchain_user(),
         this->_values._is_include_context_switch,
-        is_include_cgroup);
+        is_include_cgroup,
+        this->_values._is_include_mmap,
+        this->_config.wakeup_events(),
+        this->_config.wakeup_watermark());
 
       /// Set the group leader file descriptor.
       if (is_leader) {
@@ -142,10 +172,14 @@ perf::Sampler::open()
       buffer_file_descriptor = sample_counter.group().member(1U).file_descriptor();
     }
 
-    /// Open the mapped buffer.
+    /// Hand the filters to the kernel, which drops samples not matching before writing them into the buffer.
+    Sampler::apply_filters(static_cast<std::int32_t>(buffer_file_descriptor), this->_config);
+
+    /// Open the mapped buffer. The buffer is mapped writable to let the kernel know which records were consumed (via
+    /// data_tail); the kernel will not overwrite records that were not consumed, yet.
     auto* buffer = ::mmap(nullptr,
                           this->_config.buffer_pages() * 4096U,
-                          PROT_READ,
+                          PROT_READ | PROT_WRITE,
                           MAP_SHARED,
                           static_cast<std::int32_t>(buffer_file_descriptor),
                           0);
@@ -157,7 +191,46 @@ perf::Sampler::open()
       throw std::runtime_error{ "Created buffer via mmap() is null." };
     }
 
-    sample_counter.buffer(buffer, this->_config.buffer_pages());
+    sample_counter.buffer(buffer, this->_config.buffer_pages(), buffer_file_descriptor);
+
+    /// Deliver a signal whenever the buffer is signaled to be readable, if requested.
+    if (const auto wakeup_signal = this->_config.wakeup_signal(); wakeup_signal.has_value()) {
+      Sampler::apply_wakeup_signal(static_cast<std::int32_t>(buffer_file_descriptor), wakeup_signal.value());
+    }
+
+    /// Map the AUX area behind the user-level buffer, if requested. The AUX area is mapped read-only in snapshot mode,
+    /// which lets the hardware overwrite the oldest trace data.
+    if (const auto aux_pages = this->_config.aux_pages(); aux_pages > 0U) {
+      if ((aux_pages & (aux_pages - 1U)) != 0U) {
+        throw std::runtime_error{ "Creating AUX area failed: The number of AUX pages must be a power of two." };
+      }
+
+      auto* mmap_page = reinterpret_cast<perf_event_mmap_page*>(buffer);
+      mmap_page->aux_offset = this->_config.buffer_pages() * 4096U;
+      mmap_page->aux_size = aux_pages * 4096U;
+
+      auto* aux_buffer = ::mmap(nullptr,
+                                aux_pages * 4096U,
+                                this->_config.is_aux_snapshot() ? PROT_READ : PROT_READ | PROT_WRITE,
+                                MAP_SHARED,
+                                static_cast<std::int32_t>(buffer_file_descriptor),
+                                static_cast<off_t>(mmap_page->aux_offset));
+      if (aux_buffer == MAP_FAILED) {
+        throw std::runtime_error{ std::string{ "Creating AUX area via mmap() failed: " }.append(std::strerror(errno)) };
+      }
+
+      sample_counter.aux_buffer(aux_buffer, aux_pages);
+    }
+
+    /// The layout of the records is fixed from now on.
+    auto layout = SampleLayout{ sample_type,
+                                this->_values.user_registers().size(),
+                                this->_values.kernel_registers().size(),
+                                sample_counter.counter_names() };
+    if (amd_ibs_type.has_value()) {
+      layout.amd_ibs(amd_ibs_type.value(), this->_values.is_set(PERF_SAMPLE_RAW));
+    }
+    sample_counter.layout(std::move(layout));
   }
 }
 
@@ -171,6 +244,7 @@ perf::Sampler::start()
   for (const auto& sample_counter : this->_sample_counter) {
     sample_counter.group().enable();
   }
+  this->_is_recording = true;
 
   return true;
 }
@@ -182,6 +256,7 @@ perf::Sampler::stop()
   for (const auto& sample_counter : this->_sample_counter) {
     sample_counter.group().disable();
   }
+  this->_is_recording = false;
 }
 
 void
@@ -191,7 +266,212 @@ perf::Sampler::close()
     /// Clear all buffers, groups, and counter names
     /// in order to enable opening again.
     this->_sample_counter.clear();
+    this->_is_recording = false;
+  }
+}
+
+std::vector<std::uint8_t>
+perf::Sampler::aux_snapshot()
+{
+  if (!this->_config.is_aux_snapshot()) {
+    throw std::runtime_error{ "Cannot take a snapshot of the AUX area: The AUX area is not in snapshot mode." };
+  }
+
+  auto snapshot = std::vector<std::uint8_t>{};
+
+  for (const auto& sample_counter : this->_sample_counter) {
+    /// Stopping the trace lets the hardware flush its data and publish aux_head.
+    if (this->_is_recording) {
+      sample_counter.group().disable();
+    }
+
+    sample_counter.read_aux(
+      [&snapshot](const std::uint8_t* first, const std::size_t first_size, const std::uint8_t* second,
+                  const std::size_t second_size) {
+        snapshot.insert(snapshot.end(), first, first + first_size);
+        snapshot.insert(snapshot.end(), second, second + second_size);
+      },
+      false);
+
+    if (this->_is_recording) {
+      sample_counter.group().enable();
+    }
+  }
+
+  return snapshot;
+}
+
+std::vector<perf::Sample>
+perf::Sampler::drain_arm_spe()
+{
+  if (this->_config.is_aux_snapshot()) {
+    throw std::runtime_error{ "Cannot drain the AUX area in snapshot mode, use aux_snapshot() instead." };
+  }
+
+  auto result = std::vector<Sample>{};
+
+  for (auto& sample_counter : this->_sample_counter) {
+    auto& decoder = sample_counter.arm_spe_decoder();
+    sample_counter.read_aux(
+      [&decoder](const std::uint8_t* first, const std::size_t first_size, const std::uint8_t* second,
+                 const std::size_t second_size) {
+        decoder.feed(first, first_size);
+        decoder.feed(second, second_size);
+      },
+      true);
+
+    auto samples = decoder.take();
+    result.insert(result.end(), std::make_move_iterator(samples.begin()), std::make_move_iterator(samples.end()));
+  }
+
+  /// Records of multiple triggers are merged by time.
+  if (this->_sample_counter.size() > 1U) {
+    std::sort(result.begin(), result.end(), SampleTimestampComparator{});
+  }
+
+  return result;
+}
+
+void
+perf::Sampler::apply_filters(const std::int32_t file_descriptor, const SampleConfig& config)
+{
+  const auto& expressions = config.filters();
+  const auto& address_filters = config.address_filters();
+  if (!expressions.empty() && !address_filters.empty()) {
+    throw std::runtime_error{ "Cannot combine filter expressions with address filters." };
+  }
+
+  /// Every PERF_EVENT_IOC_SET_FILTER replaces the filter of the event: Expressions need to be passed all, address
+  /// filters are a list of ranges.
+  auto filter = std::string{};
+  if (expressions.size() == 1U) {
+    filter = expressions.front();
+  } else {
+    for (const auto& expression : expressions) {
+      filter.append(filter.empty() ? "(" : " && (").append(expression).append(")");
+    }
+  }
+  for (const auto& address_filter : address_filters) {
+    filter.append(filter.empty() ? "" : ",").append(address_filter);
+  }
+
+  if (!filter.empty() && ::ioctl(file_descriptor, PERF_EVENT_IOC_SET_FILTER, filter.c_str()) != 0) {
+    throw std::runtime_error{ std::string{ "Setting filter \"" }
+                                .append(filter)
+                                .append("\" via ioctl() failed: ")
+                                .append(std::strerror(errno)) };
+  }
+
+  if (const auto bpf_program = config.bpf_program(); bpf_program.has_value()) {
+    if (::ioctl(file_descriptor, PERF_EVENT_IOC_SET_BPF, bpf_program.value()) != 0) {
+      throw std::runtime_error{ std::string{ "Attaching BPF program via ioctl() failed: " }.append(
+        std::strerror(errno)) };
+    }
+  }
+}
+
+void
+perf::Sampler::apply_wakeup_signal(const std::int32_t file_descriptor, const std::int32_t signal)
+{
+  /// Deliver the signal to the calling thread instead of an arbitrary thread of the process.
+  auto owner = f_owner_ex{};
+  owner.type = F_OWNER_TID;
+  owner.pid = static_cast<pid_t>(::syscall(SYS_gettid));
+
+  const auto flags = ::fcntl(file_descriptor, F_GETFL);
+  if (flags < 0 || ::fcntl(file_descriptor, F_SETFL, flags | O_ASYNC) != 0 ||
+      ::fcntl(file_descriptor, F_SETSIG, signal) != 0 || ::fcntl(file_descriptor, F_SETOWN_EX, &owner) != 0) {
+    throw std::runtime_error{ std::string{ "Setting wakeup signal via fcntl() failed: " }.append(
+      std::strerror(errno)) };
+  }
+}
+
+bool
+perf::Sampler::wait(const std::optional<std::chrono::milliseconds> timeout) const
+{
+  auto poll_file_descriptors = std::vector<pollfd>{};
+  auto sample_counters = std::vector<const SampleCounter*>{};
+  for (const auto& sample_counter : this->_sample_counter) {
+    if (sample_counter.buffer() != nullptr) {
+      auto poll_file_descriptor = pollfd{};
+      poll_file_descriptor.fd = static_cast<std::int32_t>(sample_counter.buffer_file_descriptor());
+      poll_file_descriptor.events = POLLIN;
+      poll_file_descriptors.push_back(poll_file_descriptor);
+      sample_counters.push_back(&sample_counter);
+    }
+  }
+
+  if (poll_file_descriptors.empty()) {
+    throw std::runtime_error{ "Cannot wait for samples: The sampler is not opened." };
+  }
+
+  const auto deadline = timeout.has_value()
+                          ? std::make_optional(std::chrono::steady_clock::now() + timeout.value())
+                          : std::nullopt;
+  while (true) {
+    auto timeout_milliseconds = std::int32_t{ -1 };
+    if (deadline.has_value()) {
+      const auto remaining =
+        std::chrono::duration_cast<std::chrono::milliseconds>(deadline.value() - std::chrono::steady_clock::now());
+      timeout_milliseconds = static_cast<std::int32_t>(std::max<std::int64_t>(remaining.count(), 0));
+    }
+
+    const auto count_ready = ::poll(poll_file_descriptors.data(), poll_file_descriptors.size(), timeout_milliseconds);
+    if (count_ready < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      throw std::runtime_error{ std::string{ "Waiting for samples via poll() failed: " }.append(std::strerror(errno)) };
+    }
+
+    if (count_ready == 0) {
+      return false;
+    }
+
+    /// Counters that hung up (e.g., the monitored process exited) report POLLHUP on every poll, but no longer POLLIN:
+    /// Their remaining records can be read, afterward, they are ignored (poll() skips negative file descriptors).
+    auto is_readable = false;
+    for (auto i = 0U; i < poll_file_descriptors.size(); ++i) {
+      auto& poll_file_descriptor = poll_file_descriptors[i];
+      if ((poll_file_descriptor.revents & POLLIN) != 0) {
+        is_readable = true;
+      } else if ((poll_file_descriptor.revents & (POLLHUP | POLLERR | POLLNVAL)) != 0) {
+        if (sample_counters[i]->has_records()) {
+          is_readable = true;
+        } else {
+          poll_file_descriptor.fd = -1;
+        }
+      }
+    }
+
+    if (is_readable) {
+      return true;
+    }
+
+    const auto is_hung_up = std::all_of(poll_file_descriptors.begin(),
+                                        poll_file_descriptors.end(),
+                                        [](const pollfd& poll_file_descriptor) { return poll_file_descriptor.fd < 0; });
+    if (is_hung_up) {
+      return false;
+    }
+  }
+}
+
+bool
+perf::Sampler::update_period(std::uint64_t period)
+{
+  if (!this->_is_opened) {
+    return false;
+  }
+
+  auto is_updated = true;
+  for (const auto& sample_counter : this->_sample_counter) {
+    const auto file_descriptor = static_cast<std::int32_t>(sample_counter.group().leader_file_descriptor());
+    is_updated &= file_descriptor > -1 && ::ioctl(file_descriptor, PERF_EVENT_IOC_PERIOD, &period) == 0;
   }
+
+  return is_updated;
 }
 
 perf::Sampler::SampleCounter
@@ -261,6 +541,16 @@ perf::Sampler::transform_trigger_to_sample_counter(const std::vector<std::tuple<
       }
     }
 
+    /// Intel's top-down metric events can only be read (not sampled) in a group led by the slots event.
+    if (HardwareInfo::is_intel()) {
+      for (auto member_id = 0U; member_id < group.size(); ++member_id) {
+        if (group.member(member_id).is_intel_topdown_metric() &&
+            (member_id < triggers.size() || !group.member(0U).is_intel_topdown_slots())) {
+          throw std::runtime_error{ "Top-down metric events cannot trigger samples and require 'slots' as trigger." };
+        }
+      }
+    }
+
     if (!counter_names.empty()) {
       return SampleCounter{std::move(group), std::move(counter_names)};
     }
@@ -275,51 +565,184 @@ perf::Sampler::result(const bool sort_by_time) const
   auto result = std::vector<Sample>{};
   result.reserve(2048U);
 
+  /// Read all records without handing them back to the perf subsystem.
   for (const auto& sample_counter : this->_sample_counter) {
-    if (sample_counter.buffer() == nullptr) {
-      continue;
-    }
+    this->read_samples(sample_counter, false, result);
+  }
+
+  /// Sort the samples if requested and we can sort by time.
+  if (this->_values.is_set(PERF_SAMPLE_TIME) && sort_by_time) {
+    std::sort(result.begin(), result.end(), SampleTimestampComparator{});
+  }
+
+  return result;
+}
+
+std::vector<perf::Sample>
+perf::Sampler::drain(const bool sort_by_time)
+{
+  auto result = std::vector<Sample>{};
+
+  /// Read all new records and hand the space back to the perf subsystem.
+  for (const auto& sample_counter : this->_sample_counter) {
+    this->read_samples(sample_counter, true, result);
+  }
+
+  /// Sort the samples if requested and we can sort by time.
+  if (this->_values.is_set(PERF_SAMPLE_TIME) && sort_by_time) {
+    std::sort(result.begin(), result.end(), SampleTimestampComparator{});
+  }
+
+  return result;
+}
+
+void
+perf::Sampler::result(perf::SampleArena& arena, const bool sort_by_time) const
+{
+  arena.clear();
+
+  for (const auto& sample_counter : this->_sample_counter) {
+    this->read_samples(sample_counter, false, arena);
+  }
 
-    auto* mmap_page = reinterpret_cast<perf_event_mmap_page*>(sample_counter.buffer());
+  if (this->_values.is_set(PERF_SAMPLE_TIME) && sort_by_time) {
+    arena.sort_by_time();
+  }
+}
+
+void
+perf::Sampler::drain(perf::SampleArena& arena, const bool sort_by_time)
+{
+  arena.clear();
+
+  for (const auto& sample_counter : this->_sample_counter) {
+    this->read_samples(sample_counter, true, arena);
+  }
+
+  if (this->_values.is_set(PERF_SAMPLE_TIME) && sort_by_time) {
+    arena.sort_by_time();
+  }
+}
+
+void
+perf::Sampler::result(perf::SampleBatch& batch, const bool sort_by_time) const
+{
+  batch.clear();
+
+  for (const auto& sample_counter : this->_sample_counter) {
+    this->read_samples(sample_counter, false, batch);
+  }
+
+  if (this->_values.is_set(PERF_SAMPLE_TIME) && sort_by_time) {
+    batch.sort_by_time();
+  }
+}
+
+void
+perf::Sampler::drain(perf::SampleBatch& batch, const bool sort_by_time)
+{
+  batch.clear();
+
+  for (const auto& sample_counter : this->_sample_counter) {
+    this->read_samples(sample_counter, true, batch);
+  }
+
+  if (this->_values.is_set(PERF_SAMPLE_TIME) && sort_by_time) {
+    batch.sort_by_time();
+  }
+}
 
-    /// When the ringbuffer is empty or already read, there is nothing to do.
-    if (mmap_page->data_tail >= mmap_page->data_head) {
-      return result;
+std::optional<perf::TimeConversion>
+perf::Sampler::time_conversion() const
+{
+  for (const auto& sample_counter : this->_sample_counter) {
+    if (sample_counter.buffer() != nullptr) {
+      return TimeConversion::from(reinterpret_cast<const perf_event_mmap_page*>(sample_counter.buffer()));
     }
+  }
+
+  return std::nullopt;
+}
+
+std::vector<std::int64_t>
+perf::Sampler::buffer_file_descriptors() const
+{
+  auto file_descriptors = std::vector<std::int64_t>{};
+  file_descriptors.reserve(this->_sample_counter.size());
 
-    /// The buffer starts at page 1 (from 0).
-    auto iterator = std::uintptr_t(sample_counter.buffer()) + 4096U;
+  for (const auto& sample_counter : this->_sample_counter) {
+    if (sample_counter.buffer() != nullptr) {
+      file_descriptors.push_back(sample_counter.buffer_file_descriptor());
+    }
+  }
 
-    /// data_head is the size (in bytes) of the samples.
-    const auto end = iterator + mmap_page->data_head;
+  return file_descriptors;
+}
 
-    while (iterator < end) {
-      auto* event_header = reinterpret_cast<perf_event_header*>(iterator);
+void
+perf::Sampler::read_samples(const perf::Sampler::SampleCounter& sample_counter,
+                            const bool is_consume,
+                            std::vector<Sample>& result) const
+{
+  sample_counter.read_records(
+    [this, &sample_counter, &result](perf_event_header* event_header) {
       auto entry = UserLevelBufferEntry{ event_header };
 
       if (entry.is_sample_event()) { /// Read "normal" samples.
-        result.push_back(this->read_sample_event(entry, sample_counter));
+        result.push_back(SampleView{ event_header, sample_counter.layout() }.to_sample());
       } else if (entry.is_loss_event()) { /// Read lost samples.
         result.push_back(this->read_loss_event(entry));
+      } else if (entry.is_lost_event()) { /// Read samples lost due to a full buffer.
+        result.push_back(this->read_lost_event(entry));
       } else if (entry.is_context_switch_event()) { /// Read context switch.
         result.push_back(this->read_context_switch_event(entry));
       } else if (entry.is_cgroup_event()) { /// Read cgroup samples.
         result.push_back(Sampler::read_cgroup_event(entry));
       } else if (entry.is_throttle_event() && this->_values._is_include_throttle) { /// Read (un-) throttle samples.
         result.push_back(this->read_throttle_event(entry));
+      } else if (entry.is_mmap_event()) { /// Read memory mappings.
+        result.push_back(this->read_mmap_event(entry));
       }
+    },
+    is_consume);
+}
 
-      /// Go to the next sample.
-      iterator += event_header->size;
-    }
-  }
-
-  /// Sort the samples if requested and we can sort by time.
-  if (this->_values.is_set(PERF_SAMPLE_TIME) && sort_by_time) {
-    std::sort(result.begin(), result.end(), SampleTimestampComparator{});
-  }
+void
+perf::Sampler::read_samples(const perf::Sampler::SampleCounter& sample_counter,
+                            const bool is_consume,
+                            perf::SampleArena& arena) const
+{
+  arena.layout(sample_counter.layout());
+
+  sample_counter.read_records(
+    [this, &arena](perf_event_header* event_header) {
+      if (event_header->type == PERF_RECORD_SAMPLE) {
+        arena.add(event_header);
+      } else if (event_header->type == PERF_RECORD_LOST) {
+        arena.add_loss(this->read_lost_event(UserLevelBufferEntry{ event_header }).count_loss().value_or(0U));
+      } else if (event_header->type == PERF_RECORD_THROTTLE) {
+        arena.add_throttle();
+      }
+    },
+    is_consume);
+}
 
-  return result;
+void
+perf::Sampler::read_samples(const perf::Sampler::SampleCounter& sample_counter,
+                            const bool is_consume,
+                            perf::SampleBatch& batch) const
+{
+  sample_counter.read_records(
+    [this, &sample_counter, &batch](perf_event_header* event_header) {
+      if (event_header->type == PERF_RECORD_SAMPLE) {
+        batch.add(SampleView{ event_header, sample_counter.layout() });
+      } else if (event_header->type == PERF_RECORD_LOST) {
+        batch.add_loss(this->read_lost_event(UserLevelBufferEntry{ event_header }).count_loss().value_or(0U));
+      } else if (event_header->type == PERF_RECORD_THROTTLE) {
+        batch.add_throttle();
+      }
+    },
+    is_consume);
 }
 
 void
@@ -367,320 +790,595 @@ perf::Sampler::UserLevelBufferEntry::mode() const noexcept
 }
 
 perf::Sample
-perf::Sampler::read_sample_event(perf::Sampler::UserLevelBufferEntry entry, const SampleCounter& sample_counter) const
+perf::Sampler::read_loss_event(perf::Sampler::UserLevelBufferEntry entry) const
 {
   auto sample = Sample{ entry.mode() };
 
-  sample.is_exact_ip(entry.is_exact_ip());
+  sample.count_loss(entry.read<std::uint64_t>());
 
-  if (this->_values.is_set(PERF_SAMPLE_IDENTIFIER)) {
-    sample.sample_id(entry.read<std::uint64_t>());
-  }
+  /// Read sample_id.
+  this->read_sample_id(entry, sample);
 
-  if (this->_values.is_set(PERF_SAMPLE_IP)) {
-    sample.instruction_pointer(entry.read<std::uintptr_t>());
-  }
+  return sample;
+}
 
-  if (this->_values.is_set(PERF_SAMPLE_TID)) {
-    sample.process_id(entry.read<std::uint32_t>());
-    sample.thread_id(entry.read<std::uint32_t>());
-  }
+perf::Sample
+perf::Sampler::read_lost_event(perf::Sampler::UserLevelBufferEntry entry) const
+{
+  auto sample = Sample{ entry.mode() };
 
-  if (this->_values.is_set(PERF_SAMPLE_TIME)) {
-    sample.timestamp(entry.read<std::uint64_t>());
-  }
+  /// The record starts with the id of the event that lost samples, followed by the number of lost samples.
+  sample.id(entry.read<std::uint64_t>());
+  sample.count_loss(entry.read<std::uint64_t>());
 
-  if (this->_values.is_set(PERF_SAMPLE_STREAM_ID)) {
-    sample.stream_id(entry.read<std::uint64_t>());
-  }
+  /// Read sample_id.
+  this->read_sample_id(entry, sample);
 
-  if (this->_values.is_set(PERF_SAMPLE_ADDR)) {
-    sample.logical_memory_address(entry.read<std::uint64_t>());
-  }
+  return sample;
+}
 
-  if (this->_values.is_set(PERF_SAMPLE_CPU)) {
-    sample.cpu_id(entry.read<std::uint32_t>());
-    entry.skip<std::uint32_t>(); /// Skip "res".
-  }
+perf::Sample
+perf::Sampler::read_context_switch_event(perf::Sampler::UserLevelBufferEntry entry) const
+{
+  auto sample = Sample{ entry.mode() };
 
-  if (this->_values.is_set(PERF_SAMPLE_PERIOD)) {
-    sample.period(entry.read<std::uint64_t>());
-  }
+  const auto is_switch_out = entry.is_context_switch_out();
+  const auto is_switch_out_preempt = entry.is_context_switch_out_preempt();
 
-  if (this->_values.is_set(PERF_SAMPLE_READ)) {
-    /// Read the number of counters.
-    const auto count_counter_values = entry.read<typeof(CounterReadFormat<Group::MAX_MEMBERS>::count_members)>();
+  std::optional<std::uint32_t> process_id{ std::nullopt };
+  std::optional<std::uint32_t> thread_id{ std::nullopt };
 
-    /// Time enabled and running for correction.
-    const auto time_enabled = entry.read<typeof(CounterReadFormat<Group::MAX_MEMBERS>::time_enabled)>();
-    const auto time_running = entry.read<typeof(CounterReadFormat<Group::MAX_MEMBERS>::time_running)>();
-    const auto multiplexing_correction = double(time_enabled) / double(time_running);
+  /// CPU wide context switches contain the process and thread ids.
+  if (entry.is_context_switch_cpu_wide()) {
+    process_id = entry.read<std::uint32_t>();
+    thread_id = entry.read<std::uint32_t>();
+  }
 
-    /// Read the counters (if the number matches the number of specified counters).
-    auto* counter_values = entry.read<CounterReadFormat<Group::MAX_MEMBERS>::value>(count_counter_values);
-    if (count_counter_values == sample_counter.group().size()) {
-      auto counter_results = std::vector<std::pair<std::string_view, double>>{};
+  /// Read sample_id.
+  this->read_sample_id(entry, sample);
 
-      /// Add each counter and its value to the result set of the sample.
-      for (auto counter_id = 0U; counter_id < sample_counter.group().size(); ++counter_id) {
-        const auto counter_name = sample_counter.counter_names()[counter_id];
+  sample.context_switch(ContextSwitch{ is_switch_out, is_switch_out_preempt, process_id, thread_id });
 
-        /// Counter value (corrected).
-        const auto counter_result = double(counter_values[counter_id].value) * multiplexing_correction;
+  return sample;
+}
 
-        counter_results.emplace_back(counter_name, counter_result);
-      }
-      sample.counter_result(CounterResult{ std::move(counter_results) });
-    }
-  }
+perf::Sample
+perf::Sampler::read_cgroup_event(perf::Sampler::UserLevelBufferEntry entry)
+{
+  auto sample = Sample{ entry.mode() };
 
-  if (this->_values.is_set(PERF_SAMPLE_CALLCHAIN)) {
-    /// Read the size of the callchain.
-    const auto callchain_size = entry.read<std::uint64_t>();
+  const auto cgroup_id = entry.read<std::uint64_t>();
+  auto* path = entry.as<const char*>();
 
-    if (callchain_size > 0U) {
-      auto callchain = std::vector<std::uintptr_t>{};
-      callchain.reserve(callchain_size);
+  sample.cgroup(CGroup{ cgroup_id, std::string{ path } });
 
-      /// Read the callchain entries.
-      auto* instruction_pointers = entry.read<std::uint64_t>(callchain_size);
-      for (auto index = 0U; index < callchain_size; ++index) {
-        callchain.push_back(std::uintptr_t{ instruction_pointers[index] });
-      }
+  return sample;
+}
 
-      sample.callchain(std::move(callchain));
-    }
+perf::Sample
+perf::Sampler::read_mmap_event(perf::Sampler::UserLevelBufferEntry entry) const
+{
+  auto sample = Sample{ entry.mode() };
+
+  const auto process_id = entry.read<std::uint32_t>();
+  const auto thread_id = entry.read<std::uint32_t>();
+  const auto address = entry.read<std::uint64_t>();
+  const auto length = entry.read<std::uint64_t>();
+  const auto page_offset = entry.read<std::uint64_t>();
+
+  auto inode = std::optional<std::uint64_t>{ std::nullopt };
+  auto protection = std::optional<std::uint32_t>{ std::nullopt };
+  if (entry.is_mmap2()) {
+    /// MMAP2 records contain either the device and inode or the build id of the mapped file.
+    entry.skip<std::uint32_t>(2U); /// Skip major and minor device or build id size.
+    const auto record_inode = entry.read<std::uint64_t>();
+    entry.skip<std::uint64_t>(); /// Skip inode generation or build id.
+    if (!entry.is_mmap_build_id()) {
+      inode = record_inode;
+    }
+
+    protection = entry.read<std::uint32_t>();
+    entry.skip<std::uint32_t>(); /// Skip flags.
   }
 
-  if (this->_values.is_set(PERF_SAMPLE_RAW)) {
-    /// Read the size of the raw sample.
-    const auto raw_data_size = entry.read<std::uint32_t>();
+  /// The path is padded to a multiple of 8 bytes.
+  auto path = std::string{ entry.as<const char*>() };
+  entry.skip<char>((path.size() + 1U + 7U) & ~std::size_t{ 7U });
 
-    /// Read the raw data.
-    const auto* raw_sample_data = entry.read<char>(raw_data_size);
-    auto raw_data = std::vector<char>(std::size_t{ raw_data_size }, '\0');
-    for (auto i = 0U; i < raw_data_size; ++i) {
-      raw_data[i] = raw_sample_data[i];
-    }
+  /// Read sample_id.
+  this->read_sample_id(entry, sample);
+
+  sample.mmap(Mmap{ process_id, thread_id, address, length, page_offset, inode, protection, std::move(path) });
+
+  return sample;
+}
+
+perf::Sample
+perf::Sampler::read_throttle_event(perf::Sampler::UserLevelBufferEntry entry) const
+{
+  auto sample = Sample{ entry.mode() };
+
+  if (this->_values.is_set(PERF_SAMPLE_TIME)) {
+    sample.timestamp(entry.read<std::uint64_t>());
+  }
 
-    sample.raw(std::move(raw_data));
+  if (this->_values.is_set(PERF_SAMPLE_STREAM_ID)) {
+    sample.stream_id(entry.read<std::uint64_t>());
   }
 
-  if (this->_values.is_set(PERF_SAMPLE_BRANCH_STACK)) {
-    /// Read the size of the branch stack.
-    const auto count_branches = entry.read<std::uint64_t>();
+  /// Read sample_id.
+  this->read_sample_id(entry, sample);
 
-    if (count_branches > 0U) {
-      auto branches = std::vector<Branch>{};
-      branches.reserve(count_branches);
+  sample.throttle(Throttle{ entry.is_throttle() });
 
-      /// Read the branch stack entries.
-      auto* sampled_branches = entry.read<perf_branch_entry>(count_branches);
-      for (auto i = 0U; i < count_branches; ++i) {
-        const auto& branch = sampled_branches[i];
-        branches.emplace_back(
-          branch.from, branch.to, branch.mispred, branch.predicted, branch.in_tx, branch.abort, branch.cycles);
-      }
+  return sample;
+}
 
-      sample.branches(std::move(branches));
-    }
+perf::Sampler::SampleCounter::~SampleCounter()
+{
+  /// Free the AUX area and the buffer (if mmap-ed); the AUX area has to be unmapped first.
+  if (this->_aux_buffer != nullptr) {
+    ::munmap(this->_aux_buffer, this->_aux_pages * 4096U);
   }
 
-  if (this->_values.is_set(PERF_SAMPLE_REGS_USER)) {
-    /// Read the register ABI.
-    sample.user_registers_abi(entry.read<std::uint64_t>());
+  if (this->_buffer != nullptr) {
+    ::munmap(this->_buffer, this->_buffer_pages * 4096U);
+  }
 
-    /// Read the number of registers.
-    const auto count_user_registers = this->_values.user_registers().size();
+  /// Close the group.
+  if (this->_group.leader_file_descriptor() > -1) {
+    this->_group.close();
+  }
+}
 
-    if (count_user_registers > 0U) {
-      auto user_registers = std::vector<std::uint64_t>{};
-      user_registers.reserve(count_user_registers);
+perf::SampleDrainer::SampleDrainer(const std::size_t count_samplers,
+                                   const std::uint16_t count_threads,
+                                   perf::SampleQueue* queue)
+  : SampleDrainer(
+      SampleDrainer::round_robin(count_samplers, count_threads),
+      std::vector<std::vector<std::uint16_t>>(
+        std::max<std::size_t>(1U, std::min<std::size_t>(count_threads, count_samplers))),
+      queue)
+{
+}
 
-      /// Read the register values.
-      const auto* perf_user_registers = entry.read<std::uint64_t>(count_user_registers);
-      for (auto register_id = 0U; register_id < count_user_registers; ++register_id) {
-        user_registers.push_back(perf_user_registers[register_id]);
-      }
+perf::SampleDrainer::SampleDrainer(std::vector<std::size_t>&& worker_ids,
+                                   std::vector<std::vector<std::uint16_t>>&& worker_cpu_ids,
+                                   perf::SampleQueue* queue)
+  : _worker_ids(std::move(worker_ids))
+  , _worker_cpu_ids(std::move(worker_cpu_ids))
+  , _queue(queue)
+{
+  this->_slots.reserve(this->_worker_ids.size());
+  for (auto sampler_id = 0U; sampler_id < this->_worker_ids.size(); ++sampler_id) {
+    this->_slots.emplace_back(std::make_unique<Slot>());
+  }
 
-      sample.user_registers(std::move(user_registers));
-    }
+  /// The stop event is written once and never read; it wakes up all threads that wait for it.
+  this->_stop_file_descriptor = ::eventfd(0U, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (this->_stop_file_descriptor < 0) {
+    throw std::runtime_error{ std::string{ "Cannot create eventfd for background drain: " }.append(
+      std::strerror(errno)) };
   }
 
-  if (this->_values.is_set(PERF_SAMPLE_WEIGHT)) {
-    sample.weight(perf::Weight{ static_cast<std::uint32_t>(entry.read<std::uint64_t>()) });
+  for (auto thread_id = 0U; thread_id < std::max<std::size_t>(1U, this->_worker_cpu_ids.size()); ++thread_id) {
+    const auto epoll_file_descriptor = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_file_descriptor < 0) {
+      throw std::runtime_error{ std::string{ "Cannot create epoll instance for background drain: " }.append(
+        std::strerror(errno)) };
+    }
+
+    auto event = epoll_event{};
+    event.events = EPOLLIN;
+    event.data.u64 = std::numeric_limits<std::uint64_t>::max();
+    ::epoll_ctl(epoll_file_descriptor, EPOLL_CTL_ADD, this->_stop_file_descriptor, &event);
+
+    this->_epoll_file_descriptors.push_back(epoll_file_descriptor);
   }
+  this->_worker_cpu_ids.resize(this->_epoll_file_descriptors.size());
 
-#ifndef PERFCPP_NO_SAMPLE_WEIGHT_STRUCT
-  else if (this->_values.is_set(PERF_SAMPLE_WEIGHT_STRUCT)) {
-    const auto weight_struct = entry.read<perf_sample_weight>();
-    sample.weight(perf::Weight{ weight_struct.var1_dw, weight_struct.var2_w, weight_struct.var3_w });
+  for (auto thread_id = 0U; thread_id < this->_epoll_file_descriptors.size(); ++thread_id) {
+    this->_threads.emplace_back(
+      &SampleDrainer::run, this, this->_epoll_file_descriptors[thread_id], std::cref(this->_worker_cpu_ids[thread_id]));
   }
-#endif
+}
 
-  if (this->_values.is_set(PERF_SAMPLE_DATA_SRC)) {
-    sample.data_src(perf::DataSource{ entry.read<std::uint64_t>() });
+std::vector<std::size_t>
+perf::SampleDrainer::round_robin(const std::size_t count_samplers, const std::uint16_t count_threads)
+{
+  const auto count_workers = std::max<std::size_t>(1U, std::min<std::size_t>(count_threads, count_samplers));
+
+  auto worker_ids = std::vector<std::size_t>(count_samplers);
+  for (auto sampler_id = 0U; sampler_id < count_samplers; ++sampler_id) {
+    worker_ids[sampler_id] = sampler_id % count_workers;
   }
 
-  if (this->_values.is_set(PERF_SAMPLE_TRANSACTION)) {
-    sample.transaction_abort(TransactionAbort{ entry.read<std::uint64_t>() });
+  return worker_ids;
+}
+
+perf::SampleDrainer::~SampleDrainer()
+{
+  /// Signal all threads to stop.
+  this->_is_stopping.store(true);
+  const auto value = std::uint64_t{ 1U };
+  std::ignore = ::write(this->_stop_file_descriptor, &value, sizeof(value));
+
+  for (auto& thread : this->_threads) {
+    thread.join();
   }
 
-  if (this->_values.is_set(PERF_SAMPLE_REGS_INTR)) {
-    /// Read the register ABI.
-    sample.kernel_registers_abi(entry.read<std::uint64_t>());
+  for (const auto epoll_file_descriptor : this->_epoll_file_descriptors) {
+    ::close(epoll_file_descriptor);
+  }
 
-    /// Read the number of registers.
-    const auto count_kernel_registers = this->_values.kernel_registers().size();
+  ::close(this->_stop_file_descriptor);
+}
 
-    if (count_kernel_registers > 0U) {
-      auto kernel_registers = std::vector<std::uint64_t>{};
-      kernel_registers.reserve(count_kernel_registers);
+void
+perf::SampleDrainer::add(const std::size_t sampler_id, perf::Sampler& sampler)
+{
+  auto& slot = *this->_slots[sampler_id];
+  const auto lock = std::lock_guard{ slot.mutex };
 
-      /// Read the register values.
-      const auto* perf_kernel_registers = entry.read<std::uint64_t>(count_kernel_registers);
-      for (auto register_id = 0U; register_id < count_kernel_registers; ++register_id) {
-        kernel_registers.push_back(perf_kernel_registers[register_id]);
-      }
+  if (slot.sampler != nullptr) {
+    return;
+  }
 
-      sample.kernel_registers(std::move(kernel_registers));
+  slot.sampler = &sampler;
+  slot.file_descriptors = sampler.buffer_file_descriptors();
+
+  for (const auto file_descriptor : slot.file_descriptors) {
+    auto event = epoll_event{};
+    event.events = EPOLLIN;
+    event.data.u64 = (std::uint64_t(sampler_id) << 32U) | std::uint64_t(file_descriptor);
+    if (::epoll_ctl(this->epoll_file_descriptor(sampler_id),
+                    EPOLL_CTL_ADD,
+                    static_cast<std::int32_t>(file_descriptor),
+                    &event) != 0) {
+      throw std::runtime_error{ std::string{ "Cannot register sampler for background drain: " }.append(
+        std::strerror(errno)) };
     }
   }
+}
 
-#ifndef PERFCPP_NO_SAMPLE_PHYS_ADDR
-  if (this->_values.is_set(PERF_SAMPLE_PHYS_ADDR)) {
-    sample.physical_memory_address(entry.read<std::uint64_t>());
+void
+perf::SampleDrainer::remove(const std::size_t sampler_id)
+{
+  auto& slot = *this->_slots[sampler_id];
+  auto lock = std::unique_lock{ slot.mutex };
+
+  /// Hand the samples that are left in the buffer to the consumers of the queue.
+  if (this->_queue != nullptr && slot.sampler != nullptr) {
+    auto batch = SampleBatch{};
+    slot.sampler->drain(batch, false);
+    if (!batch.empty()) {
+      this->enqueue(batch);
+    }
   }
-#endif
 
-  if (this->_values.is_set(PERF_SAMPLE_CGROUP)) {
-    sample.cgroup_id(entry.read<std::uint64_t>());
+  /// Deregistering may fail for file descriptors that were already removed after a hang-up; this is fine.
+  for (const auto file_descriptor : slot.file_descriptors) {
+    ::epoll_ctl(
+      this->epoll_file_descriptor(sampler_id), EPOLL_CTL_DEL, static_cast<std::int32_t>(file_descriptor), nullptr);
   }
 
-#ifndef PERFCPP_NO_SAMPLE_DATA_PAGE_SIZE
-  if (this->_values.is_set(PERF_SAMPLE_DATA_PAGE_SIZE)) {
-    sample.data_page_size(entry.read<std::uint64_t>());
-  }
-#endif
+  slot.sampler = nullptr;
+  slot.file_descriptors.clear();
+  slot.samples.clear();
+}
 
-#ifndef PERFCPP_NO_SAMPLE_CODE_PAGE_SIZE
-  if (this->_values.is_set(PERF_SAMPLE_CODE_PAGE_SIZE)) {
-    sample.code_page_size(entry.read<std::uint64_t>());
+std::vector<perf::Sample>
+perf::SampleDrainer::result(const std::size_t sampler_id) const
+{
+  const auto& slot = *this->_slots[sampler_id];
+  const auto lock = std::lock_guard{ slot.mutex };
+
+  auto result = slot.samples;
+  if (slot.sampler != nullptr) {
+    auto samples = slot.sampler->result(false);
+    std::move(samples.begin(), samples.end(), std::back_inserter(result));
   }
-#endif
 
-  return sample;
+  return result;
 }
 
-perf::Sample
-perf::Sampler::read_loss_event(perf::Sampler::UserLevelBufferEntry entry) const
+std::vector<perf::Sample>
+perf::SampleDrainer::drain(const std::size_t sampler_id)
 {
-  auto sample = Sample{ entry.mode() };
+  auto& slot = *this->_slots[sampler_id];
+  const auto lock = std::lock_guard{ slot.mutex };
 
-  sample.count_loss(entry.read<std::uint64_t>());
+  auto result = std::move(slot.samples);
+  slot.samples = std::vector<Sample>{};
 
-  /// Read sample_id.
-  this->read_sample_id(entry, sample);
+  if (slot.sampler != nullptr) {
+    auto samples = slot.sampler->drain(false);
+    std::move(samples.begin(), samples.end(), std::back_inserter(result));
+  }
 
-  return sample;
+  return result;
 }
 
-perf::Sample
-perf::Sampler::read_context_switch_event(perf::Sampler::UserLevelBufferEntry entry) const
+void
+perf::SampleDrainer::run(const std::int32_t epoll_file_descriptor, const std::vector<std::uint16_t>& cpu_ids)
 {
-  auto sample = Sample{ entry.mode() };
+  /// Pin the worker to its CPUs, such that the buffers are read (and the samples allocated) node-locally.
+  if (!cpu_ids.empty()) {
+    auto affinity = cpu_set_t{};
+    CPU_ZERO(&affinity);
+    for (const auto cpu_id : cpu_ids) {
+      CPU_SET(cpu_id, &affinity);
+    }
+    std::ignore = ::sched_setaffinity(0, sizeof(cpu_set_t), &affinity);
+  }
 
-  const auto is_switch_out = entry.is_context_switch_out();
-  const auto is_switch_out_preempt = entry.is_context_switch_out_preempt();
+  auto events = std::array<epoll_event, 64U>{};
 
-  std::optional<std::uint32_t> process_id{ std::nullopt };
-  std::optional<std::uint32_t> thread_id{ std::nullopt };
+  /// Batch of drained samples, handed to the queue; the queue returns a batch with allocated memory for reuse.
+  auto batch = SampleBatch{};
 
-  /// CPU wide context switches contain the process and thread ids.
-  if (entry.is_context_switch_cpu_wide()) {
-    process_id = entry.read<std::uint32_t>();
-    thread_id = entry.read<std::uint32_t>();
+  while (true) {
+    const auto count_events = ::epoll_wait(epoll_file_descriptor, events.data(), std::int32_t(events.size()), -1);
+    if (count_events < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      return;
+    }
+
+    for (auto event_id = 0; event_id < count_events; ++event_id) {
+      const auto& event = events[std::size_t(event_id)];
+
+      if (event.data.u64 == std::numeric_limits<std::uint64_t>::max()) {
+        return;
+      }
+
+      const auto sampler_id = std::size_t(event.data.u64 >> 32U);
+      auto& slot = *this->_slots[sampler_id];
+      auto lock = std::unique_lock{ slot.mutex };
+
+      if (slot.sampler == nullptr) {
+        continue;
+      }
+
+      if (this->_queue != nullptr) {
+        /// The batch is pushed without holding the lock, such that a waiting push does not block the user.
+        slot.sampler->drain(batch, false);
+        lock.unlock();
+        if (!batch.empty()) {
+          this->enqueue(batch);
+        }
+      } else {
+        auto samples = slot.sampler->drain(false);
+        std::move(samples.begin(), samples.end(), std::back_inserter(slot.samples));
+      }
+
+      /// The monitored thread exited; the counter will not produce any further records.
+      if ((event.events & EPOLLHUP) != 0U) {
+        ::epoll_ctl(epoll_file_descriptor,
+                    EPOLL_CTL_DEL,
+                    static_cast<std::int32_t>(event.data.u64 & std::numeric_limits<std::uint32_t>::max()),
+                    nullptr);
+      }
+    }
   }
+}
 
-  /// Read sample_id.
-  this->read_sample_id(entry, sample);
+void
+perf::MultiSamplerBase::background_drain(const std::uint16_t count_threads)
+{
+  this->background_drain(std::make_unique<SampleDrainer>(this->samplers().size(), count_threads));
+}
 
-  sample.context_switch(ContextSwitch{ is_switch_out, is_switch_out_preempt, process_id, thread_id });
+void
+perf::SampleDrainer::enqueue(perf::SampleBatch& batch)
+{
+  if (this->_queue->backpressure() != SampleQueue::Backpressure::Block) {
+    std::ignore = this->_queue->push(batch);
+    return;
+  }
 
-  return sample;
+  while (!this->_queue->try_push(batch)) {
+    if (this->_queue->is_closed() || this->_is_stopping.load(std::memory_order_relaxed)) {
+      batch.clear();
+      return;
+    }
+    std::this_thread::yield();
+  }
 }
 
-perf::Sample
-perf::Sampler::read_cgroup_event(perf::Sampler::UserLevelBufferEntry entry)
+void
+perf::MultiSamplerBase::background_drain(perf::SampleQueue& queue, const std::uint16_t count_threads)
 {
-  auto sample = Sample{ entry.mode() };
+  this->background_drain(std::make_unique<SampleDrainer>(this->samplers().size(), count_threads, &queue));
+}
 
-  const auto cgroup_id = entry.read<std::uint64_t>();
-  auto* path = entry.as<const char*>();
+void
+perf::MultiSamplerBase::background_drain(std::unique_ptr<SampleDrainer>&& drainer)
+{
+  /// Replacing the drainer would discard the queued samples.
+  if (this->_drainer != nullptr) {
+    throw std::runtime_error{ "Background drain is already enabled." };
+  }
 
-  sample.cgroup(CGroup{ cgroup_id, std::string{ path } });
+  this->_drainer = std::move(drainer);
 
-  return sample;
+  /// Register samplers that are already opened.
+  auto& samplers = this->samplers();
+  for (auto sampler_id = 0U; sampler_id < samplers.size(); ++sampler_id) {
+    if (samplers[sampler_id]._is_opened) {
+      this->_drainer->add(sampler_id, samplers[sampler_id]);
+    }
+  }
 }
 
-perf::Sample
-perf::Sampler::read_throttle_event(perf::Sampler::UserLevelBufferEntry entry) const
+void
+perf::MultiSamplerBase::close()
 {
-  auto sample = Sample{ entry.mode() };
+  auto& samplers = this->samplers();
+  for (auto sampler_id = 0U; sampler_id < samplers.size(); ++sampler_id) {
+    /// Ensure that the background threads do not access the buffer after unmapping it.
+    if (this->_drainer != nullptr) {
+      this->_drainer->remove(sampler_id);
+    }
 
-  if (this->_values.is_set(PERF_SAMPLE_TIME)) {
-    sample.timestamp(entry.read<std::uint64_t>());
+    samplers[sampler_id].close();
   }
+}
 
-  if (this->_values.is_set(PERF_SAMPLE_STREAM_ID)) {
-    sample.stream_id(entry.read<std::uint64_t>());
+template<typename F>
+void
+perf::MultiSamplerBase::for_each_parallel(const std::size_t count_samplers, F&& callback)
+{
+  const auto count_threads = std::max<std::size_t>(
+    1U, std::min<std::size_t>(count_samplers, std::size_t{ std::thread::hardware_concurrency() }));
+
+  /// Exceptions are caught per thread and re-thrown in the calling thread.
+  auto exceptions = std::vector<std::exception_ptr>(count_threads);
+  const auto run = [&callback, &exceptions, count_samplers, count_threads](const std::size_t thread_id) {
+    try {
+      for (auto sampler_id = thread_id; sampler_id < count_samplers; sampler_id += count_threads) {
+        callback(sampler_id);
+      }
+    } catch (...) {
+      exceptions[thread_id] = std::current_exception();
+    }
+  };
+
+  /// Spawn threads for all but the first share of samplers, which is processed by the calling thread.
+  auto threads = std::vector<std::thread>{};
+  threads.reserve(count_threads - 1U);
+  for (auto thread_id = std::size_t{ 1U }; thread_id < count_threads; ++thread_id) {
+    threads.emplace_back(run, thread_id);
   }
 
-  /// Read sample_id.
-  this->read_sample_id(entry, sample);
+  run(0U);
 
-  sample.throttle(Throttle{ entry.is_throttle() });
+  for (auto& thread : threads) {
+    thread.join();
+  }
 
-  return sample;
+  for (const auto& exception : exceptions) {
+    if (exception != nullptr) {
+      std::rethrow_exception(exception);
+    }
+  }
 }
 
-perf::Sampler::SampleCounter::~SampleCounter()
+template<typename F>
+std::vector<std::vector<perf::Sample>>
+perf::MultiSamplerBase::read_parallel(const std::size_t count_samplers, const bool sort_by_time, F&& read)
 {
-  /// Free the buffer (if mmap-ed).
-  if (this->_buffer != nullptr) {
-    ::munmap(this->_buffer, this->_buffer_pages * 4096U);
-  }
+  auto results = std::vector<std::vector<Sample>>(count_samplers);
 
-  /// Close the group.
-  if (this->_group.leader_file_descriptor() > -1) {
-    this->_group.close();
-  }
+  /// Every sampler's result is (almost) ordered by time; sorting them locally is cheap and enables the k-way merge.
+  MultiSamplerBase::for_each_parallel(count_samplers, [&results, &read, sort_by_time](const std::size_t sampler_id) {
+    auto& result = results[sampler_id];
+    result = read(sampler_id);
+
+    if (sort_by_time && !std::is_sorted(result.begin(), result.end(), SampleTimestampComparator{})) {
+      std::sort(result.begin(), result.end(), SampleTimestampComparator{});
+    }
+  });
+
+  return results;
+}
+
+std::vector<perf::Sample>
+perf::MultiSamplerBase::result(const bool sort_by_time) const
+{
+  const auto& samplers = this->samplers();
+  const auto is_sort_by_time = sort_by_time && this->is_all_timed();
+
+  auto results = MultiSamplerBase::read_parallel(
+    samplers.size(), is_sort_by_time, [this, &samplers](const std::size_t sampler_id) {
+      if (this->_drainer != nullptr) {
+        return this->_drainer->result(sampler_id);
+      }
+
+      return samplers[sampler_id].result(false);
+    });
+
+  return MultiSamplerBase::merge(std::move(results), is_sort_by_time);
 }
 
 std::vector<perf::Sample>
-perf::MultiSamplerBase::result(const std::vector<Sampler>& sampler, bool sort_by_time)
+perf::MultiSamplerBase::drain(const bool sort_by_time)
 {
-  if (!sampler.empty()) {
-    auto result = sampler.front().result();
+  auto& samplers = this->samplers();
+  const auto is_sort_by_time = sort_by_time && this->is_all_timed();
+
+  auto results = MultiSamplerBase::read_parallel(
+    samplers.size(), is_sort_by_time, [this, &samplers](const std::size_t sampler_id) {
+      if (this->_drainer != nullptr) {
+        return this->_drainer->drain(sampler_id);
+      }
 
-    sort_by_time &= sampler.front()._values.is_set(PERF_SAMPLE_TIME);
+      return samplers[sampler_id].drain(false);
+    });
 
-    for (auto i = 1U; i < sampler.size(); ++i) {
-      /// Only sort if all samplers recorded the timestamp.
-      sort_by_time &= sampler[i]._values.is_set(PERF_SAMPLE_TIME);
+  return MultiSamplerBase::merge(std::move(results), is_sort_by_time);
+}
 
-      auto temp_result = sampler[i].result();
-      std::move(temp_result.begin(), temp_result.end(), std::back_inserter(result));
+std::vector<perf::Sample>
+perf::MultiSamplerBase::merge(std::vector<std::vector<Sample>>&& results, const bool sort_by_time)
+{
+  auto count_samples = std::size_t{ 0U };
+  for (const auto& result : results) {
+    count_samples += result.size();
+  }
+
+  auto merged_result = std::vector<Sample>{};
+  merged_result.reserve(count_samples);
+
+  if (!sort_by_time) {
+    for (auto& result : results) {
+      std::move(result.begin(), result.end(), std::back_inserter(merged_result));
+      result = std::vector<Sample>{};
     }
 
-    if (sort_by_time) {
-      std::sort(result.begin(), result.end(), SampleTimestampComparator{});
+    return merged_result;
+  }
+
+  /// K-way merge: The heap holds the next (earliest) sample of every result.
+  using HeapEntry = std::pair<std::uint64_t, std::size_t>;
+  auto heap = std::priority_queue<HeapEntry, std::vector<HeapEntry>, std::greater<>>{};
+  auto positions = std::vector<std::size_t>(results.size(), 0U);
+
+  for (auto result_id = 0U; result_id < results.size(); ++result_id) {
+    if (!results[result_id].empty()) {
+      heap.emplace(results[result_id].front().time().value_or(0U), result_id);
     }
+  }
+
+  while (!heap.empty()) {
+    const auto result_id = heap.top().second;
+    heap.pop();
+
+    auto& result = results[result_id];
+    auto& position = positions[result_id];
+    merged_result.push_back(std::move(result[position++]));
 
-    return result;
+    if (position < result.size()) {
+      heap.emplace(result[position].time().value_or(0U), result_id);
+    } else {
+      /// Free the memory of results as soon as they are merged.
+      result = std::vector<Sample>{};
+    }
   }
 
-  return std::vector<perf::Sample>{};
+  return merged_result;
+}
+
+bool
+perf::MultiSamplerBase::is_all_timed() const
+{
+  /// Samplers that were never opened (e.g., of threads that did not start) hold no samples.
+  const auto& samplers = this->samplers();
+  return std::all_of(samplers.begin(), samplers.end(), [](const Sampler& sampler) {
+    return !sampler._is_opened || sampler._values.is_set(PERF_SAMPLE_TIME);
+  });
 }
 
 void
@@ -708,21 +1406,31 @@ perf::MultiSamplerBase::trigger(std::vector<Sampler>& samplers, std::vector<std:
 }
 
 void
-perf::MultiSamplerBase::open(perf::Sampler& sampler, const perf::SampleConfig config)
+perf::MultiSamplerBase::open(const std::size_t sampler_id, const perf::SampleConfig config)
 {
+  auto& sampler = this->samplers()[sampler_id];
   sampler._values = _values;
   sampler._config = config;
 
   sampler.open();
+
+  if (this->_drainer != nullptr) {
+    this->_drainer->add(sampler_id, sampler);
+  }
 }
 
 void
-perf::MultiSamplerBase::start(perf::Sampler& sampler, const perf::SampleConfig config)
+perf::MultiSamplerBase::start(const std::size_t sampler_id, const perf::SampleConfig config)
 {
+  auto& sampler = this->samplers()[sampler_id];
   sampler._values = _values;
   sampler._config = config;
 
   std::ignore = sampler.start();
+
+  if (this->_drainer != nullptr) {
+    this->_drainer->add(sampler_id, sampler);
+  }
 }
 
 perf::MultiThreadSampler::MultiThreadSampler(const perf::CounterDefinition& counter_list,
@@ -734,6 +1442,11 @@ perf::MultiThreadSampler::MultiThreadSampler(const perf::CounterDefinition& coun
   for (auto thread_id = 0U; thread_id < num_threads; ++thread_id) {
     this->_thread_local_samplers.emplace_back(counter_list);
   }
+
+  /// Samplers of exiting threads are only stopped, the buffers keep the samples until closing.
+  auto* samplers = this->_thread_local_samplers.data();
+  this->_thread_registry = ThreadRegistry{ this->_thread_local_samplers.size(),
+                                           [samplers](const std::size_t thread_id) { samplers[thread_id].stop(); } };
 }
 
 perf::MultiCoreSampler::MultiCoreSampler(const perf::CounterDefinition& counter_list,
@@ -754,21 +1467,216 @@ perf::MultiCoreSampler::MultiCoreSampler(const perf::CounterDefinition& counter_
 void
 perf::MultiCoreSampler::open()
 {
-  for (auto sampler_id = 0U; sampler_id < this->_core_ids.size(); ++sampler_id) {
+  /// Opening a sampler (i.e., opening the counters and mapping the buffer) takes time; on machines with many cores, the
+  /// samplers are opened in parallel. Samplers that are already opened will not be opened again.
+  MultiSamplerBase::for_each_parallel(this->_core_ids.size(), [this](const std::size_t sampler_id) {
     auto config = this->_config;
     config.cpu_id(this->_core_ids[sampler_id]);
-    MultiSamplerBase::open(this->_core_local_samplers[sampler_id], config);
+    MultiSamplerBase::open(sampler_id, config);
+  });
+}
+
+void
+perf::MultiCoreSampler::background_drain_per_node(const perf::NumaTopology& topology, perf::SampleQueue* queue)
+{
+  /// One worker per node that holds at least one of the recorded CPUs; CPUs of unknown nodes are drained by the first.
+  auto worker_of_node = std::vector<std::optional<std::size_t>>(topology.count_nodes(), std::nullopt);
+  auto worker_ids = std::vector<std::size_t>{};
+  auto worker_cpu_ids = std::vector<std::vector<std::uint16_t>>{};
+
+  worker_ids.reserve(this->_core_ids.size());
+  for (const auto core_id : this->_core_ids) {
+    const auto node = topology.node_of_cpu(core_id).value_or(0U);
+    if (node >= worker_of_node.size()) {
+      worker_of_node.resize(std::size_t(node) + 1U, std::nullopt);
+    }
+
+    if (!worker_of_node[node].has_value()) {
+      worker_of_node[node] = worker_cpu_ids.size();
+      worker_cpu_ids.push_back(topology.cpus(node));
+    }
+    worker_ids.push_back(worker_of_node[node].value());
   }
+
+  MultiSamplerBase::background_drain(
+    std::make_unique<SampleDrainer>(std::move(worker_ids), std::move(worker_cpu_ids), queue));
 }
 
 bool
 perf::MultiCoreSampler::start()
 {
-  for (auto sampler_id = 0U; sampler_id < this->_core_ids.size(); ++sampler_id) {
-    auto config = this->_config;
-    config.cpu_id(this->_core_ids[sampler_id]);
-    MultiSamplerBase::start(this->_core_local_samplers[sampler_id], config);
+  /// Open all samplers first, to enable them near-simultaneously in a separate (and fast) phase afterward.
+  this->open();
+
+  /// Since all samplers are opened, starting them will only enable the counters.
+  for (auto& sampler : this->_core_local_samplers) {
+    std::ignore = sampler.start();
+  }
+
+  return true;
+}
+
+perf::MultiProcessSampler::MultiProcessSampler(const perf::CounterDefinition& counter_list,
+                                               std::vector<pid_t>&& process_ids,
+                                               perf::SampleConfig config,
+                                               const std::uint16_t count_spare_threads)
+  : MultiSamplerBase(config)
+  , _process_ids(std::move(process_ids))
+{
+  auto count_threads = std::size_t{ count_spare_threads };
+  for (const auto process_id : this->_process_ids) {
+    count_threads += MultiProcessSampler::threads_of(process_id).size();
+  }
+
+  /// Create thread-local samplers without config (will be set when starting).
+  for (auto sampler_id = std::size_t{ 0U }; sampler_id < count_threads; ++sampler_id) {
+    this->_thread_samplers.emplace_back(counter_list);
+  }
+  this->_is_exited.resize(count_threads, 0U);
+
+  this->list_threads();
+}
+
+std::vector<pid_t>
+perf::MultiProcessSampler::threads_of(const pid_t process_id)
+{
+  const auto task_path = std::string{ "/proc/" }.append(std::to_string(process_id)).append("/task");
+
+  auto* directory = ::opendir(task_path.c_str());
+  if (directory == nullptr) {
+    throw std::runtime_error{ std::string{ "Cannot list threads of process " }
+                                .append(std::to_string(process_id))
+                                .append(": ")
+                                .append(std::strerror(errno)) };
+  }
+
+  auto thread_ids = std::vector<pid_t>{};
+  while (const auto* entry = ::readdir(directory)) {
+    if (entry->d_name[0] >= '0' && entry->d_name[0] <= '9') {
+      thread_ids.push_back(static_cast<pid_t>(std::stol(entry->d_name)));
+    }
+  }
+  ::closedir(directory);
+
+  std::sort(thread_ids.begin(), thread_ids.end());
+  return thread_ids;
+}
+
+std::size_t
+perf::MultiProcessSampler::attach_new_threads()
+{
+  const auto count_attached_threads = this->_thread_ids.size();
+
+  this->list_threads();
+  this->open(count_attached_threads);
+
+  if (this->_is_recording) {
+    for (auto sampler_id = count_attached_threads; sampler_id < this->_thread_ids.size(); ++sampler_id) {
+      if (this->_is_exited[sampler_id] == 0U) {
+        std::ignore = this->_thread_samplers[sampler_id].start();
+      }
+    }
+  }
+
+  return this->_thread_ids.size() - count_attached_threads;
+}
+
+void
+perf::MultiProcessSampler::list_threads()
+{
+  auto attached_thread_ids = this->_thread_ids;
+  std::sort(attached_thread_ids.begin(), attached_thread_ids.end());
+
+  for (const auto process_id : this->_process_ids) {
+    /// Processes may exit while being sampled.
+    auto thread_ids = std::vector<pid_t>{};
+    try {
+      thread_ids = MultiProcessSampler::threads_of(process_id);
+    } catch (std::runtime_error&) {
+      continue;
+    }
+
+    for (const auto thread_id : thread_ids) {
+      if (std::binary_search(attached_thread_ids.begin(), attached_thread_ids.end(), thread_id)) {
+        continue;
+      }
+
+      if (this->_thread_ids.size() < this->_thread_samplers.size()) {
+        this->_thread_ids.push_back(thread_id);
+      } else {
+        ++this->_count_missed_threads;
+      }
+    }
+  }
+}
+
+std::uint64_t
+perf::MultiProcessSampler::buffer_pages_per_sampler(const std::uint64_t buffer_pages, const std::size_t count_samplers)
+{
+  /// The kernel expects one metadata page followed by 2^n data pages.
+  const auto data_pages = (buffer_pages > 1U ? buffer_pages - 1U : 0U) / std::max<std::size_t>(1U, count_samplers);
+
+  auto pages = MultiProcessSampler::MIN_BUFFER_PAGES;
+  while (pages * 2U <= data_pages) {
+    pages *= 2U;
+  }
+
+  return pages + 1U;
+}
+
+void
+perf::MultiProcessSampler::open()
+{
+  this->list_threads();
+  this->open(0U);
+}
+
+void
+perf::MultiProcessSampler::open(const std::size_t first_sampler_id)
+{
+  auto config = this->_config;
+  config.buffer_pages(MultiProcessSampler::buffer_pages_per_sampler(this->_config.buffer_pages(),
+                                                                    this->_thread_samplers.size()));
+
+  /// Opening the samplers of processes with many threads takes time; the samplers are opened in parallel. Samplers that
+  /// are already opened will not be opened again.
+  const auto count_samplers = this->_thread_ids.size() - first_sampler_id;
+  MultiSamplerBase::for_each_parallel(count_samplers, [this, first_sampler_id, config](const std::size_t index) {
+    const auto sampler_id = first_sampler_id + index;
+    if (this->_is_exited[sampler_id] != 0U) {
+      return;
+    }
+
+    auto thread_config = config;
+    thread_config.process_id(this->_thread_ids[sampler_id]);
+
+    try {
+      MultiSamplerBase::open(sampler_id, thread_config);
+    } catch (std::runtime_error&) {
+      /// Threads may exit between listing and opening; the sampler is closed to be skipped from now on.
+      const auto thread_path = std::string{ "/proc/" }.append(std::to_string(this->_thread_ids[sampler_id]));
+      if (::access(thread_path.c_str(), F_OK) == 0) {
+        throw;
+      }
+
+      this->_thread_samplers[sampler_id].close();
+      this->_is_exited[sampler_id] = 1U;
+    }
+  });
+}
+
+bool
+perf::MultiProcessSampler::start()
+{
+  /// Open all samplers first, to enable them near-simultaneously in a separate (and fast) phase afterward.
+  this->open();
+
+  for (auto sampler_id = 0U; sampler_id < this->_thread_ids.size(); ++sampler_id) {
+    if (this->_is_exited[sampler_id] == 0U) {
+      std::ignore = this->_thread_samplers[sampler_id].start();
+    }
   }
+  this->_is_recording = true;
 
   return true;
 }
@@ -0,0 +1,415 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <fstream>
+#include <linux/perf_event.h>
+#include <memory>
+#include <perfcpp/symbolizer.h>
+#include <sstream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+std::string
+perf::Symbol::demangled_name() const
+{
+  auto status = 0;
+  auto name = std::string{ this->_name };
+  auto* demangled = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+  if (status == 0 && demangled != nullptr) {
+    name = std::string{ demangled };
+  }
+
+  std::free(demangled);
+  return name;
+}
+
+bool
+perf::Symbolizer::add_process(const std::uint32_t process_id)
+{
+  auto maps_stream = std::ifstream{ std::string{ "/proc/" }.append(std::to_string(process_id)).append("/maps") };
+  if (!maps_stream.is_open()) {
+    return false;
+  }
+
+  auto& address_space = this->_address_spaces[process_id];
+
+  /// Every line has the format "begin-end permissions offset device inode path".
+  auto line = std::string{};
+  while (std::getline(maps_stream, line)) {
+    auto line_stream = std::istringstream{ line };
+
+    auto range = std::string{};
+    auto permissions = std::string{};
+    auto offset = std::string{};
+    auto device = std::string{};
+    auto inode = std::string{};
+    auto path = std::string{};
+    line_stream >> range >> permissions >> offset >> device >> inode;
+    std::getline(line_stream >> std::ws, path);
+
+    /// Only executable mappings of files are needed to resolve instruction pointers.
+    const auto separator = range.find('-');
+    if (separator == std::string::npos || permissions.size() < 3U || permissions[2U] != 'x' || path.empty() ||
+        path.front() != '/') {
+      continue;
+    }
+
+    const auto begin = std::uintptr_t(std::strtoull(range.substr(0U, separator).c_str(), nullptr, 16));
+    const auto end = std::uintptr_t(std::strtoull(range.substr(separator + 1U).c_str(), nullptr, 16));
+    const auto page_offset = std::uint64_t(std::strtoull(offset.c_str(), nullptr, 16));
+
+    this->add(address_space, begin, end, page_offset, std::move(path));
+  }
+
+  return true;
+}
+
+void
+perf::Symbolizer::add(const perf::Mmap& mmap)
+{
+  /// Only executable mappings of files are needed to resolve instruction pointers.
+  if (mmap.protection().has_value() && (mmap.protection().value() & PROT_EXEC) == 0U) {
+    return;
+  }
+  if (mmap.path().empty() || mmap.path().front() != '/') {
+    return;
+  }
+
+  auto& address_space = this->address_space(mmap.process_id());
+  this->add(
+    address_space, mmap.address(), mmap.address() + mmap.length(), mmap.page_offset(), std::string{ mmap.path() });
+}
+
+std::optional<perf::Symbol>
+perf::Symbolizer::resolve(const std::uint32_t process_id, const std::uintptr_t address)
+{
+  /// Kernel addresses are located in the upper half of the address space.
+  if ((address >> 63U) != 0U) {
+    return this->resolve_kernel(address);
+  }
+
+  auto& address_space = this->address_space(process_id);
+
+  if (auto iterator = address_space.cache.find(address); iterator != address_space.cache.end()) {
+    return iterator->second;
+  }
+
+  auto symbol = std::optional<Symbol>{ std::nullopt };
+  if (const auto* mapping = Symbolizer::mapping(address_space, address); mapping != nullptr) {
+    symbol = mapping->image->find(address - mapping->begin + mapping->page_offset);
+  }
+
+  if (address_space.cache.size() >= Symbolizer::MAX_CACHED_ADDRESSES) {
+    address_space.cache.clear();
+  }
+  address_space.cache.insert(std::make_pair(address, symbol));
+
+  return symbol;
+}
+
+std::optional<perf::Symbol>
+perf::Symbolizer::resolve(const perf::Sample& sample)
+{
+  if (sample.process_id().has_value() && sample.instruction_pointer().has_value()) {
+    return this->resolve(sample.process_id().value(), sample.instruction_pointer().value());
+  }
+
+  return std::nullopt;
+}
+
+std::vector<std::optional<perf::Symbol>>
+perf::Symbolizer::resolve(const std::uint32_t process_id, const std::vector<std::uintptr_t>& callchain)
+{
+  auto symbols = std::vector<std::optional<Symbol>>{};
+  symbols.reserve(callchain.size());
+
+  for (const auto address : callchain) {
+    /// Skip context markers (PERF_CONTEXT_KERNEL, PERF_CONTEXT_USER, ...).
+    if (address >= std::uintptr_t(PERF_CONTEXT_MAX)) {
+      symbols.emplace_back(std::nullopt);
+    } else {
+      symbols.emplace_back(this->resolve(process_id, address));
+    }
+  }
+
+  return symbols;
+}
+
+std::optional<perf::BinaryAddress>
+perf::Symbolizer::translate(const std::uint32_t process_id, const std::uintptr_t address)
+{
+  /// Kernel addresses are located in the upper half of the address space.
+  if ((address >> 63U) != 0U) {
+    return std::nullopt;
+  }
+
+  const auto* mapping = Symbolizer::mapping(this->address_space(process_id), address);
+  if (mapping == nullptr) {
+    return std::nullopt;
+  }
+
+  return BinaryAddress{ mapping->image->path(),
+                        mapping->image->virtual_address(address - mapping->begin + mapping->page_offset) };
+}
+
+const perf::Symbolizer::Mapping*
+perf::Symbolizer::mapping(const perf::Symbolizer::AddressSpace& address_space, const std::uintptr_t address) noexcept
+{
+  /// Find the last mapping that begins at or before the address.
+  auto mapping = std::upper_bound(address_space.mappings.begin(),
+                                  address_space.mappings.end(),
+                                  address,
+                                  [](const std::uintptr_t value, const Mapping& item) { return value < item.begin; });
+  if (mapping == address_space.mappings.begin()) {
+    return nullptr;
+  }
+
+  --mapping;
+  return address < mapping->end ? &*mapping : nullptr;
+}
+
+perf::Symbolizer::AddressSpace&
+perf::Symbolizer::address_space(const std::uint32_t process_id)
+{
+  if (auto iterator = this->_address_spaces.find(process_id); iterator != this->_address_spaces.end()) {
+    return iterator->second;
+  }
+
+  /// Initialize the address space with the current mappings of the process.
+  if (!this->add_process(process_id)) {
+    return this->_address_spaces[process_id];
+  }
+
+  return this->_address_spaces.at(process_id);
+}
+
+void
+perf::Symbolizer::add(perf::Symbolizer::AddressSpace& address_space,
+                      const std::uintptr_t begin,
+                      const std::uintptr_t end,
+                      const std::uint64_t page_offset,
+                      std::string&& path)
+{
+  if (begin >= end) {
+    return;
+  }
+
+  /// Get (or parse) the image, shared by all processes mapping the same file.
+  auto image_iterator = this->_images.find(path);
+  if (image_iterator == this->_images.end()) {
+    auto image = std::make_shared<Image>(std::string{ path });
+    image_iterator = this->_images.insert(std::make_pair(std::move(path), std::move(image))).first;
+  }
+
+  /// Replace (parts of) mappings overlapping with the new one.
+  auto mappings = std::vector<Mapping>{};
+  mappings.reserve(address_space.mappings.size() + 2U);
+  for (auto& mapping : address_space.mappings) {
+    if (mapping.end <= begin || mapping.begin >= end) {
+      mappings.push_back(std::move(mapping));
+      continue;
+    }
+
+    if (mapping.begin < begin) {
+      mappings.push_back(Mapping{ mapping.begin, begin, mapping.page_offset, mapping.image });
+    }
+
+    if (mapping.end > end) {
+      mappings.push_back(Mapping{ end, mapping.end, mapping.page_offset + (end - mapping.begin), mapping.image });
+    }
+  }
+
+  mappings.push_back(Mapping{ begin, end, page_offset, image_iterator->second });
+  std::sort(mappings.begin(), mappings.end(), [](const auto& left, const auto& right) {
+    return left.begin < right.begin;
+  });
+
+  address_space.mappings = std::move(mappings);
+
+  /// Cached addresses may be resolved differently now.
+  address_space.cache.clear();
+}
+
+std::optional<perf::Symbol>
+perf::Symbolizer::resolve_kernel(const std::uintptr_t address)
+{
+  if (!this->_kernel_symbols.has_value()) {
+    auto& kernel_symbols = this->_kernel_symbols.emplace();
+
+    /// Every line has the format "address type name [module]"; addresses are zero if not permitted to read them.
+    auto kallsyms_stream = std::ifstream{ "/proc/kallsyms" };
+    auto line = std::string{};
+    while (std::getline(kallsyms_stream, line)) {
+      auto line_stream = std::istringstream{ line };
+      auto symbol_address = std::string{};
+      auto type = std::string{};
+      auto name = std::string{};
+      line_stream >> symbol_address >> type >> name;
+
+      const auto value = std::uintptr_t(std::strtoull(symbol_address.c_str(), nullptr, 16));
+      if (value != 0U && (type == "t" || type == "T")) {
+        kernel_symbols.emplace_back(value, std::move(name));
+      }
+    }
+
+    std::sort(kernel_symbols.begin(), kernel_symbols.end(), [](const auto& left, const auto& right) {
+      return left.first < right.first;
+    });
+  }
+
+  const auto& kernel_symbols = this->_kernel_symbols.value();
+  auto iterator = std::upper_bound(
+    kernel_symbols.begin(), kernel_symbols.end(), address, [](const std::uintptr_t value, const auto& item) {
+      return value < item.first;
+    });
+  if (iterator == kernel_symbols.begin()) {
+    return std::nullopt;
+  }
+
+  --iterator;
+  return Symbol{ iterator->second, "[kernel]", address - iterator->first };
+}
+
+perf::Symbolizer::Image::Image(std::string&& path)
+  : _path(std::move(path))
+{
+  const auto file_descriptor = ::open(this->_path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (file_descriptor < 0) {
+    return;
+  }
+
+  struct stat file_stat
+  {};
+  if (::fstat(file_descriptor, &file_stat) == 0 && file_stat.st_size > 0) {
+    auto* data = ::mmap(nullptr, std::size_t(file_stat.st_size), PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+    if (data != MAP_FAILED) {
+      this->_data = data;
+      this->_size = std::size_t(file_stat.st_size);
+    }
+  }
+  ::close(file_descriptor);
+
+  this->parse();
+}
+
+perf::Symbolizer::Image::~Image()
+{
+  if (this->_data != nullptr) {
+    ::munmap(this->_data, this->_size);
+  }
+}
+
+void
+perf::Symbolizer::Image::parse() noexcept
+{
+  if (this->_data == nullptr || this->_size < sizeof(Elf64_Ehdr)) {
+    return;
+  }
+
+  const auto* begin = reinterpret_cast<const std::uint8_t*>(this->_data);
+  const auto* header = reinterpret_cast<const Elf64_Ehdr*>(begin);
+
+  /// Only 64-bit ELF files are supported.
+  if (std::memcmp(header->e_ident, ELFMAG, SELFMAG) != 0 || header->e_ident[EI_CLASS] != ELFCLASS64) {
+    return;
+  }
+
+  /// Collect loadable segments to translate file offsets into virtual addresses.
+  if (header->e_phoff + std::uint64_t{ header->e_phnum } * sizeof(Elf64_Phdr) <= this->_size) {
+    const auto* program_headers = reinterpret_cast<const Elf64_Phdr*>(begin + header->e_phoff);
+    for (auto i = 0U; i < header->e_phnum; ++i) {
+      if (program_headers[i].p_type == PT_LOAD) {
+        this->_segments.push_back(
+          Segment{ program_headers[i].p_offset, program_headers[i].p_vaddr, program_headers[i].p_filesz });
+      }
+    }
+  }
+
+  if (header->e_shoff + std::uint64_t{ header->e_shnum } * sizeof(Elf64_Shdr) > this->_size) {
+    return;
+  }
+  const auto* section_headers = reinterpret_cast<const Elf64_Shdr*>(begin + header->e_shoff);
+
+  /// Prefer the full symbol table, fall back to the dynamic symbol table (e.g., for stripped binaries).
+  const Elf64_Shdr* symbol_table = nullptr;
+  for (auto i = 0U; i < header->e_shnum; ++i) {
+    if (section_headers[i].sh_type == SHT_SYMTAB) {
+      symbol_table = &section_headers[i];
+      break;
+    }
+    if (section_headers[i].sh_type == SHT_DYNSYM) {
+      symbol_table = &section_headers[i];
+    }
+  }
+
+  if (symbol_table == nullptr || symbol_table->sh_link >= header->e_shnum ||
+      symbol_table->sh_offset + symbol_table->sh_size > this->_size) {
+    return;
+  }
+
+  const auto& string_table = section_headers[symbol_table->sh_link];
+  if (string_table.sh_offset + string_table.sh_size > this->_size) {
+    return;
+  }
+  this->_strings = reinterpret_cast<const char*>(begin + string_table.sh_offset);
+  this->_strings_size = string_table.sh_size;
+
+  /// Collect the defined function symbols; the names stay in the mapped file.
+  const auto* symbols = reinterpret_cast<const Elf64_Sym*>(begin + symbol_table->sh_offset);
+  const auto count_symbols = symbol_table->sh_size / sizeof(Elf64_Sym);
+  for (auto i = 0U; i < count_symbols; ++i) {
+    const auto& symbol = symbols[i];
+    const auto type = ELF64_ST_TYPE(symbol.st_info);
+    if ((type == STT_FUNC || type == STT_GNU_IFUNC) && symbol.st_shndx != SHN_UNDEF && symbol.st_value != 0U &&
+        symbol.st_name < this->_strings_size) {
+      this->_symbols.push_back(ElfSymbol{ symbol.st_value, symbol.st_size, symbol.st_name });
+    }
+  }
+
+  /// Sort by address; for aliases (same address), keep the symbol with a size.
+  std::sort(this->_symbols.begin(), this->_symbols.end(), [](const auto& left, const auto& right) {
+    return left.address < right.address || (left.address == right.address && left.size > right.size);
+  });
+  this->_symbols.erase(std::unique(this->_symbols.begin(),
+                                   this->_symbols.end(),
+                                   [](const auto& left, const auto& right) { return left.address == right.address; }),
+                       this->_symbols.end());
+}
+
+std::optional<perf::Symbol>
+perf::Symbolizer::Image::find(const std::uint64_t file_offset) const noexcept
+{
+  const auto address = this->virtual_address(file_offset);
+
+  auto iterator = std::upper_bound(
+    this->_symbols.begin(), this->_symbols.end(), address, [](const std::uint64_t value, const ElfSymbol& symbol) {
+      return value < symbol.address;
+    });
+  if (iterator == this->_symbols.begin()) {
+    return std::nullopt;
+  }
+
+  --iterator;
+  if (iterator->size > 0U && address >= iterator->address + iterator->size) {
+    return std::nullopt;
+  }
+
+  return Symbol{ std::string_view{ this->_strings + iterator->name }, this->_path, address - iterator->address };
+}
+
+std::uint64_t
+perf::Symbolizer::Image::virtual_address(const std::uint64_t file_offset) const noexcept
+{
+  for (const auto& segment : this->_segments) {
+    if (file_offset >= segment.file_offset && file_offset < segment.file_offset + segment.size) {
+      return file_offset - segment.file_offset + segment.virtual_address;
+    }
+  }
+
+  return file_offset;
+}
@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <perfcpp/thread_registry.h>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+class perf::ThreadRegistry::State
+{
+public:
+  State(const std::size_t capacity, std::function<void(std::size_t)>&& retire)
+    : _capacity(capacity)
+    , _retire(std::move(retire))
+  {
+  }
+
+  [[nodiscard]] std::size_t capacity() const noexcept { return _capacity; }
+
+  [[nodiscard]] std::size_t size() const noexcept
+  {
+    return std::min(this->_next_slot.load(std::memory_order_relaxed), this->_capacity);
+  }
+
+  [[nodiscard]] std::size_t claim()
+  {
+    const auto slot = this->_next_slot.fetch_add(1U, std::memory_order_relaxed);
+    if (slot >= this->_capacity) {
+      throw std::runtime_error{ std::string{ "Cannot register thread: All " }
+                                  .append(std::to_string(this->_capacity))
+                                  .append(" thread slots are claimed.") };
+    }
+
+    return slot;
+  }
+
+  void retire(const std::size_t slot) noexcept
+  {
+    /// The lock only orders retiring against detaching; claiming slots never locks.
+    auto lock = std::lock_guard{ this->_mutex };
+    if (this->_is_attached) {
+      try {
+        this->_retire(slot);
+      } catch (...) {
+        /// Retiring runs while the thread exits and must not throw.
+      }
+    }
+  }
+
+  void detach() noexcept
+  {
+    auto lock = std::lock_guard{ this->_mutex };
+    this->_is_attached = false;
+  }
+
+private:
+  const std::size_t _capacity;
+  std::atomic<std::size_t> _next_slot{ 0U };
+
+  std::function<void(std::size_t)> _retire;
+  std::mutex _mutex;
+  bool _is_attached{ true };
+};
+
+class perf::ThreadRegistry::ThreadHandle
+{
+public:
+  ThreadHandle() = default;
+  ThreadHandle(ThreadHandle&&) = delete;
+  ThreadHandle(const ThreadHandle&) = delete;
+
+  /// Retires all slots of the exiting thread at registries that are still alive.
+  ~ThreadHandle()
+  {
+    for (auto& entry : this->_entries) {
+      if (auto state = entry.state.lock(); state != nullptr) {
+        state->retire(entry.slot);
+      }
+    }
+  }
+
+  ThreadHandle& operator=(ThreadHandle&&) = delete;
+  ThreadHandle& operator=(const ThreadHandle&) = delete;
+
+  [[nodiscard]] static ThreadHandle& local()
+  {
+    thread_local auto handle = ThreadHandle{};
+    return handle;
+  }
+
+  [[nodiscard]] std::size_t slot(const std::shared_ptr<State>& state)
+  {
+    /// Threads are typically registered at few registries. Expired entries are skipped, since a new registry may
+    /// reuse the address of a destroyed one.
+    const auto* key = state.get();
+    const auto iterator = std::find_if(this->_entries.begin(), this->_entries.end(), [key](const auto& entry) {
+      return entry.key == key && !entry.state.expired();
+    });
+
+    if (iterator != this->_entries.end()) {
+      return iterator->slot;
+    }
+
+    this->_entries.erase(std::remove_if(this->_entries.begin(),
+                                        this->_entries.end(),
+                                        [](const auto& entry) { return entry.state.expired(); }),
+                         this->_entries.end());
+
+    const auto slot = state->claim();
+    this->_entries.push_back(Entry{ key, std::weak_ptr<State>{ state }, slot });
+
+    return slot;
+  }
+
+private:
+  struct Entry
+  {
+    const State* key;
+    std::weak_ptr<State> state;
+    std::size_t slot;
+  };
+
+  std::vector<Entry> _entries;
+};
+
+perf::ThreadRegistry::ThreadRegistry(const std::size_t capacity, std::function<void(std::size_t)>&& retire)
+  : _state(std::make_shared<State>(capacity, std::move(retire)))
+{
+}
+
+perf::ThreadRegistry::~ThreadRegistry()
+{
+  if (this->_state != nullptr) {
+    this->_state->detach();
+  }
+}
+
+perf::ThreadRegistry&
+perf::ThreadRegistry::operator=(ThreadRegistry&& other) noexcept
+{
+  if (this != &other) {
+    if (this->_state != nullptr) {
+      this->_state->detach();
+    }
+    this->_state = std::move(other._state);
+  }
+
+  return *this;
+}
+
+std::size_t
+perf::ThreadRegistry::slot()
+{
+  if (this->_state == nullptr) {
+    throw std::runtime_error{ "Cannot register thread: The registry has no slots." };
+  }
+
+  return ThreadHandle::local().slot(this->_state);
+}
+
+std::size_t
+perf::ThreadRegistry::size() const noexcept
+{
+  return this->_state != nullptr ? this->_state->size() : 0U;
+}
+
+std::size_t
+perf::ThreadRegistry::capacity() const noexcept
+{
+  return this->_state != nullptr ? this->_state->capacity() : 0U;
+}
@@ -0,0 +1,115 @@
+#include <ctime>
+#include <perfcpp/time_conversion.h>
+#include <tuple>
+
+perf::TimeConversion::TimeConversion(const std::uint64_t time_zero,
+                                     const std::uint32_t time_multiplier,
+                                     const std::uint16_t time_shift,
+                                     const std::uint64_t time_cycles,
+                                     const std::uint64_t time_mask) noexcept
+  : _time_zero(time_zero)
+  , _time_multiplier(time_multiplier)
+  , _time_shift(time_shift)
+  , _time_cycles(time_cycles)
+  , _time_mask(time_mask)
+{
+  /// Measure the offset of the system clock as the tightest of a few brackets of cycles around reading the clock.
+  auto smallest_bracket = std::uint64_t{ 0U };
+  for (auto iteration = 0U; iteration < 4U; ++iteration) {
+    auto system_time = timespec{};
+    const auto cycles_before = TimeConversion::cycles();
+    ::clock_gettime(CLOCK_REALTIME, &system_time);
+    const auto cycles_after = TimeConversion::cycles();
+
+    const auto bracket = cycles_after - cycles_before;
+    if (iteration == 0U || bracket < smallest_bracket) {
+      smallest_bracket = bracket;
+      const auto system_nanoseconds = std::int64_t{ system_time.tv_sec } * 1000000000 + system_time.tv_nsec;
+      const auto perf_time = this->to_perf_time(cycles_before + bracket / 2U);
+      this->_system_clock_offset = system_nanoseconds - static_cast<std::int64_t>(perf_time);
+    }
+  }
+}
+
+std::optional<perf::TimeConversion>
+perf::TimeConversion::from(const perf_event_mmap_page* page) noexcept
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)
+  if (page == nullptr) {
+    return std::nullopt;
+  }
+
+  /// The page is updated by the kernel; the lock acts as a sequence lock.
+  const volatile auto* volatile_page = page;
+
+  auto sequence = std::uint32_t{ 0U };
+  auto time_zero = std::uint64_t{ 0U };
+  auto time_multiplier = std::uint32_t{ 0U };
+  auto time_shift = std::uint16_t{ 0U };
+  auto time_cycles = std::uint64_t{ 0U };
+  auto time_mask = std::uint64_t{ 0U };
+
+  do {
+    sequence = volatile_page->lock;
+    asm volatile("" ::: "memory");
+
+    if (!volatile_page->cap_user_time_zero) {
+      return std::nullopt;
+    }
+
+    time_zero = volatile_page->time_zero;
+    time_multiplier = volatile_page->time_mult;
+    time_shift = volatile_page->time_shift;
+#ifndef PERFCPP_NO_USER_TIME_SHORT
+    if (volatile_page->cap_user_time_short) {
+      time_cycles = volatile_page->time_cycles;
+      time_mask = volatile_page->time_mask;
+    }
+#endif
+
+    asm volatile("" ::: "memory");
+  } while (volatile_page->lock != sequence);
+
+  return TimeConversion{ time_zero, time_multiplier, time_shift, time_cycles, time_mask };
+#else
+  std::ignore = page;
+  return std::nullopt;
+#endif
+}
+
+std::uint64_t
+perf::TimeConversion::to_perf_time(std::uint64_t cycles) const noexcept
+{
+  if (this->_time_mask != 0U) {
+    cycles = this->_time_cycles + ((cycles - this->_time_cycles) & this->_time_mask);
+  }
+
+  /// Split the multiplication to avoid overflows (see the documentation of perf_event_mmap_page).
+  const auto quotient = cycles >> this->_time_shift;
+  const auto remainder = cycles & ((std::uint64_t{ 1U } << this->_time_shift) - 1U);
+
+  return this->_time_zero + quotient * this->_time_multiplier +
+         ((remainder * this->_time_multiplier) >> this->_time_shift);
+}
+
+std::uint64_t
+perf::TimeConversion::to_cycles(const std::uint64_t perf_time) const noexcept
+{
+  if (this->_time_multiplier == 0U) {
+    return 0U;
+  }
+
+  const auto time = perf_time - this->_time_zero;
+  const auto quotient = time / this->_time_multiplier;
+  const auto remainder = time % this->_time_multiplier;
+
+  return (quotient << this->_time_shift) + (remainder << this->_time_shift) / this->_time_multiplier;
+}
+
+std::chrono::system_clock::time_point
+perf::TimeConversion::to_system_time(const std::uint64_t perf_time) const noexcept
+{
+  const auto nanoseconds = static_cast<std::int64_t>(perf_time) + this->_system_clock_offset;
+  return std::chrono::system_clock::time_point{ std::chrono::duration_cast<std::chrono::system_clock::duration>(
+    std::chrono::nanoseconds{ nanoseconds }) };
+}